@@ -0,0 +1,54 @@
+//
+// NSBitmapImageRep+PTD.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+#import "PTDResampler.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface NSBitmapImageRep (PTD)
+
+/* YES if the bitmap data can be handed directly to the PTDResampler
+ * functions (non-planar 8 bit premultiplied RGBA) */
+- (BOOL)ptd_isPremultipliedRGBA8;
+
+/* Returns the receiver if it already is premultiplied RGBA8, otherwise a
+ * converted copy in the same color space. */
+- (NSBitmapImageRep *)ptd_premultipliedRGBA8ImageRep;
+
+- (PTDPixelBuffer)ptd_pixelBuffer;
+
+/* A premultiplied RGBA8 image rep whose pixels are filled in by the block,
+ * stored in a buffer of PTDBufferPool which goes back to the pool with the
+ * image. The pixels start out as garbage. Reading -bitmapData makes a
+ * private copy, so it is meant for images which are drawn or encoded. */
++ (nullable NSBitmapImageRep *)ptd_pooledImageRepWithPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height colorSpace:(nullable NSColorSpace *)colorSpace fillingPixelsUsingBlock:(void (^)(const PTDPixelBuffer *pixels))block;
+
+- (NSBitmapImageRep *)ptd_imageRepByResamplingToPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height;
+- (NSBitmapImageRep *)ptd_imageRepByResamplingToPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height filter:(PTDResamplingFilter)filter;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,128 @@
+//
+// NSBitmapImageRep+PTD.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "NSBitmapImageRep+PTD.h"
+#import "PTDBufferPoolImage.h"
+
+
+@implementation NSBitmapImageRep (PTD)
+
+
+- (BOOL)ptd_isPremultipliedRGBA8
+{
+  NSBitmapFormat unsupported = NSBitmapFormatAlphaFirst | NSBitmapFormatAlphaNonpremultiplied | NSBitmapFormatFloatingPointSamples;
+  return self.bitsPerSample == 8 && self.samplesPerPixel == 4 && self.bitsPerPixel == 32
+      && self.hasAlpha && !self.isPlanar && (self.bitmapFormat & unsupported) == 0
+      && self.colorSpace.colorSpaceModel == NSColorSpaceModelRGB;
+}
+
+
+- (NSBitmapImageRep *)ptd_premultipliedRGBA8ImageRep
+{
+  if (self.ptd_isPremultipliedRGBA8)
+    return self;
+  
+  NSBitmapImageRep *copy = [[NSBitmapImageRep alloc]
+      initWithBitmapDataPlanes:NULL
+      pixelsWide:self.pixelsWide pixelsHigh:self.pixelsHigh
+      bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+      colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:32];
+  NSColorSpace *colorSpace = self.colorSpace;
+  if (colorSpace.colorSpaceModel == NSColorSpaceModelRGB)
+    copy = [copy bitmapImageRepByRetaggingWithColorSpace:colorSpace];
+  
+  @autoreleasepool {
+    [NSGraphicsContext saveGraphicsState];
+    NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithBitmapImageRep:copy];
+    NSRect rect = NSMakeRect(0, 0, self.pixelsWide, self.pixelsHigh);
+    [self drawInRect:rect fromRect:NSZeroRect operation:NSCompositingOperationCopy fraction:1.0 respectFlipped:NO hints:nil];
+    [NSGraphicsContext restoreGraphicsState];
+  }
+  copy.size = self.size;
+  return copy;
+}
+
+
+- (PTDPixelBuffer)ptd_pixelBuffer
+{
+  return (PTDPixelBuffer){
+    .data = self.bitmapData,
+    .width = (size_t)self.pixelsWide,
+    .height = (size_t)self.pixelsHigh,
+    .bytesPerRow = (size_t)self.bytesPerRow
+  };
+}
+
+
++ (NSBitmapImageRep *)ptd_pooledImageRepWithPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height colorSpace:(NSColorSpace *)colorSpace fillingPixelsUsingBlock:(void (^)(const PTDPixelBuffer *pixels))block
+{
+  if (colorSpace.colorSpaceModel != NSColorSpaceModelRGB)
+    colorSpace = NSColorSpace.genericRGBColorSpace;
+  CGImageRef image = PTDBufferPoolCreateImage((size_t)MAX(1, width), (size_t)MAX(1, height), colorSpace.CGColorSpace, kCGImageAlphaPremultipliedLast, ^(CGContextRef ctxt) {
+    PTDPixelBuffer pixels = {
+      .data = CGBitmapContextGetData(ctxt),
+      .width = CGBitmapContextGetWidth(ctxt),
+      .height = CGBitmapContextGetHeight(ctxt),
+      .bytesPerRow = CGBitmapContextGetBytesPerRow(ctxt)
+    };
+    block(&pixels);
+  });
+  if (!image)
+    return nil;
+  NSBitmapImageRep *rep = [[NSBitmapImageRep alloc] initWithCGImage:image];
+  CGImageRelease(image);
+  return rep;
+}
+
+
+- (NSBitmapImageRep *)ptd_imageRepByResamplingToPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height
+{
+  PTDPixelBuffer src = self.ptd_pixelBuffer;
+  PTDPixelBuffer dst = {NULL, (size_t)MAX(1, width), (size_t)MAX(1, height), 0};
+  PTDResamplingFilter filter = PTDResamplingFilterForScaling(&src, &dst);
+  return [self ptd_imageRepByResamplingToPixelsWide:width pixelsHigh:height filter:filter];
+}
+
+
+- (NSBitmapImageRep *)ptd_imageRepByResamplingToPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height filter:(PTDResamplingFilter)filter
+{
+  NSBitmapImageRep *source = self.ptd_premultipliedRGBA8ImageRep;
+  
+  NSBitmapImageRep *res = [[NSBitmapImageRep alloc]
+      initWithBitmapDataPlanes:NULL
+      pixelsWide:MAX(1, width) pixelsHigh:MAX(1, height)
+      bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+      colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:32];
+  res = [res bitmapImageRepByRetaggingWithColorSpace:source.colorSpace];
+  res.size = self.size;
+  
+  PTDPixelBuffer srcBuf = source.ptd_pixelBuffer;
+  PTDPixelBuffer dstBuf = res.ptd_pixelBuffer;
+  PTDResample(&srcBuf, &dstBuf, filter);
+  return res;
+}
+
+
+@end
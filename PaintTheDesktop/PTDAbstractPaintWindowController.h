@@ -38,6 +38,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (nullable NSMenu *)windowMenu;
 @property (nonatomic, readonly, copy) NSImage *thumbnail;
+/* The memory taken by the canvases of the window, in bytes */
+@property (nonatomic, readonly) size_t memoryUsage;
+@property (nonatomic, readonly, getter=isCompressed) BOOL compressed;
 
 - (void)applicationDidEnableDrawing;
 - (void)applicationDidDisableDrawing;
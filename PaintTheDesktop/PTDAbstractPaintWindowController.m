@@ -86,6 +86,18 @@
 }
 
 
+- (size_t)memoryUsage
+{
+  return 0;
+}
+
+
+- (BOOL)isCompressed
+{
+  return NO;
+}
+
+
 - (void)applicationDidEnableDrawing
 {
 }
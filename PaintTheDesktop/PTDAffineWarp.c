@@ -0,0 +1,180 @@
+//
+// PTDAffineWarp.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include <string.h>
+#include "PTDAffineWarp.h"
+#include "PTDParallel.h"
+#include "PTDVector.h"
+
+
+/* Number of destination rows processed by a single work item */
+static const size_t _BandHeight = 32;
+
+
+PTDAffineWarpMatrix PTDAffineWarpMatrixInvert(PTDAffineWarpMatrix m)
+{
+  double det = m.a * m.d - m.b * m.c;
+  if (fabs(det) < 1e-12)
+    return (PTDAffineWarpMatrix){0, 0, 0, 0, 0, 0};
+  PTDAffineWarpMatrix r;
+  r.a = m.d / det;
+  r.b = -m.b / det;
+  r.c = -m.c / det;
+  r.d = m.a / det;
+  r.tx = -(r.a * m.tx + r.c * m.ty);
+  r.ty = -(r.b * m.tx + r.d * m.ty);
+  return r;
+}
+
+
+PTDAffineWarpMatrix PTDAffineWarpMatrixConcat(PTDAffineWarpMatrix m1, PTDAffineWarpMatrix m2)
+{
+  PTDAffineWarpMatrix r;
+  r.a = m1.a * m2.a + m1.b * m2.c;
+  r.b = m1.a * m2.b + m1.b * m2.d;
+  r.c = m1.c * m2.a + m1.d * m2.c;
+  r.d = m1.c * m2.b + m1.d * m2.d;
+  r.tx = m1.tx * m2.a + m1.ty * m2.c + m2.tx;
+  r.ty = m1.tx * m2.b + m1.ty * m2.d + m2.ty;
+  return r;
+}
+
+
+/* Restricts [*x0, *x1) to the x for which lo < p + dp * x < hi */
+static void PTDClipSpan(double p, double dp, double lo, double hi, double *x0, double *x1)
+{
+  if (dp == 0.0) {
+    if (p <= lo || p >= hi)
+      *x1 = *x0;
+    return;
+  }
+  double t0 = (lo - p) / dp;
+  double t1 = (hi - p) / dp;
+  if (t0 > t1) {
+    double tmp = t0;
+    t0 = t1;
+    t1 = tmp;
+  }
+  if (t0 > *x0)
+    *x0 = t0;
+  if (t1 < *x1)
+    *x1 = t1;
+}
+
+
+static inline PTDFloat4 PTDFetchTexel(const PTDPixelBuffer *src, long x, long y)
+{
+  if (x < 0 || y < 0 || x >= (long)src->width || y >= (long)src->height)
+    return PTDFloat4Splat(0.0f);
+  return PTDFloat4LoadPixel(src->data + (size_t)y * src->bytesPerRow + (size_t)x * 4);
+}
+
+
+static void PTDAffineWarpRow(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, PTDAffineWarpMatrix m, size_t y)
+{
+  uint8_t *out = dst->data + y * dst->bytesPerRow;
+  memset(out, 0, dst->width * 4);
+  
+  /* source coordinates of the center of the first pixel of the row, shifted
+   * so that texel centers are at integer coordinates */
+  double cy = (double)y + 0.5;
+  double u0 = m.a * 0.5 + m.c * cy + m.tx - 0.5;
+  double v0 = m.b * 0.5 + m.d * cy + m.ty - 0.5;
+  
+  /* outside of this span all four texels are transparent */
+  double fx0 = 0.0, fx1 = (double)dst->width;
+  PTDClipSpan(u0, m.a, -1.0, (double)src->width, &fx0, &fx1);
+  PTDClipSpan(v0, m.b, -1.0, (double)src->height, &fx0, &fx1);
+  if (fx1 <= fx0)
+    return;
+  size_t x0 = (size_t)fmax(0.0, floor(fx0));
+  size_t x1 = (size_t)fmin((double)dst->width, ceil(fx1));
+  
+  for (size_t x = x0; x < x1; x++) {
+    double u = u0 + m.a * (double)x;
+    double v = v0 + m.b * (double)x;
+    /* the span is rounded outwards, so its ends may be fully outside;
+     * elsewhere u and v are above -1, and this is floor() without the
+     * call to the library */
+    if (u <= -1.0 || v <= -1.0)
+      continue;
+    long iu = (long)(u + 1.0) - 1, iv = (long)(v + 1.0) - 1;
+    float wu = (float)(u - (double)iu), wv = (float)(v - (double)iv);
+    
+    PTDFloat4 p00, p10, p01, p11;
+    if (iu >= 0 && iv >= 0 && iu + 1 < (long)src->width && iv + 1 < (long)src->height) {
+      const uint8_t *r0 = src->data + (size_t)iv * src->bytesPerRow + (size_t)iu * 4;
+      const uint8_t *r1 = r0 + src->bytesPerRow;
+      p00 = PTDFloat4LoadPixel(r0);
+      p10 = PTDFloat4LoadPixel(r0 + 4);
+      p01 = PTDFloat4LoadPixel(r1);
+      p11 = PTDFloat4LoadPixel(r1 + 4);
+    } else {
+      p00 = PTDFetchTexel(src, iu, iv);
+      p10 = PTDFetchTexel(src, iu + 1, iv);
+      p01 = PTDFetchTexel(src, iu, iv + 1);
+      p11 = PTDFetchTexel(src, iu + 1, iv + 1);
+    }
+    
+    PTDFloat4 top = PTDFloat4Mix(p00, p10, wu);
+    PTDFloat4 bottom = PTDFloat4Mix(p01, p11, wu);
+    PTDFloat4 px = PTDFloat4Mix(top, bottom, wv);
+    PTDFloat4StorePixel(out + x * 4, PTDFloat4Add(px, PTDFloat4Splat(0.5f)));
+  }
+}
+
+
+typedef struct {
+  const PTDPixelBuffer *src;
+  const PTDPixelBuffer *dst;
+  PTDAffineWarpMatrix dstToSrc;
+} PTDAffineWarpJob;
+
+
+static void PTDAffineWarpJobBand(void *context, size_t band)
+{
+  const PTDAffineWarpJob *job = context;
+  size_t height = job->dst->height;
+  size_t y0 = band * _BandHeight;
+  size_t y1 = y0 + _BandHeight < height ? y0 + _BandHeight : height;
+  for (size_t y = y0; y < y1; y++)
+    PTDAffineWarpRow(job->src, job->dst, job->dstToSrc, y);
+}
+
+
+int PTDAffineWarp(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, PTDAffineWarpMatrix dstToSrc)
+{
+  double det = dstToSrc.a * dstToSrc.d - dstToSrc.b * dstToSrc.c;
+  if (fabs(det) < 1e-12 || !isfinite(det))
+    return 0;
+  if (dst->width == 0 || dst->height == 0)
+    return 1;
+  
+  size_t numBands = (dst->height + _BandHeight - 1) / _BandHeight;
+  PTDAffineWarpJob job = {src, dst, dstToSrc};
+  PTDParallelApply(numBands, &job, PTDAffineWarpJobBand);
+  return 1;
+}
@@ -0,0 +1,58 @@
+//
+// PTDAffineWarp.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDAffineWarp_h
+#define PTDAffineWarp_h
+
+#include "PTDResampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Same layout and convention as CGAffineTransform:
+ *   x' = a * x + c * y + tx
+ *   y' = b * x + d * y + ty */
+typedef struct {
+  double a, b, c, d;
+  double tx, ty;
+} PTDAffineWarpMatrix;
+
+/* Fills the destination buffer with the source buffer warped by an affine
+ * transform, with bilinear sampling. dstToSrc maps destination pixel
+ * coordinates to source pixel coordinates, where pixel (i, j) covers the
+ * square [i, i+1) x [j, j+1). Pixels outside of the source are transparent,
+ * which also antialiases the edges of the warped image. Returns 0 if the
+ * matrix is degenerate. */
+int PTDAffineWarp(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, PTDAffineWarpMatrix dstToSrc);
+
+PTDAffineWarpMatrix PTDAffineWarpMatrixInvert(PTDAffineWarpMatrix m);
+PTDAffineWarpMatrix PTDAffineWarpMatrixConcat(PTDAffineWarpMatrix first, PTDAffineWarpMatrix second);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDAffineWarp_h */
@@ -0,0 +1,57 @@
+//
+// PTDAnnotationOverlay.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* The annotations of a PDF page, as stored in a PTDAnnotationPageStore: a
+ * PNG of the part of the canvas which has content, and where that part
+ * is on the canvas, so that the rest is neither encoded nor drawn. */
+@interface PTDAnnotationOverlay : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+/* The crop rect is in canvas pixels, with the origin at the top left
+ * corner, and has the size of the PNG image. */
+- (instancetype)initWithPNGData:(NSData *)pngData canvasPixelSize:(NSSize)size cropRect:(NSRect)rect NS_DESIGNATED_INITIALIZER;
+/* Returns nil if the data is not the data representation of an overlay. */
+- (nullable instancetype)initWithData:(NSData *)data;
+
+@property (nonatomic, readonly) NSData *dataRepresentation;
+
+@property (nonatomic, readonly) NSData *PNGData;
+@property (nonatomic, readonly) NSSize canvasPixelSize;
+@property (nonatomic, readonly) NSRect cropRect;
+
+/* The part of the given rect which the PNG covers when the whole canvas
+ * is drawn in it. Both rects have the origin at the bottom left corner. */
+- (NSRect)cropRectForCanvasRect:(NSRect)rect;
+
+- (nullable NSBitmapImageRep *)imageRep;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,109 @@
+//
+// PTDAnnotationOverlay.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#import "PTDAnnotationOverlay.h"
+
+
+/* The PNG data follows a header with the size of the canvas and the crop
+ * rect, as little-endian 32 bit integers. */
+static const uint32_t _Magic = 'PTDo';
+
+typedef struct {
+  uint32_t magic;
+  uint32_t canvasWidth, canvasHeight;
+  uint32_t cropX, cropY, cropWidth, cropHeight;
+} PTDAnnotationOverlayHeader;
+
+
+@implementation PTDAnnotationOverlay
+
+
+- (instancetype)initWithPNGData:(NSData *)pngData canvasPixelSize:(NSSize)size cropRect:(NSRect)rect
+{
+  self = [super init];
+  _PNGData = [pngData copy];
+  _canvasPixelSize = size;
+  _cropRect = rect;
+  return self;
+}
+
+
+- (instancetype)initWithData:(NSData *)data
+{
+  PTDAnnotationOverlayHeader header;
+  if (data.length <= sizeof(header))
+    return nil;
+  [data getBytes:&header length:sizeof(header)];
+  if (NSSwapLittleIntToHost(header.magic) != _Magic)
+    return nil;
+  
+  NSSize size = NSMakeSize(NSSwapLittleIntToHost(header.canvasWidth), NSSwapLittleIntToHost(header.canvasHeight));
+  NSRect rect = NSMakeRect(
+      NSSwapLittleIntToHost(header.cropX), NSSwapLittleIntToHost(header.cropY),
+      NSSwapLittleIntToHost(header.cropWidth), NSSwapLittleIntToHost(header.cropHeight));
+  if (size.width <= 0 || size.height <= 0 || NSIsEmptyRect(rect))
+    return nil;
+  NSData *pngData = [data subdataWithRange:NSMakeRange(sizeof(header), data.length - sizeof(header))];
+  return [self initWithPNGData:pngData canvasPixelSize:size cropRect:rect];
+}
+
+
+- (NSData *)dataRepresentation
+{
+  PTDAnnotationOverlayHeader header = {
+    NSSwapHostIntToLittle(_Magic),
+    NSSwapHostIntToLittle((uint32_t)_canvasPixelSize.width),
+    NSSwapHostIntToLittle((uint32_t)_canvasPixelSize.height),
+    NSSwapHostIntToLittle((uint32_t)NSMinX(_cropRect)),
+    NSSwapHostIntToLittle((uint32_t)NSMinY(_cropRect)),
+    NSSwapHostIntToLittle((uint32_t)NSWidth(_cropRect)),
+    NSSwapHostIntToLittle((uint32_t)NSHeight(_cropRect))
+  };
+  NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + _PNGData.length];
+  [data appendBytes:&header length:sizeof(header)];
+  [data appendData:_PNGData];
+  return data;
+}
+
+
+- (NSRect)cropRectForCanvasRect:(NSRect)rect
+{
+  CGFloat sx = NSWidth(rect) / _canvasPixelSize.width;
+  CGFloat sy = NSHeight(rect) / _canvasPixelSize.height;
+  return NSMakeRect(
+      NSMinX(rect) + NSMinX(_cropRect) * sx,
+      NSMinY(rect) + (_canvasPixelSize.height - NSMaxY(_cropRect)) * sy,
+      NSWidth(_cropRect) * sx, NSHeight(_cropRect) * sy);
+}
+
+
+- (NSBitmapImageRep *)imageRep
+{
+  return [[NSBitmapImageRep alloc] initWithData:_PNGData];
+}
+
+
+@end
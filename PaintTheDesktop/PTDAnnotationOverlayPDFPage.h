@@ -25,11 +25,13 @@
 
 #import <PDFKit/PDFKit.h>
 
+@class PTDAnnotationOverlay;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface PTDAnnotationOverlayPDFPage : PDFPage
 
-- (instancetype)initWithPDFPage:(PDFPage *)origPage overlay:(NSData *)imageData;
+- (instancetype)initWithPDFPage:(PDFPage *)origPage overlay:(PTDAnnotationOverlay *)overlay;
 
 @end
 
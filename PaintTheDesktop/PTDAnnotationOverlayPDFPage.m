@@ -26,20 +26,21 @@
 #import "PTDAnnotationOverlayPDFPage.h"
 #import "NSAffineTransform+PTD.h"
 #import "PDFPage+PTD.h"
+#import "PTDAnnotationOverlay.h"
 
 
 @implementation PTDAnnotationOverlayPDFPage {
   PDFPage *_origPage;
-  NSData *_imageData;
+  PTDAnnotationOverlay *_overlay;
 }
 
 
-- (instancetype)initWithPDFPage:(PDFPage *)origPage overlay:(NSData *)imageData
+- (instancetype)initWithPDFPage:(PDFPage *)origPage overlay:(PTDAnnotationOverlay *)overlay
 {
   self = [super init];
   
   _origPage = origPage;
-  _imageData = imageData;
+  _overlay = overlay;
   
   return self;
 }
@@ -72,9 +73,12 @@
   [NSGraphicsContext saveGraphicsState];
   NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithCGContext:context flipped:NO];
   @autoreleasepool {
-    NSRect cropBox = [self ptd_rotatedCropBox];
-    NSBitmapImageRep *image = [[NSBitmapImageRep alloc] initWithData:_imageData];
-    [image drawInRect:cropBox];
+    /* only the part of the canvas with content is decoded and drawn */
+    NSRect rect = [_overlay cropRectForCanvasRect:[self ptd_rotatedCropBox]];
+    CGContextSaveGState(context);
+    CGContextClipToRect(context, rect);
+    [_overlay.imageRep drawInRect:rect];
+    CGContextRestoreGState(context);
   }
   [NSGraphicsContext restoreGraphicsState];
 }
@@ -0,0 +1,58 @@
+//
+// PTDAnnotationPageStore.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Stores the encoded annotations of each page of a document, such as the
+ * data representation of a PTDAnnotationOverlay, on top of a PTDPageStore:
+ * page data is spilled to an unlinked temporary file and read back through
+ * a memory mapping, so only the most recently used pages stay resident.
+ * Safe to use from any thread. */
+@interface PTDAnnotationPageStore : NSObject
+
+- (nullable instancetype)initWithPageCount:(NSInteger)pageCount;
+- (nullable instancetype)initWithPageCount:(NSInteger)pageCount hotPageLimit:(NSInteger)limit NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSInteger pageCount;
+@property (nonatomic, readonly) NSInteger hotPageLimit;
+
+/* Returns an empty NSData for pages without annotations. */
+- (NSData *)dataForPageAtIndex:(NSInteger)index;
+/* Does not make the page one of the most recently used ones, for reads
+ * which are not about the page being edited. */
+- (NSData *)uncachedDataForPageAtIndex:(NSInteger)index;
+- (void)setData:(nullable NSData *)data forPageAtIndex:(NSInteger)index;
+- (BOOL)hasDataForPageAtIndex:(NSInteger)index;
+/* Changes every time the data of the page is replaced with different data. */
+- (NSUInteger)revisionOfPageAtIndex:(NSInteger)index;
+
+- (void)removeAllData;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,114 @@
+//
+// PTDAnnotationPageStore.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDAnnotationPageStore.h"
+#include "PTDPageStore.h"
+
+
+@implementation PTDAnnotationPageStore {
+  PTDPageStore *_store;
+}
+
+
+- (instancetype)initWithPageCount:(NSInteger)pageCount
+{
+  return [self initWithPageCount:pageCount hotPageLimit:8];
+}
+
+
+- (instancetype)initWithPageCount:(NSInteger)pageCount hotPageLimit:(NSInteger)limit
+{
+  self = [super init];
+  _pageCount = MAX(0, pageCount);
+  _hotPageLimit = MAX(1, limit);
+  _store = PTDPageStoreCreate((size_t)_pageCount, (size_t)_hotPageLimit, NSTemporaryDirectory().fileSystemRepresentation);
+  if (!_store)
+    return nil;
+  return self;
+}
+
+
+- (void)dealloc
+{
+  PTDPageStoreDestroy(_store);
+}
+
+
+- (NSData *)dataForPageAtIndex:(NSInteger)index
+{
+  return [self _dataForPageAtIndex:index cache:YES];
+}
+
+
+- (NSData *)uncachedDataForPageAtIndex:(NSInteger)index
+{
+  return [self _dataForPageAtIndex:index cache:NO];
+}
+
+
+- (NSData *)_dataForPageAtIndex:(NSInteger)index cache:(BOOL)cache
+{
+  if (index < 0 || index >= _pageCount)
+    return [NSData data];
+  size_t length;
+  void *bytes = PTDPageStoreCopyPage(_store, (size_t)index, &length, cache);
+  if (!bytes)
+    return [NSData data];
+  return [NSData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+}
+
+
+- (void)setData:(NSData *)data forPageAtIndex:(NSInteger)index
+{
+  if (index < 0 || index >= _pageCount)
+    return;
+  if (!PTDPageStoreSetPage(_store, (size_t)index, data.bytes, data.length))
+    NSLog(@"warning: could not store the annotations of page %ld", (long)index);
+}
+
+
+- (BOOL)hasDataForPageAtIndex:(NSInteger)index
+{
+  if (index < 0 || index >= _pageCount)
+    return NO;
+  return PTDPageStoreHasPage(_store, (size_t)index);
+}
+
+
+- (NSUInteger)revisionOfPageAtIndex:(NSInteger)index
+{
+  if (index < 0 || index >= _pageCount)
+    return 0;
+  return (NSUInteger)PTDPageStoreRevision(_store, (size_t)index);
+}
+
+
+- (void)removeAllData
+{
+  PTDPageStoreRemoveAllPages(_store);
+}
+
+
+@end
@@ -26,6 +26,7 @@
 #import <Sparkle/Sparkle.h>
 #import "PTDToolManager.h"
 #import "PTDTool.h"
+#import "PTDToolOptions.h"
 #import "PTDAppDelegate.h"
 #import "PTDAbstractPaintWindowController.h"
 #import "PTDScreenPaintWindowController.h"
@@ -37,6 +38,12 @@
 #import "PTDPDFPresentationPaintWindowController.h"
 #import "NSWindow+PTD.h"
 #import "PTDPDFAnnotationPaintWindowController.h"
+#import "PTDUtils.h"
+
+
+/* the updater checks its feed on start, which is not worth delaying the
+ * menu bar icon for */
+static const NSTimeInterval _UpdaterStartDelay = 5.0;
 
 
 @interface PTDAppDelegate ()
@@ -56,6 +63,8 @@
 
 @implementation PTDAppDelegate {
   NSInteger _dockRefCount;
+  BOOL _updaterStarted;
+  BOOL _activatedOnce;
 }
 
 
@@ -87,8 +96,9 @@
   NSUserDefaults *ud = NSUserDefaults.standardUserDefaults;
   _alwaysShowsDockIcon = [ud boolForKey:@"PTDAlwaysShowsDockIcon"];
   
-  _updateController = [[SPUStandardUpdaterController alloc] initWithStartingUpdater:YES updaterDelegate:nil userDriverDelegate:nil];
+  _updateController = [[SPUStandardUpdaterController alloc] initWithStartingUpdater:NO updaterDelegate:nil userDriverDelegate:nil];
   
+  PTDStartupTraceMark(@"app delegate initialized");
   return self;
 }
 
@@ -103,7 +113,10 @@
     [self hideDockIcon];
   
   [self setupMenu];
+  PTDStartupTraceMark(@"menu bar icon shown");
+  /* the windows and their canvases are created when drawing is enabled */
   [self updateScreenPaintWindows];
+  PTDStartupTraceMark(@"screen paintings registered");
   
   NSUserDefaults *ud = NSUserDefaults.standardUserDefaults;
   NSNumber *showAboutScreen = [ud objectForKey:@"PTDAboutPanelDisplayOnLaunch"];
@@ -112,6 +125,29 @@
   if (showAboutScreen == nil || showAboutScreen.boolValue == YES) {
     [self openAboutWindow:self];
   }
+  
+  __weak PTDAppDelegate *weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_UpdaterStartDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+    [weakSelf startUpdater];
+  });
+  PTDStartupTraceMark(@"launch finished");
+}
+
+
+- (void)startUpdater
+{
+  if (_updaterStarted)
+    return;
+  _updaterStarted = YES;
+  [self.updateController startUpdater];
+  PTDStartupTraceMark(@"updater started");
+}
+
+
+- (void)checkForUpdates:(id)sender
+{
+  [self startUpdater];
+  [self.updateController checkForUpdates:sender];
 }
 
 
@@ -167,6 +203,7 @@
 
 - (void)applicationWillTerminate:(NSNotification *)aNotification
 {
+  [PTDToolOptions.sharedOptions synchronize];
 }
 
 
@@ -215,6 +252,11 @@
       else
         [wc applicationDidDisableDrawing];
     }
+    
+    if (active && !_activatedOnce) {
+      _activatedOnce = YES;
+      PTDStartupTraceMark(@"first activation");
+    }
   }
 }
 
@@ -239,7 +281,7 @@
   [prefsMi setTarget:self];
   
   NSMenuItem *sparkleMi = [res addItemWithTitle:NSLocalizedString(@"Check for Updates...", @"") action:@selector(checkForUpdates:) keyEquivalent:@""];
-  [sparkleMi setTarget:self.updateController];
+  [sparkleMi setTarget:self];
   
   [res addItem:[NSMenuItem separatorItem]];
   
@@ -266,6 +308,8 @@
 
 - (BOOL)validateMenuItem:(NSMenuItem *)menuItem
 {
+  if (menuItem.action == @selector(checkForUpdates:))
+    return !_updaterStarted || [self.updateController validateMenuItem:menuItem];
   if (self.active) {
     if (menuItem.action == @selector(newCanvasWindow:) ||
         menuItem.action == @selector(newPresentationWindow:) ||
@@ -287,7 +331,12 @@
 
 - (NSMenuItem *)menuItemForPainting:(PTDAbstractPaintWindowController *)paintw
 {
-  NSString *title = [NSString stringWithFormat:@"%@", paintw.displayName];
+  NSString *memory = [NSByteCountFormatter stringFromByteCount:(long long)paintw.memoryUsage countStyle:NSByteCountFormatterCountStyleMemory];
+  NSString *title;
+  if (paintw.compressed)
+    title = [NSString stringWithFormat:NSLocalizedString(@"%@ — %@ compressed", @"Format string for painting menu items; name and memory usage of a compressed painting"), paintw.displayName, memory];
+  else
+    title = [NSString stringWithFormat:NSLocalizedString(@"%@ — %@", @"Format string for painting menu items; name and memory usage of the painting"), paintw.displayName, memory];
   NSMenuItem *mi = [NSMenuItem ptd_menuItemWithLabel:title thumbnail:paintw.thumbnail thumbnailArea:0];
   NSMenu *submenu = [paintw windowMenu];
   if (submenu)
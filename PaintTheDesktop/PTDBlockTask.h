@@ -0,0 +1,39 @@
+//
+// PTDBlockTask.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "PTDTaskScheduler.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* The block runs inside an autorelease pool, and not at all if the task is
+ * cancelled before it starts. The returned task must be released. */
+PTDTask *PTDBlockTaskCreate(PTDTaskPriority priority, void (^block)(PTDTask *task));
+
+/* Submits a task which nobody needs to wait for or cancel to the shared
+ * scheduler. */
+void PTDBlockTaskSubmit(PTDTaskPriority priority, void (^block)(void));
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,53 @@
+//
+// PTDBlockTask.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDBlockTask.h"
+
+
+static void PTDBlockTaskRun(PTDTask *task, void *context)
+{
+  void (^block)(PTDTask *) = (__bridge_transfer void (^)(PTDTask *))context;
+  if (PTDTaskIsCancelled(task))
+    return;
+  @autoreleasepool {
+    block(task);
+  }
+}
+
+
+PTDTask *PTDBlockTaskCreate(PTDTaskPriority priority, void (^block)(PTDTask *task))
+{
+  return PTDTaskCreate(priority, PTDBlockTaskRun, (__bridge_retained void *)[block copy]);
+}
+
+
+void PTDBlockTaskSubmit(PTDTaskPriority priority, void (^block)(void))
+{
+  PTDTask *task = PTDBlockTaskCreate(priority, ^(PTDTask *unused) {
+    block();
+  });
+  PTDTaskSchedulerSubmit(PTDTaskSchedulerShared(), task);
+  PTDTaskRelease(task);
+}
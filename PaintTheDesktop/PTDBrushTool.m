@@ -104,7 +104,7 @@ NSString * const PTDBrushToolOptionSizeOptions = @"brushSizeOptions";
 
 - (void)reloadOptions
 {
-  self.size = [[[PTDToolOptions sharedOptions] objectForOption:PTDBrushToolOptionSize ofToolClass:nil] integerValue];
+  self.size = [[PTDToolOptions sharedOptions] integerForOption:PTDBrushToolOptionSize ofToolClass:nil];
   self.color = [[PTDToolOptions sharedOptions] objectForOption:PTDBrushToolOptionColor ofToolClass:nil];
 }
 
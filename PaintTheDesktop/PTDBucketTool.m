@@ -0,0 +1,205 @@
+//
+// PTDBucketTool.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#import "PTDBucketTool.h"
+#import "PTDBrushTool.h"
+#import "PTDDrawingSurface.h"
+#import "PTDToolOptions.h"
+#import "PTDCursor.h"
+#import "PTDGraphics.h"
+#import "PTDFloodFill.h"
+
+
+NSString * const PTDToolIdentifierBucketTool = @"PTDToolIdentifierBucketTool";
+
+NSString * const PTDBucketToolOptionTolerance = @"tolerance";
+NSString * const PTDBucketToolOptionGapSize = @"gapSize";
+
+
+@implementation PTDBucketTool
+
+
++ (void)registerDefaults
+{
+  PTDToolOptions *o = PTDToolOptions.sharedOptions;
+  [o registerOption:PTDBucketToolOptionTolerance ofToolClass:self types:@[[NSNumber class]] defaultValue:@(32) validationBlock:nil];
+  [o registerOption:PTDBucketToolOptionGapSize ofToolClass:self types:@[[NSNumber class]] defaultValue:@(0) validationBlock:nil];
+}
+
+
+- (void)reloadOptions
+{
+  self.color = [PTDToolOptions.sharedOptions objectForOption:PTDBrushToolOptionColor ofToolClass:nil];
+  self.tolerance = [PTDToolOptions.sharedOptions integerForOption:PTDBucketToolOptionTolerance ofToolClass:self.class];
+  self.gapSize = [PTDToolOptions.sharedOptions integerForOption:PTDBucketToolOptionGapSize ofToolClass:self.class];
+}
+
+
++ (NSString *)toolIdentifier
+{
+  return PTDToolIdentifierBucketTool;
+}
+
+
++ (PTDRingMenuItem *)menuItem
+{
+  return [PTDRingMenuItem itemWithImage:[NSImage imageNamed:@"PTDToolIconBucket"] target:nil action:nil];
+}
+
+
+- (void)activate
+{
+  self.cursor = [PTDCursor cursorFromCursor:[NSCursor crosshairCursor]];
+}
+
+
+- (void)mouseClickedAtPoint:(NSPoint)point
+{
+  PTDDrawingSurface *surface = self.currentDrawingSurface;
+  NSPoint seed = [surface convertPointToCanvasPixels:point];
+  if (seed.x < 0 || seed.y < 0)
+    return;
+  
+  PTDFloodFillOptions options = {
+    .tolerance = (uint8_t)MIN(MAX(self.tolerance, 0), 255),
+    .gapSize = (unsigned)MAX(self.gapSize, 0),
+    .antialias = 1
+  };
+  NSColor *fill = [self.color colorUsingColorSpace:surface.canvasColorSpace];
+  if (!fill)
+    return;
+  NSSize scale = surface.backingScaleFactor;
+  CGFloat height = NSHeight(surface.bounds);
+  
+  /* large fills take a while, so they run on the raster worker; they can
+   * spread over the whole canvas, and stop at the canvas objects */
+  [surface enqueueCanvasModificationInRect:surface.bounds usingBlock:^NSRect(const PTDPixelBuffer *canvas) {
+    PTDSelectionMask mask;
+    if (!PTDFloodFill(canvas, (size_t)seed.x, (size_t)seed.y, &options, &mask)) {
+      NSLog(@"warning: could not allocate the flood fill mask");
+      return NSZeroRect;
+    }
+    
+    uint8_t pixel[4];
+    CGFloat alpha = fill.alphaComponent;
+    pixel[0] = (uint8_t)round([fill redComponent] * alpha * 255.0);
+    pixel[1] = (uint8_t)round([fill greenComponent] * alpha * 255.0);
+    pixel[2] = (uint8_t)round([fill blueComponent] * alpha * 255.0);
+    pixel[3] = (uint8_t)round(alpha * 255.0);
+    PTDSelectionMaskFill(&mask, canvas, pixel);
+    
+    /* the surface is not used on this thread */
+    NSRect px = NSMakeRect(mask.x, mask.y, mask.width, mask.height);
+    NSRect dirty = NSMakeRect(
+        NSMinX(px) / scale.width,
+        height - NSMaxY(px) / scale.height,
+        NSWidth(px) / scale.width,
+        NSHeight(px) / scale.height);
+    PTDSelectionMaskFree(&mask);
+    return dirty;
+  }];
+}
+
+
+- (nullable PTDRingMenuRing *)optionMenu
+{
+  PTDRingMenuRing *res = [PTDRingMenuRing ring];
+  
+  [res beginGravityMassGroupWithAngle:M_PI_2];
+  static const NSInteger tolerances[] = {0, 32, 64, 128};
+  for (int i = 0; i < 4; i++) {
+    NSString *title = [NSString stringWithFormat:@"%d%%", (int)round(tolerances[i] * 100.0 / 255.0)];
+    PTDRingMenuItem *itm = [res addItemWithText:title target:self action:@selector(changeTolerance:)];
+    itm.tag = tolerances[i];
+    if (tolerances[i] == self.tolerance)
+      itm.state = NSControlStateValueOn;
+  }
+  [res endGravityMassGroup];
+  
+  [res addSpringWithElasticity:1000];
+  
+  [res beginGravityMassGroupWithAngle:0];
+  PTDRingMenuItem *itm;
+  itm = [res addItemWithText:NSLocalizedString(@"No Gap Closing", @"Menu item for letting the fill leak through gaps") target:self action:@selector(changeGapSize:)];
+  itm.tag = 0;
+  if (self.gapSize == 0)
+    itm.state = NSControlStateValueOn;
+  itm = [res addItemWithText:NSLocalizedString(@"Close Small Gaps", @"Menu item for stopping the fill at small gaps") target:self action:@selector(changeGapSize:)];
+  itm.tag = 4;
+  if (self.gapSize == 4)
+    itm.state = NSControlStateValueOn;
+  itm = [res addItemWithText:NSLocalizedString(@"Close Large Gaps", @"Menu item for stopping the fill at large gaps") target:self action:@selector(changeGapSize:)];
+  itm.tag = 10;
+  if (self.gapSize == 10)
+    itm.state = NSControlStateValueOn;
+  [res endGravityMassGroup];
+  
+  [res addSpringWithElasticity:1000];
+  
+  NSArray <NSColor *> *colors = [[PTDToolOptions sharedOptions] objectForOption:PTDBrushToolOptionColorOptions ofToolClass:nil];
+  for (NSColor *color in colors) {
+    PTDRingMenuItem *item = [self menuItemForFillColor:color];
+    [res addItem:item];
+  }
+  
+  [res addSpringWithElasticity:1000];
+  return res;
+}
+
+
+- (PTDRingMenuItem *)menuItemForFillColor:(NSColor *)color
+{
+  NSImage *img = [NSImage imageWithSize:NSMakeSize(16, 16) flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+    PTDDrawCircularColorSwatch(NSMakeRect(3, 3, 16-6, 16-6), color);
+    return YES;
+  }];
+  PTDRingMenuItem *itm = [PTDRingMenuItem itemWithImage:img target:self action:@selector(changeColor:)];
+  itm.representedObject = color;
+  if ([color isEqual:self.color])
+    itm.state = NSControlStateValueOn;
+  return itm;
+}
+
+
+- (void)changeColor:(id)sender
+{
+  [[PTDToolOptions sharedOptions] setObject:sender forOption:PTDBrushToolOptionColor ofToolClass:nil];
+}
+
+
+- (void)changeTolerance:(id)sender
+{
+  [[PTDToolOptions sharedOptions] setObject:@([sender tag]) forOption:PTDBucketToolOptionTolerance ofToolClass:self.class];
+}
+
+
+- (void)changeGapSize:(id)sender
+{
+  [[PTDToolOptions sharedOptions] setObject:@([sender tag]) forOption:PTDBucketToolOptionGapSize ofToolClass:self.class];
+}
+
+
+@end
@@ -0,0 +1,253 @@
+//
+// PTDBufferPool.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/* posix_memalign is POSIX; Darwin declares it anyway, and the macro would
+ * hide the dispatch functions there */
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#endif
+#include "PTDBufferPool.h"
+
+
+#define MIN_POOLED_SHIFT 14
+#define MAX_POOLED_SHIFT 28
+#define CLASS_COUNT (2 * (MAX_POOLED_SHIFT - MIN_POOLED_SHIFT + 1))
+
+static const size_t _CacheLimit = 128 * 1024 * 1024;
+
+
+typedef struct PTDBufferPoolNode {
+  struct PTDBufferPoolNode *next;
+} PTDBufferPoolNode;
+
+static pthread_mutex_t _Lock = PTHREAD_MUTEX_INITIALIZER;
+static PTDBufferPoolNode *_FreeLists[CLASS_COUNT];
+static PTDBufferPoolStatistics _Statistics;
+static size_t _PageSize;
+
+
+static void PTDBufferPoolInitialize(void)
+{
+  long pageSize = sysconf(_SC_PAGESIZE);
+  _PageSize = pageSize > 0 ? (size_t)pageSize : 4096;
+  
+#ifdef __APPLE__
+  dispatch_source_t source = dispatch_source_create(
+      DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+      DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+      dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+  dispatch_source_set_event_handler(source, ^{
+    if (dispatch_source_get_data(source) & DISPATCH_MEMORYPRESSURE_CRITICAL) {
+      PTDBufferPoolTrim(0);
+    } else {
+      PTDBufferPoolStatistics stats;
+      PTDBufferPoolGetStatistics(&stats);
+      PTDBufferPoolTrim(stats.bytesCached / 2);
+    }
+  });
+  dispatch_resume(source);
+#endif
+}
+
+
+static void PTDBufferPoolInitializeOnce(void)
+{
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once(&once, PTDBufferPoolInitialize);
+}
+
+
+#ifdef __APPLE__
+
+/* the cache is emptied after no buffer was requested for this long */
+static const int64_t _IdleTrimDelay = 10;
+static size_t _LastAllocations;
+static bool _IdleTrimScheduled;
+
+static void PTDBufferPoolScheduleIdleTrim(void);
+
+static void PTDBufferPoolIdleTrim(void *unused)
+{
+  pthread_mutex_lock(&_Lock);
+  _IdleTrimScheduled = false;
+  bool idle = _Statistics.systemAllocations + _Statistics.reuses == _LastAllocations;
+  if (!idle && _Statistics.bytesCached > 0)
+    PTDBufferPoolScheduleIdleTrim();
+  pthread_mutex_unlock(&_Lock);
+  
+  if (idle)
+    PTDBufferPoolTrim(0);
+}
+
+
+/* Must be called with the lock held. */
+static void PTDBufferPoolScheduleIdleTrim(void)
+{
+  if (_IdleTrimScheduled)
+    return;
+  _IdleTrimScheduled = true;
+  _LastAllocations = _Statistics.systemAllocations + _Statistics.reuses;
+  dispatch_after_f(
+      dispatch_time(DISPATCH_TIME_NOW, _IdleTrimDelay * NSEC_PER_SEC),
+      dispatch_get_global_queue(QOS_CLASS_BACKGROUND, 0),
+      NULL, PTDBufferPoolIdleTrim);
+}
+
+#endif
+
+
+/* Returns -1 for sizes which are not pooled. */
+static int PTDBufferPoolClass(size_t size, size_t *classSize)
+{
+  if (size < ((size_t)1 << MIN_POOLED_SHIFT) || size > ((size_t)1 << MAX_POOLED_SHIFT))
+    return -1;
+  int shift = MIN_POOLED_SHIFT;
+  while (((size_t)1 << shift) < size)
+    shift++;
+  
+  size_t power = (size_t)1 << shift;
+  size_t midpoint = power / 4 * 3;
+  int index = 2 * (shift - MIN_POOLED_SHIFT);
+  if (size <= midpoint && midpoint >= ((size_t)1 << MIN_POOLED_SHIFT)) {
+    *classSize = midpoint;
+    return index;
+  }
+  *classSize = power;
+  return index + 1;
+}
+
+
+void *PTDBufferPoolAlloc(size_t size)
+{
+  size_t classSize;
+  int c = PTDBufferPoolClass(size, &classSize);
+  if (c < 0)
+    return malloc(size > 0 ? size : 1);
+  PTDBufferPoolInitializeOnce();
+  
+  pthread_mutex_lock(&_Lock);
+  PTDBufferPoolNode *node = _FreeLists[c];
+  if (node) {
+    _FreeLists[c] = node->next;
+    _Statistics.bytesCached -= classSize;
+    _Statistics.reuses++;
+  } else {
+    _Statistics.systemAllocations++;
+  }
+  _Statistics.bytesInUse += classSize;
+  if (_Statistics.bytesInUse > _Statistics.peakBytesInUse)
+    _Statistics.peakBytesInUse = _Statistics.bytesInUse;
+  pthread_mutex_unlock(&_Lock);
+  
+  if (node)
+    return node;
+  void *buffer;
+  if (posix_memalign(&buffer, _PageSize, classSize) != 0) {
+    pthread_mutex_lock(&_Lock);
+    _Statistics.systemAllocations--;
+    _Statistics.bytesInUse -= classSize;
+    pthread_mutex_unlock(&_Lock);
+    return NULL;
+  }
+  return buffer;
+}
+
+
+void PTDBufferPoolFree(void *buffer, size_t size)
+{
+  if (!buffer)
+    return;
+  size_t classSize;
+  int c = PTDBufferPoolClass(size, &classSize);
+  if (c < 0) {
+    free(buffer);
+    return;
+  }
+  
+  pthread_mutex_lock(&_Lock);
+  _Statistics.bytesInUse -= classSize;
+  bool keep = _Statistics.bytesCached + classSize <= _CacheLimit;
+  if (keep) {
+    PTDBufferPoolNode *node = buffer;
+    node->next = _FreeLists[c];
+    _FreeLists[c] = node;
+    _Statistics.bytesCached += classSize;
+#ifdef __APPLE__
+    PTDBufferPoolScheduleIdleTrim();
+#endif
+  } else {
+    _Statistics.systemFrees++;
+  }
+  pthread_mutex_unlock(&_Lock);
+  
+  if (!keep)
+    free(buffer);
+}
+
+
+void PTDBufferPoolTrim(size_t keepBytes)
+{
+  PTDBufferPoolNode *released = NULL;
+  
+  pthread_mutex_lock(&_Lock);
+  /* the largest buffers first, as they are the least likely to fit the
+   * next request anyway */
+  for (int c = CLASS_COUNT - 1; c >= 0 && _Statistics.bytesCached > keepBytes; c--) {
+    size_t classSize = ((size_t)1 << (MIN_POOLED_SHIFT + c / 2));
+    if (c % 2 == 0)
+      classSize = classSize / 4 * 3;
+    while (_FreeLists[c] && _Statistics.bytesCached > keepBytes) {
+      PTDBufferPoolNode *node = _FreeLists[c];
+      _FreeLists[c] = node->next;
+      node->next = released;
+      released = node;
+      _Statistics.bytesCached -= classSize;
+      _Statistics.systemFrees++;
+    }
+  }
+  pthread_mutex_unlock(&_Lock);
+  
+  while (released) {
+    PTDBufferPoolNode *next = released->next;
+    free(released);
+    released = next;
+  }
+}
+
+
+void PTDBufferPoolGetStatistics(PTDBufferPoolStatistics *statistics)
+{
+  pthread_mutex_lock(&_Lock);
+  *statistics = _Statistics;
+  pthread_mutex_unlock(&_Lock);
+}
@@ -0,0 +1,74 @@
+//
+// PTDBufferPool.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDBufferPool_h
+#define PTDBufferPool_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A process-wide cache of the large buffers used for transient bitmaps, so
+ * that a buffer freed by one operation can be handed to the next one without
+ * going back to the system and faulting its pages in again.
+ *
+ * Sizes are rounded up to a class; the classes are the powers of two and
+ * the midpoints between them, so at most a third of a buffer is wasted.
+ * Pooled buffers are aligned to a page. Requests too small or too large to
+ * be worth keeping go straight to malloc. Freed buffers are kept up to a limit,
+ * and released when the system is under memory pressure. All functions can
+ * be called from any thread. */
+
+typedef struct {
+  /* buffers obtained from and returned to the system */
+  size_t systemAllocations;
+  size_t systemFrees;
+  /* requests served by a buffer kept in the pool */
+  size_t reuses;
+  size_t bytesInUse;
+  size_t bytesCached;
+  /* the highest value of bytesInUse so far */
+  size_t peakBytesInUse;
+} PTDBufferPoolStatistics;
+
+/* The contents of the buffer are undefined. Returns NULL on failure. */
+void *PTDBufferPoolAlloc(size_t size);
+/* The size must be the one the buffer was allocated with. */
+void PTDBufferPoolFree(void *buffer, size_t size);
+
+/* Releases cached buffers until at most the given number of bytes are
+ * cached. */
+void PTDBufferPoolTrim(size_t keepBytes);
+
+void PTDBufferPoolGetStatistics(PTDBufferPoolStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDBufferPool_h */
@@ -0,0 +1,61 @@
+//
+// PTDBufferPoolImage.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "PTDBufferPoolImage.h"
+#include "PTDBufferPool.h"
+
+
+static void PTDBufferPoolReleaseImageData(void *info, const void *data, size_t size)
+{
+  PTDBufferPoolFree((void *)data, size);
+}
+
+
+CGImageRef PTDBufferPoolCreateImage(size_t width, size_t height, CGColorSpaceRef colorSpace, CGBitmapInfo bitmapInfo, void (^draw)(CGContextRef context))
+{
+  /* rows aligned to a cache line, like CoreGraphics does by itself */
+  size_t bytesPerRow = (width * 4 + 63) & ~(size_t)63;
+  size_t size = bytesPerRow * height;
+  void *data = PTDBufferPoolAlloc(size);
+  if (!data)
+    return NULL;
+  
+  CGContextRef context = CGBitmapContextCreate(data, width, height, 8, bytesPerRow, colorSpace, bitmapInfo);
+  if (!context) {
+    PTDBufferPoolFree(data, size);
+    return NULL;
+  }
+  draw(context);
+  CGContextRelease(context);
+  
+  CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, data, size, PTDBufferPoolReleaseImageData);
+  if (!provider) {
+    PTDBufferPoolFree(data, size);
+    return NULL;
+  }
+  CGImageRef image = CGImageCreate(width, height, 8, 32, bytesPerRow, colorSpace, bitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+  CGDataProviderRelease(provider);
+  return image;
+}
@@ -0,0 +1,45 @@
+//
+// PTDBufferPoolImage.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDBufferPoolImage_h
+#define PTDBufferPoolImage_h
+
+#include <CoreGraphics/CoreGraphics.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Draws in a bitmap context backed by a buffer of PTDBufferPool, then hands
+ * the buffer over to the returned image without copying it; it goes back to
+ * the pool once the image is released. The context initially contains
+ * garbage, so the block must clear or fill it. */
+CGImageRef PTDBufferPoolCreateImage(size_t width, size_t height, CGColorSpaceRef colorSpace, CGBitmapInfo bitmapInfo, void (^draw)(CGContextRef context));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDBufferPoolImage_h */
@@ -0,0 +1,53 @@
+//
+// PTDCanvasMemoryBudget.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class PTDPaintView;
+
+/* Keeps the memory taken by all the canvases under a budget. When the
+ * budget is exceeded, the canvases which were not drawn on for a while are
+ * compressed, starting from those that are not visible and then from the
+ * least recently changed; when the system is low on memory, every canvas
+ * which is not being drawn on right now is. */
+@interface PTDCanvasMemoryBudget : NSObject
+
++ (PTDCanvasMemoryBudget *)sharedBudget;
+
+/* In bytes, from the PTDCanvasMemoryBudget default which is in megabytes. */
+@property (nonatomic, readonly) size_t budget;
+@property (nonatomic, readonly) size_t memoryUsage;
+
+/* Views are not retained, and stop being tracked when they go away. */
+- (void)addPaintView:(PTDPaintView *)view;
+/* Called when a canvas is drawn on, or when its buffers are reallocated. */
+- (void)paintViewDidChangeCanvas:(PTDPaintView *)view;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,168 @@
+//
+// PTDCanvasMemoryBudget.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#import "PTDCanvasMemoryBudget.h"
+#import "PTDPaintView.h"
+
+
+static const NSTimeInterval _CheckDelay = 2.0;
+/* canvases changed more recently than this count as being drawn on */
+static const NSTimeInterval _IdleInterval = 60.0;
+static const NSTimeInterval _MemoryPressureIdleInterval = 5.0;
+
+
+@implementation PTDCanvasMemoryBudget {
+  NSHashTable<PTDPaintView *> *_paintViews;
+  BOOL _checkScheduled;
+  dispatch_source_t _memoryPressureSource;
+}
+
+
++ (PTDCanvasMemoryBudget *)sharedBudget
+{
+  static PTDCanvasMemoryBudget *singleton;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    singleton = [[PTDCanvasMemoryBudget alloc] init];
+  });
+  return singleton;
+}
+
+
+- (instancetype)init
+{
+  self = [super init];
+  _paintViews = [NSHashTable weakObjectsHashTable];
+  
+  NSUserDefaults *ud = NSUserDefaults.standardUserDefaults;
+  [ud registerDefaults:@{@"PTDCanvasMemoryBudget": @(512)}];
+  _budget = (size_t)MAX(0, [ud integerForKey:@"PTDCanvasMemoryBudget"]) * 1024 * 1024;
+  
+  _memoryPressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0, DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL, dispatch_get_main_queue());
+  __weak PTDCanvasMemoryBudget *weakSelf = self;
+  dispatch_source_set_event_handler(_memoryPressureSource, ^{
+    [weakSelf compressCanvasesIdleFor:_MemoryPressureIdleInterval untilMemoryUsage:0];
+  });
+  dispatch_resume(_memoryPressureSource);
+  return self;
+}
+
+
+- (void)addPaintView:(PTDPaintView *)view
+{
+  [_paintViews addObject:view];
+  [self scheduleCheck];
+}
+
+
+- (void)paintViewDidChangeCanvas:(PTDPaintView *)view
+{
+  [self scheduleCheck];
+}
+
+
+- (size_t)memoryUsage
+{
+  size_t usage = 0;
+  for (PTDPaintView *view in _paintViews)
+    usage += view.canvasMemoryUsage;
+  return usage;
+}
+
+
+- (void)scheduleCheck
+{
+  [self scheduleCheckAfterDelay:_CheckDelay];
+}
+
+
+- (void)scheduleCheckAfterDelay:(NSTimeInterval)delay
+{
+  if (_checkScheduled)
+    return;
+  _checkScheduled = YES;
+  
+  __weak PTDCanvasMemoryBudget *weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+    [weakSelf checkBudget];
+  });
+}
+
+
+- (void)checkBudget
+{
+  _checkScheduled = NO;
+  if (self.memoryUsage <= _budget)
+    return;
+  if ([self compressCanvasesIdleFor:_IdleInterval untilMemoryUsage:_budget])
+    return;
+  /* try again once the canvases drawn on recently become idle */
+  [self scheduleCheckAfterDelay:_IdleInterval];
+}
+
+
+/* Returns NO if the usage is still above the target after the canvases
+ * being compressed are done, and some canvas may become idle later. */
+- (BOOL)compressCanvasesIdleFor:(NSTimeInterval)interval untilMemoryUsage:(size_t)target
+{
+  NSTimeInterval now = NSProcessInfo.processInfo.systemUptime;
+  NSMutableArray<PTDPaintView *> *candidates = [NSMutableArray array];
+  BOOL waitingForIdle = NO;
+  size_t usage = 0;
+  for (PTDPaintView *view in _paintViews) {
+    usage += view.canvasMemoryUsage;
+    if (view.canvasCompressed)
+      continue;
+    if (now - view.lastCanvasChangeTime >= interval)
+      [candidates addObject:view];
+    else
+      waitingForIdle = YES;
+  }
+  
+  [candidates sortUsingComparator:^NSComparisonResult(PTDPaintView *a, PTDPaintView *b) {
+    BOOL aVisible = (a.window.occlusionState & NSWindowOcclusionStateVisible) != 0;
+    BOOL bVisible = (b.window.occlusionState & NSWindowOcclusionStateVisible) != 0;
+    if (aVisible != bVisible)
+      return aVisible ? NSOrderedDescending : NSOrderedAscending;
+    if (a.lastCanvasChangeTime != b.lastCanvasChangeTime)
+      return a.lastCanvasChangeTime < b.lastCanvasChangeTime ? NSOrderedAscending : NSOrderedDescending;
+    return NSOrderedSame;
+  }];
+  
+  for (PTDPaintView *view in candidates) {
+    if (usage <= target)
+      break;
+    if ([NSUserDefaults.standardUserDefaults boolForKey:@"debug"])
+      NSLog(@"canvas memory usage %zu over %zu, compressing %@", usage, target, view);
+    /* assume that the compressed canvas takes next to nothing */
+    usage -= MIN(usage, view.canvasMemoryUsage);
+    [view compressCanvas];
+  }
+  return usage <= target || !waitingForIdle;
+}
+
+
+@end
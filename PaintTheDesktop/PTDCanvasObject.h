@@ -0,0 +1,86 @@
+//
+// PTDCanvasObject.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+#import "PTDShapeRaster.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Something drawn on a canvas which is kept editable until it is flattened
+ * into the canvas pixels. Canvas objects are immutable; editing one means
+ * replacing it with a new object. */
+@interface PTDCanvasObject : NSObject
+
+/* Covers everything the object draws, in view coordinates. */
+@property (nonatomic, readonly) NSRect bounds;
+
+/* Draws in the current graphics context, in view coordinates. */
+- (void)draw;
+
+- (BOOL)containsPoint:(NSPoint)point;
+
+/* Draws the object into a canvas whose pixels correspond to view
+ * coordinates multiplied by the given scale. The default implementation
+ * uses -draw. */
+- (void)drawInCanvas:(NSBitmapImageRep *)canvas backingScaleFactor:(NSSize)scale;
+
+/* Returns a block which draws the object like -drawInCanvas:backingScaleFactor:
+ * into the pixels of a canvas with the given color space, and can run on any
+ * thread. Returns nil, the default, if the object can only be drawn on the
+ * main thread. */
+- (nullable void (^)(const PTDPixelBuffer *canvas))canvasPixelDrawerWithColorSpace:(NSColorSpace *)colorSpace backingScaleFactor:(NSSize)scale;
+
+@end
+
+
+/* A stroked path, with the line width and the other stroke attributes
+ * taken from the path. Filled shapes are also filled with the same color. */
+@interface PTDShapeCanvasObject : PTDCanvasObject
+
+- (instancetype)initWithPath:(NSBezierPath *)path color:(NSColor *)color;
+- (instancetype)initWithPath:(NSBezierPath *)path color:(NSColor *)color filled:(BOOL)filled;
+
+@property (nonatomic, readonly) NSBezierPath *path;
+@property (nonatomic, readonly) NSColor *color;
+@property (nonatomic, readonly, getter=isFilled) BOOL filled;
+
+- (PTDShapeCanvasObject *)objectByChangingLineWidth:(CGFloat)width color:(NSColor *)color;
+
+@end
+
+
+/* A rectangle, rounded rectangle or oval, which is flattened by the
+ * analytic shape rasterizer instead of AppKit. */
+@interface PTDPrimitiveShapeCanvasObject : PTDShapeCanvasObject
+
+- (instancetype)initWithKind:(PTDShapeRasterKind)kind rect:(NSRect)rect cornerRadius:(CGFloat)radius lineWidth:(CGFloat)width color:(NSColor *)color filled:(BOOL)filled;
+
+@property (nonatomic, readonly) PTDShapeRasterKind kind;
+@property (nonatomic, readonly) NSRect rect;
+@property (nonatomic, readonly) CGFloat cornerRadius;
+
+@end
+
+NS_ASSUME_NONNULL_END
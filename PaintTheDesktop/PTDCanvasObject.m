@@ -0,0 +1,221 @@
+//
+// PTDCanvasObject.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDCanvasObject.h"
+#import "NSBezierPath+PTD.h"
+#import "NSBitmapImageRep+PTD.h"
+#import "PTDUtils.h"
+
+
+/* Minimum width of the area around a line which hits it */
+static const CGFloat _HitTestLineWidth = 8.0;
+
+
+@implementation PTDCanvasObject
+
+
+- (NSRect)bounds
+{
+  PTDAbstract();
+}
+
+
+- (void)draw
+{
+  PTDAbstract();
+}
+
+
+- (BOOL)containsPoint:(NSPoint)point
+{
+  return NSPointInRect(point, self.bounds);
+}
+
+
+- (void)drawInCanvas:(NSBitmapImageRep *)canvas backingScaleFactor:(NSSize)scale
+{
+  NSGraphicsContext *ctxt = [NSGraphicsContext graphicsContextWithBitmapImageRep:canvas];
+  CGContextScaleCTM(ctxt.CGContext, scale.width, scale.height);
+  [NSGraphicsContext saveGraphicsState];
+  NSGraphicsContext.currentContext = ctxt;
+  [self draw];
+  [NSGraphicsContext restoreGraphicsState];
+}
+
+
+- (nullable void (^)(const PTDPixelBuffer *canvas))canvasPixelDrawerWithColorSpace:(NSColorSpace *)colorSpace backingScaleFactor:(NSSize)scale
+{
+  return nil;
+}
+
+
+@end
+
+
+@implementation PTDShapeCanvasObject {
+  NSRect _bounds;
+}
+
+
+- (instancetype)initWithPath:(NSBezierPath *)path color:(NSColor *)color
+{
+  return [self initWithPath:path color:color filled:NO];
+}
+
+
+- (instancetype)initWithPath:(NSBezierPath *)path color:(NSColor *)color filled:(BOOL)filled
+{
+  self = [super init];
+  _path = [path copy];
+  _color = color;
+  _filled = filled;
+  /* miter joins can extend up to the whole line width from the path */
+  _bounds = NSInsetRect(_path.bounds, -_path.lineWidth - 1.0, -_path.lineWidth - 1.0);
+  return self;
+}
+
+
+- (PTDShapeCanvasObject *)objectByChangingLineWidth:(CGFloat)width color:(NSColor *)color
+{
+  NSBezierPath *path = [_path copy];
+  path.lineWidth = width;
+  return [[PTDShapeCanvasObject alloc] initWithPath:path color:color filled:_filled];
+}
+
+
+- (NSRect)bounds
+{
+  return _bounds;
+}
+
+
+- (void)draw
+{
+  [NSGraphicsContext.currentContext setShouldAntialias:YES];
+  if (_filled) {
+    [_color setFill];
+    [_path fill];
+  }
+  [_color setStroke];
+  [_path stroke];
+}
+
+
+- (BOOL)containsPoint:(NSPoint)point
+{
+  if (!NSPointInRect(point, _bounds))
+    return NO;
+  if (_filled && [_path containsPoint:point])
+    return YES;
+  CGFloat width = MAX(_path.lineWidth, _HitTestLineWidth);
+  CGPathRef outline = CGPathCreateCopyByStrokingPath(_path.ptd_CGPath, NULL, width, kCGLineCapRound, kCGLineJoinRound, 10.0);
+  BOOL res = CGPathContainsPoint(outline, NULL, point, false);
+  CGPathRelease(outline);
+  return res;
+}
+
+
+@end
+
+
+@implementation PTDPrimitiveShapeCanvasObject
+
+
++ (NSBezierPath *)pathWithKind:(PTDShapeRasterKind)kind rect:(NSRect)rect cornerRadius:(CGFloat)radius
+{
+  switch (kind) {
+    case PTDShapeRasterKindRectangle:
+      return [NSBezierPath bezierPathWithRect:rect];
+    case PTDShapeRasterKindRoundRect:
+      return [NSBezierPath bezierPathWithRoundedRect:rect xRadius:radius yRadius:radius];
+    case PTDShapeRasterKindOval:
+      return [NSBezierPath bezierPathWithOvalInRect:rect];
+  }
+}
+
+
+- (instancetype)initWithKind:(PTDShapeRasterKind)kind rect:(NSRect)rect cornerRadius:(CGFloat)radius lineWidth:(CGFloat)width color:(NSColor *)color filled:(BOOL)filled
+{
+  NSBezierPath *path = [PTDPrimitiveShapeCanvasObject pathWithKind:kind rect:rect cornerRadius:radius];
+  path.lineWidth = width;
+  self = [super initWithPath:path color:color filled:filled];
+  _kind = kind;
+  _rect = rect;
+  _cornerRadius = radius;
+  return self;
+}
+
+
+- (PTDShapeCanvasObject *)objectByChangingLineWidth:(CGFloat)width color:(NSColor *)color
+{
+  return [[PTDPrimitiveShapeCanvasObject alloc] initWithKind:_kind rect:_rect cornerRadius:_cornerRadius lineWidth:width color:color filled:self.filled];
+}
+
+
+- (void)drawInCanvas:(NSBitmapImageRep *)canvas backingScaleFactor:(NSSize)scale
+{
+  void (^drawer)(const PTDPixelBuffer *) = [self canvasPixelDrawerWithColorSpace:canvas.colorSpace backingScaleFactor:scale];
+  if (!drawer) {
+    [super drawInCanvas:canvas backingScaleFactor:scale];
+    return;
+  }
+  PTDPixelBuffer buffer = canvas.ptd_pixelBuffer;
+  drawer(&buffer);
+}
+
+
+- (nullable void (^)(const PTDPixelBuffer *canvas))canvasPixelDrawerWithColorSpace:(NSColorSpace *)colorSpace backingScaleFactor:(NSSize)scale
+{
+  NSColor *color = [self.color colorUsingColorSpace:colorSpace];
+  if (!color)
+    return nil;
+  CGFloat alpha = color.alphaComponent;
+  uint8_t red = (uint8_t)round(color.redComponent * alpha * 255.0);
+  uint8_t green = (uint8_t)round(color.greenComponent * alpha * 255.0);
+  uint8_t blue = (uint8_t)round(color.blueComponent * alpha * 255.0);
+  uint8_t opacity = (uint8_t)round(alpha * 255.0);
+  
+  /* the canvas pixels have the first row on top */
+  CGFloat lineScale = MIN(scale.width, scale.height);
+  PTDShapeRasterShape shape = {
+    .kind = _kind,
+    .centerX = (float)(NSMidX(_rect) * scale.width),
+    .halfWidth = (float)(NSWidth(_rect) / 2.0 * scale.width),
+    .halfHeight = (float)(NSHeight(_rect) / 2.0 * scale.height),
+    .cornerRadius = (float)(_cornerRadius * lineScale),
+    .lineWidth = (float)(self.path.lineWidth * lineScale),
+    .filled = self.filled
+  };
+  CGFloat centerY = NSMidY(_rect) * scale.height;
+  return ^(const PTDPixelBuffer *canvas) {
+    PTDShapeRasterShape flipped = shape;
+    flipped.centerY = (float)((CGFloat)canvas->height - centerY);
+    uint8_t pixel[4] = {red, green, blue, opacity};
+    PTDShapeRasterDraw(canvas, &flipped, pixel);
+  };
+}
+
+
+@end
@@ -0,0 +1,419 @@
+//
+// PTDCanvasObjectGrid.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "PTDCanvasObjectGrid.h"
+
+
+typedef struct {
+  uint64_t key;
+  int used;
+  /* sorted by order */
+  PTDCanvasObjectGridEntry *entries;
+  size_t count;
+  size_t capacity;
+} PTDCanvasObjectGridCell;
+
+struct PTDCanvasObjectGrid {
+  double cellSize;
+  size_t objectCount;
+  /* open addressing hash table of the cells; a cell which becomes empty
+   * stays in the table, there are only as many as the canvas has room for */
+  PTDCanvasObjectGridCell *cells;
+  size_t tableSize;
+  size_t cellCount;
+};
+
+
+void PTDCanvasObjectGridListFree(PTDCanvasObjectGridList *list)
+{
+  free(list->entries);
+  list->entries = NULL;
+  list->count = 0;
+  list->capacity = 0;
+}
+
+
+static int PTDCanvasObjectGridListAppend(PTDCanvasObjectGridList *list, const PTDCanvasObjectGridEntry *entry)
+{
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 16;
+    PTDCanvasObjectGridEntry *entries = realloc(list->entries, capacity * sizeof(PTDCanvasObjectGridEntry));
+    if (!entries)
+      return 0;
+    list->entries = entries;
+    list->capacity = capacity;
+  }
+  list->entries[list->count++] = *entry;
+  return 1;
+}
+
+
+PTDCanvasObjectGrid *PTDCanvasObjectGridCreate(double cellSize)
+{
+  if (!(cellSize > 0))
+    return NULL;
+  PTDCanvasObjectGrid *grid = calloc(1, sizeof(PTDCanvasObjectGrid));
+  if (!grid)
+    return NULL;
+  grid->cellSize = cellSize;
+  return grid;
+}
+
+
+void PTDCanvasObjectGridDestroy(PTDCanvasObjectGrid *grid)
+{
+  if (!grid)
+    return;
+  PTDCanvasObjectGridRemoveAll(grid);
+  free(grid->cells);
+  free(grid);
+}
+
+
+#pragma mark - Cells
+
+
+uint64_t PTDCanvasObjectGridCellKey(long cx, long cy)
+{
+  return ((uint64_t)(uint32_t)cy << 32) | (uint32_t)cx;
+}
+
+
+PTDCanvasObjectGridRect PTDCanvasObjectGridCellRect(const PTDCanvasObjectGrid *grid, uint64_t key)
+{
+  long cx = (int32_t)(uint32_t)key;
+  long cy = (int32_t)(uint32_t)(key >> 32);
+  double size = grid->cellSize;
+  return (PTDCanvasObjectGridRect){cx * size, cy * size, size, size};
+}
+
+
+static int PTDCanvasObjectGridRectIsEmpty(PTDCanvasObjectGridRect rect)
+{
+  return !(rect.width > 0 && rect.height > 0);
+}
+
+
+static int PTDCanvasObjectGridRectsIntersect(PTDCanvasObjectGridRect a, PTDCanvasObjectGridRect b)
+{
+  if (PTDCanvasObjectGridRectIsEmpty(a) || PTDCanvasObjectGridRectIsEmpty(b))
+    return 0;
+  return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+
+int PTDCanvasObjectGridCellRange(const PTDCanvasObjectGrid *grid, PTDCanvasObjectGridRect rect, long *cx0, long *cy0, long *cx1, long *cy1)
+{
+  if (PTDCanvasObjectGridRectIsEmpty(rect))
+    return 0;
+  double size = grid->cellSize;
+  *cx0 = (long)floor(rect.x / size);
+  *cy0 = (long)floor(rect.y / size);
+  *cx1 = (long)floor((rect.x + rect.width) / size);
+  *cy1 = (long)floor((rect.y + rect.height) / size);
+  return 1;
+}
+
+
+static size_t PTDCanvasObjectGridHash(uint64_t key, size_t tableSize)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (size_t)key & (tableSize - 1);
+}
+
+
+static PTDCanvasObjectGridCell *PTDCanvasObjectGridFindCell(const PTDCanvasObjectGrid *grid, uint64_t key)
+{
+  if (!grid->cells)
+    return NULL;
+  for (size_t i = PTDCanvasObjectGridHash(key, grid->tableSize); grid->cells[i].used; i = (i + 1) & (grid->tableSize - 1)) {
+    if (grid->cells[i].key == key)
+      return &grid->cells[i];
+  }
+  return NULL;
+}
+
+
+static int PTDCanvasObjectGridGrowTable(PTDCanvasObjectGrid *grid)
+{
+  size_t tableSize = grid->tableSize ? grid->tableSize * 2 : 64;
+  PTDCanvasObjectGridCell *cells = calloc(tableSize, sizeof(PTDCanvasObjectGridCell));
+  if (!cells)
+    return 0;
+  for (size_t i = 0; i < grid->tableSize; i++) {
+    if (!grid->cells[i].used)
+      continue;
+    size_t j = PTDCanvasObjectGridHash(grid->cells[i].key, tableSize);
+    while (cells[j].used)
+      j = (j + 1) & (tableSize - 1);
+    cells[j] = grid->cells[i];
+  }
+  free(grid->cells);
+  grid->cells = cells;
+  grid->tableSize = tableSize;
+  return 1;
+}
+
+
+/* Finds or adds the cell, with room for one more entry */
+static PTDCanvasObjectGridCell *PTDCanvasObjectGridReserveCell(PTDCanvasObjectGrid *grid, uint64_t key)
+{
+  PTDCanvasObjectGridCell *cell = PTDCanvasObjectGridFindCell(grid, key);
+  if (!cell) {
+    /* keeps the table at most half full */
+    if ((grid->cellCount + 1) * 2 > grid->tableSize && !PTDCanvasObjectGridGrowTable(grid))
+      return NULL;
+    size_t i = PTDCanvasObjectGridHash(key, grid->tableSize);
+    while (grid->cells[i].used)
+      i = (i + 1) & (grid->tableSize - 1);
+    cell = &grid->cells[i];
+    cell->key = key;
+    cell->used = 1;
+    grid->cellCount++;
+  }
+  if (cell->count == cell->capacity) {
+    size_t capacity = cell->capacity ? cell->capacity * 2 : 8;
+    PTDCanvasObjectGridEntry *entries = realloc(cell->entries, capacity * sizeof(PTDCanvasObjectGridEntry));
+    if (!entries)
+      return NULL;
+    cell->entries = entries;
+    cell->capacity = capacity;
+  }
+  return cell;
+}
+
+
+/* Index of the first entry of the cell whose order is not less than the
+ * given one */
+static size_t PTDCanvasObjectGridCellLowerBound(const PTDCanvasObjectGridCell *cell, uint64_t order)
+{
+  size_t lo = 0, hi = cell->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (cell->entries[mid].order < order)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+
+#pragma mark - Objects
+
+
+int PTDCanvasObjectGridInsert(PTDCanvasObjectGrid *grid, uint64_t order, PTDCanvasObjectGridRect bounds)
+{
+  long cx0, cy0, cx1, cy1;
+  if (!PTDCanvasObjectGridCellRange(grid, bounds, &cx0, &cy0, &cx1, &cy1)) {
+    grid->objectCount++;
+    return 1;
+  }
+  
+  /* all the memory is allocated first, so that a failure leaves nothing
+   * half done; the cells added in the meantime are just empty */
+  for (long cy = cy0; cy <= cy1; cy++) {
+    for (long cx = cx0; cx <= cx1; cx++) {
+      if (!PTDCanvasObjectGridReserveCell(grid, PTDCanvasObjectGridCellKey(cx, cy)))
+        return 0;
+    }
+  }
+  
+  PTDCanvasObjectGridEntry entry = {order, bounds};
+  for (long cy = cy0; cy <= cy1; cy++) {
+    for (long cx = cx0; cx <= cx1; cx++) {
+      PTDCanvasObjectGridCell *cell = PTDCanvasObjectGridFindCell(grid, PTDCanvasObjectGridCellKey(cx, cy));
+      /* objects are mostly added on top */
+      size_t i = cell->count > 0 && cell->entries[cell->count - 1].order < order ? cell->count : PTDCanvasObjectGridCellLowerBound(cell, order);
+      memmove(&cell->entries[i + 1], &cell->entries[i], (cell->count - i) * sizeof(PTDCanvasObjectGridEntry));
+      cell->entries[i] = entry;
+      cell->count++;
+    }
+  }
+  grid->objectCount++;
+  return 1;
+}
+
+
+void PTDCanvasObjectGridRemove(PTDCanvasObjectGrid *grid, uint64_t order, PTDCanvasObjectGridRect bounds)
+{
+  if (grid->objectCount > 0)
+    grid->objectCount--;
+  long cx0, cy0, cx1, cy1;
+  if (!PTDCanvasObjectGridCellRange(grid, bounds, &cx0, &cy0, &cx1, &cy1))
+    return;
+  for (long cy = cy0; cy <= cy1; cy++) {
+    for (long cx = cx0; cx <= cx1; cx++) {
+      PTDCanvasObjectGridCell *cell = PTDCanvasObjectGridFindCell(grid, PTDCanvasObjectGridCellKey(cx, cy));
+      if (!cell)
+        continue;
+      size_t i = PTDCanvasObjectGridCellLowerBound(cell, order);
+      if (i == cell->count || cell->entries[i].order != order)
+        continue;
+      memmove(&cell->entries[i], &cell->entries[i + 1], (cell->count - i - 1) * sizeof(PTDCanvasObjectGridEntry));
+      cell->count--;
+    }
+  }
+}
+
+
+void PTDCanvasObjectGridRemoveAll(PTDCanvasObjectGrid *grid)
+{
+  for (size_t i = 0; i < grid->tableSize; i++)
+    free(grid->cells[i].entries);
+  if (grid->cells)
+    memset(grid->cells, 0, grid->tableSize * sizeof(PTDCanvasObjectGridCell));
+  grid->cellCount = 0;
+  grid->objectCount = 0;
+}
+
+
+size_t PTDCanvasObjectGridCount(const PTDCanvasObjectGrid *grid)
+{
+  return grid->objectCount;
+}
+
+
+#pragma mark - Queries
+
+
+static int PTDCanvasObjectGridCompareEntries(const void *a, const void *b)
+{
+  uint64_t orderA = ((const PTDCanvasObjectGridEntry *)a)->order;
+  uint64_t orderB = ((const PTDCanvasObjectGridEntry *)b)->order;
+  return orderA < orderB ? -1 : orderA > orderB;
+}
+
+
+int PTDCanvasObjectGridObjectsInCell(const PTDCanvasObjectGrid *grid, uint64_t key, PTDCanvasObjectGridList *list)
+{
+  list->count = 0;
+  PTDCanvasObjectGridCell *cell = PTDCanvasObjectGridFindCell(grid, key);
+  if (!cell)
+    return 1;
+  for (size_t i = 0; i < cell->count; i++) {
+    if (!PTDCanvasObjectGridListAppend(list, &cell->entries[i]))
+      return 0;
+  }
+  return 1;
+}
+
+
+int PTDCanvasObjectGridObjectsInRect(const PTDCanvasObjectGrid *grid, PTDCanvasObjectGridRect rect, PTDCanvasObjectGridList *list)
+{
+  list->count = 0;
+  long cx0, cy0, cx1, cy1;
+  if (!PTDCanvasObjectGridCellRange(grid, rect, &cx0, &cy0, &cx1, &cy1))
+    return 1;
+  for (long cy = cy0; cy <= cy1; cy++) {
+    for (long cx = cx0; cx <= cx1; cx++) {
+      PTDCanvasObjectGridCell *cell = PTDCanvasObjectGridFindCell(grid, PTDCanvasObjectGridCellKey(cx, cy));
+      if (!cell)
+        continue;
+      for (size_t i = 0; i < cell->count; i++) {
+        if (PTDCanvasObjectGridRectsIntersect(cell->entries[i].bounds, rect) && !PTDCanvasObjectGridListAppend(list, &cell->entries[i]))
+          return 0;
+      }
+    }
+  }
+  
+  /* objects covering more than one of the cells were found more than once */
+  if (cx0 == cx1 && cy0 == cy1)
+    return 1;
+  qsort(list->entries, list->count, sizeof(PTDCanvasObjectGridEntry), PTDCanvasObjectGridCompareEntries);
+  size_t unique = 0;
+  for (size_t i = 0; i < list->count; i++) {
+    if (unique == 0 || list->entries[unique - 1].order != list->entries[i].order)
+      list->entries[unique++] = list->entries[i];
+  }
+  list->count = unique;
+  return 1;
+}
+
+
+int PTDCanvasObjectGridObjectsInRectAndBelow(const PTDCanvasObjectGrid *grid, PTDCanvasObjectGridRect rect, PTDCanvasObjectGridList *list)
+{
+  if (!PTDCanvasObjectGridObjectsInRect(grid, rect, list))
+    return 0;
+  if (list->count == 0)
+    return 1;
+  
+  /* the orders found so far, sorted, to skip the objects found again */
+  size_t foundCapacity = list->count * 2;
+  uint64_t *found = malloc(foundCapacity * sizeof(uint64_t));
+  if (!found)
+    return 0;
+  size_t foundCount = list->count;
+  for (size_t i = 0; i < list->count; i++)
+    found[i] = list->entries[i].order;
+  
+  int success = 1;
+  PTDCanvasObjectGridList below = {0};
+  for (size_t i = 0; i < list->count && success; i++) {
+    PTDCanvasObjectGridEntry entry = list->entries[i];
+    if (!PTDCanvasObjectGridObjectsInRect(grid, entry.bounds, &below))
+      success = 0;
+    for (size_t j = 0; j < below.count && below.entries[j].order < entry.order; j++) {
+      uint64_t order = below.entries[j].order;
+      size_t lo = 0, hi = foundCount;
+      while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (found[mid] < order)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      if (lo < foundCount && found[lo] == order)
+        continue;
+      if (foundCount == foundCapacity) {
+        uint64_t *grown = realloc(found, foundCapacity * 2 * sizeof(uint64_t));
+        if (!grown) {
+          success = 0;
+          break;
+        }
+        found = grown;
+        foundCapacity *= 2;
+      }
+      if (!PTDCanvasObjectGridListAppend(list, &below.entries[j])) {
+        success = 0;
+        break;
+      }
+      memmove(&found[lo + 1], &found[lo], (foundCount - lo) * sizeof(uint64_t));
+      found[lo] = order;
+      foundCount++;
+    }
+  }
+  PTDCanvasObjectGridListFree(&below);
+  free(found);
+  if (!success)
+    return 0;
+  qsort(list->entries, list->count, sizeof(PTDCanvasObjectGridEntry), PTDCanvasObjectGridCompareEntries);
+  return 1;
+}
@@ -0,0 +1,97 @@
+//
+// PTDCanvasObjectGrid.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDCanvasObjectGrid_h
+#define PTDCanvasObjectGrid_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* In the coordinates of the objects, with the origin at the bottom left */
+typedef struct {
+  double x, y, width, height;
+} PTDCanvasObjectGridRect;
+
+/* Objects are identified by their stacking order, which must be unique;
+ * larger is higher. */
+typedef struct {
+  uint64_t order;
+  PTDCanvasObjectGridRect bounds;
+} PTDCanvasObjectGridEntry;
+
+/* Results of the queries, sorted from the bottom object to the top one.
+ * Each query replaces the previous contents and reuses the memory; a
+ * zero-initialized list is empty. */
+typedef struct {
+  PTDCanvasObjectGridEntry *entries;
+  size_t count;
+  size_t capacity;
+} PTDCanvasObjectGridList;
+
+void PTDCanvasObjectGridListFree(PTDCanvasObjectGridList *list);
+
+/* Index of the bounds of the canvas objects in a grid of square cells, so
+ * that the queries only look at the objects in the cells they touch. An
+ * object is listed in every cell its bounds cover. */
+typedef struct PTDCanvasObjectGrid PTDCanvasObjectGrid;
+
+PTDCanvasObjectGrid *PTDCanvasObjectGridCreate(double cellSize);
+void PTDCanvasObjectGridDestroy(PTDCanvasObjectGrid *grid);
+
+/* Cells are identified by a key made of their column and row, which can be
+ * negative. */
+uint64_t PTDCanvasObjectGridCellKey(long cx, long cy);
+PTDCanvasObjectGridRect PTDCanvasObjectGridCellRect(const PTDCanvasObjectGrid *grid, uint64_t key);
+/* Sets the first and last column and row of the cells covered by the rect.
+ * Returns 0 if the rect is empty and covers no cell. */
+int PTDCanvasObjectGridCellRange(const PTDCanvasObjectGrid *grid, PTDCanvasObjectGridRect rect, long *cx0, long *cy0, long *cx1, long *cy1);
+
+/* Returns 0, and leaves the grid unchanged, if memory cannot be allocated.
+ * Objects with empty bounds are not in any cell, and are never found. */
+int PTDCanvasObjectGridInsert(PTDCanvasObjectGrid *grid, uint64_t order, PTDCanvasObjectGridRect bounds);
+/* The bounds must be the ones the object was inserted with. */
+void PTDCanvasObjectGridRemove(PTDCanvasObjectGrid *grid, uint64_t order, PTDCanvasObjectGridRect bounds);
+void PTDCanvasObjectGridRemoveAll(PTDCanvasObjectGrid *grid);
+size_t PTDCanvasObjectGridCount(const PTDCanvasObjectGrid *grid);
+
+/* The queries return 0 if memory cannot be allocated. */
+/* Every object listed in the cell, for hit testing */
+int PTDCanvasObjectGridObjectsInCell(const PTDCanvasObjectGrid *grid, uint64_t key, PTDCanvasObjectGridList *list);
+/* The objects whose bounds intersect the rect */
+int PTDCanvasObjectGridObjectsInRect(const PTDCanvasObjectGrid *grid, PTDCanvasObjectGridRect rect, PTDCanvasObjectGridList *list);
+/* The objects whose bounds intersect the rect, plus the objects below them
+ * which they overlap, and so on. Drawing these into the canvas under the
+ * remaining objects keeps the stacking order of everything visible. */
+int PTDCanvasObjectGridObjectsInRectAndBelow(const PTDCanvasObjectGrid *grid, PTDCanvasObjectGridRect rect, PTDCanvasObjectGridList *list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDCanvasObjectGrid_h */
@@ -0,0 +1,68 @@
+//
+// PTDCanvasObjectList.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class PTDCanvasObject;
+
+/* The canvas objects of a paint view, indexed by a grid of square cells
+ * (see PTDCanvasObjectGrid) so that hit testing and redrawing only look at
+ * the objects near the point or rect of interest. The objects are rendered
+ * in tiles, one per cell, inside the given layer; each change re-renders
+ * only the tiles covered by the objects involved. */
+@interface PTDCanvasObjectList : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithLayer:(CALayer *)layer NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic) NSSize backingScaleFactor;
+
+/* From the bottom one to the top one */
+@property (nonatomic, readonly) NSArray<PTDCanvasObject *> *objects;
+@property (nonatomic, readonly) NSUInteger count;
+/* Incremented by every change to the objects */
+@property (nonatomic, readonly) NSUInteger changeCount;
+
+- (void)addObject:(PTDCanvasObject *)object;
+- (void)removeObject:(PTDCanvasObject *)object;
+/* The new object takes the place of the old one in the stacking order */
+- (void)replaceObject:(PTDCanvasObject *)object withObject:(PTDCanvasObject *)newObject;
+- (void)removeObjects:(NSArray<PTDCanvasObject *> *)objects;
+- (void)removeAllObjects;
+
+/* The topmost object containing the point */
+- (nullable PTDCanvasObject *)objectAtPoint:(NSPoint)point;
+/* Objects whose bounds intersect the rect, from the bottom one to the top one */
+- (NSArray<PTDCanvasObject *> *)objectsInRect:(NSRect)rect;
+/* The objects in the rect and, recursively, the objects below them which
+ * they overlap, from the bottom one to the top one. Flattening these into
+ * the canvas leaves the stacking order of what is visible unchanged. */
+- (NSArray<PTDCanvasObject *> *)objectsToFlattenInRect:(NSRect)rect;
+
+@end
+
+NS_ASSUME_NONNULL_END
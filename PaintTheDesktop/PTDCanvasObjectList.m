@@ -0,0 +1,289 @@
+//
+// PTDCanvasObjectList.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <QuartzCore/QuartzCore.h>
+#import "PTDCanvasObjectList.h"
+#import "PTDCanvasObject.h"
+#import "PTDNoAnimeCALayer.h"
+#import "PTDBufferPoolImage.h"
+#import "PTDCanvasObjectGrid.h"
+
+
+/* Side of the grid cells and of the tiles, in points */
+static const CGFloat _CellSize = 256.0;
+
+
+@implementation PTDCanvasObjectList {
+  CALayer *_layer;
+  /* stacking order of each object; larger is higher */
+  NSMapTable<PTDCanvasObject *, NSNumber *> *_order;
+  NSMutableDictionary<NSNumber *, PTDCanvasObject *> *_objectsByOrder;
+  uint64_t _nextOrder;
+  PTDCanvasObjectGrid *_grid;
+  /* results of the last query to the grid, reused by the next one */
+  PTDCanvasObjectGridList _found;
+  NSMutableDictionary<NSNumber *, CALayer *> *_tiles;
+}
+
+
+- (instancetype)initWithLayer:(CALayer *)layer
+{
+  self = [super init];
+  _layer = layer;
+  _backingScaleFactor = NSMakeSize(1.0, 1.0);
+  _order = [NSMapTable strongToStrongObjectsMapTable];
+  _objectsByOrder = [NSMutableDictionary dictionary];
+  _grid = PTDCanvasObjectGridCreate(_CellSize);
+  _tiles = [NSMutableDictionary dictionary];
+  return self;
+}
+
+
+- (void)dealloc
+{
+  PTDCanvasObjectGridListFree(&_found);
+  PTDCanvasObjectGridDestroy(_grid);
+}
+
+
+#pragma mark - Grid
+
+
+static PTDCanvasObjectGridRect PTDCanvasObjectListGridRect(NSRect rect)
+{
+  return (PTDCanvasObjectGridRect){NSMinX(rect), NSMinY(rect), NSWidth(rect), NSHeight(rect)};
+}
+
+
+- (void)enumerateCellKeysInRect:(NSRect)rect usingBlock:(NS_NOESCAPE void (^)(uint64_t key))block
+{
+  long cx0, cy0, cx1, cy1;
+  if (!PTDCanvasObjectGridCellRange(_grid, PTDCanvasObjectListGridRect(rect), &cx0, &cy0, &cx1, &cy1))
+    return;
+  for (long cy = cy0; cy <= cy1; cy++) {
+    for (long cx = cx0; cx <= cx1; cx++) {
+      block(PTDCanvasObjectGridCellKey(cx, cy));
+    }
+  }
+}
+
+
+- (void)indexObject:(PTDCanvasObject *)object order:(uint64_t)order
+{
+  if (!PTDCanvasObjectGridInsert(_grid, order, PTDCanvasObjectListGridRect(object.bounds)))
+    NSLog(@"warning: could not index a canvas object");
+  [_order setObject:@(order) forKey:object];
+  _objectsByOrder[@(order)] = object;
+}
+
+
+- (void)unindexObject:(PTDCanvasObject *)object order:(uint64_t)order
+{
+  PTDCanvasObjectGridRemove(_grid, order, PTDCanvasObjectListGridRect(object.bounds));
+  [_order removeObjectForKey:object];
+  [_objectsByOrder removeObjectForKey:@(order)];
+}
+
+
+/* The objects of the last query, in stacking order */
+- (NSArray<PTDCanvasObject *> *)objectsFoundByQuery:(int)success
+{
+  if (!success) {
+    NSLog(@"warning: could not look up the canvas objects");
+    return @[];
+  }
+  NSMutableArray *res = [NSMutableArray arrayWithCapacity:_found.count];
+  for (size_t i = 0; i < _found.count; i++)
+    [res addObject:_objectsByOrder[@(_found.entries[i].order)]];
+  return res;
+}
+
+
+#pragma mark - Objects
+
+
+- (NSArray<PTDCanvasObject *> *)objects
+{
+  NSArray *orders = [_objectsByOrder.allKeys sortedArrayUsingSelector:@selector(compare:)];
+  return [_objectsByOrder objectsForKeys:orders notFoundMarker:NSNull.null];
+}
+
+
+- (NSUInteger)count
+{
+  return _order.count;
+}
+
+
+- (void)addObject:(PTDCanvasObject *)object
+{
+  [self indexObject:object order:_nextOrder++];
+  _changeCount++;
+  [self renderTilesInRect:object.bounds];
+}
+
+
+- (void)removeObject:(PTDCanvasObject *)object
+{
+  NSNumber *order = [_order objectForKey:object];
+  if (!order)
+    return;
+  [self unindexObject:object order:order.unsignedLongLongValue];
+  _changeCount++;
+  [self renderTilesInRect:object.bounds];
+}
+
+
+- (void)replaceObject:(PTDCanvasObject *)object withObject:(PTDCanvasObject *)newObject
+{
+  NSNumber *order = [_order objectForKey:object];
+  if (!order) {
+    [self addObject:newObject];
+    return;
+  }
+  [self unindexObject:object order:order.unsignedLongLongValue];
+  [self indexObject:newObject order:order.unsignedLongLongValue];
+  _changeCount++;
+  [self renderTilesInRect:NSUnionRect(object.bounds, newObject.bounds)];
+}
+
+
+- (void)removeAllObjects
+{
+  if (_order.count > 0)
+    _changeCount++;
+  [_order removeAllObjects];
+  [_objectsByOrder removeAllObjects];
+  PTDCanvasObjectGridRemoveAll(_grid);
+  for (CALayer *tile in _tiles.allValues)
+    [tile removeFromSuperlayer];
+  [_tiles removeAllObjects];
+}
+
+
+- (void)removeObjects:(NSArray<PTDCanvasObject *> *)objects
+{
+  NSRect dirtyRect = NSZeroRect;
+  for (PTDCanvasObject *object in objects) {
+    NSNumber *order = [_order objectForKey:object];
+    if (!order)
+      continue;
+    [self unindexObject:object order:order.unsignedLongLongValue];
+    dirtyRect = NSUnionRect(dirtyRect, object.bounds);
+    _changeCount++;
+  }
+  [self renderTilesInRect:dirtyRect];
+}
+
+
+- (nullable PTDCanvasObject *)objectAtPoint:(NSPoint)point
+{
+  uint64_t key = PTDCanvasObjectGridCellKey((long)floor(point.x / _CellSize), (long)floor(point.y / _CellSize));
+  NSArray *objects = [self objectsFoundByQuery:PTDCanvasObjectGridObjectsInCell(_grid, key, &_found)];
+  for (PTDCanvasObject *object in objects.reverseObjectEnumerator) {
+    if ([object containsPoint:point])
+      return object;
+  }
+  return nil;
+}
+
+
+- (NSArray<PTDCanvasObject *> *)objectsInRect:(NSRect)rect
+{
+  return [self objectsFoundByQuery:PTDCanvasObjectGridObjectsInRect(_grid, PTDCanvasObjectListGridRect(rect), &_found)];
+}
+
+
+- (NSArray<PTDCanvasObject *> *)objectsToFlattenInRect:(NSRect)rect
+{
+  return [self objectsFoundByQuery:PTDCanvasObjectGridObjectsInRectAndBelow(_grid, PTDCanvasObjectListGridRect(rect), &_found)];
+}
+
+
+#pragma mark - Rendering
+
+
+- (void)setBackingScaleFactor:(NSSize)backingScaleFactor
+{
+  if (NSEqualSizes(backingScaleFactor, _backingScaleFactor))
+    return;
+  _backingScaleFactor = backingScaleFactor;
+  for (NSNumber *key in _tiles.allKeys)
+    [self renderTileWithKey:key.unsignedLongLongValue];
+}
+
+
+- (void)renderTilesInRect:(NSRect)rect
+{
+  [self enumerateCellKeysInRect:rect usingBlock:^(uint64_t key) {
+    [self renderTileWithKey:key];
+  }];
+}
+
+
+- (void)renderTileWithKey:(uint64_t)key
+{
+  PTDCanvasObjectGridRect cell = PTDCanvasObjectGridCellRect(_grid, key);
+  NSRect tileRect = NSMakeRect(cell.x, cell.y, cell.width, cell.height);
+  NSArray *objects = [self objectsInRect:tileRect];
+  CALayer *tile = _tiles[@(key)];
+  if (objects.count == 0) {
+    [tile removeFromSuperlayer];
+    [_tiles removeObjectForKey:@(key)];
+    return;
+  }
+  
+  size_t width = (size_t)ceil(_CellSize * _backingScaleFactor.width);
+  size_t height = (size_t)ceil(_CellSize * _backingScaleFactor.height);
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+  CGImageRef image = PTDBufferPoolCreateImage(width, height, colorSpace, kCGImageAlphaPremultipliedLast, ^(CGContextRef ctxt) {
+    CGContextClearRect(ctxt, CGRectMake(0, 0, width, height));
+    CGContextScaleCTM(ctxt, self->_backingScaleFactor.width, self->_backingScaleFactor.height);
+    CGContextTranslateCTM(ctxt, -tileRect.origin.x, -tileRect.origin.y);
+    
+    [NSGraphicsContext saveGraphicsState];
+    NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithCGContext:ctxt flipped:NO];
+    for (PTDCanvasObject *object in objects)
+      [object draw];
+    [NSGraphicsContext restoreGraphicsState];
+  });
+  CGColorSpaceRelease(colorSpace);
+  if (!image) {
+    NSLog(@"warning: could not allocate a canvas object tile");
+    return;
+  }
+  
+  if (!tile) {
+    tile = [[PTDNoAnimeCALayer alloc] init];
+    tile.frame = tileRect;
+    [_layer addSublayer:tile];
+    _tiles[@(key)] = tile;
+  }
+  tile.contents = (__bridge id)image;
+  CGImageRelease(image);
+}
+
+
+@end
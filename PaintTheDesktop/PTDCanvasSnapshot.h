@@ -0,0 +1,58 @@
+//
+// PTDCanvasSnapshot.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+#import "PTDCanvasStore.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* An immutable frame of a canvas store, which can be read on any thread
+ * for as long as the object is alive. */
+@interface PTDCanvasSnapshot : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+/* Takes over the reference to the frame. */
+- (instancetype)initWithCanvasFrame:(PTDCanvasFrame *)frame size:(NSSize)size colorSpace:(nullable NSColorSpace *)colorSpace NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) PTDCanvasFrame *canvasFrame;
+@property (nonatomic, readonly) uint64_t generation;
+@property (nonatomic, readonly) NSInteger pixelWidth;
+@property (nonatomic, readonly) NSInteger pixelHeight;
+/* In points */
+@property (nonatomic, readonly) NSSize size;
+@property (nonatomic, readonly, nullable) NSColorSpace *colorSpace;
+
+/* The tiles of the frame which are not fully transparent, in pixels with
+ * the origin at the top left corner, or NSZeroRect if there are none. */
+@property (nonatomic, readonly) NSRect contentPixelRect;
+
+/* Return nil if the pixels can not be allocated. The rect is in pixels,
+ * with the origin at the top left corner, and must fit in the frame. */
+- (nullable NSBitmapImageRep *)bitmapImageRep;
+- (nullable NSBitmapImageRep *)bitmapImageRepOfPixelRect:(NSRect)rect;
+
+@end
+
+NS_ASSUME_NONNULL_END
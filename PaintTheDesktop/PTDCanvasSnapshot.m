@@ -0,0 +1,94 @@
+//
+// PTDCanvasSnapshot.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDCanvasSnapshot.h"
+#import "NSBitmapImageRep+PTD.h"
+
+
+@implementation PTDCanvasSnapshot
+
+
+- (instancetype)initWithCanvasFrame:(PTDCanvasFrame *)frame size:(NSSize)size colorSpace:(NSColorSpace *)colorSpace
+{
+  self = [super init];
+  _canvasFrame = frame;
+  _size = size;
+  _colorSpace = colorSpace;
+  return self;
+}
+
+
+- (void)dealloc
+{
+  PTDCanvasFrameRelease(_canvasFrame);
+}
+
+
+- (uint64_t)generation
+{
+  return PTDCanvasFrameGeneration(_canvasFrame);
+}
+
+
+- (NSInteger)pixelWidth
+{
+  return (NSInteger)PTDCanvasFrameWidth(_canvasFrame);
+}
+
+
+- (NSInteger)pixelHeight
+{
+  return (NSInteger)PTDCanvasFrameHeight(_canvasFrame);
+}
+
+
+- (NSRect)contentPixelRect
+{
+  size_t x0, y0, x1, y1;
+  if (!PTDCanvasFrameContentBounds(_canvasFrame, &x0, &y0, &x1, &y1))
+    return NSZeroRect;
+  return NSMakeRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+
+- (NSBitmapImageRep *)bitmapImageRep
+{
+  return [self bitmapImageRepOfPixelRect:NSMakeRect(0, 0, self.pixelWidth, self.pixelHeight)];
+}
+
+
+- (NSBitmapImageRep *)bitmapImageRepOfPixelRect:(NSRect)rect
+{
+  PTDCanvasFrame *frame = _canvasFrame;
+  size_t x = (size_t)NSMinX(rect), y = (size_t)NSMinY(rect);
+  NSBitmapImageRep *rep = [NSBitmapImageRep ptd_pooledImageRepWithPixelsWide:(NSInteger)NSWidth(rect) pixelsHigh:(NSInteger)NSHeight(rect) colorSpace:_colorSpace fillingPixelsUsingBlock:^(const PTDPixelBuffer *pixels) {
+    PTDCanvasFrameCopyPixels(frame, x, y, pixels);
+  }];
+  rep.size = NSMakeSize(NSWidth(rect) * _size.width / self.pixelWidth, NSHeight(rect) * _size.height / self.pixelHeight);
+  return rep;
+}
+
+
+@end
@@ -0,0 +1,386 @@
+//
+// PTDCanvasStore.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "PTDCanvasStore.h"
+
+
+#define TILE_SIZE 64
+#define READER_SLOTS 32
+
+
+typedef struct {
+  _Atomic size_t refs;
+  uint8_t pixels[TILE_SIZE * TILE_SIZE * 4];
+} PTDCanvasTile;
+
+struct PTDCanvasFrame {
+  _Atomic size_t refs;
+  uint64_t generation;
+  size_t width;
+  size_t height;
+  size_t columns;
+  size_t rows;
+  /* in tiles; empty when every tile is NULL */
+  size_t contentX0, contentY0, contentX1, contentY1;
+  /* only used by the writer, while the frame waits to be reclaimed */
+  PTDCanvasFrame *nextRetired;
+  uint64_t retiredEpoch;
+  /* NULL tiles are fully transparent */
+  PTDCanvasTile *tiles[];
+};
+
+struct PTDCanvasStore {
+  _Atomic size_t refs;
+  size_t width;
+  size_t height;
+  size_t columns;
+  size_t rows;
+  
+  _Atomic(PTDCanvasFrame *) current;
+  /* starts at one; zero in a reader slot means that the slot is free */
+  _Atomic uint64_t epoch;
+  _Atomic uint64_t readerEpochs[READER_SLOTS];
+  
+  /* writer only */
+  PTDCanvasFrame *retired;
+};
+
+
+static void PTDCanvasTileRelease(PTDCanvasTile *tile)
+{
+  if (tile && atomic_fetch_sub_explicit(&tile->refs, 1, memory_order_acq_rel) == 1)
+    free(tile);
+}
+
+
+static int PTDCanvasTileIsTransparent(const PTDCanvasTile *tile)
+{
+  uint64_t acc = 0;
+  for (size_t i = 0; i < sizeof(tile->pixels); i += 8) {
+    uint64_t v;
+    memcpy(&v, tile->pixels + i, 8);
+    acc |= v;
+  }
+  return acc == 0;
+}
+
+
+static PTDCanvasFrame *PTDCanvasFrameCreate(const PTDCanvasStore *store, uint64_t generation)
+{
+  size_t count = store->columns * store->rows;
+  PTDCanvasFrame *frame = calloc(1, sizeof(PTDCanvasFrame) + count * sizeof(PTDCanvasTile *));
+  if (!frame)
+    return NULL;
+  atomic_init(&frame->refs, 1);
+  frame->generation = generation;
+  frame->width = store->width;
+  frame->height = store->height;
+  frame->columns = store->columns;
+  frame->rows = store->rows;
+  return frame;
+}
+
+
+static void PTDCanvasFrameUpdateContentBounds(PTDCanvasFrame *frame)
+{
+  frame->contentX0 = frame->columns;
+  frame->contentY0 = frame->rows;
+  frame->contentX1 = frame->contentY1 = 0;
+  for (size_t ty = 0; ty < frame->rows; ty++) {
+    PTDCanvasTile *const *tileRow = frame->tiles + ty * frame->columns;
+    for (size_t tx = 0; tx < frame->columns; tx++) {
+      if (!tileRow[tx])
+        continue;
+      if (tx < frame->contentX0)
+        frame->contentX0 = tx;
+      if (tx >= frame->contentX1)
+        frame->contentX1 = tx + 1;
+      if (ty < frame->contentY0)
+        frame->contentY0 = ty;
+      frame->contentY1 = ty + 1;
+    }
+  }
+}
+
+
+PTDCanvasFrame *PTDCanvasFrameRetain(PTDCanvasFrame *frame)
+{
+  atomic_fetch_add_explicit(&frame->refs, 1, memory_order_relaxed);
+  return frame;
+}
+
+
+void PTDCanvasFrameRelease(PTDCanvasFrame *frame)
+{
+  if (!frame || atomic_fetch_sub_explicit(&frame->refs, 1, memory_order_acq_rel) != 1)
+    return;
+  size_t count = frame->columns * frame->rows;
+  for (size_t i = 0; i < count; i++)
+    PTDCanvasTileRelease(frame->tiles[i]);
+  free(frame);
+}
+
+
+uint64_t PTDCanvasFrameGeneration(const PTDCanvasFrame *frame)
+{
+  return frame->generation;
+}
+
+
+size_t PTDCanvasFrameWidth(const PTDCanvasFrame *frame)
+{
+  return frame->width;
+}
+
+
+size_t PTDCanvasFrameHeight(const PTDCanvasFrame *frame)
+{
+  return frame->height;
+}
+
+
+size_t PTDCanvasFrameAllocatedSize(const PTDCanvasFrame *frame)
+{
+  size_t count = frame->columns * frame->rows;
+  size_t size = sizeof(PTDCanvasFrame) + count * sizeof(PTDCanvasTile *);
+  for (size_t i = 0; i < count; i++) {
+    if (frame->tiles[i])
+      size += sizeof(PTDCanvasTile);
+  }
+  return size;
+}
+
+
+int PTDCanvasFrameContentBounds(const PTDCanvasFrame *frame, size_t *x0, size_t *y0, size_t *x1, size_t *y1)
+{
+  if (frame->contentX0 >= frame->contentX1 || frame->contentY0 >= frame->contentY1) {
+    *x0 = *y0 = *x1 = *y1 = 0;
+    return 0;
+  }
+  *x0 = frame->contentX0 * TILE_SIZE;
+  *y0 = frame->contentY0 * TILE_SIZE;
+  *x1 = frame->contentX1 * TILE_SIZE;
+  *y1 = frame->contentY1 * TILE_SIZE;
+  if (*x1 > frame->width)
+    *x1 = frame->width;
+  if (*y1 > frame->height)
+    *y1 = frame->height;
+  return 1;
+}
+
+
+void PTDCanvasFrameCopyPixels(const PTDCanvasFrame *frame, size_t x, size_t y, const PTDPixelBuffer *dst)
+{
+  for (size_t dy = 0; dy < dst->height; dy++) {
+    size_t sy = y + dy;
+    PTDCanvasTile *const *tileRow = frame->tiles + (sy / TILE_SIZE) * frame->columns;
+    size_t tileY = sy % TILE_SIZE;
+    uint8_t *dstRow = dst->data + dy * dst->bytesPerRow;
+    
+    size_t dx = 0;
+    while (dx < dst->width) {
+      size_t sx = x + dx;
+      size_t tileX = sx % TILE_SIZE;
+      size_t run = TILE_SIZE - tileX;
+      if (run > dst->width - dx)
+        run = dst->width - dx;
+      const PTDCanvasTile *tile = tileRow[sx / TILE_SIZE];
+      if (tile)
+        memcpy(dstRow + dx * 4, tile->pixels + (tileY * TILE_SIZE + tileX) * 4, run * 4);
+      else
+        memset(dstRow + dx * 4, 0, run * 4);
+      dx += run;
+    }
+  }
+}
+
+
+PTDCanvasStore *PTDCanvasStoreCreate(size_t width, size_t height)
+{
+  PTDCanvasStore *store = calloc(1, sizeof(PTDCanvasStore));
+  if (!store)
+    return NULL;
+  atomic_init(&store->refs, 1);
+  store->width = width;
+  store->height = height;
+  store->columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+  store->rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+  atomic_init(&store->current, NULL);
+  atomic_init(&store->epoch, 1);
+  for (int i = 0; i < READER_SLOTS; i++)
+    atomic_init(&store->readerEpochs[i], 0);
+  return store;
+}
+
+
+PTDCanvasStore *PTDCanvasStoreRetain(PTDCanvasStore *store)
+{
+  atomic_fetch_add_explicit(&store->refs, 1, memory_order_relaxed);
+  return store;
+}
+
+
+void PTDCanvasStoreRelease(PTDCanvasStore *store)
+{
+  if (!store || atomic_fetch_sub_explicit(&store->refs, 1, memory_order_acq_rel) != 1)
+    return;
+  /* nobody else can be acquiring a frame at this point */
+  PTDCanvasFrameRelease(atomic_load_explicit(&store->current, memory_order_relaxed));
+  while (store->retired) {
+    PTDCanvasFrame *frame = store->retired;
+    store->retired = frame->nextRetired;
+    PTDCanvasFrameRelease(frame);
+  }
+  free(store);
+}
+
+
+size_t PTDCanvasStoreWidth(const PTDCanvasStore *store)
+{
+  return store->width;
+}
+
+
+size_t PTDCanvasStoreHeight(const PTDCanvasStore *store)
+{
+  return store->height;
+}
+
+
+PTDCanvasFrame *PTDCanvasStoreAcquireFrame(PTDCanvasStore *store)
+{
+  /* The slot is claimed before the current frame is loaded, so the writer
+   * either sees the slot, or has swapped the frame before the load and the
+   * reader can only get the new one. An epoch which is stale by the time
+   * the slot is claimed is only more conservative. */
+  int slot = 0;
+  for (;;) {
+    uint64_t epoch = atomic_load(&store->epoch);
+    uint64_t expected = 0;
+    if (atomic_compare_exchange_strong(&store->readerEpochs[slot], &expected, epoch))
+      break;
+    if (++slot == READER_SLOTS) {
+      /* every slot is held for a few instructions at most */
+      slot = 0;
+      sched_yield();
+    }
+  }
+  
+  PTDCanvasFrame *frame = atomic_load(&store->current);
+  if (frame)
+    PTDCanvasFrameRetain(frame);
+  atomic_store_explicit(&store->readerEpochs[slot], 0, memory_order_release);
+  return frame;
+}
+
+
+static void PTDCanvasStoreReclaim(PTDCanvasStore *store)
+{
+  uint64_t oldestReader = UINT64_MAX;
+  for (int i = 0; i < READER_SLOTS; i++) {
+    uint64_t epoch = atomic_load(&store->readerEpochs[i]);
+    if (epoch != 0 && epoch < oldestReader)
+      oldestReader = epoch;
+  }
+  
+  PTDCanvasFrame **link = &store->retired;
+  while (*link) {
+    PTDCanvasFrame *frame = *link;
+    if (frame->retiredEpoch < oldestReader) {
+      *link = frame->nextRetired;
+      PTDCanvasFrameRelease(frame);
+    } else {
+      link = &frame->nextRetired;
+    }
+  }
+}
+
+
+uint64_t PTDCanvasStorePublish(PTDCanvasStore *store, const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+  PTDCanvasFrame *previous = atomic_load_explicit(&store->current, memory_order_relaxed);
+  PTDCanvasFrame *frame = PTDCanvasFrameCreate(store, previous ? previous->generation + 1 : 1);
+  if (!frame)
+    return 0;
+  
+  if (x1 > store->width)
+    x1 = store->width;
+  if (y1 > store->height)
+    y1 = store->height;
+  size_t tx0 = x0 / TILE_SIZE, ty0 = y0 / TILE_SIZE;
+  size_t tx1 = x0 < x1 ? (x1 + TILE_SIZE - 1) / TILE_SIZE : tx0;
+  size_t ty1 = y0 < y1 ? (y1 + TILE_SIZE - 1) / TILE_SIZE : ty0;
+  
+  for (size_t ty = 0; ty < store->rows; ty++) {
+    for (size_t tx = 0; tx < store->columns; tx++) {
+      size_t i = ty * store->columns + tx;
+      if (tx < tx0 || tx >= tx1 || ty < ty0 || ty >= ty1) {
+        PTDCanvasTile *shared = previous ? previous->tiles[i] : NULL;
+        if (shared)
+          atomic_fetch_add_explicit(&shared->refs, 1, memory_order_relaxed);
+        frame->tiles[i] = shared;
+        continue;
+      }
+      
+      PTDCanvasTile *tile = malloc(sizeof(PTDCanvasTile));
+      if (!tile) {
+        PTDCanvasFrameRelease(frame);
+        return 0;
+      }
+      atomic_init(&tile->refs, 1);
+      size_t w = store->width - tx * TILE_SIZE;
+      size_t h = store->height - ty * TILE_SIZE;
+      if (w > TILE_SIZE)
+        w = TILE_SIZE;
+      if (h > TILE_SIZE)
+        h = TILE_SIZE;
+      if (w < TILE_SIZE || h < TILE_SIZE)
+        memset(tile->pixels, 0, sizeof(tile->pixels));
+      const uint8_t *src = canvas->data + ty * TILE_SIZE * canvas->bytesPerRow + tx * TILE_SIZE * 4;
+      for (size_t y = 0; y < h; y++)
+        memcpy(tile->pixels + y * TILE_SIZE * 4, src + y * canvas->bytesPerRow, w * 4);
+      if (PTDCanvasTileIsTransparent(tile)) {
+        free(tile);
+        tile = NULL;
+      }
+      frame->tiles[i] = tile;
+    }
+  }
+  PTDCanvasFrameUpdateContentBounds(frame);
+  
+  uint64_t generation = frame->generation;
+  atomic_store(&store->current, frame);
+  if (previous) {
+    previous->retiredEpoch = atomic_fetch_add(&store->epoch, 1);
+    previous->nextRetired = store->retired;
+    store->retired = previous;
+  }
+  PTDCanvasStoreReclaim(store);
+  return generation;
+}
@@ -0,0 +1,106 @@
+//
+// PTDCanvasStore.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDCanvasStore_h
+#define PTDCanvasStore_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "PTDResampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Immutable copies of a canvas which can be read from any thread while the
+ * canvas keeps changing.
+ *
+ * A frame is a grid of tiles. Publishing a new frame copies only the tiles
+ * which changed, the others are shared with the previous frame. Fully
+ * transparent tiles take no memory. Each frame has a generation number,
+ * which grows by one every time a frame is published.
+ *
+ * Only one thread, the writer, may publish; any number of readers can
+ * acquire the current frame at the same time, and neither side ever waits
+ * for the other. Memory is reclaimed according to these rules:
+ *  - Frames and tiles are reference counted. A frame acquired by a reader
+ *    stays valid, unchanged, until the reader releases it, no matter how
+ *    many frames are published in the meantime or whether the store is
+ *    gone already. Slow readers therefore only keep their own frame alive.
+ *  - A reader announces the epoch it started in while it goes from the
+ *    pointer to the current frame to a reference to it. A frame replaced
+ *    by a newer one loses the reference of the store only once no reader
+ *    still announces an epoch at or before the one it was replaced in.
+ *    This check is done by the writer each time it publishes, and never
+ *    makes it wait.
+ *  - The store itself is reference counted, and readers on other threads
+ *    must hold a reference to it while they acquire a frame. */
+typedef struct PTDCanvasStore PTDCanvasStore;
+typedef struct PTDCanvasFrame PTDCanvasFrame;
+
+/* The store starts out without a current frame. */
+PTDCanvasStore *PTDCanvasStoreCreate(size_t width, size_t height);
+PTDCanvasStore *PTDCanvasStoreRetain(PTDCanvasStore *store);
+void PTDCanvasStoreRelease(PTDCanvasStore *store);
+
+size_t PTDCanvasStoreWidth(const PTDCanvasStore *store);
+size_t PTDCanvasStoreHeight(const PTDCanvasStore *store);
+
+/* Writer only. Makes a new frame by copying the tiles of the canvas which
+ * intersect the given rect, in pixels, and taking the others from the
+ * current frame. The canvas must have the size of the store; when there is
+ * no current frame yet, everything outside the rect is taken to be fully
+ * transparent. The canvas is not read, and can be NULL, if the rect is
+ * empty. Returns the generation of the new frame, or zero if it could not
+ * be allocated. */
+uint64_t PTDCanvasStorePublish(PTDCanvasStore *store, const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1);
+
+/* Any thread. Returns the current frame with a new reference to it, or
+ * NULL if nothing was published yet. */
+PTDCanvasFrame *PTDCanvasStoreAcquireFrame(PTDCanvasStore *store);
+
+PTDCanvasFrame *PTDCanvasFrameRetain(PTDCanvasFrame *frame);
+void PTDCanvasFrameRelease(PTDCanvasFrame *frame);
+
+uint64_t PTDCanvasFrameGeneration(const PTDCanvasFrame *frame);
+size_t PTDCanvasFrameWidth(const PTDCanvasFrame *frame);
+size_t PTDCanvasFrameHeight(const PTDCanvasFrame *frame);
+/* The memory taken by the frame and all of its tiles, including the ones
+ * it shares with other frames. */
+size_t PTDCanvasFrameAllocatedSize(const PTDCanvasFrame *frame);
+/* Sets the smallest rect, in pixels, made of whole tiles and clipped to the
+ * frame, which includes every pixel that is not fully transparent. Returns
+ * zero, and an empty rect, if the frame is fully transparent. */
+int PTDCanvasFrameContentBounds(const PTDCanvasFrame *frame, size_t *x0, size_t *y0, size_t *x1, size_t *y1);
+
+/* Copies the pixels of the frame starting at (x, y) to fill the whole
+ * destination buffer, which must fit inside the frame. */
+void PTDCanvasFrameCopyPixels(const PTDCanvasFrame *frame, size_t x, size_t y, const PTDPixelBuffer *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDCanvasStore_h */
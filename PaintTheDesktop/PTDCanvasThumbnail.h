@@ -0,0 +1,61 @@
+//
+// PTDCanvasThumbnail.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+#import "PTDCanvasStore.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* A box-filtered, integer-factor downsampling of an RGBA8 canvas which can
+ * be brought up to date by resampling only the regions that changed.
+ * Invalidation happens on one thread; the regions taken out of the invalid
+ * one can be resampled on any other. */
+@interface PTDCanvasThumbnail : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+- (nullable instancetype)initWithCanvasPixelWidth:(NSInteger)width height:(NSInteger)height maximumArea:(NSInteger)area NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) NSInteger canvasPixelWidth;
+@property (nonatomic, readonly) NSInteger canvasPixelHeight;
+@property (nonatomic, readonly) NSInteger pixelWidth;
+@property (nonatomic, readonly) NSInteger pixelHeight;
+@property (nonatomic, readonly) NSInteger factor;
+
+/* Rect in canvas pixels, with the origin at the top left corner. */
+- (void)invalidateCanvasPixelRect:(NSRect)rect;
+- (void)invalidate;
+@property (nonatomic, readonly) BOOL needsUpdate;
+
+/* Returns the invalid region, in thumbnail pixels, and marks the thumbnail
+ * as up to date until the next invalidation. */
+- (NSRect)takeInvalidRegion;
+/* The frame must have the size of the canvas. */
+- (void)updateRegion:(NSRect)region fromCanvasFrame:(const PTDCanvasFrame *)frame;
+
+- (NSBitmapImageRep *)bitmapImageRepWithColorSpace:(nullable NSColorSpace *)colorSpace;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,133 @@
+//
+// PTDCanvasThumbnail.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDCanvasThumbnail.h"
+#include "PTDThumbnailBuffer.h"
+
+
+@implementation PTDCanvasThumbnail {
+  PTDThumbnailBuffer *_buffer;
+  NSInteger _dirtyMinX, _dirtyMinY, _dirtyMaxX, _dirtyMaxY;
+}
+
+
+- (instancetype)initWithCanvasPixelWidth:(NSInteger)width height:(NSInteger)height maximumArea:(NSInteger)area
+{
+  self = [super init];
+  _buffer = PTDThumbnailBufferCreate((size_t)MAX(1, width), (size_t)MAX(1, height), (size_t)MAX(1, area));
+  if (!_buffer)
+    return nil;
+  _canvasPixelWidth = MAX(1, width);
+  _canvasPixelHeight = MAX(1, height);
+  _factor = (NSInteger)PTDThumbnailBufferFactor(_buffer);
+  _pixelWidth = (NSInteger)PTDThumbnailBufferWidth(_buffer);
+  _pixelHeight = (NSInteger)PTDThumbnailBufferHeight(_buffer);
+  [self invalidate];
+  return self;
+}
+
+
+- (void)dealloc
+{
+  PTDThumbnailBufferDestroy(_buffer);
+}
+
+
+- (void)invalidate
+{
+  _dirtyMinX = 0;
+  _dirtyMinY = 0;
+  _dirtyMaxX = _pixelWidth;
+  _dirtyMaxY = _pixelHeight;
+}
+
+
+- (void)invalidateCanvasPixelRect:(NSRect)rect
+{
+  NSInteger x0 = MAX(0, (NSInteger)floor(NSMinX(rect)) / _factor);
+  NSInteger y0 = MAX(0, (NSInteger)floor(NSMinY(rect)) / _factor);
+  NSInteger x1 = MIN(_pixelWidth, ((NSInteger)ceil(NSMaxX(rect)) + _factor - 1) / _factor);
+  NSInteger y1 = MIN(_pixelHeight, ((NSInteger)ceil(NSMaxY(rect)) + _factor - 1) / _factor);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  
+  if (!self.needsUpdate) {
+    _dirtyMinX = x0;
+    _dirtyMinY = y0;
+    _dirtyMaxX = x1;
+    _dirtyMaxY = y1;
+  } else {
+    _dirtyMinX = MIN(_dirtyMinX, x0);
+    _dirtyMinY = MIN(_dirtyMinY, y0);
+    _dirtyMaxX = MAX(_dirtyMaxX, x1);
+    _dirtyMaxY = MAX(_dirtyMaxY, y1);
+  }
+}
+
+
+- (BOOL)needsUpdate
+{
+  return _dirtyMinX < _dirtyMaxX && _dirtyMinY < _dirtyMaxY;
+}
+
+
+- (NSRect)takeInvalidRegion
+{
+  if (!self.needsUpdate)
+    return NSZeroRect;
+  NSRect region = NSMakeRect(_dirtyMinX, _dirtyMinY, _dirtyMaxX - _dirtyMinX, _dirtyMaxY - _dirtyMinY);
+  _dirtyMinX = _dirtyMaxX = 0;
+  _dirtyMinY = _dirtyMaxY = 0;
+  return region;
+}
+
+
+- (void)updateRegion:(NSRect)region fromCanvasFrame:(const PTDCanvasFrame *)frame
+{
+  NSInteger x0 = MAX(0, (NSInteger)NSMinX(region));
+  NSInteger y0 = MAX(0, (NSInteger)NSMinY(region));
+  NSInteger x1 = MAX(x0, (NSInteger)NSMaxX(region));
+  NSInteger y1 = MAX(y0, (NSInteger)NSMaxY(region));
+  PTDThumbnailBufferUpdate(_buffer, frame, x0, y0, x1, y1);
+}
+
+
+- (NSBitmapImageRep *)bitmapImageRepWithColorSpace:(NSColorSpace *)colorSpace
+{
+  NSBitmapImageRep *rep = [[NSBitmapImageRep alloc]
+      initWithBitmapDataPlanes:NULL
+      pixelsWide:_pixelWidth pixelsHigh:_pixelHeight
+      bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+      colorSpaceName:NSCalibratedRGBColorSpace
+      bytesPerRow:_pixelWidth * 4 bitsPerPixel:0];
+  PTDPixelBuffer dst = {rep.bitmapData, (size_t)_pixelWidth, (size_t)_pixelHeight, (size_t)_pixelWidth * 4};
+  PTDThumbnailBufferCopyPixels(_buffer, &dst);
+  if (colorSpace)
+    rep = [rep bitmapImageRepByRetaggingWithColorSpace:colorSpace];
+  return rep;
+}
+
+
+@end
@@ -0,0 +1,416 @@
+//
+// PTDCompressedCanvas.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "PTDCompressedCanvas.h"
+#include "PTDParallel.h"
+
+
+#define TILE_SIZE 64
+#define TILE_BYTES (TILE_SIZE * TILE_SIZE * 4)
+
+/* The coder works on blocks of at most 64KB, so that any position fits in
+ * the 16 bit offsets and in the hash table. */
+#define HASH_BITS 12
+#define MIN_MATCH 4
+/* the last bytes of a block are always literals, so that matches can be
+ * found and extended with loads of 8 bytes without bounds checks */
+#define LAST_LITERALS 8
+#define MATCH_SEARCH_LIMIT (LAST_LITERALS + 8)
+/* the worst case size of a block, which is when nothing matches */
+#define COMPRESS_BOUND(n) ((n) + (n) / 255 + 16)
+
+
+typedef struct {
+  /* NULL for fully transparent tiles */
+  uint8_t *data;
+  /* equal to the size of the pixels when stored uncompressed */
+  uint32_t size;
+} PTDCompressedTile;
+
+struct PTDCompressedCanvas {
+  size_t width;
+  size_t height;
+  size_t columns;
+  size_t rows;
+  _Atomic size_t dataSize;
+  PTDCompressedTile tiles[];
+};
+
+
+#pragma mark - Coder
+
+
+static inline uint32_t PTDLZRead32(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+
+static inline uint64_t PTDLZRead64(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+
+static inline size_t PTDLZHash(uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+
+static uint8_t *PTDLZWriteLength(uint8_t *op, size_t length)
+{
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+
+/* A sequence is a token with the lengths of the literals and of the match
+ * in its nibbles, the longer lengths continuing in the following bytes,
+ * then the literals, then the offset of the match. The last sequence has
+ * no match. */
+static uint8_t *PTDLZWriteSequence(uint8_t *op, const uint8_t *literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+  uint8_t *token = op++;
+  *token = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+  if (literalLength >= 15)
+    op = PTDLZWriteLength(op, literalLength - 15);
+  memcpy(op, literals, literalLength);
+  op += literalLength;
+  if (offset == 0)
+    return op;
+  
+  *op++ = (uint8_t)offset;
+  *op++ = (uint8_t)(offset >> 8);
+  matchLength -= MIN_MATCH;
+  *token |= (uint8_t)(matchLength < 15 ? matchLength : 15);
+  if (matchLength >= 15)
+    op = PTDLZWriteLength(op, matchLength - 15);
+  return op;
+}
+
+
+/* Returns the size of the compressed data, or zero if it is not smaller
+ * than the source. */
+static size_t PTDLZCompress(const uint8_t *src, size_t size, uint8_t *dst)
+{
+  uint16_t table[1 << HASH_BITS] = {0};
+  const uint8_t *ip = src, *anchor = src;
+  const uint8_t *end = src + size;
+  uint8_t *op = dst;
+  
+  if (size > MATCH_SEARCH_LIMIT) {
+    const uint8_t *searchLimit = end - MATCH_SEARCH_LIMIT;
+    const uint8_t *matchLimit = end - LAST_LITERALS;
+    unsigned misses = 0;
+    while (ip < searchLimit) {
+      uint32_t seq = PTDLZRead32(ip);
+      size_t h = PTDLZHash(seq);
+      const uint8_t *ref = src + table[h];
+      table[h] = (uint16_t)(ip - src);
+      if (ref >= ip || PTDLZRead32(ref) != seq) {
+        /* skip faster through data that does not compress */
+        ip += 1 + (misses++ >> 5);
+        continue;
+      }
+      misses = 0;
+      
+      const uint8_t *mp = ip + MIN_MATCH, *rp = ref + MIN_MATCH;
+      while (mp < matchLimit) {
+        uint64_t diff = PTDLZRead64(mp) ^ PTDLZRead64(rp);
+        if (diff) {
+          mp += __builtin_ctzll(diff) / 8;
+          break;
+        }
+        mp += 8;
+        rp += 8;
+      }
+      if (mp > matchLimit)
+        mp = matchLimit;
+      
+      op = PTDLZWriteSequence(op, anchor, ip - anchor, ip - ref, mp - ip);
+      if ((size_t)(op - dst) >= size)
+        return 0;
+      ip = anchor = mp;
+    }
+  }
+  
+  op = PTDLZWriteSequence(op, anchor, end - anchor, 0, 0);
+  size_t result = op - dst;
+  return result < size ? result : 0;
+}
+
+
+static int PTDLZReadLength(const uint8_t **ip, const uint8_t *end, size_t *length)
+{
+  uint8_t byte;
+  do {
+    if (*ip >= end)
+      return 0;
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return 1;
+}
+
+
+/* Returns zero unless the data fills exactly the whole destination. */
+static int PTDLZDecompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dstSize)
+{
+  const uint8_t *ip = src, *end = src + size;
+  uint8_t *op = dst, *dstEnd = dst + dstSize;
+  
+  while (ip < end) {
+    uint8_t token = *ip++;
+    size_t literalLength = token >> 4;
+    if (literalLength == 15 && !PTDLZReadLength(&ip, end, &literalLength))
+      return 0;
+    if (literalLength > (size_t)(end - ip) || literalLength > (size_t)(dstEnd - op))
+      return 0;
+    memcpy(op, ip, literalLength);
+    op += literalLength;
+    ip += literalLength;
+    if (ip == end)
+      break;
+    
+    if (end - ip < 2)
+      return 0;
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t matchLength = token & 15;
+    if (matchLength == 15 && !PTDLZReadLength(&ip, end, &matchLength))
+      return 0;
+    matchLength += MIN_MATCH;
+    if (offset == 0 || offset > (size_t)(op - dst) || matchLength > (size_t)(dstEnd - op))
+      return 0;
+    
+    const uint8_t *ref = op - offset;
+    if (offset >= matchLength) {
+      memcpy(op, ref, matchLength);
+    } else {
+      /* Overlapping, which is how runs are encoded. The bytes copied so far
+       * are a whole number of repetitions, so the source can grow with
+       * them and never overlap the destination. */
+      size_t copied = 0;
+      while (copied < matchLength) {
+        size_t n = copied + offset;
+        if (n > matchLength - copied)
+          n = matchLength - copied;
+        memcpy(op + copied, ref, n);
+        copied += n;
+      }
+    }
+    op += matchLength;
+  }
+  return op == dstEnd;
+}
+
+
+#pragma mark - Canvas
+
+
+static int PTDCompressedCanvasIsTransparent(const uint8_t *pixels, size_t size)
+{
+  uint64_t acc = 0;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    acc |= PTDLZRead64(pixels + i);
+  if (i < size)
+    acc |= PTDLZRead32(pixels + i);
+  return acc == 0;
+}
+
+
+static void PTDCompressedCanvasTileSize(const PTDCompressedCanvas *canvas, size_t tx, size_t ty, size_t *w, size_t *h)
+{
+  *w = canvas->width - tx * TILE_SIZE;
+  *h = canvas->height - ty * TILE_SIZE;
+  if (*w > TILE_SIZE)
+    *w = TILE_SIZE;
+  if (*h > TILE_SIZE)
+    *h = TILE_SIZE;
+}
+
+
+typedef struct {
+  PTDCompressedCanvas *canvas;
+  const PTDCanvasFrame *frame;
+  _Atomic int failed;
+} PTDCompressedCanvasCompressJob;
+
+
+static void PTDCompressedCanvasCompressRow(void *context, size_t ty)
+{
+  PTDCompressedCanvasCompressJob *job = context;
+  PTDCompressedCanvas *canvas = job->canvas;
+  uint8_t pixels[TILE_BYTES];
+  uint8_t compressed[COMPRESS_BOUND(TILE_BYTES)];
+  size_t rowSize = 0;
+  for (size_t tx = 0; tx < canvas->columns && !atomic_load_explicit(&job->failed, memory_order_relaxed); tx++) {
+    size_t w, h;
+    PTDCompressedCanvasTileSize(canvas, tx, ty, &w, &h);
+    size_t size = w * h * 4;
+    PTDPixelBuffer tile = {pixels, w, h, w * 4};
+    PTDCanvasFrameCopyPixels(job->frame, tx * TILE_SIZE, ty * TILE_SIZE, &tile);
+    if (PTDCompressedCanvasIsTransparent(pixels, size))
+      continue;
+    
+    const uint8_t *data = pixels;
+    size_t compressedSize = PTDLZCompress(pixels, size, compressed);
+    if (compressedSize > 0) {
+      data = compressed;
+      size = compressedSize;
+    }
+    PTDCompressedTile *dst = &canvas->tiles[ty * canvas->columns + tx];
+    dst->data = malloc(size);
+    if (!dst->data) {
+      atomic_store_explicit(&job->failed, 1, memory_order_relaxed);
+      break;
+    }
+    memcpy(dst->data, data, size);
+    dst->size = (uint32_t)size;
+    rowSize += size;
+  }
+  atomic_fetch_add_explicit(&canvas->dataSize, rowSize, memory_order_relaxed);
+}
+
+
+PTDCompressedCanvas *PTDCompressedCanvasCreate(const PTDCanvasFrame *frame)
+{
+  size_t width = PTDCanvasFrameWidth(frame);
+  size_t height = PTDCanvasFrameHeight(frame);
+  size_t columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+  size_t rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+  PTDCompressedCanvas *canvas = calloc(1, sizeof(PTDCompressedCanvas) + columns * rows * sizeof(PTDCompressedTile));
+  if (!canvas)
+    return NULL;
+  canvas->width = width;
+  canvas->height = height;
+  canvas->columns = columns;
+  canvas->rows = rows;
+  atomic_init(&canvas->dataSize, 0);
+  
+  PTDCompressedCanvasCompressJob job;
+  job.canvas = canvas;
+  job.frame = frame;
+  atomic_init(&job.failed, 0);
+  PTDParallelApply(rows, &job, PTDCompressedCanvasCompressRow);
+  
+  if (atomic_load(&job.failed)) {
+    PTDCompressedCanvasDestroy(canvas);
+    return NULL;
+  }
+  return canvas;
+}
+
+
+void PTDCompressedCanvasDestroy(PTDCompressedCanvas *canvas)
+{
+  if (!canvas)
+    return;
+  for (size_t i = 0; i < canvas->columns * canvas->rows; i++)
+    free(canvas->tiles[i].data);
+  free(canvas);
+}
+
+
+size_t PTDCompressedCanvasWidth(const PTDCompressedCanvas *canvas)
+{
+  return canvas->width;
+}
+
+
+size_t PTDCompressedCanvasHeight(const PTDCompressedCanvas *canvas)
+{
+  return canvas->height;
+}
+
+
+size_t PTDCompressedCanvasSize(const PTDCompressedCanvas *canvas)
+{
+  size_t tableSize = canvas->columns * canvas->rows * sizeof(PTDCompressedTile);
+  return sizeof(PTDCompressedCanvas) + tableSize + atomic_load_explicit(&canvas->dataSize, memory_order_relaxed);
+}
+
+
+typedef struct {
+  const PTDCompressedCanvas *canvas;
+  const PTDPixelBuffer *dst;
+  _Atomic int failed;
+} PTDCompressedCanvasDecompressJob;
+
+
+static void PTDCompressedCanvasDecompressRow(void *context, size_t ty)
+{
+  PTDCompressedCanvasDecompressJob *job = context;
+  const PTDCompressedCanvas *canvas = job->canvas;
+  const PTDPixelBuffer *dst = job->dst;
+  uint8_t pixels[TILE_BYTES];
+  for (size_t tx = 0; tx < canvas->columns; tx++) {
+    size_t w, h;
+    PTDCompressedCanvasTileSize(canvas, tx, ty, &w, &h);
+    size_t size = w * h * 4;
+    const PTDCompressedTile *tile = &canvas->tiles[ty * canvas->columns + tx];
+    uint8_t *out = dst->data + ty * TILE_SIZE * dst->bytesPerRow + tx * TILE_SIZE * 4;
+    
+    const uint8_t *src = pixels;
+    if (!tile->data) {
+      memset(pixels, 0, size);
+    } else if (tile->size == size) {
+      src = tile->data;
+    } else if (!PTDLZDecompress(tile->data, tile->size, pixels, size)) {
+      atomic_store_explicit(&job->failed, 1, memory_order_relaxed);
+      memset(pixels, 0, size);
+    }
+    for (size_t y = 0; y < h; y++)
+      memcpy(out + y * dst->bytesPerRow, src + y * w * 4, w * 4);
+  }
+}
+
+
+int PTDCompressedCanvasDecompress(const PTDCompressedCanvas *canvas, const PTDPixelBuffer *dst)
+{
+  if (dst->width != canvas->width || dst->height != canvas->height)
+    return 0;
+  
+  PTDCompressedCanvasDecompressJob job;
+  job.canvas = canvas;
+  job.dst = dst;
+  atomic_init(&job.failed, 0);
+  PTDParallelApply(canvas->rows, &job, PTDCompressedCanvasDecompressRow);
+  return !atomic_load(&job.failed);
+}
@@ -0,0 +1,67 @@
+//
+// PTDCompressedCanvas.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef PTDCompressedCanvas_h
+#define PTDCompressedCanvas_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "PTDResampler.h"
+#include "PTDCanvasStore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A canvas compressed in tiles of 64x64 pixels, for canvases that are not
+ * going to be drawn on for a while.
+ *
+ * Fully transparent tiles take no space at all. The others are compressed
+ * with a fast LZ77 coder with byte-aligned sequences, which mostly gains
+ * on the long runs of identical pixels of drawings; tiles that do not get
+ * smaller are stored as they are. Compression and decompression process
+ * rows of tiles concurrently. */
+typedef struct PTDCompressedCanvas PTDCompressedCanvas;
+
+/* Compresses a frame of a canvas store, so that it can run on any thread.
+ * Returns NULL if the memory could not be allocated. */
+PTDCompressedCanvas *PTDCompressedCanvasCreate(const PTDCanvasFrame *frame);
+void PTDCompressedCanvasDestroy(PTDCompressedCanvas *canvas);
+
+size_t PTDCompressedCanvasWidth(const PTDCompressedCanvas *canvas);
+size_t PTDCompressedCanvasHeight(const PTDCompressedCanvas *canvas);
+/* The number of bytes taken by the compressed canvas. */
+size_t PTDCompressedCanvasSize(const PTDCompressedCanvas *canvas);
+
+/* Overwrites the whole destination buffer, which must have the same size
+ * as the canvas. Returns zero if the compressed data is inconsistent. */
+int PTDCompressedCanvasDecompress(const PTDCompressedCanvas *canvas, const PTDPixelBuffer *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDCompressedCanvas_h */
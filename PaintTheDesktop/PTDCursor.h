@@ -34,6 +34,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)cursorFromCursor:(NSCursor *)cursor;
 
+/* Returns the cursor previously generated for an equal key, if it is
+ * still cached; otherwise invokes the generator. Cached cursors are
+ * shared and must not be modified. */
++ (PTDCursor *)cachedCursorWithKey:(id)key generator:(NS_NOESCAPE PTDCursor * (^)(void))generator;
+/* How many times the generator was invoked so far, for diagnostics. */
+@property (class, nonatomic, readonly) NSUInteger cachedCursorMissCount;
+
+/* The image pre-rendered as a bitmap at the given scale. */
+- (nullable CGImageRef)spriteForBackingScaleFactor:(CGFloat)scale CF_RETURNS_NOT_RETAINED;
+
 @end
 
 NS_ASSUME_NONNULL_END
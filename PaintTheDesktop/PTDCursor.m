@@ -25,7 +25,13 @@
 
 #import "PTDCursor.h"
 
-@implementation PTDCursor
+static const NSUInteger _CursorCacheCountLimit = 32;
+static NSUInteger _CursorCacheMisses;
+
+
+@implementation PTDCursor {
+  NSMutableDictionary <NSNumber *, id> *_sprites;
+}
 
 
 + (instancetype)cursorFromCursor:(NSCursor *)cursor
@@ -37,4 +43,79 @@
 }
 
 
++ (PTDCursor *)cachedCursorWithKey:(id)key generator:(NS_NOESCAPE PTDCursor * (^)(void))generator
+{
+  static NSCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.countLimit = _CursorCacheCountLimit;
+  });
+  
+  PTDCursor *res = [cache objectForKey:key];
+  if (!res) {
+    _CursorCacheMisses++;
+    res = generator();
+    [cache setObject:res forKey:key];
+  }
+  return res;
+}
+
+
++ (NSUInteger)cachedCursorMissCount
+{
+  return _CursorCacheMisses;
+}
+
+
+- (void)setImage:(NSImage *)image
+{
+  _image = image;
+  [_sprites removeAllObjects];
+}
+
+
+- (nullable CGImageRef)spriteForBackingScaleFactor:(CGFloat)scale
+{
+  if (!_sprites)
+    _sprites = [[NSMutableDictionary alloc] init];
+  
+  NSNumber *key = @(scale);
+  id sprite = [_sprites objectForKey:key];
+  if (!sprite) {
+    sprite = CFBridgingRelease([self newSpriteForBackingScaleFactor:scale]);
+    if (!sprite)
+      return NULL;
+    [_sprites setObject:sprite forKey:key];
+  }
+  return (__bridge CGImageRef)sprite;
+}
+
+
+- (nullable CGImageRef)newSpriteForBackingScaleFactor:(CGFloat)scale CF_RETURNS_RETAINED
+{
+  NSSize size = self.image.size;
+  size_t width = (size_t)ceil(size.width * scale);
+  size_t height = (size_t)ceil(size.height * scale);
+  if (width == 0 || height == 0)
+    return NULL;
+  
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+  CGContextRef ctx = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Host);
+  CGColorSpaceRelease(colorSpace);
+  if (!ctx)
+    return NULL;
+  CGContextScaleCTM(ctx, scale, scale);
+  
+  [NSGraphicsContext saveGraphicsState];
+  NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithCGContext:ctx flipped:NO];
+  [self.image drawInRect:(NSRect){NSZeroPoint, size} fromRect:NSZeroRect operation:NSCompositingOperationCopy fraction:1.0];
+  [NSGraphicsContext restoreGraphicsState];
+  
+  CGImageRef res = CGBitmapContextCreateImage(ctx);
+  CGContextRelease(ctx);
+  return res;
+}
+
+
 @end
@@ -24,30 +24,61 @@
 //
 
 #import <Cocoa/Cocoa.h>
+#import "PTDResampler.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @class PTDPaintView;
 @class PTDTransientView;
+@class PTDCanvasObject;
+@class PTDCanvasSnapshot;
 
 @interface PTDDrawingSurface : NSObject
 
 - (instancetype)initWithPaintView:(PTDPaintView *)paintView;
 
-- (void)beginCanvasDrawing;
+/* Makes the canvas the current graphics context, for drawing in the rect;
+ * it can be called again before ending, with other rects. */
+- (void)beginCanvasDrawingInRect:(NSRect)rect;
+/* Reports the rects drawn since -beginCanvasDrawingInRect: to the canvas,
+ * or all of it if none was reported. */
 - (void)endCanvasDrawing;
+- (void)canvasDidChangeInRect:(NSRect)rect;
 
 - (CALayer *)overlayLayer;
 
+/* Canvas objects are drawn above the canvas; the ones in the way of any
+ * other drawing are flattened into it first. */
+- (void)addCanvasObject:(PTDCanvasObject *)object;
+- (void)removeCanvasObject:(PTDCanvasObject *)object;
+- (void)replaceCanvasObject:(PTDCanvasObject *)object withObject:(PTDCanvasObject *)newObject;
+- (nullable PTDCanvasObject *)canvasObjectAtPoint:(NSPoint)point;
+- (void)flattenCanvasObjects;
+
 - (void)beginTextEditingWithTextView:(NSTextView *)textView;
 - (void)endTextEditing:(NSTextView *)textView;
 
 - (NSBitmapImageRep *)captureRect:(NSRect)rect;
+- (void)modifyCanvasPixelsInRect:(NSRect)rect usingBlock:(NS_NOESCAPE NSRect (^)(NSBitmapImageRep *canvas))block;
+- (void)readCanvasPixelsUsingBlock:(NS_NOESCAPE void (^)(const PTDPixelBuffer *canvas))block;
+/* Runs the block in the background; see PTDPaintView. */
+- (void)enqueueCanvasModificationInRect:(NSRect)rect usingBlock:(NSRect (^)(const PTDPixelBuffer *canvas))block;
+- (NSUInteger)canvasRevision;
+/* A copy of the canvas which can be read on any thread; see PTDPaintView. */
+- (nullable PTDCanvasSnapshot *)publishedSnapshot;
+- (nullable PTDCanvasSnapshot *)publishedSnapshotIncludingCanvasObjects;
 
 - (NSRect)bounds;
 - (NSPoint)convertPointFromScreen:(NSPoint)point;
 
 - (NSPoint)alignPointToBacking:(NSPoint)point;
+- (NSSize)backingScaleFactor;
+- (NSColorSpace *)canvasColorSpace;
+
+/* Canvas pixel coordinates have their origin on the top left corner. */
+- (NSSize)canvasPixelSize;
+- (NSPoint)convertPointToCanvasPixels:(NSPoint)point;
+- (NSRect)convertRectFromCanvasPixels:(NSRect)rect;
 
 @end
 
@@ -26,12 +26,14 @@
 #import "PTDDrawingSurface.h"
 #import "PTDPaintView.h"
 #import "NSView+PTD.h"
+#import "PTDCanvasObjectList.h"
 
 
 @implementation PTDDrawingSurface {
   PTDPaintView *_paintView;
   NSGraphicsContext *_canvasContext;
   BOOL _touchedPaintView;
+  NSRect _damagedRect;
 }
 
 
@@ -43,11 +45,13 @@
 }
 
 
-- (void)beginCanvasDrawing
+- (void)beginCanvasDrawingInRect:(NSRect)rect
 {
   _touchedPaintView = YES;
-  if (!_canvasContext)
-    _canvasContext = _paintView.graphicsContext;
+  [_paintView flattenCanvasObjectsInRect:rect];
+  /* a new context waits for the objects flattened in the background */
+  [_canvasContext flushGraphics];
+  _canvasContext = _paintView.graphicsContext;
   [NSGraphicsContext setCurrentContext:_canvasContext];
 }
 
@@ -60,17 +64,55 @@
   [NSGraphicsContext setCurrentContext:nil];
   _canvasContext = nil;
   if (_touchedPaintView) {
-    [_paintView setNeedsDisplay:YES];
+    [_paintView canvasDidChangeInRect:NSIsEmptyRect(_damagedRect) ? _paintView.bounds : _damagedRect];
+    _touchedPaintView = NO;
+    _damagedRect = NSZeroRect;
   }
 }
 
 
+- (void)canvasDidChangeInRect:(NSRect)rect
+{
+  _damagedRect = NSUnionRect(_damagedRect, rect);
+}
+
+
 - (CALayer *)overlayLayer
 {
   return _paintView.overlayLayer;
 }
 
 
+- (void)addCanvasObject:(PTDCanvasObject *)object
+{
+  [_paintView.canvasObjects addObject:object];
+}
+
+
+- (void)removeCanvasObject:(PTDCanvasObject *)object
+{
+  [_paintView.canvasObjects removeObject:object];
+}
+
+
+- (void)replaceCanvasObject:(PTDCanvasObject *)object withObject:(PTDCanvasObject *)newObject
+{
+  [_paintView.canvasObjects replaceObject:object withObject:newObject];
+}
+
+
+- (nullable PTDCanvasObject *)canvasObjectAtPoint:(NSPoint)point
+{
+  return [_paintView.canvasObjects objectAtPoint:point];
+}
+
+
+- (void)flattenCanvasObjects
+{
+  [_paintView flattenCanvasObjects];
+}
+
+
 - (void)beginTextEditingWithTextView:(NSTextView *)textView;
 {
   [_paintView addSubview:textView];
@@ -91,6 +133,42 @@
 }
 
 
+- (void)modifyCanvasPixelsInRect:(NSRect)rect usingBlock:(NS_NOESCAPE NSRect (^)(NSBitmapImageRep *canvas))block
+{
+  [_paintView modifyCanvasPixelsInRect:rect usingBlock:block];
+}
+
+
+- (void)readCanvasPixelsUsingBlock:(NS_NOESCAPE void (^)(const PTDPixelBuffer *canvas))block
+{
+  [_paintView readCanvasPixelsUsingBlock:block];
+}
+
+
+- (void)enqueueCanvasModificationInRect:(NSRect)rect usingBlock:(NSRect (^)(const PTDPixelBuffer *canvas))block
+{
+  [_paintView enqueueCanvasModificationInRect:rect usingBlock:block];
+}
+
+
+- (NSUInteger)canvasRevision
+{
+  return _paintView.canvasRevision;
+}
+
+
+- (nullable PTDCanvasSnapshot *)publishedSnapshot
+{
+  return [_paintView publishedSnapshot];
+}
+
+
+- (nullable PTDCanvasSnapshot *)publishedSnapshotIncludingCanvasObjects
+{
+  return [_paintView publishedSnapshotIncludingCanvasObjects];
+}
+
+
 - (NSRect)bounds
 {
   return _paintView.paintRect;
@@ -110,6 +188,44 @@
 }
 
 
+- (NSSize)backingScaleFactor
+{
+  return _paintView.backingScaleFactor;
+}
+
+
+- (NSColorSpace *)canvasColorSpace
+{
+  return _paintView.canvasColorSpace;
+}
+
+
+- (NSSize)canvasPixelSize
+{
+  NSSize scale = _paintView.backingScaleFactor;
+  NSRect bounds = _paintView.bounds;
+  return NSMakeSize(round(bounds.size.width * scale.width), round(bounds.size.height * scale.height));
+}
+
+
+- (NSPoint)convertPointToCanvasPixels:(NSPoint)point
+{
+  NSSize scale = _paintView.backingScaleFactor;
+  return NSMakePoint(point.x * scale.width, (NSHeight(_paintView.bounds) - point.y) * scale.height);
+}
+
+
+- (NSRect)convertRectFromCanvasPixels:(NSRect)rect
+{
+  NSSize scale = _paintView.backingScaleFactor;
+  return NSMakeRect(
+      rect.origin.x / scale.width,
+      NSHeight(_paintView.bounds) - NSMaxY(rect) / scale.height,
+      rect.size.width / scale.width,
+      rect.size.height / scale.height);
+}
+
+
 - (void)dealloc
 {
   if (_canvasContext) {
@@ -84,7 +84,7 @@ NSString * const PTDEraserToolOptionSizeOptions = @"sizes";
 
 - (void)reloadOptions
 {
-  self.size = [[[PTDToolOptions sharedOptions] objectForOption:PTDEraserToolOptionSize ofToolClass:self.class] integerValue];
+  self.size = [[PTDToolOptions sharedOptions] integerForOption:PTDEraserToolOptionSize ofToolClass:self.class];
   [self updateCursor];
 }
 
@@ -110,11 +110,6 @@ NSString * const PTDEraserToolOptionSizeOptions = @"sizes";
 
 - (void)dragDidContinueFromPoint:(NSPoint)prevPoint toPoint:(NSPoint)nextPoint
 {
-  [self.currentDrawingSurface beginCanvasDrawing];
-  [[NSGraphicsContext currentContext] setCompositingOperation:NSCompositingOperationClear];
-
-  [[NSColor colorWithWhite:1.0 alpha:0.0] setFill];
-  
   NSRect origRect = NSMakeRect(prevPoint.x-_size/2, prevPoint.y-_size/2, _size, _size);
   NSRect destRect = NSMakeRect(nextPoint.x-_size/2, nextPoint.y-_size/2, _size, _size);
   NSPoint joinP1, joinP2, joinP3, joinP4;
@@ -130,15 +125,30 @@ NSString * const PTDEraserToolOptionSizeOptions = @"sizes";
     joinP4 = NSMakePoint(NSMaxX(origRect), NSMaxY(origRect));
   }
   
-  NSRectFill(origRect);
-  NSRectFill(destRect);
-  NSBezierPath *path = [NSBezierPath bezierPath];
-  [path moveToPoint:joinP1];
-  [path lineToPoint:joinP2];
-  [path lineToPoint:joinP3];
-  [path lineToPoint:joinP4];
-  [path closePath];
-  [path fill];
+  /* Large erasures are expensive, so they are done on the raster worker
+   * with plain Quartz instead of AppKit */
+  NSSize scale = self.currentDrawingSurface.backingScaleFactor;
+  [self.currentDrawingSurface enqueueCanvasModificationInRect:NSUnionRect(origRect, destRect) usingBlock:^NSRect(const PTDPixelBuffer *canvas) {
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef ctx = CGBitmapContextCreate(canvas->data, canvas->width, canvas->height, 8, canvas->bytesPerRow, colorSpace, kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    if (!ctx)
+      return NSZeroRect;
+    CGContextScaleCTM(ctx, scale.width, scale.height);
+    CGContextSetBlendMode(ctx, kCGBlendModeClear);
+    
+    CGContextFillRect(ctx, origRect);
+    CGContextFillRect(ctx, destRect);
+    CGContextMoveToPoint(ctx, joinP1.x, joinP1.y);
+    CGContextAddLineToPoint(ctx, joinP2.x, joinP2.y);
+    CGContextAddLineToPoint(ctx, joinP3.x, joinP3.y);
+    CGContextAddLineToPoint(ctx, joinP4.x, joinP4.y);
+    CGContextClosePath(ctx);
+    CGContextFillPath(ctx);
+    
+    CGContextRelease(ctx);
+    return NSUnionRect(origRect, destRect);
+  }];
 }
 
 
@@ -187,22 +197,23 @@ NSString * const PTDEraserToolOptionSizeOptions = @"sizes";
 - (void)updateCursor
 {
   CGFloat size = self.size;
-  PTDCursor *cursor = [[PTDCursor alloc] init];
-  
-  cursor.image = [NSImage
-      imageWithSize:NSMakeSize(size, size)
-      flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
-    NSRect squareRect = NSMakeRect(0.5, 0.5, size-1.0, size-1.0);
-    NSBezierPath *bp = [NSBezierPath bezierPathWithRect:squareRect];
-    [[NSColor whiteColor] setFill];
-    [bp fill];
-    [[NSColor blackColor] setStroke];
-    [bp stroke];
-    return YES;
+  self.cursor = [PTDCursor cachedCursorWithKey:@[@"eraser", @(size)] generator:^PTDCursor *{
+    PTDCursor *cursor = [[PTDCursor alloc] init];
+    
+    cursor.image = [NSImage
+        imageWithSize:NSMakeSize(size, size)
+        flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+      NSRect squareRect = NSMakeRect(0.5, 0.5, size-1.0, size-1.0);
+      NSBezierPath *bp = [NSBezierPath bezierPathWithRect:squareRect];
+      [[NSColor whiteColor] setFill];
+      [bp fill];
+      [[NSColor blackColor] setStroke];
+      [bp stroke];
+      return YES;
+    }];
+    cursor.hotspot = NSMakePoint(size/2, size/2);
+    return cursor;
   }];
-  cursor.hotspot = NSMakePoint(size/2, size/2);
-  
-  self.cursor = cursor;
 }
 
 
@@ -0,0 +1,518 @@
+//
+// PTDFloodFill.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <stdlib.h>
+#include <string.h>
+#include "PTDFloodFill.h"
+#include "PTDBufferPool.h"
+
+
+/* The fill works on bitmaps with one bit per pixel, bit i of word k of a
+ * row being pixel 64k + i, and the rows padded with zeros to whole words:
+ * the pixels within the tolerance, computed the first time the fill
+ * reaches each row, and the pixels filled so far. */
+typedef struct {
+  const PTDPixelBuffer *canvas;
+  uint8_t reference[4];
+  uint32_t reference32;
+  int tolerance;
+  /* range of each channel within the tolerance, one channel every 16 bits */
+  uint64_t low, high;
+  
+  size_t words;
+  uint64_t *fillable;
+  uint64_t *filled;
+  uint8_t *rowReady;
+  size_t minX, minY, maxX, maxY;
+  
+  size_t *stack;
+  size_t stackSize;
+  size_t stackCapacity;
+} PTDFloodFillState;
+
+static const uint64_t _AllBits = ~(uint64_t)0;
+static const uint64_t _LaneCarry = 0x0100010001000100ULL;
+
+
+static inline unsigned PTDCountTrailingZeros(uint64_t v)
+{
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctzll(v);
+#else
+  unsigned n = 0;
+  for (; !(v & 1); v >>= 1)
+    n++;
+  return n;
+#endif
+}
+
+
+static inline unsigned PTDCountLeadingZeros(uint64_t v)
+{
+#if defined(__GNUC__)
+  return (unsigned)__builtin_clzll(v);
+#else
+  unsigned n = 0;
+  for (; !(v >> 63); v <<= 1)
+    n++;
+  return n;
+#endif
+}
+
+
+static inline int PTDPixelDistance(const uint8_t *p, const uint8_t *ref)
+{
+  int d = abs(p[0] - ref[0]);
+  int d1 = abs(p[1] - ref[1]);
+  int d2 = abs(p[2] - ref[2]);
+  int d3 = abs(p[3] - ref[3]);
+  d = d1 > d ? d1 : d;
+  d = d2 > d ? d2 : d;
+  return d3 > d ? d3 : d;
+}
+
+
+/* Moves the four bytes of a pixel to 16 bit lanes, so that they can be
+ * compared with a single subtraction without borrowing from each other */
+static inline uint64_t PTDSpreadPixel(uint32_t v)
+{
+  uint64_t x = v;
+  x = (x | x << 16) & 0x0000FFFF0000FFFFULL;
+  return (x | x << 8) & 0x00FF00FF00FF00FFULL;
+}
+
+
+static inline uint64_t PTDRowEndMask(size_t width)
+{
+  return width % 64 ? ~(_AllBits << (width % 64)) : _AllBits;
+}
+
+
+static inline uint64_t PTDFloodFillPixelMatches(const PTDFloodFillState *s, const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, 4);
+  uint64_t lanes = PTDSpreadPixel(v);
+  uint64_t match = ((lanes | _LaneCarry) - s->low) & ((s->high | _LaneCarry) - lanes) & _LaneCarry;
+  return match == _LaneCarry;
+}
+
+
+static void PTDFloodFillComputeRow(PTDFloodFillState *s, size_t y)
+{
+  size_t w = s->canvas->width;
+  const uint8_t *p = s->canvas->data + y * s->canvas->bytesPerRow;
+  uint64_t *out = s->fillable + y * s->words;
+  uint64_t reference64 = (uint64_t)s->reference32 * 0x100000001ULL;
+  for (size_t k = 0; k < s->words; k++) {
+    size_t n = w - k * 64 < 64 ? w - k * 64 : 64;
+    /* most of a canvas is usually exactly the color of the seed */
+    uint64_t differ = n < 64;
+    for (size_t i = 0; i < 256 && !differ; i += 32) {
+      uint64_t q[4];
+      memcpy(q, p + i, 32);
+      differ = (q[0] ^ reference64) | (q[1] ^ reference64) | (q[2] ^ reference64) | (q[3] ^ reference64);
+    }
+    if (!differ) {
+      out[k] = _AllBits;
+      p += 256;
+      continue;
+    }
+    
+    uint64_t bits = 0;
+    size_t i = 0;
+    /* two pixels at a time, which keeps the chain of ors short */
+    for (; i + 2 <= n; i += 2, p += 8)
+      bits |= (PTDFloodFillPixelMatches(s, p) | PTDFloodFillPixelMatches(s, p + 4) << 1) << i;
+    if (i < n) {
+      bits |= PTDFloodFillPixelMatches(s, p) << i;
+      p += 4;
+    }
+    out[k] = bits;
+  }
+}
+
+
+static inline void PTDFloodFillPrepareRow(PTDFloodFillState *s, size_t y)
+{
+  if (s->rowReady[y])
+    return;
+  s->rowReady[y] = 1;
+  PTDFloodFillComputeRow(s, y);
+}
+
+
+/* Returns the first pixel in [x, end) which is available to the fill
+ * (fillable and not filled yet) if available is set, or which is not
+ * available otherwise, or end. */
+static inline size_t PTDFloodFillFindForward(const uint64_t *fillable, const uint64_t *filled, size_t x, size_t end, int available)
+{
+  uint64_t flip = available ? 0 : _AllBits;
+  size_t k = x / 64;
+  uint64_t v = ((fillable[k] & ~filled[k]) ^ flip) & (_AllBits << (x % 64));
+  while (!v) {
+    k++;
+    if (k * 64 >= end)
+      return end;
+    v = (fillable[k] & ~filled[k]) ^ flip;
+  }
+  x = k * 64 + PTDCountTrailingZeros(v);
+  return x < end ? x : end;
+}
+
+
+/* Returns the first pixel of the run of available pixels containing x */
+static inline size_t PTDFloodFillRunStart(const uint64_t *fillable, const uint64_t *filled, size_t x)
+{
+  size_t k = x / 64;
+  uint64_t v = ~(fillable[k] & ~filled[k]) & (_AllBits >> (63 - x % 64));
+  while (!v) {
+    if (k == 0)
+      return 0;
+    k--;
+    v = ~(fillable[k] & ~filled[k]);
+  }
+  return k * 64 + 64 - PTDCountLeadingZeros(v);
+}
+
+
+/* Sets the bits of the pixels in [x0, x1) */
+static void PTDBitRowSet(uint64_t *row, size_t x0, size_t x1)
+{
+  size_t k0 = x0 / 64, k1 = (x1 - 1) / 64;
+  uint64_t first = _AllBits << (x0 % 64);
+  uint64_t last = _AllBits >> (63 - (x1 - 1) % 64);
+  if (k0 == k1) {
+    row[k0] |= first & last;
+    return;
+  }
+  row[k0] |= first;
+  for (size_t k = k0 + 1; k < k1; k++)
+    row[k] = _AllBits;
+  row[k1] |= last;
+}
+
+
+static inline int PTDFloodFillPush(PTDFloodFillState *s, size_t x, size_t y)
+{
+  if (s->stackSize + 2 > s->stackCapacity) {
+    size_t newCapacity = s->stackCapacity ? s->stackCapacity * 2 : 1024;
+    size_t *newStack = realloc(s->stack, newCapacity * sizeof(size_t));
+    if (!newStack)
+      return 0;
+    s->stack = newStack;
+    s->stackCapacity = newCapacity;
+  }
+  s->stack[s->stackSize++] = x;
+  s->stack[s->stackSize++] = y;
+  return 1;
+}
+
+
+/* Scanline fill: every popped seed is extended to a whole horizontal span,
+ * and the rows above and below only get one seed per run of fillable
+ * pixels touching the span. */
+static int PTDFloodFillSpans(PTDFloodFillState *s, size_t seedX, size_t seedY)
+{
+  size_t w = s->canvas->width, h = s->canvas->height;
+  PTDFloodFillPrepareRow(s, seedY);
+  if (!PTDFloodFillPush(s, seedX, seedY))
+    return 0;
+  
+  while (s->stackSize > 0) {
+    size_t y = s->stack[--s->stackSize];
+    size_t x = s->stack[--s->stackSize];
+    const uint64_t *fillable = s->fillable + y * s->words;
+    uint64_t *filled = s->filled + y * s->words;
+    if (!((fillable[x / 64] & ~filled[x / 64]) >> (x % 64) & 1))
+      continue;
+    
+    size_t l = PTDFloodFillRunStart(fillable, filled, x);
+    size_t r = PTDFloodFillFindForward(fillable, filled, x, w, 0);
+    PTDBitRowSet(filled, l, r);
+    
+    if (l < s->minX) s->minX = l;
+    if (r - 1 > s->maxX) s->maxX = r - 1;
+    if (y < s->minY) s->minY = y;
+    if (y > s->maxY) s->maxY = y;
+    
+    for (int dy = -1; dy <= 1; dy += 2) {
+      if ((dy < 0 && y == 0) || (dy > 0 && y + 1 >= h))
+        continue;
+      size_t ny = y + dy;
+      PTDFloodFillPrepareRow(s, ny);
+      const uint64_t *nfillable = s->fillable + ny * s->words;
+      const uint64_t *nfilled = s->filled + ny * s->words;
+      size_t nx = l;
+      while (nx < r) {
+        nx = PTDFloodFillFindForward(nfillable, nfilled, nx, r, 1);
+        if (nx >= r)
+          break;
+        if (!PTDFloodFillPush(s, nx, ny))
+          return 0;
+        nx = PTDFloodFillFindForward(nfillable, nfilled, nx, r, 0);
+      }
+    }
+  }
+  return 1;
+}
+
+
+/* Square dilation of a bitmap by the given radius. The radius grows by up
+ * to twice its current size at every step, by or-ing the bitmap with
+ * itself moved both ways, which is done in place as two passes running in
+ * opposite directions. */
+static void PTDBitmapDilate(uint64_t *bits, size_t words, size_t width, size_t height, size_t radius)
+{
+  uint64_t endMask = PTDRowEndMask(width);
+  
+  for (size_t y = 0; y < height; y++) {
+    uint64_t *row = bits + y * words;
+    for (size_t m = 0; m < radius; ) {
+      size_t step = 2 * m + 1 < radius - m ? 2 * m + 1 : radius - m;
+      size_t ws = step / 64, bs = step % 64;
+      /* row[x] |= row[x - step] */
+      for (size_t k = words; k-- > ws; ) {
+        uint64_t v = row[k - ws] << bs;
+        if (bs && k > ws)
+          v |= row[k - ws - 1] >> (64 - bs);
+        row[k] |= v;
+      }
+      row[words - 1] &= endMask;
+      /* row[x] |= row[x + step] */
+      for (size_t k = 0; k + ws < words; k++) {
+        uint64_t v = row[k + ws] >> bs;
+        if (bs && k + ws + 1 < words)
+          v |= row[k + ws + 1] << (64 - bs);
+        row[k] |= v;
+      }
+      m += step;
+    }
+  }
+  
+  for (size_t m = 0; m < radius; ) {
+    size_t step = 2 * m + 1 < radius - m ? 2 * m + 1 : radius - m;
+    for (size_t y = height; y-- > step; ) {
+      uint64_t *row = bits + y * words;
+      const uint64_t *src = row - step * words;
+      for (size_t k = 0; k < words; k++)
+        row[k] |= src[k];
+    }
+    for (size_t y = 0; y + step < height; y++) {
+      uint64_t *row = bits + y * words;
+      const uint64_t *src = row + step * words;
+      for (size_t k = 0; k < words; k++)
+        row[k] |= src[k];
+    }
+    m += step;
+  }
+}
+
+
+/* Fills the region after growing the border of the region to close the
+ * gaps, then grows the region back up to the original border. */
+static int PTDFloodFillClosingGaps(PTDFloodFillState *s, size_t seedX, size_t seedY, size_t gap)
+{
+  size_t w = s->canvas->width, h = s->canvas->height;
+  size_t words = s->words, size = words * h * sizeof(uint64_t);
+  size_t r = (gap + 1) / 2;
+  uint64_t *closed = PTDBufferPoolAlloc(size);
+  if (!closed)
+    return 0;
+  
+  for (size_t y = 0; y < h; y++)
+    PTDFloodFillPrepareRow(s, y);
+  uint64_t endMask = PTDRowEndMask(w);
+  for (size_t i = 0; i < words * h; i++) {
+    closed[i] = ~s->fillable[i];
+    if (i % words == words - 1)
+      closed[i] &= endMask;
+  }
+  PTDBitmapDilate(closed, words, w, h, r);
+  for (size_t i = 0; i < words * h; i++)
+    closed[i] = s->fillable[i] & ~closed[i];
+  
+  if (!(closed[seedY * words + seedX / 64] >> (seedX % 64) & 1)) {
+    /* the seed is inside a gap; fill without closing */
+    PTDBufferPoolFree(closed, size);
+    return PTDFloodFillSpans(s, seedX, seedY);
+  }
+  
+  uint64_t *original = s->fillable;
+  s->fillable = closed;
+  int success = PTDFloodFillSpans(s, seedX, seedY);
+  s->fillable = original;
+  PTDBufferPoolFree(closed, size);
+  if (!success)
+    return 0;
+  
+  PTDBitmapDilate(s->filled, words, w, h, r);
+  s->minX = s->minY = SIZE_MAX;
+  s->maxX = s->maxY = 0;
+  for (size_t y = 0; y < h; y++) {
+    uint64_t *row = s->filled + y * words;
+    const uint64_t *fillable = original + y * words;
+    for (size_t k = 0; k < words; k++) {
+      row[k] &= fillable[k];
+      if (!row[k])
+        continue;
+      size_t x0 = k * 64 + PTDCountTrailingZeros(row[k]);
+      size_t x1 = k * 64 + 63 - PTDCountLeadingZeros(row[k]);
+      if (x0 < s->minX) s->minX = x0;
+      if (x1 > s->maxX) s->maxX = x1;
+      if (y < s->minY) s->minY = y;
+      s->maxY = y;
+    }
+  }
+  return 1;
+}
+
+
+/* The bits of 8 pixels starting at x, as 8 bytes of 0 or 255 in memory order */
+static inline uint64_t PTDExpandBits(const uint64_t *row, size_t words, size_t x)
+{
+  size_t k = x / 64, b = x % 64;
+  uint64_t v = row[k] >> b;
+  if (b > 56 && k + 1 < words)
+    v |= row[k + 1] << (64 - b);
+  v &= 0xFF;
+  v = (v | v << 28) & 0x0000000F0000000FULL;
+  v = (v | v << 14) & 0x0003000300030003ULL;
+  v = (v | v << 7) & 0x0101010101010101ULL;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v * 0xFF;
+}
+
+
+static int PTDFloodFillBuildMask(const PTDFloodFillState *s, int antialias, PTDSelectionMask *mask)
+{
+  size_t w = s->canvas->width, h = s->canvas->height, words = s->words;
+  size_t border = antialias ? 1 : 0;
+  size_t x0 = s->minX >= border ? s->minX - border : 0;
+  size_t y0 = s->minY >= border ? s->minY - border : 0;
+  size_t x1 = s->maxX + border + 1 < w ? s->maxX + border + 1 : w;
+  size_t y1 = s->maxY + border + 1 < h ? s->maxY + border + 1 : h;
+  if (!PTDSelectionMaskInit(mask, (long)x0, (long)y0, x1 - x0, y1 - y0))
+    return 0;
+  
+  uint64_t endMask = PTDRowEndMask(w);
+  uint32_t lastPixel = s->reference32;
+  uint8_t lastCoverage = 0;
+  for (size_t y = y0; y < y1; y++) {
+    const uint64_t *f = s->filled + y * words;
+    uint8_t *m = mask->coverage + (y - y0) * mask->width - x0;
+    size_t x = x0;
+    for (; x + 8 <= x1; x += 8) {
+      uint64_t bytes = PTDExpandBits(f, words, x);
+      memcpy(m + x, &bytes, 8);
+    }
+    for (; x < x1; x++)
+      m[x] = (uint8_t)-(f[x / 64] >> (x % 64) & 1);
+    if (!border)
+      continue;
+    
+    /* antialiased border pixels, next to the region but not in it, get a
+     * coverage proportional to their similarity to the region */
+    const uint64_t *above = y > 0 ? f - words : NULL;
+    const uint64_t *below = y + 1 < h ? f + words : NULL;
+    for (size_t k = x0 / 64; k * 64 < x1; k++) {
+      uint64_t near = f[k] << 1 | f[k] >> 1;
+      if (k > 0)
+        near |= f[k - 1] >> 63;
+      if (k + 1 < words)
+        near |= f[k + 1] << 63;
+      if (above)
+        near |= above[k];
+      if (below)
+        near |= below[k];
+      near &= ~f[k];
+      if (k + 1 == words)
+        near &= endMask;
+      for (; near; near &= near - 1) {
+        size_t x = k * 64 + PTDCountTrailingZeros(near);
+        const uint8_t *p = s->canvas->data + y * s->canvas->bytesPerRow + x * 4;
+        uint32_t v;
+        memcpy(&v, p, 4);
+        /* the border is usually a stroke of a single color */
+        if (v != lastPixel) {
+          int d = PTDPixelDistance(p, s->reference);
+          lastPixel = v;
+          lastCoverage = d > s->tolerance && s->tolerance < 255 ? (uint8_t)((255 - d) * 255 / (255 - s->tolerance)) : 0;
+        }
+        m[x] = lastCoverage;
+      }
+    }
+  }
+  return 1;
+}
+
+
+int PTDFloodFill(const PTDPixelBuffer *canvas, size_t seedX, size_t seedY, const PTDFloodFillOptions *options, PTDSelectionMask *mask)
+{
+  PTDSelectionMaskInit(mask, 0, 0, 0, 0);
+  if (seedX >= canvas->width || seedY >= canvas->height)
+    return 1;
+  
+  PTDFloodFillState s = {0};
+  s.canvas = canvas;
+  memcpy(s.reference, canvas->data + seedY * canvas->bytesPerRow + seedX * 4, 4);
+  memcpy(&s.reference32, s.reference, 4);
+  s.tolerance = options->tolerance;
+  uint8_t low[4], high[4];
+  for (int c = 0; c < 4; c++) {
+    low[c] = s.reference[c] > s.tolerance ? s.reference[c] - s.tolerance : 0;
+    high[c] = s.reference[c] + s.tolerance < 255 ? s.reference[c] + s.tolerance : 255;
+  }
+  uint32_t low32, high32;
+  memcpy(&low32, low, 4);
+  memcpy(&high32, high, 4);
+  s.low = PTDSpreadPixel(low32);
+  s.high = PTDSpreadPixel(high32);
+  s.minX = s.minY = SIZE_MAX;
+  
+  s.words = (canvas->width + 63) / 64;
+  size_t size = s.words * canvas->height * sizeof(uint64_t);
+  s.fillable = PTDBufferPoolAlloc(size);
+  s.filled = PTDBufferPoolAlloc(size);
+  s.rowReady = calloc(canvas->height, 1);
+  
+  int success = s.fillable && s.filled && s.rowReady;
+  if (success) {
+    memset(s.filled, 0, size);
+    if (options->gapSize > 0)
+      success = PTDFloodFillClosingGaps(&s, seedX, seedY, options->gapSize);
+    else
+      success = PTDFloodFillSpans(&s, seedX, seedY);
+  }
+  if (success)
+    success = PTDFloodFillBuildMask(&s, options->antialias, mask);
+  
+  PTDBufferPoolFree(s.fillable, size);
+  PTDBufferPoolFree(s.filled, size);
+  free(s.rowReady);
+  free(s.stack);
+  return success;
+}
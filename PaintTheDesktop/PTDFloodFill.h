@@ -0,0 +1,54 @@
+//
+// PTDFloodFill.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDFloodFill_h
+#define PTDFloodFill_h
+
+#include "PTDSelectionMask.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  /* maximum difference of each premultiplied channel from the seed pixel */
+  uint8_t tolerance;
+  /* gaps in the border of the region up to this width (in pixels) do not
+   * let the fill leak out */
+  unsigned gapSize;
+  /* also partially cover the antialiased pixels around the region */
+  int antialias;
+} PTDFloodFillOptions;
+
+/* Computes the mask of the region of similar pixels connected to the seed
+ * pixel. The mask only covers the bounding box of the region. Returns 0 on
+ * failure; a seed outside the canvas produces a successful empty mask. */
+int PTDFloodFill(const PTDPixelBuffer *canvas, size_t seedX, size_t seedY, const PTDFloodFillOptions *options, PTDSelectionMask *mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDFloodFill_h */
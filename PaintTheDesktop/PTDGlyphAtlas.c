@@ -0,0 +1,263 @@
+//
+// PTDGlyphAtlas.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "PTDGlyphAtlas.h"
+
+
+typedef struct {
+  size_t y;
+  size_t height;
+  size_t x;
+} PTDGlyphAtlasShelf;
+
+struct PTDGlyphAtlas {
+  uint8_t *coverage;
+  size_t width;
+  size_t height;
+  
+  PTDGlyphAtlasShelf *shelves;
+  size_t shelfCount;
+  size_t shelfCapacity;
+  size_t nextShelfY;
+  
+  PTDGlyphAtlasEntry *entries;
+  uint64_t *keys;
+  size_t count;
+  size_t capacity;
+  /* open addressing hash table of entry indexes plus one; zero is empty */
+  uint32_t *table;
+  size_t tableSize;
+};
+
+
+PTDGlyphAtlas *PTDGlyphAtlasCreate(size_t width, size_t height)
+{
+  /* entries store positions in 16 bits */
+  if (width == 0 || height == 0 || width > UINT16_MAX || height > UINT16_MAX)
+    return NULL;
+  PTDGlyphAtlas *atlas = calloc(1, sizeof(PTDGlyphAtlas));
+  if (!atlas)
+    return NULL;
+  atlas->width = width;
+  atlas->height = height;
+  atlas->coverage = calloc(width * height, 1);
+  if (!atlas->coverage) {
+    free(atlas);
+    return NULL;
+  }
+  return atlas;
+}
+
+
+void PTDGlyphAtlasDestroy(PTDGlyphAtlas *atlas)
+{
+  if (!atlas)
+    return;
+  free(atlas->coverage);
+  free(atlas->shelves);
+  free(atlas->entries);
+  free(atlas->keys);
+  free(atlas->table);
+  free(atlas);
+}
+
+
+void PTDGlyphAtlasClear(PTDGlyphAtlas *atlas)
+{
+  /* only the rows used by the shelves are dirty */
+  memset(atlas->coverage, 0, atlas->nextShelfY * atlas->width);
+  atlas->shelfCount = 0;
+  atlas->nextShelfY = 0;
+  atlas->count = 0;
+  if (atlas->table)
+    memset(atlas->table, 0, atlas->tableSize * sizeof(uint32_t));
+}
+
+
+static size_t PTDGlyphAtlasHash(uint64_t key, size_t tableSize)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (size_t)key & (tableSize - 1);
+}
+
+
+const PTDGlyphAtlasEntry *PTDGlyphAtlasLookup(const PTDGlyphAtlas *atlas, uint64_t key)
+{
+  if (!atlas->table)
+    return NULL;
+  for (size_t i = PTDGlyphAtlasHash(key, atlas->tableSize); atlas->table[i]; i = (i + 1) & (atlas->tableSize - 1)) {
+    uint32_t index = atlas->table[i] - 1;
+    if (atlas->keys[index] == key)
+      return &atlas->entries[index];
+  }
+  return NULL;
+}
+
+
+static int PTDGlyphAtlasReserveEntry(PTDGlyphAtlas *atlas)
+{
+  if (atlas->count < atlas->capacity)
+    return 1;
+  
+  size_t capacity = atlas->capacity ? atlas->capacity * 2 : 256;
+  PTDGlyphAtlasEntry *entries = realloc(atlas->entries, capacity * sizeof(PTDGlyphAtlasEntry));
+  if (!entries)
+    return 0;
+  atlas->entries = entries;
+  uint64_t *keys = realloc(atlas->keys, capacity * sizeof(uint64_t));
+  if (!keys)
+    return 0;
+  atlas->keys = keys;
+  atlas->capacity = capacity;
+  
+  /* keep the load factor of the table at most 1/2 */
+  size_t tableSize = capacity * 2;
+  uint32_t *table = calloc(tableSize, sizeof(uint32_t));
+  if (!table)
+    return 0;
+  for (size_t index = 0; index < atlas->count; index++) {
+    size_t i = PTDGlyphAtlasHash(atlas->keys[index], tableSize);
+    while (table[i])
+      i = (i + 1) & (tableSize - 1);
+    table[i] = (uint32_t)index + 1;
+  }
+  free(atlas->table);
+  atlas->table = table;
+  atlas->tableSize = tableSize;
+  return 1;
+}
+
+
+static PTDGlyphAtlasShelf *PTDGlyphAtlasFindShelf(PTDGlyphAtlas *atlas, size_t width, size_t height)
+{
+  /* the shortest shelf the glyph fits in, but not one so tall that most of
+   * its height would be wasted */
+  PTDGlyphAtlasShelf *best = NULL;
+  for (size_t i = 0; i < atlas->shelfCount; i++) {
+    PTDGlyphAtlasShelf *shelf = &atlas->shelves[i];
+    if (shelf->height < height || shelf->height > height + height / 2 + 2)
+      continue;
+    if (shelf->x + width > atlas->width)
+      continue;
+    if (!best || shelf->height < best->height)
+      best = shelf;
+  }
+  if (best)
+    return best;
+  
+  if (atlas->nextShelfY + height > atlas->height)
+    return NULL;
+  if (atlas->shelfCount == atlas->shelfCapacity) {
+    size_t capacity = atlas->shelfCapacity ? atlas->shelfCapacity * 2 : 32;
+    PTDGlyphAtlasShelf *shelves = realloc(atlas->shelves, capacity * sizeof(PTDGlyphAtlasShelf));
+    if (!shelves)
+      return NULL;
+    atlas->shelves = shelves;
+    atlas->shelfCapacity = capacity;
+  }
+  PTDGlyphAtlasShelf *shelf = &atlas->shelves[atlas->shelfCount++];
+  shelf->y = atlas->nextShelfY;
+  shelf->height = height;
+  shelf->x = 0;
+  atlas->nextShelfY += height;
+  return shelf;
+}
+
+
+const PTDGlyphAtlasEntry *PTDGlyphAtlasInsert(PTDGlyphAtlas *atlas, uint64_t key, size_t width, size_t height, int left, int top, uint8_t **coverage, size_t *bytesPerRow)
+{
+  if (width > atlas->width || height > atlas->height)
+    return NULL;
+  if (left < INT16_MIN || left > INT16_MAX || top < INT16_MIN || top > INT16_MAX)
+    return NULL;
+  if (!PTDGlyphAtlasReserveEntry(atlas))
+    return NULL;
+  
+  /* empty glyphs (spaces) still get an entry to avoid rendering them again */
+  size_t x = 0, y = 0;
+  if (width > 0 && height > 0) {
+    PTDGlyphAtlasShelf *shelf = PTDGlyphAtlasFindShelf(atlas, width, height);
+    if (!shelf)
+      return NULL;
+    x = shelf->x;
+    y = shelf->y;
+    shelf->x += width;
+  }
+  
+  size_t index = atlas->count++;
+  PTDGlyphAtlasEntry *entry = &atlas->entries[index];
+  *entry = (PTDGlyphAtlasEntry){
+      (uint16_t)x, (uint16_t)y, (uint16_t)width, (uint16_t)height,
+      (int16_t)left, (int16_t)top};
+  atlas->keys[index] = key;
+  size_t i = PTDGlyphAtlasHash(key, atlas->tableSize);
+  while (atlas->table[i])
+    i = (i + 1) & (atlas->tableSize - 1);
+  atlas->table[i] = (uint32_t)index + 1;
+  
+  *coverage = atlas->coverage + y * atlas->width + x;
+  *bytesPerRow = atlas->width;
+  return entry;
+}
+
+
+void PTDGlyphAtlasComposite(const PTDGlyphAtlas *atlas, const PTDGlyphAtlasEntry *entry, const PTDPixelBuffer *canvas, long x, long y, const uint8_t color[4])
+{
+  long gx = x + entry->left;
+  long gy = y - entry->top;
+  long x0 = gx < 0 ? -gx : 0;
+  long y0 = gy < 0 ? -gy : 0;
+  long x1 = entry->width, y1 = entry->height;
+  if (gx + x1 > (long)canvas->width)
+    x1 = (long)canvas->width - gx;
+  if (gy + y1 > (long)canvas->height)
+    y1 = (long)canvas->height - gy;
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  
+  for (long row = y0; row < y1; row++) {
+    const uint8_t *m = atlas->coverage + (entry->y + row) * atlas->width + entry->x;
+    uint8_t *px = canvas->data + (size_t)(gy + row) * canvas->bytesPerRow + (size_t)gx * 4;
+    for (long col = x0; col < x1; col++) {
+      if (m[col] == 0)
+        continue;
+      /* source over with the color scaled by the coverage */
+      uint8_t *p = px + col * 4;
+      unsigned sa = color[3] * m[col] + 128;
+      sa = (sa + (sa >> 8)) >> 8;
+      for (int c = 0; c < 4; c++) {
+        unsigned s = color[c] * m[col] + 128;
+        s = (s + (s >> 8)) >> 8;
+        unsigned d = p[c] * (255 - sa) + 128;
+        d = (d + (d >> 8)) >> 8;
+        p[c] = (uint8_t)(s + d);
+      }
+    }
+  }
+}
@@ -0,0 +1,71 @@
+//
+// PTDGlyphAtlas.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDGlyphAtlas_h
+#define PTDGlyphAtlas_h
+
+#include "PTDResampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Location of a glyph coverage mask in the atlas. The offsets are from the
+ * pen position to the top left pixel of the mask, with top growing
+ * upwards like in the font coordinate system. */
+typedef struct {
+  uint16_t x, y;
+  uint16_t width, height;
+  int16_t left, top;
+} PTDGlyphAtlasEntry;
+
+/* 8 bit coverage masks packed in shelves into a single bitmap, looked up by
+ * a key which identifies the glyph, its font and its rendering parameters. */
+typedef struct PTDGlyphAtlas PTDGlyphAtlas;
+
+PTDGlyphAtlas *PTDGlyphAtlasCreate(size_t width, size_t height);
+void PTDGlyphAtlasDestroy(PTDGlyphAtlas *atlas);
+
+/* Removes all glyphs */
+void PTDGlyphAtlasClear(PTDGlyphAtlas *atlas);
+
+/* Returned entries are valid until the next insertion or clear. */
+const PTDGlyphAtlasEntry *PTDGlyphAtlasLookup(const PTDGlyphAtlas *atlas, uint64_t key);
+
+/* Reserves space for a new glyph and returns its entry. The caller renders
+ * the glyph in the zero-filled area pointed to by coverage, whose rows are
+ * bytesPerRow bytes apart. Returns NULL if the atlas is full, or if the
+ * glyph is too big for it. */
+const PTDGlyphAtlasEntry *PTDGlyphAtlasInsert(PTDGlyphAtlas *atlas, uint64_t key, size_t width, size_t height, int left, int top, uint8_t **coverage, size_t *bytesPerRow);
+
+/* Composites a glyph with the given premultiplied color over the canvas,
+ * with the pen at canvas pixel (x, y). */
+void PTDGlyphAtlasComposite(const PTDGlyphAtlas *atlas, const PTDGlyphAtlasEntry *entry, const PTDPixelBuffer *canvas, long x, long y, const uint8_t color[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDGlyphAtlas_h */
@@ -0,0 +1,44 @@
+//
+// PTDImageClipboard.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Puts images on a pasteboard without encoding them upfront. Other apps
+ * receive PNG or TIFF data encoded on demand, while pasting in this app
+ * gets back the original bitmap as long as the pasteboard did not change
+ * in the meantime. */
+@interface PTDImageClipboard : NSObject
+
++ (void)writeImageRep:(NSBitmapImageRep *)imageRep toPasteboard:(NSPasteboard *)pasteboard;
+
+/* The bitmap last written to the pasteboard by this class, if it is still
+ * the current contents of the pasteboard. The bitmap must not be modified. */
++ (nullable NSBitmapImageRep *)imageRepFromPasteboard:(NSPasteboard *)pasteboard;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,122 @@
+//
+// PTDImageClipboard.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDImageClipboard.h"
+
+
+@interface PTDImageClipboardContents: NSObject <NSPasteboardItemDataProvider>
+
+- (instancetype)initWithImageRep:(NSBitmapImageRep *)imageRep;
+
+@property (nonatomic, readonly) NSBitmapImageRep *imageRep;
+@property (nonatomic) NSPasteboardName pasteboardName;
+@property (nonatomic) NSInteger changeCount;
+
+@end
+
+
+@implementation PTDImageClipboardContents {
+  NSData *_pngData;
+  NSData *_tiffData;
+}
+
+
+- (instancetype)initWithImageRep:(NSBitmapImageRep *)imageRep
+{
+  self = [super init];
+  _imageRep = imageRep;
+  return self;
+}
+
+
+- (nullable NSData *)dataForType:(NSPasteboardType)type
+{
+  /* Each type is encoded only once it is asked for, and only once. The
+   * encoders read the same bitmap, so they never run at the same time, even
+   * if the pasteboard calls the provider from more than one thread. */
+  @synchronized (self) {
+    if ([type isEqual:NSPasteboardTypePNG]) {
+      if (!_pngData)
+        _pngData = [_imageRep representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
+      return _pngData;
+    } else if ([type isEqual:NSPasteboardTypeTIFF]) {
+      if (!_tiffData)
+        _tiffData = _imageRep.TIFFRepresentation;
+      return _tiffData;
+    }
+  }
+  return nil;
+}
+
+
+- (void)pasteboard:(nullable NSPasteboard *)pasteboard item:(NSPasteboardItem *)item provideDataForType:(NSPasteboardType)type
+{
+  NSData *data = [self dataForType:type];
+  if (!data) {
+    NSLog(@"warning: could not encode the clipboard image as %@", type);
+    return;
+  }
+  [item setData:data forType:type];
+}
+
+
+@end
+
+
+@implementation PTDImageClipboard
+
+
+static PTDImageClipboardContents *_lastContents;
+
+
++ (void)writeImageRep:(NSBitmapImageRep *)imageRep toPasteboard:(NSPasteboard *)pasteboard
+{
+  PTDImageClipboardContents *contents = [[PTDImageClipboardContents alloc] initWithImageRep:imageRep];
+  NSPasteboardItem *item = [[NSPasteboardItem alloc] init];
+  [item setDataProvider:contents forTypes:@[NSPasteboardTypePNG, NSPasteboardTypeTIFF]];
+  
+  [pasteboard clearContents];
+  if (![pasteboard writeObjects:@[item]]) {
+    NSLog(@"warning: could not write the image to the pasteboard");
+    return;
+  }
+  contents.pasteboardName = pasteboard.name;
+  contents.changeCount = pasteboard.changeCount;
+  /* the pasteboard item does not keep its data provider alive */
+  _lastContents = contents;
+}
+
+
++ (nullable NSBitmapImageRep *)imageRepFromPasteboard:(NSPasteboard *)pasteboard
+{
+  if (![_lastContents.pasteboardName isEqual:pasteboard.name])
+    return nil;
+  if (_lastContents.changeCount != pasteboard.changeCount)
+    return nil;
+  return _lastContents.imageRep;
+}
+
+
+@end
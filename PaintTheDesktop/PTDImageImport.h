@@ -0,0 +1,54 @@
+//
+// PTDImageImport.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Decodes raster images away from the main thread. The image is downsampled
+ * while it is being decoded, so the memory used depends on the requested
+ * size rather than on the size of the source. */
+@interface PTDImageImport : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/* Return nil for data which is not a raster image (for example a PDF). Only
+ * the header of the image is read at this point. */
+- (nullable instancetype)initWithContentsOfURL:(NSURL *)url;
+- (nullable instancetype)initWithData:(NSData *)data;
+
+/* Size of the image as it will be displayed, taking into account its
+ * orientation. The size in points derives from the resolution of the image. */
+@property (nonatomic, readonly) NSSize pixelSize;
+@property (nonatomic, readonly) NSSize size;
+
+/* Decodes the image scaled down to fit the given pixel size, keeping its
+ * aspect ratio. Images smaller than that size are not scaled up. The handler
+ * is called on the main queue, with nil if the image could not be decoded. */
+- (void)decodeImageFittingPixelSize:(NSSize)maxSize completionHandler:(void (^)(NSBitmapImageRep * _Nullable image))handler;
+
+@end
+
+NS_ASSUME_NONNULL_END
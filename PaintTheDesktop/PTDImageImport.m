@@ -0,0 +1,122 @@
+//
+// PTDImageImport.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import <ImageIO/ImageIO.h>
+#import "PTDImageImport.h"
+#import "PTDBlockTask.h"
+
+
+@implementation PTDImageImport {
+  CGImageSourceRef _source;
+}
+
+
+- (nullable instancetype)initWithContentsOfURL:(NSURL *)url
+{
+  NSDictionary *opts = @{(__bridge NSString *)kCGImageSourceShouldCache: @NO};
+  CGImageSourceRef source = CGImageSourceCreateWithURL((__bridge CFURLRef)url, (__bridge CFDictionaryRef)opts);
+  return [self initWithImageSource:source];
+}
+
+
+- (nullable instancetype)initWithData:(NSData *)data
+{
+  NSDictionary *opts = @{(__bridge NSString *)kCGImageSourceShouldCache: @NO};
+  CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, (__bridge CFDictionaryRef)opts);
+  return [self initWithImageSource:source];
+}
+
+
+- (nullable instancetype)initWithImageSource:(nullable CGImageSourceRef)source
+{
+  self = [super init];
+  if (!source)
+    return nil;
+  _source = source;
+  
+  /* vector images are better served by NSImageRep */
+  CFStringRef type = CGImageSourceGetType(source);
+  if (!type || UTTypeConformsTo(type, kUTTypePDF) || CGImageSourceGetCount(source) == 0)
+    return nil;
+  
+  NSDictionary *props = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(source, 0, NULL));
+  CGFloat width = [props[(__bridge NSString *)kCGImagePropertyPixelWidth] doubleValue];
+  CGFloat height = [props[(__bridge NSString *)kCGImagePropertyPixelHeight] doubleValue];
+  if (width < 1 || height < 1)
+    return nil;
+  CGFloat dpiX = [props[(__bridge NSString *)kCGImagePropertyDPIWidth] doubleValue];
+  CGFloat dpiY = [props[(__bridge NSString *)kCGImagePropertyDPIHeight] doubleValue];
+  if (dpiX <= 0 || dpiY <= 0)
+    dpiX = dpiY = 72.0;
+  
+  /* orientations 5 to 8 swap the axes */
+  NSInteger orientation = [props[(__bridge NSString *)kCGImagePropertyOrientation] integerValue];
+  if (orientation >= 5) {
+    CGFloat t = width; width = height; height = t;
+    t = dpiX; dpiX = dpiY; dpiY = t;
+  }
+  _pixelSize = NSMakeSize(width, height);
+  _size = NSMakeSize(round(width * 72.0 / dpiX), round(height * 72.0 / dpiY));
+  return self;
+}
+
+
+- (void)dealloc
+{
+  if (_source)
+    CFRelease(_source);
+}
+
+
+- (void)decodeImageFittingPixelSize:(NSSize)maxSize completionHandler:(void (^)(NSBitmapImageRep * _Nullable image))handler
+{
+  CGFloat scale = MIN(1.0, MIN(maxSize.width / _pixelSize.width, maxSize.height / _pixelSize.height));
+  CGFloat maxPixelSize = ceil(MAX(_pixelSize.width, _pixelSize.height) * scale);
+  NSDictionary *opts = @{
+    (__bridge NSString *)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+    (__bridge NSString *)kCGImageSourceCreateThumbnailWithTransform: @YES,
+    (__bridge NSString *)kCGImageSourceThumbnailMaxPixelSize: @(MAX(maxPixelSize, 1.0)),
+    /* decode here instead of when the image is first drawn */
+    (__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES};
+  
+  PTDBlockTaskSubmit(PTDTaskPriorityInteractive, ^{
+    /* ImageIO scales the image while decoding it, so the image at full size
+     * is never allocated */
+    CGImageRef image = CGImageSourceCreateThumbnailAtIndex(self->_source, 0, (__bridge CFDictionaryRef)opts);
+    NSBitmapImageRep *res;
+    if (image) {
+      res = [[NSBitmapImageRep alloc] initWithCGImage:image];
+      CGImageRelease(image);
+    } else {
+      NSLog(@"warning: could not decode the image");
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+      handler(res);
+    });
+  });
+}
+
+
+@end
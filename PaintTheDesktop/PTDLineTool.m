@@ -31,6 +31,7 @@
 #import "PTDCursor.h"
 #import "PTDGraphics.h"
 #import "NSBezierPath+PTD.h"
+#import "PTDCanvasObject.h"
 
 
 NSString * const PTDToolIdentifierLineTool = @"PTDToolIdentifierLineTool";
@@ -84,23 +85,37 @@ NSString * const PTDToolIdentifierLineTool = @"PTDToolIdentifierLineTool";
 - (void)dragDidEndAtPoint:(NSPoint)point
 {
   [self removeDragIndicator];
-  [self.currentDrawingSurface beginCanvasDrawing];
   NSBezierPath *path = [NSBezierPath bezierPath];
   [path setLineCapStyle:NSLineCapStyleRound];
   [path setLineWidth:self.size];
   [path moveToPoint:_point0];
   [path lineToPoint:_point1];
-  [self.color setStroke];
-  [path stroke];
+  PTDShapeCanvasObject *object = [[PTDShapeCanvasObject alloc] initWithPath:path color:self.color];
+  [self.currentDrawingSurface addCanvasObject:object];
+}
+
+
+- (void)mouseClickedAtPoint:(NSPoint)point
+{
+  /* clicking a shape which was not flattened yet restyles it */
+  PTDCanvasObject *object = [self.currentDrawingSurface canvasObjectAtPoint:point];
+  if (![object isKindOfClass:PTDShapeCanvasObject.class])
+    return;
+  PTDShapeCanvasObject *newObject = [(PTDShapeCanvasObject *)object objectByChangingLineWidth:self.size color:self.color];
+  [self.currentDrawingSurface replaceCanvasObject:object withObject:newObject];
 }
 
 
 - (void)updateCursor
 {
-  PTDCursor *cursor = [[PTDCursor alloc] init];
-  cursor.image = PTDCrosshairImage(self.size, self.color);
-  cursor.hotspot = NSMakePoint(cursor.image.size.width/2.0, cursor.image.size.height/2.0);
-  self.cursor = cursor;
+  CGFloat size = self.size;
+  NSColor *color = self.color;
+  self.cursor = [PTDCursor cachedCursorWithKey:@[@"crosshair", @(size), color] generator:^PTDCursor *{
+    PTDCursor *cursor = [[PTDCursor alloc] init];
+    cursor.image = PTDCrosshairImage(size, color);
+    cursor.hotspot = NSMakePoint(cursor.image.size.width/2.0, cursor.image.size.height/2.0);
+    return cursor;
+  }];
 }
 
 
@@ -52,12 +52,29 @@ NS_ASSUME_NONNULL_BEGIN
 @property (readonly, nonatomic) NSOpenGLContext *openGLContext;
 
 - (NSBitmapImageRep *)bufferAsImageRep;
+/* YES while an image rep returned by -bufferAsImageRep is still alive */
+@property (readonly, nonatomic, getter=isBufferMapped) BOOL bufferMapped;
+/* Read-only access to the buffer which, unlike -bufferAsImageRep, does not
+ * force the texture to be uploaded again on the next bind. */
+- (void)readBufferUsingBlock:(void (^)(const uint8_t *pixels, NSInteger bytesPerRow))block;
 
 - (void)bindBuffer;
 - (void)bindTextureAndBuffer;
+/* Binds the texture without uploading the buffer, which may be mapped, and
+ * updates a rect of it, in pixels, from other memory with the same layout
+ * as the buffer. */
+- (void)bindTextureUpdatingRect:(NSRect)rect fromPixels:(nullable const uint8_t *)pixels bytesPerRow:(NSInteger)bytesPerRow;
 @property (readonly) GLenum bufferUnit;
 @property (readonly) GLenum texUnit;
 
+/* Uploads the pending changes of the buffer and deletes it, keeping only
+ * the texture, which can still be bound with -bindTextureUpdatingRect:...
+ * The buffer must not be mapped, and can not be used afterwards. */
+- (void)releaseBuffer;
+
+/* The memory taken by the buffer, and by the texture once it exists */
+@property (readonly, nonatomic) size_t allocatedSize;
+
 @end
 
 NS_ASSUME_NONNULL_END
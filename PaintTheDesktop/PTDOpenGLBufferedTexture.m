@@ -184,6 +184,33 @@
 }
 
 
+- (BOOL)isBufferMapped
+{
+  return _lastWrappedImage != nil;
+}
+
+
+- (void)readBufferUsingBlock:(void (^)(const uint8_t *pixels, NSInteger bytesPerRow))block
+{
+  NSInteger bytePerRow = ALIGN_OFFS(4 * _pixelWidth, 4);
+  
+  /* the buffer cannot be mapped twice */
+  PTDOpenGLBufferedTextureWrapperImageRep *imageRep = _lastWrappedImage;
+  if (imageRep) {
+    block(imageRep.bitmapData, bytePerRow);
+    return;
+  }
+  
+  [self bindBuffer];
+  const uint8_t *bufptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_READ_ONLY);
+  if (bufptr) {
+    block(bufptr, bytePerRow);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+
 - (NSSize)pixelSize
 {
   return NSMakeSize(_pixelWidth, _pixelHeight);
@@ -197,12 +224,8 @@
 }
 
 
-- (void)bindTextureAndBuffer
+- (void)bindTexture
 {
-  [_openGLContext makeCurrentContext];
-  
-  [self bindBuffer];
-  
   if (!_textureId) {
     glGenTextures(1, &_textureId);
     glBindTexture(GL_TEXTURE_2D, _textureId);
@@ -212,8 +235,17 @@
   } else {
     glBindTexture(GL_TEXTURE_2D, _textureId);
   }
+}
+
+
+- (void)bindTextureAndBuffer
+{
+  [_openGLContext makeCurrentContext];
+  
+  [self bindBuffer];
+  [self bindTexture];
   
-  if (!_editedSinceLastBind)
+  if (!_editedSinceLastBind || !_bufferId)
     return;
     
   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _pixelWidth, _pixelHeight, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -223,6 +255,45 @@
 }
 
 
+- (void)bindTextureUpdatingRect:(NSRect)rect fromPixels:(nullable const uint8_t *)pixels bytesPerRow:(NSInteger)bytesPerRow
+{
+  [_openGLContext makeCurrentContext];
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  [self bindTexture];
+  
+  GLint x = (GLint)NSMinX(rect), y = (GLint)NSMinY(rect);
+  GLint width = (GLint)NSWidth(rect), height = (GLint)NSHeight(rect);
+  if (!pixels || width <= 0 || height <= 0)
+    return;
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)(bytesPerRow / 4));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels + y * bytesPerRow + x * 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+
+- (void)releaseBuffer
+{
+  if (!_bufferId)
+    return;
+  [self bindTextureAndBuffer];
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glDeleteBuffers(1, &_bufferId);
+  _bufferId = 0;
+}
+
+
+- (size_t)allocatedSize
+{
+  size_t size = 0;
+  if (_bufferId)
+    size += (size_t)ALIGN_OFFS(4 * _pixelWidth, 4) * (size_t)_pixelHeight;
+  if (_textureId)
+    size += (size_t)_pixelWidth * (size_t)_pixelHeight * 4;
+  return size;
+}
+
+
 - (GLenum)texUnit
 {
   return GL_TEXTURE_2D;
@@ -270,7 +341,8 @@
 {
   if (_textureId)
     glDeleteTextures(1, &_textureId);
-  glDeleteBuffers(1, &_bufferId);
+  if (_bufferId)
+    glDeleteBuffers(1, &_bufferId);
 }
 
 
@@ -24,6 +24,7 @@
 //
 
 #import "PTDOvalTool.h"
+#import "PTDCanvasObject.h"
 
 
 NSString * const PTDToolIdentifierOvalTool = @"PTDToolIdentifierOvalTool";
@@ -50,4 +51,10 @@ NSString * const PTDToolIdentifierOvalTool = @"PTDToolIdentifierOvalTool";
 }
 
 
+- (PTDShapeCanvasObject *)shapeCanvasObjectInRect:(NSRect)rect
+{
+  return [[PTDPrimitiveShapeCanvasObject alloc] initWithKind:PTDShapeRasterKindOval rect:rect cornerRadius:0.0 lineWidth:self.size color:self.color filled:self.filled];
+}
+
+
 @end
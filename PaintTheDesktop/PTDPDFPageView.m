@@ -27,6 +27,8 @@
 #import "PDFPage+PTD.h"
 #import "NSAffineTransform+PTD.h"
 #import "PTDNoAnimeCALayer.h"
+#import "PTDBlockTask.h"
+#import "PTDBufferPoolImage.h"
 
 
 @interface PTDPDFPageRendererRequest: NSObject
@@ -100,7 +102,7 @@
     curRequest.bitmap = _lastRequest.bitmap;
     [self renderingEnded:curRequest];
   } else {
-    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    PTDBlockTaskSubmit(PTDTaskPriorityInteractive, ^{
       [self renderRequest:curRequest];
       dispatch_async(dispatch_get_main_queue(), ^{
         [self renderingEnded:curRequest];
@@ -114,32 +116,34 @@
 {
   NSInteger width = round(request.backingSize.width);
   NSInteger height = round(request.backingSize.height);
-  CGContextRef bmpCtx = CGBitmapContextCreate(NULL,
-                                              width, height, 8, 0, 
-                                              request.colorSpace.CGColorSpace,
-                                              kCGImageAlphaNoneSkipLast | kCGImageByteOrderDefault);
-  
-  @autoreleasepool {
-    NSGraphicsContext *ctx = [NSGraphicsContext graphicsContextWithCGContext:bmpCtx flipped:NO];
-    NSGraphicsContext.currentContext = ctx;
-    
-    NSRect sourceRect = request.src;
-    NSRect destRect = NSMakeRect(0, 0, width, height);
-    [[NSColor whiteColor] setFill];
-    NSRectFill(destRect);
-    
-    NSAffineTransform *at = [NSAffineTransform ptd_transformMappingRect:sourceRect toRect:destRect];
-    [at rotateByDegrees:-request.page.rotation];
-    [at concat];
-    
-    CGContextDrawPDFPage(NSGraphicsContext.currentContext.CGContext, request.page.pageRef);
-    [ctx flushGraphics];
-    NSGraphicsContext.currentContext = nil;
+  CGImageRef img = PTDBufferPoolCreateImage(width, height,
+      request.colorSpace.CGColorSpace,
+      kCGImageAlphaNoneSkipLast | kCGImageByteOrderDefault,
+      ^(CGContextRef bmpCtx) {
+    @autoreleasepool {
+      NSGraphicsContext *ctx = [NSGraphicsContext graphicsContextWithCGContext:bmpCtx flipped:NO];
+      NSGraphicsContext.currentContext = ctx;
+      
+      NSRect sourceRect = request.src;
+      NSRect destRect = NSMakeRect(0, 0, width, height);
+      [[NSColor whiteColor] setFill];
+      NSRectFill(destRect);
+      
+      NSAffineTransform *at = [NSAffineTransform ptd_transformMappingRect:sourceRect toRect:destRect];
+      [at rotateByDegrees:-request.page.rotation];
+      [at concat];
+      
+      CGContextDrawPDFPage(NSGraphicsContext.currentContext.CGContext, request.page.pageRef);
+      [ctx flushGraphics];
+      NSGraphicsContext.currentContext = nil;
+    }
+  });
+  if (!img) {
+    NSLog(@"warning: could not allocate a bitmap for a PDF page");
+    return;
   }
-  CGImageRef img = CGBitmapContextCreateImage(bmpCtx);
   request.bitmap = img;
   CFRelease(img);
-  CGContextRelease(bmpCtx);
 }
 
 
@@ -28,9 +28,34 @@
 #import "PTDPDFPageView.h"
 #import "PTDAppDelegate.h"
 #import "PTDAnnotationOverlayPDFPage.h"
+#import "PTDAnnotationOverlay.h"
 #import "NSGeometry+PTD.h"
 #import "PTDThumbnailMenuItemView.h"
 #import "PDFPage+PTD.h"
+#import "PTDAnnotationPageStore.h"
+#import "PTDBlockTask.h"
+#import "PTDCanvasSnapshot.h"
+#import "NSBitmapImageRep+PTD.h"
+
+
+@interface PTDPDFPageThumbnail: NSObject
+
+@property (nonatomic) NSImage *image;
+@property (nonatomic) NSUInteger revision;
+
+@end
+
+@implementation PTDPDFPageThumbnail
+
+@end
+
+
+/* A page is rendered either with its stashed annotations, for the page
+ * menu, or alone, to go under the live canvas in the paintings menu */
+static NSNumber *PTDPDFPageThumbnailKey(NSInteger pageIndex, BOOL annotated)
+{
+  return @(pageIndex * 2 + (annotated ? 1 : 0));
+}
 
 
 @interface PTDPDFPaintWindowController ()
@@ -40,7 +65,9 @@
 
 @implementation PTDPDFPaintWindowController {
   BOOL _openingFile;
-  NSMutableArray<NSData *> *_annotationPages;
+  PTDAnnotationPageStore *_annotationPages;
+  NSMutableDictionary<NSNumber *, PTDPDFPageThumbnail *> *_pageThumbnails;
+  NSMutableDictionary<NSNumber *, NSMutableArray *> *_pendingPageThumbnails;
 }
 
 
@@ -107,11 +134,9 @@
 
 - (void)resetAnnotations
 {
-  NSInteger pc = self.theDocument.pageCount;
-  _annotationPages = [NSMutableArray arrayWithCapacity:pc];
-  for (NSInteger i = 0; i < pc; i++) {
-    [_annotationPages addObject:[NSData data]];
-  }
+  _annotationPages = [[PTDAnnotationPageStore alloc] initWithPageCount:self.theDocument.pageCount];
+  _pageThumbnails = [NSMutableDictionary dictionary];
+  _pendingPageThumbnails = [NSMutableDictionary dictionary];
 }
 
 
@@ -127,6 +152,9 @@
   if (pageIndex >= 0 && pageIndex < self.theDocument.pageCount) {
     self.pageView.pdfPage = [self.theDocument pageAtIndex:_pageIndex];
     self.paintViewController.active = YES;
+    /* ready for the paintings menu before it is opened */
+    if (![self cachedMenuThumbnailOfPageIndex:_pageIndex annotated:NO])
+      [self generateMenuThumbnailOfPageIndex:_pageIndex annotated:NO withArea:10000 completionHandler:^(NSImage *image) {}];
   } else {
     self.pageView.pdfPage = nil;
     self.paintViewController.active = NO;
@@ -151,7 +179,7 @@
     NSRectFill(bounds);
     
     [NSGraphicsContext restoreGraphicsState];
-    [self.paintViewController.view setNeedsDisplay:YES];
+    [self.paintViewController.view canvasDidChangeInRect:bounds];
   }
 }
 
@@ -161,9 +189,32 @@
   if (_pageIndex < 0 || _pageIndex >= self.theDocument.pageCount)
     return NO;
     
-  NSBitmapImageRep *painting = [self snapshot];
+  /* publishing flattens the canvas objects and makes the content rect
+   * exact; only the tiles with content are encoded, and pages left empty
+   * are neither encoded nor overlaid on export */
+  PTDPaintView *view = self.paintViewController.view;
+  PTDCanvasSnapshot *published = view.publishedSnapshot;
+  NSBitmapImageRep *painting;
+  NSSize canvasSize;
+  NSRect cropRect;
+  if (published) {
+    canvasSize = NSMakeSize(published.pixelWidth, published.pixelHeight);
+    cropRect = view.canvasEmpty ? NSZeroRect : published.contentPixelRect;
+    if (!NSIsEmptyRect(cropRect))
+      painting = [published bitmapImageRepOfPixelRect:cropRect];
+  } else {
+    painting = [self snapshot];
+    canvasSize = NSMakeSize(painting.pixelsWide, painting.pixelsHigh);
+    cropRect = (NSRect){NSZeroPoint, canvasSize};
+  }
+  
   NSData *pngPainting = [painting representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
-  _annotationPages[_pageIndex] = pngPainting;
+  if (!pngPainting) {
+    [_annotationPages setData:nil forPageAtIndex:_pageIndex];
+    return YES;
+  }
+  PTDAnnotationOverlay *overlay = [[PTDAnnotationOverlay alloc] initWithPNGData:pngPainting canvasPixelSize:canvasSize cropRect:cropRect];
+  [_annotationPages setData:overlay.dataRepresentation forPageAtIndex:_pageIndex];
   return YES;
 }
 
@@ -173,12 +224,32 @@
   if (_pageIndex < 0 || _pageIndex >= self.theDocument.pageCount)
     return NO;
   
-  NSData *pngPainting = _annotationPages[_pageIndex];
-  if (pngPainting.length == 0)
+  NSData *data = [_annotationPages dataForPageAtIndex:_pageIndex];
+  if (data.length == 0)
+    return NO;
+  PTDAnnotationOverlay *overlay = [[PTDAnnotationOverlay alloc] initWithData:data];
+  if (!overlay)
     return NO;
+  
+  /* the PNG only covers the part of the canvas with content */
+  [self clearCanvas];
+  @autoreleasepool {
+    PTDPaintView *view = self.paintViewController.view;
+    NSRect rect = [overlay cropRectForCanvasRect:view.paintRect];
+    NSInteger width = round(rect.size.width * view.backingScaleFactor.width);
+    NSInteger height = round(rect.size.height * view.backingScaleFactor.height);
+    NSBitmapImageRep *painting = overlay.imageRep;
+    if (!painting || width <= 0 || height <= 0)
+      return YES;
+    if (width != painting.pixelsWide || height != painting.pixelsHigh)
+      painting = [painting ptd_imageRepByResamplingToPixelsWide:width pixelsHigh:height];
     
-  NSBitmapImageRep *painting = [NSBitmapImageRep imageRepWithData:pngPainting];
-  [self restoreFromSnapshot:painting];
+    [NSGraphicsContext saveGraphicsState];
+    NSGraphicsContext.currentContext = view.graphicsContext;
+    [painting drawInRect:rect];
+    [NSGraphicsContext restoreGraphicsState];
+    [view canvasDidChangeInRect:rect];
+  }
   return YES;
 }
 
@@ -212,8 +283,21 @@
 
 - (NSImage *)thumbnail
 {
-  [self stashCanvas];
-  return [self thumbnailOfPageIndex:self.pageIndex withArea:10000];
+  if (self.pageIndex < 0 || self.pageIndex >= self.theDocument.pageCount)
+    return [self thumbnailOfPageIndex:self.pageIndex withArea:10000];
+  
+  /* the page is rendered in the background when it is shown */
+  NSImage *pageThumb = [self cachedMenuThumbnailOfPageIndex:self.pageIndex annotated:NO];
+  if (!pageThumb) {
+    pageThumb = [self placeholderThumbnailWithArea:10000];
+    [self generateMenuThumbnailOfPageIndex:self.pageIndex annotated:NO withArea:10000 completionHandler:^(NSImage *image) {}];
+  }
+  NSImage *canvasThumb = [super thumbnail];
+  return [NSImage imageWithSize:pageThumb.size flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+    [pageThumb drawInRect:dstRect];
+    [canvasThumb drawInRect:dstRect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0];
+    return YES;
+  }];
 }
 
 
@@ -229,26 +313,117 @@
   }
   
   PDFPage *page = [self.theDocument pageAtIndex:pageIndex];
-  NSRect box = [page ptd_rotatedCropBox];
-  NSSize destSize = PTD_NSSizePreservingAspectWithArea(box.size, area);
-  NSImage *baseThumb = [page thumbnailOfSize:destSize forBox:kPDFDisplayBoxCropBox];
-  NSData *snapshotData =_annotationPages[pageIndex];
-  NSBitmapImageRep *snapshot;
-  if (snapshotData.length > 0)
-    snapshot = [[NSBitmapImageRep alloc] initWithData:snapshotData];
-  NSRect destRect = (NSRect){NSZeroPoint, destSize};
-  
-  return [NSImage imageWithSize:destSize flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+  NSData *snapshotData = [_annotationPages dataForPageAtIndex:pageIndex];
+  return [[self class] renderThumbnailOfPage:page annotations:snapshotData withArea:area];
+}
+
+
++ (NSImage *)renderThumbnailOfPage:(PDFPage *)page annotations:(NSData *)snapshotData withArea:(CGFloat)area
+{
+  /* Safe to call from any thread: everything is drawn into a private
+   * bitmap instead of being deferred to an NSImage drawing handler. */
+  @autoreleasepool {
+    NSRect box = [page ptd_rotatedCropBox];
+    NSSize destSize = PTD_NSSizePreservingAspectWithArea(box.size, area);
+    NSImage *baseThumb = [page thumbnailOfSize:destSize forBox:kPDFDisplayBoxCropBox];
+    PTDAnnotationOverlay *overlay;
+    if (snapshotData.length > 0)
+      overlay = [[PTDAnnotationOverlay alloc] initWithData:snapshotData];
+    NSBitmapImageRep *snapshot = overlay.imageRep;
+    NSRect destRect = (NSRect){NSZeroPoint, destSize};
+    
+    NSBitmapImageRep *thumb = [[NSBitmapImageRep alloc]
+        initWithBitmapDataPlanes:NULL
+        pixelsWide:MAX(1, (NSInteger)ceil(destSize.width)) pixelsHigh:MAX(1, (NSInteger)ceil(destSize.height))
+        bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+        colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:0];
+    thumb.size = destSize;
+    
+    [NSGraphicsContext saveGraphicsState];
+    NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithBitmapImageRep:thumb];
     [[NSColor whiteColor] setFill];
     NSRectFill(destRect);
     [baseThumb drawInRect:destRect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0];
     if (snapshot)
-      [snapshot drawInRect:destRect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0 respectFlipped:NO hints:nil];
+      [snapshot drawInRect:[overlay cropRectForCanvasRect:destRect] fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0 respectFlipped:NO hints:nil];
+    [NSGraphicsContext restoreGraphicsState];
+    
+    NSImage *res = [[NSImage alloc] initWithSize:destSize];
+    [res addRepresentation:thumb];
+    return res;
+  }
+}
+
+
+#pragma mark - Page Menu Thumbnails
+
+
+- (NSImage *)placeholderThumbnailWithArea:(CGFloat)area
+{
+  /* Pages are measured only once, so that opening the menu stays cheap;
+   * most documents have pages of a single size anyway */
+  PDFPage *page = [self.theDocument pageAtIndex:self.pageIndex];
+  NSSize destSize = PTD_NSSizePreservingAspectWithArea([page ptd_rotatedCropBox].size, area);
+  return [NSImage imageWithSize:destSize flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+    [[NSColor colorWithWhite:0.85 alpha:1.0] setFill];
+    NSRectFill(dstRect);
     return YES;
   }];
 }
 
 
+- (NSImage *)cachedMenuThumbnailOfPageIndex:(NSInteger)pageIndex annotated:(BOOL)annotated
+{
+  PTDPDFPageThumbnail *thumb = _pageThumbnails[PTDPDFPageThumbnailKey(pageIndex, annotated)];
+  NSUInteger revision = annotated ? [_annotationPages revisionOfPageAtIndex:pageIndex] : 0;
+  if (thumb && thumb.revision == revision)
+    return thumb.image;
+  return nil;
+}
+
+
+- (void)generateMenuThumbnailOfPageIndex:(NSInteger)pageIndex annotated:(BOOL)annotated withArea:(CGFloat)area completionHandler:(void (^)(NSImage *image))handler
+{
+  NSNumber *key = PTDPDFPageThumbnailKey(pageIndex, annotated);
+  NSMutableArray *handlers = _pendingPageThumbnails[key];
+  if (handlers) {
+    [handlers addObject:handler];
+    return;
+  }
+  handlers = [NSMutableArray arrayWithObject:handler];
+  _pendingPageThumbnails[key] = handlers;
+  
+  PDFDocument *document = self.theDocument;
+  PTDAnnotationPageStore *store = _annotationPages;
+  PDFPage *page = [document pageAtIndex:pageIndex];
+  
+  PTDBlockTaskSubmit(PTDTaskPriorityPrefetch, ^{
+    /* the revision is read first, so that if the page changes meanwhile
+     * the thumbnail is regenerated rather than kept as up to date; the
+     * data is read without caching it, to avoid evicting the pages which
+     * are being edited */
+    NSUInteger revision = 0;
+    NSData *snapshotData;
+    if (annotated) {
+      revision = [store revisionOfPageAtIndex:pageIndex];
+      snapshotData = [store uncachedDataForPageAtIndex:pageIndex];
+    }
+    NSImage *image = [PTDPDFPaintWindowController renderThumbnailOfPage:page annotations:snapshotData withArea:area];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      if (store != self->_annotationPages)
+        return;
+      [self->_pendingPageThumbnails removeObjectForKey:key];
+      PTDPDFPageThumbnail *thumb = [[PTDPDFPageThumbnail alloc] init];
+      thumb.image = image;
+      thumb.revision = revision;
+      self->_pageThumbnails[key] = thumb;
+      for (void (^handler)(NSImage *) in handlers)
+        handler(image);
+    });
+  });
+}
+
+
 - (NSMenu *)windowMenu
 {
   NSMenu *submenu = [[NSMenu alloc] init];
@@ -268,10 +443,17 @@
   
   [submenu addItemWithTitle:NSLocalizedString(@"Skip to page", @"Menu item label for PDF page selection") action:nil keyEquivalent:@""];
   NSInteger pageCount = self.theDocument.pageCount;
+  NSImage *placeholder;
   for (NSInteger i=0; i<pageCount; i++) {
     PDFPage *page = [self.theDocument pageAtIndex:i];
     NSString *label = [NSString stringWithFormat:NSLocalizedString(@"%@ (%ld / %ld)", @"Menu item format for PDF page selection"), page.label, i+1, pageCount];
-    NSImage *thumb = [self thumbnailOfPageIndex:i withArea:2500];
+    NSImage *thumb = [self cachedMenuThumbnailOfPageIndex:i annotated:YES];
+    BOOL needsThumb = thumb == nil;
+    if (needsThumb) {
+      if (!placeholder)
+        placeholder = [self placeholderThumbnailWithArea:2500];
+      thumb = placeholder;
+    }
     
     tmp = [NSMenuItem ptd_menuItemWithLabel:label thumbnail:thumb thumbnailArea:5000];
     tmp.tag = i;
@@ -279,6 +461,14 @@
     tmp.target = self;
     tmp.state = i == self.pageIndex ? NSOnState : NSOffState;
     
+    if (needsThumb) {
+      __weak NSMenuItem *weakItem = tmp;
+      [self generateMenuThumbnailOfPageIndex:i annotated:YES withArea:2500 completionHandler:^(NSImage *image) {
+        PTDThumbnailMenuItemView *view = (PTDThumbnailMenuItemView *)weakItem.view;
+        view.thumbnail = image;
+      }];
+    }
+    
     [submenu addItem:tmp];
   }
   
@@ -294,9 +484,10 @@
   NSInteger pageCount = self.theDocument.pageCount;
   for (NSInteger i=0; i<pageCount; i++) {
     PDFPage *origPage = [self.theDocument pageAtIndex:i];
-    NSData *image = _annotationPages[i];
-    if (image.length > 0) {
-      PTDAnnotationOverlayPDFPage *page = [[PTDAnnotationOverlayPDFPage alloc] initWithPDFPage:origPage overlay:image];
+    NSData *data = [_annotationPages dataForPageAtIndex:i];
+    PTDAnnotationOverlay *overlay = data.length > 0 ? [[PTDAnnotationOverlay alloc] initWithData:data] : nil;
+    if (overlay) {
+      PTDAnnotationOverlayPDFPage *page = [[PTDAnnotationOverlayPDFPage alloc] initWithPDFPage:origPage overlay:overlay];
       [newDocument insertPage:page atIndex:i];
     } else {
       [newDocument insertPage:origPage atIndex:i];
@@ -314,8 +505,13 @@
     if (result == NSModalResponseCancel)
       return;
     dispatch_async(dispatch_get_main_queue(), ^{
+      /* the canvas is only accessible from the main thread, but the
+       * document can be written anywhere */
       PDFDocument *doc = [self annotatedPDFDocument];
-      [doc writeToURL:savePanel.URL];
+      NSURL *url = savePanel.URL;
+      PTDBlockTaskSubmit(PTDTaskPriorityEncode, ^{
+        [doc writeToURL:url];
+      });
     });
   }];
 }
@@ -0,0 +1,466 @@
+//
+// PTDPageStore.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/* mkstemp, pwrite and ftruncate are POSIX; Darwin declares them anyway,
+ * and would hide its own extensions if this was defined */
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include "PTDPageStore.h"
+
+
+#define NO_PAGE SIZE_MAX
+/* Dead space below this size is never compacted */
+#define COMPACTION_THRESHOLD (4 * 1024 * 1024)
+
+
+typedef struct {
+  /* extent in the spill file; a zero length means not spilled */
+  off_t offset;
+  size_t length;
+  uint64_t revision;
+  /* a cached copy of the extent, or the data which could not be spilled */
+  uint8_t *memory;
+  size_t memoryLength;
+  bool unspilled;
+  /* list of the cached pages, the most recently used first */
+  size_t newer, older;
+} PTDPageStoreEntry;
+
+struct PTDPageStore {
+  pthread_mutex_t lock;
+  size_t pageCount;
+  size_t hotPageLimit;
+  char *directory;
+  
+  int fd;
+  off_t fileSize;
+  off_t garbageSize;
+  void *map;
+  size_t mapSize;
+  
+  uint64_t lastRevision;
+  size_t residentSize;
+  size_t hotCount;
+  size_t newest, oldest;
+  PTDPageStoreEntry entries[];
+};
+
+
+#pragma mark - Spill file
+
+
+static int PTDPageStoreOpenSpillFile(const PTDPageStore *store)
+{
+  const char *name = "/PTDPages.XXXXXX";
+  char *path = malloc(strlen(store->directory) + strlen(name) + 1);
+  if (!path)
+    return -1;
+  strcpy(path, store->directory);
+  strcat(path, name);
+  int fd = mkstemp(path);
+  /* the file lives only as long as the descriptor */
+  if (fd >= 0)
+    unlink(path);
+  free(path);
+  return fd;
+}
+
+
+static void PTDPageStoreUnmap(PTDPageStore *store)
+{
+  if (store->map != MAP_FAILED)
+    munmap(store->map, store->mapSize);
+  store->map = MAP_FAILED;
+  store->mapSize = 0;
+}
+
+
+static bool PTDPageStoreMapIfNeeded(PTDPageStore *store)
+{
+  if (store->map != MAP_FAILED && store->mapSize == (size_t)store->fileSize)
+    return true;
+  PTDPageStoreUnmap(store);
+  if (store->fd < 0 || store->fileSize == 0)
+    return false;
+  store->map = mmap(NULL, (size_t)store->fileSize, PROT_READ, MAP_SHARED, store->fd, 0);
+  if (store->map == MAP_FAILED)
+    return false;
+  store->mapSize = (size_t)store->fileSize;
+  return true;
+}
+
+
+static bool PTDPageStoreAppend(int fd, off_t *fileSize, const uint8_t *bytes, size_t length, off_t *offset)
+{
+  if (fd < 0)
+    return false;
+  size_t remaining = length;
+  off_t end = *fileSize;
+  while (remaining > 0) {
+    ssize_t res = pwrite(fd, bytes, remaining, end);
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    bytes += res;
+    end += res;
+    remaining -= (size_t)res;
+  }
+  *offset = *fileSize;
+  *fileSize = end;
+  return true;
+}
+
+
+static const uint8_t *PTDPageStoreSpilledBytes(PTDPageStore *store, const PTDPageStoreEntry *entry)
+{
+  if (entry->length == 0 || !PTDPageStoreMapIfNeeded(store))
+    return NULL;
+  return (const uint8_t *)store->map + entry->offset;
+}
+
+
+/* Rewritten pages leave their old extent behind; once the dead space
+ * outweighs the live data, the live extents are copied to a new file. The
+ * old file is kept unless every extent could be copied. */
+static void PTDPageStoreCompactIfNeeded(PTDPageStore *store)
+{
+  if (store->garbageSize < COMPACTION_THRESHOLD || store->garbageSize < store->fileSize - store->garbageSize)
+    return;
+  if (!PTDPageStoreMapIfNeeded(store))
+    return;
+  off_t *offsets = malloc(store->pageCount * sizeof(off_t));
+  int fd = PTDPageStoreOpenSpillFile(store);
+  if (!offsets || fd < 0) {
+    free(offsets);
+    if (fd >= 0)
+      close(fd);
+    return;
+  }
+  
+  off_t fileSize = 0;
+  for (size_t i = 0; i < store->pageCount; i++) {
+    const PTDPageStoreEntry *entry = &store->entries[i];
+    if (entry->length == 0)
+      continue;
+    const uint8_t *bytes = (const uint8_t *)store->map + entry->offset;
+    if (!PTDPageStoreAppend(fd, &fileSize, bytes, entry->length, &offsets[i])) {
+      close(fd);
+      free(offsets);
+      return;
+    }
+  }
+  
+  for (size_t i = 0; i < store->pageCount; i++) {
+    if (store->entries[i].length > 0)
+      store->entries[i].offset = offsets[i];
+  }
+  free(offsets);
+  PTDPageStoreUnmap(store);
+  close(store->fd);
+  store->fd = fd;
+  store->fileSize = fileSize;
+  store->garbageSize = 0;
+}
+
+
+#pragma mark - Memory
+
+
+static void PTDPageStoreUnlinkCached(PTDPageStore *store, size_t index)
+{
+  PTDPageStoreEntry *entry = &store->entries[index];
+  if (entry->newer != NO_PAGE)
+    store->entries[entry->newer].older = entry->older;
+  else
+    store->newest = entry->older;
+  if (entry->older != NO_PAGE)
+    store->entries[entry->older].newer = entry->newer;
+  else
+    store->oldest = entry->newer;
+  entry->newer = entry->older = NO_PAGE;
+  store->hotCount--;
+}
+
+
+static void PTDPageStoreLinkCached(PTDPageStore *store, size_t index)
+{
+  PTDPageStoreEntry *entry = &store->entries[index];
+  entry->newer = NO_PAGE;
+  entry->older = store->newest;
+  if (store->newest != NO_PAGE)
+    store->entries[store->newest].newer = index;
+  else
+    store->oldest = index;
+  store->newest = index;
+  store->hotCount++;
+}
+
+
+static bool PTDPageStoreIsCached(const PTDPageStore *store, size_t index)
+{
+  const PTDPageStoreEntry *entry = &store->entries[index];
+  return entry->memory && !entry->unspilled;
+}
+
+
+static void PTDPageStoreDropMemory(PTDPageStore *store, size_t index)
+{
+  PTDPageStoreEntry *entry = &store->entries[index];
+  if (!entry->memory)
+    return;
+  if (!entry->unspilled)
+    PTDPageStoreUnlinkCached(store, index);
+  store->residentSize -= entry->memoryLength;
+  free(entry->memory);
+  entry->memory = NULL;
+  entry->memoryLength = 0;
+  entry->unspilled = false;
+}
+
+
+static void PTDPageStoreKeepMemory(PTDPageStore *store, size_t index, uint8_t *memory, size_t length, bool unspilled)
+{
+  PTDPageStoreEntry *entry = &store->entries[index];
+  entry->memory = memory;
+  entry->memoryLength = length;
+  entry->unspilled = unspilled;
+  store->residentSize += length;
+  if (unspilled)
+    return;
+  PTDPageStoreLinkCached(store, index);
+  while (store->hotCount > store->hotPageLimit)
+    PTDPageStoreDropMemory(store, store->oldest);
+}
+
+
+#pragma mark - Public interface
+
+
+PTDPageStore *PTDPageStoreCreate(size_t pageCount, size_t hotPageLimit, const char *directory)
+{
+  PTDPageStore *store = calloc(1, sizeof(PTDPageStore) + pageCount * sizeof(PTDPageStoreEntry));
+  if (!store)
+    return NULL;
+  if (!directory)
+    directory = getenv("TMPDIR");
+  store->directory = strdup(directory && *directory ? directory : "/tmp");
+  if (!store->directory) {
+    free(store);
+    return NULL;
+  }
+  pthread_mutex_init(&store->lock, NULL);
+  store->pageCount = pageCount;
+  store->hotPageLimit = hotPageLimit > 0 ? hotPageLimit : 1;
+  store->map = MAP_FAILED;
+  store->newest = store->oldest = NO_PAGE;
+  for (size_t i = 0; i < pageCount; i++)
+    store->entries[i].newer = store->entries[i].older = NO_PAGE;
+  /* without a file every page stays in memory */
+  store->fd = PTDPageStoreOpenSpillFile(store);
+  return store;
+}
+
+
+void PTDPageStoreDestroy(PTDPageStore *store)
+{
+  if (!store)
+    return;
+  for (size_t i = 0; i < store->pageCount; i++)
+    free(store->entries[i].memory);
+  PTDPageStoreUnmap(store);
+  if (store->fd >= 0)
+    close(store->fd);
+  pthread_mutex_destroy(&store->lock);
+  free(store->directory);
+  free(store);
+}
+
+
+size_t PTDPageStorePageCount(const PTDPageStore *store)
+{
+  return store->pageCount;
+}
+
+
+void *PTDPageStoreCopyPage(PTDPageStore *store, size_t index, size_t *length, bool cache)
+{
+  *length = 0;
+  if (index >= store->pageCount)
+    return NULL;
+  pthread_mutex_lock(&store->lock);
+  PTDPageStoreEntry *entry = &store->entries[index];
+  uint8_t *copy = NULL;
+  
+  if (entry->memory) {
+    copy = malloc(entry->memoryLength);
+    if (copy) {
+      memcpy(copy, entry->memory, entry->memoryLength);
+      *length = entry->memoryLength;
+    }
+    if (cache && PTDPageStoreIsCached(store, index)) {
+      PTDPageStoreUnlinkCached(store, index);
+      PTDPageStoreLinkCached(store, index);
+    }
+  } else {
+    const uint8_t *bytes = PTDPageStoreSpilledBytes(store, entry);
+    copy = bytes ? malloc(entry->length) : NULL;
+    if (copy) {
+      memcpy(copy, bytes, entry->length);
+      *length = entry->length;
+      uint8_t *cached = cache ? malloc(entry->length) : NULL;
+      if (cached) {
+        memcpy(cached, bytes, entry->length);
+        PTDPageStoreKeepMemory(store, index, cached, entry->length, false);
+      }
+    }
+  }
+  
+  pthread_mutex_unlock(&store->lock);
+  return copy;
+}
+
+
+bool PTDPageStoreSetPage(PTDPageStore *store, size_t index, const void *data, size_t length)
+{
+  if (index >= store->pageCount)
+    return false;
+  if (!data)
+    length = 0;
+  pthread_mutex_lock(&store->lock);
+  PTDPageStoreEntry *entry = &store->entries[index];
+  
+  const uint8_t *old = entry->memory ? entry->memory : PTDPageStoreSpilledBytes(store, entry);
+  size_t oldLength = entry->memory ? entry->memoryLength : entry->length;
+  if (length == oldLength && (length == 0 || (old && memcmp(old, data, length) == 0))) {
+    pthread_mutex_unlock(&store->lock);
+    return true;
+  }
+  
+  off_t offset = 0;
+  bool spilled = length > 0 && PTDPageStoreAppend(store->fd, &store->fileSize, data, length, &offset);
+  uint8_t *memory = length > 0 ? malloc(length) : NULL;
+  if (length > 0 && !spilled && !memory) {
+    pthread_mutex_unlock(&store->lock);
+    return false;
+  }
+  
+  PTDPageStoreDropMemory(store, index);
+  store->garbageSize += (off_t)entry->length;
+  entry->offset = offset;
+  entry->length = spilled ? length : 0;
+  entry->revision = ++store->lastRevision;
+  if (memory) {
+    memcpy(memory, data, length);
+    PTDPageStoreKeepMemory(store, index, memory, length, !spilled);
+  }
+  PTDPageStoreCompactIfNeeded(store);
+  
+  pthread_mutex_unlock(&store->lock);
+  return true;
+}
+
+
+bool PTDPageStoreHasPage(PTDPageStore *store, size_t index)
+{
+  if (index >= store->pageCount)
+    return false;
+  pthread_mutex_lock(&store->lock);
+  const PTDPageStoreEntry *entry = &store->entries[index];
+  bool res = entry->length > 0 || entry->memory != NULL;
+  pthread_mutex_unlock(&store->lock);
+  return res;
+}
+
+
+uint64_t PTDPageStoreRevision(PTDPageStore *store, size_t index)
+{
+  if (index >= store->pageCount)
+    return 0;
+  pthread_mutex_lock(&store->lock);
+  uint64_t res = store->entries[index].revision;
+  pthread_mutex_unlock(&store->lock);
+  return res;
+}
+
+
+void PTDPageStoreRemoveAllPages(PTDPageStore *store)
+{
+  pthread_mutex_lock(&store->lock);
+  for (size_t i = 0; i < store->pageCount; i++) {
+    PTDPageStoreEntry *entry = &store->entries[i];
+    if (entry->length > 0 || entry->memory)
+      entry->revision = ++store->lastRevision;
+    PTDPageStoreDropMemory(store, i);
+    entry->offset = 0;
+    entry->length = 0;
+  }
+  
+  PTDPageStoreUnmap(store);
+  if (store->fd >= 0 && ftruncate(store->fd, 0) != 0) {
+    /* start over with a new file; otherwise the old one is reused, and
+     * its contents are dead space until the next compaction */
+    int fd = PTDPageStoreOpenSpillFile(store);
+    if (fd >= 0) {
+      close(store->fd);
+      store->fd = fd;
+    } else {
+      store->garbageSize = store->fileSize;
+      pthread_mutex_unlock(&store->lock);
+      return;
+    }
+  }
+  store->fileSize = 0;
+  store->garbageSize = 0;
+  pthread_mutex_unlock(&store->lock);
+}
+
+
+size_t PTDPageStoreResidentSize(PTDPageStore *store)
+{
+  pthread_mutex_lock(&store->lock);
+  size_t res = store->residentSize;
+  pthread_mutex_unlock(&store->lock);
+  return res;
+}
+
+
+size_t PTDPageStoreFileSize(PTDPageStore *store)
+{
+  pthread_mutex_lock(&store->lock);
+  size_t res = (size_t)store->fileSize;
+  pthread_mutex_unlock(&store->lock);
+  return res;
+}
@@ -0,0 +1,77 @@
+//
+// PTDPageStore.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDPageStore_h
+#define PTDPageStore_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A blob of data for each page of a document, spilled to an unlinked file
+ * and read back through a memory mapping. Only the most recently used
+ * pages are kept in memory, so the footprint does not depend on the
+ * number of pages; looking a page up is constant time.
+ *
+ * Pages which cannot be written to the file are kept in memory instead,
+ * and a failed compaction of the file leaves it as it was, so no data is
+ * ever lost because of a full disk. All functions can be called from any
+ * thread. */
+typedef struct PTDPageStore PTDPageStore;
+
+/* The spill file is created in the directory, or in the temporary
+ * directory if it is NULL. */
+PTDPageStore *PTDPageStoreCreate(size_t pageCount, size_t hotPageLimit, const char *directory);
+void PTDPageStoreDestroy(PTDPageStore *store);
+
+size_t PTDPageStorePageCount(const PTDPageStore *store);
+
+/* Returns a copy of the data of the page, to be freed by the caller, or
+ * NULL and a length of zero if the page has no data. Only a cached read
+ * makes the page one of the most recently used ones. */
+void *PTDPageStoreCopyPage(PTDPageStore *store, size_t index, size_t *length, bool cache);
+/* Empty data removes the page. Returns false if the data could neither be
+ * written nor kept in memory; the page is left unchanged in that case. */
+bool PTDPageStoreSetPage(PTDPageStore *store, size_t index, const void *data, size_t length);
+bool PTDPageStoreHasPage(PTDPageStore *store, size_t index);
+/* Changes every time the data of the page is replaced with different
+ * data; zero for pages which never had any. */
+uint64_t PTDPageStoreRevision(PTDPageStore *store, size_t index);
+void PTDPageStoreRemoveAllPages(PTDPageStore *store);
+
+/* The bytes kept in memory, for the cached and the unspilled pages, and
+ * the size of the spill file, including the dead space not yet compacted. */
+size_t PTDPageStoreResidentSize(PTDPageStore *store);
+size_t PTDPageStoreFileSize(PTDPageStore *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDPageStore_h */
@@ -24,10 +24,14 @@
 //
 
 #import <Cocoa/Cocoa.h>
+#import "PTDResampler.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol PTDPaintViewDelegate;
+@class PTDCanvasObjectList;
+@class PTDCursor;
+@class PTDCanvasSnapshot;
 
 @interface PTDPaintView : NSOpenGLView
 
@@ -40,12 +44,87 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, readonly) CALayer *overlayLayer;
 
-@property (nonatomic, nullable) NSImage *cursorImage;
+/* Objects shown above the canvas until they are flattened into it. The
+ * methods which change the canvas pixels flatten the objects in the rect
+ * they change first; the ones which read them draw the objects over a
+ * copy instead. */
+@property (nonatomic, readonly) PTDCanvasObjectList *canvasObjects;
+- (void)flattenCanvasObjects;
+/* Flattens the objects intersecting the rect, and the ones below them which
+ * they overlap, so that the stacking order stays the same. */
+- (void)flattenCanvasObjectsInRect:(NSRect)rect;
+
+/* Drawn above everything else, using the bitmap sprites of the cursor.
+ * Moving the cursor does not commit a transaction by itself; the change
+ * is presented with the next frame. */
+@property (nonatomic, nullable) PTDCursor *overlayCursor;
 @property (nonatomic) NSPoint cursorPosition;
 
+/* Incremented every time a part of the canvas is marked as changed, or the
+ * canvas objects change, so that data derived from what the canvas shows
+ * can be checked for staleness. */
+@property (nonatomic, readonly) NSUInteger canvasRevision;
+
+/* Marks a rect of the canvas as changed after drawing into its graphics
+ * context: it is redrawn, published and thumbnailed again. The methods
+ * which modify the pixels directly call it themselves. A plain redisplay,
+ * through -setNeedsDisplay:, does not change the canvas. */
+- (void)canvasDidChangeInRect:(NSRect)rect;
+
 - (NSBitmapImageRep *)snapshot;
 - (NSBitmapImageRep *)snapshotOfRect:(NSRect)rect;
 
+/* Copies the tiles of the canvas which changed since the last call to the
+ * canvas store, and returns the resulting frame. Unlike the snapshots
+ * above, it can be read from any thread, and the canvas can be modified
+ * while it is being read. Returns nil if the frame cannot be allocated. */
+- (nullable PTDCanvasSnapshot *)publishedSnapshot;
+/* Same as -publishedSnapshot, but the canvas objects are drawn into a copy
+ * of the canvas instead of being flattened. The copy is only made when
+ * there are canvas objects. */
+- (nullable PTDCanvasSnapshot *)publishedSnapshotIncludingCanvasObjects;
+
+/* Bounds of the pixels of the canvas which are not fully transparent and
+ * of the canvas objects, or NSZeroRect if there are none. They grow with
+ * every change to the canvas, but only shrink once it is published again,
+ * so they may be larger than the content. */
+@property (nonatomic, readonly) NSRect contentRect;
+@property (nonatomic, readonly, getter=isCanvasEmpty) BOOL canvasEmpty;
+
+/* Direct access to the pixels of the canvas, for tools that do not draw
+ * through the graphics context. The rect, in view coordinates, is the one
+ * the block may change; the block returns the rect to redraw. */
+- (void)modifyCanvasPixelsInRect:(NSRect)rect usingBlock:(NS_NOESCAPE NSRect (^)(NSBitmapImageRep *canvas))block;
+- (void)readCanvasPixelsUsingBlock:(NS_NOESCAPE void (^)(const PTDPixelBuffer *canvas))block;
+
+/* Runs the block on the raster worker of the canvas, after all the blocks
+ * enqueued before it, and returns immediately. The block must not touch
+ * anything else which is used by the main thread. The rect it returns is
+ * redrawn once it has finished; drawing the view shows the blocks finished
+ * so far without waiting for the others. Any other access to the canvas
+ * waits for the queued blocks to finish first. */
+- (void)enqueueCanvasModificationInRect:(NSRect)rect usingBlock:(NSRect (^)(const PTDPixelBuffer *canvas))block;
+
+/* The color space of the canvas pixels */
+@property (nonatomic, readonly) NSColorSpace *canvasColorSpace;
+
+/* Downsampled copy of the canvas, kept up to date in the background, with
+ * the canvas objects drawn above it. */
+- (NSImage *)thumbnail;
+
+/* The memory taken by the pixels of the canvas, including its published
+ * copy, or by its compressed form. */
+@property (nonatomic, readonly) size_t canvasMemoryUsage;
+/* System uptime of the last change to the canvas, or of the last time it
+ * was decompressed. */
+@property (nonatomic, readonly) NSTimeInterval lastCanvasChangeTime;
+
+/* Compresses the canvas in the background and releases its buffers, unless
+ * it changes in the meantime. Only its texture is kept, so that it can be
+ * drawn; it is decompressed as soon as anything else accesses it. */
+- (void)compressCanvas;
+@property (nonatomic, readonly, getter=isCanvasCompressed) BOOL canvasCompressed;
+
 @end
 
 @protocol PTDPaintViewDelegate <NSObject>
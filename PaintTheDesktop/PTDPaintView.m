@@ -29,13 +29,59 @@
 #import "PTDPaintView.h"
 #import "PTDOpenGLBufferedTexture.h"
 #import "PTDNoAnimeCALayer.h"
+#import "PTDCanvasThumbnail.h"
+#import "NSBitmapImageRep+PTD.h"
+#import "PTDCanvasObjectList.h"
+#import "PTDCanvasObject.h"
+#import "PTDCursor.h"
+#import "PTDRasterWorker.h"
+#import "PTDPresentBuffer.h"
+#import "PTDCanvasStore.h"
+#import "PTDCanvasSnapshot.h"
+#import "PTDBlockTask.h"
+#import "PTDCompressedCanvas.h"
+#import "PTDCanvasMemoryBudget.h"
+
+
+static const NSInteger _ThumbnailArea = 200 * 200;
+static const NSTimeInterval _ThumbnailRefreshDelay = 0.5;
+static const size_t _RasterQueueCapacity = 64;
 
 
 @implementation PTDPaintView {
   PTDOpenGLBufferedTexture *_mainBuffer;
   PTDNoAnimeCALayer *_overlayLayer;
-  CALayer *_cursorLayer;
+  PTDNoAnimeCALayer *_canvasObjectsLayer;
+  PTDCanvasObjectList *_canvasObjects;
+  /* the canvas revision also counts the changes to the canvas objects */
+  NSUInteger _canvasRevision;
+  PTDNoAnimeCALayer *_cursorLayer;
   BOOL _liveResize;
+  PTDCanvasThumbnail *_thumbnail;
+  BOOL _thumbnailRefreshScheduled;
+  PTDRasterWorker *_rasterWorker;
+  /* keeps the buffer mapped while the worker has commands to run; only
+   * released on the main thread */
+  NSBitmapImageRep *_workerCanvas;
+  /* commands whose dirty rect has not reached the main thread yet */
+  NSUInteger _pendingRasterCommands;
+  /* the changes finished by the worker, which are drawn while the buffer
+   * is mapped; exists as long as _workerCanvas */
+  PTDPresentBuffer *_presentBuffer;
+  /* written only on the main thread, read by the thumbnail queue and by
+   * the owners of published snapshots */
+  PTDCanvasStore *_canvasStore;
+  /* in pixels, with the origin at the top left corner */
+  NSRect _unpublishedRect;
+  /* tiles which are not fully transparent in the last frame published */
+  NSRect _publishedContentRect;
+  PTDTaskSerialQueue *_thumbnailQueue;
+  /* replaces the buffer and the store while the canvas is compressed */
+  PTDCompressedCanvas *_compressedCanvas;
+  /* the texture of the compressed canvas, without its buffer */
+  PTDOpenGLBufferedTexture *_compressedTexture;
+  NSColorSpace *_compressedColorSpace;
+  BOOL _compressing;
 }
 
 
@@ -45,6 +91,7 @@
   _liveResize = NO;
   _backingScaleFactor = NSMakeSize(1.0, 1.0);
   [self updateBackingImages];
+  [PTDCanvasMemoryBudget.sharedBudget addPaintView:self];
   return self;
 }
 
@@ -55,10 +102,21 @@
   _liveResize = NO;
   _backingScaleFactor = NSMakeSize(1.0, 1.0);
   [self updateBackingImages];
+  [PTDCanvasMemoryBudget.sharedBudget addPaintView:self];
   return self;
 }
 
 
+- (void)dealloc
+{
+  PTDRasterWorkerDestroy(_rasterWorker);
+  PTDPresentBufferDestroy(_presentBuffer);
+  PTDCanvasStoreRelease(_canvasStore);
+  PTDTaskSerialQueueRelease(_thumbnailQueue);
+  PTDCompressedCanvasDestroy(_compressedCanvas);
+}
+
+
 - (BOOL)acceptsFirstMouse:(NSEvent *)event
 {
   return YES;
@@ -169,10 +227,13 @@
 {
   if (!self.window || self.inLiveResize)
     return;
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
   [_mainBuffer convertToColorSpace:self.window.screen.colorSpace renderingIntent:NSColorRenderingIntentRelativeColorimetric];
   CGFloat scale = self.window.screen.backingScaleFactor;
   NSSize oldScaleFactor = self.backingScaleFactor;
   self.backingScaleFactor = NSMakeSize(MAX(oldScaleFactor.width, scale), MAX(oldScaleFactor.height, scale));
+  [self updateCursorLayerContents];
 }
 
 
@@ -197,18 +258,113 @@
 }
 
 
+- (PTDCanvasObjectList *)canvasObjects
+{
+  if (!_canvasObjects) {
+    _canvasObjectsLayer = [[PTDNoAnimeCALayer alloc] init];
+    [self.layer addSublayer:_canvasObjectsLayer];
+    _canvasObjectsLayer.autoresizingMask = kCALayerWidthSizable | kCALayerHeightSizable;
+    _canvasObjectsLayer.frame = self.bounds;
+    _canvasObjectsLayer.zPosition = 25;
+    _canvasObjects = [[PTDCanvasObjectList alloc] initWithLayer:_canvasObjectsLayer];
+    _canvasObjects.backingScaleFactor = _backingScaleFactor;
+  }
+  return _canvasObjects;
+}
+
+
+- (void)flattenCanvasObjects
+{
+  NSArray<PTDCanvasObject *> *objects = _canvasObjects.objects;
+  if (objects.count == 0)
+    return;
+  [_canvasObjects removeAllObjects];
+  [self drawCanvasObjectsIntoCanvas:objects];
+}
+
+
+- (void)flattenCanvasObjectsInRect:(NSRect)rect
+{
+  if (_canvasObjects.count == 0)
+    return;
+  NSArray<PTDCanvasObject *> *objects = [_canvasObjects objectsToFlattenInRect:rect];
+  if (objects.count == 0)
+    return;
+  [_canvasObjects removeObjects:objects];
+  [self drawCanvasObjectsIntoCanvas:objects];
+}
+
+
+- (void)drawCanvasObjectsIntoCanvas:(NSArray<PTDCanvasObject *> *)objects
+{
+  /* The objects which can be drawn on any thread are drawn on the raster
+   * worker. Drawing the others waits for it, which keeps them in order. */
+  NSSize scale = _backingScaleFactor;
+  NSColorSpace *colorSpace = self.canvasColorSpace;
+  for (PTDCanvasObject *object in objects) {
+    NSRect bounds = object.bounds;
+    void (^drawer)(const PTDPixelBuffer *) = [object canvasPixelDrawerWithColorSpace:colorSpace backingScaleFactor:scale];
+    if (drawer) {
+      [self enqueueRasterCommandUsingBlock:^NSRect(const PTDPixelBuffer *canvas) {
+        drawer(canvas);
+        return bounds;
+      }];
+    } else {
+      [self writeCanvasPixelsUsingBlock:^NSRect(NSBitmapImageRep *canvas) {
+        [object drawInCanvas:canvas backingScaleFactor:scale];
+        return bounds;
+      }];
+    }
+  }
+}
+
+
+- (NSUInteger)canvasRevision
+{
+  return _canvasRevision + _canvasObjects.changeCount;
+}
+
+
 - (NSRect)paintRect
 {
   return self.bounds;
 }
 
 
+/* Copies the pixels of a rect of the canvas, whose first row is the top
+ * one, to an image rep backed by the buffer pool. The pixels outside the
+ * canvas are transparent. */
+static NSBitmapImageRep *PTDPaintViewCopyCanvasPixels(NSBitmapImageRep *canvas, NSInteger x, NSInteger y, NSInteger width, NSInteger height)
+{
+  PTDPixelBuffer src = canvas.ptd_pixelBuffer;
+  return [NSBitmapImageRep ptd_pooledImageRepWithPixelsWide:width pixelsHigh:height colorSpace:canvas.colorSpace fillingPixelsUsingBlock:^(const PTDPixelBuffer *dst) {
+    NSInteger dstWidth = (NSInteger)dst->width;
+    NSInteger cx0 = MIN(dstWidth, MAX(0, -x));
+    NSInteger cx1 = MAX(cx0, MIN(dstWidth, (NSInteger)src.width - x));
+    for (NSInteger row = 0; row < (NSInteger)dst->height; row++) {
+      uint8_t *out = dst->data + (size_t)row * dst->bytesPerRow;
+      NSInteger srcRow = y + row;
+      if (srcRow < 0 || srcRow >= (NSInteger)src.height) {
+        memset(out, 0, dst->width * 4);
+        continue;
+      }
+      memset(out, 0, (size_t)cx0 * 4);
+      memcpy(out + cx0 * 4, src.data + (size_t)srcRow * src.bytesPerRow + (x + cx0) * 4, (size_t)(cx1 - cx0) * 4);
+      memset(out + cx1 * 4, 0, (size_t)(dstWidth - cx1) * 4);
+    }
+  }];
+}
+
+
 - (NSBitmapImageRep *)snapshot
 {
+  [self flattenCanvasObjects];
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
   NSBitmapImageRep *copy;
   @autoreleasepool {
     NSBitmapImageRep *imageRep = _mainBuffer.bufferAsImageRep;
-    copy = [imageRep copy];
+    copy = PTDPaintViewCopyCanvasPixels(imageRep, 0, 0, imageRep.pixelsWide, imageRep.pixelsHigh);
   }
   
   copy.size = NSMakeSize(
@@ -220,6 +376,9 @@
 
 - (NSBitmapImageRep *)snapshotOfRect:(NSRect)rect
 {
+  [self flattenCanvasObjectsInRect:rect];
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
   NSRect backingRect = rect;
   backingRect.origin.x *= _backingScaleFactor.width;
   backingRect.size.width *= _backingScaleFactor.width;
@@ -232,14 +391,10 @@
   NSBitmapImageRep *copy;
   @autoreleasepool {
     NSBitmapImageRep *imageRep = _mainBuffer.bufferAsImageRep;
-    
-    copy = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL pixelsWide:backingWidth pixelsHigh:backingHeight bitsPerSample:imageRep.bitsPerSample samplesPerPixel:imageRep.samplesPerPixel hasAlpha:imageRep.hasAlpha isPlanar:NO colorSpaceName:imageRep.colorSpaceName bytesPerRow:0 bitsPerPixel:0];
-    copy = [copy bitmapImageRepByRetaggingWithColorSpace:imageRep.colorSpace];
-    
-    [NSGraphicsContext saveGraphicsState];
-    NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithBitmapImageRep:copy];
-    [imageRep drawInRect:(NSRect){NSZeroPoint, backingRect.size} fromRect:backingRect operation:NSCompositingOperationCopy fraction:1.0 respectFlipped:YES hints:nil];
-    [NSGraphicsContext restoreGraphicsState];
+    /* the rect has its origin at the bottom */
+    NSInteger x = (NSInteger)floor(backingRect.origin.x);
+    NSInteger y = imageRep.pixelsHigh - (NSInteger)floor(backingRect.origin.y) - backingHeight;
+    copy = PTDPaintViewCopyCanvasPixels(imageRep, x, y, backingWidth, backingHeight);
   }
   
   copy.size = NSMakeSize(
@@ -249,8 +404,472 @@
 }
 
 
+- (PTDCanvasSnapshot *)publishedSnapshot
+{
+  [self flattenCanvasObjects];
+  if (![self publishCanvas])
+    return nil;
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(_canvasStore);
+  if (!frame)
+    return nil;
+  return [[PTDCanvasSnapshot alloc] initWithCanvasFrame:frame size:self.paintRect.size colorSpace:self.canvasColorSpace];
+}
+
+
+- (PTDCanvasSnapshot *)publishedSnapshotIncludingCanvasObjects
+{
+  if (_canvasObjects.count == 0)
+    return [self publishedSnapshot];
+  
+  /* the frame is made from a copy of the canvas in a store of its own, so
+   * the canvas store keeps publishing only what was flattened */
+  __block PTDCanvasFrame *frame = NULL;
+  [self readCanvasPixelsUsingBlock:^(const PTDPixelBuffer *canvas) {
+    PTDCanvasStore *store = PTDCanvasStoreCreate(canvas->width, canvas->height);
+    if (!store)
+      return;
+    if (PTDCanvasStorePublish(store, canvas, 0, 0, canvas->width, canvas->height))
+      frame = PTDCanvasStoreAcquireFrame(store);
+    PTDCanvasStoreRelease(store);
+  }];
+  if (!frame)
+    return nil;
+  return [[PTDCanvasSnapshot alloc] initWithCanvasFrame:frame size:self.paintRect.size colorSpace:self.canvasColorSpace];
+}
+
+
+- (BOOL)publishCanvas
+{
+  [self restoreCompressedCanvas];
+  if (!_canvasStore)
+    return NO;
+  [self waitForRasterWorker];
+  if (NSIsEmptyRect(_unpublishedRect))
+    return YES;
+  
+  size_t x0 = (size_t)MAX(0, floor(NSMinX(_unpublishedRect)));
+  size_t y0 = (size_t)MAX(0, floor(NSMinY(_unpublishedRect)));
+  size_t x1 = (size_t)MAX(0, ceil(NSMaxX(_unpublishedRect)));
+  size_t y1 = (size_t)MAX(0, ceil(NSMaxY(_unpublishedRect)));
+  PTDCanvasStore *store = _canvasStore;
+  size_t width = PTDCanvasStoreWidth(store);
+  size_t height = PTDCanvasStoreHeight(store);
+  __block uint64_t generation = 0;
+  [_mainBuffer readBufferUsingBlock:^(const uint8_t *pixels, NSInteger bytesPerRow) {
+    PTDPixelBuffer canvas = {(uint8_t *)pixels, width, height, (size_t)bytesPerRow};
+    generation = PTDCanvasStorePublish(store, &canvas, x0, y0, x1, y1);
+  }];
+  if (generation == 0)
+    return NO;
+  _unpublishedRect = NSZeroRect;
+  
+  /* shrinks the content rect after something was erased */
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  if (frame) {
+    size_t cx0, cy0, cx1, cy1;
+    PTDCanvasFrameContentBounds(frame, &cx0, &cy0, &cx1, &cy1);
+    _publishedContentRect = NSMakeRect(cx0, cy0, cx1 - cx0, cy1 - cy0);
+    PTDCanvasFrameRelease(frame);
+  }
+  return YES;
+}
+
+
+- (NSRect)contentRect
+{
+  NSRect pxRect = NSUnionRect(_publishedContentRect, _unpublishedRect);
+  NSRect rect = NSZeroRect;
+  if (!NSIsEmptyRect(pxRect)) {
+    /* the buffer has its first row at the top */
+    rect.origin.x = pxRect.origin.x / _backingScaleFactor.width;
+    rect.origin.y = NSHeight(self.bounds) - NSMaxY(pxRect) / _backingScaleFactor.height;
+    rect.size.width = pxRect.size.width / _backingScaleFactor.width;
+    rect.size.height = pxRect.size.height / _backingScaleFactor.height;
+  }
+  for (PTDCanvasObject *object in _canvasObjects.objects)
+    rect = NSUnionRect(rect, object.bounds);
+  return NSIntersectionRect(rect, self.bounds);
+}
+
+
+- (BOOL)isCanvasEmpty
+{
+  return _pendingRasterCommands == 0 && _canvasObjects.count == 0 && NSIsEmptyRect(_publishedContentRect) && NSIsEmptyRect(_unpublishedRect);
+}
+
+
+- (void)modifyCanvasPixelsInRect:(NSRect)rect usingBlock:(NS_NOESCAPE NSRect (^)(NSBitmapImageRep *canvas))block
+{
+  [self flattenCanvasObjectsInRect:rect];
+  [self writeCanvasPixelsUsingBlock:block];
+}
+
+
+- (void)writeCanvasPixelsUsingBlock:(NS_NOESCAPE NSRect (^)(NSBitmapImageRep *canvas))block
+{
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
+  NSRect dirtyRect;
+  @autoreleasepool {
+    dirtyRect = block(_mainBuffer.bufferAsImageRep);
+  }
+  [self canvasDidChangeInRect:dirtyRect];
+}
+
+
+- (void)readCanvasPixelsUsingBlock:(NS_NOESCAPE void (^)(const PTDPixelBuffer *canvas))block
+{
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
+  if (_canvasObjects.count > 0) {
+    /* drawn in the same order and in the same way as when flattening */
+    @autoreleasepool {
+      NSBitmapImageRep *imageRep = _mainBuffer.bufferAsImageRep;
+      NSBitmapImageRep *copy = PTDPaintViewCopyCanvasPixels(imageRep, 0, 0, imageRep.pixelsWide, imageRep.pixelsHigh);
+      for (PTDCanvasObject *object in _canvasObjects.objects)
+        [object drawInCanvas:copy backingScaleFactor:_backingScaleFactor];
+      PTDPixelBuffer canvas = copy.ptd_pixelBuffer;
+      block(&canvas);
+    }
+    return;
+  }
+  size_t width = (size_t)_mainBuffer.pixelWidth;
+  size_t height = (size_t)_mainBuffer.pixelHeight;
+  [_mainBuffer readBufferUsingBlock:^(const uint8_t *pixels, NSInteger bytesPerRow) {
+    PTDPixelBuffer canvas = {(uint8_t *)pixels, width, height, (size_t)bytesPerRow};
+    block(&canvas);
+  }];
+}
+
+
+static void PTDPaintViewRunRasterCommand(void *context)
+{
+  void (^command)(void) = (__bridge_transfer void (^)(void))context;
+  command();
+}
+
+
+/* The pixels covered by a rect in view coordinates, in a canvas whose first
+ * row is the top one */
+static void PTDPaintViewPixelRect(NSRect rect, NSSize scale, const PTDPixelBuffer *canvas, size_t *x0, size_t *y0, size_t *x1, size_t *y1)
+{
+  CGFloat height = (CGFloat)canvas->height;
+  *x0 = (size_t)MAX(0, floor(NSMinX(rect) * scale.width));
+  *y0 = (size_t)MAX(0, floor(height - NSMaxY(rect) * scale.height));
+  *x1 = (size_t)MIN((CGFloat)canvas->width, MAX(0, ceil(NSMaxX(rect) * scale.width)));
+  *y1 = (size_t)MIN(height, MAX(0, ceil(height - NSMinY(rect) * scale.height)));
+}
+
+
+- (void)enqueueCanvasModificationInRect:(NSRect)rect usingBlock:(NSRect (^)(const PTDPixelBuffer *canvas))block
+{
+  [self flattenCanvasObjectsInRect:rect];
+  [self enqueueRasterCommandUsingBlock:block];
+}
+
+
+- (void)enqueueRasterCommandUsingBlock:(NSRect (^)(const PTDPixelBuffer *canvas))block
+{
+  if (!_rasterWorker)
+    _rasterWorker = PTDRasterWorkerCreate(_RasterQueueCapacity);
+  if (!_rasterWorker) {
+    [self writeCanvasPixelsUsingBlock:^NSRect(NSBitmapImageRep *canvas) {
+      PTDPixelBuffer buffer = canvas.ptd_pixelBuffer;
+      return block(&buffer);
+    }];
+    return;
+  }
+  
+  if (!_workerCanvas) {
+    [self restoreCompressedCanvas];
+    /* While the worker has the buffer mapped, it cannot be uploaded to the
+     * texture. The texture is brought up to date now, and then only the
+     * changes finished by the worker are uploaded, from the present buffer. */
+    if (!_mainBuffer.bufferMapped) {
+      [_mainBuffer bindTextureAndBuffer];
+      glBindTexture(_mainBuffer.texUnit, 0);
+      glBindBuffer(_mainBuffer.bufferUnit, 0);
+    }
+    _presentBuffer = PTDPresentBufferCreate((size_t)_mainBuffer.pixelWidth, (size_t)_mainBuffer.pixelHeight);
+    @autoreleasepool {
+      _workerCanvas = _mainBuffer.bufferAsImageRep;
+    }
+  }
+  PTDPixelBuffer canvas = _workerCanvas.ptd_pixelBuffer;
+  PTDPresentBuffer *presentBuffer = _presentBuffer;
+  NSSize scale = _backingScaleFactor;
+  _pendingRasterCommands++;
+  
+  __weak PTDPaintView *weakSelf = self;
+  void (^command)(void) = ^{
+    NSRect dirtyRect = block(&canvas);
+    if (presentBuffer) {
+      size_t x0, y0, x1, y1;
+      PTDPaintViewPixelRect(dirtyRect, scale, &canvas, &x0, &y0, &x1, &y1);
+      PTDPresentBufferUpdate(presentBuffer, &canvas, x0, y0, x1, y1);
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [weakSelf rasterCommandDidFinishWithDirtyRect:dirtyRect];
+    });
+  };
+  PTDRasterWorkerEnqueue(_rasterWorker, PTDPaintViewRunRasterCommand, (__bridge_retained void *)command);
+}
+
+
+- (void)rasterCommandDidFinishWithDirtyRect:(NSRect)dirtyRect
+{
+  _pendingRasterCommands--;
+  [self canvasDidChangeInRect:dirtyRect];
+  if (_rasterWorker && PTDRasterWorkerIsIdle(_rasterWorker))
+    [self releaseWorkerCanvas];
+}
+
+
+- (void)waitForRasterWorker
+{
+  if (!_rasterWorker)
+    return;
+  PTDRasterWorkerWaitUntilIdle(_rasterWorker);
+  [self releaseWorkerCanvas];
+}
+
+
+/* The worker must be idle */
+- (void)releaseWorkerCanvas
+{
+  /* the whole buffer is uploaded at the next redraw */
+  _workerCanvas = nil;
+  PTDPresentBufferDestroy(_presentBuffer);
+  _presentBuffer = NULL;
+}
+
+
+- (NSImage *)thumbnail
+{
+  NSBitmapImageRep *rep = [_thumbnail bitmapImageRepWithColorSpace:self.canvasColorSpace];
+  NSSize size = self.paintRect.size;
+  NSArray<PTDCanvasObject *> *objects = _canvasObjects.objects;
+  if (objects.count == 0) {
+    NSImage *image = [[NSImage alloc] initWithSize:size];
+    if (rep) {
+      rep.size = size;
+      [image addRepresentation:rep];
+    }
+    return image;
+  }
+  
+  /* the objects are not in the canvas yet, but they are part of the
+   * painting; they are immutable, so they can be drawn later */
+  return [NSImage imageWithSize:size flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+    [rep drawInRect:dstRect];
+    for (PTDCanvasObject *object in objects)
+      [object draw];
+    return YES;
+  }];
+}
+
+
+- (NSColorSpace *)canvasColorSpace
+{
+  return _compressedCanvas ? _compressedColorSpace : _mainBuffer.colorSpace;
+}
+
+
+- (size_t)canvasMemoryUsage
+{
+  if (_compressedCanvas)
+    return PTDCompressedCanvasSize(_compressedCanvas) + _compressedTexture.allocatedSize;
+  size_t usage = _mainBuffer.allocatedSize;
+  PTDCanvasFrame *frame = _canvasStore ? PTDCanvasStoreAcquireFrame(_canvasStore) : NULL;
+  if (frame) {
+    usage += PTDCanvasFrameAllocatedSize(frame);
+    PTDCanvasFrameRelease(frame);
+  }
+  return usage;
+}
+
+
+- (BOOL)isCanvasCompressed
+{
+  return _compressedCanvas != NULL;
+}
+
+
+- (void)compressCanvas
+{
+  if (_compressedCanvas || _compressing || !_mainBuffer)
+    return;
+  /* the raster worker is still changing it */
+  if (_workerCanvas)
+    return;
+  /* floating objects are still being edited */
+  if (_canvasObjects.objects.count > 0)
+    return;
+  if (![self publishCanvas])
+    return;
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(_canvasStore);
+  if (!frame)
+    return;
+  
+  _compressing = YES;
+  NSUInteger revision = _canvasRevision;
+  __weak PTDPaintView *weakSelf = self;
+  PTDBlockTaskSubmit(PTDTaskPriorityAutosave, ^{
+    PTDCompressedCanvas *compressed = PTDCompressedCanvasCreate(frame);
+    PTDCanvasFrameRelease(frame);
+    dispatch_async(dispatch_get_main_queue(), ^{
+      PTDPaintView *view = weakSelf;
+      if (!view || ![view replaceCanvasWithCompressedCanvas:compressed revision:revision])
+        PTDCompressedCanvasDestroy(compressed);
+    });
+  });
+}
+
+
+- (BOOL)replaceCanvasWithCompressedCanvas:(nullable PTDCompressedCanvas *)compressed revision:(NSUInteger)revision
+{
+  _compressing = NO;
+  if (!compressed || revision != _canvasRevision || !_mainBuffer)
+    return NO;
+  /* something still has the buffer mapped, or is about to change it */
+  if (_mainBuffer.bufferMapped || _workerCanvas || _canvasObjects.objects.count > 0)
+    return NO;
+  if (PTDCompressedCanvasWidth(compressed) != (size_t)_mainBuffer.pixelWidth ||
+      PTDCompressedCanvasHeight(compressed) != (size_t)_mainBuffer.pixelHeight)
+    return NO;
+  
+  if ([NSUserDefaults.standardUserDefaults boolForKey:@"debug"])
+    NSLog(@"compressed canvas %p from %zu to %zu bytes", self, self.canvasMemoryUsage, PTDCompressedCanvasSize(compressed));
+  _compressedColorSpace = _mainBuffer.colorSpace;
+  /* the GL objects are deleted in the context of the view; the texture is
+   * kept, so that the canvas can be drawn without decompressing it */
+  [self.openGLContext makeCurrentContext];
+  [_mainBuffer releaseBuffer];
+  _compressedTexture = _mainBuffer;
+  _mainBuffer = nil;
+  /* snapshots published before keep their own frames */
+  PTDCanvasStoreRelease(_canvasStore);
+  _canvasStore = NULL;
+  _unpublishedRect = NSZeroRect;
+  _compressedCanvas = compressed;
+  return YES;
+}
+
+
+- (void)restoreCompressedCanvas
+{
+  if (!_compressedCanvas)
+    return;
+  
+  PTDCompressedCanvas *compressed = _compressedCanvas;
+  [self.openGLContext makeCurrentContext];
+  _compressedTexture = nil;
+  GLint width = (GLint)PTDCompressedCanvasWidth(compressed);
+  GLint height = (GLint)PTDCompressedCanvasHeight(compressed);
+  _mainBuffer = [[PTDOpenGLBufferedTexture alloc]
+      initWithOpenGLContext:self.openGLContext
+      width:width height:height
+      colorSpace:_compressedColorSpace];
+  @autoreleasepool {
+    PTDPixelBuffer canvas = _mainBuffer.bufferAsImageRep.ptd_pixelBuffer;
+    if (!PTDCompressedCanvasDecompress(compressed, &canvas))
+      NSLog(@"warning: could not decompress the canvas");
+  }
+  _compressedCanvas = NULL;
+  _compressedColorSpace = nil;
+  PTDCompressedCanvasDestroy(compressed);
+  
+  _canvasStore = PTDCanvasStoreCreate(width, height);
+  /* it was compressed from a frame, which is transparent everywhere else */
+  _unpublishedRect = _publishedContentRect;
+  if (NSIsEmptyRect(_unpublishedRect))
+    PTDCanvasStorePublish(_canvasStore, NULL, 0, 0, 0, 0);
+  /* otherwise it could be compressed again right away */
+  _lastCanvasChangeTime = NSProcessInfo.processInfo.systemUptime;
+  [PTDCanvasMemoryBudget.sharedBudget paintViewDidChangeCanvas:self];
+}
+
+
+- (void)canvasDidChangeInRect:(NSRect)rect
+{
+  rect = NSIntersectionRect(rect, self.bounds);
+  if (NSIsEmptyRect(rect))
+    return;
+  [self setNeedsDisplayInRect:rect];
+  _canvasRevision++;
+  
+  /* the buffer has its first row at the top */
+  NSRect pxRect;
+  pxRect.origin.x = rect.origin.x * _backingScaleFactor.width;
+  pxRect.origin.y = (NSHeight(self.bounds) - NSMaxY(rect)) * _backingScaleFactor.height;
+  pxRect.size.width = rect.size.width * _backingScaleFactor.width;
+  pxRect.size.height = rect.size.height * _backingScaleFactor.height;
+  _unpublishedRect = NSUnionRect(_unpublishedRect, pxRect);
+  _lastCanvasChangeTime = NSProcessInfo.processInfo.systemUptime;
+  [PTDCanvasMemoryBudget.sharedBudget paintViewDidChangeCanvas:self];
+  
+  if (!_thumbnail)
+    return;
+  [_thumbnail invalidateCanvasPixelRect:pxRect];
+  [self scheduleThumbnailRefresh];
+}
+
+
+- (void)scheduleThumbnailRefresh
+{
+  if (_thumbnailRefreshScheduled || !_thumbnail.needsUpdate)
+    return;
+  _thumbnailRefreshScheduled = YES;
+  
+  __weak PTDPaintView *weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_ThumbnailRefreshDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+    [weakSelf refreshThumbnail];
+  });
+}
+
+
+- (void)refreshThumbnail
+{
+  _thumbnailRefreshScheduled = NO;
+  if (!_thumbnail.needsUpdate)
+    return;
+  /* publishing would wait for the raster worker; the thumbnail is updated
+   * once it is done */
+  if (_workerCanvas) {
+    [self scheduleThumbnailRefresh];
+    return;
+  }
+  /* the region is taken only once it is in the store, so it is never
+   * marked as up to date from an older frame */
+  if (![self publishCanvas])
+    return;
+  
+  /* serial, so that the regions are never updated from an older frame
+   * after a newer one */
+  if (!_thumbnailQueue)
+    _thumbnailQueue = PTDTaskSerialQueueCreate();
+  PTDCanvasThumbnail *thumbnail = _thumbnail;
+  NSRect region = [thumbnail takeInvalidRegion];
+  PTDCanvasStore *store = PTDCanvasStoreRetain(_canvasStore);
+  PTDTask *task = PTDBlockTaskCreate(PTDTaskPriorityPrefetch, ^(PTDTask *unused) {
+    /* any frame published since then is just as good */
+    PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+    PTDCanvasStoreRelease(store);
+    if (!frame)
+      return;
+    [thumbnail updateRegion:region fromCanvasFrame:frame];
+    PTDCanvasFrameRelease(frame);
+  });
+  PTDTaskSetSerialQueue(task, _thumbnailQueue);
+  PTDTaskSchedulerSubmit(PTDTaskSchedulerShared(), task);
+  PTDTaskRelease(task);
+}
+
+
 - (NSGraphicsContext *)graphicsContext
 {
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
   NSBitmapImageRep *imageRep = _mainBuffer.bufferAsImageRep;
   NSGraphicsContext *ctxt = [NSGraphicsContext graphicsContextWithBitmapImageRep:imageRep];
   CGContextScaleCTM(ctxt.CGContext, _backingScaleFactor.width, _backingScaleFactor.height);
@@ -261,6 +880,8 @@
 - (void)updateBackingImages
 {
   _overlayLayer.frame = self.bounds;
+  _canvasObjectsLayer.frame = self.bounds;
+  _canvasObjects.backingScaleFactor = _backingScaleFactor;
   
   NSSize newSize = self.bounds.size;
   NSSize newPxSize = NSMakeSize(newSize.width * _backingScaleFactor.width, newSize.height * _backingScaleFactor.height);
@@ -270,16 +891,41 @@
     NSLog(@"%s: canceling because area is zero", __PRETTY_FUNCTION__);
     return;
   }
+  if (_compressedCanvas &&
+      newPxSize.width == PTDCompressedCanvasWidth(_compressedCanvas) &&
+      newPxSize.height == PTDCompressedCanvasHeight(_compressedCanvas))
+    return;
+  [self restoreCompressedCanvas];
+  [self waitForRasterWorker];
+  /* there is nothing to resample from an empty canvas */
+  BOOL blank = self.canvasEmpty;
 
   @autoreleasepool {
-    NSBitmapImageRep *oldImage = _mainBuffer.bufferAsImageRep;
+    NSBitmapImageRep *oldImage = blank ? nil : _mainBuffer.bufferAsImageRep;
     _mainBuffer = [[PTDOpenGLBufferedTexture alloc]
         initWithOpenGLContext:self.openGLContext
         width:newPxSize.width height:newPxSize.height
         colorSpace:self.window.screen.colorSpace];
+    _thumbnail = [[PTDCanvasThumbnail alloc]
+        initWithCanvasPixelWidth:_mainBuffer.pixelWidth height:_mainBuffer.pixelHeight
+        maximumArea:_ThumbnailArea];
+    /* snapshots published before keep their own frames */
+    PTDCanvasStoreRelease(_canvasStore);
+    _canvasStore = PTDCanvasStoreCreate(_mainBuffer.pixelWidth, _mainBuffer.pixelHeight);
+    _publishedContentRect = NSZeroRect;
+    _unpublishedRect = NSZeroRect;
+    if (blank)
+      PTDCanvasStorePublish(_canvasStore, NULL, 0, 0, 0, 0);
   
+    NSBitmapImageRep *newImage = _mainBuffer.bufferAsImageRep;
+    BOOL sameColorSpace = oldImage.colorSpace == newImage.colorSpace || [oldImage.colorSpace isEqual:newImage.colorSpace];
+    
     [NSGraphicsContext setCurrentContext:self.graphicsContext];
-    if (oldImage) {
+    if (oldImage && sameColorSpace) {
+      PTDPixelBuffer src = oldImage.ptd_pixelBuffer;
+      PTDPixelBuffer dst = newImage.ptd_pixelBuffer;
+      PTDResample(&src, &dst, PTDResamplingFilterForScaling(&src, &dst));
+    } else if (oldImage) {
       [oldImage
           drawInRect:(NSRect){NSZeroPoint, newSize}
           fromRect:NSZeroRect
@@ -292,27 +938,34 @@
     [NSGraphicsContext setCurrentContext:nil];
   }
   
-  [self setNeedsDisplay:YES];
+  if (blank) {
+    /* the empty frame published above is still up to date */
+    _canvasRevision++;
+    [self setNeedsDisplay:YES];
+  } else {
+    [self canvasDidChangeInRect:self.bounds];
+  }
 }
 
 
-- (void)setCursorImage:(NSImage *)cursorImage
+- (void)setOverlayCursor:(PTDCursor *)overlayCursor
 {
-  _cursorImage = cursorImage;
-  if (self.layer)
-    [self initializeCursorLayer];
+  if (overlayCursor == _overlayCursor)
+    return;
+  _overlayCursor = overlayCursor;
+  [self updateCursorLayerContents];
 }
 
 
 - (void)setCursorPosition:(NSPoint)cursorPosition
 {
   _cursorPosition = cursorPosition;
-  if (_cursorLayer) {
-    [CATransaction begin];
-    [CATransaction setDisableActions:YES];
-    _cursorLayer.position = [self ptd_backingAlignedPoint:_cursorPosition];
-    [CATransaction commit];
-  }
+  /* The cursor layer has no implicit animations, so there's no need for an
+   * explicit transaction, which would be committed on its own for every
+   * mouse event. */
+  CGPoint position = [self ptd_backingAlignedPoint:_cursorPosition];
+  if (!CGPointEqualToPoint(position, _cursorLayer.position))
+    _cursorLayer.position = position;
 }
 
 
@@ -321,13 +974,21 @@
   if (_cursorLayer)
     [_cursorLayer removeFromSuperlayer];
     
-  _cursorLayer = [CALayer layer];
+  _cursorLayer = [[PTDNoAnimeCALayer alloc] init];
   [self.layer addSublayer:_cursorLayer];
   _cursorLayer.zPosition = 100;
-  _cursorLayer.contents = self.cursorImage;
   _cursorLayer.anchorPoint = NSZeroPoint;
-  _cursorLayer.bounds = (NSRect){NSZeroPoint, self.cursorImage.size};
   _cursorLayer.position = [self ptd_backingAlignedPoint:self.cursorPosition];
+  [self updateCursorLayerContents];
+}
+
+
+- (void)updateCursorLayerContents
+{
+  CGFloat scale = MAX(1.0, self.window ? self.window.backingScaleFactor : _backingScaleFactor.width);
+  _cursorLayer.contents = (__bridge id)[_overlayCursor spriteForBackingScaleFactor:scale];
+  _cursorLayer.contentsScale = scale;
+  _cursorLayer.bounds = (NSRect){NSZeroPoint, _overlayCursor.image.size};
 }
 
 
@@ -381,9 +1042,33 @@
 
 - (void)drawBackdrop
 {
-  [_mainBuffer bindTextureAndBuffer];
+  /* the view is cleared already; an empty canvas is not even decompressed */
+  if (self.canvasEmpty)
+    return;
+  PTDOpenGLBufferedTexture *texture = _compressedTexture;
+  if (!texture) {
+    [self restoreCompressedCanvas];
+    texture = _mainBuffer;
+  }
+  if (texture != _mainBuffer) {
+    /* the canvas stays compressed, its last texture is drawn */
+    [texture bindTextureUpdatingRect:NSZeroRect fromPixels:NULL bytesPerRow:0];
+  } else if (_workerCanvas) {
+    /* the buffer is mapped by the raster worker, which is not waited for;
+     * only the changes it has finished are shown */
+    PTDPixelBuffer pixels;
+    size_t x0, y0, x1, y1;
+    if (_presentBuffer && PTDPresentBufferBeginRead(_presentBuffer, &pixels, &x0, &y0, &x1, &y1)) {
+      [_mainBuffer bindTextureUpdatingRect:NSMakeRect(x0, y0, x1 - x0, y1 - y0) fromPixels:pixels.data bytesPerRow:(NSInteger)pixels.bytesPerRow];
+      PTDPresentBufferEndRead(_presentBuffer);
+    } else {
+      [_mainBuffer bindTextureUpdatingRect:NSZeroRect fromPixels:NULL bytesPerRow:0];
+    }
+  } else {
+    [_mainBuffer bindTextureAndBuffer];
+  }
   
-  glEnable(_mainBuffer.texUnit);
+  glEnable(texture.texUnit);
   glBegin(GL_QUADS);
   glNormal3f(0.0, 0.0, 1.0);
   glTexCoord2d(0, 1); glVertex3f(-1.0, -1.0, 0.0);
@@ -391,10 +1076,10 @@
   glTexCoord2d(1, 0); glVertex3f(1.0, 1.0, 0.0);
   glTexCoord2d(1, 1); glVertex3f(1.0, -1.0, 0.0);
   glEnd();
-  glDisable(_mainBuffer.texUnit);
+  glDisable(texture.texUnit);
   
-  glBindTexture(_mainBuffer.texUnit, 0);
-  glBindBuffer(_mainBuffer.bufferUnit, 0);
+  glBindTexture(texture.texUnit, 0);
+  glBindBuffer(texture.bufferUnit, 0);
 }
 
 
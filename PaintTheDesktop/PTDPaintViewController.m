@@ -35,6 +35,11 @@
 #import "PTDRingMenuSpring.h"
 #import "PTDRingMenuWindow.h"
 #import "PTDSelectionTool.h"
+#import "PTDToolOptions.h"
+
+
+/* how many mouse moves are averaged in each line of the debug log */
+static const NSUInteger _MouseMoveLogInterval = 500;
 
 
 typedef NS_OPTIONS(NSUInteger, PTDPaintViewActivityStatus) {
@@ -72,6 +77,12 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
   NSPoint _firstMousePositionInDrag;
   BOOL _isResizing;
   BOOL _toolIsActive;
+  NSMutableDictionary <NSArray *, PTDRingMenu *> *_ringMenuCache;
+  id _optionsChangedObserver;
+  BOOL _logMouseMoves;
+  NSUInteger _mouseMoveCount;
+  CFTimeInterval _mouseMoveTotalTime, _mouseMoveMaxTime;
+  NSUInteger _mouseMoveFirstCursorMiss;
 }
 
 @dynamic view;
@@ -87,6 +98,16 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
   [_toolManager addObserver:self forKeyPath:@"currentTool" options:NSKeyValueObservingOptionPrior context:NULL];
   
   _systemCursorVisibility = YES;
+  _logMouseMoves = [NSUserDefaults.standardUserDefaults boolForKey:@"debug"];
+  
+  _ringMenuCache = [[NSMutableDictionary alloc] init];
+  NSNotificationCenter *nc = [NSNotificationCenter defaultCenter];
+  __weak PTDPaintViewController *weakSelf = self;
+  _optionsChangedObserver = [nc addObserverForName:PTDToolOptionsChangedNotification
+      object:PTDToolOptions.sharedOptions
+      queue:nil usingBlock:^(NSNotification * _Nonnull note) {
+    [weakSelf invalidateRingMenuCache];
+  }];
   
   NSTrackingAreaOptions options = NSTrackingActiveAlways |
     NSTrackingInVisibleRect | NSTrackingMouseEnteredAndExited |
@@ -110,6 +131,7 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
 {
   [_toolManager removeObserver:self forKeyPath:@"currentTool.cursor"];
   [_toolManager removeObserver:self forKeyPath:@"currentTool"];
+  [[NSNotificationCenter defaultCenter] removeObserver:_optionsChangedObserver];
 }
 
 
@@ -256,8 +278,30 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
 
 - (void)mouseMoved:(NSEvent *)event
 {
+  CFTimeInterval start = _logMouseMoves ? CACurrentMediaTime() : 0;
   self.mouseInViewOrDragging = YES;
   [self updateCursorAtPoint:[self locationForEvent:event]];
+  if (_logMouseMoves)
+    [self _logMouseMoveTime:CACurrentMediaTime() - start];
+}
+
+
+- (void)_logMouseMoveTime:(CFTimeInterval)elapsed
+{
+  if (_mouseMoveCount == 0)
+    _mouseMoveFirstCursorMiss = PTDCursor.cachedCursorMissCount;
+  _mouseMoveCount++;
+  _mouseMoveTotalTime += elapsed;
+  _mouseMoveMaxTime = MAX(_mouseMoveMaxTime, elapsed);
+  if (_mouseMoveCount < _MouseMoveLogInterval)
+    return;
+  
+  NSLog(@"mouse moved: %lu events, %.1f us average, %.1f us max on the main thread, %lu cursors generated",
+      (unsigned long)_mouseMoveCount, _mouseMoveTotalTime / _mouseMoveCount * 1e6, _mouseMoveMaxTime * 1e6,
+      (unsigned long)(PTDCursor.cachedCursorMissCount - _mouseMoveFirstCursorMiss));
+  _mouseMoveCount = 0;
+  _mouseMoveTotalTime = 0;
+  _mouseMoveMaxTime = 0;
 }
 
 
@@ -327,8 +371,33 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
 }
 
 
-- (void)openContextMenuWithEvent:(NSEvent *)event
+- (void)invalidateRingMenuCache
+{
+  [_ringMenuCache removeAllObjects];
+}
+
+
+- (NSArray *)ringMenuCacheKeyForTool:(PTDTool *)tool
 {
+  NSString *appearance = self.view.effectiveAppearance.name;
+  CGFloat scale = self.view.window.backingScaleFactor;
+  return @[[[tool class] toolIdentifier], appearance, @(scale)];
+}
+
+
+- (PTDRingMenu *)ringMenuForTool:(PTDTool *)tool
+{
+  /* Menus are built from the tool options and dropped as soon as any
+   * option changes, so any cached menu is up to date. Along with the
+   * menu, the window and the layout of its items are reused too. */
+  NSArray *key;
+  if (!tool.optionMenuDependsOnToolState) {
+    key = [self ringMenuCacheKeyForTool:tool];
+    PTDRingMenu *cached = [_ringMenuCache objectForKey:key];
+    if (cached)
+      return cached;
+  }
+  
   PTDRingMenu *ringMenu = [[PTDRingMenu alloc] init];
   PTDRingMenuRing *itemsRing = [ringMenu newRing];
   
@@ -342,13 +411,23 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
   [itemsRing addItemWithText:NSLocalizedString(@"Quit", @"") target:NSApp action:@selector(terminate:)];
   [itemsRing endGravityMassGroup];
   
+  PTDRingMenuRing *optMenu = [tool optionMenu];
+  if (optMenu)
+    [ringMenu addRing:optMenu];
+  
+  if (key)
+    [_ringMenuCache setObject:ringMenu forKey:key];
+  return ringMenu;
+}
+
+
+- (void)openContextMenuWithEvent:(NSEvent *)event
+{
   @autoreleasepool {
     PTDDrawingSurface *surf = [self drawingSurface];
     PTDTool *tool = [self initializeToolWithSurface:surf];
     
-    PTDRingMenuRing *optMenu = [tool optionMenu];
-    if (optMenu)
-      [ringMenu addRing:optMenu];
+    PTDRingMenu *ringMenu = [self ringMenuForTool:tool];
     
     [tool willOpenOptionMenuAtPoint:[self locationForEvent:event]];
     self.systemCursorVisibility = YES;
@@ -430,13 +509,14 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
 
 - (void)currentToolDidChange
 {
+  [self invalidateRingMenuCache];
   [self activateTool];
 }
 
 
 - (void)setCurrentCursor:(PTDCursor * _Nullable)currentCursor
 {
-  self.view.cursorImage = currentCursor.image;
+  self.view.overlayCursor = currentCursor;
   _currentCursor = currentCursor;
   [self updateCursorAtPoint:self.lastMousePositionInDrag];
 }
@@ -448,9 +528,10 @@ NS_INLINE BOOL PTDPaintViewActiveFromStatus(PTDPaintViewActivityStatus status)
     NSPoint hotspot = self.currentCursor.hotspot;
     self.view.cursorPosition = NSMakePoint(point.x - hotspot.x, point.y - hotspot.y);
   } else {
-    if (self.view.cursorImage) {
-      CGFloat outX = NSMaxX(self.view.paintRect) + self.view.cursorImage.size.width + 1;
-      CGFloat outY = NSMaxY(self.view.paintRect) + self.view.cursorImage.size.height + 1;
+    NSImage *cursorImage = self.view.overlayCursor.image;
+    if (cursorImage) {
+      CGFloat outX = NSMaxX(self.view.paintRect) + cursorImage.size.width + 1;
+      CGFloat outY = NSMaxY(self.view.paintRect) + cursorImage.size.height + 1;
       self.view.cursorPosition = NSMakePoint(outX, outY);
     }
   }
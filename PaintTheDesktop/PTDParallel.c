@@ -0,0 +1,94 @@
+//
+// PTDParallel.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <pthread.h>
+#endif
+#include "PTDParallel.h"
+
+
+#ifdef __APPLE__
+
+void PTDParallelApply(size_t iterations, void *context, PTDParallelFunction function)
+{
+  if (iterations == 1) {
+    function(context, 0);
+    return;
+  }
+  dispatch_apply_f(iterations, DISPATCH_APPLY_AUTO, context, function);
+}
+
+#else
+
+#define MAX_THREADS 64
+
+typedef struct {
+  _Atomic size_t next;
+  size_t iterations;
+  void *context;
+  PTDParallelFunction function;
+} PTDParallelJob;
+
+
+static void *PTDParallelWorker(void *arg)
+{
+  PTDParallelJob *job = arg;
+  size_t i;
+  while ((i = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed)) < job->iterations)
+    job->function(job->context, i);
+  return NULL;
+}
+
+
+void PTDParallelApply(size_t iterations, void *context, PTDParallelFunction function)
+{
+  if (iterations == 0)
+    return;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t threads = cpus > 1 ? (size_t)cpus : 1;
+  if (threads > iterations)
+    threads = iterations;
+  if (threads > MAX_THREADS)
+    threads = MAX_THREADS;
+  
+  PTDParallelJob job = {0, iterations, context, function};
+  pthread_t helpers[MAX_THREADS];
+  size_t started = 0;
+  for (; started + 1 < threads; started++) {
+    if (pthread_create(&helpers[started], NULL, PTDParallelWorker, &job) != 0)
+      break;
+  }
+  /* if no thread could be started, everything runs here */
+  PTDParallelWorker(&job);
+  for (size_t i = 0; i < started; i++)
+    pthread_join(helpers[i], NULL);
+}
+
+#endif
@@ -34,6 +34,9 @@ extern NSString * const PTDToolIdentifierPencilTool;
 
 @property (class, nonatomic) double smoothingCoefficient;
 @property (class, nonatomic) BOOL liveSmoothing;
+/* Replaces strokes which look like lines, polygons or ellipses with the
+ * clean shape */
+@property (class, nonatomic) BOOL shapeRecognition;
 
 @end
 
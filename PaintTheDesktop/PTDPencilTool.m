@@ -31,17 +31,146 @@
 #import "PTDCursor.h"
 #import "PTDGraphics.h"
 #import "PTDToolOptions.h"
+#import "PTDShapeRecognizer.h"
+#import "PTDStrokeFitter.h"
+#import "PTDCanvasObject.h"
+#import "NSGeometry+PTD.h"
 
 
 NSString * const PTDToolIdentifierPencilTool = @"PTDToolIdentifierPencilTool";
 
 NSString * const PTDPencilToolOptionSmoothingCoefficient = @"smoothingCoefficient";
 NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
+NSString * const PTDPencilToolOptionShapeRecognition = @"shapeRecognition";
+
+/* Maximum distance of the stroked curves from the mouse positions */
+static const double _StrokeFittingTolerance = 0.5;
+/* The curves of the stroke being drawn are shown by layers of at most this
+ * many curves, so that each event only updates a short path */
+static const size_t _OverlayChunkCurves = 64;
+
+
+#define WRAP(n, p) (((n) % (p) + (p)) % (p))
+#define ST_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+static const int smoothHistSize = 8;
+static const unsigned int smoothHistBufSize = ST_MAX(smoothHistSize*2+1, 0x20);
+static const double smoothBellMaxWidth = 5.0;
+
+/* Gaussian smoothing of the mouse positions, weighted by the distance
+ * along the stroke. Each point is output once the points after it are
+ * known, smoothHistSize points later. */
+typedef struct PTDSmoothedPathContext {
+  PTDStrokeFitter *fitter;
+  NSPoint history[smoothHistBufSize];
+  double smoothingCoeff;
+  unsigned int historyIdx;
+} PTDSmoothedPathContext;
+
+static void _PTDPencilToolSmoothedPathCalcNextPoint(PTDSmoothedPathContext *spc, NSPoint point)
+{
+  spc->history[WRAP((spc->historyIdx++), smoothHistBufSize)] = point;
+  if (spc->historyIdx <= smoothHistSize)
+    return;
+    
+  CGPoint accum = {0.0, 0.0};
+  CGFloat totalWeight = 0.0;
+  
+  int centerIdx = WRAP(spc->historyIdx - smoothHistSize - 1, smoothHistBufSize);
+  CGFloat distAccum = 0.0;
+  
+  for (int i=-smoothHistSize; i<=smoothHistSize; i++) {
+    int pi, pj;
+    if (i < 0) {
+      /* points before center, in reverse order */
+      pi = WRAP(centerIdx - smoothHistSize - i - 1, smoothHistBufSize);
+      pj = WRAP(centerIdx - smoothHistSize - i, smoothHistBufSize);
+    } else if (i == 0) {
+      pi = pj = centerIdx;
+      distAccum = 0;
+    } else {
+      /* points after center, in direct order */
+      pi = WRAP(centerIdx + i, smoothHistBufSize);
+      pj = WRAP(pi - 1, smoothHistBufSize);
+    }
+    
+    CGPoint point1 = spc->history[pi];
+    CGPoint point2 = spc->history[pj];
+    CGFloat dx = point1.x - point2.x;
+    CGFloat dy = point1.y - point2.y;
+    CGFloat dist = sqrt(dx * dx + dy * dy);
+    distAccum += dist;
+    
+    CGFloat sigma = smoothBellMaxWidth * spc->smoothingCoeff;
+    CGFloat weight = exp(-(distAccum * distAccum) / (2 * sigma * sigma));
+        
+    accum.x += point1.x * weight;
+    accum.y += point1.y * weight;
+    totalWeight += weight;
+  }
+  
+  accum.x /= totalWeight;
+  accum.y /= totalWeight;
+  
+  PTDStrokeFitterAddPoint(spc->fitter, accum.x, accum.y);
+}
+
+static void _PTDPencilToolSmoothedPathStart(PTDSmoothedPathContext *spc, NSPoint point)
+{
+  for (int i=0; i<smoothHistBufSize; i++)
+    spc->history[i] = point;
+  spc->historyIdx = 0;
+  _PTDPencilToolSmoothedPathCalcNextPoint(spc, point);
+}
+
+/* Outputs the points still waiting for the points after them */
+static void _PTDPencilToolSmoothedPathFinish(PTDSmoothedPathContext *spc)
+{
+  NSPoint lastPoint = spc->history[WRAP(spc->historyIdx - 1, smoothHistBufSize)];
+  for (int i=0; i<smoothHistSize; i++)
+    _PTDPencilToolSmoothedPathCalcNextPoint(spc, lastPoint);
+}
+
+
+static CGPathRef PTDPencilToolCreatePathWithStrokeFitter(PTDStrokeFitter *fitter)
+{
+  CGMutablePathRef path = CGPathCreateMutable();
+  size_t curveCount, pendingCount;
+  const double *curves = PTDStrokeFitterCurves(fitter, &curveCount);
+  const double *pending = PTDStrokeFitterPendingPoints(fitter, &pendingCount);
+  
+  /* the pending points start at the end of the curves */
+  if (curves) {
+    CGPathMoveToPoint(path, NULL, curves[0], curves[1]);
+    for (size_t i = 0; i < curveCount; i++) {
+      const double *c = curves + 2 + 6 * i;
+      CGPathAddCurveToPoint(path, NULL, c[0], c[1], c[2], c[3], c[4], c[5]);
+    }
+  } else if (pendingCount > 0) {
+    CGPathMoveToPoint(path, NULL, pending[0], pending[1]);
+  }
+  for (size_t i = 1; i < pendingCount; i++)
+    CGPathAddLineToPoint(path, NULL, pending[2*i], pending[2*i+1]);
+  return path;
+}
 
 
 @implementation PTDPencilTool {
-  CGMutablePathRef _currentPath;
-  CAShapeLayer *_overlayShape;
+  PTDShapeRecognizer *_recognizer;
+  PTDStrokeFitter *_fitter;
+  /* the smoothed points, when smoothing is enabled */
+  PTDStrokeFitter *_smoothedFitter;
+  PTDSmoothedPathContext _smoothing;
+  BOOL _smoothingEnabled;
+  /* the fitter whose curves are shown while drawing */
+  PTDStrokeFitter *_overlayFitter;
+  
+  CALayer *_overlayLayer;
+  CAShapeLayer *_overlayCurvesShape;
+  CGMutablePathRef _overlayCurvesPath;
+  size_t _overlayCurveCount;
+  size_t _overlayChunkCurveCount;
+  CAShapeLayer *_overlayPendingShape;
 }
 
 
@@ -50,6 +179,7 @@ NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
   PTDToolOptions *o = PTDToolOptions.sharedOptions;
   [o registerOption:PTDPencilToolOptionSmoothingCoefficient ofToolClass:self types:@[[NSNumber class]] defaultValue:@(0.5) validationBlock:nil];
   [o registerOption:PTDPencilToolOptionLiveSmoothing ofToolClass:self types:@[[NSNumber class]] defaultValue:@(NO) validationBlock:nil];
+  [o registerOption:PTDPencilToolOptionShapeRecognition ofToolClass:self types:@[[NSNumber class]] defaultValue:@(NO) validationBlock:nil];
 }
 
 
@@ -61,7 +191,7 @@ NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
 
 + (double)smoothingCoefficient
 {
-  return [[PTDToolOptions.sharedOptions objectForOption:PTDPencilToolOptionSmoothingCoefficient ofToolClass:self.class] doubleValue];
+  return [PTDToolOptions.sharedOptions doubleForOption:PTDPencilToolOptionSmoothingCoefficient ofToolClass:self.class];
 }
 
 
@@ -73,7 +203,19 @@ NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
 
 + (BOOL)liveSmoothing
 {
-  return [[PTDToolOptions.sharedOptions objectForOption:PTDPencilToolOptionLiveSmoothing ofToolClass:self.class] boolValue];
+  return [PTDToolOptions.sharedOptions boolForOption:PTDPencilToolOptionLiveSmoothing ofToolClass:self.class];
+}
+
+
++ (void)setShapeRecognition:(BOOL)shapeRecognition
+{
+  [PTDToolOptions.sharedOptions setObject:@(shapeRecognition) forOption:PTDPencilToolOptionShapeRecognition ofToolClass:self.class];
+}
+
+
++ (BOOL)shapeRecognition
+{
+  return [PTDToolOptions.sharedOptions boolForOption:PTDPencilToolOptionShapeRecognition ofToolClass:self.class];
 }
 
 
@@ -83,6 +225,15 @@ NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
 }
 
 
+- (void)dealloc
+{
+  PTDShapeRecognizerDestroy(_recognizer);
+  PTDStrokeFitterDestroy(_fitter);
+  PTDStrokeFitterDestroy(_smoothedFitter);
+  CGPathRelease(_overlayCurvesPath);
+}
+
+
 - (void)activate
 {
   [self updateCursor];
@@ -91,22 +242,80 @@ NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
 
 - (void)dragDidStartAtPoint:(NSPoint)point
 {
-  _currentPath = CGPathCreateMutable();
-  CGPathMoveToPoint(_currentPath, NULL, point.x, point.y);
+  if (!_fitter)
+    _fitter = PTDStrokeFitterCreate(_StrokeFittingTolerance);
+  else
+    PTDStrokeFitterReset(_fitter);
+  if (_fitter)
+    PTDStrokeFitterAddPoint(_fitter, point.x, point.y);
+  
+  /* the smoothed stroke is fitted while it is drawn as well, instead of
+   * smoothing all of it again for every event */
+  double smoothingCoefficient = [self.class smoothingCoefficient];
+  _smoothingEnabled = smoothingCoefficient > 0.001;
+  if (_smoothingEnabled) {
+    if (!_smoothedFitter)
+      _smoothedFitter = PTDStrokeFitterCreate(_StrokeFittingTolerance);
+    else
+      PTDStrokeFitterReset(_smoothedFitter);
+    _smoothing.fitter = _smoothedFitter;
+    _smoothing.smoothingCoeff = smoothingCoefficient;
+    if (_smoothedFitter)
+      _PTDPencilToolSmoothedPathStart(&_smoothing, point);
+  }
+  
+  if ([self.class shapeRecognition]) {
+    if (!_recognizer)
+      _recognizer = PTDShapeRecognizerCreate();
+    else
+      PTDShapeRecognizerReset(_recognizer);
+    if (_recognizer)
+      PTDShapeRecognizerAddPoint(_recognizer, point.x, point.y);
+  } else {
+    PTDShapeRecognizerDestroy(_recognizer);
+    _recognizer = NULL;
+  }
+  
   [self createDragIndicator];
 }
 
 
 - (void)dragDidContinueFromPoint:(NSPoint)prevPoint toPoint:(NSPoint)nextPoint
 {
-  CGPathAddLineToPoint(_currentPath, NULL, nextPoint.x, nextPoint.y);
+  if (_fitter)
+    PTDStrokeFitterAddPoint(_fitter, nextPoint.x, nextPoint.y);
+  if (_smoothingEnabled && _smoothedFitter)
+    _PTDPencilToolSmoothedPathCalcNextPoint(&_smoothing, nextPoint);
+  if (_recognizer)
+    PTDShapeRecognizerAddPoint(_recognizer, nextPoint.x, nextPoint.y);
   [self updateDragIndicator];
 }
 
 
 - (void)dragDidEndAtPoint:(NSPoint)point
 {
-  [self.currentDrawingSurface beginCanvasDrawing];
+  PTDCanvasObject *shape = _recognizer ? [self recognizedShapeCanvasObject] : nil;
+  if (shape) {
+    [self.currentDrawingSurface addCanvasObject:shape];
+    [self removeDragIndicator];
+    return;
+  }
+  
+  PTDStrokeFitter *fitter = _fitter;
+  if (_smoothingEnabled && _smoothedFitter) {
+    _PTDPencilToolSmoothedPathFinish(&_smoothing);
+    fitter = _smoothedFitter;
+  }
+  if (!fitter || !PTDStrokeFitterFinish(fitter)) {
+    NSLog(@"warning: could not fit the stroke");
+    [self removeDragIndicator];
+    return;
+  }
+  CGPathRef path = PTDPencilToolCreatePathWithStrokeFitter(fitter);
+  CGFloat outset = -(self.size / 2.0 + 1.0);
+  NSRect strokeRect = NSInsetRect(CGPathGetBoundingBox(path), outset, outset);
+  
+  [self.currentDrawingSurface beginCanvasDrawingInRect:strokeRect];
   
   CGContextRef ctxt = NSGraphicsContext.currentContext.CGContext;
   CGContextBeginPath(ctxt);
@@ -114,112 +323,52 @@ NSString * const PTDPencilToolOptionLiveSmoothing = @"liveSmoothing";
   CGContextSetLineJoin(ctxt, kCGLineJoinRound);
   CGContextSetLineWidth(ctxt, self.size);
   CGContextSetStrokeColorWithColor(ctxt, self.color.CGColor);
+  CGContextAddPath(ctxt, path);
+  CGPathRelease(path);
   
-  if ([self.class smoothingCoefficient] > 0.001) {
-    CGContextAddPath(ctxt, [self smoothedPath]);
-  } else {
-    CGContextAddPath(ctxt, _currentPath);
-  }
-  
+  [self.currentDrawingSurface canvasDidChangeInRect:strokeRect];
   CGContextStrokePath(ctxt);
-  CGPathRelease(_currentPath);
   [self removeDragIndicator];
 }
 
 
-#define WRAP(n, p) (((n) % (p) + (p)) % (p))
-#define ST_MAX(a, b) ((a) > (b) ? (a) : (b))
-
-static const int smoothHistSize = 8;
-static const unsigned int smoothHistBufSize = ST_MAX(smoothHistSize*2+1, 0x20);
-static const double smoothBellMaxWidth = 5.0;
-
-typedef struct PTDSmoothedPathContext {
-  CGMutablePathRef smoothedPath;
-  NSPoint history[smoothHistBufSize];
-  double smoothingCoeff;
-  unsigned int historyIdx;
-  BOOL pathStarted;
-} PTDSmoothedPathContext;
-
-static void _PTDPencilToolSmoothedPathCallback(void *info, const CGPathElement *element)
-{
-  PTDSmoothedPathContext *spc = (PTDSmoothedPathContext *)info;
-  if (element->type == kCGPathElementMoveToPoint) {
-    for (int i=0; i<smoothHistBufSize; i++)
-      spc->history[i] = element->points[0];
-  }
-  _PTDPencilToolSmoothedPathCalcNextPoint(spc, element->points[0]);
-}
-
-static void _PTDPencilToolSmoothedPathCalcNextPoint(PTDSmoothedPathContext *spc, NSPoint point)
+- (nullable PTDCanvasObject *)recognizedShapeCanvasObject
 {
-  spc->history[WRAP((spc->historyIdx++), smoothHistBufSize)] = point;
-  if (spc->historyIdx <= smoothHistSize)
-    return;
-    
-  CGPoint accum = {0.0, 0.0};
-  CGFloat totalWeight = 0.0;
-  
-  int centerIdx = WRAP(spc->historyIdx - smoothHistSize - 1, smoothHistBufSize);
-  CGFloat distAccum = 0.0;
+  PTDRecognizedShape shape;
+  if (!PTDShapeRecognizerRecognize(_recognizer, &shape))
+    return nil;
   
-  for (int i=-smoothHistSize; i<=smoothHistSize; i++) {
-    int pi, pj;
-    if (i < 0) {
-      /* points before center, in reverse order */
-      pi = WRAP(centerIdx - smoothHistSize - i - 1, smoothHistBufSize);
-      pj = WRAP(centerIdx - smoothHistSize - i, smoothHistBufSize);
-    } else if (i == 0) {
-      pi = pj = centerIdx;
-      distAccum = 0;
-    } else {
-      /* points after center, in direct order */
-      pi = WRAP(centerIdx + i, smoothHistBufSize);
-      pj = WRAP(pi - 1, smoothHistBufSize);
-    }
-    
-    CGPoint point1 = spc->history[pi];
-    CGPoint point2 = spc->history[pj];
-    CGFloat dx = point1.x - point2.x;
-    CGFloat dy = point1.y - point2.y;
-    CGFloat dist = sqrt(dx * dx + dy * dy);
-    distAccum += dist;
-    
-    CGFloat sigma = smoothBellMaxWidth * spc->smoothingCoeff;
-    CGFloat weight = exp(-(distAccum * distAccum) / (2 * sigma * sigma));
-        
-    accum.x += point1.x * weight;
-    accum.y += point1.y * weight;
-    totalWeight += weight;
+  if (shape.kind == PTDRecognizedShapeKindRectangle) {
+    NSRect rect = PTD_NSMakeRectFromPoints(
+        NSMakePoint(shape.vertices[0], shape.vertices[1]),
+        NSMakePoint(shape.vertices[4], shape.vertices[5]));
+    return [[PTDPrimitiveShapeCanvasObject alloc] initWithKind:PTDShapeRasterKindRectangle rect:rect cornerRadius:0.0 lineWidth:self.size color:self.color filled:NO];
   }
   
-  accum.x /= totalWeight;
-  accum.y /= totalWeight;
-  
-  if (!spc->pathStarted) {
-    spc->pathStarted = YES;
-    CGPathMoveToPoint(spc->smoothedPath, NULL, accum.x, accum.y);
+  NSBezierPath *path;
+  if (shape.kind == PTDRecognizedShapeKindEllipse) {
+    NSRect rect = NSMakeRect(-shape.radiusX, -shape.radiusY, shape.radiusX * 2.0, shape.radiusY * 2.0);
+    if (shape.rotation == 0.0) {
+      rect = NSOffsetRect(rect, shape.centerX, shape.centerY);
+      return [[PTDPrimitiveShapeCanvasObject alloc] initWithKind:PTDShapeRasterKindOval rect:rect cornerRadius:0.0 lineWidth:self.size color:self.color filled:NO];
+    }
+    path = [NSBezierPath bezierPathWithOvalInRect:rect];
+    NSAffineTransform *transform = [NSAffineTransform transform];
+    [transform translateXBy:shape.centerX yBy:shape.centerY];
+    [transform rotateByRadians:shape.rotation];
+    [path transformUsingAffineTransform:transform];
   } else {
-    CGPathAddLineToPoint(spc->smoothedPath, NULL, accum.x, accum.y);
+    path = [NSBezierPath bezierPath];
+    [path moveToPoint:NSMakePoint(shape.vertices[0], shape.vertices[1])];
+    for (size_t i = 1; i < shape.vertexCount; i++)
+      [path lineToPoint:NSMakePoint(shape.vertices[2*i], shape.vertices[2*i+1])];
+    if (shape.kind == PTDRecognizedShapeKindPolygon)
+      [path closePath];
   }
-}
-
-- (CGPathRef)smoothedPath
-{
-  PTDSmoothedPathContext spc;
-  spc.smoothedPath = CGPathCreateMutable();
-  spc.historyIdx = 0;
-  spc.smoothingCoeff = [self.class smoothingCoefficient];
-  spc.pathStarted = NO;
-  
-  CGPathApply(_currentPath, &spc, _PTDPencilToolSmoothedPathCallback);
-  
-  NSPoint lastPoint = spc.history[WRAP(spc.historyIdx - 1, smoothHistBufSize)];
-  for (int i=0; i<smoothHistSize; i++)
-    _PTDPencilToolSmoothedPathCalcNextPoint(&spc, lastPoint);
-  
-  return CFAutorelease(spc.smoothedPath);
+  path.lineWidth = self.size;
+  path.lineCapStyle = NSLineCapStyleRound;
+  path.lineJoinStyle = NSLineJoinStyleRound;
+  return [[PTDShapeCanvasObject alloc] initWithPath:path color:self.color];
 }
 
 
@@ -236,45 +385,144 @@ static void _PTDPencilToolSmoothedPathCalcNextPoint(PTDSmoothedPathContext *spc,
 }
 
 
+- (nullable PTDRingMenuRing *)optionMenu
+{
+  PTDRingMenuRing *res = [super optionMenu];
+  
+  PTDRingMenuItem *itm = [res addItemWithText:NSLocalizedString(@"Snap Shapes", @"Menu item for toggling shape recognition") target:self action:@selector(toggleShapeRecognition:)];
+  if ([self.class shapeRecognition])
+    itm.state = NSControlStateValueOn;
+  [res addSpringWithElasticity:1000];
+  
+  return res;
+}
+
+
+- (void)toggleShapeRecognition:(id)sender
+{
+  [self.class setShapeRecognition:![self.class shapeRecognition]];
+}
+
+
 - (void)updateCursor
 {
-  PTDCursor *cursor = [[PTDCursor alloc] init];
-  cursor.image = PTDCrosshairWithBrushOutlineImage(self.size, self.color);
-  cursor.hotspot = NSMakePoint(cursor.image.size.width / 2.0, cursor.image.size.height / 2.0);
-  self.cursor = cursor;
+  CGFloat size = self.size;
+  NSColor *color = self.color;
+  self.cursor = [PTDCursor cachedCursorWithKey:@[@"crosshairWithBrushOutline", @(size), color] generator:^PTDCursor *{
+    PTDCursor *cursor = [[PTDCursor alloc] init];
+    cursor.image = PTDCrosshairWithBrushOutlineImage(size, color);
+    cursor.hotspot = NSMakePoint(cursor.image.size.width / 2.0, cursor.image.size.height / 2.0);
+    return cursor;
+  }];
 }
 
 
 - (void)createDragIndicator
 {
-  _overlayShape = [[CAShapeLayer alloc] init];
-  [self.currentDrawingSurface.overlayLayer addSublayer:_overlayShape];
-  _overlayShape.lineWidth = self.size;
-  _overlayShape.strokeColor = self.color.CGColor;
-  _overlayShape.fillColor = NSColor.clearColor.CGColor;
-  _overlayShape.lineCap = kCALineCapRound;
-  _overlayShape.lineJoin = kCALineJoinRound;
-  _overlayShape.frame = self.currentDrawingSurface.overlayLayer.bounds;
+  /* The stroke is drawn opaque and made translucent by the container,
+   * so that it looks the same where the chunks overlap. */
+  NSColor *color = self.color;
+  CALayer *overlayLayer = self.currentDrawingSurface.overlayLayer;
+  _overlayLayer = [[CALayer alloc] init];
+  _overlayLayer.frame = overlayLayer.bounds;
+  _overlayLayer.opacity = (float)color.alphaComponent;
+  _overlayLayer.allowsGroupOpacity = YES;
+  [overlayLayer addSublayer:_overlayLayer];
+  
+  _overlayFitter = _smoothingEnabled && [self.class liveSmoothing] && _smoothedFitter ? _smoothedFitter : _fitter;
+  _overlayCurveCount = 0;
+  [self startOverlayCurvesChunk];
+  _overlayPendingShape = [self newOverlayShape];
   [self updateDragIndicator];
 }
 
 
+- (CAShapeLayer *)newOverlayShape
+{
+  CAShapeLayer *shape = [[CAShapeLayer alloc] init];
+  shape.lineWidth = self.size;
+  shape.strokeColor = [self.color colorWithAlphaComponent:1.0].CGColor;
+  shape.fillColor = NSColor.clearColor.CGColor;
+  shape.lineCap = kCALineCapRound;
+  shape.lineJoin = kCALineJoinRound;
+  shape.frame = _overlayLayer.bounds;
+  [_overlayLayer addSublayer:shape];
+  return shape;
+}
+
+
+/* Leaves the curves shown up to now in their own layer, which does not
+ * change anymore, and continues in a new one */
+- (void)startOverlayCurvesChunk
+{
+  CGPathRelease(_overlayCurvesPath);
+  _overlayCurvesPath = NULL;
+  _overlayChunkCurveCount = 0;
+  _overlayCurvesShape = [self newOverlayShape];
+}
+
+
 - (void)updateDragIndicator
 {
+  if (!_overlayFitter)
+    return;
   [CATransaction begin];
   CATransaction.disableActions = YES;
-  if (![self.class liveSmoothing] || [self.class smoothingCoefficient] <= 0.001)
-    _overlayShape.path = _currentPath;
-  else
-    _overlayShape.path = [self smoothedPath];
+  
+  size_t curveCount;
+  const double *curves = PTDStrokeFitterCurves(_overlayFitter, &curveCount);
+  if (curveCount > _overlayCurveCount) {
+    for (size_t i = _overlayCurveCount; i < curveCount; i++) {
+      if (_overlayChunkCurveCount == _OverlayChunkCurves)
+        [self startOverlayCurvesChunk];
+      const double *c = curves + 6 * i;
+      if (!_overlayCurvesPath) {
+        _overlayCurvesPath = CGPathCreateMutable();
+        CGPathMoveToPoint(_overlayCurvesPath, NULL, c[0], c[1]);
+      }
+      CGPathAddCurveToPoint(_overlayCurvesPath, NULL, c[2], c[3], c[4], c[5], c[6], c[7]);
+      _overlayChunkCurveCount++;
+    }
+    _overlayCurveCount = curveCount;
+    _overlayCurvesShape.path = _overlayCurvesPath;
+  }
+  
+  /* the points not fitted yet, and the mouse positions still waiting to
+   * be smoothed */
+  size_t pendingCount;
+  const double *pending = PTDStrokeFitterPendingPoints(_overlayFitter, &pendingCount);
+  CGMutablePathRef path = CGPathCreateMutable();
+  if (pendingCount > 0) {
+    CGPathMoveToPoint(path, NULL, pending[0], pending[1]);
+    for (size_t i = 1; i < pendingCount; i++)
+      CGPathAddLineToPoint(path, NULL, pending[2*i], pending[2*i+1]);
+  }
+  if (_overlayFitter == _smoothedFitter) {
+    unsigned int count = MIN(_smoothing.historyIdx, (unsigned int)smoothHistSize);
+    for (unsigned int i = count; i > 0; i--) {
+      NSPoint p = _smoothing.history[WRAP(_smoothing.historyIdx - i, smoothHistBufSize)];
+      if (CGPathIsEmpty(path))
+        CGPathMoveToPoint(path, NULL, p.x, p.y);
+      else
+        CGPathAddLineToPoint(path, NULL, p.x, p.y);
+    }
+  }
+  _overlayPendingShape.path = path;
+  CGPathRelease(path);
+  
   [CATransaction commit];
 }
 
 
 - (void)removeDragIndicator
 {
-  [_overlayShape removeFromSuperlayer];
-  _overlayShape = nil;
+  [_overlayLayer removeFromSuperlayer];
+  _overlayLayer = nil;
+  _overlayCurvesShape = nil;
+  _overlayPendingShape = nil;
+  CGPathRelease(_overlayCurvesPath);
+  _overlayCurvesPath = NULL;
+  _overlayFitter = NULL;
 }
 
 
@@ -28,6 +28,7 @@
 #import "PTDAppDelegate.h"
 #import "PTDPencilTool.h"
 #import "PTDTextTool.h"
+#import "PTDBlockTask.h"
 
 
 @interface PTDPreferencesWindowController ()
@@ -171,7 +172,7 @@
   
   NSString *initialFontName = PTDTextTool.baseFontName;
   
-  dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0), ^{
+  PTDBlockTaskSubmit(PTDTaskPriorityInteractive, ^{
     [self populateFontMenuInBackgroundWithInitialSelection:initialFontName];
   });
 }
@@ -0,0 +1,135 @@
+//
+// PTDPresentBuffer.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "PTDPresentBuffer.h"
+#include "PTDBufferPool.h"
+
+
+struct PTDPresentBuffer {
+  PTDPixelBuffer pixels;
+  pthread_mutex_t lock;
+  /* empty when x0 >= x1 */
+  size_t x0, y0, x1, y1;
+};
+
+
+PTDPresentBuffer *PTDPresentBufferCreate(size_t width, size_t height)
+{
+  PTDPresentBuffer *buffer = calloc(1, sizeof(PTDPresentBuffer));
+  if (!buffer)
+    return NULL;
+  /* only the changed rects are ever read, so it is not cleared */
+  buffer->pixels.width = width;
+  buffer->pixels.height = height;
+  buffer->pixels.bytesPerRow = width * 4;
+  buffer->pixels.data = PTDBufferPoolAlloc(buffer->pixels.bytesPerRow * height);
+  if (!buffer->pixels.data) {
+    free(buffer);
+    return NULL;
+  }
+  pthread_mutex_init(&buffer->lock, NULL);
+  return buffer;
+}
+
+
+void PTDPresentBufferDestroy(PTDPresentBuffer *buffer)
+{
+  if (!buffer)
+    return;
+  pthread_mutex_destroy(&buffer->lock);
+  PTDBufferPoolFree(buffer->pixels.data, buffer->pixels.bytesPerRow * buffer->pixels.height);
+  free(buffer);
+}
+
+
+static void PTDPresentBufferCopy(PTDPresentBuffer *buffer, const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+  PTDPixelBuffer *dst = &buffer->pixels;
+  if (x0 >= x1)
+    return;
+  for (size_t y = y0; y < y1; y++)
+    memcpy(dst->data + y * dst->bytesPerRow + x0 * 4, canvas->data + y * canvas->bytesPerRow + x0 * 4, (x1 - x0) * 4);
+}
+
+
+void PTDPresentBufferUpdate(PTDPresentBuffer *buffer, const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+  x1 = x1 < buffer->pixels.width ? x1 : buffer->pixels.width;
+  y1 = y1 < buffer->pixels.height ? y1 : buffer->pixels.height;
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  
+  pthread_mutex_lock(&buffer->lock);
+  PTDPresentBufferCopy(buffer, canvas, x0, y0, x1, y1);
+  if (buffer->x0 >= buffer->x1) {
+    buffer->x0 = x0;
+    buffer->y0 = y0;
+    buffer->x1 = x1;
+    buffer->y1 = y1;
+  } else {
+    /* The reader gets the bounding box of the changed rects, so the parts
+     * it grows by are copied as well; the canvas does not change while
+     * this runs. */
+    size_t bx0 = x0 < buffer->x0 ? x0 : buffer->x0;
+    size_t by0 = y0 < buffer->y0 ? y0 : buffer->y0;
+    size_t bx1 = x1 > buffer->x1 ? x1 : buffer->x1;
+    size_t by1 = y1 > buffer->y1 ? y1 : buffer->y1;
+    PTDPresentBufferCopy(buffer, canvas, bx0, by0, bx1, buffer->y0);
+    PTDPresentBufferCopy(buffer, canvas, bx0, buffer->y1, bx1, by1);
+    PTDPresentBufferCopy(buffer, canvas, bx0, buffer->y0, buffer->x0, buffer->y1);
+    PTDPresentBufferCopy(buffer, canvas, buffer->x1, buffer->y0, bx1, buffer->y1);
+    buffer->x0 = bx0;
+    buffer->y0 = by0;
+    buffer->x1 = bx1;
+    buffer->y1 = by1;
+  }
+  pthread_mutex_unlock(&buffer->lock);
+}
+
+
+int PTDPresentBufferBeginRead(PTDPresentBuffer *buffer, PTDPixelBuffer *pixels, size_t *x0, size_t *y0, size_t *x1, size_t *y1)
+{
+  pthread_mutex_lock(&buffer->lock);
+  if (buffer->x0 >= buffer->x1) {
+    pthread_mutex_unlock(&buffer->lock);
+    return 0;
+  }
+  *pixels = buffer->pixels;
+  *x0 = buffer->x0;
+  *y0 = buffer->y0;
+  *x1 = buffer->x1;
+  *y1 = buffer->y1;
+  buffer->x0 = buffer->y0 = buffer->x1 = buffer->y1 = 0;
+  return 1;
+}
+
+
+void PTDPresentBufferEndRead(PTDPresentBuffer *buffer)
+{
+  pthread_mutex_unlock(&buffer->lock);
+}
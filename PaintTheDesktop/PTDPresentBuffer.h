@@ -0,0 +1,62 @@
+//
+// PTDPresentBuffer.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDPresentBuffer_h
+#define PTDPresentBuffer_h
+
+#include <stddef.h>
+#include "PTDResampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The second buffer of a canvas which is being changed on another thread.
+ * After each change the writer copies the rect it changed into it, and the
+ * reader takes the pixels changed since it last looked, so that it can show
+ * every finished change without waiting for the ones still running. Both
+ * sides only hold the lock for the copy of the changed rect. */
+typedef struct PTDPresentBuffer PTDPresentBuffer;
+
+/* Returns NULL if the buffer cannot be allocated. */
+PTDPresentBuffer *PTDPresentBufferCreate(size_t width, size_t height);
+void PTDPresentBufferDestroy(PTDPresentBuffer *buffer);
+
+/* Writer. Copies the rect, in pixels, from the canvas, which must have the
+ * size of the buffer, and adds it to the changed rect. The canvas must not
+ * change while this runs. */
+void PTDPresentBufferUpdate(PTDPresentBuffer *buffer, const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1);
+
+/* Reader. Returns zero if nothing changed; otherwise locks the buffer,
+ * returns its pixels and the changed rect, and forgets the rect. The buffer
+ * stays locked until PTDPresentBufferEndRead is called. */
+int PTDPresentBufferBeginRead(PTDPresentBuffer *buffer, PTDPixelBuffer *pixels, size_t *x0, size_t *y0, size_t *x1, size_t *y1);
+void PTDPresentBufferEndRead(PTDPresentBuffer *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDPresentBuffer_h */
@@ -0,0 +1,197 @@
+//
+// PTDRasterWorker.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "PTDRasterWorker.h"
+
+
+typedef struct {
+  PTDRasterWorkerFunction function;
+  void *context;
+} PTDRasterWorkerCommand;
+
+struct PTDRasterWorker {
+  PTDRasterWorkerCommand *ring;
+  size_t mask;
+  
+  /* both only ever grow; a slot is reused only after the command in it
+   * has finished running */
+  _Atomic size_t head;
+  _Atomic size_t tail;
+  
+  _Atomic bool workerSleeping;
+  _Atomic bool producerSleeping;
+  _Atomic bool stop;
+  
+  pthread_mutex_t lock;
+  pthread_cond_t workerWakeup;
+  pthread_cond_t producerWakeup;
+  pthread_t thread;
+};
+
+
+static void *PTDRasterWorkerRun(void *arg)
+{
+  PTDRasterWorker *worker = arg;
+  size_t head = atomic_load_explicit(&worker->head, memory_order_relaxed);
+  
+  for (;;) {
+    size_t tail = atomic_load_explicit(&worker->tail, memory_order_acquire);
+    
+    if (head == tail) {
+      /* The flag is set before checking the queue again, and the producer
+       * checks the flag after publishing a command, so at least one of
+       * the two sees the other's store. */
+      pthread_mutex_lock(&worker->lock);
+      atomic_store(&worker->workerSleeping, true);
+      while (atomic_load(&worker->tail) == head && !atomic_load(&worker->stop))
+        pthread_cond_wait(&worker->workerWakeup, &worker->lock);
+      atomic_store(&worker->workerSleeping, false);
+      pthread_mutex_unlock(&worker->lock);
+      
+      if (atomic_load_explicit(&worker->tail, memory_order_acquire) == head)
+        break;
+      continue;
+    }
+    
+    PTDRasterWorkerCommand *cmd = &worker->ring[head & worker->mask];
+    cmd->function(cmd->context);
+    head++;
+    atomic_store(&worker->head, head);
+    
+    if (atomic_load(&worker->producerSleeping)) {
+      pthread_mutex_lock(&worker->lock);
+      pthread_cond_signal(&worker->producerWakeup);
+      pthread_mutex_unlock(&worker->lock);
+    }
+  }
+  
+  return NULL;
+}
+
+
+PTDRasterWorker *PTDRasterWorkerCreate(size_t capacity)
+{
+  size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+  
+  PTDRasterWorker *worker = calloc(1, sizeof(PTDRasterWorker));
+  if (!worker)
+    return NULL;
+  worker->ring = calloc(size, sizeof(PTDRasterWorkerCommand));
+  if (!worker->ring) {
+    free(worker);
+    return NULL;
+  }
+  worker->mask = size - 1;
+  atomic_init(&worker->head, 0);
+  atomic_init(&worker->tail, 0);
+  atomic_init(&worker->workerSleeping, false);
+  atomic_init(&worker->producerSleeping, false);
+  atomic_init(&worker->stop, false);
+  pthread_mutex_init(&worker->lock, NULL);
+  pthread_cond_init(&worker->workerWakeup, NULL);
+  pthread_cond_init(&worker->producerWakeup, NULL);
+  
+  if (pthread_create(&worker->thread, NULL, PTDRasterWorkerRun, worker) != 0) {
+    pthread_cond_destroy(&worker->producerWakeup);
+    pthread_cond_destroy(&worker->workerWakeup);
+    pthread_mutex_destroy(&worker->lock);
+    free(worker->ring);
+    free(worker);
+    return NULL;
+  }
+  return worker;
+}
+
+
+void PTDRasterWorkerDestroy(PTDRasterWorker *worker)
+{
+  if (!worker)
+    return;
+  
+  pthread_mutex_lock(&worker->lock);
+  atomic_store(&worker->stop, true);
+  pthread_cond_signal(&worker->workerWakeup);
+  pthread_mutex_unlock(&worker->lock);
+  pthread_join(worker->thread, NULL);
+  
+  pthread_cond_destroy(&worker->producerWakeup);
+  pthread_cond_destroy(&worker->workerWakeup);
+  pthread_mutex_destroy(&worker->lock);
+  free(worker->ring);
+  free(worker);
+}
+
+
+static void PTDRasterWorkerWaitForHead(PTDRasterWorker *worker, size_t minHead)
+{
+  if (atomic_load_explicit(&worker->head, memory_order_acquire) >= minHead)
+    return;
+  
+  pthread_mutex_lock(&worker->lock);
+  atomic_store(&worker->producerSleeping, true);
+  while (atomic_load(&worker->head) < minHead)
+    pthread_cond_wait(&worker->producerWakeup, &worker->lock);
+  atomic_store(&worker->producerSleeping, false);
+  pthread_mutex_unlock(&worker->lock);
+}
+
+
+void PTDRasterWorkerEnqueue(PTDRasterWorker *worker, PTDRasterWorkerFunction function, void *context)
+{
+  size_t tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+  if (tail > worker->mask)
+    PTDRasterWorkerWaitForHead(worker, tail - worker->mask);
+  
+  PTDRasterWorkerCommand *cmd = &worker->ring[tail & worker->mask];
+  cmd->function = function;
+  cmd->context = context;
+  atomic_store(&worker->tail, tail + 1);
+  
+  if (atomic_load(&worker->workerSleeping)) {
+    pthread_mutex_lock(&worker->lock);
+    pthread_cond_signal(&worker->workerWakeup);
+    pthread_mutex_unlock(&worker->lock);
+  }
+}
+
+
+bool PTDRasterWorkerIsIdle(PTDRasterWorker *worker)
+{
+  size_t tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+  return atomic_load_explicit(&worker->head, memory_order_acquire) == tail;
+}
+
+
+void PTDRasterWorkerWaitUntilIdle(PTDRasterWorker *worker)
+{
+  size_t tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+  PTDRasterWorkerWaitForHead(worker, tail);
+}
@@ -0,0 +1,63 @@
+//
+// PTDRasterWorker.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef PTDRasterWorker_h
+#define PTDRasterWorker_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*PTDRasterWorkerFunction)(void *context);
+
+/* A thread which runs commands in the order they were enqueued. Commands
+ * are passed through a lock-free single producer, single consumer ring;
+ * the mutex is only taken by a side which has to go to sleep, or to wake
+ * the other side up. All the functions below must be called from the
+ * same thread, which is the only producer. */
+typedef struct PTDRasterWorker PTDRasterWorker;
+
+/* The capacity is rounded up to a power of two. */
+PTDRasterWorker *PTDRasterWorkerCreate(size_t capacity);
+/* Runs the commands still in the queue before returning. */
+void PTDRasterWorkerDestroy(PTDRasterWorker *worker);
+
+/* Waits for a free slot if the queue is full. */
+void PTDRasterWorkerEnqueue(PTDRasterWorker *worker, PTDRasterWorkerFunction function, void *context);
+
+/* After these return true, everything written by the commands run so far
+ * is visible to the producer. */
+bool PTDRasterWorkerIsIdle(PTDRasterWorker *worker);
+void PTDRasterWorkerWaitUntilIdle(PTDRasterWorker *worker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDRasterWorker_h */
@@ -24,6 +24,7 @@
 //
 
 #import "PTDRectangleTool.h"
+#import "PTDCanvasObject.h"
 
 
 NSString * const PTDToolIdentifierRectangleTool = @"PTDToolIdentifierRectangleTool";
@@ -50,4 +51,10 @@ NSString * const PTDToolIdentifierRectangleTool = @"PTDToolIdentifierRectangleTo
 }
 
 
+- (PTDShapeCanvasObject *)shapeCanvasObjectInRect:(NSRect)rect
+{
+  return [[PTDPrimitiveShapeCanvasObject alloc] initWithKind:PTDShapeRasterKindRectangle rect:rect cornerRadius:0.0 lineWidth:self.size color:self.color filled:self.filled];
+}
+
+
 @end
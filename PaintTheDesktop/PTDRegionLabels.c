@@ -0,0 +1,356 @@
+//
+// PTDRegionLabels.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "PTDRegionLabels.h"
+#include "PTDCanvasStore.h"
+#include "PTDBufferPool.h"
+
+
+typedef struct {
+  uint32_t *parent;
+  size_t count;
+  size_t capacity;
+} PTDUnionFind;
+
+
+static inline uint32_t PTDUnionFindRoot(PTDUnionFind *uf, uint32_t i)
+{
+  uint32_t root = i;
+  while (uf->parent[root] != root)
+    root = uf->parent[root];
+  while (uf->parent[i] != root) {
+    uint32_t next = uf->parent[i];
+    uf->parent[i] = root;
+    i = next;
+  }
+  return root;
+}
+
+
+static inline void PTDUnionFindMerge(PTDUnionFind *uf, uint32_t a, uint32_t b)
+{
+  a = PTDUnionFindRoot(uf, a);
+  b = PTDUnionFindRoot(uf, b);
+  /* the smallest label is the root, so that roots are found in order */
+  if (a < b)
+    uf->parent[b] = a;
+  else if (b < a)
+    uf->parent[a] = b;
+}
+
+
+static inline int PTDUnionFindAdd(PTDUnionFind *uf, uint32_t *label)
+{
+  if (uf->count == uf->capacity) {
+    size_t newCapacity = uf->capacity ? uf->capacity * 2 : 4096;
+    if (newCapacity > UINT32_MAX)
+      return 0;
+    uint32_t *newParent = realloc(uf->parent, newCapacity * sizeof(uint32_t));
+    if (!newParent)
+      return 0;
+    uf->parent = newParent;
+    uf->capacity = newCapacity;
+  }
+  *label = (uint32_t)uf->count;
+  uf->parent[uf->count] = (uint32_t)uf->count;
+  uf->count++;
+  return 1;
+}
+
+
+static inline int PTDPixelsConnected(uint32_t a, uint32_t b, int tolerance)
+{
+  if (a == b)
+    return 1;
+  for (int c = 0; c < 32; c += 8) {
+    int d = (int)((a >> c) & 0xFF) - (int)((b >> c) & 0xFF);
+    if (d > tolerance || d < -tolerance)
+      return 0;
+  }
+  return 1;
+}
+
+
+/* The rows of the canvas being labelled, read in order. Rows of a frame
+ * are copied, and the previous row stays valid while the next one is read. */
+typedef struct {
+  const PTDPixelBuffer *canvas;
+  const PTDCanvasFrame *frame;
+  uint32_t *rows;
+} PTDRegionRowReader;
+
+
+static const uint32_t *PTDRegionRowReaderRow(PTDRegionRowReader *reader, size_t y)
+{
+  if (reader->canvas)
+    return (const uint32_t *)(reader->canvas->data + y * reader->canvas->bytesPerRow);
+  size_t w = PTDCanvasFrameWidth(reader->frame);
+  uint32_t *row = reader->rows + (y % 2) * w;
+  PTDPixelBuffer dst = {(uint8_t *)row, w, 1, w * 4};
+  PTDCanvasFrameCopyPixels(reader->frame, 0, y, &dst);
+  return row;
+}
+
+
+static int PTDRegionLabelsBuild(PTDRegionLabels *labels, PTDRegionRowReader *reader, size_t w, size_t h, uint8_t tolerance, size_t maxRegions)
+{
+  memset(labels, 0, sizeof(PTDRegionLabels));
+  labels->width = w;
+  labels->height = h;
+  if (w == 0 || h == 0)
+    return 1;
+  if (w > UINT32_MAX || h > UINT32_MAX)
+    return 0;
+  
+  labels->labels = PTDBufferPoolAlloc(w * h * sizeof(uint32_t));
+  if (!labels->labels)
+    return 0;
+  
+  /* first pass: one provisional label for each run of connected pixels in
+   * a row, merged with the labels of the connected pixels above it */
+  PTDUnionFind uf = {0};
+  int success = 1;
+  const uint32_t *prevRow = NULL;
+  for (size_t y = 0; y < h && success; y++) {
+    const uint32_t *row = PTDRegionRowReaderRow(reader, y);
+    uint32_t *out = labels->labels + y * w;
+    const uint32_t *prevOut = y > 0 ? out - w : NULL;
+    
+    size_t x = 0;
+    while (x < w) {
+      size_t start = x++;
+      while (x < w && PTDPixelsConnected(row[x], row[x-1], tolerance))
+        x++;
+      
+      uint32_t label = UINT32_MAX;
+      if (prevRow) {
+        uint32_t lastUp = UINT32_MAX;
+        for (size_t i = start; i < x; i++) {
+          uint32_t up = prevOut[i];
+          if (up == lastUp || !PTDPixelsConnected(row[i], prevRow[i], tolerance))
+            continue;
+          lastUp = up;
+          if (label == UINT32_MAX)
+            label = up;
+          else if (up != label)
+            PTDUnionFindMerge(&uf, label, up);
+        }
+      }
+      if (label == UINT32_MAX) {
+        if (uf.count >= maxRegions || !PTDUnionFindAdd(&uf, &label)) {
+          success = 0;
+          break;
+        }
+      }
+      for (size_t i = start; i < x; i++)
+        out[i] = label;
+    }
+    prevRow = row;
+  }
+  
+  /* second pass: compact the labels and find the bounds of each region */
+  if (success) {
+    for (size_t i = 0; i < uf.count; i++)
+      uf.parent[i] = PTDUnionFindRoot(&uf, (uint32_t)i);
+    /* roots come before the other labels of their region */
+    size_t count = 0;
+    for (size_t i = 0; i < uf.count; i++)
+      uf.parent[i] = uf.parent[i] == i ? (uint32_t)count++ : uf.parent[uf.parent[i]];
+    labels->count = count;
+    labels->bounds = malloc(count * sizeof(PTDRegionBounds));
+    success = labels->bounds != NULL;
+  }
+  if (success) {
+    for (size_t i = 0; i < labels->count; i++)
+      labels->bounds[i] = (PTDRegionBounds){UINT32_MAX, UINT32_MAX, 0, 0};
+    for (size_t y = 0; y < h; y++) {
+      uint32_t *row = labels->labels + y * w;
+      size_t x = 0;
+      while (x < w) {
+        size_t start = x;
+        uint32_t provisional = row[x];
+        while (x < w && row[x] == provisional)
+          row[x++] = uf.parent[provisional];
+        PTDRegionBounds *b = &labels->bounds[uf.parent[provisional]];
+        if (start < b->minX) b->minX = (uint32_t)start;
+        if (x - 1 > b->maxX) b->maxX = (uint32_t)(x - 1);
+        if (y < b->minY) b->minY = (uint32_t)y;
+        b->maxY = (uint32_t)y;
+      }
+    }
+  }
+  
+  free(uf.parent);
+  if (!success)
+    PTDRegionLabelsFree(labels);
+  return success;
+}
+
+
+int PTDRegionLabelsInit(PTDRegionLabels *labels, const PTDPixelBuffer *canvas, uint8_t tolerance, size_t maxRegions)
+{
+  PTDRegionRowReader reader = {canvas, NULL, NULL};
+  return PTDRegionLabelsBuild(labels, &reader, canvas->width, canvas->height, tolerance, maxRegions);
+}
+
+
+int PTDRegionLabelsInitWithFrame(PTDRegionLabels *labels, const PTDCanvasFrame *frame, uint8_t tolerance, size_t maxRegions)
+{
+  size_t w = PTDCanvasFrameWidth(frame), h = PTDCanvasFrameHeight(frame);
+  PTDRegionRowReader reader = {NULL, frame, malloc(w * 2 * sizeof(uint32_t))};
+  if (!reader.rows && w > 0) {
+    memset(labels, 0, sizeof(PTDRegionLabels));
+    return 0;
+  }
+  int success = PTDRegionLabelsBuild(labels, &reader, w, h, tolerance, maxRegions);
+  free(reader.rows);
+  return success;
+}
+
+
+void PTDRegionLabelsFree(PTDRegionLabels *labels)
+{
+  PTDBufferPoolFree(labels->labels, labels->width * labels->height * sizeof(uint32_t));
+  free(labels->bounds);
+  labels->labels = NULL;
+  labels->bounds = NULL;
+  labels->count = 0;
+}
+
+
+int PTDRegionLabelsMaskAtPixel(const PTDRegionLabels *labels, size_t x, size_t y, PTDSelectionMask *mask)
+{
+  PTDSelectionMaskInit(mask, 0, 0, 0, 0);
+  if (x >= labels->width || y >= labels->height || !labels->labels)
+    return 1;
+  
+  uint32_t l = labels->labels[y * labels->width + x];
+  PTDRegionBounds b = labels->bounds[l];
+  size_t mw = b.maxX - b.minX + 1, mh = b.maxY - b.minY + 1;
+  if (!PTDSelectionMaskInit(mask, (long)b.minX, (long)b.minY, mw, mh))
+    return 0;
+  
+  for (size_t my = 0; my < mh; my++) {
+    const uint32_t *row = labels->labels + (b.minY + my) * labels->width + b.minX;
+    uint8_t *out = mask->coverage + my * mw;
+    for (size_t mx = 0; mx < mw; mx++)
+      out[mx] = (uint8_t)-(row[mx] == l);
+  }
+  return 1;
+}
+
+
+static int PTDRegionStackPush(size_t **stack, size_t *size, size_t *capacity, size_t x, size_t y)
+{
+  if (*size + 2 > *capacity) {
+    size_t newCapacity = *capacity ? *capacity * 2 : 1024;
+    size_t *newStack = realloc(*stack, newCapacity * sizeof(size_t));
+    if (!newStack)
+      return 0;
+    *stack = newStack;
+    *capacity = newCapacity;
+  }
+  (*stack)[(*size)++] = x;
+  (*stack)[(*size)++] = y;
+  return 1;
+}
+
+
+int PTDRegionMaskAtPixel(const PTDPixelBuffer *canvas, size_t x, size_t y, uint8_t tolerance, PTDSelectionMask *mask)
+{
+  PTDSelectionMaskInit(mask, 0, 0, 0, 0);
+  size_t w = canvas->width, h = canvas->height;
+  if (x >= w || y >= h)
+    return 1;
+  
+  uint8_t *visited = PTDBufferPoolAlloc(w * h);
+  if (visited)
+    memset(visited, 0, w * h);
+  size_t *stack = NULL;
+  size_t stackSize = 0, stackCapacity = 0;
+  size_t minX = x, minY = y, maxX = x, maxY = y;
+  int success = visited != NULL;
+  
+  #define PIXEL(px, py) (((const uint32_t *)(canvas->data + (py) * canvas->bytesPerRow))[px])
+  
+  if (success)
+    success = PTDRegionStackPush(&stack, &stackSize, &stackCapacity, x, y);
+  while (success && stackSize > 0) {
+    size_t sy = stack[--stackSize];
+    size_t sx = stack[--stackSize];
+    uint8_t *vrow = visited + sy * w;
+    if (vrow[sx])
+      continue;
+    
+    /* the run of connected pixels in this row */
+    size_t l = sx, r = sx;
+    while (l > 0 && !vrow[l-1] && PTDPixelsConnected(PIXEL(l-1, sy), PIXEL(l, sy), tolerance))
+      l--;
+    while (r + 1 < w && !vrow[r+1] && PTDPixelsConnected(PIXEL(r+1, sy), PIXEL(r, sy), tolerance))
+      r++;
+    memset(vrow + l, 1, r - l + 1);
+    if (l < minX) minX = l;
+    if (r > maxX) maxX = r;
+    if (sy < minY) minY = sy;
+    if (sy > maxY) maxY = sy;
+    
+    /* pixels connected to the run from above or below; a pixel connected
+     * to the previous one is reached when the run of the latter is filled */
+    for (int dy = -1; dy <= 1 && success; dy += 2) {
+      if ((dy < 0 && sy == 0) || (dy > 0 && sy + 1 >= h))
+        continue;
+      size_t ny = sy + dy;
+      const uint8_t *nvrow = visited + ny * w;
+      int previousConnected = 0;
+      for (size_t nx = l; nx <= r; nx++) {
+        int connected = !nvrow[nx] && PTDPixelsConnected(PIXEL(nx, ny), PIXEL(nx, sy), tolerance);
+        if (connected && !(previousConnected && PTDPixelsConnected(PIXEL(nx, ny), PIXEL(nx-1, ny), tolerance))) {
+          if (!(success = PTDRegionStackPush(&stack, &stackSize, &stackCapacity, nx, ny)))
+            break;
+        }
+        previousConnected = connected;
+      }
+    }
+  }
+  
+  #undef PIXEL
+  
+  if (success)
+    success = PTDSelectionMaskInit(mask, (long)minX, (long)minY, maxX - minX + 1, maxY - minY + 1);
+  if (success) {
+    for (size_t my = 0; my < mask->height; my++) {
+      const uint8_t *vrow = visited + (minY + my) * w + minX;
+      uint8_t *out = mask->coverage + my * mask->width;
+      for (size_t mx = 0; mx < mask->width; mx++)
+        out[mx] = (uint8_t)-vrow[mx];
+    }
+  }
+  
+  PTDBufferPoolFree(visited, w * h);
+  free(stack);
+  return success;
+}
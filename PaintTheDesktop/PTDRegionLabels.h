@@ -0,0 +1,73 @@
+//
+// PTDRegionLabels.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDRegionLabels_h
+#define PTDRegionLabels_h
+
+#include "PTDSelectionMask.h"
+#include "PTDCanvasStore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint32_t minX, minY, maxX, maxY;
+} PTDRegionBounds;
+
+/* Partition of a canvas in regions of 4-connected pixels, where two
+ * neighbouring pixels are connected when no premultiplied channel differs
+ * by more than the tolerance. */
+typedef struct {
+  uint32_t *labels;
+  size_t width;
+  size_t height;
+  size_t count;
+  PTDRegionBounds *bounds;
+} PTDRegionLabels;
+
+/* Labels the whole canvas. Returns 0 on failure, or when labelling requires
+ * more than maxRegions intermediate labels, as on noisy images where most
+ * regions are a handful of pixels. */
+int PTDRegionLabelsInit(PTDRegionLabels *labels, const PTDPixelBuffer *canvas, uint8_t tolerance, size_t maxRegions);
+/* Same as PTDRegionLabelsInit, reading the pixels of a frame of a canvas
+ * store, so that the canvas can keep changing on another thread. */
+int PTDRegionLabelsInitWithFrame(PTDRegionLabels *labels, const PTDCanvasFrame *frame, uint8_t tolerance, size_t maxRegions);
+void PTDRegionLabelsFree(PTDRegionLabels *labels);
+
+/* Builds the mask of the region containing the given pixel, covering only
+ * the bounding box of the region. Returns 0 on failure; a pixel outside the
+ * canvas produces a successful empty mask. */
+int PTDRegionLabelsMaskAtPixel(const PTDRegionLabels *labels, size_t x, size_t y, PTDSelectionMask *mask);
+
+/* Same as labelling the canvas and asking for the mask of the region at the
+ * given pixel, but only visits the pixels of that region. */
+int PTDRegionMaskAtPixel(const PTDPixelBuffer *canvas, size_t x, size_t y, uint8_t tolerance, PTDSelectionMask *mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDRegionLabels_h */
@@ -0,0 +1,281 @@
+//
+// PTDResampler.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PTDResampler.h"
+#include "PTDBufferPool.h"
+#include "PTDParallel.h"
+#include "PTDVector.h"
+
+
+/* Number of destination rows processed by a single work item */
+static const size_t _BandHeight = 16;
+
+static const double _Pi = 3.14159265358979323846;
+
+
+typedef struct {
+  size_t count;
+  size_t maxTaps;
+  size_t *first;    /* first source index of each destination index */
+  size_t *numTaps;  /* number of source indexes of each destination index */
+  float *weights;   /* maxTaps weights for each destination index */
+} PTDResamplingWeights;
+
+
+static double PTDFilterRadius(PTDResamplingFilter filter)
+{
+  switch (filter) {
+    case PTDResamplingFilterBilinear:
+      return 1.0;
+    case PTDResamplingFilterBicubic:
+      return 2.0;
+    case PTDResamplingFilterLanczos3:
+      return 3.0;
+  }
+  return 1.0;
+}
+
+
+static double PTDSinc(double x)
+{
+  if (x == 0.0)
+    return 1.0;
+  x *= _Pi;
+  return sin(x) / x;
+}
+
+
+static double PTDFilterKernel(PTDResamplingFilter filter, double x)
+{
+  x = fabs(x);
+  switch (filter) {
+    case PTDResamplingFilterBilinear:
+      return x < 1.0 ? 1.0 - x : 0.0;
+      
+    case PTDResamplingFilterBicubic: {
+      /* Keys cubic convolution, a = -0.5 */
+      const double a = -0.5;
+      if (x < 1.0)
+        return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+      if (x < 2.0)
+        return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+      return 0.0;
+    }
+      
+    case PTDResamplingFilterLanczos3:
+      return x < 3.0 ? PTDSinc(x) * PTDSinc(x / 3.0) : 0.0;
+  }
+  return 0.0;
+}
+
+
+static int PTDResamplingWeightsInit(PTDResamplingWeights *w, size_t srcCount, size_t dstCount, PTDResamplingFilter filter)
+{
+  double scale = (double)srcCount / (double)dstCount;
+  /* when shrinking, stretch the kernel to cover all the source samples */
+  double filterScale = fmax(1.0, scale);
+  double radius = PTDFilterRadius(filter) * filterScale;
+  
+  w->count = dstCount;
+  w->maxTaps = (size_t)ceil(radius * 2.0) + 1;
+  w->first = calloc(dstCount, sizeof(size_t));
+  w->numTaps = calloc(dstCount, sizeof(size_t));
+  w->weights = calloc(dstCount * w->maxTaps, sizeof(float));
+  if (!w->first || !w->numTaps || !w->weights)
+    return 0;
+  
+  for (size_t i = 0; i < dstCount; i++) {
+    double center = ((double)i + 0.5) * scale - 0.5;
+    long left = (long)ceil(center - radius);
+    long right = (long)floor(center + radius);
+    long first = left < 0 ? 0 : left;
+    long last = right > (long)srcCount - 1 ? (long)srcCount - 1 : right;
+    float *weights = w->weights + i * w->maxTaps;
+    
+    /* samples outside of the source are replaced by the nearest edge */
+    double sum = 0.0;
+    for (long j = left; j <= right; j++) {
+      double k = PTDFilterKernel(filter, ((double)j - center) / filterScale);
+      long t = j < first ? first : (j > last ? last : j);
+      if (t - first >= (long)w->maxTaps)
+        continue;
+      weights[t - first] += (float)k;
+      sum += k;
+    }
+    size_t n = (size_t)(last - first + 1);
+    if (n > w->maxTaps)
+      n = w->maxTaps;
+    if (sum != 0.0) {
+      for (size_t t = 0; t < n; t++)
+        weights[t] = (float)(weights[t] / sum);
+    }
+    
+    w->first[i] = (size_t)first;
+    w->numTaps[i] = n;
+  }
+  return 1;
+}
+
+
+static void PTDResamplingWeightsFree(PTDResamplingWeights *w)
+{
+  free(w->first);
+  free(w->numTaps);
+  free(w->weights);
+}
+
+
+/* Intermediate rows hold 4 floats per pixel */
+static void PTDResampleRowHorizontal(const uint8_t *src, float *dst, const PTDResamplingWeights *w)
+{
+  for (size_t x = 0; x < w->count; x++) {
+    const uint8_t *p = src + w->first[x] * 4;
+    const float *k = w->weights + x * w->maxTaps;
+    size_t n = w->numTaps[x];
+    PTDFloat4 acc = PTDFloat4Splat(0.0f);
+    for (size_t t = 0; t < n; t++)
+      acc = PTDFloat4Add(acc, PTDFloat4Mul(PTDFloat4LoadPixel(p + t * 4), PTDFloat4Splat(k[t])));
+    PTDFloat4Store(dst + x * 4, acc);
+  }
+}
+
+
+static void PTDResampleBand(
+    const PTDPixelBuffer *src, const PTDPixelBuffer *dst,
+    const PTDResamplingWeights *hw, const PTDResamplingWeights *vw,
+    size_t y0, size_t y1, float *rows, float *acc)
+{
+  size_t rowLength = dst->width * 4;
+  
+  /* source rows needed by this band; they are contiguous because the
+   * first tap index is monotonic */
+  size_t firstRow = vw->first[y0];
+  size_t lastRow = firstRow;
+  for (size_t y = y0; y < y1; y++) {
+    size_t end = vw->first[y] + vw->numTaps[y];
+    if (end > lastRow)
+      lastRow = end;
+  }
+  
+  for (size_t sy = firstRow; sy < lastRow; sy++)
+    PTDResampleRowHorizontal(src->data + sy * src->bytesPerRow, rows + (sy - firstRow) * rowLength, hw);
+  
+  for (size_t y = y0; y < y1; y++) {
+    const float *k = vw->weights + y * vw->maxTaps;
+    size_t n = vw->numTaps[y];
+    const float *base = rows + (vw->first[y] - firstRow) * rowLength;
+    uint8_t *out = dst->data + y * dst->bytesPerRow;
+    
+    /* whole rows at a time, which keeps the inner loop contiguous */
+    for (size_t i = 0; i < rowLength; i += 4)
+      PTDFloat4Store(acc + i, PTDFloat4Splat(0.5f));
+    for (size_t t = 0; t < n; t++) {
+      const float *row = base + t * rowLength;
+      PTDFloat4 kt = PTDFloat4Splat(k[t]);
+      for (size_t i = 0; i < rowLength; i += 4)
+        PTDFloat4Store(acc + i, PTDFloat4Add(PTDFloat4Load(acc + i), PTDFloat4Mul(PTDFloat4Load(row + i), kt)));
+    }
+    
+    PTDFloat4 zero = PTDFloat4Splat(0.0f);
+    for (size_t x = 0; x < dst->width; x++) {
+      /* ringing filters may overshoot; keep the result premultiplied */
+      PTDFloat4 px = PTDFloat4Load(acc + x * 4);
+      float alpha = PTDFloat4Lane(PTDFloat4Clamp(px, zero, PTDFloat4Splat(255.0f)), 3);
+      px = PTDFloat4Clamp(px, zero, PTDFloat4Splat(alpha));
+      PTDFloat4StorePixel(out + x * 4, px);
+    }
+  }
+}
+
+
+typedef struct {
+  const PTDPixelBuffer *src;
+  const PTDPixelBuffer *dst;
+  const PTDResamplingWeights *hw;
+  const PTDResamplingWeights *vw;
+  size_t maxBandRows;
+} PTDResampleJob;
+
+
+static void PTDResampleJobBand(void *context, size_t band)
+{
+  const PTDResampleJob *job = context;
+  size_t height = job->dst->height;
+  size_t y0 = band * _BandHeight;
+  size_t y1 = y0 + _BandHeight < height ? y0 + _BandHeight : height;
+  size_t rowLength = job->dst->width * 4;
+  size_t rowsSize = (job->maxBandRows + 1) * rowLength * sizeof(float);
+  float *rows = PTDBufferPoolAlloc(rowsSize);
+  if (!rows)
+    return;
+  PTDResampleBand(job->src, job->dst, job->hw, job->vw, y0, y1, rows, rows + job->maxBandRows * rowLength);
+  PTDBufferPoolFree(rows, rowsSize);
+}
+
+
+PTDResamplingFilter PTDResamplingFilterForScaling(const PTDPixelBuffer *src, const PTDPixelBuffer *dst)
+{
+  if (dst->width < src->width && dst->height < src->height)
+    return PTDResamplingFilterLanczos3;
+  return PTDResamplingFilterBicubic;
+}
+
+
+void PTDResample(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, PTDResamplingFilter filter)
+{
+  if (src->width == 0 || src->height == 0 || dst->width == 0 || dst->height == 0)
+    return;
+  
+  PTDResamplingWeights hw = {0}, vw = {0};
+  if (!PTDResamplingWeightsInit(&hw, src->width, dst->width, filter) ||
+      !PTDResamplingWeightsInit(&vw, src->height, dst->height, filter)) {
+    PTDResamplingWeightsFree(&hw);
+    PTDResamplingWeightsFree(&vw);
+    return;
+  }
+  
+  size_t maxBandRows = 0;
+  for (size_t y0 = 0; y0 < dst->height; y0 += _BandHeight) {
+    size_t y1 = y0 + _BandHeight < dst->height ? y0 + _BandHeight : dst->height;
+    size_t rows = 0;
+    for (size_t y = y0; y < y1; y++) {
+      size_t e = vw.first[y] + vw.numTaps[y];
+      if (e - vw.first[y0] > rows)
+        rows = e - vw.first[y0];
+    }
+    if (rows > maxBandRows)
+      maxBandRows = rows;
+  }
+  
+  size_t numBands = (dst->height + _BandHeight - 1) / _BandHeight;
+  PTDResampleJob job = {src, dst, &hw, &vw, maxBandRows};
+  PTDParallelApply(numBands, &job, PTDResampleJobBand);
+  
+  PTDResamplingWeightsFree(&hw);
+  PTDResamplingWeightsFree(&vw);
+}
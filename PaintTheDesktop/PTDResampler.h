@@ -0,0 +1,63 @@
+//
+// PTDResampler.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDResampler_h
+#define PTDResampler_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  PTDResamplingFilterBilinear,
+  PTDResamplingFilterBicubic,
+  PTDResamplingFilterLanczos3
+} PTDResamplingFilter;
+
+/* 8 bit per channel premultiplied RGBA pixels, the first row is the top one */
+typedef struct {
+  uint8_t *data;
+  size_t width;
+  size_t height;
+  size_t bytesPerRow;
+} PTDPixelBuffer;
+
+/* Lanczos keeps more detail when shrinking, but its ringing is too visible
+ * on the hard edges of enlarged drawings; this picks the appropriate one */
+PTDResamplingFilter PTDResamplingFilterForScaling(const PTDPixelBuffer *src, const PTDPixelBuffer *dst);
+
+/* Scales the whole source buffer to fill the whole destination buffer.
+ * The buffers must not overlap. The work is split in bands of rows which
+ * are processed concurrently. */
+void PTDResample(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, PTDResamplingFilter filter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDResampler_h */
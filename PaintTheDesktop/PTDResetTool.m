@@ -49,11 +49,12 @@ NSString * const PTDToolIdentifierResetTool = @"PTDToolIdentifierResetTool";
 
 - (void)mouseClickedAtPoint:(NSPoint)point
 {
-  [self.currentDrawingSurface beginCanvasDrawing];
   NSRect bounds = [self.currentDrawingSurface bounds];
+  [self.currentDrawingSurface beginCanvasDrawingInRect:bounds];
   [NSGraphicsContext.currentContext setCompositingOperation:NSCompositingOperationClear];
   [[NSColor colorWithWhite:1.0 alpha:0.0] setFill];
   NSRectFill(bounds);
+  [self.currentDrawingSurface canvasDidChangeInRect:bounds];
   
   NSShowAnimationEffect(NSAnimationEffectPoof, NSEvent.mouseLocation, NSZeroSize, nil, nil, NULL);
 }
@@ -43,6 +43,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)removeRingInPosition:(NSInteger)i;
 
+/* The layout computed the first time the menu pops up is reused by
+ * subsequent pop-ups. Call this after changing the items of a ring. */
+- (void)invalidateLayout;
+
 - (void)popUpMenuWithEvent:(NSEvent *)event forView:(nullable NSView *)view;
 - (void)popUpMenuAtLocation:(NSPoint)location inWindow:(nullable NSWindow *)window event:(nullable NSEvent *)event;
 
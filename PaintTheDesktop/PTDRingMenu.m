@@ -30,6 +30,7 @@
 
 @implementation PTDRingMenu {
   NSMutableArray <PTDRingMenuRing *> *_rings;
+  PTDRingMenuWindow *_window;
 }
 
 
@@ -50,12 +51,14 @@
 - (void)addRing:(PTDRingMenuRing *)ring
 {
   [_rings addObject:ring];
+  [self invalidateLayout];
 }
 
 
 - (void)addRing:(PTDRingMenuRing *)ring inPosition:(NSInteger)pos
 {
   [_rings insertObject:ring atIndex:pos];
+  [self invalidateLayout];
 }
 
 
@@ -82,6 +85,13 @@
 - (void)removeRingInPosition:(NSInteger)i
 {
   [_rings removeObjectAtIndex:i];
+  [self invalidateLayout];
+}
+
+
+- (void)invalidateLayout
+{
+  _window = nil;
 }
 
 
@@ -97,7 +107,12 @@
   if (window)
     scrPos = [window convertPointToScreen:location];
     
-  PTDRingMenuWindow *wc = [[PTDRingMenuWindow alloc] initWithRingMenu:self];
+  PTDRingMenuWindow *wc = _window;
+  if (!wc.canReopen) {
+    wc = [[PTDRingMenuWindow alloc] initWithRingMenu:self];
+    _window = wc;
+  }
+  [wc.window.parentWindow removeChildWindow:wc.window];
   [window addChildWindow:wc.window ordered:NSWindowAbove];
   [wc positionCenter:scrPos];
   [wc openMenuWithInitialEvent:event];
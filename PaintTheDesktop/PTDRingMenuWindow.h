@@ -36,6 +36,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)positionCenter:(NSPoint)center;
 - (void)openMenuWithInitialEvent:(nullable NSEvent *)evt;
 
+/* YES if the menu has been closed and its window can be opened again
+ * without redoing the layout */
+@property (nonatomic, readonly) BOOL canReopen;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -48,6 +48,7 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 
 @property (nonatomic, readonly) NSBezierPath *selectionShape;
 @property (nonatomic, readonly) NSSize selectionShapeSize;
+@property (nonatomic, readonly) NSImage *selectionBackdrop;
 
 @property (nonatomic) CGFloat distanceFromCenter;
 @property (nonatomic) CGFloat angleOnRing;
@@ -65,6 +66,9 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 
 @implementation PTDRingMenuWindowItemLayout {
   NSImageView *_contentsView;
+  NSImage *_normalImage;
+  NSImage *_selectedImage;
+  NSImage *_selectionBackdrop;
 }
 
 
@@ -107,13 +111,45 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 }
 
 
+- (NSImage *)selectionBackdrop
+{
+  if (!_selectionBackdrop) {
+    NSBezierPath *shape = _selectionShape;
+    _selectionBackdrop = [NSImage imageWithSize:_selectionShapeSize flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+      [[NSColor ptd_ringMenuHighlightColor] setFill];
+      [shape fill];
+      return YES;
+    }];
+  }
+  return _selectionBackdrop;
+}
+
+
+- (void)_computeItemImages
+{
+  /* Tinting is done once here rather than on every selection change,
+   * because the images are reused every time the menu is reopened */
+  if (!self.item.enabled) {
+    /* disabled items are never selected */
+    _normalImage = [self.item.image ptd_imageByTintingWithColor:NSColor.ptd_ringMenuDisabledItemTextColor];
+    _selectedImage = _normalImage;
+    return;
+  }
+  _normalImage = self.item.image;
+  if (_normalImage.isTemplate)
+    _normalImage = [_normalImage ptd_imageByTintingWithColor:NSColor.ptd_ringMenuItemTextColor];
+  _selectedImage = self.item.selectedImage ?: self.item.image;
+  if (_selectedImage.isTemplate)
+    _selectedImage = [_selectedImage ptd_imageByTintingWithColor:NSColor.ptd_ringMenuItemSelectedTextColor];
+}
+
+
 - (void)_setupView
 {
+  [self _computeItemImages];
+  
   if (self.item.state == NSControlStateValueOff || !self.item.enabled) {
-    NSImage *itemImage = self.item.image;
-    if (!self.item.enabled)
-      itemImage = [itemImage ptd_imageByTintingWithColor:NSColor.ptd_ringMenuDisabledItemTextColor];
-    NSImageView *view = [NSImageView imageViewWithImage:itemImage];
+    NSImageView *view = [NSImageView imageViewWithImage:_normalImage];
     [view setFrameSize:_size];
     _view = view;
     _contentsView = view;
@@ -146,7 +182,7 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
     [mainView setFrameSize:rect.size];
     _view = mainView;
     
-    _contentsView = [NSImageView imageViewWithImage:self.item.image];
+    _contentsView = [NSImageView imageViewWithImage:_normalImage];
     [_contentsView setFrameSize:_size];
     
     [mainView addSubview:_contentsView];
@@ -171,10 +207,7 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 {
   if (!self.item.enabled)
     return;
-  NSImage *image = self.item.selectedImage ?: self.item.image;
-  if (image.isTemplate)
-    image = [image ptd_imageByTintingWithColor:NSColor.ptd_ringMenuItemSelectedTextColor];
-  _contentsView.image = image;
+  _contentsView.image = _selectedImage;
   _contentsView.cell.backgroundStyle = NSBackgroundStyleEmphasized;
 }
 
@@ -183,10 +216,7 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 {
   if (!self.item.enabled)
     return;
-  NSImage *image = self.item.image;
-  if (image.isTemplate)
-    image = [image ptd_imageByTintingWithColor:NSColor.ptd_ringMenuItemTextColor];
-  _contentsView.image = image;
+  _contentsView.image = _normalImage;
   _contentsView.cell.backgroundStyle = NSBackgroundStyleNormal;
 }
 
@@ -248,6 +278,7 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
   
   PTDRingMenuWindowItemLayout *_dragStartItem;
   BOOL _endOfLife, _lifeEnded, _draggingMode;
+  NSUInteger _openCount;
 }
 
 
@@ -293,13 +324,59 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 }
 
 
+- (BOOL)canReopen
+{
+  return _lifeEnded && !self.window.isVisible;
+}
+
+
+- (void)_prepareForReopening
+{
+  _endOfLife = _lifeEnded = _draggingMode = NO;
+  _dragStartItem = nil;
+  
+  [CATransaction begin];
+  CATransaction.disableActions = YES;
+  for (PTDRingMenuWindowItemLayout *itm in _layout) {
+    [itm deselect];
+  }
+  _selectionLayer.opacity = 0.0;
+  [CATransaction commit];
+  
+  self.window.alphaValue = 1.0;
+  [PTDRingMenuWindow addMenuWindow:self];
+}
+
+
 - (void)openMenuWithInitialEvent:(NSEvent *)evt
 {
+  if (_lifeEnded)
+    [self _prepareForReopening];
+  
   [self.window makeKeyAndOrderFront:nil];
+  if ([[NSUserDefaults standardUserDefaults] boolForKey:@"debug"])
+    [self _logTimeToFirstFrameFromEvent:evt];
+  _openCount++;
   [self _trackModallyWithInitialEvent:evt];
 }
 
 
+- (void)_logTimeToFirstFrameFromEvent:(NSEvent *)evt
+{
+  /* Event timestamps and CACurrentMediaTime() share the same time base
+   * (seconds since boot) */
+  CFTimeInterval start = evt ? evt.timestamp : CACurrentMediaTime();
+  BOOL reused = _openCount > 0;
+  [CATransaction begin];
+  [CATransaction setCompletionBlock:^{
+    CFTimeInterval elapsed = CACurrentMediaTime() - start;
+    NSLog(@"ring menu: open to first frame %.2f ms (%@)", elapsed * 1000.0, reused ? @"cached" : @"new");
+  }];
+  [self.window displayIfNeeded];
+  [CATransaction commit];
+}
+
+
 #pragma mark - Global Menu List
 
 
@@ -687,17 +764,6 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
 }
 
 
-- (NSImage *)_selectionBackdropForItem:(PTDRingMenuWindowItemLayout *)item
-{
-  NSImage *image = [NSImage imageWithSize:item.selectionShapeSize flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
-    [[NSColor ptd_ringMenuHighlightColor] setFill];
-    [item.selectionShape fill];
-    return YES;
-  }];
-  return image;
-}
-
-
 - (void)_updateSelectionLayerForItem:(PTDRingMenuWindowItemLayout *)item clicked:(BOOL)click
 {
   if (_endOfLife)
@@ -722,7 +788,7 @@ static NSMutableSet <PTDRingMenuWindow *> *currentlyOpenMenus;
     [_mainView.layer insertSublayer:_selectionLayer atIndex:0];
   }
   
-  NSImage *backdrop = [self _selectionBackdropForItem:item];
+  NSImage *backdrop = item.selectionBackdrop;
   
   _selectionLayer.contents = backdrop;
   _selectionLayer.frame = (NSRect){NSZeroPoint, backdrop.size};
@@ -24,10 +24,13 @@
 //
 
 #import "PTDRoundRectTool.h"
+#import "PTDCanvasObject.h"
 
 
 NSString * const PTDToolIdentifierRoundRectTool = @"PTDToolIdentifierRoundRectTool";
 
+static const CGFloat _CornerRadius = 8.0;
+
 
 @implementation PTDRoundRectTool
 
@@ -46,7 +49,13 @@ NSString * const PTDToolIdentifierRoundRectTool = @"PTDToolIdentifierRoundRectTo
 
 - (NSBezierPath *)shapeBezierPathInRect:(NSRect)rect
 {
-  return [NSBezierPath bezierPathWithRoundedRect:rect xRadius:8.0 yRadius:8.0];
+  return [NSBezierPath bezierPathWithRoundedRect:rect xRadius:_CornerRadius yRadius:_CornerRadius];
+}
+
+
+- (PTDShapeCanvasObject *)shapeCanvasObjectInRect:(NSRect)rect
+{
+  return [[PTDPrimitiveShapeCanvasObject alloc] initWithKind:PTDShapeRasterKindRoundRect rect:rect cornerRadius:_CornerRadius lineWidth:self.size color:self.color filled:self.filled];
 }
 
 
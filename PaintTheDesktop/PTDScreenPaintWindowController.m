@@ -112,6 +112,8 @@
       NSWindowCollectionBehaviorFullScreenAuxiliary |
       NSWindowCollectionBehaviorIgnoresCycle;
   window.level = kCGMaximumWindowLevelKey;
+  /* until drawing is enabled, which may not be why the window is loaded */
+  window.ignoresMouseEvents = YES;
   
   if ([[NSUserDefaults standardUserDefaults] boolForKey:@"debug"]) {
     window.movable = YES;
@@ -174,18 +176,37 @@
   NSRect dispFrame = [self displayRect];
   if (!NSIsEmptyRect(dispFrame)) {
     self.displayName = _displayProductName;
-    self.window.isVisible = YES;
-    [self.window setFrame:dispFrame display:NO];
   } else {
     self.displayName = [NSString stringWithFormat:
         NSLocalizedString(@"%@ (disconnected)",
           @"Format string for menu items corresponding to disconnected screens"),
         _displayProductName];
+  }
+  
+  /* the window is not created just to follow the screen around */
+  if (!self.windowLoaded)
+    return;
+  if (!NSIsEmptyRect(dispFrame)) {
+    self.window.isVisible = YES;
+    [self.window setFrame:dispFrame display:NO];
+  } else {
     self.window.isVisible = NO;
   }
 }
 
 
+- (NSImage *)thumbnail
+{
+  if (self.windowLoaded)
+    return [super thumbnail];
+  /* nothing can have been drawn yet */
+  NSSize size = [self displayRect].size;
+  if (size.width <= 0 || size.height <= 0)
+    size = NSMakeSize(16, 10);
+  return [[NSImage alloc] initWithSize:size];
+}
+
+
 - (void)windowDidBecomeMain:(NSNotification *)notification
 {
 }
@@ -213,7 +234,7 @@
   if (active) {
     self.window.ignoresMouseEvents = NO;
     [self.window makeKeyAndOrderFront:nil];
-  } else {
+  } else if (self.windowLoaded) {
     self.window.ignoresMouseEvents = YES;
   }
   _active = active;
@@ -280,6 +301,8 @@
   BOOL oldActive = PTDAppDelegate.appDelegate.active;
   PTDAppDelegate.appDelegate.active = NO;
   [NSWindow ptd_pushForceTopLevel];
+  /* the canvas is created along with the window */
+  [self window];
   [super saveImageAs:sender];
   [NSWindow ptd_popForceTopLevel];
   PTDAppDelegate.appDelegate.active = oldActive;
@@ -291,6 +314,7 @@
   BOOL oldActive = PTDAppDelegate.appDelegate.active;
   PTDAppDelegate.appDelegate.active = NO;
   [NSWindow ptd_pushForceTopLevel];
+  [self window];
   [super openImage:sender];
   [NSWindow ptd_popForceTopLevel];
   PTDAppDelegate.appDelegate.active = oldActive;
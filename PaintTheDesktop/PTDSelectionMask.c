@@ -0,0 +1,358 @@
+//
+// PTDSelectionMask.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PTDSelectionMask.h"
+#include "PTDBufferPool.h"
+
+
+/* Vertical samples per pixel row; the horizontal coverage is exact */
+static const int _SubScanlines = 4;
+
+
+typedef struct {
+  double yTop;
+  double yBottom;
+  double xTop;
+  double dxdy;
+  int winding;
+} PTDPolygonEdge;
+
+typedef struct {
+  double x;
+  int winding;
+} PTDEdgeCrossing;
+
+
+int PTDSelectionMaskInit(PTDSelectionMask *mask, long x, long y, size_t width, size_t height)
+{
+  mask->x = x;
+  mask->y = y;
+  mask->width = width;
+  mask->height = height;
+  mask->coverage = NULL;
+  if (width == 0 || height == 0)
+    return 1;
+  mask->coverage = PTDBufferPoolAlloc(width * height);
+  if (!mask->coverage)
+    return 0;
+  memset(mask->coverage, 0, width * height);
+  return 1;
+}
+
+
+void PTDSelectionMaskFree(PTDSelectionMask *mask)
+{
+  PTDBufferPoolFree(mask->coverage, mask->width * mask->height);
+  mask->coverage = NULL;
+  mask->width = mask->height = 0;
+}
+
+
+static int PTDPolygonEdgeCompare(const void *a, const void *b)
+{
+  double ya = ((const PTDPolygonEdge *)a)->yTop;
+  double yb = ((const PTDPolygonEdge *)b)->yTop;
+  return ya < yb ? -1 : (ya > yb ? 1 : 0);
+}
+
+
+/* Adds the horizontal coverage of the span [xa, xb) to a row. Partial
+ * pixels go to partial[], whole pixels are added through the difference
+ * array whole[]. */
+static void PTDAccumulateSpan(double xa, double xb, double width, float *partial, int *whole)
+{
+  if (xa < 0.0)
+    xa = 0.0;
+  if (xb > width)
+    xb = width;
+  if (xb <= xa)
+    return;
+  
+  long ia = (long)floor(xa);
+  long ib = (long)floor(xb);
+  if (ia == ib) {
+    partial[ia] += (float)(xb - xa);
+    return;
+  }
+  partial[ia] += (float)((double)(ia + 1) - xa);
+  whole[ia + 1] += 1;
+  whole[ib] -= 1;
+  if ((double)ib < width)
+    partial[ib] += (float)(xb - (double)ib);
+}
+
+
+int PTDSelectionMaskInitWithPolygon(PTDSelectionMask *mask, const double *points, size_t count, PTDFillRule rule, size_t canvasWidth, size_t canvasHeight)
+{
+  PTDSelectionMaskInit(mask, 0, 0, 0, 0);
+  if (count < 3)
+    return 1;
+  
+  double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+  for (size_t i = 0; i < count; i++) {
+    minX = fmin(minX, points[i*2]);
+    maxX = fmax(maxX, points[i*2]);
+    minY = fmin(minY, points[i*2+1]);
+    maxY = fmax(maxY, points[i*2+1]);
+  }
+  long x0 = (long)fmax(0.0, floor(minX));
+  long y0 = (long)fmax(0.0, floor(minY));
+  long x1 = (long)fmin((double)canvasWidth, ceil(maxX));
+  long y1 = (long)fmin((double)canvasHeight, ceil(maxY));
+  if (x1 <= x0 || y1 <= y0)
+    return 1;
+  
+  size_t width = (size_t)(x1 - x0);
+  size_t height = (size_t)(y1 - y0);
+  if (!PTDSelectionMaskInit(mask, x0, y0, width, height))
+    return 0;
+  
+  /* edges relative to the origin of the mask, sorted by their top */
+  PTDPolygonEdge *edges = malloc(count * sizeof(PTDPolygonEdge));
+  PTDEdgeCrossing *crossings = malloc(count * sizeof(PTDEdgeCrossing));
+  size_t *active = malloc(count * sizeof(size_t));
+  float *partial = calloc(width + 1, sizeof(float));
+  int *whole = calloc(width + 1, sizeof(int));
+  if (!edges || !crossings || !active || !partial || !whole) {
+    free(edges);
+    free(crossings);
+    free(active);
+    free(partial);
+    free(whole);
+    PTDSelectionMaskFree(mask);
+    return 0;
+  }
+  
+  size_t numEdges = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t j = (i + 1) % count;
+    double ax = points[i*2] - x0, ay = points[i*2+1] - y0;
+    double bx = points[j*2] - x0, by = points[j*2+1] - y0;
+    if (ay == by)
+      continue;
+    PTDPolygonEdge *e = &edges[numEdges++];
+    e->winding = ay < by ? 1 : -1;
+    if (ay > by) {
+      double t;
+      t = ax; ax = bx; bx = t;
+      t = ay; ay = by; by = t;
+    }
+    e->yTop = ay;
+    e->yBottom = by;
+    e->xTop = ax;
+    e->dxdy = (bx - ax) / (by - ay);
+  }
+  qsort(edges, numEdges, sizeof(PTDPolygonEdge), PTDPolygonEdgeCompare);
+  
+  size_t nextEdge = 0;
+  size_t numActive = 0;
+  const float subScale = 255.0f / (float)_SubScanlines;
+  
+  for (size_t row = 0; row < height; row++) {
+    for (int sub = 0; sub < _SubScanlines; sub++) {
+      double y = (double)row + ((double)sub + 0.5) / (double)_SubScanlines;
+      
+      while (nextEdge < numEdges && edges[nextEdge].yTop <= y)
+        active[numActive++] = nextEdge++;
+      size_t numCrossings = 0;
+      for (size_t k = 0; k < numActive; ) {
+        PTDPolygonEdge *e = &edges[active[k]];
+        if (e->yBottom <= y) {
+          active[k] = active[--numActive];
+          continue;
+        }
+        if (e->yTop <= y) {
+          /* insertion sort; the order rarely changes between scanlines */
+          PTDEdgeCrossing c = {e->xTop + (y - e->yTop) * e->dxdy, e->winding};
+          size_t p = numCrossings++;
+          while (p > 0 && crossings[p-1].x > c.x) {
+            crossings[p] = crossings[p-1];
+            p--;
+          }
+          crossings[p] = c;
+        }
+        k++;
+      }
+      
+      int wind = 0;
+      for (size_t k = 0; k + 1 < numCrossings; k++) {
+        if (rule == PTDFillRuleEvenOdd)
+          wind ^= 1;
+        else
+          wind += crossings[k].winding;
+        if (wind != 0)
+          PTDAccumulateSpan(crossings[k].x, crossings[k+1].x, (double)width, partial, whole);
+      }
+    }
+    
+    uint8_t *out = mask->coverage + row * width;
+    int run = 0;
+    for (size_t x = 0; x < width; x++) {
+      run += whole[x];
+      float v = ((float)run + partial[x]) * subScale;
+      out[x] = (uint8_t)(v >= 255.0f ? 255 : v + 0.5f);
+    }
+    memset(partial, 0, (width + 1) * sizeof(float));
+    memset(whole, 0, (width + 1) * sizeof(int));
+  }
+  
+  free(edges);
+  free(crossings);
+  free(active);
+  free(partial);
+  free(whole);
+  return 1;
+}
+
+
+/* Multiplies all the channels of a premultiplied pixel by m / 255, with
+ * the exact rounding of (t + (t >> 8)) >> 8 */
+static inline void PTDScalePixel(uint8_t *dst, const uint8_t *src, unsigned m)
+{
+  for (int c = 0; c < 4; c++) {
+    unsigned t = src[c] * m + 128;
+    dst[c] = (uint8_t)((t + (t >> 8)) >> 8);
+  }
+}
+
+
+/* Intersection of the mask with the canvas, in mask coordinates */
+static int PTDSelectionMaskClip(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas, size_t *mx0, size_t *my0, size_t *mx1, size_t *my1)
+{
+  long x0 = mask->x < 0 ? -mask->x : 0;
+  long y0 = mask->y < 0 ? -mask->y : 0;
+  long x1 = (long)canvas->width - mask->x;
+  long y1 = (long)canvas->height - mask->y;
+  if (x1 > (long)mask->width)
+    x1 = (long)mask->width;
+  if (y1 > (long)mask->height)
+    y1 = (long)mask->height;
+  if (x1 <= x0 || y1 <= y0 || !mask->coverage)
+    return 0;
+  *mx0 = (size_t)x0;
+  *my0 = (size_t)y0;
+  *mx1 = (size_t)x1;
+  *my1 = (size_t)y1;
+  return 1;
+}
+
+
+/* The canvas pixel under (x, y) of the mask, which must be inside both */
+static inline uint8_t *PTDSelectionMaskCanvasPixel(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas, size_t x, size_t y)
+{
+  return canvas->data + (size_t)(mask->y + (long)y) * canvas->bytesPerRow + (size_t)(mask->x + (long)x) * 4;
+}
+
+
+void PTDSelectionMaskCopy(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas, const PTDPixelBuffer *dst)
+{
+  for (size_t y = 0; y < dst->height; y++)
+    memset(dst->data + y * dst->bytesPerRow, 0, dst->width * 4);
+  
+  size_t x0, y0, x1, y1;
+  if (!PTDSelectionMaskClip(mask, canvas, &x0, &y0, &x1, &y1))
+    return;
+  
+  for (size_t y = y0; y < y1; y++) {
+    const uint8_t *m = mask->coverage + y * mask->width;
+    const uint8_t *src = PTDSelectionMaskCanvasPixel(mask, canvas, x0, y);
+    uint8_t *out = dst->data + y * dst->bytesPerRow + x0 * 4;
+    for (size_t x = x0; x < x1; x++, src += 4, out += 4) {
+      if (m[x] == 255)
+        memcpy(out, src, 4);
+      else if (m[x] != 0)
+        PTDScalePixel(out, src, m[x]);
+    }
+  }
+}
+
+
+void PTDSelectionMaskClear(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas)
+{
+  size_t x0, y0, x1, y1;
+  if (!PTDSelectionMaskClip(mask, canvas, &x0, &y0, &x1, &y1))
+    return;
+  
+  for (size_t y = y0; y < y1; y++) {
+    const uint8_t *m = mask->coverage + y * mask->width;
+    uint8_t *px = PTDSelectionMaskCanvasPixel(mask, canvas, x0, y);
+    for (size_t x = x0; x < x1; x++, px += 4) {
+      if (m[x] == 255)
+        memset(px, 0, 4);
+      else if (m[x] != 0)
+        PTDScalePixel(px, px, 255 - m[x]);
+    }
+  }
+}
+
+
+void PTDSelectionMaskPaste(const PTDSelectionMask *mask, const PTDPixelBuffer *src, const PTDPixelBuffer *canvas)
+{
+  size_t x0, y0, x1, y1;
+  if (!PTDSelectionMaskClip(mask, canvas, &x0, &y0, &x1, &y1))
+    return;
+  
+  for (size_t y = y0; y < y1; y++) {
+    const uint8_t *m = mask->coverage + y * mask->width;
+    const uint8_t *in = src->data + y * src->bytesPerRow + x0 * 4;
+    uint8_t *px = PTDSelectionMaskCanvasPixel(mask, canvas, x0, y);
+    for (size_t x = x0; x < x1; x++, in += 4, px += 4) {
+      if (m[x] == 255) {
+        memcpy(px, in, 4);
+      } else if (m[x] != 0) {
+        for (int c = 0; c < 4; c++) {
+          unsigned sum = px[c] + in[c];
+          px[c] = (uint8_t)(sum > 255 ? 255 : sum);
+        }
+      }
+    }
+  }
+}
+
+
+void PTDSelectionMaskFill(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas, const uint8_t color[4])
+{
+  size_t x0, y0, x1, y1;
+  if (!PTDSelectionMaskClip(mask, canvas, &x0, &y0, &x1, &y1))
+    return;
+  
+  for (size_t y = y0; y < y1; y++) {
+    const uint8_t *m = mask->coverage + y * mask->width;
+    uint8_t *px = PTDSelectionMaskCanvasPixel(mask, canvas, x0, y);
+    for (size_t x = x0; x < x1; x++, px += 4) {
+      if (m[x] == 255) {
+        memcpy(px, color, 4);
+      } else if (m[x] != 0) {
+        for (int c = 0; c < 4; c++) {
+          unsigned t = px[c] * (255u - m[x]) + color[c] * (unsigned)m[x] + 128;
+          px[c] = (uint8_t)((t + (t >> 8)) >> 8);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,81 @@
+//
+// PTDSelectionMask.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDSelectionMask_h
+#define PTDSelectionMask_h
+
+#include "PTDResampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  PTDFillRuleNonZero,
+  PTDFillRuleEvenOdd
+} PTDFillRule;
+
+/* 8 bit coverage values for a rectangular area of a canvas, with the first
+ * row on top. Coordinates are in canvas pixels. */
+typedef struct {
+  uint8_t *coverage;
+  long x;
+  long y;
+  size_t width;
+  size_t height;
+} PTDSelectionMask;
+
+/* Allocates a mask with zero coverage; returns 0 on failure */
+int PTDSelectionMaskInit(PTDSelectionMask *mask, long x, long y, size_t width, size_t height);
+void PTDSelectionMaskFree(PTDSelectionMask *mask);
+
+/* Rasterizes a closed polygon (an array of count x,y pairs) into an
+ * antialiased mask, clipped to a canvas of the given size. The mask
+ * only covers the bounding box of the polygon. Returns 0 on failure; an
+ * empty polygon produces a successful empty mask. */
+int PTDSelectionMaskInitWithPolygon(PTDSelectionMask *mask, const double *points, size_t count, PTDFillRule rule, size_t canvasWidth, size_t canvasHeight);
+
+/* Copies the pixels of the canvas under the mask to dst (which must be as
+ * large as the mask), weighted by the coverage of the mask. */
+void PTDSelectionMaskCopy(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas, const PTDPixelBuffer *dst);
+
+/* Erases the pixels of the canvas under the mask, proportionally to the
+ * coverage of the mask. */
+void PTDSelectionMaskClear(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas);
+
+/* Puts pixels copied with PTDSelectionMaskCopy back on the canvas, adding
+ * them to what PTDSelectionMaskClear left there. The canvas is restored
+ * exactly where the coverage is 0 or 255; elsewhere it may be off by one. */
+void PTDSelectionMaskPaste(const PTDSelectionMask *mask, const PTDPixelBuffer *src, const PTDPixelBuffer *canvas);
+
+/* Paints a premultiplied RGBA color on the canvas pixels under the mask,
+ * replacing them where the coverage is full. */
+void PTDSelectionMaskFill(const PTDSelectionMask *mask, const PTDPixelBuffer *canvas, const uint8_t color[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDSelectionMask_h */
@@ -27,10 +27,28 @@
 #import "PTDSelectionTool.h"
 #import "PTDDrawingSurface.h"
 #import "NSGeometry+PTD.h"
+#import "NSBitmapImageRep+PTD.h"
+#import "PTDAffineWarp.h"
+#import "PTDSelectionMask.h"
+#import "PTDRegionLabels.h"
+#import "PTDToolOptions.h"
+#import "PTDImageClipboard.h"
+#import "PTDImageImport.h"
+#import "PTDBlockTask.h"
+#import "PTDCanvasSnapshot.h"
 
 
 NSString * const PTDToolIdentifierSelectionTool = @"PTDToolIdentifierSelectionTool";
 
+NSString * const PTDSelectionToolOptionShape = @"shape";
+NSString * const PTDSelectionToolOptionWandTolerance = @"wandTolerance";
+
+typedef NS_ENUM(NSInteger, PTDSelectionToolShape) {
+  PTDSelectionToolShapeRectangle,
+  PTDSelectionToolShapeLasso,
+  PTDSelectionToolShapeMagicWand
+};
+
 typedef NS_ENUM(NSUInteger, PTDSelectionToolMode) {
   PTDSelectionToolModeMakeSelection,
   PTDSelectionToolModeEditSelection
@@ -47,6 +65,7 @@ typedef NS_ENUM(NSInteger, PTDSelectionToolHandleID) {
   PTDSelectionToolNWResizeHandle,
   PTDSelectionToolWResizeHandle,
   PTDSelectionToolLastResizeHandle = PTDSelectionToolWResizeHandle,
+  PTDSelectionToolRotateHandle,
   PTDSelectionToolDragHandle,
   PTDSelectionToolNumHandles
 };
@@ -54,26 +73,110 @@ typedef NS_ENUM(NSInteger, PTDSelectionToolHandleID) {
 typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
     PTDSelectionToolEditFlagsProportional = 1 << 0,
     PTDSelectionToolEditFlagsCentered = 1 << 1,
+    PTDSelectionToolEditFlagsSkew = 1 << 2,
 };
 
 
+/* Past this many regions the canvas is mostly noise, and labelling it
+ * would take more memory than it saves time */
+static const size_t _RegionLabelsMaxRegions = 1 << 20;
+
+
+static PTDAffineWarpMatrix PTDAffineWarpMatrixFromCGAffineTransform(CGAffineTransform t)
+{
+  return (PTDAffineWarpMatrix){t.a, t.b, t.c, t.d, t.tx, t.ty};
+}
+
+
+/* Labelling of the whole canvas, which answers magic wand clicks for as long
+ * as the canvas does not change */
+@interface PTDSelectionToolRegionCache: NSObject {
+@public
+  PTDRegionLabels _labels;
+}
+
+@property (nonatomic, readonly) NSUInteger canvasRevision;
+@property (nonatomic, readonly) uint8_t tolerance;
+
+- (nullable instancetype)initWithCanvasFrame:(const PTDCanvasFrame *)frame tolerance:(uint8_t)tolerance canvasRevision:(NSUInteger)revision;
+
+@end
+
+@implementation PTDSelectionToolRegionCache
+
+
+- (nullable instancetype)initWithCanvasFrame:(const PTDCanvasFrame *)frame tolerance:(uint8_t)tolerance canvasRevision:(NSUInteger)revision
+{
+  self = [super init];
+  if (!PTDRegionLabelsInitWithFrame(&_labels, frame, tolerance, _RegionLabelsMaxRegions))
+    return nil;
+  _tolerance = tolerance;
+  _canvasRevision = revision;
+  return self;
+}
+
+
+- (void)dealloc
+{
+  PTDRegionLabelsFree(&_labels);
+}
+
+
+@end
+
+
 @implementation PTDSelectionTool {
   PTDSelectionToolMode _mode;
+  PTDSelectionToolShape _shape;
   BOOL _isDragging;
   NSPoint _lastMenuPosition;
   
   NSRect _currentSelection;
+  /* maps _currentSelection to its position on the canvas */
+  CGAffineTransform _selectionTransform;
   
   NSImageRep *_selectedArea;
+  /* image being decoded for pasting in the current selection */
+  PTDImageImport *_pendingImport;
   
   NSPoint _dragPivot;
   NSPoint _lastMousePosition;
   NSRect _uneditedCurrentSelection;
+  CGAffineTransform _uneditedSelectionTransform;
   PTDSelectionToolHandleID _activeSelectionHandle;
   
+  /* vertices of the lasso in canvas pixels, as pairs of doubles */
+  NSMutableData *_lassoPoints;
+  CGMutablePathRef _lassoPath;
+  /* outline of a lasso selection being edited, and the rect of the
+   * selection it was drawn around; it follows the rect when it changes */
+  CGPathRef _selectionOutline;
+  NSRect _selectionOutlineRect;
+  
+  uint8_t _wandTolerance;
+  PTDSelectionToolRegionCache *_regionCache;
+  PTDTask *_labellingTask;
+  NSUInteger _labellingRevision;
+  uint8_t _labellingTolerance;
+  /* the canvas revision the current wand selection was lifted from, and the
+   * rect it was lifted from */
+  BOOL _isWandSelection;
+  NSUInteger _wandSourceRevision;
+  NSRect _wandSourceRect;
+  /* what was lifted, how, and the canvas revision right after lifting it,
+   * so that an untouched selection can be put back exactly */
+  PTDSelectionMask _wandMask;
+  NSBitmapImageRep *_wandLiftedArea;
+  NSUInteger _wandLiftedRevision;
+  /* putting back an untouched wand selection gives back the same canvas, so
+   * the revision after the commit is treated as an alias of the old one */
+  NSUInteger _revisionAliasFrom;
+  NSUInteger _revisionAliasTo;
+  
   CAShapeLayer *_selectionIndicator;
   CALayer *_selectionPreview;
   NSMutableArray <CALayer *> *_selectionHandleIndicators;
+  CALayer *_rotationHandleIndicator;
 }
 
 
@@ -81,11 +184,42 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 {
   self = [super init];
   _mode = PTDSelectionToolModeMakeSelection;
+  _selectionTransform = CGAffineTransformIdentity;
   _selectionHandleIndicators = [NSMutableArray array];
+  _labellingRevision = NSNotFound;
+  _revisionAliasFrom = NSNotFound;
   return self;
 }
 
 
+- (void)dealloc
+{
+  CGPathRelease(_lassoPath);
+  CGPathRelease(_selectionOutline);
+  PTDSelectionMaskFree(&_wandMask);
+  PTDTaskCancel(_labellingTask);
+  PTDTaskRelease(_labellingTask);
+}
+
+
++ (void)registerDefaults
+{
+  PTDToolOptions *o = PTDToolOptions.sharedOptions;
+  [o registerOption:PTDSelectionToolOptionShape ofToolClass:self types:@[[NSNumber class]] defaultValue:@(PTDSelectionToolShapeRectangle) validationBlock:nil];
+  [o registerOption:PTDSelectionToolOptionWandTolerance ofToolClass:self types:@[[NSNumber class]] defaultValue:@(32) validationBlock:nil];
+}
+
+
+- (void)reloadOptions
+{
+  _shape = [PTDToolOptions.sharedOptions integerForOption:PTDSelectionToolOptionShape ofToolClass:self.class];
+  NSInteger tolerance = [PTDToolOptions.sharedOptions integerForOption:PTDSelectionToolOptionWandTolerance ofToolClass:self.class];
+  _wandTolerance = (uint8_t)MIN(MAX(tolerance, 0), 255);
+  if (_shape != PTDSelectionToolShapeMagicWand)
+    [self discardRegionLabels];
+}
+
+
 + (NSString *)toolIdentifier
 {
   return PTDToolIdentifierSelectionTool;
@@ -104,6 +238,13 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 }
 
 
+- (BOOL)optionMenuDependsOnToolState
+{
+  /* Cut, Copy and Paste depend on the selection and on the pasteboard */
+  return YES;
+}
+
+
 - (nullable PTDRingMenuRing *)optionMenu
 {
   PTDRingMenuRing *res = [PTDRingMenuRing ring];
@@ -124,21 +265,99 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
   
   [res addSpringWithElasticity:1.0];
   
+  [res beginGravityMassGroupWithAngle:0];
+  itm = [res addItemWithText:NSLocalizedString(@"Flip Horizontally", @"Menu item for mirroring current selection horizontally") target:self action:@selector(flipHorizontally:)];
+  itm.enabled = _mode == PTDSelectionToolModeEditSelection;
+  itm = [res addItemWithText:NSLocalizedString(@"Flip Vertically", @"Menu item for mirroring current selection vertically") target:self action:@selector(flipVertically:)];
+  itm.enabled = _mode == PTDSelectionToolModeEditSelection;
+  [res endGravityMassGroup];
+  
+  [res addSpringWithElasticity:1.0];
+  
   itm = [res addItemWithText:NSLocalizedString(@"Delete", @"Menu item for deleting current selection") target:self action:@selector(delete:)];
   itm.enabled = _mode == PTDSelectionToolModeEditSelection;
   
   [res addSpringWithElasticity:1.0];
   
+  [res beginGravityMassGroupWithAngle:M_PI];
+  itm = [res addItemWithText:NSLocalizedString(@"Rectangle", @"Menu item for making rectangular selections") target:self action:@selector(changeShape:)];
+  itm.tag = PTDSelectionToolShapeRectangle;
+  if (_shape == PTDSelectionToolShapeRectangle)
+    itm.state = NSControlStateValueOn;
+  itm = [res addItemWithText:NSLocalizedString(@"Lasso", @"Menu item for making freehand selections") target:self action:@selector(changeShape:)];
+  itm.tag = PTDSelectionToolShapeLasso;
+  if (_shape == PTDSelectionToolShapeLasso)
+    itm.state = NSControlStateValueOn;
+  itm = [res addItemWithText:NSLocalizedString(@"Magic Wand", @"Menu item for selecting regions of similar color") target:self action:@selector(changeShape:)];
+  itm.tag = PTDSelectionToolShapeMagicWand;
+  if (_shape == PTDSelectionToolShapeMagicWand)
+    itm.state = NSControlStateValueOn;
+  [res endGravityMassGroup];
+  
+  [res addSpringWithElasticity:1.0];
+  
+  if (_shape == PTDSelectionToolShapeMagicWand) {
+    [res beginGravityMassGroupWithAngle:-M_PI_2];
+    static const NSInteger tolerances[] = {0, 32, 64, 128};
+    for (int i = 0; i < 4; i++) {
+      NSString *title = [NSString stringWithFormat:@"%d%%", (int)round(tolerances[i] * 100.0 / 255.0)];
+      itm = [res addItemWithText:title target:self action:@selector(changeWandTolerance:)];
+      itm.tag = tolerances[i];
+      if (tolerances[i] == _wandTolerance)
+        itm.state = NSControlStateValueOn;
+    }
+    [res endGravityMassGroup];
+    
+    [res addSpringWithElasticity:1.0];
+  }
+  
   return res;
 }
 
 
+- (void)changeShape:(id)sender
+{
+  [PTDToolOptions.sharedOptions setObject:@([(PTDRingMenuItem *)sender tag]) forOption:PTDSelectionToolOptionShape ofToolClass:self.class];
+}
+
+
+- (void)changeWandTolerance:(id)sender
+{
+  [PTDToolOptions.sharedOptions setObject:@([(PTDRingMenuItem *)sender tag]) forOption:PTDSelectionToolOptionWandTolerance ofToolClass:self.class];
+}
+
+
 - (void)delete:(id)sender
 {
   [self deleteAndTerminateEditSelection];
 }
 
 
+- (void)flipHorizontally:(id)sender
+{
+  [self flipSelectionWithScaleX:-1.0 y:1.0];
+}
+
+
+- (void)flipVertically:(id)sender
+{
+  [self flipSelectionWithScaleX:1.0 y:-1.0];
+}
+
+
+- (void)flipSelectionWithScaleX:(CGFloat)sx y:(CGFloat)sy
+{
+  if (_mode != PTDSelectionToolModeEditSelection)
+    return;
+  NSPoint c = PTD_NSRectCenter(_currentSelection);
+  CGAffineTransform flip = CGAffineTransformMakeTranslation(-c.x, -c.y);
+  flip = CGAffineTransformConcat(flip, CGAffineTransformMakeScale(sx, sy));
+  flip = CGAffineTransformConcat(flip, CGAffineTransformMakeTranslation(c.x, c.y));
+  _selectionTransform = CGAffineTransformConcat(flip, _selectionTransform);
+  [self updateSelectionIndicator];
+}
+
+
 - (void)cut:(id)sender
 {
   [self copy:sender];
@@ -154,15 +373,20 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
   }
   
   NSBitmapImageRep *area = (NSBitmapImageRep *)_selectedArea;
-  NSPasteboard *pb = [NSPasteboard generalPasteboard];
-  [pb declareTypes:@[NSPasteboardTypePNG] owner:nil];
-  NSData *png = [area representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
-  [pb setData:png forType:NSPasteboardTypePNG];
+  if (!CGAffineTransformIsIdentity(_selectionTransform))
+    area = [self renderTransformedSelectionInRect:NULL clipToCanvas:NO];
+  if (!area) {
+    NSBeep();
+    return;
+  }
+  [PTDImageClipboard writeImageRep:area toPasteboard:[NSPasteboard generalPasteboard]];
 }
 
 
 - (BOOL)canPasteFromPasteboard:(NSPasteboard *)pb
 {
+  if ([PTDImageClipboard imageRepFromPasteboard:pb])
+    return YES;
   if ([pb canReadItemWithDataConformingToTypes:@[NSPasteboardTypeFileURL]])
     return YES;
   return [NSBitmapImageRep canInitWithPasteboard:pb];
@@ -171,45 +395,112 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 
 - (void)paste:(id)sender
 {
+  NSPoint pasteLocation;
+  if ([sender isKindOfClass:[PTDRingMenuItem class]]) {
+    pasteLocation = _lastMenuPosition;
+  } else {
+    pasteLocation = NSEvent.mouseLocation;
+    pasteLocation = [self.currentDrawingSurface convertPointFromScreen:pasteLocation];
+    if (!NSPointInRect(pasteLocation, self.currentDrawingSurface.bounds)) {
+      pasteLocation = PTD_NSRectCenter(self.currentDrawingSurface.bounds);
+    }
+  }
+  
   NSPasteboard *pb = [NSPasteboard generalPasteboard];
-  NSImageRep *newImage;
+  /* images copied from this app are pasted back without decoding them */
+  NSImageRep *newImage = [PTDImageClipboard imageRepFromPasteboard:pb];
+  if (newImage) {
+    [self terminateEditSelection];
+    [self beginEditingPastedImage:newImage size:newImage.size centeredAtPoint:pasteLocation];
+    return;
+  }
   
+  PTDImageImport *import;
   NSURL *file = [NSURL URLFromPasteboard:pb];
+  if (file) {
+    import = [[PTDImageImport alloc] initWithContentsOfURL:file];
+  } else {
+    NSPasteboardType type = [pb availableTypeFromArray:@[NSPasteboardTypePNG, NSPasteboardTypeTIFF]];
+    if (type)
+      import = [[PTDImageImport alloc] initWithData:[pb dataForType:type]];
+  }
+  if (import) {
+    [self beginPastingImport:import centeredAtPoint:pasteLocation];
+    return;
+  }
+  
   if (file) {
     newImage = [NSImageRep imageRepWithContentsOfURL:file];
   } else {
     newImage = [NSImageRep imageRepWithPasteboard:pb];
   }
-  
   if (!newImage) {
     NSBeep();
     return;
   }
-  
-  NSPoint pasteLocation;
-  if ([sender isKindOfClass:[PTDRingMenuItem class]]) {
-    pasteLocation = _lastMenuPosition;
-  } else {
-    pasteLocation = NSEvent.mouseLocation;
-    pasteLocation = [self.currentDrawingSurface convertPointFromScreen:pasteLocation];
-    if (!NSPointInRect(pasteLocation, self.currentDrawingSurface.bounds)) {
-      pasteLocation = PTD_NSRectCenter(self.currentDrawingSurface.bounds);
-    }
-  }
-  
   [self terminateEditSelection];
-  _selectedArea = newImage;
+  [self beginEditingPastedImage:newImage size:newImage.size centeredAtPoint:pasteLocation];
+}
+
+
+- (void)beginEditingPastedImage:(nullable NSImageRep *)image size:(NSSize)size centeredAtPoint:(NSPoint)point
+{
+  _selectedArea = image;
+  _selectionTransform = CGAffineTransformIdentity;
   _currentSelection = NSMakeRect(
-      pasteLocation.x - _selectedArea.size.width / 2.0,
-      pasteLocation.y - _selectedArea.size.height / 2.0,
-      _selectedArea.size.width,
-      _selectedArea.size.height);
+      point.x - size.width / 2.0,
+      point.y - size.height / 2.0,
+      size.width,
+      size.height);
   _currentSelection.origin = [self.currentDrawingSurface alignPointToBacking:_currentSelection.origin];
   _mode = PTDSelectionToolModeEditSelection;
   [self createSelectionIndicator];
 }
 
 
+- (void)beginPastingImport:(PTDImageImport *)import centeredAtPoint:(NSPoint)point
+{
+  PTDDrawingSurface *surface = self.currentDrawingSurface;
+  
+  /* images larger than the canvas are scaled down to fit it */
+  NSSize size = import.size;
+  NSSize bounds = surface.bounds.size;
+  CGFloat fit = MIN(1.0, MIN(bounds.width / size.width, bounds.height / size.height));
+  size = NSMakeSize(MAX(1.0, round(size.width * fit)), MAX(1.0, round(size.height * fit)));
+  
+  /* the selection can be edited while the image is decoded; until then
+   * the preview shows a placeholder */
+  [self terminateEditSelection];
+  _pendingImport = import;
+  [self beginEditingPastedImage:nil size:size centeredAtPoint:point];
+  
+  NSSize scale = surface.backingScaleFactor;
+  NSSize pixelSize = NSMakeSize(size.width * scale.width, size.height * scale.height);
+  __weak PTDSelectionTool *weakSelf = self;
+  [import decodeImageFittingPixelSize:pixelSize completionHandler:^(NSBitmapImageRep *image) {
+    [weakSelf finishPastingImport:import image:image size:size];
+  }];
+}
+
+
+- (void)finishPastingImport:(PTDImageImport *)import image:(nullable NSBitmapImageRep *)image size:(NSSize)size
+{
+  if (_pendingImport != import)
+    return;
+  _pendingImport = nil;
+  if (!image) {
+    NSBeep();
+    [self terminateEditSelection];
+    return;
+  }
+  
+  image.size = size;
+  _selectedArea = image;
+  _selectionPreview.contents = nil;
+  [self updateSelectionIndicator];
+}
+
+
 - (void)dragDidStartAtPoint:(NSPoint)point
 {
   _isDragging = YES;
@@ -275,6 +566,7 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 - (void)deactivate
 {
   [self terminateEditSelection];
+  [self discardRegionLabels];
 }
 
 
@@ -283,15 +575,24 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 
 - (void)newSelection_dragDidStartAtPoint:(NSPoint)point
 {
+  if (_shape == PTDSelectionToolShapeLasso) {
+    [self lasso_dragDidStartAtPoint:point];
+    return;
+  }
   _dragPivot = [self.currentDrawingSurface alignPointToBacking:point];
   _currentSelection.origin = _dragPivot;
   _currentSelection.size = NSZeroSize;
+  _selectionTransform = CGAffineTransformIdentity;
   [self createSelectionIndicator];
 }
 
 
 - (void)newSelection_dragDidContinueFromPoint:(NSPoint)prevPoint toPoint:(NSPoint)nextPoint
 {
+  if (_lassoPath) {
+    [self lasso_dragDidContinueFromPoint:prevPoint toPoint:nextPoint];
+    return;
+  }
   _currentSelection = PTD_NSMakeRectFromPoints(_dragPivot, [self.currentDrawingSurface alignPointToBacking:nextPoint]);
   [self updateSelectionIndicator];
 }
@@ -299,6 +600,10 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 
 - (void)newSelection_dragDidEndAtPoint:(NSPoint)point
 {
+  if (_lassoPath) {
+    [self lasso_dragDidEndAtPoint:point];
+    return;
+  }
   point = [self.currentDrawingSurface alignPointToBacking:point];
   _currentSelection = PTD_NSMakeRectFromPoints(_dragPivot, point);
   if (_currentSelection.size.width < 1 || _currentSelection.size.height < 1) {
@@ -308,10 +613,11 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
   
   _selectedArea = [self.currentDrawingSurface captureRect:_currentSelection];
   
-  [self.currentDrawingSurface beginCanvasDrawing];
+  [self.currentDrawingSurface beginCanvasDrawingInRect:_currentSelection];
   [NSGraphicsContext.currentContext setCompositingOperation:NSCompositingOperationClear];
   [NSColor.clearColor setFill];
   NSRectFill(_currentSelection);
+  [self.currentDrawingSurface canvasDidChangeInRect:_currentSelection];
   
   _mode = PTDSelectionToolModeEditSelection;
   [self updateSelectionIndicator];
@@ -321,6 +627,211 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 - (void)newSelection_mouseClickedAtPoint:(NSPoint)point
 {
   [self terminateEditSelection];
+  if (_shape == PTDSelectionToolShapeMagicWand)
+    [self wand_selectRegionAtPoint:point];
+}
+
+
+#pragma mark - Lasso Selection
+
+
+- (void)lasso_dragDidStartAtPoint:(NSPoint)point
+{
+  _lassoPoints = [NSMutableData data];
+  CGPathRelease(_lassoPath);
+  _lassoPath = CGPathCreateMutable();
+  CGPathMoveToPoint(_lassoPath, NULL, point.x, point.y);
+  [self appendLassoPoint:point];
+  
+  _currentSelection.origin = point;
+  _currentSelection.size = NSZeroSize;
+  _selectionTransform = CGAffineTransformIdentity;
+  [self createSelectionIndicator];
+}
+
+
+- (void)lasso_dragDidContinueFromPoint:(NSPoint)prevPoint toPoint:(NSPoint)nextPoint
+{
+  CGPathAddLineToPoint(_lassoPath, NULL, nextPoint.x, nextPoint.y);
+  [self appendLassoPoint:nextPoint];
+  [self updateSelectionIndicator];
+}
+
+
+- (void)lasso_dragDidEndAtPoint:(NSPoint)point
+{
+  [self appendLassoPoint:point];
+  
+  NSSize canvasSize = self.currentDrawingSurface.canvasPixelSize;
+  PTDSelectionMask mask;
+  int success = PTDSelectionMaskInitWithPolygon(&mask,
+      _lassoPoints.bytes, _lassoPoints.length / (2 * sizeof(double)), PTDFillRuleEvenOdd,
+      (size_t)canvasSize.width, (size_t)canvasSize.height);
+  
+  CGPathCloseSubpath(_lassoPath);
+  CGPathRef outline = CGPathCreateCopy(_lassoPath);
+  [self discardLasso];
+  
+  if (!success || mask.width == 0 || mask.height == 0) {
+    if (!success)
+      NSLog(@"warning: could not allocate the lasso selection mask");
+    PTDSelectionMaskFree(&mask);
+    CGPathRelease(outline);
+    [self removeSelectionIndicator];
+    return;
+  }
+  
+  [self beginEditingSelectionWithMask:&mask outline:outline];
+  PTDSelectionMaskFree(&mask);
+  CGPathRelease(outline);
+}
+
+
+- (void)appendLassoPoint:(NSPoint)point
+{
+  NSPoint px = [self.currentDrawingSurface convertPointToCanvasPixels:point];
+  double xy[2] = {px.x, px.y};
+  [_lassoPoints appendBytes:xy length:sizeof(xy)];
+}
+
+
+- (void)discardLasso
+{
+  _lassoPoints = nil;
+  CGPathRelease(_lassoPath);
+  _lassoPath = NULL;
+}
+
+
+- (void)beginEditingSelectionWithMask:(const PTDSelectionMask *)mask outline:(nullable CGPathRef)outline
+{
+  PTDDrawingSurface *surface = self.currentDrawingSurface;
+  _currentSelection = [surface convertRectFromCanvasPixels:NSMakeRect(mask->x, mask->y, mask->width, mask->height)];
+  _selectionTransform = CGAffineTransformIdentity;
+  CGPathRelease(_selectionOutline);
+  _selectionOutline = CGPathRetain(outline);
+  _selectionOutlineRect = _currentSelection;
+  
+  /* only the pixels in the bounding box of the mask are touched */
+  __block NSBitmapImageRep *area;
+  NSRect selection = _currentSelection;
+  [surface modifyCanvasPixelsInRect:selection usingBlock:^NSRect(NSBitmapImageRep *canvas) {
+    area = [[NSBitmapImageRep alloc]
+        initWithBitmapDataPlanes:NULL
+        pixelsWide:mask->width pixelsHigh:mask->height
+        bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+        colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:32];
+    area = [area bitmapImageRepByRetaggingWithColorSpace:canvas.colorSpace];
+    PTDPixelBuffer canvasBuf = canvas.ptd_pixelBuffer;
+    PTDPixelBuffer areaBuf = area.ptd_pixelBuffer;
+    PTDSelectionMaskCopy(mask, &canvasBuf, &areaBuf);
+    PTDSelectionMaskClear(mask, &canvasBuf);
+    return selection;
+  }];
+  area.size = _currentSelection.size;
+  _selectedArea = area;
+  
+  _mode = PTDSelectionToolModeEditSelection;
+  [self updateSelectionIndicator];
+}
+
+
+#pragma mark - Magic Wand Selection
+
+
+- (NSUInteger)wandCanvasRevision
+{
+  NSUInteger revision = self.currentDrawingSurface.canvasRevision;
+  if (revision == _revisionAliasFrom)
+    return _revisionAliasTo;
+  return revision;
+}
+
+
+- (void)wand_selectRegionAtPoint:(NSPoint)point
+{
+  PTDDrawingSurface *surface = self.currentDrawingSurface;
+  NSPoint px = [surface convertPointToCanvasPixels:point];
+  NSSize canvasSize = surface.canvasPixelSize;
+  if (px.x < 0 || px.y < 0 || px.x >= canvasSize.width || px.y >= canvasSize.height)
+    return;
+  size_t x = (size_t)px.x, y = (size_t)px.y;
+  
+  NSUInteger revision = [self wandCanvasRevision];
+  __block PTDSelectionMask mask;
+  __block int success;
+  if (_regionCache && _regionCache.canvasRevision == revision && _regionCache.tolerance == _wandTolerance) {
+    success = PTDRegionLabelsMaskAtPixel(&_regionCache->_labels, x, y, &mask);
+  } else {
+    /* answer this click by visiting just the region, and label the whole
+     * canvas in the background for the next ones */
+    uint8_t tolerance = _wandTolerance;
+    [surface readCanvasPixelsUsingBlock:^(const PTDPixelBuffer *canvas) {
+      success = PTDRegionMaskAtPixel(canvas, x, y, tolerance, &mask);
+    }];
+    [self scheduleRegionLabellingForCanvasRevision:revision];
+  }
+  
+  if (!success || mask.width == 0 || mask.height == 0) {
+    if (!success)
+      NSLog(@"warning: could not allocate the magic wand selection mask");
+    PTDSelectionMaskFree(&mask);
+    return;
+  }
+  
+  [self createSelectionIndicator];
+  [self beginEditingSelectionWithMask:&mask outline:NULL];
+  
+  _isWandSelection = YES;
+  _wandSourceRevision = revision;
+  _wandSourceRect = _currentSelection;
+  PTDSelectionMaskFree(&_wandMask);
+  _wandMask = mask;
+  _wandLiftedArea = (NSBitmapImageRep *)_selectedArea;
+  _wandLiftedRevision = self.currentDrawingSurface.canvasRevision;
+}
+
+
+- (void)scheduleRegionLabellingForCanvasRevision:(NSUInteger)revision
+{
+  if (_labellingRevision == revision && _labellingTolerance == _wandTolerance)
+    return;
+  _labellingRevision = revision;
+  _labellingTolerance = _wandTolerance;
+  
+  /* the canvas keeps changing while the labelling is in progress; the
+   * published frame only costs a copy of the tiles changed since the last
+   * time it was published. The canvas objects are labelled as they are
+   * shown, without flattening them. */
+  PTDCanvasSnapshot *snapshot = [self.currentDrawingSurface publishedSnapshotIncludingCanvasObjects];
+  if (!snapshot) {
+    NSLog(@"warning: could not publish the canvas for labelling");
+    return;
+  }
+  
+  /* the labels for an older revision would be thrown away anyway */
+  PTDTaskCancel(_labellingTask);
+  PTDTaskRelease(_labellingTask);
+  uint8_t tolerance = _wandTolerance;
+  __weak PTDSelectionTool *weakSelf = self;
+  _labellingTask = PTDBlockTaskCreate(PTDTaskPriorityPrefetch, ^(PTDTask *task) {
+    PTDSelectionToolRegionCache *cache = [[PTDSelectionToolRegionCache alloc] initWithCanvasFrame:snapshot.canvasFrame tolerance:tolerance canvasRevision:revision];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      PTDSelectionTool *tool = weakSelf;
+      if (!tool || tool->_labellingRevision != revision || tool->_labellingTolerance != tolerance)
+        return;
+      if (cache)
+        tool->_regionCache = cache;
+    });
+  });
+  PTDTaskSchedulerSubmit(PTDTaskSchedulerShared(), _labellingTask);
+}
+
+
+- (void)discardRegionLabels
+{
+  _regionCache = nil;
+  _labellingRevision = NSNotFound;
 }
 
 
@@ -339,6 +850,7 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
   _lastMousePosition = point = [self.currentDrawingSurface alignPointToBacking:point];
   _dragPivot = point;
   _uneditedCurrentSelection = _currentSelection;
+  _uneditedSelectionTransform = _selectionTransform;
 }
 
 
@@ -358,28 +870,49 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 
 - (void)editSelection_mouseClickedAtPoint:(NSPoint)point
 {
-  if (!NSPointInRect(point, _currentSelection)) {
+  CGAffineTransform toLocal = CGAffineTransformInvert(_selectionTransform);
+  if (!NSPointInRect(CGPointApplyAffineTransform(point, toLocal), _currentSelection)) {
     [self terminateEditSelection];
+    if (_shape == PTDSelectionToolShapeMagicWand)
+      [self wand_selectRegionAtPoint:point];
   }
 }
 
 
 - (void)continueEditingSelection
 {
+  if (_activeSelectionHandle == PTDSelectionToolRotateHandle) {
+    [self continueRotatingSelection];
+    return;
+  }
+  
   PTDSelectionToolEditFlags flags = 0;
   if (_activeSelectionHandle != PTDSelectionToolDragHandle) {
     if (NSEvent.modifierFlags & NSEventModifierFlagShift)
       flags |= PTDSelectionToolEditFlagsProportional;
     if (NSEvent.modifierFlags & NSEventModifierFlagOption)
       flags |= PTDSelectionToolEditFlagsCentered;
+    if (NSEvent.modifierFlags & NSEventModifierFlagCommand)
+      flags |= PTDSelectionToolEditFlagsSkew;
+  }
+  
+  /* resizing happens in the untransformed space of the selection */
+  CGAffineTransform toLocal = CGAffineTransformInvert(_uneditedSelectionTransform);
+  NSPoint lastMousePosition = CGPointApplyAffineTransform(_lastMousePosition, toLocal);
+  NSPoint dragPivot = CGPointApplyAffineTransform(_dragPivot, toLocal);
+  
+  if (flags & PTDSelectionToolEditFlagsSkew) {
+    if ([self continueSkewingSelectionWithDelta:NSMakePoint(lastMousePosition.x - dragPivot.x, lastMousePosition.y - dragPivot.y)])
+      return;
   }
+  _selectionTransform = _uneditedSelectionTransform;
   
   NSRect coeffs = [self transformCoefficientsForSelectionHandle:_activeSelectionHandle editFlags:flags];
   
-  CGFloat dx = (_lastMousePosition.x - _dragPivot.x) * coeffs.origin.x;
-  CGFloat dy = (_lastMousePosition.y - _dragPivot.y) * coeffs.origin.y;
-  CGFloat dw = (_lastMousePosition.x - _dragPivot.x) * coeffs.size.width;
-  CGFloat dh = (_lastMousePosition.y - _dragPivot.y) * coeffs.size.height;
+  CGFloat dx = (lastMousePosition.x - dragPivot.x) * coeffs.origin.x;
+  CGFloat dy = (lastMousePosition.y - dragPivot.y) * coeffs.origin.y;
+  CGFloat dw = (lastMousePosition.x - dragPivot.x) * coeffs.size.width;
+  CGFloat dh = (lastMousePosition.y - dragPivot.y) * coeffs.size.height;
   
   if (flags & PTDSelectionToolEditFlagsProportional) {
     CGFloat ratio = _uneditedCurrentSelection.size.width / _uneditedCurrentSelection.size.height;
@@ -420,9 +953,57 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 }
 
 
+- (void)continueRotatingSelection
+{
+  NSPoint c = CGPointApplyAffineTransform(PTD_NSRectCenter(_uneditedCurrentSelection), _uneditedSelectionTransform);
+  CGFloat a0 = atan2(_dragPivot.y - c.y, _dragPivot.x - c.x);
+  CGFloat a1 = atan2(_lastMousePosition.y - c.y, _lastMousePosition.x - c.x);
+  CGFloat angle = a1 - a0;
+  if (NSEvent.modifierFlags & NSEventModifierFlagShift)
+    angle = round(angle / (M_PI / 12.0)) * (M_PI / 12.0);
+  
+  CGAffineTransform rot = CGAffineTransformMakeTranslation(-c.x, -c.y);
+  rot = CGAffineTransformConcat(rot, CGAffineTransformMakeRotation(angle));
+  rot = CGAffineTransformConcat(rot, CGAffineTransformMakeTranslation(c.x, c.y));
+  _currentSelection = _uneditedCurrentSelection;
+  _selectionTransform = CGAffineTransformConcat(_uneditedSelectionTransform, rot);
+  [self updateSelectionIndicator];
+}
+
+
+- (BOOL)continueSkewingSelectionWithDelta:(NSPoint)delta
+{
+  NSRect r = _uneditedCurrentSelection;
+  CGFloat kx = 0.0, ky = 0.0;
+  switch (_activeSelectionHandle) {
+    case PTDSelectionToolNResizeHandle:
+      kx = delta.x / (r.size.height / 2.0); break;
+    case PTDSelectionToolSResizeHandle:
+      kx = -delta.x / (r.size.height / 2.0); break;
+    case PTDSelectionToolEResizeHandle:
+      ky = delta.y / (r.size.width / 2.0); break;
+    case PTDSelectionToolWResizeHandle:
+      ky = -delta.y / (r.size.width / 2.0); break;
+    default:
+      return NO;
+  }
+  
+  NSPoint c = PTD_NSRectCenter(r);
+  CGAffineTransform skew = CGAffineTransformMakeTranslation(-c.x, -c.y);
+  skew = CGAffineTransformConcat(skew, CGAffineTransformMake(1.0, ky, kx, 1.0, 0.0, 0.0));
+  skew = CGAffineTransformConcat(skew, CGAffineTransformMakeTranslation(c.x, c.y));
+  _currentSelection = r;
+  _selectionTransform = CGAffineTransformConcat(skew, _uneditedSelectionTransform);
+  [self updateSelectionIndicator];
+  return YES;
+}
+
+
 - (NSPoint)centerOfSelectionHandle:(PTDSelectionToolHandleID)handle
 {
   switch (handle) {
+    case PTDSelectionToolRotateHandle:
+      return NSMakePoint(PTD_NSRectCenter(_currentSelection).x, NSMaxY(_currentSelection) + 16.0); break;
     case PTDSelectionToolSWResizeHandle:
       return NSMakePoint(NSMinX(_currentSelection)+.5         , NSMinY(_currentSelection)+.5         ); break;
     case PTDSelectionToolSResizeHandle:
@@ -453,11 +1034,13 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
     (NSPoint){(p).x - HANDLE_WIDTH/2.0, (p).y - HANDLE_WIDTH/2.0}, \
     (NSPoint){(p).x + HANDLE_WIDTH/2.0, (p).y + HANDLE_WIDTH/2.0})
   
-  for (NSInteger i=PTDSelectionToolFirstResizeHandle; i<=PTDSelectionToolLastResizeHandle; i++) {
-    if (NSPointInRect(loc, HANDLE_RECT([self centerOfSelectionHandle:i])))
+  for (NSInteger i=PTDSelectionToolFirstResizeHandle; i<=PTDSelectionToolRotateHandle; i++) {
+    NSPoint center = CGPointApplyAffineTransform([self centerOfSelectionHandle:i], _selectionTransform);
+    if (NSPointInRect(loc, HANDLE_RECT(center)))
       return i;
   }
-  if (NSPointInRect(loc, _currentSelection))
+  CGAffineTransform toLocal = CGAffineTransformInvert(_selectionTransform);
+  if (NSPointInRect(CGPointApplyAffineTransform(loc, toLocal), _currentSelection))
     return PTDSelectionToolDragHandle;
   return NSNotFound;
   
@@ -508,17 +1091,130 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
 
 - (void)terminateEditSelection
 {
-  if (_selectedArea) {
-    [self.currentDrawingSurface beginCanvasDrawing];
-    [_selectedArea drawInRect:_currentSelection fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0 respectFlipped:YES hints:@{NSImageHintInterpolation: @(NSImageInterpolationHigh)}];
+  /* the canvas must not have changed since lifting the selection either */
+  BOOL untouchedWandSelection = _isWandSelection && _selectedArea == _wandLiftedArea
+      && CGAffineTransformIsIdentity(_selectionTransform)
+      && NSEqualRects(_currentSelection, _wandSourceRect)
+      && self.currentDrawingSurface.canvasRevision == _wandLiftedRevision;
+  _isWandSelection = NO;
+  _wandLiftedArea = nil;
+  
+  if (untouchedWandSelection) {
+    /* wand masks have no partial coverage, so the pixels go back exactly
+     * and the labels of the canvas they were lifted from stay valid */
+    NSBitmapImageRep *area = (NSBitmapImageRep *)_selectedArea;
+    const PTDSelectionMask *mask = &_wandMask;
+    NSRect rect = _currentSelection;
+    [self.currentDrawingSurface modifyCanvasPixelsInRect:rect usingBlock:^NSRect(NSBitmapImageRep *canvas) {
+      PTDPixelBuffer canvasBuf = canvas.ptd_pixelBuffer;
+      PTDPixelBuffer areaBuf = area.ptd_pixelBuffer;
+      PTDSelectionMaskPaste(mask, &areaBuf, &canvasBuf);
+      return rect;
+    }];
+    _selectedArea = nil;
+    _revisionAliasFrom = self.currentDrawingSurface.canvasRevision;
+    _revisionAliasTo = _wandSourceRevision;
+  } else if (_selectedArea) {
+    NSRect destRect = _currentSelection;
+    if (!CGAffineTransformIsIdentity(_selectionTransform)) {
+      _selectedArea = [self renderTransformedSelectionInRect:&destRect clipToCanvas:YES];
+    } else if ([_selectedArea isKindOfClass:NSBitmapImageRep.class]) {
+      NSSize scale = self.currentDrawingSurface.backingScaleFactor;
+      NSInteger width = round(_currentSelection.size.width * scale.width);
+      NSInteger height = round(_currentSelection.size.height * scale.height);
+      if (width != _selectedArea.pixelsWide || height != _selectedArea.pixelsHigh)
+        _selectedArea = [(NSBitmapImageRep *)_selectedArea ptd_imageRepByResamplingToPixelsWide:width pixelsHigh:height];
+    }
+    [self.currentDrawingSurface beginCanvasDrawingInRect:NSInsetRect(destRect, -1, -1)];
+    [_selectedArea drawInRect:destRect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0 respectFlipped:YES hints:@{NSImageHintInterpolation: @(NSImageInterpolationHigh)}];
+    [self.currentDrawingSurface canvasDidChangeInRect:NSInsetRect(destRect, -1, -1)];
     _selectedArea = nil;
     [self.currentDrawingSurface endCanvasDrawing];
   }
+  PTDSelectionMaskFree(&_wandMask);
+  _selectionTransform = CGAffineTransformIdentity;
+  _pendingImport = nil;
+  [self discardLasso];
+  CGPathRelease(_selectionOutline);
+  _selectionOutline = NULL;
   [self removeSelectionIndicator];
   _mode = PTDSelectionToolModeMakeSelection;
 }
 
 
+- (NSBitmapImageRep *)selectedAreaBitmapWithPixelsWide:(NSInteger)width pixelsHigh:(NSInteger)height
+{
+  if ([_selectedArea isKindOfClass:NSBitmapImageRep.class]) {
+    NSBitmapImageRep *bitmap = (NSBitmapImageRep *)_selectedArea;
+    if (width != bitmap.pixelsWide || height != bitmap.pixelsHigh)
+      bitmap = [bitmap ptd_imageRepByResamplingToPixelsWide:width pixelsHigh:height];
+    return bitmap.ptd_premultipliedRGBA8ImageRep;
+  }
+  
+  NSBitmapImageRep *bitmap = [[NSBitmapImageRep alloc]
+      initWithBitmapDataPlanes:NULL
+      pixelsWide:width pixelsHigh:height
+      bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+      colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:32];
+  @autoreleasepool {
+    [NSGraphicsContext saveGraphicsState];
+    NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap];
+    [_selectedArea drawInRect:NSMakeRect(0, 0, width, height)];
+    [NSGraphicsContext restoreGraphicsState];
+  }
+  return bitmap;
+}
+
+
+- (NSBitmapImageRep *)renderTransformedSelectionInRect:(NSRect *)outRect clipToCanvas:(BOOL)clip
+{
+  NSSize scale = self.currentDrawingSurface.backingScaleFactor;
+  NSInteger srcWidth = MAX(1, round(_currentSelection.size.width * scale.width));
+  NSInteger srcHeight = MAX(1, round(_currentSelection.size.height * scale.height));
+  NSBitmapImageRep *source = [self selectedAreaBitmapWithPixelsWide:srcWidth pixelsHigh:srcHeight];
+  
+  /* smallest backing-aligned rect containing the transformed selection */
+  NSRect bbox = CGRectApplyAffineTransform(_currentSelection, _selectionTransform);
+  if (clip)
+    bbox = NSIntersectionRect(bbox, self.currentDrawingSurface.bounds);
+  CGFloat minX = floor(NSMinX(bbox) * scale.width);
+  CGFloat minY = floor(NSMinY(bbox) * scale.height);
+  NSInteger dstWidth = ceil(NSMaxX(bbox) * scale.width) - minX;
+  NSInteger dstHeight = ceil(NSMaxY(bbox) * scale.height) - minY;
+  if (dstWidth <= 0 || dstHeight <= 0)
+    return nil;
+  NSRect dest = NSMakeRect(minX / scale.width, minY / scale.height, dstWidth / scale.width, dstHeight / scale.height);
+  
+  NSBitmapImageRep *res = [[NSBitmapImageRep alloc]
+      initWithBitmapDataPlanes:NULL
+      pixelsWide:dstWidth pixelsHigh:dstHeight
+      bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO
+      colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:32];
+  res = [res bitmapImageRepByRetaggingWithColorSpace:source.colorSpace];
+  
+  /* source pixels (first row on top) -> selection -> canvas -> destination
+   * pixels (first row on top) */
+  CGAffineTransform srcToLocal = CGAffineTransformMake(
+      _currentSelection.size.width / srcWidth, 0, 0, -_currentSelection.size.height / srcHeight,
+      NSMinX(_currentSelection), NSMaxY(_currentSelection));
+  CGAffineTransform canvasToDst = CGAffineTransformMake(
+      scale.width, 0, 0, -scale.height,
+      -NSMinX(dest) * scale.width, NSMaxY(dest) * scale.height);
+  CGAffineTransform srcToDst = CGAffineTransformConcat(CGAffineTransformConcat(srcToLocal, _selectionTransform), canvasToDst);
+  PTDAffineWarpMatrix dstToSrc = PTDAffineWarpMatrixInvert(PTDAffineWarpMatrixFromCGAffineTransform(srcToDst));
+  
+  PTDPixelBuffer srcBuf = source.ptd_pixelBuffer;
+  PTDPixelBuffer dstBuf = res.ptd_pixelBuffer;
+  if (!PTDAffineWarp(&srcBuf, &dstBuf, dstToSrc))
+    return nil;
+  
+  res.size = dest.size;
+  if (outRect)
+    *outRect = dest;
+  return res;
+}
+
+
 #pragma mark - Selection Indicator
 
 
@@ -558,6 +1254,14 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
     [_selectionHandleIndicators addObject:shi];
   }
   
+  _rotationHandleIndicator = [[CALayer alloc] init];
+  [_selectionIndicator addSublayer:_rotationHandleIndicator];
+  _rotationHandleIndicator.backgroundColor = NSColor.whiteColor.CGColor;
+  _rotationHandleIndicator.borderColor = NSColor.blackColor.CGColor;
+  _rotationHandleIndicator.borderWidth = 1.0;
+  _rotationHandleIndicator.bounds = NSMakeRect(0, 0, 7, 7);
+  _rotationHandleIndicator.cornerRadius = 3.5;
+  
   [self updateSelectionIndicator];
 }
 
@@ -567,7 +1271,22 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
   [CATransaction begin];
   CATransaction.disableActions = YES;
   
-  CGPathRef path = CGPathCreateWithRect(NSInsetRect(_currentSelection, .5, .5), NULL);
+  CGAffineTransform transform = _selectionTransform;
+  CGPathRef path;
+  if (_lassoPath) {
+    path = CGPathCreateCopy(_lassoPath);
+  } else if (_selectionOutline) {
+    /* stretch the outline from the rect it was drawn in to the current one */
+    CGAffineTransform fit = CGAffineTransformMakeTranslation(-NSMinX(_selectionOutlineRect), -NSMinY(_selectionOutlineRect));
+    fit = CGAffineTransformConcat(fit, CGAffineTransformMakeScale(
+        NSWidth(_currentSelection) / NSWidth(_selectionOutlineRect),
+        NSHeight(_currentSelection) / NSHeight(_selectionOutlineRect)));
+    fit = CGAffineTransformConcat(fit, CGAffineTransformMakeTranslation(NSMinX(_currentSelection), NSMinY(_currentSelection)));
+    fit = CGAffineTransformConcat(fit, transform);
+    path = CGPathCreateCopyByTransformingPath(_selectionOutline, &fit);
+  } else {
+    path = CGPathCreateWithRect(NSInsetRect(_currentSelection, .5, .5), &transform);
+  }
   _selectionIndicator.path = path;
   CGPathRelease(path);
   
@@ -579,8 +1298,15 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
       NSRect proposedRect = (NSRect){NSZeroPoint, _currentSelection.size};
       _selectionPreview.contents = (id)[_selectedArea CGImageForProposedRect:&proposedRect context:nil hints:nil];
     }
+    _selectionPreview.backgroundColor = _pendingImport ? [NSColor colorWithWhite:0.5 alpha:0.5].CGColor : NULL;
   }
-  _selectionPreview.frame = _currentSelection;
+  /* the layer applies its transform around its center */
+  CGAffineTransform linear = transform;
+  linear.tx = linear.ty = 0;
+  _selectionPreview.affineTransform = CGAffineTransformIdentity;
+  _selectionPreview.bounds = (NSRect){NSZeroPoint, _currentSelection.size};
+  _selectionPreview.position = CGPointApplyAffineTransform(PTD_NSRectCenter(_currentSelection), transform);
+  _selectionPreview.affineTransform = linear;
   
   for (PTDSelectionToolHandleID i=PTDSelectionToolFirstResizeHandle; i<=PTDSelectionToolLastResizeHandle; i++) {
     CALayer *shi = _selectionHandleIndicators[i];
@@ -588,9 +1314,11 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
       shi.hidden = YES;
     } else {
       shi.hidden = NO;
-      shi.position = [self centerOfSelectionHandle:i];
+      shi.position = CGPointApplyAffineTransform([self centerOfSelectionHandle:i], transform);
     }
   }
+  _rotationHandleIndicator.hidden = _mode == PTDSelectionToolModeMakeSelection;
+  _rotationHandleIndicator.position = CGPointApplyAffineTransform([self centerOfSelectionHandle:PTDSelectionToolRotateHandle], transform);
   
   [CATransaction commit];
 }
@@ -605,6 +1333,8 @@ typedef NS_OPTIONS(NSUInteger, PTDSelectionToolEditFlags) {
     [shi removeFromSuperlayer];
   }
   [_selectionHandleIndicators removeAllObjects];
+  [_rotationHandleIndicator removeFromSuperlayer];
+  _rotationHandleIndicator = nil;
   
   [_selectionIndicator removeFromSuperlayer];
   _selectionIndicator = nil;
@@ -0,0 +1,219 @@
+//
+// PTDShapeRaster.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <math.h>
+#include <float.h>
+#include "PTDShapeRaster.h"
+#include "PTDVector.h"
+
+
+/* Distances are evaluated in blocks of pixels, to skip the blocks which
+ * are entirely inside or outside the shape. */
+#define BLOCK_SIZE 8
+/* Iterations of the ellipse closest point search */
+#define ELLIPSE_ITERATIONS 3
+
+static const float _Sqrt1_2 = 0.70710678118654752440f;
+
+
+/* Signed distance from a box with rounded corners of radius r, which may be
+ * zero. The point is relative to the center of the box, in the first
+ * quadrant. */
+static inline PTDFloat4 PTDShapeRasterBoxDistance(PTDFloat4 x, PTDFloat4 y, float hw, float hh, float r)
+{
+  PTDFloat4 zero = PTDFloat4Splat(0.0f);
+  PTDFloat4 qx = PTDFloat4Sub(x, PTDFloat4Splat(hw - r));
+  PTDFloat4 qy = PTDFloat4Sub(y, PTDFloat4Splat(hh - r));
+  PTDFloat4 ox = PTDFloat4Max(qx, zero);
+  PTDFloat4 oy = PTDFloat4Max(qy, zero);
+  PTDFloat4 outside = PTDFloat4Sqrt(PTDFloat4Add(PTDFloat4Mul(ox, ox), PTDFloat4Mul(oy, oy)));
+  PTDFloat4 inside = PTDFloat4Min(PTDFloat4Max(qx, qy), zero);
+  return PTDFloat4Sub(PTDFloat4Add(outside, inside), PTDFloat4Splat(r));
+}
+
+
+/* Signed distance from an ellipse with semi-axes a and b. The closest point
+ * on the ellipse is found by repeatedly approximating the ellipse with the
+ * circle centered on the evolute, which converges in a few steps without
+ * trigonometry. */
+static inline PTDFloat4 PTDShapeRasterEllipseDistance(PTDFloat4 x, PTDFloat4 y, float a, float b)
+{
+  PTDFloat4 zero = PTDFloat4Splat(0.0f), one = PTDFloat4Splat(1.0f), tiny = PTDFloat4Splat(1e-6f);
+  PTDFloat4 va = PTDFloat4Splat(a), vb = PTDFloat4Splat(b);
+  PTDFloat4 tx = PTDFloat4Splat(_Sqrt1_2), ty = PTDFloat4Splat(_Sqrt1_2);
+  float k = a * a - b * b;
+  
+  for (int i = 0; i < ELLIPSE_ITERATIONS; i++) {
+    PTDFloat4 ex = PTDFloat4Mul(PTDFloat4Splat(k / a), PTDFloat4Mul(tx, PTDFloat4Mul(tx, tx)));
+    PTDFloat4 ey = PTDFloat4Mul(PTDFloat4Splat(-k / b), PTDFloat4Mul(ty, PTDFloat4Mul(ty, ty)));
+    PTDFloat4 rx = PTDFloat4Sub(PTDFloat4Mul(va, tx), ex), ry = PTDFloat4Sub(PTDFloat4Mul(vb, ty), ey);
+    PTDFloat4 qx = PTDFloat4Sub(x, ex), qy = PTDFloat4Sub(y, ey);
+    PTDFloat4 r = PTDFloat4Sqrt(PTDFloat4Add(PTDFloat4Mul(rx, rx), PTDFloat4Mul(ry, ry)));
+    PTDFloat4 q = PTDFloat4Max(PTDFloat4Sqrt(PTDFloat4Add(PTDFloat4Mul(qx, qx), PTDFloat4Mul(qy, qy))), tiny);
+    PTDFloat4 rq = PTDFloat4Div(r, q);
+    tx = PTDFloat4Clamp(PTDFloat4Div(PTDFloat4Add(PTDFloat4Mul(qx, rq), ex), va), zero, one);
+    ty = PTDFloat4Clamp(PTDFloat4Div(PTDFloat4Add(PTDFloat4Mul(qy, rq), ey), vb), zero, one);
+    PTDFloat4 t = PTDFloat4Max(PTDFloat4Sqrt(PTDFloat4Add(PTDFloat4Mul(tx, tx), PTDFloat4Mul(ty, ty))), tiny);
+    tx = PTDFloat4Div(tx, t);
+    ty = PTDFloat4Div(ty, t);
+  }
+  
+  PTDFloat4 dx = PTDFloat4Sub(x, PTDFloat4Mul(va, tx)), dy = PTDFloat4Sub(y, PTDFloat4Mul(vb, ty));
+  PTDFloat4 d = PTDFloat4Sqrt(PTDFloat4Add(PTDFloat4Mul(dx, dx), PTDFloat4Mul(dy, dy)));
+  /* negative inside the ellipse */
+  for (int i = 0; i < 4; i++) {
+    float px = PTDFloat4Lane(x, i) / a, py = PTDFloat4Lane(y, i) / b;
+    if (px * px + py * py < 1.0f)
+      d = PTDFloat4SetLane(d, i, -PTDFloat4Lane(d, i));
+  }
+  return d;
+}
+
+
+/* Signed distances from the outer and the inner edge of the stroke */
+static inline void PTDShapeRasterEdgeDistances(const PTDShapeRasterShape *s, PTDFloat4 x, PTDFloat4 y, PTDFloat4 *outer, PTDFloat4 *inner)
+{
+  PTDFloat4 hlw = PTDFloat4Splat(s->lineWidth / 2.0f);
+  PTDFloat4 d;
+  switch (s->kind) {
+    case PTDShapeRasterKindRectangle:
+      d = PTDShapeRasterBoxDistance(x, y, s->halfWidth, s->halfHeight, 0.0f);
+      /* mitered corners stay sharp on the outside */
+      *outer = PTDShapeRasterBoxDistance(x, y, s->halfWidth + s->lineWidth / 2.0f, s->halfHeight + s->lineWidth / 2.0f, 0.0f);
+      break;
+    case PTDShapeRasterKindRoundRect:
+      d = PTDShapeRasterBoxDistance(x, y, s->halfWidth, s->halfHeight, s->cornerRadius);
+      *outer = PTDFloat4Sub(d, hlw);
+      break;
+    default:
+      d = PTDShapeRasterEllipseDistance(x, y, s->halfWidth, s->halfHeight);
+      *outer = PTDFloat4Sub(d, hlw);
+      break;
+  }
+  *inner = PTDFloat4Add(d, hlw);
+}
+
+
+static inline void PTDShapeRasterCompositePixel(uint8_t *px, const uint8_t color[4], uint8_t coverage)
+{
+  unsigned sa = color[3] * coverage + 128;
+  sa = (sa + (sa >> 8)) >> 8;
+  for (int c = 0; c < 4; c++) {
+    unsigned s = color[c] * coverage + 128;
+    s = (s + (s >> 8)) >> 8;
+    unsigned d = px[c] * (255 - sa) + 128;
+    d = (d + (d >> 8)) >> 8;
+    px[c] = (uint8_t)(s + d);
+  }
+}
+
+
+void PTDShapeRasterDraw(const PTDPixelBuffer *canvas, const PTDShapeRasterShape *shape, const uint8_t color[4])
+{
+  PTDShapeRasterShape s = *shape;
+  s.halfWidth = fmaxf(s.halfWidth, 0.0f);
+  s.halfHeight = fmaxf(s.halfHeight, 0.0f);
+  s.lineWidth = fmaxf(s.lineWidth, 0.0f);
+  if (s.kind == PTDShapeRasterKindRoundRect)
+    s.cornerRadius = fminf(fmaxf(s.cornerRadius, 0.0f), fminf(s.halfWidth, s.halfHeight));
+  /* flat ellipses are indistinguishable from lines */
+  if (s.kind == PTDShapeRasterKindOval && fminf(s.halfWidth, s.halfHeight) < 0.5f)
+    s.kind = PTDShapeRasterKindRectangle;
+  if (color[3] == 0 || (s.lineWidth == 0.0f && !s.filled))
+    return;
+  
+  float hlw = s.lineWidth / 2.0f;
+  long x0 = (long)floorf(s.centerX - s.halfWidth - hlw - 1.0f);
+  long y0 = (long)floorf(s.centerY - s.halfHeight - hlw - 1.0f);
+  long x1 = (long)ceilf(s.centerX + s.halfWidth + hlw + 1.0f);
+  long y1 = (long)ceilf(s.centerY + s.halfHeight + hlw + 1.0f);
+  x0 = x0 < 0 ? 0 : x0;
+  y0 = y0 < 0 ? 0 : y0;
+  x1 = x1 > (long)canvas->width ? (long)canvas->width : x1;
+  y1 = y1 > (long)canvas->height ? (long)canvas->height : y1;
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  
+  /* Distances change at most as much as the points move, thus a block
+   * whose center is further from an edge than the half diagonal of the
+   * block is entirely on one side of it. The ellipse distance is not exact
+   * away from the outline, so leave some margin. */
+  float reach = BLOCK_SIZE * _Sqrt1_2 + 2.0f;
+  static const float laneOffsets[4] = {0.5f, 1.5f, 2.5f, 3.5f};
+  PTDFloat4 lane = PTDFloat4Load(laneOffsets);
+  PTDFloat4 zero = PTDFloat4Splat(0.0f), one = PTDFloat4Splat(1.0f);
+  uint8_t coverage[BLOCK_SIZE];
+  
+  for (long by = y0; by < y1; by += BLOCK_SIZE) {
+    long by1 = by + BLOCK_SIZE < y1 ? by + BLOCK_SIZE : y1;
+    
+    for (long bx = x0; bx < x1; bx += BLOCK_SIZE) {
+      long bx1 = bx + BLOCK_SIZE < x1 ? bx + BLOCK_SIZE : x1;
+      
+      PTDFloat4 cx = PTDFloat4Splat(fabsf((float)(bx + bx1) / 2.0f - s.centerX));
+      PTDFloat4 cy = PTDFloat4Splat(fabsf((float)(by + by1) / 2.0f - s.centerY));
+      PTDFloat4 cOuter, cInner;
+      PTDShapeRasterEdgeDistances(&s, cx, cy, &cOuter, &cInner);
+      if (PTDFloat4Lane(cOuter, 0) > reach)
+        continue;
+      if (!s.filled && PTDFloat4Lane(cInner, 0) < -reach)
+        continue;
+      
+      if (s.filled && PTDFloat4Lane(cOuter, 0) < -reach) {
+        for (long y = by; y < by1; y++) {
+          uint8_t *px = canvas->data + (size_t)y * canvas->bytesPerRow;
+          for (long x = bx; x < bx1; x++)
+            PTDShapeRasterCompositePixel(px + x * 4, color, 255);
+        }
+        continue;
+      }
+      
+      for (long y = by; y < by1; y++) {
+        PTDFloat4 fy = PTDFloat4Splat(fabsf((float)y + 0.5f - s.centerY));
+        for (long x = bx; x < bx1; x += 4) {
+          PTDFloat4 fx = PTDFloat4Abs(PTDFloat4Add(lane, PTDFloat4Splat((float)x - s.centerX)));
+          PTDFloat4 outer, inner;
+          PTDShapeRasterEdgeDistances(&s, fx, fy, &outer, &inner);
+          /* area of the pixel inside the outer edge, minus the area inside
+           * the inner edge */
+          PTDFloat4 half = PTDFloat4Splat(0.5f);
+          PTDFloat4 a = PTDFloat4Clamp(PTDFloat4Sub(half, outer), zero, one);
+          if (!s.filled)
+            a = PTDFloat4Sub(a, PTDFloat4Clamp(PTDFloat4Sub(half, inner), zero, one));
+          a = PTDFloat4Clamp(a, zero, one);
+          for (int i = 0; i < 4; i++)
+            coverage[x - bx + i] = (uint8_t)(PTDFloat4Lane(a, i) * 255.0f + 0.5f);
+        }
+        
+        uint8_t *px = canvas->data + (size_t)y * canvas->bytesPerRow;
+        for (long x = bx; x < bx1; x++) {
+          if (coverage[x - bx] != 0)
+            PTDShapeRasterCompositePixel(px + x * 4, color, coverage[x - bx]);
+        }
+      }
+    }
+  }
+}
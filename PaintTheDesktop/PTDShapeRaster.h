@@ -0,0 +1,65 @@
+//
+// PTDShapeRaster.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef PTDShapeRaster_h
+#define PTDShapeRaster_h
+
+#include "PTDResampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  PTDShapeRasterKindRectangle,
+  PTDShapeRasterKindRoundRect,
+  PTDShapeRasterKindOval
+} PTDShapeRasterKind;
+
+/* A shape centered on a pixel position, with the first row on top and
+ * pixel centers at half-integer coordinates. Strokes are centered on the
+ * outline like in AppKit, with mitered corners for rectangles. */
+typedef struct {
+  PTDShapeRasterKind kind;
+  float centerX, centerY;
+  float halfWidth, halfHeight;
+  float cornerRadius;
+  float lineWidth;
+  /* filled shapes cover the inside of the stroke as well */
+  int filled;
+} PTDShapeRasterShape;
+
+/* Composites the antialiased shape with the given premultiplied color over
+ * the canvas. Coverage is computed from the signed distance to the outline,
+ * and only for the pixels near it; the pixels far inside a filled shape
+ * are covered without evaluating the distance. */
+void PTDShapeRasterDraw(const PTDPixelBuffer *canvas, const PTDShapeRasterShape *shape, const uint8_t color[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDShapeRaster_h */
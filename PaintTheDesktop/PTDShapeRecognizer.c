@@ -0,0 +1,569 @@
+//
+// PTDShapeRecognizer.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "PTDShapeRecognizer.h"
+
+
+/* M_PI is not part of standard C */
+#define PI 3.14159265358979323846
+#define HALF_PI (PI / 2.0)
+
+/* Distance between the points of the resampled stroke */
+static const double _ResampleSpacing = 4.0;
+/* Corners are found by comparing the direction of the stroke this many
+ * resampled points before and after each point */
+#define CORNER_WINDOW 3
+#define MAX_CORNERS 8
+static const double _CornerMinAngle = 55.0 * PI / 180.0;
+
+static const double _MinStrokeLength = 24.0;
+/* Strokes whose ends are closer than this fraction of their length are
+ * closed */
+static const double _ClosedEndsRatio = 0.15;
+/* Maximum distance of the stroke from a straight side, relative to the
+ * length of the side, or absolute */
+static const double _StraightRelativeError = 0.06;
+static const double _StraightMinError = 4.0;
+/* Maximum RMS distance of the stroke from an ellipse, relative to its
+ * size */
+static const double _EllipseRelativeError = 0.06;
+/* Ellipses whose radii are closer than this ratio become circles */
+static const double _CircleRadiusRatio = 0.85;
+static const double _AxisAlignedAngle = 12.0 * PI / 180.0;
+static const double _RightAngleTolerance = 15.0 * PI / 180.0;
+
+
+typedef struct {
+  size_t index;
+  double angle;
+} PTDShapeRecognizerCorner;
+
+struct PTDShapeRecognizer {
+  /* all coordinates are relative to the first point, which keeps the sums
+   * well conditioned */
+  double originX, originY;
+  size_t rawCount;
+  double lastX, lastY;
+  double length;
+  /* sums of the products of (x^2, xy, y^2, x, y, 1) over all points */
+  double scatter[6][6];
+  
+  /* x,y pairs at constant distance along the stroke */
+  double *points;
+  size_t count;
+  size_t capacity;
+  double sinceResample;
+  
+  PTDShapeRecognizerCorner corners[MAX_CORNERS];
+  size_t cornerCount;
+  PTDShapeRecognizerCorner candidate;
+  int hasCandidate;
+  
+  int failed;
+  double vertices[2 * (MAX_CORNERS + 2)];
+};
+
+
+PTDShapeRecognizer *PTDShapeRecognizerCreate(void)
+{
+  return calloc(1, sizeof(PTDShapeRecognizer));
+}
+
+
+void PTDShapeRecognizerDestroy(PTDShapeRecognizer *recognizer)
+{
+  if (!recognizer)
+    return;
+  free(recognizer->points);
+  free(recognizer);
+}
+
+
+void PTDShapeRecognizerReset(PTDShapeRecognizer *r)
+{
+  double *points = r->points;
+  size_t capacity = r->capacity;
+  memset(r, 0, sizeof(PTDShapeRecognizer));
+  r->points = points;
+  r->capacity = capacity;
+}
+
+
+static double PTDShapeRecognizerTurningAngle(double ux, double uy, double vx, double vy)
+{
+  double lu = hypot(ux, uy), lv = hypot(vx, vy);
+  if (lu == 0.0 || lv == 0.0)
+    return 0.0;
+  double c = (ux * vx + uy * vy) / (lu * lv);
+  return acos(c < -1.0 ? -1.0 : (c > 1.0 ? 1.0 : c));
+}
+
+
+static double PTDShapeRecognizerAngleAtPoint(const double *p, size_t prev, size_t i, size_t next)
+{
+  return PTDShapeRecognizerTurningAngle(
+      p[2*i] - p[2*prev], p[2*i+1] - p[2*prev+1],
+      p[2*next] - p[2*i], p[2*next+1] - p[2*i+1]);
+}
+
+
+static void PTDShapeRecognizerCommitCorner(PTDShapeRecognizer *r, PTDShapeRecognizerCorner corner)
+{
+  if (r->cornerCount < MAX_CORNERS)
+    r->corners[r->cornerCount] = corner;
+  r->cornerCount++;
+}
+
+
+/* Keeps only the sharpest of the corners closer than the window */
+static void PTDShapeRecognizerConsiderCorner(PTDShapeRecognizer *r, size_t index, double angle)
+{
+  if (angle < _CornerMinAngle)
+    return;
+  if (r->hasCandidate) {
+    if (index - r->candidate.index <= CORNER_WINDOW) {
+      if (angle > r->candidate.angle)
+        r->candidate = (PTDShapeRecognizerCorner){index, angle};
+      return;
+    }
+    PTDShapeRecognizerCommitCorner(r, r->candidate);
+  }
+  r->candidate = (PTDShapeRecognizerCorner){index, angle};
+  r->hasCandidate = 1;
+}
+
+
+static int PTDShapeRecognizerAppendResampled(PTDShapeRecognizer *r, double x, double y)
+{
+  if (r->count == r->capacity) {
+    size_t capacity = r->capacity ? r->capacity * 2 : 256;
+    double *points = realloc(r->points, capacity * 2 * sizeof(double));
+    if (!points)
+      return 0;
+    r->points = points;
+    r->capacity = capacity;
+  }
+  r->points[2 * r->count] = x;
+  r->points[2 * r->count + 1] = y;
+  r->count++;
+  
+  if (r->count > 2 * CORNER_WINDOW) {
+    size_t i = r->count - 1 - CORNER_WINDOW;
+    double angle = PTDShapeRecognizerAngleAtPoint(r->points, i - CORNER_WINDOW, i, i + CORNER_WINDOW);
+    PTDShapeRecognizerConsiderCorner(r, i, angle);
+  }
+  return 1;
+}
+
+
+int PTDShapeRecognizerAddPoint(PTDShapeRecognizer *r, double x, double y)
+{
+  if (r->failed)
+    return 0;
+  if (r->rawCount == 0) {
+    r->originX = x;
+    r->originY = y;
+  }
+  x -= r->originX;
+  y -= r->originY;
+  
+  double z[6] = {x * x, x * y, y * y, x, y, 1.0};
+  for (int i = 0; i < 6; i++) {
+    for (int j = i; j < 6; j++)
+      r->scatter[i][j] += z[i] * z[j];
+  }
+  
+  if (r->rawCount++ == 0) {
+    r->lastX = x;
+    r->lastY = y;
+    if (!PTDShapeRecognizerAppendResampled(r, x, y))
+      r->failed = 1;
+    return !r->failed;
+  }
+  
+  double px = r->lastX, py = r->lastY;
+  double d = hypot(x - px, y - py);
+  r->length += d;
+  while (r->sinceResample + d >= _ResampleSpacing) {
+    double t = (_ResampleSpacing - r->sinceResample) / d;
+    px += t * (x - px);
+    py += t * (y - py);
+    if (!PTDShapeRecognizerAppendResampled(r, px, py)) {
+      r->failed = 1;
+      return 0;
+    }
+    d = hypot(x - px, y - py);
+    r->sinceResample = 0.0;
+  }
+  r->sinceResample += d;
+  r->lastX = x;
+  r->lastY = y;
+  return 1;
+}
+
+
+/* Largest distance from the segment a-b of the resampled points from the
+ * first to the last index, included */
+static double PTDShapeRecognizerMaxDeviation(const double *p, size_t first, size_t last, double ax, double ay, double bx, double by)
+{
+  double dx = bx - ax, dy = by - ay;
+  double len2 = dx * dx + dy * dy;
+  double res = 0.0;
+  for (size_t i = first; i <= last; i++) {
+    double vx = p[2*i] - ax, vy = p[2*i+1] - ay;
+    double t = len2 > 0.0 ? (vx * dx + vy * dy) / len2 : 0.0;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    double dist = hypot(vx - t * dx, vy - t * dy);
+    if (dist > res)
+      res = dist;
+  }
+  return res;
+}
+
+
+static int PTDShapeRecognizerIsStraight(double deviation, double ax, double ay, double bx, double by)
+{
+  double limit = hypot(bx - ax, by - ay) * _StraightRelativeError;
+  return deviation <= (limit > _StraightMinError ? limit : _StraightMinError);
+}
+
+
+/* Least squares fit of a line through all the points, with the ends of the
+ * stroke projected on it */
+static void PTDShapeRecognizerFitLine(const PTDShapeRecognizer *r, double *vertices)
+{
+  double n = r->scatter[5][5];
+  double mx = r->scatter[3][5] / n, my = r->scatter[4][5] / n;
+  double cxx = r->scatter[3][3] / n - mx * mx;
+  double cxy = r->scatter[3][4] / n - mx * my;
+  double cyy = r->scatter[4][4] / n - my * my;
+  double angle = 0.5 * atan2(2.0 * cxy, cxx - cyy);
+  double ux = cos(angle), uy = sin(angle);
+  
+  double ends[4] = {r->points[0], r->points[1], r->lastX, r->lastY};
+  for (int i = 0; i < 2; i++) {
+    double t = (ends[2*i] - mx) * ux + (ends[2*i+1] - my) * uy;
+    vertices[2*i] = mx + t * ux;
+    vertices[2*i+1] = my + t * uy;
+  }
+}
+
+
+/* Least squares fit of a conic Ax^2 + Bxy + Cy^2 + Dx + Ey + F = 0 with the
+ * constraint A + C = 1, which excludes no ellipse and does not depend on
+ * the position of the origin. */
+static int PTDShapeRecognizerFitEllipse(const PTDShapeRecognizer *r, PTDRecognizedShape *shape)
+{
+  double s[6][6];
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++)
+      s[i][j] = i <= j ? r->scatter[i][j] : r->scatter[j][i];
+  }
+  
+  /* the residual is g . (A, B, D, E, F) + y^2 where g = M z */
+  static const double m[5][6] = {
+    {1, 0, -1, 0, 0, 0},
+    {0, 1, 0, 0, 0, 0},
+    {0, 0, 0, 1, 0, 0},
+    {0, 0, 0, 0, 1, 0},
+    {0, 0, 0, 0, 0, 1}
+  };
+  double ms[5][6];
+  for (int i = 0; i < 5; i++) {
+    for (int j = 0; j < 6; j++) {
+      ms[i][j] = 0.0;
+      for (int k = 0; k < 6; k++)
+        ms[i][j] += m[i][k] * s[k][j];
+    }
+  }
+  /* normal equations, augmented with the right hand side */
+  double a[5][6];
+  for (int i = 0; i < 5; i++) {
+    for (int j = 0; j < 5; j++) {
+      a[i][j] = 0.0;
+      for (int k = 0; k < 6; k++)
+        a[i][j] += ms[i][k] * m[j][k];
+    }
+    a[i][5] = -ms[i][2];
+  }
+  
+  double scale = 0.0;
+  for (int i = 0; i < 5; i++)
+    scale = fmax(scale, fabs(a[i][i]));
+  for (int col = 0; col < 5; col++) {
+    int pivot = col;
+    for (int i = col + 1; i < 5; i++) {
+      if (fabs(a[i][col]) > fabs(a[pivot][col]))
+        pivot = i;
+    }
+    if (fabs(a[pivot][col]) <= 1e-12 * scale)
+      return 0;
+    if (pivot != col) {
+      for (int j = 0; j < 6; j++) {
+        double t = a[col][j];
+        a[col][j] = a[pivot][j];
+        a[pivot][j] = t;
+      }
+    }
+    for (int i = 0; i < 5; i++) {
+      if (i == col)
+        continue;
+      double f = a[i][col] / a[col][col];
+      for (int j = col; j < 6; j++)
+        a[i][j] -= f * a[col][j];
+    }
+  }
+  double A = a[0][5] / a[0][0], B = a[1][5] / a[1][1];
+  double D = a[2][5] / a[2][2], E = a[3][5] / a[3][3], F = a[4][5] / a[4][4];
+  double C = 1.0 - A;
+  
+  double det = 4.0 * A * C - B * B;
+  if (det <= 0.0)
+    return 0;
+  double cx = (B * E - 2.0 * C * D) / det;
+  double cy = (B * D - 2.0 * A * E) / det;
+  double f0 = F + (D * cx + E * cy) / 2.0;
+  if (f0 >= 0.0)
+    return 0;
+  
+  /* the eigenvalues of the quadratic part are both positive, because its
+   * trace is 1 and its determinant is positive */
+  double diff = hypot((A - C) / 2.0, B / 2.0);
+  double r1 = sqrt(-f0 / (0.5 + diff));
+  double r2 = sqrt(-f0 / (0.5 - diff));
+  
+  /* On the normalized ellipse, where the conic is 1 on the outline, the
+   * conic changes by about twice the relative distance from the outline */
+  double w[6] = {A, B, C, D, E, F};
+  double rss = 0.0;
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++)
+      rss += w[i] * s[i][j] * w[j];
+  }
+  double n = r->scatter[5][5];
+  double error = sqrt(fmax(rss, 0.0) / n) / -f0 / 2.0;
+  if (error > _EllipseRelativeError)
+    return 0;
+  
+  shape->kind = PTDRecognizedShapeKindEllipse;
+  shape->centerX = cx + r->originX;
+  shape->centerY = cy + r->originY;
+  shape->radiusX = r1;
+  shape->radiusY = r2;
+  shape->rotation = 0.5 * atan2(B, A - C);
+  
+  if (fmin(r1, r2) / fmax(r1, r2) > _CircleRadiusRatio) {
+    shape->radiusX = shape->radiusY = (r1 + r2) / 2.0;
+    shape->rotation = 0.0;
+  } else if (fabs(shape->rotation) < _AxisAlignedAngle) {
+    shape->rotation = 0.0;
+  } else if (fabs(fabs(shape->rotation) - HALF_PI) < _AxisAlignedAngle) {
+    shape->rotation = 0.0;
+    shape->radiusX = r2;
+    shape->radiusY = r1;
+  }
+  return 1;
+}
+
+
+/* Turns polygons with four right angles and sides close to the axes into
+ * axis-aligned rectangles */
+static int PTDShapeRecognizerSnapRectangle(double *v, PTDRecognizedShape *shape)
+{
+  for (int i = 0; i < 4; i++) {
+    const double *a = v + 2 * ((i + 3) % 4), *b = v + 2 * i, *c = v + 2 * ((i + 1) % 4);
+    double turn = PTDShapeRecognizerTurningAngle(b[0] - a[0], b[1] - a[1], c[0] - b[0], c[1] - b[1]);
+    if (fabs(turn - HALF_PI) > _RightAngleTolerance)
+      return 0;
+    double side = fmod(fabs(atan2(c[1] - b[1], c[0] - b[0])), HALF_PI);
+    if (side > _AxisAlignedAngle && HALF_PI - side > _AxisAlignedAngle)
+      return 0;
+  }
+  
+  /* average the two smallest and the two largest coordinates */
+  double bounds[4];
+  for (int axis = 0; axis < 2; axis++) {
+    double c[4] = {v[axis], v[2+axis], v[4+axis], v[6+axis]};
+    for (int i = 1; i < 4; i++) {
+      for (int j = i; j > 0 && c[j-1] > c[j]; j--) {
+        double t = c[j];
+        c[j] = c[j-1];
+        c[j-1] = t;
+      }
+    }
+    bounds[axis] = (c[0] + c[1]) / 2.0;
+    bounds[2+axis] = (c[2] + c[3]) / 2.0;
+  }
+  double rect[8] = {
+    bounds[0], bounds[1], bounds[2], bounds[1],
+    bounds[2], bounds[3], bounds[0], bounds[3]
+  };
+  memcpy(v, rect, sizeof(rect));
+  shape->kind = PTDRecognizedShapeKindRectangle;
+  return 1;
+}
+
+
+static int PTDShapeRecognizerRecognizeOpen(PTDShapeRecognizer *r, const PTDShapeRecognizerCorner *corners, size_t cornerCount, PTDRecognizedShape *shape)
+{
+  const double *p = r->points;
+  size_t last = r->count - 1;
+  
+  double deviation = PTDShapeRecognizerMaxDeviation(p, 0, last, p[0], p[1], r->lastX, r->lastY);
+  if (PTDShapeRecognizerIsStraight(deviation, p[0], p[1], r->lastX, r->lastY)) {
+    PTDShapeRecognizerFitLine(r, r->vertices);
+    shape->kind = PTDRecognizedShapeKindLine;
+    shape->vertexCount = 2;
+    return 1;
+  }
+  
+  if (cornerCount == 0 || cornerCount > MAX_CORNERS)
+    return 0;
+  double *v = r->vertices;
+  v[0] = p[0];
+  v[1] = p[1];
+  size_t prev = 0;
+  for (size_t i = 0; i <= cornerCount; i++) {
+    size_t index = i < cornerCount ? corners[i].index : last;
+    double x = i < cornerCount ? p[2*index] : r->lastX;
+    double y = i < cornerCount ? p[2*index+1] : r->lastY;
+    deviation = PTDShapeRecognizerMaxDeviation(p, prev, index, v[2*i], v[2*i+1], x, y);
+    if (!PTDShapeRecognizerIsStraight(deviation, v[2*i], v[2*i+1], x, y))
+      return 0;
+    v[2*i+2] = x;
+    v[2*i+3] = y;
+    prev = index;
+  }
+  shape->kind = PTDRecognizedShapeKindPolyline;
+  shape->vertexCount = cornerCount + 2;
+  return 1;
+}
+
+
+static int PTDShapeRecognizerRecognizeClosed(PTDShapeRecognizer *r, PTDShapeRecognizerCorner *corners, size_t cornerCount, PTDRecognizedShape *shape)
+{
+  const double *p = r->points;
+  size_t last = r->count - 1;
+  
+  if (cornerCount <= MAX_CORNERS && r->count > 2 * CORNER_WINDOW + 1) {
+    /* the corner where the stroke starts and ends is only visible by
+     * comparing the direction of the stroke at both ends */
+    const double *a = p + 2 * (last - CORNER_WINDOW), *b = p + 2 * last, *c = p + 2 * CORNER_WINDOW;
+    double angle = PTDShapeRecognizerTurningAngle(b[0] - a[0], b[1] - a[1], c[0] - p[0], c[1] - p[1]);
+    if (angle >= _CornerMinAngle) {
+      memmove(corners + 1, corners, cornerCount * sizeof(PTDShapeRecognizerCorner));
+      corners[0] = (PTDShapeRecognizerCorner){0, angle};
+      cornerCount++;
+    }
+    /* corners found again when the stroke overshoots its start */
+    double mergeDistance = 2.0 * CORNER_WINDOW * _ResampleSpacing;
+    size_t kept = 0;
+    for (size_t i = 0; i < cornerCount; i++) {
+      int duplicate = 0;
+      for (size_t j = 0; j < kept; j++) {
+        const double *a = p + 2 * corners[i].index, *b = p + 2 * corners[j].index;
+        if (hypot(a[0] - b[0], a[1] - b[1]) < mergeDistance)
+          duplicate = 1;
+      }
+      if (!duplicate)
+        corners[kept++] = corners[i];
+    }
+    cornerCount = kept;
+  }
+  
+  if (cornerCount >= 3 && cornerCount <= MAX_CORNERS) {
+    double *v = r->vertices;
+    int straight = 1;
+    for (size_t i = 0; i < cornerCount && straight; i++) {
+      size_t from = corners[i].index;
+      size_t to = corners[(i + 1) % cornerCount].index;
+      const double *a = p + 2 * from, *b = p + 2 * to;
+      double deviation;
+      if (to > from) {
+        deviation = PTDShapeRecognizerMaxDeviation(p, from, to, a[0], a[1], b[0], b[1]);
+      } else {
+        /* the side across the ends of the stroke */
+        deviation = fmax(
+            PTDShapeRecognizerMaxDeviation(p, from, last, a[0], a[1], b[0], b[1]),
+            PTDShapeRecognizerMaxDeviation(p, 0, to, a[0], a[1], b[0], b[1]));
+      }
+      straight = PTDShapeRecognizerIsStraight(deviation, a[0], a[1], b[0], b[1]);
+      v[2*i] = a[0];
+      v[2*i+1] = a[1];
+    }
+    if (straight) {
+      shape->kind = PTDRecognizedShapeKindPolygon;
+      shape->vertexCount = cornerCount;
+      if (cornerCount == 4)
+        PTDShapeRecognizerSnapRectangle(v, shape);
+      return 1;
+    }
+  }
+  
+  return PTDShapeRecognizerFitEllipse(r, shape);
+}
+
+
+int PTDShapeRecognizerRecognize(PTDShapeRecognizer *r, PTDRecognizedShape *shape)
+{
+  memset(shape, 0, sizeof(PTDRecognizedShape));
+  if (r->failed || r->count < 2 * CORNER_WINDOW + 1 || r->length < _MinStrokeLength)
+    return 0;
+  
+  /* the stroke may continue after recognition, so work on a copy of the
+   * corners */
+  PTDShapeRecognizerCorner corners[MAX_CORNERS + 2];
+  size_t cornerCount = r->cornerCount;
+  memcpy(corners, r->corners, (cornerCount < MAX_CORNERS ? cornerCount : MAX_CORNERS) * sizeof(PTDShapeRecognizerCorner));
+  if (r->hasCandidate) {
+    if (cornerCount < MAX_CORNERS)
+      corners[cornerCount] = r->candidate;
+    cornerCount++;
+  }
+  
+  const double *p = r->points;
+  int res;
+  if (hypot(r->lastX - p[0], r->lastY - p[1]) < r->length * _ClosedEndsRatio)
+    res = PTDShapeRecognizerRecognizeClosed(r, corners, cornerCount, shape);
+  else
+    res = PTDShapeRecognizerRecognizeOpen(r, corners, cornerCount, shape);
+  if (!res) {
+    shape->kind = PTDRecognizedShapeKindNone;
+    return 0;
+  }
+  
+  if (shape->kind != PTDRecognizedShapeKindEllipse) {
+    for (size_t i = 0; i < shape->vertexCount; i++) {
+      r->vertices[2*i] += r->originX;
+      r->vertices[2*i+1] += r->originY;
+    }
+    shape->vertices = r->vertices;
+  }
+  return 1;
+}
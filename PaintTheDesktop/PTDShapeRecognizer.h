@@ -0,0 +1,82 @@
+//
+// PTDShapeRecognizer.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef PTDShapeRecognizer_h
+#define PTDShapeRecognizer_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  PTDRecognizedShapeKindNone,
+  PTDRecognizedShapeKindLine,
+  PTDRecognizedShapeKindPolyline,
+  PTDRecognizedShapeKindPolygon,
+  /* an axis-aligned rectangle, with its corners as vertices */
+  PTDRecognizedShapeKindRectangle,
+  PTDRecognizedShapeKindEllipse
+} PTDRecognizedShapeKind;
+
+typedef struct {
+  PTDRecognizedShapeKind kind;
+  /* count x,y pairs, for all kinds except ellipses */
+  const double *vertices;
+  size_t vertexCount;
+  /* rotation in radians of the radiusX axis, counterclockwise when y grows
+   * upwards */
+  double centerX, centerY;
+  double radiusX, radiusY;
+  double rotation;
+} PTDRecognizedShape;
+
+/* Recognizes lines, polylines, polygons and ellipses in a freehand stroke.
+ * Points are consumed as they are added: the least squares fits only
+ * accumulate sums, and corners are detected on a resampled copy of the
+ * stroke, thus recognition at the end of the stroke takes time linear in
+ * the number of resampled points. Distances are in points. */
+typedef struct PTDShapeRecognizer PTDShapeRecognizer;
+
+PTDShapeRecognizer *PTDShapeRecognizerCreate(void);
+void PTDShapeRecognizerDestroy(PTDShapeRecognizer *recognizer);
+
+/* Forgets the current stroke */
+void PTDShapeRecognizerReset(PTDShapeRecognizer *recognizer);
+
+/* Returns 0 on failure, after which the stroke is not recognized anymore */
+int PTDShapeRecognizerAddPoint(PTDShapeRecognizer *recognizer, double x, double y);
+
+/* Returns 0 when the stroke does not match any shape confidently enough.
+ * The vertices are valid until the recognizer is modified. */
+int PTDShapeRecognizerRecognize(PTDShapeRecognizer *recognizer, PTDRecognizedShape *shape);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDShapeRecognizer_h */
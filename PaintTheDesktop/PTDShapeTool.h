@@ -27,10 +27,19 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class PTDShapeCanvasObject;
+
+extern NSString * const PTDShapeToolOptionFilled;
+
 @interface PTDShapeTool : PTDBrushTool
 
+@property (nonatomic, readonly, getter=isFilled) BOOL filled;
+
 - (NSBezierPath *)shapeBezierPathInRect:(NSRect)rect;
 
+/* The default implementation draws the path of the shape. */
+- (PTDShapeCanvasObject *)shapeCanvasObjectInRect:(NSRect)rect;
+
 @end
 
 NS_ASSUME_NONNULL_END
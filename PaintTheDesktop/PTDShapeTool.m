@@ -33,11 +33,23 @@
 #import "NSBezierPath+PTD.h"
 #import "PTDGraphics.h"
 #import "PTDUtils.h"
+#import "PTDCanvasObject.h"
+#import "PTDToolOptions.h"
+
+
+NSString * const PTDShapeToolOptionFilled = @"filled";
 
 
 #define SIGN(x) ((x) < 0.0 ? -1.0 : 1.0)
 
 
+@interface PTDShapeTool ()
+
+@property (nonatomic, getter=isFilled) BOOL filled;
+
+@end
+
+
 @implementation PTDShapeTool {
   NSRect _currentRect;
   NSPoint _point0, _point1;
@@ -45,6 +57,14 @@
 }
 
 
++ (void)registerDefaults
+{
+  [super registerDefaults];
+  PTDToolOptions *o = PTDToolOptions.sharedOptions;
+  [o registerOption:PTDShapeToolOptionFilled ofToolClass:self types:@[[NSNumber class]] defaultValue:@(NO) validationBlock:nil];
+}
+
+
 - (void)activate
 {
   [self updateCursor];
@@ -57,6 +77,14 @@
 }
 
 
+- (PTDShapeCanvasObject *)shapeCanvasObjectInRect:(NSRect)rect
+{
+  NSBezierPath *path = [self shapeBezierPathInRect:rect];
+  [path setLineWidth:self.size];
+  return [[PTDShapeCanvasObject alloc] initWithPath:path color:self.color filled:self.filled];
+}
+
+
 - (void)dragDidStartAtPoint:(NSPoint)point
 {
   _point0 = point;
@@ -108,29 +136,59 @@
 {
   [self removeDragIndicator];
   
-  [self.currentDrawingSurface beginCanvasDrawing];
-  [NSGraphicsContext.currentContext setShouldAntialias:YES];
-  
-  NSBezierPath *path = [self shapeBezierPathInRect:_currentRect];
-  [path setLineWidth:self.size];
-  [self.color setStroke];
-  [path stroke];
+  PTDShapeCanvasObject *object = [self shapeCanvasObjectInRect:_currentRect];
+  [self.currentDrawingSurface addCanvasObject:object];
+}
+
+
+- (void)mouseClickedAtPoint:(NSPoint)point
+{
+  /* clicking a shape which was not flattened yet restyles it */
+  PTDCanvasObject *object = [self.currentDrawingSurface canvasObjectAtPoint:point];
+  if (![object isKindOfClass:PTDShapeCanvasObject.class])
+    return;
+  PTDShapeCanvasObject *newObject = [(PTDShapeCanvasObject *)object objectByChangingLineWidth:self.size color:self.color];
+  [self.currentDrawingSurface replaceCanvasObject:object withObject:newObject];
 }
 
 
 - (void)reloadOptions
 {
   [super reloadOptions];
+  self.filled = [PTDToolOptions.sharedOptions boolForOption:PTDShapeToolOptionFilled ofToolClass:self.class];
   [self updateCursor];
 }
 
 
+- (nullable PTDRingMenuRing *)optionMenu
+{
+  PTDRingMenuRing *res = [super optionMenu];
+  
+  PTDRingMenuItem *itm = [res addItemWithText:NSLocalizedString(@"Fill", @"Menu item for toggling filled shapes") target:self action:@selector(toggleFilled:)];
+  if (self.filled)
+    itm.state = NSControlStateValueOn;
+  [res addSpringWithElasticity:1000];
+  
+  return res;
+}
+
+
+- (void)toggleFilled:(id)sender
+{
+  [PTDToolOptions.sharedOptions setObject:@(!self.filled) forOption:PTDShapeToolOptionFilled ofToolClass:self.class];
+}
+
+
 - (void)updateCursor
 {
-  PTDCursor *cursor = [[PTDCursor alloc] init];
-  cursor.image = PTDCrosshairImage(self.size, self.color);
-  cursor.hotspot = NSMakePoint(cursor.image.size.width/2.0, cursor.image.size.height/2.0);
-  self.cursor = cursor;
+  CGFloat size = self.size;
+  NSColor *color = self.color;
+  self.cursor = [PTDCursor cachedCursorWithKey:@[@"crosshair", @(size), color] generator:^PTDCursor *{
+    PTDCursor *cursor = [[PTDCursor alloc] init];
+    cursor.image = PTDCrosshairImage(size, color);
+    cursor.hotspot = NSMakePoint(cursor.image.size.width/2.0, cursor.image.size.height/2.0);
+    return cursor;
+  }];
 }
 
 
@@ -140,7 +198,7 @@
   [self.currentDrawingSurface.overlayLayer addSublayer:_overlayShape];
   _overlayShape.lineWidth = self.size;
   _overlayShape.strokeColor = self.color.CGColor;
-  _overlayShape.fillColor = NSColor.clearColor.CGColor;
+  _overlayShape.fillColor = self.filled ? self.color.CGColor : NSColor.clearColor.CGColor;
   _overlayShape.frame = self.currentDrawingSurface.overlayLayer.bounds;
   [self updateDragIndicator];
 }
@@ -24,6 +24,10 @@
 //
 
 #import "PTDSimpleAbstractPaintWindowController.h"
+#import "NSBitmapImageRep+PTD.h"
+#import "PTDImageImport.h"
+#import "PTDCanvasSnapshot.h"
+#import "PTDBlockTask.h"
 
 
 @implementation PTDSimpleAbstractPaintWindowController
@@ -37,21 +41,36 @@
 
 - (NSImage *)thumbnail
 {
-  NSBitmapImageRep *rep = self.snapshot;
-  NSImage *image = [[NSImage alloc] initWithSize:rep.size];
-  [image addRepresentation:rep];
-  return image;
+  return self.paintViewController.view.thumbnail;
+}
+
+
+- (size_t)memoryUsage
+{
+  return self.paintViewController.view.canvasMemoryUsage;
+}
+
+
+- (BOOL)isCompressed
+{
+  return self.paintViewController.view.canvasCompressed;
 }
 
 
 - (void)restoreFromSnapshot:(NSBitmapImageRep *)bitmap
 {
   @autoreleasepool {
+    PTDPaintView *view = self.paintViewController.view;
+    NSInteger width = round(view.paintRect.size.width * view.backingScaleFactor.width);
+    NSInteger height = round(view.paintRect.size.height * view.backingScaleFactor.height);
+    if (width != bitmap.pixelsWide || height != bitmap.pixelsHigh)
+      bitmap = [bitmap ptd_imageRepByResamplingToPixelsWide:width pixelsHigh:height];
+    
     [NSGraphicsContext saveGraphicsState];
-    NSGraphicsContext.currentContext = self.paintViewController.view.graphicsContext;
-    [bitmap drawInRect:self.paintViewController.view.paintRect];
+    NSGraphicsContext.currentContext = view.graphicsContext;
+    [bitmap drawInRect:view.paintRect];
     [NSGraphicsContext restoreGraphicsState];
-    [self.paintViewController.view setNeedsDisplay:YES];
+    [view canvasDidChangeInRect:view.paintRect];
   }
 }
 
@@ -64,11 +83,19 @@
   if (resp == NSModalResponseCancel)
     return;
   
-  NSBitmapImageRep *snapshot = [self snapshot];
   NSURL *file = savePanel.URL;
-  NSData *dataToSave;
-  dataToSave = [snapshot representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
-  [dataToSave writeToURL:file atomically:NO];
+  PTDCanvasSnapshot *published = self.paintViewController.view.publishedSnapshot;
+  if (!published) {
+    NSData *dataToSave = [[self snapshot] representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
+    [dataToSave writeToURL:file atomically:NO];
+    return;
+  }
+  
+  /* the canvas can be drawn on while the frame is encoded */
+  PTDBlockTaskSubmit(PTDTaskPriorityEncode, ^{
+    NSData *dataToSave = [published.bitmapImageRep representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
+    [dataToSave writeToURL:file atomically:NO];
+  });
 }
 
 
@@ -85,9 +112,27 @@
   if (resp == NSModalResponseCancel)
     return;
     
-  NSData *imageData = [NSData dataWithContentsOfURL:openPanel.URL];
-  NSBitmapImageRep *image = [[NSBitmapImageRep alloc] initWithData:imageData];
-  [self restoreFromSnapshot:image];
+  PTDImageImport *import = [[PTDImageImport alloc] initWithContentsOfURL:openPanel.URL];
+  if (!import) {
+    NSBeep();
+    return;
+  }
+  
+  /* decode just enough pixels to cover the canvas */
+  PTDPaintView *view = self.paintViewController.view;
+  CGFloat width = round(view.paintRect.size.width * view.backingScaleFactor.width);
+  CGFloat height = round(view.paintRect.size.height * view.backingScaleFactor.height);
+  CGFloat cover = MAX(width / import.pixelSize.width, height / import.pixelSize.height);
+  NSSize pixelSize = NSMakeSize(ceil(import.pixelSize.width * cover), ceil(import.pixelSize.height * cover));
+  
+  __weak PTDSimpleAbstractPaintWindowController *weakSelf = self;
+  [import decodeImageFittingPixelSize:pixelSize completionHandler:^(NSBitmapImageRep *image) {
+    if (!image) {
+      NSBeep();
+      return;
+    }
+    [weakSelf restoreFromSnapshot:image];
+  }];
 }
 
 
@@ -0,0 +1,507 @@
+//
+// PTDStrokeFitter.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "PTDStrokeFitter.h"
+
+
+/* M_PI is not part of standard C */
+#define PI 3.14159265358979323846
+
+/* Vertices where the polyline turns more than this are corners, where the
+ * curves are not smooth */
+static const double _CornerAngle = 60.0 * PI / 180.0;
+/* Minimum length of the sides around a corner, relative to the tolerance */
+static const double _CornerMinSide = 4.0;
+/* Runs of vertices without corners are fitted as soon as they have this
+ * many vertices, so that the work per point stays constant */
+#define MAX_RUN_VERTICES 32
+/* Fitting uses the vertices and the midpoints of the sides */
+#define MAX_SAMPLES (2 * MAX_RUN_VERTICES + 1)
+#define REPARAMETERIZE_ITERATIONS 4
+
+
+typedef struct {
+  double x, y;
+} PTDStrokeFitterPoint;
+
+struct PTDStrokeFitter {
+  double tolerance;
+  int failed;
+  int finished;
+  size_t pointCount;
+  
+  /* the start of the stroke followed by three points per curve */
+  PTDStrokeFitterPoint *curves;
+  size_t curveCount;
+  size_t curveCapacity;
+  
+  /* Vertices not fitted yet; the first one is the end of the curves. The
+   * last point added follows them, when it is not a vertex. */
+  PTDStrokeFitterPoint run[MAX_RUN_VERTICES + 2];
+  size_t runCount;
+  int hasLast;
+  /* tangent at the start of the run, or zero to estimate it */
+  PTDStrokeFitterPoint runTangent;
+  
+  /* The sleeve is the range of directions from the last vertex along which
+   * a side passes within the tolerance from all the points after it. The
+   * directions are relative to sleeveReference. */
+  int sleeveConstrained;
+  double sleeveReference;
+  double sleeveMin, sleeveMax;
+  double sleeveDistance;
+  
+  PTDStrokeFitterPoint samples[MAX_SAMPLES];
+  double u[MAX_SAMPLES];
+};
+
+
+static inline PTDStrokeFitterPoint PTDStrokeFitterSub(PTDStrokeFitterPoint a, PTDStrokeFitterPoint b)
+{
+  return (PTDStrokeFitterPoint){a.x - b.x, a.y - b.y};
+}
+
+
+static inline PTDStrokeFitterPoint PTDStrokeFitterScale(PTDStrokeFitterPoint a, double s)
+{
+  return (PTDStrokeFitterPoint){a.x * s, a.y * s};
+}
+
+
+static inline double PTDStrokeFitterDot(PTDStrokeFitterPoint a, PTDStrokeFitterPoint b)
+{
+  return a.x * b.x + a.y * b.y;
+}
+
+
+static inline double PTDStrokeFitterDistance(PTDStrokeFitterPoint a, PTDStrokeFitterPoint b)
+{
+  return hypot(a.x - b.x, a.y - b.y);
+}
+
+
+static inline PTDStrokeFitterPoint PTDStrokeFitterNormalize(PTDStrokeFitterPoint a)
+{
+  double len = hypot(a.x, a.y);
+  if (len == 0.0)
+    return a;
+  return PTDStrokeFitterScale(a, 1.0 / len);
+}
+
+
+static PTDStrokeFitterPoint PTDStrokeFitterBezierPoint(const PTDStrokeFitterPoint *bez, int degree, double t)
+{
+  PTDStrokeFitterPoint tmp[4];
+  memcpy(tmp, bez, (size_t)(degree + 1) * sizeof(PTDStrokeFitterPoint));
+  for (int i = 1; i <= degree; i++) {
+    for (int j = 0; j <= degree - i; j++) {
+      tmp[j].x = (1.0 - t) * tmp[j].x + t * tmp[j+1].x;
+      tmp[j].y = (1.0 - t) * tmp[j].y + t * tmp[j+1].y;
+    }
+  }
+  return tmp[0];
+}
+
+
+PTDStrokeFitter *PTDStrokeFitterCreate(double tolerance)
+{
+  PTDStrokeFitter *fitter = calloc(1, sizeof(PTDStrokeFitter));
+  if (!fitter)
+    return NULL;
+  fitter->tolerance = tolerance > 0.0 ? tolerance : 0.5;
+  return fitter;
+}
+
+
+void PTDStrokeFitterDestroy(PTDStrokeFitter *fitter)
+{
+  if (!fitter)
+    return;
+  free(fitter->curves);
+  free(fitter);
+}
+
+
+void PTDStrokeFitterReset(PTDStrokeFitter *f)
+{
+  f->failed = 0;
+  f->finished = 0;
+  f->pointCount = 0;
+  f->curveCount = 0;
+  f->runCount = 0;
+  f->hasLast = 0;
+  f->runTangent = (PTDStrokeFitterPoint){0.0, 0.0};
+  f->sleeveConstrained = 0;
+  f->sleeveDistance = 0.0;
+}
+
+
+#pragma mark - Curve Fitting
+
+
+static int PTDStrokeFitterAppendCurve(PTDStrokeFitter *f, const PTDStrokeFitterPoint *bez)
+{
+  size_t needed = 1 + (f->curveCount + 1) * 3;
+  if (needed > f->curveCapacity) {
+    size_t capacity = f->curveCapacity ? f->curveCapacity * 2 : 64;
+    while (capacity < needed)
+      capacity *= 2;
+    PTDStrokeFitterPoint *curves = realloc(f->curves, capacity * sizeof(PTDStrokeFitterPoint));
+    if (!curves)
+      return 0;
+    f->curves = curves;
+    f->curveCapacity = capacity;
+  }
+  memcpy(f->curves + 1 + f->curveCount * 3, bez + 1, 3 * sizeof(PTDStrokeFitterPoint));
+  f->curveCount++;
+  return 1;
+}
+
+
+/* Least squares fit of the distances of the control points from the ends
+ * along the given tangents */
+static void PTDStrokeFitterGenerateBezier(const PTDStrokeFitter *f, size_t first, size_t last, PTDStrokeFitterPoint tHat1, PTDStrokeFitterPoint tHat2, PTDStrokeFitterPoint *bez)
+{
+  const PTDStrokeFitterPoint *d = f->samples;
+  double c00 = 0.0, c01 = 0.0, c11 = 0.0, x0 = 0.0, x1 = 0.0;
+  
+  for (size_t i = first; i <= last; i++) {
+    double u = f->u[i], mu = 1.0 - u;
+    double b0 = mu * mu * mu, b1 = 3.0 * u * mu * mu, b2 = 3.0 * u * u * mu, b3 = u * u * u;
+    PTDStrokeFitterPoint a0 = PTDStrokeFitterScale(tHat1, b1);
+    PTDStrokeFitterPoint a1 = PTDStrokeFitterScale(tHat2, b2);
+    c00 += PTDStrokeFitterDot(a0, a0);
+    c01 += PTDStrokeFitterDot(a0, a1);
+    c11 += PTDStrokeFitterDot(a1, a1);
+    PTDStrokeFitterPoint tmp = {
+      d[i].x - (d[first].x * (b0 + b1) + d[last].x * (b2 + b3)),
+      d[i].y - (d[first].y * (b0 + b1) + d[last].y * (b2 + b3))
+    };
+    x0 += PTDStrokeFitterDot(a0, tmp);
+    x1 += PTDStrokeFitterDot(a1, tmp);
+  }
+  
+  double det = c00 * c11 - c01 * c01;
+  double alpha1 = 0.0, alpha2 = 0.0;
+  if (det != 0.0) {
+    alpha1 = (x0 * c11 - x1 * c01) / det;
+    alpha2 = (c00 * x1 - c01 * x0) / det;
+  }
+  double segLength = PTDStrokeFitterDistance(d[first], d[last]);
+  double epsilon = 1e-6 * segLength;
+  if (alpha1 < epsilon || alpha2 < epsilon)
+    alpha1 = alpha2 = segLength / 3.0;
+  
+  bez[0] = d[first];
+  bez[3] = d[last];
+  bez[1] = (PTDStrokeFitterPoint){d[first].x + tHat1.x * alpha1, d[first].y + tHat1.y * alpha1};
+  bez[2] = (PTDStrokeFitterPoint){d[last].x + tHat2.x * alpha2, d[last].y + tHat2.y * alpha2};
+}
+
+
+static double PTDStrokeFitterMaxError(const PTDStrokeFitter *f, size_t first, size_t last, const PTDStrokeFitterPoint *bez, size_t *split)
+{
+  double maxDist = 0.0;
+  *split = (first + last + 1) / 2;
+  for (size_t i = first + 1; i < last; i++) {
+    double dist = PTDStrokeFitterDistance(PTDStrokeFitterBezierPoint(bez, 3, f->u[i]), f->samples[i]);
+    if (dist >= maxDist) {
+      maxDist = dist;
+      *split = i;
+    }
+  }
+  return maxDist;
+}
+
+
+/* One Newton-Raphson step towards the parameter of the point of the curve
+ * closest to each sample */
+static void PTDStrokeFitterReparameterize(PTDStrokeFitter *f, size_t first, size_t last, const PTDStrokeFitterPoint *bez)
+{
+  PTDStrokeFitterPoint q1[3], q2[2];
+  for (int i = 0; i < 3; i++)
+    q1[i] = PTDStrokeFitterScale(PTDStrokeFitterSub(bez[i+1], bez[i]), 3.0);
+  for (int i = 0; i < 2; i++)
+    q2[i] = PTDStrokeFitterScale(PTDStrokeFitterSub(q1[i+1], q1[i]), 2.0);
+  
+  for (size_t i = first; i <= last; i++) {
+    double u = f->u[i];
+    PTDStrokeFitterPoint qu = PTDStrokeFitterSub(PTDStrokeFitterBezierPoint(bez, 3, u), f->samples[i]);
+    PTDStrokeFitterPoint q1u = PTDStrokeFitterBezierPoint(q1, 2, u);
+    PTDStrokeFitterPoint q2u = PTDStrokeFitterBezierPoint(q2, 1, u);
+    double num = PTDStrokeFitterDot(qu, q1u);
+    double den = PTDStrokeFitterDot(q1u, q1u) + PTDStrokeFitterDot(qu, q2u);
+    if (den != 0.0)
+      f->u[i] = u - num / den;
+  }
+}
+
+
+static int PTDStrokeFitterFitCubic(PTDStrokeFitter *f, size_t first, size_t last, PTDStrokeFitterPoint tHat1, PTDStrokeFitterPoint tHat2)
+{
+  const PTDStrokeFitterPoint *d = f->samples;
+  PTDStrokeFitterPoint bez[4];
+  
+  if (last - first == 1) {
+    double dist = PTDStrokeFitterDistance(d[first], d[last]) / 3.0;
+    bez[0] = d[first];
+    bez[3] = d[last];
+    bez[1] = (PTDStrokeFitterPoint){d[first].x + tHat1.x * dist, d[first].y + tHat1.y * dist};
+    bez[2] = (PTDStrokeFitterPoint){d[last].x + tHat2.x * dist, d[last].y + tHat2.y * dist};
+    return PTDStrokeFitterAppendCurve(f, bez);
+  }
+  
+  /* chord length parameterization */
+  f->u[first] = 0.0;
+  for (size_t i = first + 1; i <= last; i++)
+    f->u[i] = f->u[i-1] + PTDStrokeFitterDistance(d[i], d[i-1]);
+  double total = f->u[last];
+  for (size_t i = first + 1; i <= last; i++)
+    f->u[i] = total > 0.0 ? f->u[i] / total : 1.0;
+  
+  size_t split;
+  PTDStrokeFitterGenerateBezier(f, first, last, tHat1, tHat2, bez);
+  double error = PTDStrokeFitterMaxError(f, first, last, bez, &split);
+  if (error < f->tolerance)
+    return PTDStrokeFitterAppendCurve(f, bez);
+  
+  if (error < f->tolerance * 4.0) {
+    for (int i = 0; i < REPARAMETERIZE_ITERATIONS; i++) {
+      PTDStrokeFitterReparameterize(f, first, last, bez);
+      PTDStrokeFitterGenerateBezier(f, first, last, tHat1, tHat2, bez);
+      error = PTDStrokeFitterMaxError(f, first, last, bez, &split);
+      if (error < f->tolerance)
+        return PTDStrokeFitterAppendCurve(f, bez);
+    }
+  }
+  
+  PTDStrokeFitterPoint tHatCenter = PTDStrokeFitterNormalize(PTDStrokeFitterSub(d[split-1], d[split+1]));
+  if (tHatCenter.x == 0.0 && tHatCenter.y == 0.0)
+    tHatCenter = PTDStrokeFitterNormalize(PTDStrokeFitterSub(d[split-1], d[split]));
+  if (!PTDStrokeFitterFitCubic(f, first, split, tHat1, tHatCenter))
+    return 0;
+  return PTDStrokeFitterFitCubic(f, split, last, PTDStrokeFitterScale(tHatCenter, -1.0), tHat2);
+}
+
+
+/* Fits curves to the first count vertices of the run; tangents which are
+ * zero are estimated from the vertices. */
+static int PTDStrokeFitterFitRun(PTDStrokeFitter *f, size_t count, PTDStrokeFitterPoint tHat1, PTDStrokeFitterPoint tHat2)
+{
+  const PTDStrokeFitterPoint *v = f->run;
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i > 0)
+      f->samples[n++] = (PTDStrokeFitterPoint){(v[i-1].x + v[i].x) / 2.0, (v[i-1].y + v[i].y) / 2.0};
+    f->samples[n++] = v[i];
+  }
+  
+  if (count == 2) {
+    /* a single side stays straight */
+    tHat1 = PTDStrokeFitterNormalize(PTDStrokeFitterSub(v[1], v[0]));
+    tHat2 = PTDStrokeFitterScale(tHat1, -1.0);
+  } else {
+    if (tHat1.x == 0.0 && tHat1.y == 0.0)
+      tHat1 = PTDStrokeFitterNormalize(PTDStrokeFitterSub(v[1], v[0]));
+    if (tHat2.x == 0.0 && tHat2.y == 0.0)
+      tHat2 = PTDStrokeFitterNormalize(PTDStrokeFitterSub(v[count-2], v[count-1]));
+  }
+  return PTDStrokeFitterFitCubic(f, 0, n - 1, tHat1, tHat2);
+}
+
+
+/* Removes the fitted vertices from the run, keeping the last one as the
+ * start of the next run */
+static void PTDStrokeFitterShiftRun(PTDStrokeFitter *f, size_t fitted)
+{
+  size_t remaining = f->runCount - (fitted - 1);
+  memmove(f->run, f->run + fitted - 1, (remaining + 1) * sizeof(PTDStrokeFitterPoint));
+  f->runCount = remaining;
+}
+
+
+#pragma mark - Simplification
+
+
+static void PTDStrokeFitterResetSleeve(PTDStrokeFitter *f)
+{
+  f->sleeveConstrained = 0;
+  f->sleeveDistance = 0.0;
+}
+
+
+/* Returns whether the side from the last vertex to the point passes within
+ * the tolerance from all the points since the vertex */
+static int PTDStrokeFitterExtendSleeve(PTDStrokeFitter *f, PTDStrokeFitterPoint p)
+{
+  PTDStrokeFitterPoint anchor = f->run[f->runCount - 1];
+  double dx = p.x - anchor.x, dy = p.y - anchor.y;
+  double dist = hypot(dx, dy);
+  double tolerance = f->tolerance;
+  
+  /* strokes turning back on themselves */
+  if (dist < f->sleeveDistance - tolerance)
+    return 0;
+  if (dist <= tolerance) {
+    f->sleeveDistance = fmax(f->sleeveDistance, dist);
+    return 1;
+  }
+  
+  double angle = atan2(dy, dx);
+  double halfWidth = asin(tolerance / dist);
+  if (!f->sleeveConstrained) {
+    f->sleeveConstrained = 1;
+    f->sleeveReference = angle;
+    f->sleeveMin = -halfWidth;
+    f->sleeveMax = halfWidth;
+  } else {
+    double rel = remainder(angle - f->sleeveReference, 2.0 * PI);
+    if (rel < f->sleeveMin || rel > f->sleeveMax)
+      return 0;
+    f->sleeveMin = fmax(f->sleeveMin, rel - halfWidth);
+    f->sleeveMax = fmin(f->sleeveMax, rel + halfWidth);
+  }
+  f->sleeveDistance = fmax(f->sleeveDistance, dist);
+  return 1;
+}
+
+
+static int PTDStrokeFitterAddVertex(PTDStrokeFitter *f, PTDStrokeFitterPoint p)
+{
+  f->run[f->runCount++] = p;
+  f->hasLast = 0;
+  PTDStrokeFitterResetSleeve(f);
+  if (f->runCount < 3)
+    return 1;
+  
+  size_t k = f->runCount - 2;
+  const PTDStrokeFitterPoint *v = f->run;
+  PTDStrokeFitterPoint in = PTDStrokeFitterSub(v[k], v[k-1]);
+  PTDStrokeFitterPoint out = PTDStrokeFitterSub(v[k+1], v[k]);
+  /* the direction of short sides is mostly noise */
+  double minSide = f->tolerance * _CornerMinSide;
+  int corner = 0;
+  if (hypot(in.x, in.y) > minSide && hypot(out.x, out.y) > minSide) {
+    double c = PTDStrokeFitterDot(PTDStrokeFitterNormalize(in), PTDStrokeFitterNormalize(out));
+    corner = c < cos(_CornerAngle);
+  }
+  
+  if (corner) {
+    if (!PTDStrokeFitterFitRun(f, k + 1, f->runTangent, (PTDStrokeFitterPoint){0.0, 0.0}))
+      return 0;
+    f->runTangent = (PTDStrokeFitterPoint){0.0, 0.0};
+    PTDStrokeFitterShiftRun(f, k + 1);
+    
+  } else if (f->runCount > MAX_RUN_VERTICES) {
+    /* the curves stay smooth across runs */
+    PTDStrokeFitterPoint tangent = PTDStrokeFitterNormalize(PTDStrokeFitterSub(v[k-1], v[k+1]));
+    if (!PTDStrokeFitterFitRun(f, k + 1, f->runTangent, tangent))
+      return 0;
+    f->runTangent = PTDStrokeFitterScale(tangent, -1.0);
+    PTDStrokeFitterShiftRun(f, k + 1);
+  }
+  return 1;
+}
+
+
+int PTDStrokeFitterAddPoint(PTDStrokeFitter *f, double x, double y)
+{
+  if (f->failed || f->finished)
+    return 0;
+  PTDStrokeFitterPoint p = {x, y};
+  
+  if (f->pointCount++ == 0) {
+    if (!f->curves) {
+      f->curves = malloc(64 * sizeof(PTDStrokeFitterPoint));
+      if (!f->curves) {
+        f->failed = 1;
+        return 0;
+      }
+      f->curveCapacity = 64;
+    }
+    f->curves[0] = p;
+    f->run[0] = p;
+    f->runCount = 1;
+    PTDStrokeFitterResetSleeve(f);
+    return 1;
+  }
+  
+  if (!PTDStrokeFitterExtendSleeve(f, p)) {
+    /* the previous point ends the side and starts a new sleeve, which
+     * always contains the next point */
+    if (!PTDStrokeFitterAddVertex(f, f->run[f->runCount])) {
+      f->failed = 1;
+      return 0;
+    }
+    PTDStrokeFitterExtendSleeve(f, p);
+  }
+  f->run[f->runCount] = p;
+  f->hasLast = 1;
+  return 1;
+}
+
+
+int PTDStrokeFitterFinish(PTDStrokeFitter *f)
+{
+  if (f->failed)
+    return 0;
+  if (f->finished)
+    return 1;
+  f->finished = 1;
+  
+  PTDStrokeFitterPoint last = f->run[f->runCount];
+  if (f->hasLast && PTDStrokeFitterDistance(last, f->run[f->runCount - 1]) > 0.0 && !PTDStrokeFitterAddVertex(f, last)) {
+    f->failed = 1;
+    return 0;
+  }
+  if (f->runCount >= 2) {
+    if (!PTDStrokeFitterFitRun(f, f->runCount, f->runTangent, (PTDStrokeFitterPoint){0.0, 0.0})) {
+      f->failed = 1;
+      return 0;
+    }
+    PTDStrokeFitterShiftRun(f, f->runCount);
+  }
+  return 1;
+}
+
+
+const double *PTDStrokeFitterCurves(const PTDStrokeFitter *f, size_t *curveCount)
+{
+  *curveCount = f->curveCount;
+  if (f->curveCount == 0)
+    return NULL;
+  return (const double *)f->curves;
+}
+
+
+const double *PTDStrokeFitterPendingPoints(const PTDStrokeFitter *f, size_t *count)
+{
+  *count = f->runCount + (f->hasLast ? 1 : 0);
+  return (const double *)f->run;
+}
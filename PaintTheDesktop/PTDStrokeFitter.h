@@ -0,0 +1,70 @@
+//
+// PTDStrokeFitter.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef PTDStrokeFitter_h
+#define PTDStrokeFitter_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Approximates a freehand stroke with cubic Bézier curves while it is being
+ * drawn. Points are first simplified to a polyline whose sides pass within
+ * the tolerance from all the points, which takes constant time per point.
+ * Runs of polyline vertices are then fitted with curves, splitting at
+ * sharp corners, with Schneider's algorithm. */
+typedef struct PTDStrokeFitter PTDStrokeFitter;
+
+PTDStrokeFitter *PTDStrokeFitterCreate(double tolerance);
+void PTDStrokeFitterDestroy(PTDStrokeFitter *fitter);
+
+/* Forgets the current stroke */
+void PTDStrokeFitterReset(PTDStrokeFitter *fitter);
+
+/* Returns 0 on failure, after which points are not added anymore */
+int PTDStrokeFitterAddPoint(PTDStrokeFitter *fitter, double x, double y);
+
+/* Fits the rest of the stroke. Points cannot be added afterwards until the
+ * fitter is reset. */
+int PTDStrokeFitterFinish(PTDStrokeFitter *fitter);
+
+/* The curves fitted up to now, as x,y pairs: the start of the stroke, then
+ * the two control points and the end point of each curve. Returns NULL if
+ * there are no curves. Curves are only ever appended, so the ones returned
+ * before stay the same until the fitter is reset. */
+const double *PTDStrokeFitterCurves(const PTDStrokeFitter *fitter, size_t *curveCount);
+
+/* The polyline continuing the curves up to the last point added, as x,y
+ * pairs starting from the end of the curves. */
+const double *PTDStrokeFitterPendingPoints(const PTDStrokeFitter *fitter, size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDStrokeFitter_h */
@@ -0,0 +1,472 @@
+//
+// PTDTaskScheduler.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/* clock_gettime is POSIX; on Darwin the macro would hide the QoS functions */
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
+#include "PTDTaskScheduler.h"
+
+
+/* how many tasks can be taken before one which was waiting all along */
+static const unsigned long long _StarvationLimit = 16;
+static const time_t _IdleWorkerTimeout = 10;
+static const size_t _SharedMaxWorkers = 4;
+
+
+typedef enum {
+  PTDTaskStateCreated,
+  /* behind another task of its serial queue */
+  PTDTaskStateQueued,
+  PTDTaskStatePending,
+  PTDTaskStateRunning,
+  PTDTaskStateFinished
+} PTDTaskState;
+
+struct PTDTask {
+  _Atomic size_t refs;
+  _Atomic bool cancelled;
+  PTDTaskPriority priority;
+  PTDTaskFunction function;
+  void *context;
+  PTDTaskSerialQueue *serialQueue;
+  /* set once when submitted; atomic so that waiting can find the lock */
+  _Atomic(PTDTaskScheduler *) scheduler;
+  
+  /* the rest is protected by the lock of the scheduler */
+  PTDTaskState state;
+  unsigned long long submittedAt;
+  PTDTask *prev;
+  PTDTask *next;
+};
+
+typedef struct {
+  PTDTask *head;
+  PTDTask *tail;
+} PTDTaskList;
+
+struct PTDTaskSerialQueue {
+  _Atomic size_t refs;
+  /* protected by the lock of the scheduler */
+  /* set while a task of the queue is pending or running; the others wait
+   * here, so that the scheduler only ever sees tasks which can start */
+  bool busy;
+  PTDTaskList waiting;
+};
+
+struct PTDTaskScheduler {
+  pthread_mutex_t lock;
+  pthread_cond_t workAvailable;
+  pthread_cond_t taskFinished;
+  PTDTaskList pending[PTDTaskPriorityCount];
+  /* the tasks submitted and not started yet, including the ones waiting
+   * behind their serial queue, and of those only the ones which can start */
+  size_t pendingCount;
+  size_t runnableCount;
+  /* counts the tasks taken, to measure how long the others waited */
+  unsigned long long taken;
+  size_t maxWorkers;
+  size_t workers;
+  size_t idleWorkers;
+  size_t backgroundRunning;
+  bool stop;
+};
+
+
+#pragma mark - Tasks
+
+
+PTDTask *PTDTaskCreate(PTDTaskPriority priority, PTDTaskFunction function, void *context)
+{
+  PTDTask *task = calloc(1, sizeof(PTDTask));
+  if (!task)
+    return NULL;
+  atomic_init(&task->refs, 1);
+  atomic_init(&task->cancelled, false);
+  atomic_init(&task->scheduler, NULL);
+  task->priority = priority < PTDTaskPriorityCount ? priority : PTDTaskPriorityAutosave;
+  task->function = function;
+  task->context = context;
+  task->state = PTDTaskStateCreated;
+  return task;
+}
+
+
+PTDTask *PTDTaskRetain(PTDTask *task)
+{
+  atomic_fetch_add_explicit(&task->refs, 1, memory_order_relaxed);
+  return task;
+}
+
+
+void PTDTaskRelease(PTDTask *task)
+{
+  if (!task || atomic_fetch_sub_explicit(&task->refs, 1, memory_order_acq_rel) != 1)
+    return;
+  PTDTaskSerialQueueRelease(task->serialQueue);
+  free(task);
+}
+
+
+void PTDTaskSetSerialQueue(PTDTask *task, PTDTaskSerialQueue *queue)
+{
+  PTDTaskSerialQueueRelease(task->serialQueue);
+  task->serialQueue = queue ? PTDTaskSerialQueueRetain(queue) : NULL;
+}
+
+
+void PTDTaskCancel(PTDTask *task)
+{
+  atomic_store_explicit(&task->cancelled, true, memory_order_relaxed);
+}
+
+
+bool PTDTaskIsCancelled(const PTDTask *task)
+{
+  return atomic_load_explicit(&task->cancelled, memory_order_relaxed);
+}
+
+
+PTDTaskSerialQueue *PTDTaskSerialQueueCreate(void)
+{
+  PTDTaskSerialQueue *queue = calloc(1, sizeof(PTDTaskSerialQueue));
+  if (!queue)
+    return NULL;
+  atomic_init(&queue->refs, 1);
+  return queue;
+}
+
+
+PTDTaskSerialQueue *PTDTaskSerialQueueRetain(PTDTaskSerialQueue *queue)
+{
+  atomic_fetch_add_explicit(&queue->refs, 1, memory_order_relaxed);
+  return queue;
+}
+
+
+void PTDTaskSerialQueueRelease(PTDTaskSerialQueue *queue)
+{
+  if (queue && atomic_fetch_sub_explicit(&queue->refs, 1, memory_order_acq_rel) == 1)
+    free(queue);
+}
+
+
+#pragma mark - Scheduling
+
+
+static void PTDTaskListAppend(PTDTaskList *list, PTDTask *task)
+{
+  task->prev = list->tail;
+  task->next = NULL;
+  if (list->tail)
+    list->tail->next = task;
+  else
+    list->head = task;
+  list->tail = task;
+}
+
+
+static void PTDTaskListRemove(PTDTaskList *list, PTDTask *task)
+{
+  if (task->prev)
+    task->prev->next = task->next;
+  else
+    list->head = task->next;
+  if (task->next)
+    task->next->prev = task->prev;
+  else
+    list->tail = task->prev;
+  task->prev = task->next = NULL;
+}
+
+
+static void PTDTaskSchedulerMakePending(PTDTaskScheduler *scheduler, PTDTask *task)
+{
+  if (scheduler->stop)
+    PTDTaskCancel(task);
+  task->state = PTDTaskStatePending;
+  task->submittedAt = scheduler->taken;
+  PTDTaskListAppend(&scheduler->pending[task->priority], task);
+  scheduler->runnableCount++;
+}
+
+
+static void PTDTaskSchedulerTakePending(PTDTaskScheduler *scheduler, PTDTask *task)
+{
+  PTDTaskListRemove(&scheduler->pending[task->priority], task);
+  scheduler->pendingCount--;
+  scheduler->runnableCount--;
+  task->state = PTDTaskStateRunning;
+}
+
+
+static PTDTask *PTDTaskSchedulerTakeTask(PTDTaskScheduler *scheduler)
+{
+  /* background tasks can only start if a thread is left for the others */
+  size_t maxBackground = scheduler->maxWorkers > 1 ? scheduler->maxWorkers - 1 : 1;
+  int classes = scheduler->backgroundRunning < maxBackground ? PTDTaskPriorityCount : PTDTaskPriorityInteractive + 1;
+  
+  PTDTask *urgent = NULL;
+  PTDTask *starved = NULL;
+  for (int p = 0; p < classes; p++) {
+    /* the other tasks in the same class waited less */
+    PTDTask *task = scheduler->pending[p].head;
+    if (!task)
+      continue;
+    if (!urgent)
+      urgent = task;
+    if (scheduler->taken - task->submittedAt > _StarvationLimit && (!starved || task->submittedAt < starved->submittedAt))
+      starved = task;
+  }
+  
+  PTDTask *task = starved ? starved : urgent;
+  if (!task)
+    return NULL;
+  PTDTaskSchedulerTakePending(scheduler, task);
+  scheduler->taken++;
+  return task;
+}
+
+
+static void PTDTaskSchedulerRunTask(PTDTaskScheduler *scheduler, PTDTask *task)
+{
+  pthread_mutex_unlock(&scheduler->lock);
+  task->function(task, task->context);
+  pthread_mutex_lock(&scheduler->lock);
+  
+  task->state = PTDTaskStateFinished;
+  PTDTaskSerialQueue *queue = task->serialQueue;
+  if (queue) {
+    PTDTask *next = queue->waiting.head;
+    if (next) {
+      PTDTaskListRemove(&queue->waiting, next);
+      PTDTaskSchedulerMakePending(scheduler, next);
+    } else {
+      queue->busy = false;
+    }
+  }
+  pthread_cond_broadcast(&scheduler->taskFinished);
+  /* a task which could not start before might be able to now */
+  if (scheduler->runnableCount > 0)
+    pthread_cond_broadcast(&scheduler->workAvailable);
+  PTDTaskRelease(task);
+}
+
+
+static void *PTDTaskSchedulerWorker(void *arg)
+{
+  PTDTaskScheduler *scheduler = arg;
+  pthread_mutex_lock(&scheduler->lock);
+  
+  for (;;) {
+    PTDTask *task = PTDTaskSchedulerTakeTask(scheduler);
+    if (task) {
+      bool background = task->priority != PTDTaskPriorityInteractive;
+      if (background)
+        scheduler->backgroundRunning++;
+#ifdef __APPLE__
+      static const qos_class_t qos[PTDTaskPriorityCount] = {
+        QOS_CLASS_USER_INITIATED, QOS_CLASS_UTILITY, QOS_CLASS_UTILITY, QOS_CLASS_BACKGROUND};
+      pthread_set_qos_class_self_np(qos[task->priority], 0);
+#endif
+      PTDTaskSchedulerRunTask(scheduler, task);
+      if (background)
+        scheduler->backgroundRunning--;
+      continue;
+    }
+    if (scheduler->stop && scheduler->pendingCount == 0)
+      break;
+    
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += _IdleWorkerTimeout;
+    scheduler->idleWorkers++;
+    int res = pthread_cond_timedwait(&scheduler->workAvailable, &scheduler->lock, &deadline);
+    scheduler->idleWorkers--;
+    if (res != 0 && scheduler->pendingCount == 0)
+      break;
+  }
+  
+  scheduler->workers--;
+  pthread_cond_broadcast(&scheduler->taskFinished);
+  pthread_mutex_unlock(&scheduler->lock);
+  return NULL;
+}
+
+
+static bool PTDTaskSchedulerStartWorker(PTDTaskScheduler *scheduler)
+{
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  pthread_t thread;
+  int res = pthread_create(&thread, &attr, PTDTaskSchedulerWorker, scheduler);
+  pthread_attr_destroy(&attr);
+  if (res != 0)
+    return false;
+  scheduler->workers++;
+  return true;
+}
+
+
+#pragma mark - Public interface
+
+
+PTDTaskScheduler *PTDTaskSchedulerCreate(size_t maxWorkers)
+{
+  PTDTaskScheduler *scheduler = calloc(1, sizeof(PTDTaskScheduler));
+  if (!scheduler)
+    return NULL;
+  scheduler->maxWorkers = maxWorkers > 0 ? maxWorkers : 1;
+  pthread_mutex_init(&scheduler->lock, NULL);
+  pthread_cond_init(&scheduler->workAvailable, NULL);
+  pthread_cond_init(&scheduler->taskFinished, NULL);
+  return scheduler;
+}
+
+
+void PTDTaskSchedulerDestroy(PTDTaskScheduler *scheduler)
+{
+  if (!scheduler)
+    return;
+  
+  pthread_mutex_lock(&scheduler->lock);
+  scheduler->stop = true;
+  for (int p = 0; p < PTDTaskPriorityCount; p++) {
+    for (PTDTask *task = scheduler->pending[p].head; task; task = task->next) {
+      PTDTaskCancel(task);
+      if (task->serialQueue) {
+        for (PTDTask *queued = task->serialQueue->waiting.head; queued; queued = queued->next)
+          PTDTaskCancel(queued);
+      }
+    }
+  }
+  /* the tasks waiting behind running ones are cancelled once they can start */
+  pthread_cond_broadcast(&scheduler->workAvailable);
+  while (scheduler->workers > 0)
+    pthread_cond_wait(&scheduler->taskFinished, &scheduler->lock);
+  /* only if no worker could ever be started */
+  PTDTask *task;
+  while ((task = PTDTaskSchedulerTakeTask(scheduler)))
+    PTDTaskSchedulerRunTask(scheduler, task);
+  pthread_mutex_unlock(&scheduler->lock);
+  
+  pthread_cond_destroy(&scheduler->taskFinished);
+  pthread_cond_destroy(&scheduler->workAvailable);
+  pthread_mutex_destroy(&scheduler->lock);
+  free(scheduler);
+}
+
+
+static PTDTaskScheduler *_SharedScheduler;
+
+static void PTDTaskSchedulerCreateShared(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t workers = cpus > 0 ? (size_t)cpus : 1;
+  if (workers > _SharedMaxWorkers)
+    workers = _SharedMaxWorkers;
+  /* leave room for a thread reserved to interactive tasks */
+  if (workers < 2)
+    workers = 2;
+  _SharedScheduler = PTDTaskSchedulerCreate(workers);
+}
+
+
+PTDTaskScheduler *PTDTaskSchedulerShared(void)
+{
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once(&once, PTDTaskSchedulerCreateShared);
+  return _SharedScheduler;
+}
+
+
+size_t PTDTaskSchedulerWorkerCount(PTDTaskScheduler *scheduler)
+{
+  pthread_mutex_lock(&scheduler->lock);
+  size_t workers = scheduler->workers;
+  pthread_mutex_unlock(&scheduler->lock);
+  return workers;
+}
+
+
+void PTDTaskSchedulerSubmit(PTDTaskScheduler *scheduler, PTDTask *task)
+{
+  pthread_mutex_lock(&scheduler->lock);
+  PTDTaskRetain(task);
+  atomic_store_explicit(&task->scheduler, scheduler, memory_order_release);
+  scheduler->pendingCount++;
+  PTDTaskSerialQueue *queue = task->serialQueue;
+  if (queue && queue->busy) {
+    task->state = PTDTaskStateQueued;
+    PTDTaskListAppend(&queue->waiting, task);
+    pthread_mutex_unlock(&scheduler->lock);
+    return;
+  }
+  if (queue)
+    queue->busy = true;
+  PTDTaskSchedulerMakePending(scheduler, task);
+  
+  if (scheduler->idleWorkers > 0)
+    pthread_cond_broadcast(&scheduler->workAvailable);
+  /* tasks waiting behind their serial queue would leave the thread idle */
+  if (scheduler->runnableCount > scheduler->idleWorkers && scheduler->workers < scheduler->maxWorkers)
+    PTDTaskSchedulerStartWorker(scheduler);
+  
+  if (scheduler->workers == 0) {
+    /* no thread can be started at all */
+    PTDTask *next;
+    while ((next = PTDTaskSchedulerTakeTask(scheduler)))
+      PTDTaskSchedulerRunTask(scheduler, next);
+  }
+  pthread_mutex_unlock(&scheduler->lock);
+}
+
+
+void PTDTaskWait(PTDTask *task)
+{
+  PTDTaskScheduler *scheduler = atomic_load_explicit(&task->scheduler, memory_order_acquire);
+  if (!scheduler)
+    return;
+  pthread_mutex_lock(&scheduler->lock);
+  
+  if (task->state == PTDTaskStatePending) {
+    PTDTaskSchedulerTakePending(scheduler, task);
+    PTDTaskSchedulerRunTask(scheduler, task);
+  } else {
+    while (task->state != PTDTaskStateFinished)
+      pthread_cond_wait(&scheduler->taskFinished, &scheduler->lock);
+  }
+  pthread_mutex_unlock(&scheduler->lock);
+}
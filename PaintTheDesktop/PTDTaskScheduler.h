@@ -0,0 +1,103 @@
+//
+// PTDTaskScheduler.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDTaskScheduler_h
+#define PTDTaskScheduler_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* From the most to the least urgent. */
+typedef enum {
+  /* something the user is waiting for right now */
+  PTDTaskPriorityInteractive,
+  /* data which will probably be needed soon */
+  PTDTaskPriorityPrefetch,
+  /* conversion of data to a file format */
+  PTDTaskPriorityEncode,
+  /* saving state which is not asked for explicitly */
+  PTDTaskPriorityAutosave,
+  PTDTaskPriorityCount
+} PTDTaskPriority;
+
+typedef struct PTDTask PTDTask;
+typedef struct PTDTaskSerialQueue PTDTaskSerialQueue;
+typedef struct PTDTaskScheduler PTDTaskScheduler;
+
+/* Called exactly once for each submitted task, even if it was cancelled,
+ * so that it can always dispose of its context. */
+typedef void (*PTDTaskFunction)(PTDTask *task, void *context);
+
+/* Runs tasks on a pool of at most the given number of threads, which are
+ * started when there is work and exit after being idle for a while.
+ * Pending tasks are taken from the most urgent class first, except for
+ * tasks which were passed over too many times, which are taken first to
+ * avoid starving them. Tasks can not be interrupted once they are
+ * running; instead, one of the threads only ever runs interactive tasks,
+ * so that they do not wait for the others to finish. */
+PTDTaskScheduler *PTDTaskSchedulerCreate(size_t maxWorkers);
+/* Cancels the pending tasks and waits for all of them to be run. */
+void PTDTaskSchedulerDestroy(PTDTaskScheduler *scheduler);
+
+/* The scheduler used by the whole application, which is never destroyed. */
+PTDTaskScheduler *PTDTaskSchedulerShared(void);
+
+/* The number of threads started and not exited yet, for diagnostics. */
+size_t PTDTaskSchedulerWorkerCount(PTDTaskScheduler *scheduler);
+
+PTDTask *PTDTaskCreate(PTDTaskPriority priority, PTDTaskFunction function, void *context);
+PTDTask *PTDTaskRetain(PTDTask *task);
+void PTDTaskRelease(PTDTask *task);
+
+/* Tasks on the same serial queue run one at a time, in the order they
+ * were submitted. Must be set before the task is submitted, and all the
+ * tasks on a queue must go to the same scheduler. */
+void PTDTaskSetSerialQueue(PTDTask *task, PTDTaskSerialQueue *queue);
+
+/* A task can be submitted only once. The scheduler keeps its own reference
+ * until the task has run. */
+void PTDTaskSchedulerSubmit(PTDTaskScheduler *scheduler, PTDTask *task);
+
+/* Returns after the task has run. If it did not start yet, and nothing on
+ * its serial queue comes before it, it is run on the calling thread. */
+void PTDTaskWait(PTDTask *task);
+
+/* Tasks cancelled while running should check this periodically. */
+void PTDTaskCancel(PTDTask *task);
+bool PTDTaskIsCancelled(const PTDTask *task);
+
+PTDTaskSerialQueue *PTDTaskSerialQueueCreate(void);
+PTDTaskSerialQueue *PTDTaskSerialQueueRetain(PTDTaskSerialQueue *queue);
+void PTDTaskSerialQueueRelease(PTDTaskSerialQueue *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDTaskScheduler_h */
@@ -0,0 +1,42 @@
+//
+// PTDTextCanvasObject.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDCanvasObject.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Text laid out like it was in the text view used to edit it. */
+@interface PTDTextCanvasObject : PTDCanvasObject
+
+/* The text view must be a subview of the view which hosts the canvas. */
+- (instancetype)initWithTextView:(NSTextView *)textView baselinePivot:(NSPoint)pivot;
+
+@property (nonatomic, readonly) NSAttributedString *attributedString;
+@property (nonatomic, readonly) NSPoint baselinePivot;
+@property (nonatomic, readonly) NSTextAlignment alignment;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,270 @@
+//
+// PTDTextCanvasObject.m
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#import "PTDTextCanvasObject.h"
+#import "PTDGlyphAtlas.h"
+#import "NSBitmapImageRep+PTD.h"
+
+
+static const size_t _GlyphAtlasSize = 2048;
+/* horizontal glyph positions are rounded to a quarter of a pixel */
+static const int _GlyphSubpixelSteps = 4;
+
+
+static PTDGlyphAtlas *PTDTextCanvasObjectGlyphAtlas(void)
+{
+  static PTDGlyphAtlas *atlas;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    atlas = PTDGlyphAtlasCreate(_GlyphAtlasSize, _GlyphAtlasSize);
+  });
+  return atlas;
+}
+
+
+/* Renders the coverage of a glyph with its pen position moved right by
+ * the given fraction of a pixel, and adds it to the atlas */
+static const PTDGlyphAtlasEntry *PTDTextCanvasObjectRenderGlyph(PTDGlyphAtlas *atlas, uint64_t key, NSFont *font, CGGlyph glyph, NSSize scale, CGFloat subpixel)
+{
+  CTFontRef ctFont = (__bridge CTFontRef)font;
+  CGRect bbox;
+  CTFontGetBoundingRectsForGlyphs(ctFont, kCTFontOrientationDefault, &glyph, &bbox, 1);
+  
+  int left = 0, top = 0, bottom = 0;
+  size_t width = 0, height = 0;
+  if (!CGRectIsEmpty(bbox)) {
+    /* leave room for the antialiasing */
+    left = (int)floor(CGRectGetMinX(bbox) * scale.width + subpixel) - 1;
+    int right = (int)ceil(CGRectGetMaxX(bbox) * scale.width + subpixel) + 1;
+    bottom = (int)floor(CGRectGetMinY(bbox) * scale.height) - 1;
+    top = (int)ceil(CGRectGetMaxY(bbox) * scale.height) + 1;
+    width = (size_t)(right - left);
+    height = (size_t)(top - bottom);
+  }
+  
+  uint8_t *coverage;
+  size_t bytesPerRow;
+  const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasInsert(atlas, key, width, height, left, top, &coverage, &bytesPerRow);
+  if (!entry || width == 0 || height == 0)
+    return entry;
+  
+  CGContextRef ctx = CGBitmapContextCreate(coverage, width, height, 8, bytesPerRow, NULL, (CGBitmapInfo)kCGImageAlphaOnly);
+  if (!ctx)
+    return entry;
+  CGContextTranslateCTM(ctx, subpixel - left, -bottom);
+  CGContextScaleCTM(ctx, scale.width, scale.height);
+  CGPoint position = CGPointZero;
+  CTFontDrawGlyphs(ctFont, &glyph, &position, 1, ctx);
+  CGContextRelease(ctx);
+  return entry;
+}
+
+
+@implementation PTDTextCanvasObject {
+  NSTextStorage *_textStorage;
+  NSLayoutManager *_layoutManager;
+  NSTextContainer *_textContainer;
+  /* top left corner of the text container */
+  NSPoint _containerOrigin;
+  NSRect _textRect;
+  NSRect _bounds;
+}
+
+
+- (instancetype)initWithTextView:(NSTextView *)textView baselinePivot:(NSPoint)pivot
+{
+  self = [super init];
+  _baselinePivot = pivot;
+  _alignment = textView.alignment;
+  
+  _textStorage = [[NSTextStorage alloc] initWithAttributedString:textView.textStorage];
+  _layoutManager = [[NSLayoutManager alloc] init];
+  _textContainer = [[NSTextContainer alloc] initWithSize:textView.textContainer.size];
+  _textContainer.lineFragmentPadding = textView.textContainer.lineFragmentPadding;
+  [_layoutManager addTextContainer:_textContainer];
+  [_textStorage addLayoutManager:_layoutManager];
+  
+  _containerOrigin = [textView convertPoint:textView.textContainerOrigin toView:textView.superview];
+  NSRect used = [_layoutManager usedRectForTextContainer:_textContainer];
+  _textRect = NSMakeRect(
+      _containerOrigin.x + used.origin.x,
+      _containerOrigin.y - NSMaxY(used),
+      used.size.width, used.size.height);
+  
+  /* glyphs can overhang their line fragments, especially in italic */
+  __block CGFloat maxFontSize = 0;
+  [_textStorage enumerateAttribute:NSFontAttributeName inRange:NSMakeRange(0, _textStorage.length) options:0 usingBlock:^(NSFont *font, NSRange range, BOOL *stop) {
+    maxFontSize = MAX(maxFontSize, font.pointSize);
+  }];
+  _bounds = NSInsetRect(_textRect, -ceil(maxFontSize / 2.0), -ceil(maxFontSize / 2.0));
+  return self;
+}
+
+
+- (NSAttributedString *)attributedString
+{
+  return [_textStorage copy];
+}
+
+
+- (NSRect)bounds
+{
+  return _bounds;
+}
+
+
+- (BOOL)containsPoint:(NSPoint)point
+{
+  return NSPointInRect(point, _textRect);
+}
+
+
+- (void)draw
+{
+  CGContextRef ctxt = NSGraphicsContext.currentContext.CGContext;
+  CGContextSaveGState(ctxt);
+  CGContextTranslateCTM(ctxt, _containerOrigin.x, _containerOrigin.y);
+  CGContextScaleCTM(ctxt, 1.0, -1.0);
+  [NSGraphicsContext saveGraphicsState];
+  NSGraphicsContext.currentContext = [NSGraphicsContext graphicsContextWithCGContext:ctxt flipped:YES];
+  NSRange glyphRange = [_layoutManager glyphRangeForTextContainer:_textContainer];
+  [_layoutManager drawGlyphsForGlyphRange:glyphRange atPoint:NSZeroPoint];
+  [NSGraphicsContext restoreGraphicsState];
+  CGContextRestoreGState(ctxt);
+}
+
+
+- (void)drawInCanvas:(NSBitmapImageRep *)canvas backingScaleFactor:(NSSize)scale
+{
+  if (![self drawInCanvasUsingGlyphAtlas:canvas backingScaleFactor:scale])
+    [super drawInCanvas:canvas backingScaleFactor:scale];
+}
+
+
+- (BOOL)drawInCanvasUsingGlyphAtlas:(NSBitmapImageRep *)canvas backingScaleFactor:(NSSize)scale
+{
+  PTDGlyphAtlas *atlas = PTDTextCanvasObjectGlyphAtlas();
+  if (!atlas)
+    return NO;
+  
+  /* glyphs which do not fit in the atlas take the slow path */
+  __block BOOL fits = YES;
+  [_textStorage enumerateAttribute:NSFontAttributeName inRange:NSMakeRange(0, _textStorage.length) options:0 usingBlock:^(NSFont *font, NSRange range, BOOL *stop) {
+    NSRect bbox = font.boundingRectForFont;
+    if (bbox.size.width * scale.width > _GlyphAtlasSize / 2 || bbox.size.height * scale.height > _GlyphAtlasSize / 2) {
+      fits = NO;
+      *stop = YES;
+    }
+  }];
+  if (!fits)
+    return NO;
+  
+  PTDPixelBuffer canvasBuf = canvas.ptd_pixelBuffer;
+  NSRange glyphRange = [_layoutManager glyphRangeForTextContainer:_textContainer];
+  NSColor *lastColor;
+  uint8_t pixel[4];
+  NSFont *lastFont;
+  uint64_t fontKey = 0;
+  
+  for (NSUInteger i = glyphRange.location; i < NSMaxRange(glyphRange); i++) {
+    if ([_layoutManager propertyForGlyphAtIndex:i] & (NSGlyphPropertyNull | NSGlyphPropertyControlCharacter | NSGlyphPropertyElastic))
+      continue;
+    if ([_layoutManager notShownAttributeForGlyphAtIndex:i])
+      continue;
+    
+    NSUInteger charIndex = [_layoutManager characterIndexForGlyphAtIndex:i];
+    NSFont *font = [_textStorage attribute:NSFontAttributeName atIndex:charIndex effectiveRange:NULL] ?: [NSFont userFontOfSize:0];
+    NSColor *color = [_textStorage attribute:NSForegroundColorAttributeName atIndex:charIndex effectiveRange:NULL] ?: NSColor.textColor;
+    if (font != lastFont) {
+      fontKey = [PTDTextCanvasObject glyphAtlasKeyForFont:font scale:scale];
+      lastFont = font;
+    }
+    if (color != lastColor) {
+      NSColor *fill = [color colorUsingColorSpace:canvas.colorSpace];
+      CGFloat alpha = fill.alphaComponent;
+      pixel[0] = (uint8_t)round([fill redComponent] * alpha * 255.0);
+      pixel[1] = (uint8_t)round([fill greenComponent] * alpha * 255.0);
+      pixel[2] = (uint8_t)round([fill blueComponent] * alpha * 255.0);
+      pixel[3] = (uint8_t)round(alpha * 255.0);
+      lastColor = color;
+    }
+    
+    /* the text container is flipped, the canvas pixels have the first row
+     * on top */
+    NSRect lineRect = [_layoutManager lineFragmentRectForGlyphAtIndex:i effectiveRange:NULL];
+    NSPoint location = [_layoutManager locationForGlyphAtIndex:i];
+    NSPoint pen = NSMakePoint(
+        _containerOrigin.x + lineRect.origin.x + location.x,
+        _containerOrigin.y - lineRect.origin.y - location.y);
+    pen.x *= scale.width;
+    pen.y = canvas.pixelsHigh - pen.y * scale.height;
+    
+    long x = (long)floor(pen.x);
+    long y = (long)round(pen.y);
+    int subpixel = (int)round((pen.x - x) * _GlyphSubpixelSteps);
+    if (subpixel == _GlyphSubpixelSteps) {
+      x++;
+      subpixel = 0;
+    }
+    
+    CGGlyph glyph = [_layoutManager CGGlyphAtIndex:i];
+    uint64_t key = fontKey | ((uint64_t)subpixel << 16) | glyph;
+    const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasLookup(atlas, key);
+    if (!entry) {
+      CGFloat offset = (CGFloat)subpixel / _GlyphSubpixelSteps;
+      entry = PTDTextCanvasObjectRenderGlyph(atlas, key, font, glyph, scale, offset);
+      if (!entry) {
+        PTDGlyphAtlasClear(atlas);
+        entry = PTDTextCanvasObjectRenderGlyph(atlas, key, font, glyph, scale, offset);
+      }
+      if (!entry) {
+        NSLog(@"warning: could not add glyph %d to the atlas", glyph);
+        continue;
+      }
+    }
+    PTDGlyphAtlasComposite(atlas, entry, &canvasBuf, x, y, pixel);
+  }
+  return YES;
+}
+
+
++ (uint64_t)glyphAtlasKeyForFont:(NSFont *)font scale:(NSSize)scale
+{
+  /* the low 24 bits of the glyph keys hold the glyph and its subpixel
+   * position, the rest identifies the font and the scale */
+  static NSMutableDictionary<NSArray *, NSNumber *> *fontKeys;
+  if (!fontKeys)
+    fontKeys = [NSMutableDictionary dictionary];
+  NSArray *fontID = @[font, @(scale.width), @(scale.height)];
+  NSNumber *key = fontKeys[fontID];
+  if (!key) {
+    key = @(fontKeys.count + 1);
+    fontKeys[fontID] = key;
+  }
+  return key.unsignedLongLongValue << 24;
+}
+
+
+@end
@@ -31,6 +31,7 @@
 #import "PTDGraphics.h"
 #import "PTDBrushTool.h"
 #import "PTDToolOptions.h"
+#import "PTDTextCanvasObject.h"
 
 
 NSString * const PTDToolIdentifierTextTool = @"PTDToolIdentifierTextTool";
@@ -79,6 +80,7 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
 @implementation PTDTextTool {
   NSTextView *_textView;
   NSPoint _baselinePivot;
+  NSTextAlignment _editingAlignment;
 }
 
 
@@ -151,8 +153,12 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
 
 - (void)reloadOptions
 {
-  self.fontSize = [[PTDToolOptions.sharedOptions objectForOption:PTDTextToolOptionFontSize ofToolClass:self.class] doubleValue];
-  self.textAlignment = [[PTDToolOptions.sharedOptions objectForOption:PTDTextToolOptionTextAlignment ofToolClass:self.class] integerValue];
+  self.fontSize = [PTDToolOptions.sharedOptions doubleForOption:PTDTextToolOptionFontSize ofToolClass:self.class];
+  NSTextAlignment alignment = [PTDToolOptions.sharedOptions integerForOption:PTDTextToolOptionTextAlignment ofToolClass:self.class];
+  if (alignment != self.textAlignment) {
+    self.textAlignment = alignment;
+    _editingAlignment = alignment;
+  }
   self.color = [PTDToolOptions.sharedOptions objectForOption:PTDBrushToolOptionColor ofToolClass:nil];
   
   self.resolvedFont = [NSFont fontWithName:[self.class baseFontName] size:self.fontSize];
@@ -174,7 +180,11 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
 - (void)mouseClickedAtPoint:(NSPoint)point
 {
   if (!_textView) {
-    [self beginTextEditingAtPoint:point];
+    PTDCanvasObject *object = [self.currentDrawingSurface canvasObjectAtPoint:point];
+    if ([object isKindOfClass:PTDTextCanvasObject.class])
+      [self beginEditingTextObject:(PTDTextCanvasObject *)object];
+    else
+      [self beginTextEditingAtPoint:point];
   } else {
     [self endTextEditing];
   }
@@ -190,6 +200,7 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
   
   point = [_textView.superview ptd_backingAlignedPoint:point];
   _baselinePivot = point;
+  _editingAlignment = self.textAlignment;
   
   _textView.backgroundColor = [NSColor clearColor];
   _textView.drawsBackground = NO;
@@ -214,6 +225,17 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
 }
 
 
+- (void)beginEditingTextObject:(PTDTextCanvasObject *)object
+{
+  [self.currentDrawingSurface removeCanvasObject:object];
+  [self beginTextEditingAtPoint:object.baselinePivot];
+  _editingAlignment = object.alignment;
+  [_textView.textStorage setAttributedString:object.attributedString];
+  _textView.selectedRange = NSMakeRange(_textView.string.length, 0);
+  [self updateTextViewFrame];
+}
+
+
 - (void)textDidChange:(NSNotification *)notification
 {
   [self updateTextViewFrame];
@@ -228,7 +250,7 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
     /* We finish setting up the text view now otherwise the initial caret
      * positioning and baseline are screwed up.
      *   Empty text fields are hard... I guess? */
-    _textView.alignment = self.textAlignment;
+    _textView.alignment = _editingAlignment;
     _textView.textContainer.heightTracksTextView = NO;
     _textView.textContainer.widthTracksTextView = NO;
     _textView.horizontallyResizable = YES;
@@ -273,16 +295,12 @@ NSString * const PTDTextToolOptionTextAlignment = @"textAlignment";
 {
   _textView.insertionPointColor = NSColor.clearColor;
   _textView.selectedRange = NSMakeRange(0, 0);
-  NSRect theRect = _textView.bounds;
-  NSBitmapImageRep *tempImage = [_textView bitmapImageRepForCachingDisplayInRect:theRect];
-  [_textView cacheDisplayInRect:_textView.bounds toBitmapImageRep:tempImage];
   
-  [self.currentDrawingSurface beginCanvasDrawing];
-  NSRect pixRect;
-  pixRect.origin = _textView.frame.origin;
-  pixRect.size = tempImage.size;
-  [tempImage drawInRect:pixRect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0 respectFlipped:YES hints:nil];
-  [self.currentDrawingSurface endCanvasDrawing];
+  /* the text stays editable until something else is drawn on the canvas */
+  if (_textView.string.length > 0) {
+    PTDTextCanvasObject *object = [[PTDTextCanvasObject alloc] initWithTextView:_textView baselinePivot:_baselinePivot];
+    [self.currentDrawingSurface addCanvasObject:object];
+  }
   
   [self.currentDrawingSurface endTextEditing:_textView];
   _textView = nil;
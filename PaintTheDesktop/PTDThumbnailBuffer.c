@@ -0,0 +1,221 @@
+//
+// PTDThumbnailBuffer.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "PTDThumbnailBuffer.h"
+#include "PTDBufferPool.h"
+
+
+/* in thumbnail rows */
+#define BAND_HEIGHT 16
+
+
+struct PTDThumbnailBuffer {
+  size_t canvasWidth;
+  size_t canvasHeight;
+  size_t width;
+  size_t height;
+  size_t factor;
+  /* guards the pixels, which are updated off the thread reading them */
+  pthread_mutex_t lock;
+  uint8_t *pixels;
+};
+
+
+PTDThumbnailBuffer *PTDThumbnailBufferCreate(size_t canvasWidth, size_t canvasHeight, size_t maximumArea)
+{
+  PTDThumbnailBuffer *thumb = calloc(1, sizeof(PTDThumbnailBuffer));
+  if (!thumb)
+    return NULL;
+  thumb->canvasWidth = canvasWidth > 0 ? canvasWidth : 1;
+  thumb->canvasHeight = canvasHeight > 0 ? canvasHeight : 1;
+  double ratio = (double)(thumb->canvasWidth * thumb->canvasHeight) / (double)(maximumArea > 0 ? maximumArea : 1);
+  thumb->factor = ratio > 1.0 ? (size_t)ceil(sqrt(ratio)) : 1;
+  thumb->width = (thumb->canvasWidth + thumb->factor - 1) / thumb->factor;
+  thumb->height = (thumb->canvasHeight + thumb->factor - 1) / thumb->factor;
+  thumb->pixels = calloc(thumb->width * thumb->height, 4);
+  if (!thumb->pixels) {
+    free(thumb);
+    return NULL;
+  }
+  pthread_mutex_init(&thumb->lock, NULL);
+  return thumb;
+}
+
+
+void PTDThumbnailBufferDestroy(PTDThumbnailBuffer *thumb)
+{
+  if (!thumb)
+    return;
+  pthread_mutex_destroy(&thumb->lock);
+  free(thumb->pixels);
+  free(thumb);
+}
+
+
+size_t PTDThumbnailBufferWidth(const PTDThumbnailBuffer *thumb)
+{
+  return thumb->width;
+}
+
+
+size_t PTDThumbnailBufferHeight(const PTDThumbnailBuffer *thumb)
+{
+  return thumb->height;
+}
+
+
+size_t PTDThumbnailBufferFactor(const PTDThumbnailBuffer *thumb)
+{
+  return thumb->factor;
+}
+
+
+void PTDThumbnailBoxFilter(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, size_t factor)
+{
+  const uint8_t *srcData = src->data;
+  uint8_t *dstData = dst->data;
+  
+  for (size_t ty = 0; ty < dst->height; ty++) {
+    size_t sy0 = ty * factor;
+    size_t sy1 = sy0 + factor < src->height ? sy0 + factor : src->height;
+    uint8_t *dstRow = dstData + ty * dst->bytesPerRow;
+    
+    for (size_t tx = 0; tx < dst->width; tx++) {
+      size_t sx0 = tx * factor;
+      size_t sx1 = sx0 + factor < src->width ? sx0 + factor : src->width;
+      
+      uint32_t acc[4] = {0, 0, 0, 0};
+      for (size_t sy = sy0; sy < sy1; sy++) {
+        const uint8_t *px = srcData + sy * src->bytesPerRow + sx0 * 4;
+        const uint8_t *end = px + (sx1 - sx0) * 4;
+        for (; px < end; px += 4) {
+          acc[0] += px[0];
+          acc[1] += px[1];
+          acc[2] += px[2];
+          acc[3] += px[3];
+        }
+      }
+      
+      uint32_t n = (uint32_t)((sy1 - sy0) * (sx1 - sx0));
+      for (int c = 0; c < 4; c++)
+        dstRow[tx * 4 + c] = n ? (uint8_t)((acc[c] + n / 2) / n) : 0;
+    }
+  }
+}
+
+
+static void PTDThumbnailBufferClear(PTDThumbnailBuffer *thumb, size_t x0, size_t y0, size_t x1, size_t y1, size_t cx0, size_t cy0, size_t cx1, size_t cy1)
+{
+  pthread_mutex_lock(&thumb->lock);
+  for (size_t y = y0; y < y1; y++) {
+    uint8_t *row = thumb->pixels + y * thumb->width * 4;
+    if (y < cy0 || y >= cy1) {
+      memset(row + x0 * 4, 0, (x1 - x0) * 4);
+    } else {
+      memset(row + x0 * 4, 0, (cx0 - x0) * 4);
+      memset(row + cx1 * 4, 0, (x1 - cx1) * 4);
+    }
+  }
+  pthread_mutex_unlock(&thumb->lock);
+}
+
+
+int PTDThumbnailBufferUpdate(PTDThumbnailBuffer *thumb, const PTDCanvasFrame *frame, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+  if (PTDCanvasFrameWidth(frame) != thumb->canvasWidth || PTDCanvasFrameHeight(frame) != thumb->canvasHeight)
+    return 0;
+  size_t factor = thumb->factor;
+  if (x1 > thumb->width)
+    x1 = thumb->width;
+  if (y1 > thumb->height)
+    y1 = thumb->height;
+  if (x0 >= x1 || y0 >= y1)
+    return 1;
+  
+  /* everything outside of the content of the frame is transparent */
+  size_t fx0, fy0, fx1, fy1;
+  PTDCanvasFrameContentBounds(frame, &fx0, &fy0, &fx1, &fy1);
+  size_t cx0 = fx0 / factor > x0 ? fx0 / factor : x0;
+  size_t cy0 = fy0 / factor > y0 ? fy0 / factor : y0;
+  size_t cx1 = (fx1 + factor - 1) / factor < x1 ? (fx1 + factor - 1) / factor : x1;
+  size_t cy1 = (fy1 + factor - 1) / factor < y1 ? (fy1 + factor - 1) / factor : y1;
+  if (cx0 >= cx1 || cy0 >= cy1) {
+    cx0 = cx1 = x0;
+    cy0 = cy1 = y0;
+  }
+  PTDThumbnailBufferClear(thumb, x0, y0, x1, y1, cx0, cy0, cx1, cy1);
+  if (cx0 >= cx1 || cy0 >= cy1)
+    return 1;
+  
+  /* Copy the canvas in bands of rows, so that the scratch buffers stay
+   * small; bands start on a multiple of the factor, and so does the copy */
+  size_t srcX0 = cx0 * factor;
+  size_t srcX1 = cx1 * factor < thumb->canvasWidth ? cx1 * factor : thumb->canvasWidth;
+  size_t srcWidth = srcX1 - srcX0;
+  size_t dstWidth = cx1 - cx0;
+  size_t bandHeight = cy1 - cy0 < BAND_HEIGHT ? cy1 - cy0 : BAND_HEIGHT;
+  size_t srcSize = srcWidth * bandHeight * factor * 4;
+  size_t dstSize = dstWidth * bandHeight * 4;
+  uint8_t *src = PTDBufferPoolAlloc(srcSize);
+  uint8_t *dst = PTDBufferPoolAlloc(dstSize);
+  if (!src || !dst) {
+    PTDBufferPoolFree(src, srcSize);
+    PTDBufferPoolFree(dst, dstSize);
+    return 0;
+  }
+  
+  for (size_t band = cy0; band < cy1; band += bandHeight) {
+    size_t rows = cy1 - band < bandHeight ? cy1 - band : bandHeight;
+    size_t srcY0 = band * factor;
+    size_t srcY1 = (band + rows) * factor < thumb->canvasHeight ? (band + rows) * factor : thumb->canvasHeight;
+    PTDPixelBuffer srcBuffer = {src, srcWidth, srcY1 - srcY0, srcWidth * 4};
+    PTDPixelBuffer dstBuffer = {dst, dstWidth, rows, dstWidth * 4};
+    PTDCanvasFrameCopyPixels(frame, srcX0, srcY0, &srcBuffer);
+    PTDThumbnailBoxFilter(&srcBuffer, &dstBuffer, factor);
+    
+    pthread_mutex_lock(&thumb->lock);
+    for (size_t y = 0; y < rows; y++)
+      memcpy(thumb->pixels + ((band + y) * thumb->width + cx0) * 4, dst + y * dstWidth * 4, dstWidth * 4);
+    pthread_mutex_unlock(&thumb->lock);
+  }
+  
+  PTDBufferPoolFree(src, srcSize);
+  PTDBufferPoolFree(dst, dstSize);
+  return 1;
+}
+
+
+void PTDThumbnailBufferCopyPixels(PTDThumbnailBuffer *thumb, const PTDPixelBuffer *dst)
+{
+  uint8_t *dstData = dst->data;
+  pthread_mutex_lock(&thumb->lock);
+  for (size_t y = 0; y < thumb->height; y++)
+    memcpy(dstData + y * dst->bytesPerRow, thumb->pixels + y * thumb->width * 4, thumb->width * 4);
+  pthread_mutex_unlock(&thumb->lock);
+}
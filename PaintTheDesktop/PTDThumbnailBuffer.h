@@ -0,0 +1,70 @@
+//
+// PTDThumbnailBuffer.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDThumbnailBuffer_h
+#define PTDThumbnailBuffer_h
+
+#include <stddef.h>
+#include "PTDCanvasStore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The pixels of a box-filtered, integer-factor downsampling of a canvas,
+ * which are brought up to date from frames of a canvas store one region at
+ * a time. Each thumbnail pixel is the rounded average of a square of
+ * factor by factor canvas pixels, clipped to the canvas. Updates must not
+ * overlap each other, but the pixels can be copied from any thread at any
+ * time. */
+typedef struct PTDThumbnailBuffer PTDThumbnailBuffer;
+
+/* The factor is the smallest one which makes the thumbnail no larger than
+ * the given area. The thumbnail starts out fully transparent. */
+PTDThumbnailBuffer *PTDThumbnailBufferCreate(size_t canvasWidth, size_t canvasHeight, size_t maximumArea);
+void PTDThumbnailBufferDestroy(PTDThumbnailBuffer *thumb);
+
+size_t PTDThumbnailBufferWidth(const PTDThumbnailBuffer *thumb);
+size_t PTDThumbnailBufferHeight(const PTDThumbnailBuffer *thumb);
+size_t PTDThumbnailBufferFactor(const PTDThumbnailBuffer *thumb);
+
+/* Resamples a rect of the thumbnail, in thumbnail pixels, from a frame
+ * which has the size of the canvas. Only the content of the frame is read;
+ * the rest of the region is cleared. Returns zero if the frame has the
+ * wrong size or the scratch buffers cannot be allocated. */
+int PTDThumbnailBufferUpdate(PTDThumbnailBuffer *thumb, const PTDCanvasFrame *frame, size_t x0, size_t y0, size_t x1, size_t y1);
+
+/* Copies all the pixels of the thumbnail into a buffer of the same size. */
+void PTDThumbnailBufferCopyPixels(PTDThumbnailBuffer *thumb, const PTDPixelBuffer *dst);
+
+/* The reference filter. Each pixel of the destination is resampled from
+ * the source starting at (factor * x, factor * y). */
+void PTDThumbnailBoxFilter(const PTDPixelBuffer *src, const PTDPixelBuffer *dst, size_t factor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDThumbnailBuffer_h */
@@ -58,6 +58,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)willOpenOptionMenuAtPoint:(NSPoint)point;
 - (nullable PTDRingMenuRing *)optionMenu;
+/* NO if the option menu only depends on the tool options, in which
+ * case it is reused until the options change. */
+@property (nonatomic, readonly) BOOL optionMenuDependsOnToolState;
 
 - (void)reloadOptions;
 
@@ -29,9 +29,12 @@
 #import "PTDUtils.h"
 
 
-@implementation PTDTool {
-  id _optionsChangedObserver;
-}
+@interface PTDTool () <PTDToolOptionsSubscriber>
+
+@end
+
+
+@implementation PTDTool
 
 
 + (void)registerDefaults
@@ -42,26 +45,26 @@
 - (instancetype)init
 {
   self = [super init];
-  
-  NSNotificationCenter *nc = [NSNotificationCenter defaultCenter];
-  _optionsChangedObserver= [nc addObserverForName:PTDToolOptionsChangedNotification
-      object:PTDToolOptions.sharedOptions
-      queue:nil usingBlock:^(NSNotification * _Nonnull note) {
-    PTDTool *otherTool = [note.userInfo objectForKey:PTDToolOptionsChangedNotificationUserInfoToolKey];
-    if (!otherTool || [self isKindOfClass:[otherTool class]])
-      [self reloadOptions];
-  }];
-  
-  [self reloadOptions];
-  
+  [self _reloadOptionsAndSubscribe];
   return self;
 }
 
 
-- (void)dealloc
+- (void)_reloadOptionsAndSubscribe
 {
-  NSNotificationCenter *nc = [NSNotificationCenter defaultCenter];
-  [nc removeObserver:_optionsChangedObserver];
+  /* The tool is notified only of changes to the options it actually
+   * read the last time it reloaded them */
+  PTDToolOptions *o = PTDToolOptions.sharedOptions;
+  [o beginRecordingAccessedKeys];
+  [self reloadOptions];
+  NSIndexSet *keys = [o endRecordingAccessedKeys];
+  [o subscribe:self toKeys:keys];
+}
+
+
+- (void)toolOptions:(PTDToolOptions *)options didChangeOptionWithKey:(PTDToolOptionKey)key
+{
+  [self _reloadOptionsAndSubscribe];
 }
 
 
@@ -123,6 +126,12 @@
 }
 
 
+- (BOOL)optionMenuDependsOnToolState
+{
+  return NO;
+}
+
+
 - (void)reloadOptions
 {
 }
@@ -35,6 +35,7 @@
 #import "PTDLineTool.h"
 #import "PTDToolOptions.h"
 #import "PTDTextTool.h"
+#import "PTDBucketTool.h"
 
 
 NSString * const PTDToolManagerOptionToolIdentifier = @"toolId";
@@ -63,6 +64,7 @@ NSString * const PTDToolManagerOptionToolIdentifier = @"toolId";
     PTDToolIdentifierOvalTool,
     PTDToolIdentifierRoundRectTool,
     PTDToolIdentifierTextTool,
+    PTDToolIdentifierBucketTool,
     PTDToolIdentifierSelectionTool,
     PTDToolIdentifierResetTool
   ];
@@ -79,6 +81,7 @@ NSString * const PTDToolManagerOptionToolIdentifier = @"toolId";
     PTDToolIdentifierOvalTool: [PTDOvalTool class],
     PTDToolIdentifierRoundRectTool: [PTDRoundRectTool class],
     PTDToolIdentifierTextTool: [PTDTextTool class],
+    PTDToolIdentifierBucketTool: [PTDBucketTool class],
     PTDToolIdentifierSelectionTool: [PTDSelectionTool class],
     PTDToolIdentifierResetTool: [PTDResetTool class]
   };
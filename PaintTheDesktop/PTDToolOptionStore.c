@@ -0,0 +1,392 @@
+//
+// PTDToolOptionStore.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "PTDToolOptionStore.h"
+
+
+typedef struct {
+  uintptr_t scope;
+  char *name;
+  uint64_t hash;
+  PTDToolOptionValue value;
+  int hasValue;
+  int changed;
+  /* handles of the subscribers, in the order they subscribed */
+  uint32_t *subscribers;
+  size_t subscriberCount;
+  size_t subscriberCapacity;
+} PTDToolOptionStoreOption;
+
+typedef struct {
+  int used;
+  size_t *keys;
+  size_t keyCount;
+  size_t keyCapacity;
+} PTDToolOptionStoreSubscriber;
+
+struct PTDToolOptionStore {
+  const void *(*retain)(const void *object);
+  void (*release)(const void *object);
+  
+  PTDToolOptionStoreOption *options;
+  size_t count;
+  size_t capacity;
+  /* open addressing hash table of option keys plus one; zero is empty */
+  size_t *table;
+  size_t tableSize;
+  size_t changeCount;
+  
+  /* indexed by handle */
+  PTDToolOptionStoreSubscriber *subscribers;
+  size_t subscriberCount;
+  size_t subscriberCapacity;
+};
+
+
+void PTDToolOptionSubscriberListFree(PTDToolOptionSubscriberList *list)
+{
+  free(list->handles);
+  list->handles = NULL;
+  list->count = 0;
+  list->capacity = 0;
+}
+
+
+PTDToolOptionStore *PTDToolOptionStoreCreate(const void *(*retain)(const void *object), void (*release)(const void *object))
+{
+  PTDToolOptionStore *store = calloc(1, sizeof(PTDToolOptionStore));
+  if (!store)
+    return NULL;
+  store->retain = retain;
+  store->release = release;
+  return store;
+}
+
+
+void PTDToolOptionStoreDestroy(PTDToolOptionStore *store)
+{
+  if (!store)
+    return;
+  for (size_t i = 0; i < store->count; i++) {
+    PTDToolOptionStoreResetValue(store, i);
+    free(store->options[i].name);
+    free(store->options[i].subscribers);
+  }
+  for (size_t i = 0; i < store->subscriberCount; i++)
+    free(store->subscribers[i].keys);
+  free(store->options);
+  free(store->table);
+  free(store->subscribers);
+  free(store);
+}
+
+
+#pragma mark - Keys
+
+
+static uint64_t PTDToolOptionStoreHash(uintptr_t scope, const char *name)
+{
+  /* FNV-1a of the name, then mixed with the scope */
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const unsigned char *c = (const unsigned char *)name; *c; c++) {
+    hash ^= *c;
+    hash *= 0x100000001b3ULL;
+  }
+  hash ^= (uint64_t)scope;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+
+static size_t PTDToolOptionStoreFindWithHash(const PTDToolOptionStore *store, uintptr_t scope, const char *name, uint64_t hash)
+{
+  if (!store->table)
+    return PTD_TOOL_OPTION_NOT_FOUND;
+  size_t mask = store->tableSize - 1;
+  for (size_t i = (size_t)hash & mask; store->table[i]; i = (i + 1) & mask) {
+    const PTDToolOptionStoreOption *option = &store->options[store->table[i] - 1];
+    if (option->hash == hash && option->scope == scope && strcmp(option->name, name) == 0)
+      return store->table[i] - 1;
+  }
+  return PTD_TOOL_OPTION_NOT_FOUND;
+}
+
+
+static int PTDToolOptionStoreGrowTable(PTDToolOptionStore *store)
+{
+  size_t tableSize = store->tableSize ? store->tableSize * 2 : 64;
+  size_t *table = calloc(tableSize, sizeof(size_t));
+  if (!table)
+    return 0;
+  for (size_t key = 0; key < store->count; key++) {
+    size_t i = (size_t)store->options[key].hash & (tableSize - 1);
+    while (table[i])
+      i = (i + 1) & (tableSize - 1);
+    table[i] = key + 1;
+  }
+  free(store->table);
+  store->table = table;
+  store->tableSize = tableSize;
+  return 1;
+}
+
+
+size_t PTDToolOptionStoreIntern(PTDToolOptionStore *store, uintptr_t scope, const char *name)
+{
+  uint64_t hash = PTDToolOptionStoreHash(scope, name);
+  size_t key = PTDToolOptionStoreFindWithHash(store, scope, name, hash);
+  if (key != PTD_TOOL_OPTION_NOT_FOUND)
+    return key;
+  
+  /* keeps the table at most half full */
+  if ((store->count + 1) * 2 > store->tableSize && !PTDToolOptionStoreGrowTable(store))
+    return PTD_TOOL_OPTION_NOT_FOUND;
+  if (store->count == store->capacity) {
+    size_t capacity = store->capacity ? store->capacity * 2 : 32;
+    PTDToolOptionStoreOption *options = realloc(store->options, capacity * sizeof(PTDToolOptionStoreOption));
+    if (!options)
+      return PTD_TOOL_OPTION_NOT_FOUND;
+    store->options = options;
+    store->capacity = capacity;
+  }
+  size_t length = strlen(name);
+  char *copy = malloc(length + 1);
+  if (!copy)
+    return PTD_TOOL_OPTION_NOT_FOUND;
+  memcpy(copy, name, length + 1);
+  
+  key = store->count++;
+  store->options[key] = (PTDToolOptionStoreOption){.scope = scope, .name = copy, .hash = hash};
+  size_t i = (size_t)hash & (store->tableSize - 1);
+  while (store->table[i])
+    i = (i + 1) & (store->tableSize - 1);
+  store->table[i] = key + 1;
+  return key;
+}
+
+
+size_t PTDToolOptionStoreFind(const PTDToolOptionStore *store, uintptr_t scope, const char *name)
+{
+  return PTDToolOptionStoreFindWithHash(store, scope, name, PTDToolOptionStoreHash(scope, name));
+}
+
+
+size_t PTDToolOptionStoreCount(const PTDToolOptionStore *store)
+{
+  return store->count;
+}
+
+
+#pragma mark - Values
+
+
+const PTDToolOptionValue *PTDToolOptionStoreValue(const PTDToolOptionStore *store, size_t key)
+{
+  const PTDToolOptionStoreOption *option = &store->options[key];
+  return option->hasValue ? &option->value : NULL;
+}
+
+
+void PTDToolOptionStoreLoadValue(PTDToolOptionStore *store, size_t key, const PTDToolOptionValue *value)
+{
+  PTDToolOptionStoreOption *option = &store->options[key];
+  /* retained first, the value may be the same object */
+  if (value->object && store->retain)
+    store->retain(value->object);
+  if (option->hasValue && option->value.object && store->release)
+    store->release(option->value.object);
+  option->value = *value;
+  option->hasValue = 1;
+}
+
+
+void PTDToolOptionStoreSetValue(PTDToolOptionStore *store, size_t key, const PTDToolOptionValue *value)
+{
+  PTDToolOptionStoreLoadValue(store, key, value);
+  PTDToolOptionStoreOption *option = &store->options[key];
+  if (!option->changed) {
+    option->changed = 1;
+    store->changeCount++;
+  }
+}
+
+
+void PTDToolOptionStoreResetValue(PTDToolOptionStore *store, size_t key)
+{
+  PTDToolOptionStoreOption *option = &store->options[key];
+  if (option->hasValue && option->value.object && store->release)
+    store->release(option->value.object);
+  option->value = (PTDToolOptionValue){0};
+  option->hasValue = 0;
+  if (option->changed) {
+    option->changed = 0;
+    store->changeCount--;
+  }
+}
+
+
+void PTDToolOptionStoreTakeChanges(PTDToolOptionStore *store, void (*function)(void *context, size_t key), void *context)
+{
+  for (size_t key = 0; key < store->count && store->changeCount > 0; key++) {
+    PTDToolOptionStoreOption *option = &store->options[key];
+    if (!option->changed)
+      continue;
+    option->changed = 0;
+    store->changeCount--;
+    function(context, key);
+  }
+}
+
+
+int PTDToolOptionStoreHasChanges(const PTDToolOptionStore *store)
+{
+  return store->changeCount > 0;
+}
+
+
+#pragma mark - Subscribers
+
+
+uint32_t PTDToolOptionStoreAddSubscriber(PTDToolOptionStore *store)
+{
+  for (size_t i = 0; i < store->subscriberCount; i++) {
+    if (!store->subscribers[i].used) {
+      store->subscribers[i].used = 1;
+      return (uint32_t)i;
+    }
+  }
+  if (store->subscriberCount >= UINT32_MAX)
+    return UINT32_MAX;
+  if (store->subscriberCount == store->subscriberCapacity) {
+    size_t capacity = store->subscriberCapacity ? store->subscriberCapacity * 2 : 16;
+    PTDToolOptionStoreSubscriber *subscribers = realloc(store->subscribers, capacity * sizeof(PTDToolOptionStoreSubscriber));
+    if (!subscribers)
+      return UINT32_MAX;
+    store->subscribers = subscribers;
+    store->subscriberCapacity = capacity;
+  }
+  store->subscribers[store->subscriberCount] = (PTDToolOptionStoreSubscriber){.used = 1};
+  return (uint32_t)store->subscriberCount++;
+}
+
+
+/* Takes the subscriber out of the lists of the options it is subscribed
+ * to, keeping the order of the others */
+static void PTDToolOptionStoreUnsubscribe(PTDToolOptionStore *store, uint32_t handle)
+{
+  PTDToolOptionStoreSubscriber *subscriber = &store->subscribers[handle];
+  for (size_t i = 0; i < subscriber->keyCount; i++) {
+    PTDToolOptionStoreOption *option = &store->options[subscriber->keys[i]];
+    for (size_t j = 0; j < option->subscriberCount; j++) {
+      if (option->subscribers[j] != handle)
+        continue;
+      memmove(&option->subscribers[j], &option->subscribers[j + 1], (option->subscriberCount - j - 1) * sizeof(uint32_t));
+      option->subscriberCount--;
+      break;
+    }
+  }
+  subscriber->keyCount = 0;
+}
+
+
+void PTDToolOptionStoreRemoveSubscriber(PTDToolOptionStore *store, uint32_t handle)
+{
+  if (handle >= store->subscriberCount || !store->subscribers[handle].used)
+    return;
+  PTDToolOptionStoreUnsubscribe(store, handle);
+  PTDToolOptionStoreSubscriber *subscriber = &store->subscribers[handle];
+  free(subscriber->keys);
+  *subscriber = (PTDToolOptionStoreSubscriber){0};
+}
+
+
+int PTDToolOptionStoreSubscribe(PTDToolOptionStore *store, uint32_t handle, const size_t *keys, size_t count)
+{
+  if (handle >= store->subscriberCount || !store->subscribers[handle].used)
+    return 0;
+  /* the tools subscribe again every time they reload their options, which
+   * mostly leaves the keys as they were */
+  PTDToolOptionStoreSubscriber *subscriber = &store->subscribers[handle];
+  if (count == subscriber->keyCount && (count == 0 || memcmp(keys, subscriber->keys, count * sizeof(size_t)) == 0))
+    return 1;
+  PTDToolOptionStoreUnsubscribe(store, handle);
+  
+  /* all the memory is allocated first, so that a failure leaves nothing
+   * half done */
+  if (count > subscriber->keyCapacity) {
+    size_t *subscribedKeys = realloc(subscriber->keys, count * sizeof(size_t));
+    if (!subscribedKeys)
+      return 0;
+    subscriber->keys = subscribedKeys;
+    subscriber->keyCapacity = count;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (keys[i] >= store->count)
+      continue;
+    PTDToolOptionStoreOption *option = &store->options[keys[i]];
+    if (option->subscriberCount < option->subscriberCapacity)
+      continue;
+    size_t capacity = option->subscriberCapacity ? option->subscriberCapacity * 2 : 8;
+    uint32_t *handles = realloc(option->subscribers, capacity * sizeof(uint32_t));
+    if (!handles)
+      return 0;
+    option->subscribers = handles;
+    option->subscriberCapacity = capacity;
+  }
+  
+  for (size_t i = 0; i < count; i++) {
+    if (keys[i] >= store->count)
+      continue;
+    PTDToolOptionStoreOption *option = &store->options[keys[i]];
+    /* the subscriber was taken out of every list, so it can only be last
+     * in one if the key was given twice */
+    if (option->subscriberCount > 0 && option->subscribers[option->subscriberCount - 1] == handle)
+      continue;
+    option->subscribers[option->subscriberCount++] = handle;
+    subscriber->keys[subscriber->keyCount++] = keys[i];
+  }
+  return 1;
+}
+
+
+int PTDToolOptionStoreCopySubscribers(const PTDToolOptionStore *store, size_t key, PTDToolOptionSubscriberList *list)
+{
+  const PTDToolOptionStoreOption *option = &store->options[key];
+  if (option->subscriberCount > list->capacity) {
+    uint32_t *handles = realloc(list->handles, option->subscriberCount * sizeof(uint32_t));
+    if (!handles)
+      return 0;
+    list->handles = handles;
+    list->capacity = option->subscriberCount;
+  }
+  if (option->subscriberCount > 0)
+    memcpy(list->handles, option->subscribers, option->subscriberCount * sizeof(uint32_t));
+  list->count = option->subscriberCount;
+  return 1;
+}
@@ -0,0 +1,110 @@
+//
+// PTDToolOptionStore.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDToolOptionStore_h
+#define PTDToolOptionStore_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PTD_TOOL_OPTION_NOT_FOUND SIZE_MAX
+
+/* The cached value of an option, in the forms it is read in. The object is
+ * owned through the callbacks of the store. */
+typedef struct {
+  const void *object;
+  int64_t integer;
+  double real;
+} PTDToolOptionValue;
+
+/* Handles of the subscribers returned by a fan-out */
+typedef struct {
+  uint32_t *handles;
+  size_t count;
+  size_t capacity;
+} PTDToolOptionSubscriberList;
+
+void PTDToolOptionSubscriberListFree(PTDToolOptionSubscriberList *list);
+
+/* The options of the tools, interned into consecutive integer keys, with
+ * their cached values and the subscribers to their changes.
+ *
+ * An option is named by a scope, such as the tool it belongs to or zero for
+ * the global ones, and by a string. Interning the same name again returns
+ * the same key, which stays valid for the lifetime of the store. Lookups by
+ * key are array accesses; lookups by name hash the string once.
+ *
+ * Subscribers are identified by small integer handles. Each one is
+ * subscribed to a set of keys, and a change fans out only to the
+ * subscribers of the key changed. Not thread safe. */
+typedef struct PTDToolOptionStore PTDToolOptionStore;
+
+/* The callbacks retain and release the objects of the values; either can
+ * be NULL. */
+PTDToolOptionStore *PTDToolOptionStoreCreate(const void *(*retain)(const void *object), void (*release)(const void *object));
+void PTDToolOptionStoreDestroy(PTDToolOptionStore *store);
+
+/* Returns PTD_TOOL_OPTION_NOT_FOUND if memory cannot be allocated. */
+size_t PTDToolOptionStoreIntern(PTDToolOptionStore *store, uintptr_t scope, const char *name);
+size_t PTDToolOptionStoreFind(const PTDToolOptionStore *store, uintptr_t scope, const char *name);
+size_t PTDToolOptionStoreCount(const PTDToolOptionStore *store);
+
+/* Returns NULL if the option has no value cached. */
+const PTDToolOptionValue *PTDToolOptionStoreValue(const PTDToolOptionStore *store, size_t key);
+/* Caches the value without marking it as changed, as when it is loaded. */
+void PTDToolOptionStoreLoadValue(PTDToolOptionStore *store, size_t key, const PTDToolOptionValue *value);
+/* Caches the value and marks the option as changed, until the changed
+ * options are taken for persistence. */
+void PTDToolOptionStoreSetValue(PTDToolOptionStore *store, size_t key, const PTDToolOptionValue *value);
+/* Drops the cached value, and the change if it was not taken yet. */
+void PTDToolOptionStoreResetValue(PTDToolOptionStore *store, size_t key);
+
+/* Calls the function with each option changed since the last call, in
+ * order of key, and clears the changes. */
+void PTDToolOptionStoreTakeChanges(PTDToolOptionStore *store, void (*function)(void *context, size_t key), void *context);
+int PTDToolOptionStoreHasChanges(const PTDToolOptionStore *store);
+
+/* Returns a new handle, or UINT32_MAX if memory cannot be allocated. The
+ * handles of removed subscribers are reused. */
+uint32_t PTDToolOptionStoreAddSubscriber(PTDToolOptionStore *store);
+void PTDToolOptionStoreRemoveSubscriber(PTDToolOptionStore *store, uint32_t handle);
+/* Replaces the keys the subscriber is subscribed to; subscribing again to
+ * the same keys changes nothing. Returns 0, leaving the subscriber with no
+ * keys, if memory cannot be allocated. */
+int PTDToolOptionStoreSubscribe(PTDToolOptionStore *store, uint32_t handle, const size_t *keys, size_t count);
+/* Copies the subscribers of the key, in the order they subscribed to it, so
+ * that they can subscribe again while they are being notified. Returns 0 if
+ * memory cannot be allocated. */
+int PTDToolOptionStoreCopySubscribers(const PTDToolOptionStore *store, size_t key, PTDToolOptionSubscriberList *list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTDToolOptionStore_h */
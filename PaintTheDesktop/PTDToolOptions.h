@@ -28,6 +28,7 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @class PTDTool;
+@class PTDToolOptions;
 
 extern NSString * const PTDToolOptionsChangedNotification;
 
@@ -37,6 +38,18 @@ extern NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey;
 
 typedef BOOL (^PTDValidationBlock)(id value);
 
+/* Options are interned on registration; a key stays valid for the
+ * lifetime of the option store. */
+typedef NSUInteger PTDToolOptionKey;
+
+extern const PTDToolOptionKey PTDToolOptionKeyNotFound;
+
+@protocol PTDToolOptionsSubscriber <NSObject>
+
+- (void)toolOptions:(PTDToolOptions *)options didChangeOptionWithKey:(PTDToolOptionKey)key;
+
+@end
+
 @interface PTDToolOptions : NSObject
 
 + (PTDToolOptions *)sharedOptions;
@@ -44,10 +57,32 @@ typedef BOOL (^PTDValidationBlock)(id value);
 - (void)registerGlobalOption:(NSString *)optionId types:(NSArray <Class> *)clss defaultValue:(id)value validationBlock:(nullable PTDValidationBlock)valid;
 - (void)registerOption:(NSString *)optionId ofToolClass:(nullable Class)toolClass types:(NSArray <Class> *)clss defaultValue:(id)value validationBlock:(nullable PTDValidationBlock)valid;
 
+- (PTDToolOptionKey)keyForOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
+
 - (void)setObject:(id)object forOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
+- (void)setObject:(id)object forKey:(PTDToolOptionKey)key;
 - (void)restoreDefaultForOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
 
 - (id)objectForOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
+- (id)objectForKey:(PTDToolOptionKey)key;
+
+- (NSInteger)integerForOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
+- (double)doubleForOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
+- (BOOL)boolForOption:(NSString *)optionId ofToolClass:(nullable Class)tool;
+
+/* Subscribers are referenced weakly and are notified only of changes to
+ * the options they are subscribed to. Subscribing again replaces the
+ * previous set of keys. */
+- (void)subscribe:(id <PTDToolOptionsSubscriber>)subscriber toKeys:(NSIndexSet *)keys;
+- (void)unsubscribe:(id <PTDToolOptionsSubscriber>)subscriber;
+
+/* Collects the keys of all the options read between the two calls. */
+- (void)beginRecordingAccessedKeys;
+- (NSIndexSet *)endRecordingAccessedKeys;
+
+/* Changes are written to the user defaults in the background shortly
+ * after they are made; this writes out any pending change immediately. */
+- (void)synchronize;
 
 @end
 
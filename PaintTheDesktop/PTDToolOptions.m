@@ -25,6 +25,8 @@
 
 #import "PTDToolOptions.h"
 #import "PTDTool.h"
+#import "PTDBlockTask.h"
+#import "PTDToolOptionStore.h"
 
 
 NSString * const PTDToolOptionsChangedNotification = @"PTDToolOptionsChangedNotification";
@@ -33,9 +35,47 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoOptionKey = @"option";
 NSString * const PTDToolOptionsChangedNotificationUserInfoToolKey = @"tool";
 NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
 
+const PTDToolOptionKey PTDToolOptionKeyNotFound = NSNotFound;
+
+static const NSTimeInterval _PersistenceDelay = 1.0;
+
+
+static const void *PTDToolOptionsRetainObject(const void *object)
+{
+  return CFRetain(object);
+}
+
+
+static void PTDToolOptionsReleaseObject(const void *object)
+{
+  CFRelease(object);
+}
+
+
+static PTDToolOptionValue PTDToolOptionsValueWithObject(id object)
+{
+  PTDToolOptionValue value = {(__bridge const void *)object, 0, 0.0};
+  if ([object isKindOfClass:[NSNumber class]]) {
+    value.integer = [object integerValue];
+    value.real = [object doubleValue];
+  }
+  return value;
+}
+
+
+static void PTDToolOptionsAddChangedKey(void *context, size_t key)
+{
+  [(__bridge NSMutableIndexSet *)context addIndex:key];
+}
+
 
 @interface PTDToolOptionData: NSObject
 
+@property (nonatomic) PTDToolOptionKey key;
+@property (nonatomic) NSString *optionId;
+@property (nonatomic, nullable) Class toolClass;
+@property (nonatomic) NSString *defaultsKey;
+
 @property (nonatomic) id defaultValue;
 @property (nonatomic) NSSet <Class> *unarchivingClasses;
 @property (nonatomic, nullable) PTDValidationBlock validationBlock;
@@ -63,26 +103,42 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
 @end
 
 
-@interface PTDToolOptions ()
-
-@property (nonatomic, readonly) NSMutableDictionary <NSString *, PTDToolOptionData *> *optionData;
-@property (nonatomic, readonly) NSMutableDictionary *values;
-
-@end
-
-
-@implementation PTDToolOptions
+/* The keys, the cached values and the subscriptions live in a
+ * PTDToolOptionStore; this class adds the registration metadata, the user
+ * defaults and the Objective-C subscribers on top of it. */
+@implementation PTDToolOptions {
+  PTDToolOptionStore *_store;
+  NSMutableArray <PTDToolOptionData *> *_options;
+  NSMapTable <id, NSNumber *> *_subscriberHandles;
+  NSPointerArray *_subscribers;
+  NSMutableArray <NSMutableIndexSet *> *_recordedKeys;
+  BOOL _flushScheduled;
+  PTDTaskSerialQueue *_persistenceQueue;
+  PTDTask *_lastPersistenceTask;
+}
 
 
 - (instancetype)init
 {
   self = [super init];
-  _values = [[NSMutableDictionary alloc] init];
-  _optionData = [[NSMutableDictionary alloc] init];
+  _store = PTDToolOptionStoreCreate(PTDToolOptionsRetainObject, PTDToolOptionsReleaseObject);
+  if (!_store)
+    return nil;
+  _options = [[NSMutableArray alloc] init];
+  _subscriberHandles = [NSMapTable weakToStrongObjectsMapTable];
+  _subscribers = [NSPointerArray weakObjectsPointerArray];
+  _recordedKeys = [[NSMutableArray alloc] init];
+  _persistenceQueue = PTDTaskSerialQueueCreate();
   return self;
 }
 
 
+- (void)dealloc
+{
+  PTDToolOptionStoreDestroy(_store);
+}
+
+
 + (PTDToolOptions *)sharedOptions
 {
   static PTDToolOptions *singleton;
@@ -94,13 +150,7 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
 }
 
 
-- (NSString *)dictionaryKeyForOption:(NSString *)optionId ofToolClass:(nullable Class)toolClass
-{
-  if (!toolClass) {
-    return [NSString stringWithFormat:@"global.%@", optionId];
-  }
-  return [NSString stringWithFormat:@"tool.%@.%@", [toolClass toolIdentifier], optionId];
-}
+#pragma mark - Registration
 
 
 - (void)registerGlobalOption:(NSString *)optionId types:(NSArray <Class> *)clss defaultValue:(id)value validationBlock:(nullable PTDValidationBlock)valid
@@ -111,21 +161,74 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
 
 - (void)registerOption:(NSString *)optionId ofToolClass:(nullable Class)toolClass types:(NSArray <Class> *)clss defaultValue:(id)value validationBlock:(nullable PTDValidationBlock)valid
 {
-  NSString *optionKey = [self dictionaryKeyForOption:optionId ofToolClass:toolClass];
-  PTDToolOptionData *data = [[PTDToolOptionData alloc] init];
   NSAssert(value, @"Value cannot be nil");
+  
+  NSString *dictKey = [NSString stringWithFormat:@"global.%@", optionId];
+  if (toolClass)
+    dictKey = [NSString stringWithFormat:@"tool.%@.%@", [toolClass toolIdentifier], optionId];
+  
+  size_t key = PTDToolOptionStoreIntern(_store, (uintptr_t)(__bridge void *)toolClass, optionId.UTF8String);
+  if (key == PTD_TOOL_OPTION_NOT_FOUND) {
+    NSLog(@"warning: cannot register option %@, out of memory", dictKey);
+    return;
+  }
+  PTDToolOptionData *data;
+  if (key < _options.count) {
+    data = _options[key];
+  } else {
+    data = [[PTDToolOptionData alloc] init];
+    data.key = key;
+    [_options addObject:data];
+  }
+  data.optionId = optionId;
+  data.toolClass = toolClass;
+  data.defaultsKey = [NSString stringWithFormat:@"PTDToolOptions.%@", dictKey];
   data.defaultValue = value;
   data.validationBlock = valid;
   data.unarchivingClasses = [NSSet setWithArray:clss];
-  [_optionData setObject:data forKey:optionKey];
+  PTDToolOptionStoreResetValue(_store, key);
+}
+
+
+- (PTDToolOptionKey)keyForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
+{
+  size_t key = PTDToolOptionStoreFind(_store, (uintptr_t)(__bridge void *)tool, optionId.UTF8String);
+  if (key == PTD_TOOL_OPTION_NOT_FOUND)
+    return PTDToolOptionKeyNotFound;
+  return key;
 }
 
 
+- (nullable PTDToolOptionData *)_registeredDataForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
+{
+  PTDToolOptionKey key = [self keyForOption:optionId ofToolClass:tool];
+  NSAssert(key != PTDToolOptionKeyNotFound, @"Option %@ of %@ not properly registered", optionId, tool ?: @"global");
+  if (key == PTDToolOptionKeyNotFound)
+    return nil;
+  return _options[key];
+}
+
+
+#pragma mark - Setting Values
+
+
 - (void)setObject:(id)object forOption:(NSString *)optionId ofToolClass:(nullable Class)tool
 {
-  NSString *dictKey = [self dictionaryKeyForOption:optionId ofToolClass:tool];
-  PTDToolOptionData *optionData = [_optionData objectForKey:dictKey];
-  NSAssert(optionData, @"Option dictKey %@ not properly registered", dictKey);
+  PTDToolOptionData *optionData = [self _registeredDataForOption:optionId ofToolClass:tool];
+  [self _setObject:object forOptionData:optionData];
+}
+
+
+- (void)setObject:(id)object forKey:(PTDToolOptionKey)key
+{
+  [self _setObject:object forOptionData:_options[key]];
+}
+
+
+- (void)_setObject:(id)object forOptionData:(PTDToolOptionData *)optionData
+{
+  NSString *optionId = optionData.optionId;
+  Class tool = optionData.toolClass;
   
   NSMutableDictionary *userInfo = [@{
       PTDToolOptionsChangedNotificationUserInfoOptionKey: optionId,
@@ -135,21 +238,25 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
     [userInfo setObject:tool forKey:PTDToolOptionsChangedNotificationUserInfoToolKey];
   }
   
-  [_values setObject:object forKey:dictKey];
-  
-  NSUserDefaults *prefs = NSUserDefaults.standardUserDefaults;
-  id plistObject;
-  if (!optionData.requiresArchiving)
-    plistObject = object;
-  else
-    plistObject = [NSKeyedArchiver archivedDataWithRootObject:object requiringSecureCoding:YES error:nil];
+  PTDToolOptionKey key = optionData.key;
+  PTDToolOptionValue value = PTDToolOptionsValueWithObject(object);
+  PTDToolOptionStoreSetValue(_store, key, &value);
+  [self _scheduleFlush];
   
-  if (plistObject) {
-    NSString *key = [NSString stringWithFormat:@"PTDToolOptions.%@", dictKey];
-    [prefs setObject:plistObject forKey:key];
-  } else {
-    NSLog(@"warning: cannot store %@ to user defaults, archiving failed", object);
+  /* the subscribers subscribe again while they are notified, hence the
+   * copy */
+  PTDToolOptionSubscriberList handles = {0};
+  if (PTDToolOptionStoreCopySubscribers(_store, key, &handles)) {
+    for (size_t i = 0; i < handles.count; i++) {
+      id <PTDToolOptionsSubscriber> subscriber = [_subscribers pointerAtIndex:handles.handles[i]];
+      if (!subscriber) {
+        PTDToolOptionStoreRemoveSubscriber(_store, handles.handles[i]);
+        continue;
+      }
+      [subscriber toolOptions:self didChangeOptionWithKey:key];
+    }
   }
+  PTDToolOptionSubscriberListFree(&handles);
   
   [[NSNotificationCenter defaultCenter]
       postNotificationName:PTDToolOptionsChangedNotification
@@ -160,42 +267,83 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
 
 - (void)restoreDefaultForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
 {
-  NSString *dictKey = [self dictionaryKeyForOption:optionId ofToolClass:tool];
-  PTDToolOptionData *optionData = [_optionData objectForKey:dictKey];
-  [self setObject:optionData.defaultValue forOption:optionId ofToolClass:tool];
+  PTDToolOptionData *optionData = [self _registeredDataForOption:optionId ofToolClass:tool];
+  [self _setObject:optionData.defaultValue forOptionData:optionData];
 }
 
 
+#pragma mark - Reading Values
+
+
 - (id)objectForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
 {
-  NSString *dictKey = [self dictionaryKeyForOption:optionId ofToolClass:tool];
-  PTDToolOptionData *optionData = [_optionData objectForKey:dictKey];
-  NSAssert(optionData, @"Option dictKey %@ not properly registered", dictKey);
+  PTDToolOptionData *optionData = [self _registeredDataForOption:optionId ofToolClass:tool];
+  return (__bridge id)[self _loadedValueForOptionData:optionData]->object;
+}
+
+
+- (id)objectForKey:(PTDToolOptionKey)key
+{
+  return (__bridge id)[self _loadedValueForOptionData:_options[key]]->object;
+}
+
+
+- (NSInteger)integerForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
+{
+  PTDToolOptionData *optionData = [self _registeredDataForOption:optionId ofToolClass:tool];
+  return (NSInteger)[self _loadedValueForOptionData:optionData]->integer;
+}
+
+
+- (double)doubleForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
+{
+  PTDToolOptionData *optionData = [self _registeredDataForOption:optionId ofToolClass:tool];
+  return [self _loadedValueForOptionData:optionData]->real;
+}
+
+
+- (BOOL)boolForOption:(NSString *)optionId ofToolClass:(nullable Class)tool
+{
+  PTDToolOptionData *optionData = [self _registeredDataForOption:optionId ofToolClass:tool];
+  return [self _loadedValueForOptionData:optionData]->integer != 0;
+}
+
+
+- (const PTDToolOptionValue *)_loadedValueForOptionData:(nullable PTDToolOptionData *)optionData
+{
+  static const PTDToolOptionValue noValue = {NULL, 0, 0.0};
+  if (!optionData)
+    return &noValue;
+  
+  NSMutableIndexSet *recording = _recordedKeys.lastObject;
+  if (recording)
+    [recording addIndex:optionData.key];
   
-  id res = [_values objectForKey:dictKey];
-  if (res)
-    return res;
+  const PTDToolOptionValue *value = PTDToolOptionStoreValue(_store, optionData.key);
+  if (value)
+    return value;
   
+  NSString *key = optionData.defaultsKey;
+  id res;
   NSUserDefaults *prefs = NSUserDefaults.standardUserDefaults;
-  NSString *key = [NSString stringWithFormat:@"PTDToolOptions.%@", dictKey];
   id objFromDefaults = [prefs objectForKey:key];
   if (objFromDefaults) {
     if ([objFromDefaults isKindOfClass:[NSData class]]) {
       NSError *error;
       res = [NSKeyedUnarchiver unarchivedObjectOfClasses:optionData.unarchivingClasses fromData:objFromDefaults error:&error];
       if (!res)
-        NSLog(@"warning: option %@ is corrupt (unarchiving failed %@), using default", error, dictKey);
+        NSLog(@"warning: option %@ is corrupt (unarchiving failed %@), using default", error, key);
     } else {
       res = objFromDefaults;
       if (optionData.unarchivingClasses.count == 1)
         if (![res isKindOfClass:optionData.unarchivingClasses.anyObject]) {
-          NSLog(@"warning: option %@ is corrupt (type validation failed), using default", dictKey);
+          NSLog(@"warning: option %@ is corrupt (type validation failed), using default", key);
           res = nil;
         }
     }
     
     if (res && optionData.validationBlock && !optionData.validationBlock(res)) {
-      NSLog(@"warning: option %@ is corrupt (validation failed), using default", dictKey);
+      NSLog(@"warning: option %@ is corrupt (validation failed), using default", key);
       res = nil;
     }
   }
@@ -203,9 +351,145 @@ NSString * const PTDToolOptionsChangedNotificationUserInfoObjectKey = @"object";
   if (!res)
     res = optionData.defaultValue;
     
-  [_values setObject:res forKey:dictKey];
+  PTDToolOptionValue loaded = PTDToolOptionsValueWithObject(res);
+  PTDToolOptionStoreLoadValue(_store, optionData.key, &loaded);
+  return PTDToolOptionStoreValue(_store, optionData.key);
+}
+
+
+#pragma mark - Subscriptions
+
+
+- (void)subscribe:(id <PTDToolOptionsSubscriber>)subscriber toKeys:(NSIndexSet *)keys
+{
+  NSNumber *handleNumber = [_subscriberHandles objectForKey:subscriber];
+  uint32_t handle;
+  if (handleNumber) {
+    handle = handleNumber.unsignedIntValue;
+  } else {
+    [self _removeDeallocatedSubscribers];
+    handle = PTDToolOptionStoreAddSubscriber(_store);
+    if (handle == UINT32_MAX) {
+      NSLog(@"warning: cannot subscribe %@ to tool options, out of memory", subscriber);
+      return;
+    }
+    if (handle >= _subscribers.count)
+      _subscribers.count = handle + 1;
+    [_subscribers replacePointerAtIndex:handle withPointer:(__bridge void *)subscriber];
+    [_subscriberHandles setObject:@(handle) forKey:subscriber];
+  }
+  
+  NSMutableData *keyData = [NSMutableData dataWithLength:keys.count * sizeof(size_t)];
+  size_t *keyArray = keyData.mutableBytes;
+  __block size_t count = 0;
+  [keys enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    keyArray[count++] = idx;
+  }];
+  if (!PTDToolOptionStoreSubscribe(_store, handle, keyArray, count))
+    NSLog(@"warning: cannot subscribe %@ to tool options, out of memory", subscriber);
+}
+
+
+- (void)unsubscribe:(id <PTDToolOptionsSubscriber>)subscriber
+{
+  NSNumber *handleNumber = [_subscriberHandles objectForKey:subscriber];
+  if (!handleNumber)
+    return;
+  uint32_t handle = handleNumber.unsignedIntValue;
+  PTDToolOptionStoreRemoveSubscriber(_store, handle);
+  [_subscribers replacePointerAtIndex:handle withPointer:NULL];
+  [_subscriberHandles removeObjectForKey:subscriber];
+}
+
+
+/* Subscribers are weak, so they can go away without unsubscribing; their
+ * handles are given back before new ones are taken */
+- (void)_removeDeallocatedSubscribers
+{
+  NSUInteger count = _subscribers.count;
+  for (NSUInteger handle = 0; handle < count; handle++) {
+    if ([_subscribers pointerAtIndex:handle] == NULL)
+      PTDToolOptionStoreRemoveSubscriber(_store, (uint32_t)handle);
+  }
+}
+
+
+- (void)beginRecordingAccessedKeys
+{
+  [_recordedKeys addObject:[[NSMutableIndexSet alloc] init]];
+}
+
+
+- (NSIndexSet *)endRecordingAccessedKeys
+{
+  NSIndexSet *res = [_recordedKeys.lastObject copy];
+  [_recordedKeys removeLastObject];
   return res;
 }
 
 
+#pragma mark - Persistence
+
+
+- (void)_scheduleFlush
+{
+  if (_flushScheduled)
+    return;
+  _flushScheduled = YES;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_PersistenceDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+    [self _flush];
+  });
+}
+
+
+- (void)_flush
+{
+  _flushScheduled = NO;
+  if (!PTDToolOptionStoreHasChanges(_store))
+    return;
+  
+  NSMutableIndexSet *changedKeys = [[NSMutableIndexSet alloc] init];
+  PTDToolOptionStoreTakeChanges(_store, PTDToolOptionsAddChangedKey, (__bridge void *)changedKeys);
+  
+  NSMutableDictionary *plistValues = [[NSMutableDictionary alloc] init];
+  NSMutableDictionary *archivedValues = [[NSMutableDictionary alloc] init];
+  [changedKeys enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    PTDToolOptionData *optionData = self->_options[idx];
+    id value = (__bridge id)PTDToolOptionStoreValue(self->_store, idx)->object;
+    if (!optionData.requiresArchiving)
+      [plistValues setObject:value forKey:optionData.defaultsKey];
+    else
+      [archivedValues setObject:value forKey:optionData.defaultsKey];
+  }];
+  
+  PTDTask *task = PTDBlockTaskCreate(PTDTaskPriorityAutosave, ^(PTDTask *unused) {
+    NSUserDefaults *prefs = NSUserDefaults.standardUserDefaults;
+    for (NSString *key in plistValues) {
+      [prefs setObject:plistValues[key] forKey:key];
+    }
+    for (NSString *key in archivedValues) {
+      id object = archivedValues[key];
+      NSData *plistObject = [NSKeyedArchiver archivedDataWithRootObject:object requiringSecureCoding:YES error:nil];
+      if (plistObject)
+        [prefs setObject:plistObject forKey:key];
+      else
+        NSLog(@"warning: cannot store %@ to user defaults, archiving failed", object);
+    }
+  });
+  PTDTaskSetSerialQueue(task, _persistenceQueue);
+  PTDTaskSchedulerSubmit(PTDTaskSchedulerShared(), task);
+  PTDTaskRelease(_lastPersistenceTask);
+  _lastPersistenceTask = task;
+}
+
+
+- (void)synchronize
+{
+  [self _flush];
+  /* the tasks run in order, so the last one is enough */
+  if (_lastPersistenceTask)
+    PTDTaskWait(_lastPersistenceTask);
+}
+
+
 @end
@@ -32,4 +32,8 @@ __attribute__((noreturn)) void _PTDAbstract(const char *file, int line);
 
 void PTDSwizzleInstanceMethod(id self, SEL originalSelector, SEL swizzledSelector);
 
+/* When the debug default is set, logs the time elapsed since the process
+ * was started and since the previous phase, and the memory footprint. */
+void PTDStartupTraceMark(NSString *phase);
+
 NS_ASSUME_NONNULL_END
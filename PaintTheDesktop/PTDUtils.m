@@ -25,6 +25,9 @@
 
 #import <Cocoa/Cocoa.h>
 #import <objc/runtime.h>
+#import <sys/sysctl.h>
+#import <sys/time.h>
+#import <mach/mach.h>
 #import "PTDUtils.h"
 
 
@@ -57,3 +60,50 @@ void PTDSwizzleInstanceMethod(id self, SEL originalSelector, SEL swizzledSelecto
   }
 }
 
+
+static double PTDProcessStartTime(void)
+{
+  int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+  struct kinfo_proc info;
+  size_t size = sizeof(info);
+  if (sysctl(mib, 4, &info, &size, NULL, 0) != 0)
+    return 0;
+  struct timeval start = info.kp_proc.p_starttime;
+  return (double)start.tv_sec + (double)start.tv_usec / 1e6;
+}
+
+
+static size_t PTDMemoryFootprint(void)
+{
+  task_vm_info_data_t info;
+  mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+  if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+    return 0;
+  return (size_t)info.phys_footprint;
+}
+
+
+void PTDStartupTraceMark(NSString *phase)
+{
+  static double startTime, lastTime;
+  static BOOL started;
+  if (![NSUserDefaults.standardUserDefaults boolForKey:@"debug"])
+    return;
+  
+  /* the start time of the process is only known in wall clock time */
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  double time = (double)now.tv_sec + (double)now.tv_usec / 1e6;
+  if (!started) {
+    started = YES;
+    startTime = PTDProcessStartTime();
+    if (startTime == 0)
+      startTime = time;
+    lastTime = startTime;
+  }
+  
+  NSLog(@"startup: %@ at %.1f ms (+%.1f ms), footprint %.1f MB",
+      phase, (time - startTime) * 1000.0, (time - lastTime) * 1000.0,
+      (double)PTDMemoryFootprint() / (1024.0 * 1024.0));
+  lastTime = time;
+}
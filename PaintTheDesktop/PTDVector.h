@@ -0,0 +1,226 @@
+//
+// PTDVector.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDVector_h
+#define PTDVector_h
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/* Four floats, usually the channels of one RGBA8 pixel, for the inner loops
+ * of the raster code. Compilers with the GCC vector extensions (GCC and
+ * Clang) get SIMD code which does not depend on the optimization level;
+ * the others, or any compiler when PTD_VECTOR_SCALAR is defined, get the
+ * same operations done one lane at a time. All the operations are done on
+ * every lane independently. */
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(PTD_VECTOR_SCALAR)
+
+typedef float PTDFloat4 __attribute__((vector_size(16)));
+typedef uint8_t PTDUChar4 __attribute__((vector_size(4)));
+typedef int32_t PTDInt4 __attribute__((vector_size(16)));
+
+static inline PTDFloat4 PTDFloat4Splat(float x)
+{
+  return (PTDFloat4){x, x, x, x};
+}
+
+static inline PTDFloat4 PTDFloat4Add(PTDFloat4 a, PTDFloat4 b)
+{
+  return a + b;
+}
+
+static inline PTDFloat4 PTDFloat4Sub(PTDFloat4 a, PTDFloat4 b)
+{
+  return a - b;
+}
+
+static inline PTDFloat4 PTDFloat4Mul(PTDFloat4 a, PTDFloat4 b)
+{
+  return a * b;
+}
+
+static inline PTDFloat4 PTDFloat4Div(PTDFloat4 a, PTDFloat4 b)
+{
+  return a / b;
+}
+
+/* the lanes of a where the mask is all ones, those of b elsewhere */
+static inline PTDFloat4 PTDFloat4Select(PTDInt4 mask, PTDFloat4 a, PTDFloat4 b)
+{
+  return (PTDFloat4)(((PTDInt4)a & mask) | ((PTDInt4)b & ~mask));
+}
+
+static inline PTDFloat4 PTDFloat4Min(PTDFloat4 a, PTDFloat4 b)
+{
+  return PTDFloat4Select(a < b, a, b);
+}
+
+static inline PTDFloat4 PTDFloat4Max(PTDFloat4 a, PTDFloat4 b)
+{
+  return PTDFloat4Select(a > b, a, b);
+}
+
+static inline float PTDFloat4Lane(PTDFloat4 a, int i)
+{
+  return a[i];
+}
+
+static inline PTDFloat4 PTDFloat4SetLane(PTDFloat4 a, int i, float x)
+{
+  a[i] = x;
+  return a;
+}
+
+/* 8 bits per channel to float and back; the conversion back truncates the
+ * fractional part, and the values must be between 0 and 255 */
+static inline PTDFloat4 PTDFloat4LoadPixel(const uint8_t *px)
+{
+  PTDUChar4 v;
+  memcpy(&v, px, 4);
+  return __builtin_convertvector(v, PTDFloat4);
+}
+
+static inline void PTDFloat4StorePixel(uint8_t *px, PTDFloat4 a)
+{
+  PTDUChar4 v = __builtin_convertvector(__builtin_convertvector(a, PTDInt4), PTDUChar4);
+  memcpy(px, &v, 4);
+}
+
+#else
+
+typedef struct {
+  float v[4];
+} PTDFloat4;
+
+static inline PTDFloat4 PTDFloat4Splat(float x)
+{
+  return (PTDFloat4){{x, x, x, x}};
+}
+
+static inline PTDFloat4 PTDFloat4Add(PTDFloat4 a, PTDFloat4 b)
+{
+  for (int i = 0; i < 4; i++)
+    a.v[i] += b.v[i];
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4Sub(PTDFloat4 a, PTDFloat4 b)
+{
+  for (int i = 0; i < 4; i++)
+    a.v[i] -= b.v[i];
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4Mul(PTDFloat4 a, PTDFloat4 b)
+{
+  for (int i = 0; i < 4; i++)
+    a.v[i] *= b.v[i];
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4Div(PTDFloat4 a, PTDFloat4 b)
+{
+  for (int i = 0; i < 4; i++)
+    a.v[i] /= b.v[i];
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4Min(PTDFloat4 a, PTDFloat4 b)
+{
+  for (int i = 0; i < 4; i++)
+    a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4Max(PTDFloat4 a, PTDFloat4 b)
+{
+  for (int i = 0; i < 4; i++)
+    a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+  return a;
+}
+
+static inline float PTDFloat4Lane(PTDFloat4 a, int i)
+{
+  return a.v[i];
+}
+
+static inline PTDFloat4 PTDFloat4SetLane(PTDFloat4 a, int i, float x)
+{
+  a.v[i] = x;
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4LoadPixel(const uint8_t *px)
+{
+  return (PTDFloat4){{px[0], px[1], px[2], px[3]}};
+}
+
+static inline void PTDFloat4StorePixel(uint8_t *px, PTDFloat4 a)
+{
+  for (int i = 0; i < 4; i++)
+    px[i] = (uint8_t)(int32_t)a.v[i];
+}
+
+#endif
+
+static inline PTDFloat4 PTDFloat4Clamp(PTDFloat4 a, PTDFloat4 lo, PTDFloat4 hi)
+{
+  return PTDFloat4Min(PTDFloat4Max(a, lo), hi);
+}
+
+/* a where t is zero, b where it is one */
+static inline PTDFloat4 PTDFloat4Mix(PTDFloat4 a, PTDFloat4 b, float t)
+{
+  return PTDFloat4Add(a, PTDFloat4Mul(PTDFloat4Sub(b, a), PTDFloat4Splat(t)));
+}
+
+static inline PTDFloat4 PTDFloat4Abs(PTDFloat4 a)
+{
+  return PTDFloat4Max(a, PTDFloat4Sub(PTDFloat4Splat(0.0f), a));
+}
+
+/* the lanes must not be negative */
+static inline PTDFloat4 PTDFloat4Sqrt(PTDFloat4 a)
+{
+  for (int i = 0; i < 4; i++)
+    a = PTDFloat4SetLane(a, i, sqrtf(PTDFloat4Lane(a, i)));
+  return a;
+}
+
+static inline PTDFloat4 PTDFloat4Load(const float *p)
+{
+  PTDFloat4 a;
+  memcpy(&a, p, sizeof(a));
+  return a;
+}
+
+static inline void PTDFloat4Store(float *p, PTDFloat4 a)
+{
+  memcpy(p, &a, sizeof(a));
+}
+
+#endif /* PTDVector_h */
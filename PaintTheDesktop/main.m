@@ -24,8 +24,10 @@
 //
 
 #import <Cocoa/Cocoa.h>
+#import "PTDUtils.h"
 
 int main(int argc, const char * argv[])
 {
+  PTDStartupTraceMark(@"main");
   return NSApplicationMain(argc, argv);
 }
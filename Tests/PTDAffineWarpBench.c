@@ -0,0 +1,76 @@
+//
+// PTDAffineWarpBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDAffineWarp.h"
+
+
+/* Transforming a large selection, as the selection tool does on every
+ * drag of a handle */
+
+static const double _Pi = 3.14159265358979323846;
+
+
+static void PTDBenchWarp(const char *name, const PTDPixelBuffer *src, const PTDPixelBuffer *dst, PTDAffineWarpMatrix srcToDst)
+{
+  PTDAffineWarpMatrix dstToSrc = PTDAffineWarpMatrixInvert(srcToDst);
+  double start = PTDTestNow();
+  int runs = 0;
+  do {
+    PTDAffineWarp(src, dst, dstToSrc);
+    runs++;
+  } while (PTDTestNow() - start < 1.0);
+  double seconds = (PTDTestNow() - start) / runs;
+  printf("%-48s %10.3f ms %8.1f MP/s\n", name, seconds * 1000.0, (double)(dst->width * dst->height) / seconds / 1e6);
+}
+
+
+int main(void)
+{
+  const size_t size = 2048;
+  PTDPixelBuffer src = {malloc(size * size * 4), size, size, size * 4};
+  PTDPixelBuffer dst = {malloc(size * size * 4), size, size, size * 4};
+  PTDPixelBuffer large = {malloc(size * size * 16), size * 2, size * 2, size * 8};
+  uint64_t rng = 1;
+  for (size_t i = 0; i < size * size * 4; i++)
+    src.data[i] = (uint8_t)PTDTestRandom(&rng);
+  
+  double angle = 30.0 * _Pi / 180.0, c = (double)size / 2.0;
+  PTDAffineWarpMatrix rotate = PTDAffineWarpMatrixConcat(
+      PTDAffineWarpMatrixConcat((PTDAffineWarpMatrix){1, 0, 0, 1, -c, -c}, (PTDAffineWarpMatrix){cos(angle), sin(angle), -sin(angle), cos(angle), 0, 0}),
+      (PTDAffineWarpMatrix){1, 0, 0, 1, c, c});
+  
+  PTDBenchWarp("2048x2048, translation", &src, &dst, (PTDAffineWarpMatrix){1, 0, 0, 1, 10.5, 3.25});
+  PTDBenchWarp("2048x2048, rotation by 30 degrees", &src, &dst, rotate);
+  PTDBenchWarp("2048x2048, rotation by 90 degrees", &src, &dst, (PTDAffineWarpMatrix){0, 1, -1, 0, (double)size, 0});
+  PTDBenchWarp("2048x2048, scaled to 2x", &src, &large, (PTDAffineWarpMatrix){2, 0, 0, 2, 0, 0});
+  
+  free(src.data);
+  free(dst.data);
+  free(large.data);
+  return 0;
+}
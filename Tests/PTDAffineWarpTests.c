@@ -0,0 +1,266 @@
+//
+// PTDAffineWarpTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDAffineWarp.h"
+
+
+static const double _Pi = 3.14159265358979323846;
+
+
+static PTDPixelBuffer PTDTestBufferCreate(size_t width, size_t height)
+{
+  PTDPixelBuffer buffer = {calloc(width * height, 4), width, height, width * 4};
+  return buffer;
+}
+
+
+static PTDPixelBuffer PTDTestRandomImage(size_t width, size_t height, uint64_t seed)
+{
+  PTDPixelBuffer buffer = PTDTestBufferCreate(width, height);
+  for (size_t i = 0; i < width * height; i++) {
+    uint8_t a = (uint8_t)PTDTestRandom(&seed);
+    for (int c = 0; c < 3; c++)
+      buffer.data[i * 4 + c] = (uint8_t)PTDTestRandomBelow(&seed, (size_t)a + 1);
+    buffer.data[i * 4 + 3] = a;
+  }
+  return buffer;
+}
+
+
+static const uint8_t *PTDTestPixel(const PTDPixelBuffer *buffer, size_t x, size_t y)
+{
+  return buffer->data + y * buffer->bytesPerRow + x * 4;
+}
+
+
+static void testIdentity(void)
+{
+  PTDPixelBuffer src = PTDTestRandomImage(67, 45, 1), dst = PTDTestBufferCreate(67, 45);
+  PTD_CHECK(PTDAffineWarp(&src, &dst, (PTDAffineWarpMatrix){1, 0, 0, 1, 0, 0}));
+  PTD_CHECK(memcmp(src.data, dst.data, 67 * 45 * 4) == 0);
+  free(src.data);
+  free(dst.data);
+}
+
+
+static void testIntegerTranslation(void)
+{
+  PTDPixelBuffer src = PTDTestRandomImage(40, 30, 2), dst = PTDTestBufferCreate(40, 30);
+  memset(dst.data, 0xAA, 40 * 30 * 4);
+  /* the destination shows the source moved 5 right and 3 down */
+  PTD_CHECK(PTDAffineWarp(&src, &dst, (PTDAffineWarpMatrix){1, 0, 0, 1, -5, -3}));
+  int ok = 1;
+  for (size_t y = 0; y < 30; y++) {
+    for (size_t x = 0; x < 40; x++) {
+      if (x < 5 || y < 3)
+        ok &= memcmp(PTDTestPixel(&dst, x, y), (uint8_t[]){0, 0, 0, 0}, 4) == 0;
+      else
+        ok &= memcmp(PTDTestPixel(&dst, x, y), PTDTestPixel(&src, x - 5, y - 3), 4) == 0;
+    }
+  }
+  PTD_CHECK(ok);
+  free(src.data);
+  free(dst.data);
+}
+
+
+static void testQuarterRotation(void)
+{
+  const size_t w = 51, h = 34;
+  PTDPixelBuffer src = PTDTestRandomImage(w, h, 3), dst = PTDTestBufferCreate(h, w);
+  /* x' = h - y, y' = x; source pixel (i, j) lands on (h - 1 - j, i) */
+  PTDAffineWarpMatrix srcToDst = {0, 1, -1, 0, (double)h, 0};
+  PTD_CHECK(PTDAffineWarp(&src, &dst, PTDAffineWarpMatrixInvert(srcToDst)));
+  int ok = 1;
+  for (size_t j = 0; j < h; j++)
+    for (size_t i = 0; i < w; i++)
+      ok &= memcmp(PTDTestPixel(&src, i, j), PTDTestPixel(&dst, h - 1 - j, i), 4) == 0;
+  PTD_CHECK(ok);
+  
+  /* four quarter turns make a full one */
+  PTDPixelBuffer a = PTDTestBufferCreate(w, h), b = PTDTestBufferCreate(h, w);
+  PTDAffineWarpMatrix back = PTDAffineWarpMatrixInvert((PTDAffineWarpMatrix){0, 1, -1, 0, (double)w, 0});
+  PTD_CHECK(PTDAffineWarp(&dst, &a, back));
+  PTD_CHECK(PTDAffineWarp(&a, &b, PTDAffineWarpMatrixInvert(srcToDst)));
+  PTD_CHECK(PTDAffineWarp(&b, &a, back));
+  PTD_CHECK(memcmp(a.data, src.data, w * h * 4) == 0);
+  
+  free(src.data);
+  free(dst.data);
+  free(a.data);
+  free(b.data);
+}
+
+
+static void testFlipRoundTrip(void)
+{
+  const size_t w = 77, h = 23;
+  PTDPixelBuffer src = PTDTestRandomImage(w, h, 4), flipped = PTDTestBufferCreate(w, h), back = PTDTestBufferCreate(w, h);
+  PTDAffineWarpMatrix flipX = {-1, 0, 0, 1, (double)w, 0};
+  PTDAffineWarpMatrix flipY = {1, 0, 0, -1, 0, (double)h};
+  
+  PTD_CHECK(PTDAffineWarp(&src, &flipped, flipX));
+  int ok = 1;
+  for (size_t y = 0; y < h; y++)
+    for (size_t x = 0; x < w; x++)
+      ok &= memcmp(PTDTestPixel(&src, x, y), PTDTestPixel(&flipped, w - 1 - x, y), 4) == 0;
+  PTD_CHECK(ok);
+  PTD_CHECK(PTDAffineWarp(&flipped, &back, flipX));
+  PTD_CHECK(memcmp(src.data, back.data, w * h * 4) == 0);
+  
+  PTD_CHECK(PTDAffineWarp(&src, &flipped, PTDAffineWarpMatrixConcat(flipX, flipY)));
+  PTD_CHECK(PTDAffineWarp(&flipped, &back, PTDAffineWarpMatrixConcat(flipY, flipX)));
+  PTD_CHECK(memcmp(src.data, back.data, w * h * 4) == 0);
+  
+  free(src.data);
+  free(flipped.data);
+  free(back.data);
+}
+
+
+static void testRotationRoundTrip(void)
+{
+  /* a smooth image survives a turn by an arbitrary angle and back */
+  const size_t size = 256;
+  PTDPixelBuffer src = PTDTestBufferCreate(size, size), turned = PTDTestBufferCreate(size, size), back = PTDTestBufferCreate(size, size);
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      uint8_t *px = src.data + y * src.bytesPerRow + x * 4;
+      for (int c = 0; c < 3; c++)
+        px[c] = (uint8_t)lround(128.0 + 100.0 * sin((double)x / 9.0 + c) * cos((double)y / 13.0));
+      px[3] = 255;
+    }
+  }
+  double angle = 30.0 * _Pi / 180.0, center = (double)size / 2.0;
+  PTDAffineWarpMatrix toOrigin = {1, 0, 0, 1, -center, -center};
+  PTDAffineWarpMatrix rotate = {cos(angle), sin(angle), -sin(angle), cos(angle), 0, 0};
+  PTDAffineWarpMatrix fromOrigin = {1, 0, 0, 1, center, center};
+  PTDAffineWarpMatrix srcToDst = PTDAffineWarpMatrixConcat(PTDAffineWarpMatrixConcat(toOrigin, rotate), fromOrigin);
+  PTD_CHECK(PTDAffineWarp(&src, &turned, PTDAffineWarpMatrixInvert(srcToDst)));
+  PTD_CHECK(PTDAffineWarp(&turned, &back, srcToDst));
+  
+  /* compare the disc which never left the buffer */
+  double se = 0.0;
+  size_t n = 0;
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      double dx = (double)x + 0.5 - center, dy = (double)y + 0.5 - center;
+      if (dx * dx + dy * dy > (center - 4.0) * (center - 4.0))
+        continue;
+      for (int c = 0; c < 4; c++, n++) {
+        double d = (double)PTDTestPixel(&src, x, y)[c] - (double)PTDTestPixel(&back, x, y)[c];
+        se += d * d;
+      }
+    }
+  }
+  double psnr = 10.0 * log10(255.0 * 255.0 / (se / (double)n));
+  printf("  30 degrees and back  %6.2f dB\n", psnr);
+  PTD_CHECK(psnr > 35.0);
+  
+  free(src.data);
+  free(turned.data);
+  free(back.data);
+}
+
+
+/* Straightforward bilinear sampling, with transparent texels outside */
+static void PTDTestReferencePixel(const PTDPixelBuffer *src, PTDAffineWarpMatrix m, size_t x, size_t y, uint8_t *out)
+{
+  double cx = (double)x + 0.5, cy = (double)y + 0.5;
+  double u = m.a * cx + m.c * cy + m.tx - 0.5, v = m.b * cx + m.d * cy + m.ty - 0.5;
+  double fu = floor(u), fv = floor(v);
+  long iu = (long)fu, iv = (long)fv;
+  float wu = (float)(u - fu), wv = (float)(v - fv);
+  for (int c = 0; c < 4; c++) {
+    float p[2][2];
+    for (int j = 0; j < 2; j++) {
+      for (int i = 0; i < 2; i++) {
+        long sx = iu + i, sy = iv + j;
+        int inside = sx >= 0 && sy >= 0 && sx < (long)src->width && sy < (long)src->height;
+        p[j][i] = inside ? (float)PTDTestPixel(src, (size_t)sx, (size_t)sy)[c] : 0.0f;
+      }
+    }
+    float top = p[0][0] + (p[0][1] - p[0][0]) * wu;
+    float bottom = p[1][0] + (p[1][1] - p[1][0]) * wu;
+    out[c] = (uint8_t)(top + (bottom - top) * wv + 0.5f);
+  }
+}
+
+
+static void testMatchesReference(void)
+{
+  PTDPixelBuffer src = PTDTestRandomImage(60, 40, 5), dst = PTDTestBufferCreate(90, 70);
+  uint64_t rng = 6;
+  int maxError = 0;
+  for (int i = 0; i < 20; i++) {
+    double angle = (double)PTDTestRandomBelow(&rng, 360) * _Pi / 180.0;
+    double scale = 0.5 + (double)PTDTestRandomBelow(&rng, 200) / 100.0;
+    PTDAffineWarpMatrix m = {
+      cos(angle) * scale, sin(angle) * scale, -sin(angle) * scale, cos(angle) * scale,
+      (double)PTDTestRandomBelow(&rng, 100) - 20.0, (double)PTDTestRandomBelow(&rng, 80) - 20.0
+    };
+    PTD_CHECK(PTDAffineWarp(&src, &dst, m));
+    for (size_t y = 0; y < dst.height; y++) {
+      for (size_t x = 0; x < dst.width; x++) {
+        uint8_t expected[4];
+        PTDTestReferencePixel(&src, m, x, y, expected);
+        for (int c = 0; c < 4; c++) {
+          int error = abs((int)expected[c] - (int)PTDTestPixel(&dst, x, y)[c]);
+          maxError = error > maxError ? error : maxError;
+        }
+      }
+    }
+  }
+  /* only the order of the float operations may differ */
+  PTD_CHECK(maxError <= 1);
+  free(src.data);
+  free(dst.data);
+}
+
+
+static void testDegenerateMatrix(void)
+{
+  PTDPixelBuffer src = PTDTestBufferCreate(4, 4), dst = PTDTestBufferCreate(4, 4);
+  PTD_CHECK(!PTDAffineWarp(&src, &dst, (PTDAffineWarpMatrix){1, 2, 2, 4, 0, 0}));
+  PTD_CHECK(!PTDAffineWarp(&src, &dst, (PTDAffineWarpMatrix){NAN, 0, 0, 1, 0, 0}));
+  free(src.data);
+  free(dst.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testIdentity);
+  PTD_RUN(testIntegerTranslation);
+  PTD_RUN(testQuarterRotation);
+  PTD_RUN(testFlipRoundTrip);
+  PTD_RUN(testRotationRoundTrip);
+  PTD_RUN(testMatchesReference);
+  PTD_RUN(testDegenerateMatrix);
+  return PTDTestFinish();
+}
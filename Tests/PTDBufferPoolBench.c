@@ -0,0 +1,81 @@
+//
+// PTDBufferPoolBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdbool.h>
+#include <sys/resource.h>
+#include "PTDTest.h"
+#include "PTDBufferPool.h"
+
+
+static long PTDBenchPageFaults(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+
+/* Allocates, fills and frees a buffer of the given size the given number of
+ * times, as done for a transient bitmap, and prints the time and the page
+ * faults taken per round. */
+static void PTDBenchRounds(const char *name, size_t size, int rounds, bool pooled)
+{
+  long faults = PTDBenchPageFaults();
+  double start = PTDTestNow();
+  for (int i = 0; i < rounds; i++) {
+    uint8_t *buffer = pooled ? PTDBufferPoolAlloc(size) : malloc(size);
+    memset(buffer, i, size);
+    /* keeps the fill from being optimized away */
+    if (buffer[size / 2] != (uint8_t)i)
+      abort();
+    if (pooled)
+      PTDBufferPoolFree(buffer, size);
+    else
+      free(buffer);
+  }
+  double elapsed = PTDTestNow() - start;
+  faults = PTDBenchPageFaults() - faults;
+  printf("%-48s %10.3f ms, %8.0f page faults per round\n", name, elapsed * 1000.0 / rounds, (double)faults / rounds);
+}
+
+
+int main(void)
+{
+  /* a 5K screen, a 1440p screen, and a scratch band of the resampler */
+  static const struct { const char *name; size_t size; int rounds; } cases[] = {
+    {"5120x2880", 5120 * 2880 * 4, 50},
+    {"2560x1440", 2560 * 1440 * 4, 100},
+    {"256 KB", 256 * 1024, 5000}};
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s, malloc", cases[i].name);
+    PTDBenchRounds(name, cases[i].size, cases[i].rounds, false);
+    snprintf(name, sizeof(name), "%s, pool", cases[i].name);
+    PTDBenchRounds(name, cases[i].size, cases[i].rounds, true);
+    PTDBufferPoolTrim(0);
+  }
+  return 0;
+}
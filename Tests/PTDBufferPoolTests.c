@@ -0,0 +1,208 @@
+//
+// PTDBufferPoolTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "PTDTest.h"
+#include "PTDBufferPool.h"
+
+
+static const size_t _KB = 1024;
+static const size_t _MB = 1024 * 1024;
+
+
+static bool PTDTestIsPageAligned(const void *buffer)
+{
+  return (uintptr_t)buffer % (uintptr_t)sysconf(_SC_PAGESIZE) == 0;
+}
+
+
+static void testReuse(void)
+{
+  PTDBufferPoolTrim(0);
+  PTDBufferPoolStatistics before, after;
+  PTDBufferPoolGetStatistics(&before);
+  
+  void *a = PTDBufferPoolAlloc(100 * _KB);
+  PTD_CHECK(a && PTDTestIsPageAligned(a));
+  memset(a, 0xAB, 100 * _KB);
+  PTDBufferPoolFree(a, 100 * _KB);
+  /* the same class: 96 KB < size <= 128 KB */
+  void *b = PTDBufferPoolAlloc(120 * _KB);
+  PTD_CHECK(b == a);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.systemAllocations - before.systemAllocations == 1);
+  PTD_CHECK(after.reuses - before.reuses == 1);
+  PTD_CHECK(after.bytesInUse - before.bytesInUse == 128 * _KB);
+  PTD_CHECK(after.bytesCached == before.bytesCached);
+  
+  /* a different class, so a new buffer */
+  void *c = PTDBufferPoolAlloc(90 * _KB);
+  PTD_CHECK(c && c != b);
+  PTDBufferPoolFree(c, 90 * _KB);
+  PTDBufferPoolFree(b, 120 * _KB);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.bytesInUse == before.bytesInUse);
+  PTD_CHECK(after.bytesCached - before.bytesCached == 128 * _KB + 96 * _KB);
+  PTD_CHECK(after.peakBytesInUse >= before.bytesInUse + 128 * _KB + 96 * _KB);
+  PTDBufferPoolTrim(0);
+}
+
+
+static void testSizeClasses(void)
+{
+  PTDBufferPoolTrim(0);
+  /* sizes on both sides of each class boundary */
+  static const struct { size_t size; size_t classSize; } cases[] = {
+    {16 * 1024, 16 * 1024},
+    {16 * 1024 + 1, 24 * 1024},
+    {24 * 1024, 24 * 1024},
+    {24 * 1024 + 1, 32 * 1024},
+    {1536 * 1024, 1536 * 1024},
+    {1536 * 1024 + 1, 2048 * 1024},
+    {256 * 1024 * 1024, 256 * 1024 * 1024}};
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    PTDBufferPoolStatistics before, after;
+    PTDBufferPoolGetStatistics(&before);
+    void *buffer = PTDBufferPoolAlloc(cases[i].size);
+    PTDBufferPoolGetStatistics(&after);
+    PTD_CHECK(buffer && PTDTestIsPageAligned(buffer));
+    PTD_CHECK(after.bytesInUse - before.bytesInUse == cases[i].classSize);
+    /* the whole class is usable */
+    ((volatile uint8_t *)buffer)[cases[i].classSize - 1] = 1;
+    PTDBufferPoolFree(buffer, cases[i].size);
+    PTDBufferPoolTrim(0);
+  }
+  
+  /* too small or too large to be pooled: the counters do not move */
+  static const size_t unpooled[] = {0, 1, 16 * 1024 - 1, 256 * 1024 * 1024 + 1};
+  for (size_t i = 0; i < sizeof(unpooled) / sizeof(unpooled[0]); i++) {
+    PTDBufferPoolStatistics before, after;
+    PTDBufferPoolGetStatistics(&before);
+    void *buffer = PTDBufferPoolAlloc(unpooled[i]);
+    PTD_CHECK(buffer != NULL);
+    PTDBufferPoolFree(buffer, unpooled[i]);
+    PTDBufferPoolGetStatistics(&after);
+    PTD_CHECK(memcmp(&before, &after, sizeof(before)) == 0);
+  }
+  PTDBufferPoolFree(NULL, 64 * _KB);
+}
+
+
+static void testCacheLimitAndTrim(void)
+{
+  PTDBufferPoolTrim(0);
+  /* 40 buffers of 8 MB do not all fit in the 128 MB cache */
+  enum { COUNT = 40 };
+  void *buffers[COUNT];
+  for (int i = 0; i < COUNT; i++)
+    buffers[i] = PTDBufferPoolAlloc(8 * _MB);
+  PTDBufferPoolStatistics before, after;
+  PTDBufferPoolGetStatistics(&before);
+  for (int i = 0; i < COUNT; i++)
+    PTDBufferPoolFree(buffers[i], 8 * _MB);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.bytesCached == 128 * _MB);
+  PTD_CHECK(after.systemFrees - before.systemFrees == COUNT - 16);
+  
+  PTDBufferPoolTrim(20 * _MB);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.bytesCached <= 20 * _MB);
+  PTD_CHECK(after.bytesCached > 20 * _MB - 8 * _MB);
+  /* the largest classes go first */
+  void *small = PTDBufferPoolAlloc(40 * _KB);
+  PTDBufferPoolFree(small, 40 * _KB);
+  PTDBufferPoolTrim(48 * _KB);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.bytesCached == 48 * _KB);
+  PTDBufferPoolTrim(0);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.bytesCached == 0);
+}
+
+
+enum { STRESS_THREADS = 4, STRESS_ROUNDS = 2000 };
+
+
+static void *PTDTestStress(void *arg)
+{
+  uint64_t rng = (uint64_t)(uintptr_t)arg * 0x9E3779B97F4A7C15ULL + 1;
+  uint8_t tag = (uint8_t)(uintptr_t)arg;
+  void *held[8] = {NULL};
+  size_t sizes[8] = {0};
+  int failures = 0;
+  for (int round = 0; round < STRESS_ROUNDS; round++) {
+    size_t slot = PTDTestRandomBelow(&rng, 8);
+    if (held[slot]) {
+      /* nobody else wrote into the buffer while this thread held it */
+      const uint8_t *bytes = held[slot];
+      failures += bytes[0] != tag || bytes[sizes[slot] / 2] != tag || bytes[sizes[slot] - 1] != tag;
+      PTDBufferPoolFree(held[slot], sizes[slot]);
+      held[slot] = NULL;
+    } else {
+      sizes[slot] = 8 * _KB + PTDTestRandomBelow(&rng, 2 * _MB);
+      held[slot] = PTDBufferPoolAlloc(sizes[slot]);
+      uint8_t *bytes = held[slot];
+      bytes[0] = bytes[sizes[slot] / 2] = bytes[sizes[slot] - 1] = tag;
+    }
+  }
+  for (int i = 0; i < 8; i++)
+    PTDBufferPoolFree(held[i], sizes[i]);
+  return (void *)(intptr_t)failures;
+}
+
+
+static void testConcurrentUse(void)
+{
+  PTDBufferPoolStatistics before, after;
+  PTDBufferPoolGetStatistics(&before);
+  pthread_t threads[STRESS_THREADS];
+  for (int i = 0; i < STRESS_THREADS; i++)
+    pthread_create(&threads[i], NULL, PTDTestStress, (void *)(uintptr_t)(i + 1));
+  intptr_t failures = 0;
+  for (int i = 0; i < STRESS_THREADS; i++) {
+    void *res;
+    pthread_join(threads[i], &res);
+    failures += (intptr_t)res;
+  }
+  PTD_CHECK(failures == 0);
+  PTDBufferPoolGetStatistics(&after);
+  PTD_CHECK(after.bytesInUse == before.bytesInUse);
+  PTD_CHECK(after.reuses > before.reuses);
+  PTDBufferPoolTrim(0);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testReuse);
+  PTD_RUN(testSizeClasses);
+  PTD_RUN(testCacheLimitAndTrim);
+  PTD_RUN(testConcurrentUse);
+  return PTDTestFinish();
+}
@@ -0,0 +1,141 @@
+//
+// PTDCanvasObjectGridBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "PTDTest.h"
+#include "PTDCanvasObjectGrid.h"
+
+
+/* Canvases with hundreds of shapes and text boxes spread over a 1440x900
+ * point screen, queried the way the canvas object list does: hit testing
+ * under the cursor, finding the objects to redraw in a tile, and finding
+ * the objects to flatten under a stroke. The linear scan is what the
+ * queries would cost without the grid. */
+
+static const double _CellSize = 256.0;
+static const size_t _Queries = 1000;
+
+
+static PTDCanvasObjectGridRect PTDBenchRandomRect(uint64_t *rng, double maxSize)
+{
+  PTDCanvasObjectGridRect rect;
+  rect.width = 4.0 + (double)PTDTestRandomBelow(rng, (size_t)maxSize);
+  rect.height = 4.0 + (double)PTDTestRandomBelow(rng, (size_t)maxSize);
+  rect.x = (double)PTDTestRandomBelow(rng, 1440);
+  rect.y = (double)PTDTestRandomBelow(rng, 900);
+  return rect;
+}
+
+
+static size_t PTDBenchLinearScan(const PTDCanvasObjectGridEntry *objects, size_t count, const PTDCanvasObjectGridRect *rects)
+{
+  size_t found = 0;
+  for (size_t q = 0; q < _Queries; q++) {
+    PTDCanvasObjectGridRect r = rects[q];
+    for (size_t i = 0; i < count; i++) {
+      PTDCanvasObjectGridRect b = objects[i].bounds;
+      found += r.x < b.x + b.width && b.x < r.x + r.width && r.y < b.y + b.height && b.y < r.y + r.height;
+    }
+  }
+  return found;
+}
+
+
+int main(void)
+{
+  static const size_t counts[] = {100, 300, 1000};
+  PTDCanvasObjectGridRect *rects = malloc(_Queries * sizeof(PTDCanvasObjectGridRect));
+  volatile size_t sink = 0;
+  
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    size_t count = counts[c];
+    PTDCanvasObjectGridEntry *objects = malloc(count * sizeof(PTDCanvasObjectGridEntry));
+    uint64_t rng = 1;
+    for (size_t i = 0; i < count; i++)
+      objects[i] = (PTDCanvasObjectGridEntry){i, PTDBenchRandomRect(&rng, 200.0)};
+    for (size_t q = 0; q < _Queries; q++)
+      rects[q] = PTDBenchRandomRect(&rng, 30.0);
+    
+    PTDCanvasObjectGrid *grid = PTDCanvasObjectGridCreate(_CellSize);
+    PTDCanvasObjectGridList list = {0};
+    char name[80];
+    
+    snprintf(name, sizeof(name), "%zu objects, insert all", count);
+    PTD_BENCH(name, 0.5,
+      PTDCanvasObjectGridRemoveAll(grid);
+      for (size_t i = 0; i < count; i++)
+        PTDCanvasObjectGridInsert(grid, objects[i].order, objects[i].bounds));
+    
+    snprintf(name, sizeof(name), "%zu objects, 1k replacements", count);
+    PTD_BENCH(name, 0.5,
+      for (size_t q = 0; q < _Queries; q++) {
+        PTDCanvasObjectGridEntry *object = &objects[(q * 7919) % count];
+        PTDCanvasObjectGridRemove(grid, object->order, object->bounds);
+        object->bounds.x += q % 2 ? 1.0 : -1.0;
+        PTDCanvasObjectGridInsert(grid, object->order, object->bounds);
+      });
+    
+    snprintf(name, sizeof(name), "%zu objects, 1k hit tests", count);
+    PTD_BENCH(name, 0.5,
+      for (size_t q = 0; q < _Queries; q++) {
+        long cx0, cy0, cx1, cy1;
+        PTDCanvasObjectGridCellRange(grid, rects[q], &cx0, &cy0, &cx1, &cy1);
+        PTDCanvasObjectGridObjectsInCell(grid, PTDCanvasObjectGridCellKey(cx0, cy0), &list);
+        sink += list.count;
+      });
+    
+    snprintf(name, sizeof(name), "%zu objects, 1k tile queries", count);
+    PTD_BENCH(name, 0.5,
+      for (size_t q = 0; q < _Queries; q++) {
+        long cx0, cy0, cx1, cy1;
+        PTDCanvasObjectGridCellRange(grid, rects[q], &cx0, &cy0, &cx1, &cy1);
+        PTDCanvasObjectGridObjectsInRect(grid, PTDCanvasObjectGridCellRect(grid, PTDCanvasObjectGridCellKey(cx0, cy0)), &list);
+        sink += list.count;
+      });
+    
+    snprintf(name, sizeof(name), "%zu objects, 1k stroke queries", count);
+    PTD_BENCH(name, 0.5,
+      for (size_t q = 0; q < _Queries; q++) {
+        PTDCanvasObjectGridObjectsInRect(grid, rects[q], &list);
+        sink += list.count;
+      });
+    
+    snprintf(name, sizeof(name), "%zu objects, 1k stroke queries, linear", count);
+    PTD_BENCH(name, 0.5, sink += PTDBenchLinearScan(objects, count, rects));
+    
+    snprintf(name, sizeof(name), "%zu objects, 1k strokes to flatten", count);
+    PTD_BENCH(name, 0.5,
+      for (size_t q = 0; q < _Queries; q++) {
+        PTDCanvasObjectGridObjectsInRectAndBelow(grid, rects[q], &list);
+        sink += list.count;
+      });
+    
+    PTDCanvasObjectGridListFree(&list);
+    PTDCanvasObjectGridDestroy(grid);
+    free(objects);
+  }
+  
+  free(rects);
+  return 0;
+}
@@ -0,0 +1,275 @@
+//
+// PTDCanvasObjectGridTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDCanvasObjectGrid.h"
+
+
+/* The queries are checked against a linear scan of the same objects */
+
+typedef struct {
+  uint64_t order;
+  PTDCanvasObjectGridRect bounds;
+  int present;
+} PTDTestObject;
+
+static const double _CellSize = 256.0;
+
+
+static int PTDTestIntersects(PTDCanvasObjectGridRect a, PTDCanvasObjectGridRect b)
+{
+  return a.width > 0 && a.height > 0 && b.width > 0 && b.height > 0 &&
+      a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+
+static PTDCanvasObjectGridRect PTDTestRandomRect(uint64_t *rng, double maxSize)
+{
+  PTDCanvasObjectGridRect rect;
+  rect.x = (double)PTDTestRandomBelow(rng, 3000) - 500.0;
+  rect.y = (double)PTDTestRandomBelow(rng, 2000) - 500.0;
+  rect.width = 1.0 + (double)PTDTestRandomBelow(rng, (size_t)maxSize);
+  rect.height = 1.0 + (double)PTDTestRandomBelow(rng, (size_t)maxSize);
+  return rect;
+}
+
+
+/* Checks that the list has exactly the objects flagged in expected, in
+ * stacking order */
+static int PTDTestListMatches(const PTDCanvasObjectGridList *list, const PTDTestObject *objects, const int *expected, size_t count)
+{
+  size_t j = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!expected[i])
+      continue;
+    if (j >= list->count || list->entries[j].order != objects[i].order)
+      return 0;
+    j++;
+  }
+  return j == list->count;
+}
+
+
+static void testCellKeys(void)
+{
+  PTDCanvasObjectGrid *grid = PTDCanvasObjectGridCreate(_CellSize);
+  static const long coords[][2] = {{0, 0}, {-1, 0}, {0, -1}, {-1, -1}, {5, -7}, {-100000, 100000}};
+  size_t n = sizeof(coords) / sizeof(coords[0]);
+  for (size_t i = 0; i < n; i++) {
+    uint64_t key = PTDCanvasObjectGridCellKey(coords[i][0], coords[i][1]);
+    PTDCanvasObjectGridRect rect = PTDCanvasObjectGridCellRect(grid, key);
+    PTD_CHECK(rect.x == coords[i][0] * _CellSize && rect.y == coords[i][1] * _CellSize);
+    PTD_CHECK(rect.width == _CellSize && rect.height == _CellSize);
+    for (size_t j = 0; j < i; j++)
+      PTD_CHECK(key != PTDCanvasObjectGridCellKey(coords[j][0], coords[j][1]));
+  }
+  
+  long cx0, cy0, cx1, cy1;
+  PTD_CHECK(PTDCanvasObjectGridCellRange(grid, (PTDCanvasObjectGridRect){-10, -300, 20, 600}, &cx0, &cy0, &cx1, &cy1));
+  PTD_CHECK(cx0 == -1 && cx1 == 0 && cy0 == -2 && cy1 == 1);
+  PTD_CHECK(!PTDCanvasObjectGridCellRange(grid, (PTDCanvasObjectGridRect){10, 10, 0, 5}, &cx0, &cy0, &cx1, &cy1));
+  PTDCanvasObjectGridDestroy(grid);
+}
+
+
+static void testQueriesMatchLinearScan(void)
+{
+  enum { count = 400 };
+  PTDTestObject objects[count];
+  int expected[count];
+  PTDCanvasObjectGrid *grid = PTDCanvasObjectGridCreate(_CellSize);
+  PTDCanvasObjectGridList list = {0};
+  uint64_t rng = 7;
+  
+  for (size_t i = 0; i < count; i++) {
+    objects[i] = (PTDTestObject){i * 3 + 1, PTDTestRandomRect(&rng, i % 10 == 0 ? 900.0 : 120.0), 1};
+    PTD_CHECK(PTDCanvasObjectGridInsert(grid, objects[i].order, objects[i].bounds));
+  }
+  
+  for (int round = 0; round < 3; round++) {
+    /* removes some objects, and moves others keeping their place in the
+     * stacking order, like replacing them does */
+    for (size_t i = 0; i < count; i++) {
+      size_t action = PTDTestRandomBelow(&rng, 6);
+      if (objects[i].present && action == 0) {
+        PTDCanvasObjectGridRemove(grid, objects[i].order, objects[i].bounds);
+        objects[i].present = 0;
+      } else if (objects[i].present && action == 1) {
+        PTDCanvasObjectGridRemove(grid, objects[i].order, objects[i].bounds);
+        objects[i].bounds = PTDTestRandomRect(&rng, 200.0);
+        PTD_CHECK(PTDCanvasObjectGridInsert(grid, objects[i].order, objects[i].bounds));
+      }
+    }
+    size_t present = 0;
+    for (size_t i = 0; i < count; i++)
+      present += (size_t)objects[i].present;
+    PTD_CHECK(PTDCanvasObjectGridCount(grid) == present);
+    
+    int ok = 1;
+    for (int q = 0; q < 200; q++) {
+      PTDCanvasObjectGridRect rect = PTDTestRandomRect(&rng, q % 4 == 0 ? 1500.0 : 60.0);
+      for (size_t i = 0; i < count; i++)
+        expected[i] = objects[i].present && PTDTestIntersects(objects[i].bounds, rect);
+      ok &= PTDCanvasObjectGridObjectsInRect(grid, rect, &list);
+      ok &= PTDTestListMatches(&list, objects, expected, count);
+    }
+    PTD_CHECK(ok);
+  }
+  
+  PTDCanvasObjectGridListFree(&list);
+  PTDCanvasObjectGridDestroy(grid);
+}
+
+
+static void testObjectsInCell(void)
+{
+  PTDCanvasObjectGrid *grid = PTDCanvasObjectGridCreate(_CellSize);
+  PTDCanvasObjectGridList list = {0};
+  /* inserted out of stacking order */
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 20, (PTDCanvasObjectGridRect){-100, -100, 600, 200}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 10, (PTDCanvasObjectGridRect){10, 10, 20, 20}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 30, (PTDCanvasObjectGridRect){300, 10, 20, 20}));
+  
+  PTD_CHECK(PTDCanvasObjectGridObjectsInCell(grid, PTDCanvasObjectGridCellKey(0, 0), &list));
+  PTD_CHECK(list.count == 2 && list.entries[0].order == 10 && list.entries[1].order == 20);
+  PTD_CHECK(PTDCanvasObjectGridObjectsInCell(grid, PTDCanvasObjectGridCellKey(-1, -1), &list));
+  PTD_CHECK(list.count == 1 && list.entries[0].order == 20);
+  PTD_CHECK(list.entries[0].bounds.width == 600);
+  PTD_CHECK(PTDCanvasObjectGridObjectsInCell(grid, PTDCanvasObjectGridCellKey(1, 0), &list));
+  PTD_CHECK(list.count == 2 && list.entries[0].order == 20 && list.entries[1].order == 30);
+  PTD_CHECK(PTDCanvasObjectGridObjectsInCell(grid, PTDCanvasObjectGridCellKey(5, 5), &list));
+  PTD_CHECK(list.count == 0);
+  
+  /* found once even though it covers six cells */
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRect(grid, (PTDCanvasObjectGridRect){-1000, -1000, 3000, 3000}, &list));
+  PTD_CHECK(list.count == 3 && list.entries[0].order == 10 && list.entries[1].order == 20 && list.entries[2].order == 30);
+  
+  PTDCanvasObjectGridRemove(grid, 20, (PTDCanvasObjectGridRect){-100, -100, 600, 200});
+  PTD_CHECK(PTDCanvasObjectGridObjectsInCell(grid, PTDCanvasObjectGridCellKey(0, 0), &list));
+  PTD_CHECK(list.count == 1 && list.entries[0].order == 10);
+  
+  PTDCanvasObjectGridListFree(&list);
+  PTDCanvasObjectGridDestroy(grid);
+}
+
+
+static void testObjectsInRectAndBelow(void)
+{
+  PTDCanvasObjectGrid *grid = PTDCanvasObjectGridCreate(_CellSize);
+  PTDCanvasObjectGridList list = {0};
+  /* 1 is below 2 and overlaps it, 0 is below 1 and overlaps only 1, 4 is
+   * below 2 but apart from everything, 5 is above 2 and overlaps it */
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 1, (PTDCanvasObjectGridRect){0, 0, 100, 100}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 2, (PTDCanvasObjectGridRect){50, 50, 100, 100}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 5, (PTDCanvasObjectGridRect){140, 140, 100, 100}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 0, (PTDCanvasObjectGridRect){-50, -50, 60, 60}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 4, (PTDCanvasObjectGridRect){1000, 0, 10, 10}));
+  
+  /* touches only 2 */
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRectAndBelow(grid, (PTDCanvasObjectGridRect){120, 120, 10, 10}, &list));
+  PTD_CHECK(list.count == 3 && list.entries[0].order == 0 && list.entries[1].order == 1 && list.entries[2].order == 2);
+  /* touches only 5, which overlaps only 2 */
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRectAndBelow(grid, (PTDCanvasObjectGridRect){200, 200, 10, 10}, &list));
+  PTD_CHECK(list.count == 4 && list.entries[3].order == 5);
+  /* touches only 0 */
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRectAndBelow(grid, (PTDCanvasObjectGridRect){-40, -40, 10, 10}, &list));
+  PTD_CHECK(list.count == 1 && list.entries[0].order == 0);
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRectAndBelow(grid, (PTDCanvasObjectGridRect){500, 500, 10, 10}, &list));
+  PTD_CHECK(list.count == 0);
+  
+  /* random scenes, against the fixed point computed by a linear scan */
+  enum { count = 150 };
+  PTDTestObject objects[count];
+  int expected[count];
+  uint64_t rng = 11;
+  int ok = 1;
+  for (int scene = 0; scene < 20; scene++) {
+    PTDCanvasObjectGridRemoveAll(grid);
+    for (size_t i = 0; i < count; i++) {
+      objects[i] = (PTDTestObject){i, PTDTestRandomRect(&rng, 150.0), 1};
+      ok &= PTDCanvasObjectGridInsert(grid, objects[i].order, objects[i].bounds);
+    }
+    for (int q = 0; q < 20; q++) {
+      PTDCanvasObjectGridRect rect = PTDTestRandomRect(&rng, 80.0);
+      for (size_t i = 0; i < count; i++)
+        expected[i] = PTDTestIntersects(objects[i].bounds, rect);
+      int changed;
+      do {
+        changed = 0;
+        for (size_t i = 0; i < count; i++) {
+          for (size_t j = i + 1; j < count && !expected[i]; j++) {
+            if (expected[j] && PTDTestIntersects(objects[i].bounds, objects[j].bounds))
+              expected[i] = changed = 1;
+          }
+        }
+      } while (changed);
+      ok &= PTDCanvasObjectGridObjectsInRectAndBelow(grid, rect, &list);
+      ok &= PTDTestListMatches(&list, objects, expected, count);
+    }
+  }
+  PTD_CHECK(ok);
+  
+  PTDCanvasObjectGridListFree(&list);
+  PTDCanvasObjectGridDestroy(grid);
+}
+
+
+static void testEmptyBoundsAndRemoveAll(void)
+{
+  PTDCanvasObjectGrid *grid = PTDCanvasObjectGridCreate(_CellSize);
+  PTDCanvasObjectGridList list = {0};
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 1, (PTDCanvasObjectGridRect){10, 10, 0, 0}));
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 2, (PTDCanvasObjectGridRect){10, 10, 5, 5}));
+  PTD_CHECK(PTDCanvasObjectGridCount(grid) == 2);
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRect(grid, (PTDCanvasObjectGridRect){0, 0, 100, 100}, &list));
+  PTD_CHECK(list.count == 1 && list.entries[0].order == 2);
+  /* an empty rect intersects nothing */
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRect(grid, (PTDCanvasObjectGridRect){12, 12, 0, 0}, &list));
+  PTD_CHECK(list.count == 0);
+  
+  PTDCanvasObjectGridRemoveAll(grid);
+  PTD_CHECK(PTDCanvasObjectGridCount(grid) == 0);
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRect(grid, (PTDCanvasObjectGridRect){0, 0, 100, 100}, &list));
+  PTD_CHECK(list.count == 0);
+  PTD_CHECK(PTDCanvasObjectGridInsert(grid, 3, (PTDCanvasObjectGridRect){10, 10, 5, 5}));
+  PTD_CHECK(PTDCanvasObjectGridObjectsInRect(grid, (PTDCanvasObjectGridRect){0, 0, 100, 100}, &list));
+  PTD_CHECK(list.count == 1 && list.entries[0].order == 3);
+  
+  PTDCanvasObjectGridListFree(&list);
+  PTDCanvasObjectGridDestroy(grid);
+  PTD_CHECK(PTDCanvasObjectGridCreate(0.0) == NULL);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testCellKeys);
+  PTD_RUN(testQueriesMatchLinearScan);
+  PTD_RUN(testObjectsInCell);
+  PTD_RUN(testObjectsInRectAndBelow);
+  PTD_RUN(testEmptyBoundsAndRemoveAll);
+  return PTDTestFinish();
+}
@@ -0,0 +1,72 @@
+//
+// PTDCanvasStoreBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDCanvasStore.h"
+
+
+/* Background readers of a canvas used to get a copy of the whole buffer,
+ * made on the main thread. Now the main thread publishes only the tiles a
+ * stroke touched, and the readers acquire the frame without waiting. */
+
+#define WIDTH 5120
+#define HEIGHT 2880
+
+
+int main(void)
+{
+  uint64_t rng = 5;
+  PTDPixelBuffer canvas = {calloc(WIDTH * HEIGHT, 4), WIDTH, HEIGHT, WIDTH * 4};
+  PTDPixelBuffer copy = {malloc(WIDTH * HEIGHT * 4), WIDTH, HEIGHT, WIDTH * 4};
+  memset(canvas.data, 0xFF, WIDTH * HEIGHT * 4 / 2);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(WIDTH, HEIGHT);
+  PTDCanvasStorePublish(store, &canvas, 0, 0, WIDTH, HEIGHT);
+  
+  PTD_BENCH("copy of the whole canvas, 5K", 0.5, {
+    memcpy(copy.data, canvas.data, WIDTH * HEIGHT * 4);
+  });
+  PTD_BENCH("publish, whole canvas, 5K", 0.5, {
+    PTDCanvasStorePublish(store, &canvas, 0, 0, WIDTH, HEIGHT);
+  });
+  PTD_BENCH("publish, 200x200 px stroke, 5K", 0.5, {
+    size_t x = PTDTestRandomBelow(&rng, WIDTH - 200), y = PTDTestRandomBelow(&rng, HEIGHT - 200);
+    PTDCanvasStorePublish(store, &canvas, x, y, x + 200, y + 200);
+  });
+  PTD_BENCH("acquire and release a frame", 0.5, {
+    PTDCanvasFrameRelease(PTDCanvasStoreAcquireFrame(store));
+  });
+  
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTD_BENCH("frame copy, whole canvas, 5K", 0.5, {
+    PTDCanvasFrameCopyPixels(frame, 0, 0, &copy);
+  });
+  PTDCanvasFrameRelease(frame);
+  
+  PTDCanvasStoreRelease(store);
+  free(canvas.data);
+  free(copy.data);
+  return 0;
+}
@@ -0,0 +1,284 @@
+//
+// PTDCanvasStoreTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "PTDTest.h"
+#include "PTDCanvasStore.h"
+
+
+#define TILE 64
+
+
+static uint8_t *PTDTestCanvasCreate(size_t width, size_t height, PTDPixelBuffer *buffer)
+{
+  uint8_t *pixels = calloc(width * height, 4);
+  *buffer = (PTDPixelBuffer){pixels, width, height, width * 4};
+  return pixels;
+}
+
+
+static void PTDTestFillRect(const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1, uint32_t value)
+{
+  for (size_t y = y0; y < y1; y++) {
+    uint32_t *row = (uint32_t *)(canvas->data + y * canvas->bytesPerRow);
+    for (size_t x = x0; x < x1; x++)
+      row[x] = value;
+  }
+}
+
+
+static int PTDTestFrameEquals(const PTDCanvasFrame *frame, const PTDPixelBuffer *canvas)
+{
+  PTDPixelBuffer copy;
+  uint8_t *pixels = PTDTestCanvasCreate(canvas->width, canvas->height, &copy);
+  PTDCanvasFrameCopyPixels(frame, 0, 0, &copy);
+  int equal = 1;
+  for (size_t y = 0; y < canvas->height && equal; y++)
+    equal = memcmp(copy.data + y * copy.bytesPerRow, canvas->data + y * canvas->bytesPerRow, canvas->width * 4) == 0;
+  free(pixels);
+  return equal;
+}
+
+
+static void testPublishAndCopy(void)
+{
+  /* not a multiple of the tile size, to cover the partial tiles */
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(300, 170, &canvas);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(300, 170);
+  PTD_CHECK(PTDCanvasStoreAcquireFrame(store) == NULL);
+  
+  PTDTestFillRect(&canvas, 10, 20, 290, 165, 0x80402010);
+  PTD_CHECK(PTDCanvasStorePublish(store, &canvas, 0, 0, 300, 170) == 1);
+  PTDCanvasFrame *first = PTDCanvasStoreAcquireFrame(store);
+  PTD_CHECK(PTDCanvasFrameGeneration(first) == 1);
+  PTD_CHECK(PTDTestFrameEquals(first, &canvas));
+  
+  /* only the published rect is taken from the canvas */
+  PTDTestFillRect(&canvas, 0, 0, 300, 170, 0xff0000ff);
+  PTD_CHECK(PTDCanvasStorePublish(store, &canvas, 100, 100, 101, 101) == 2);
+  PTDCanvasFrame *second = PTDCanvasStoreAcquireFrame(store);
+  PTDPixelBuffer expected;
+  uint8_t *expectedPixels = PTDTestCanvasCreate(300, 170, &expected);
+  PTDTestFillRect(&expected, 10, 20, 290, 165, 0x80402010);
+  PTDTestFillRect(&expected, 64, 64, 128, 128, 0xff0000ff);
+  PTD_CHECK(PTDTestFrameEquals(second, &expected));
+  
+  /* older frames do not change */
+  PTDTestFillRect(&expected, 0, 0, 300, 170, 0);
+  PTDTestFillRect(&expected, 10, 20, 290, 165, 0x80402010);
+  PTD_CHECK(PTDTestFrameEquals(first, &expected));
+  
+  /* unchanged tiles are shared */
+  PTD_CHECK(PTDCanvasFrameAllocatedSize(second) == PTDCanvasFrameAllocatedSize(first));
+  
+  PTDCanvasFrameRelease(first);
+  PTDCanvasFrameRelease(second);
+  PTDCanvasStoreRelease(store);
+  free(pixels);
+  free(expectedPixels);
+}
+
+
+static void testTransparentTiles(void)
+{
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(256, 256, &canvas);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(256, 256);
+  
+  PTDCanvasStorePublish(store, &canvas, 0, 0, 256, 256);
+  PTDCanvasFrame *empty = PTDCanvasStoreAcquireFrame(store);
+  size_t x0, y0, x1, y1;
+  PTD_CHECK(PTDCanvasFrameContentBounds(empty, &x0, &y0, &x1, &y1) == 0);
+  PTD_CHECK(x0 == 0 && y0 == 0 && x1 == 0 && y1 == 0);
+  size_t emptySize = PTDCanvasFrameAllocatedSize(empty);
+  
+  PTDTestFillRect(&canvas, 70, 130, 71, 131, 0x01000000);
+  PTDTestFillRect(&canvas, 200, 10, 201, 11, 0x01000000);
+  PTDCanvasStorePublish(store, &canvas, 0, 0, 256, 256);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTD_CHECK(PTDCanvasFrameContentBounds(frame, &x0, &y0, &x1, &y1) == 1);
+  PTD_CHECK(x0 == 64 && y0 == 0 && x1 == 256 && y1 == 192);
+  PTD_CHECK(PTDCanvasFrameAllocatedSize(frame) > emptySize);
+  
+  /* erasing shrinks the bounds back */
+  PTDTestFillRect(&canvas, 200, 10, 201, 11, 0);
+  PTDCanvasStorePublish(store, &canvas, 200, 10, 201, 11);
+  PTDCanvasFrame *erased = PTDCanvasStoreAcquireFrame(store);
+  PTD_CHECK(PTDCanvasFrameContentBounds(erased, &x0, &y0, &x1, &y1) == 1);
+  PTD_CHECK(x0 == 64 && y0 == 128 && x1 == 128 && y1 == 192);
+  
+  PTDCanvasFrameRelease(empty);
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasFrameRelease(erased);
+  PTDCanvasStoreRelease(store);
+  free(pixels);
+}
+
+
+static void testEmptyFirstFrame(void)
+{
+  PTDCanvasStore *store = PTDCanvasStoreCreate(100, 100);
+  PTD_CHECK(PTDCanvasStorePublish(store, NULL, 0, 0, 0, 0) == 1);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTD_CHECK(frame != NULL);
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(100, 100, &canvas);
+  PTD_CHECK(PTDTestFrameEquals(frame, &canvas));
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasStoreRelease(store);
+  free(pixels);
+}
+
+
+static void testFrameOutlivesStore(void)
+{
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(128, 128, &canvas);
+  PTDTestFillRect(&canvas, 0, 0, 128, 128, 0xffffffff);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(128, 128);
+  PTDCanvasStorePublish(store, &canvas, 0, 0, 128, 128);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  for (int i = 0; i < 10; i++)
+    PTDCanvasStorePublish(store, &canvas, 0, 0, 128, 128);
+  PTDCanvasStoreRelease(store);
+  PTD_CHECK(PTDTestFrameEquals(frame, &canvas));
+  PTDCanvasFrameRelease(frame);
+  free(pixels);
+}
+
+
+/* The writer stamps every tile it publishes with the generation of the
+ * frame, so a reader can tell a torn or recycled frame: all the pixels of
+ * a tile must be equal, and never newer than the frame. */
+
+#define STRESS_WIDTH (TILE * 12 + 17)
+#define STRESS_HEIGHT (TILE * 8 + 5)
+#define STRESS_READERS 4
+#define STRESS_FRAMES 3000
+
+typedef struct {
+  PTDCanvasStore *store;
+  _Atomic int done;
+  _Atomic long framesRead;
+  _Atomic long errors;
+} PTDStressContext;
+
+
+static void *PTDStressReader(void *arg)
+{
+  PTDStressContext *ctx = arg;
+  PTDPixelBuffer copy;
+  uint8_t *pixels = PTDTestCanvasCreate(STRESS_WIDTH, STRESS_HEIGHT, &copy);
+  uint64_t lastGeneration = 0;
+  
+  while (!atomic_load(&ctx->done)) {
+    PTDCanvasStore *store = PTDCanvasStoreRetain(ctx->store);
+    PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+    PTDCanvasStoreRelease(store);
+    if (!frame)
+      continue;
+    
+    uint64_t generation = PTDCanvasFrameGeneration(frame);
+    if (generation < lastGeneration)
+      atomic_fetch_add(&ctx->errors, 1);
+    lastGeneration = generation;
+    
+    PTDCanvasFrameCopyPixels(frame, 0, 0, &copy);
+    for (size_t ty = 0; ty * TILE < STRESS_HEIGHT; ty++) {
+      for (size_t tx = 0; tx * TILE < STRESS_WIDTH; tx++) {
+        uint32_t first = *(uint32_t *)(copy.data + ty * TILE * copy.bytesPerRow + tx * TILE * 4);
+        if (first > generation)
+          atomic_fetch_add(&ctx->errors, 1);
+        for (size_t y = ty * TILE; y < (ty + 1) * TILE && y < STRESS_HEIGHT; y++) {
+          const uint32_t *row = (const uint32_t *)(copy.data + y * copy.bytesPerRow);
+          for (size_t x = tx * TILE; x < (tx + 1) * TILE && x < STRESS_WIDTH; x++) {
+            if (row[x] != first)
+              atomic_fetch_add(&ctx->errors, 1);
+          }
+        }
+      }
+    }
+    PTDCanvasFrameRelease(frame);
+    atomic_fetch_add(&ctx->framesRead, 1);
+  }
+  free(pixels);
+  return NULL;
+}
+
+
+static void testConcurrentReadersAndWriter(void)
+{
+  PTDStressContext ctx = {0};
+  ctx.store = PTDCanvasStoreCreate(STRESS_WIDTH, STRESS_HEIGHT);
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(STRESS_WIDTH, STRESS_HEIGHT, &canvas);
+  
+  pthread_t readers[STRESS_READERS];
+  for (int i = 0; i < STRESS_READERS; i++)
+    pthread_create(&readers[i], NULL, PTDStressReader, &ctx);
+  
+  uint64_t rng = 42;
+  for (uint32_t generation = 1; generation <= STRESS_FRAMES; generation++) {
+    size_t x0 = PTDTestRandomBelow(&rng, STRESS_WIDTH);
+    size_t y0 = PTDTestRandomBelow(&rng, STRESS_HEIGHT);
+    size_t x1 = x0 + 1 + PTDTestRandomBelow(&rng, STRESS_WIDTH - x0);
+    size_t y1 = y0 + 1 + PTDTestRandomBelow(&rng, STRESS_HEIGHT - y0);
+    /* every tile touched by the rect is published whole */
+    size_t tx0 = x0 / TILE * TILE, ty0 = y0 / TILE * TILE;
+    size_t tx1 = (x1 + TILE - 1) / TILE * TILE, ty1 = (y1 + TILE - 1) / TILE * TILE;
+    PTDTestFillRect(&canvas, tx0, ty0, tx1 < STRESS_WIDTH ? tx1 : STRESS_WIDTH, ty1 < STRESS_HEIGHT ? ty1 : STRESS_HEIGHT, generation);
+    /* with the first frame, the whole canvas */
+    if (generation == 1)
+      PTD_CHECK(PTDCanvasStorePublish(ctx.store, &canvas, 0, 0, STRESS_WIDTH, STRESS_HEIGHT) == generation);
+    else
+      PTD_CHECK(PTDCanvasStorePublish(ctx.store, &canvas, x0, y0, x1, y1) == generation);
+  }
+  /* let the readers see the last frames too */
+  while (atomic_load(&ctx.framesRead) < STRESS_READERS * 4)
+    sched_yield();
+  atomic_store(&ctx.done, 1);
+  for (int i = 0; i < STRESS_READERS; i++)
+    pthread_join(readers[i], NULL);
+  
+  PTD_CHECK(atomic_load(&ctx.errors) == 0);
+  PTD_CHECK(atomic_load(&ctx.framesRead) > 0);
+  PTDCanvasStoreRelease(ctx.store);
+  free(pixels);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testPublishAndCopy);
+  PTD_RUN(testTransparentTiles);
+  PTD_RUN(testEmptyFirstFrame);
+  PTD_RUN(testFrameOutlivesStore);
+  PTD_RUN(testConcurrentReadersAndWriter);
+  return PTDTestFinish();
+}
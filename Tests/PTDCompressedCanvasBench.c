@@ -0,0 +1,95 @@
+//
+// PTDCompressedCanvasBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDCompressedCanvas.h"
+
+
+/* A 5K canvas left alone for a while takes 56 MB for its buffer and as
+ * much for its published frame. Compressed, a typical drawing on it takes
+ * a small fraction of that, and it is restored in a couple of frames when
+ * it is used again. */
+
+#define WIDTH 5120
+#define HEIGHT 2880
+
+
+static void PTDBenchCanvas(const char *name, const PTDPixelBuffer *canvas)
+{
+  PTDCanvasStore *store = PTDCanvasStoreCreate(canvas->width, canvas->height);
+  PTDCanvasStorePublish(store, canvas, 0, 0, canvas->width, canvas->height);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTDPixelBuffer out = {malloc(canvas->height * canvas->bytesPerRow), canvas->width, canvas->height, canvas->bytesPerRow};
+  char label[64];
+  
+  PTDCompressedCanvas *compressed = PTDCompressedCanvasCreate(frame);
+  printf("%s: %zu bytes, %.2f%% of the buffer\n", name, PTDCompressedCanvasSize(compressed),
+      100.0 * (double)PTDCompressedCanvasSize(compressed) / (double)(canvas->height * canvas->bytesPerRow));
+  snprintf(label, sizeof(label), "compress, %s", name);
+  PTD_BENCH(label, 0.5, {
+    PTDCompressedCanvasDestroy(PTDCompressedCanvasCreate(frame));
+  });
+  snprintf(label, sizeof(label), "decompress, %s", name);
+  PTD_BENCH(label, 0.5, {
+    PTDCompressedCanvasDecompress(compressed, &out);
+  });
+  
+  PTDCompressedCanvasDestroy(compressed);
+  free(out.data);
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasStoreRelease(store);
+}
+
+
+int main(void)
+{
+  uint64_t rng = 11;
+  PTDPixelBuffer canvas = {calloc(WIDTH * HEIGHT, 4), WIDTH, HEIGHT, WIDTH * 4};
+  PTDBenchCanvas("5K, empty", &canvas);
+  
+  /* strokes of a few flat colors, with antialiased edges */
+  for (int i = 0; i < 300; i++) {
+    size_t x = PTDTestRandomBelow(&rng, WIDTH - 400), y = PTDTestRandomBelow(&rng, HEIGHT - 8);
+    uint32_t color = 0xff000000 | (uint32_t)PTDTestRandom(&rng);
+    for (size_t r = 0; r < 8; r++) {
+      uint32_t *row = (uint32_t *)(canvas.data + (y + r) * canvas.bytesPerRow);
+      for (size_t c = 0; c < 400; c++)
+        row[x + c] = (r == 0 || r == 7) ? (color & 0x7fffffff) : color;
+    }
+  }
+  PTDBenchCanvas("5K, drawing", &canvas);
+  
+  /* a screenshot pasted on half of it, which barely compresses */
+  for (size_t y = 0; y < HEIGHT / 2; y++) {
+    uint32_t *row = (uint32_t *)(canvas.data + y * canvas.bytesPerRow);
+    for (size_t x = 0; x < WIDTH; x++)
+      row[x] = 0xff000000 | (uint32_t)(PTDTestRandom(&rng) & 0x0f0f0f);
+  }
+  PTDBenchCanvas("5K, half photo", &canvas);
+  
+  free(canvas.data);
+  return 0;
+}
@@ -0,0 +1,239 @@
+//
+// PTDCompressedCanvasTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "PTDTest.h"
+#include "PTDCompressedCanvas.h"
+
+
+#define TILE 64
+#define THREADS 4
+
+
+static uint8_t *PTDTestCanvasCreate(size_t width, size_t height, size_t padding, PTDPixelBuffer *buffer)
+{
+  size_t bytesPerRow = (width + padding) * 4;
+  uint8_t *pixels = calloc(height, bytesPerRow);
+  *buffer = (PTDPixelBuffer){pixels, width, height, bytesPerRow};
+  return pixels;
+}
+
+
+static void PTDTestFillRect(const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1, uint32_t value)
+{
+  for (size_t y = y0; y < y1; y++) {
+    uint32_t *row = (uint32_t *)(canvas->data + y * canvas->bytesPerRow);
+    for (size_t x = x0; x < x1; x++)
+      row[x] = value;
+  }
+}
+
+
+static void PTDTestFillNoise(const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1, uint64_t *rng)
+{
+  for (size_t y = y0; y < y1; y++) {
+    uint32_t *row = (uint32_t *)(canvas->data + y * canvas->bytesPerRow);
+    for (size_t x = x0; x < x1; x++)
+      row[x] = (uint32_t)PTDTestRandom(rng) | 1;
+  }
+}
+
+
+static bool PTDTestPixelsEqual(const PTDPixelBuffer *a, const PTDPixelBuffer *b)
+{
+  for (size_t y = 0; y < a->height; y++)
+    if (memcmp(a->data + y * a->bytesPerRow, b->data + y * b->bytesPerRow, a->width * 4) != 0)
+      return false;
+  return true;
+}
+
+
+static PTDCompressedCanvas *PTDTestCompress(const PTDPixelBuffer *canvas)
+{
+  PTDCanvasStore *store = PTDCanvasStoreCreate(canvas->width, canvas->height);
+  PTDCanvasStorePublish(store, canvas, 0, 0, canvas->width, canvas->height);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTDCompressedCanvas *compressed = PTDCompressedCanvasCreate(frame);
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasStoreRelease(store);
+  return compressed;
+}
+
+
+static bool PTDTestRoundTrip(const PTDPixelBuffer *canvas, size_t padding)
+{
+  PTDCompressedCanvas *compressed = PTDTestCompress(canvas);
+  if (!compressed)
+    return false;
+  PTDPixelBuffer out;
+  uint8_t *pixels = PTDTestCanvasCreate(canvas->width, canvas->height, padding, &out);
+  /* every pixel must be overwritten */
+  memset(pixels, 0x5A, out.height * out.bytesPerRow);
+  bool ok = PTDCompressedCanvasDecompress(compressed, &out) && PTDTestPixelsEqual(canvas, &out);
+  free(pixels);
+  PTDCompressedCanvasDestroy(compressed);
+  return ok;
+}
+
+
+static void testRoundTrip(void)
+{
+  uint64_t rng = 1;
+  /* not a multiple of the tile size, to cover the partial tiles */
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(333, 201, 0, &canvas);
+  PTDTestFillRect(&canvas, 10, 10, 200, 60, 0xff2040ff);
+  PTDTestFillNoise(&canvas, 250, 100, 333, 201, &rng);
+  /* a stroke with antialiased edges */
+  for (size_t x = 0; x < 333; x++) {
+    size_t y = 120 + x / 8;
+    PTDTestFillRect(&canvas, x, y, x + 1, y + 3, 0xff000000 | (uint32_t)x);
+  }
+  PTD_CHECK(PTDTestRoundTrip(&canvas, 0));
+  PTD_CHECK(PTDTestRoundTrip(&canvas, 7));
+  free(pixels);
+  
+  for (int i = 0; i < 20; i++) {
+    size_t width = 1 + PTDTestRandomBelow(&rng, 300), height = 1 + PTDTestRandomBelow(&rng, 300);
+    pixels = PTDTestCanvasCreate(width, height, 0, &canvas);
+    for (int r = 0; r < 5; r++) {
+      size_t x0 = PTDTestRandomBelow(&rng, width), y0 = PTDTestRandomBelow(&rng, height);
+      size_t x1 = x0 + 1 + PTDTestRandomBelow(&rng, width - x0);
+      size_t y1 = y0 + 1 + PTDTestRandomBelow(&rng, height - y0);
+      if (r == 0)
+        PTDTestFillNoise(&canvas, x0, y0, x1, y1, &rng);
+      else
+        PTDTestFillRect(&canvas, x0, y0, x1, y1, (uint32_t)PTDTestRandom(&rng));
+    }
+    PTD_CHECK(PTDTestRoundTrip(&canvas, PTDTestRandomBelow(&rng, 3)));
+    free(pixels);
+  }
+}
+
+
+static void testSizes(void)
+{
+  uint64_t rng = 2;
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(4 * TILE, 4 * TILE, 0, &canvas);
+  
+  /* transparent tiles take no space */
+  PTDCompressedCanvas *empty = PTDTestCompress(&canvas);
+  size_t emptySize = PTDCompressedCanvasSize(empty);
+  PTD_CHECK(emptySize < 1024);
+  PTD_CHECK(PTDCompressedCanvasWidth(empty) == 4 * TILE);
+  PTD_CHECK(PTDCompressedCanvasHeight(empty) == 4 * TILE);
+  PTDCompressedCanvasDestroy(empty);
+  
+  /* flat colors compress well */
+  PTDTestFillRect(&canvas, 0, 0, 4 * TILE, 4 * TILE, 0xff804020);
+  PTDCompressedCanvas *flat = PTDTestCompress(&canvas);
+  PTD_CHECK(PTDCompressedCanvasSize(flat) - emptySize < 16 * TILE * TILE * 4 / 100);
+  PTDCompressedCanvasDestroy(flat);
+  
+  /* tiles which do not compress are stored as they are */
+  PTDTestFillNoise(&canvas, 0, 0, 4 * TILE, 4 * TILE, &rng);
+  PTDCompressedCanvas *noise = PTDTestCompress(&canvas);
+  PTD_CHECK(PTDCompressedCanvasSize(noise) - emptySize == 16 * TILE * TILE * 4);
+  PTDCompressedCanvasDestroy(noise);
+  PTD_CHECK(PTDTestRoundTrip(&canvas, 0));
+  
+  free(pixels);
+}
+
+
+static void testSizeMismatch(void)
+{
+  PTDPixelBuffer canvas, other;
+  uint8_t *pixels = PTDTestCanvasCreate(100, 100, 0, &canvas);
+  uint8_t *otherPixels = PTDTestCanvasCreate(100, 99, 0, &other);
+  PTDTestFillRect(&canvas, 0, 0, 50, 50, 0xffffffff);
+  PTDCompressedCanvas *compressed = PTDTestCompress(&canvas);
+  PTD_CHECK(PTDCompressedCanvasDecompress(compressed, &other) == 0);
+  other.width = 99;
+  other.height = 100;
+  PTD_CHECK(PTDCompressedCanvasDecompress(compressed, &other) == 0);
+  PTDCompressedCanvasDestroy(compressed);
+  free(pixels);
+  free(otherPixels);
+}
+
+
+typedef struct {
+  const PTDCompressedCanvas *compressed;
+  const PTDPixelBuffer *expected;
+  bool ok;
+} PTDTestDecompressThread;
+
+
+static void *PTDTestDecompressThreadMain(void *arg)
+{
+  PTDTestDecompressThread *thread = arg;
+  PTDPixelBuffer out;
+  uint8_t *pixels = PTDTestCanvasCreate(thread->expected->width, thread->expected->height, 0, &out);
+  thread->ok = true;
+  for (int i = 0; i < 10; i++)
+    thread->ok = thread->ok && PTDCompressedCanvasDecompress(thread->compressed, &out) && PTDTestPixelsEqual(thread->expected, &out);
+  free(pixels);
+  return NULL;
+}
+
+
+static void testConcurrentDecompress(void)
+{
+  uint64_t rng = 3;
+  PTDPixelBuffer canvas;
+  uint8_t *pixels = PTDTestCanvasCreate(500, 300, 0, &canvas);
+  PTDTestFillRect(&canvas, 20, 20, 400, 250, 0xff00ff00);
+  PTDTestFillNoise(&canvas, 300, 100, 480, 280, &rng);
+  PTDCompressedCanvas *compressed = PTDTestCompress(&canvas);
+  
+  /* a compressed canvas is only read once created */
+  pthread_t threads[THREADS];
+  PTDTestDecompressThread state[THREADS];
+  for (int i = 0; i < THREADS; i++) {
+    state[i] = (PTDTestDecompressThread){compressed, &canvas, false};
+    pthread_create(&threads[i], NULL, PTDTestDecompressThreadMain, &state[i]);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    PTD_CHECK(state[i].ok);
+  }
+  PTDCompressedCanvasDestroy(compressed);
+  free(pixels);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testRoundTrip);
+  PTD_RUN(testSizes);
+  PTD_RUN(testSizeMismatch);
+  PTD_RUN(testConcurrentDecompress);
+  return PTDTestFinish();
+}
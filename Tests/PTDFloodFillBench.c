@@ -0,0 +1,143 @@
+//
+// PTDFloodFillBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDFloodFill.h"
+
+
+/* Fills of a whole 5K canvas, with and without gap closing, and the worst
+ * cases of a scanline fill: a spiral maze, whose single corridor turns
+ * every few pixels, and a checkerboard, which is all borders */
+
+static const size_t _Width = 5120, _Height = 2880;
+
+
+static void PTDBenchSetPixel(PTDPixelBuffer *canvas, size_t x, size_t y, uint32_t color)
+{
+  memcpy(canvas->data + y * canvas->bytesPerRow + x * 4, &color, 4);
+}
+
+
+static void PTDBenchClear(PTDPixelBuffer *canvas)
+{
+  memset(canvas->data, 0, canvas->bytesPerRow * canvas->height);
+}
+
+
+/* square spiral of 1 pixel walls, turning inwards, which leaves a single
+ * corridor of the given width from the top left corner to the center */
+static void PTDBenchDrawSpiral(PTDPixelBuffer *canvas, size_t corridor)
+{
+  PTDBenchClear(canvas);
+  const long dx[] = {1, 0, -1, 0}, dy[] = {0, 1, 0, -1};
+  long step = (long)corridor + 1;
+  long x = 0, y = 0;
+  for (long i = 0; ; i++) {
+    long length = (i % 2 ? (long)canvas->height : (long)canvas->width) - 1;
+    if (i > 0)
+      length -= step * ((i - 1) / 2);
+    if (length <= step)
+      break;
+    for (long j = 0; j < length; j++, x += dx[i % 4], y += dy[i % 4])
+      PTDBenchSetPixel(canvas, (size_t)x, (size_t)y, 0xFF000000);
+  }
+}
+
+
+static void PTDBenchDrawCheckerboard(PTDPixelBuffer *canvas, size_t cell)
+{
+  for (size_t y = 0; y < canvas->height; y++)
+    for (size_t x = 0; x < canvas->width; x++)
+      PTDBenchSetPixel(canvas, x, y, ((x / cell) ^ (y / cell)) & 1 ? 0xFF000000 : 0);
+}
+
+
+/* random strokes 3 pixels wide, like a canvas covered by handwriting */
+static void PTDBenchDrawStrokes(PTDPixelBuffer *canvas)
+{
+  PTDBenchClear(canvas);
+  uint64_t rng = 5;
+  for (int i = 0; i < 4000; i++) {
+    long x = (long)PTDTestRandomBelow(&rng, canvas->width), y = (long)PTDTestRandomBelow(&rng, canvas->height);
+    for (int j = 0; j < 60; j++) {
+      x += (long)PTDTestRandomBelow(&rng, 7) - 3;
+      y += (long)PTDTestRandomBelow(&rng, 7) - 3;
+      for (long dy = 0; dy < 3; dy++)
+        for (long dx = 0; dx < 3; dx++)
+          if (x + dx >= 0 && y + dy >= 0 && x + dx < (long)canvas->width && y + dy < (long)canvas->height)
+            PTDBenchSetPixel(canvas, (size_t)(x + dx), (size_t)(y + dy), 0xFF402010);
+    }
+  }
+}
+
+
+static void PTDBenchFill(const char *name, const PTDPixelBuffer *canvas, size_t x, size_t y, uint8_t tolerance, unsigned gap)
+{
+  PTDFloodFillOptions options = {tolerance, gap, 1};
+  PTDSelectionMask mask;
+  PTDFloodFill(canvas, x, y, &options, &mask);
+  double area = 0;
+  for (size_t i = 0; i < mask.width * mask.height; i++)
+    area += mask.coverage[i] == 255;
+  PTDSelectionMaskFree(&mask);
+  
+  char title[80];
+  snprintf(title, sizeof(title), "%s (%.1f MP)", name, area / 1e6);
+  PTD_BENCH(title, 1.0,
+      PTDFloodFill(canvas, x, y, &options, &mask),
+      PTDSelectionMaskFree(&mask));
+}
+
+
+int main(void)
+{
+  PTDPixelBuffer canvas = {malloc(_Width * _Height * 4), _Width, _Height, _Width * 4};
+  
+  PTDBenchClear(&canvas);
+  PTDBenchFill("empty 5K canvas", &canvas, 100, 100, 0, 0);
+  PTDBenchFill("empty 5K canvas, tolerance 32", &canvas, 100, 100, 32, 0);
+  PTDBenchFill("empty 5K canvas, closing gaps of 4", &canvas, 100, 100, 0, 4);
+  PTDBenchFill("empty 5K canvas, closing gaps of 10", &canvas, 100, 100, 0, 10);
+  
+  PTDBenchDrawStrokes(&canvas);
+  PTDBenchFill("5K handwriting", &canvas, 0, 0, 32, 0);
+  PTDBenchFill("5K handwriting, closing gaps of 4", &canvas, 0, 0, 32, 4);
+  
+  PTDBenchDrawSpiral(&canvas, 1);
+  PTDBenchFill("5K spiral maze, 1 pixel corridors", &canvas, 1, 1, 0, 0);
+  PTDBenchDrawSpiral(&canvas, 4);
+  PTDBenchFill("5K spiral maze, 4 pixel corridors", &canvas, 1, 1, 0, 0);
+  PTDBenchFill("5K spiral maze, closing gaps of 4", &canvas, 1, 1, 0, 4);
+  
+  PTDBenchDrawCheckerboard(&canvas, 1);
+  PTDBenchFill("5K checkerboard, tolerance 255", &canvas, 0, 0, 255, 0);
+  PTDBenchFill("5K checkerboard, closing gaps of 4", &canvas, 0, 0, 0, 4);
+  PTDBenchDrawCheckerboard(&canvas, 8);
+  PTDBenchFill("5K checkerboard of 8 pixels, closing gaps of 10", &canvas, 0, 0, 0, 10);
+  
+  free(canvas.data);
+  return 0;
+}
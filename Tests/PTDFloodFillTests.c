@@ -0,0 +1,361 @@
+//
+// PTDFloodFillTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDFloodFill.h"
+
+
+/* Straightforward version of the fill, one pixel at a time, to compare
+ * the results with */
+
+typedef struct {
+  size_t width, height;
+  uint8_t *fillable;
+  uint8_t *filled;
+} PTDTestFill;
+
+
+static int PTDTestDistance(const uint8_t *a, const uint8_t *b)
+{
+  int d = 0;
+  for (int c = 0; c < 4; c++) {
+    int dc = abs(a[c] - b[c]);
+    d = dc > d ? dc : d;
+  }
+  return d;
+}
+
+
+static const uint8_t *PTDTestPixel(const PTDPixelBuffer *canvas, size_t x, size_t y)
+{
+  return canvas->data + y * canvas->bytesPerRow + x * 4;
+}
+
+
+static void PTDTestFloodFill(PTDTestFill *f, const uint8_t *fillable, size_t seedX, size_t seedY)
+{
+  size_t n = f->width * f->height;
+  size_t *queue = malloc(n * sizeof(size_t));
+  size_t head = 0, tail = 0;
+  memset(f->filled, 0, n);
+  f->filled[seedY * f->width + seedX] = 1;
+  queue[tail++] = seedY * f->width + seedX;
+  while (head < tail) {
+    size_t i = queue[head++], x = i % f->width, y = i / f->width;
+    size_t next[4] = {x > 0 ? i - 1 : i, x + 1 < f->width ? i + 1 : i, y > 0 ? i - f->width : i, y + 1 < f->height ? i + f->width : i};
+    for (int k = 0; k < 4; k++) {
+      if (fillable[next[k]] && !f->filled[next[k]]) {
+        f->filled[next[k]] = 1;
+        queue[tail++] = next[k];
+      }
+    }
+  }
+  free(queue);
+}
+
+
+static int PTDTestNear(const uint8_t *map, size_t width, size_t height, size_t x, size_t y, size_t r)
+{
+  for (size_t yy = y > r ? y - r : 0; yy <= y + r && yy < height; yy++)
+    for (size_t xx = x > r ? x - r : 0; xx <= x + r && xx < width; xx++)
+      if (map[yy * width + xx])
+        return 1;
+  return 0;
+}
+
+
+static void PTDTestReferenceFill(const PTDPixelBuffer *canvas, size_t seedX, size_t seedY, const PTDFloodFillOptions *options, PTDSelectionMask *mask)
+{
+  size_t w = canvas->width, h = canvas->height, n = w * h;
+  const uint8_t *reference = PTDTestPixel(canvas, seedX, seedY);
+  PTDTestFill f = {w, h, malloc(n), malloc(n)};
+  for (size_t y = 0; y < h; y++)
+    for (size_t x = 0; x < w; x++)
+      f.fillable[y * w + x] = PTDTestDistance(PTDTestPixel(canvas, x, y), reference) <= options->tolerance;
+  
+  size_t r = (options->gapSize + 1) / 2;
+  uint8_t *closed = malloc(n), *walls = malloc(n);
+  for (size_t i = 0; i < n; i++)
+    walls[i] = !f.fillable[i];
+  for (size_t y = 0; y < h; y++)
+    for (size_t x = 0; x < w; x++)
+      closed[y * w + x] = f.fillable[y * w + x] && !PTDTestNear(walls, w, h, x, y, r);
+  
+  if (r == 0 || !closed[seedY * w + seedX]) {
+    PTDTestFloodFill(&f, f.fillable, seedX, seedY);
+  } else {
+    PTDTestFloodFill(&f, closed, seedX, seedY);
+    uint8_t *grown = malloc(n);
+    for (size_t y = 0; y < h; y++)
+      for (size_t x = 0; x < w; x++)
+        grown[y * w + x] = f.fillable[y * w + x] && PTDTestNear(f.filled, w, h, x, y, r);
+    memcpy(f.filled, grown, n);
+    free(grown);
+  }
+  
+  long x0 = (long)w, y0 = (long)h, x1 = -1, y1 = -1;
+  for (size_t y = 0; y < h; y++) {
+    for (size_t x = 0; x < w; x++) {
+      if (!f.filled[y * w + x])
+        continue;
+      x0 = (long)x < x0 ? (long)x : x0;
+      y0 = (long)y < y0 ? (long)y : y0;
+      x1 = (long)x > x1 ? (long)x : x1;
+      y1 = (long)y > y1 ? (long)y : y1;
+    }
+  }
+  long border = options->antialias ? 1 : 0;
+  x0 = x0 - border > 0 ? x0 - border : 0;
+  y0 = y0 - border > 0 ? y0 - border : 0;
+  x1 = x1 + border < (long)w - 1 ? x1 + border : (long)w - 1;
+  y1 = y1 + border < (long)h - 1 ? y1 + border : (long)h - 1;
+  PTDSelectionMaskInit(mask, x0, y0, (size_t)(x1 - x0 + 1), (size_t)(y1 - y0 + 1));
+  
+  for (long y = y0; y <= y1; y++) {
+    for (long x = x0; x <= x1; x++) {
+      uint8_t *m = &mask->coverage[(size_t)(y - y0) * mask->width + (size_t)(x - x0)];
+      size_t i = (size_t)y * w + (size_t)x;
+      if (f.filled[i]) {
+        *m = 255;
+        continue;
+      }
+      int adjacent = (x > 0 && f.filled[i - 1]) || (x + 1 < (long)w && f.filled[i + 1])
+          || (y > 0 && f.filled[i - w]) || (y + 1 < (long)h && f.filled[i + w]);
+      if (!options->antialias || !adjacent)
+        continue;
+      int d = PTDTestDistance(PTDTestPixel(canvas, (size_t)x, (size_t)y), reference);
+      if (d > options->tolerance && options->tolerance < 255)
+        *m = (uint8_t)((255 - d) * 255 / (255 - options->tolerance));
+    }
+  }
+  
+  free(f.fillable);
+  free(f.filled);
+  free(closed);
+  free(walls);
+}
+
+
+static int PTDTestMasksEqual(const PTDSelectionMask *a, const PTDSelectionMask *b)
+{
+  if (a->x != b->x || a->y != b->y || a->width != b->width || a->height != b->height)
+    return 0;
+  return a->width * a->height == 0 || memcmp(a->coverage, b->coverage, a->width * a->height) == 0;
+}
+
+
+static PTDPixelBuffer PTDTestCanvasCreate(size_t width, size_t height)
+{
+  PTDPixelBuffer canvas = {calloc(height, width * 4 + 12), width, height, width * 4 + 12};
+  return canvas;
+}
+
+
+static void PTDTestSetPixel(PTDPixelBuffer *canvas, size_t x, size_t y, uint32_t color)
+{
+  memcpy(canvas->data + y * canvas->bytesPerRow + x * 4, &color, 4);
+}
+
+
+/* random rectangles and lines of a few similar colors */
+static PTDPixelBuffer PTDTestRandomDrawing(size_t width, size_t height, uint64_t seed)
+{
+  static const uint32_t colors[] = {0xFF000000, 0xFF101010, 0x80402000, 0xFF0000FF, 0x20202020};
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(width, height);
+  for (int i = 0; i < 30; i++) {
+    uint32_t color = colors[PTDTestRandomBelow(&seed, 5)];
+    size_t x = PTDTestRandomBelow(&seed, width), y = PTDTestRandomBelow(&seed, height);
+    size_t rw = 1 + PTDTestRandomBelow(&seed, width / 3 + 1), rh = 1 + PTDTestRandomBelow(&seed, height / 3 + 1);
+    if (PTDTestRandomBelow(&seed, 2))
+      rw = 1 + PTDTestRandomBelow(&seed, 3);
+    else
+      rh = 1 + PTDTestRandomBelow(&seed, 3);
+    for (size_t yy = y; yy < y + rh && yy < height; yy++)
+      for (size_t xx = x; xx < x + rw && xx < width; xx++)
+        PTDTestSetPixel(&canvas, xx, yy, color);
+  }
+  return canvas;
+}
+
+
+static void testEmptyCanvas(void)
+{
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(300, 200);
+  PTDFloodFillOptions options = {0, 0, 1};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDFloodFill(&canvas, 150, 100, &options, &mask));
+  PTD_CHECK(mask.x == 0 && mask.y == 0 && mask.width == 300 && mask.height == 200);
+  int full = 1;
+  for (size_t i = 0; i < 300 * 200; i++)
+    full &= mask.coverage[i] == 255;
+  PTD_CHECK(full);
+  PTDSelectionMaskFree(&mask);
+  
+  PTD_CHECK(PTDFloodFill(&canvas, 300, 10, &options, &mask));
+  PTD_CHECK(mask.width == 0 && mask.coverage == NULL);
+  free(canvas.data);
+}
+
+
+static void testClosedShape(void)
+{
+  /* a square outline; the fill stays inside, and the antialiased border
+   * is the outline itself */
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(100, 100);
+  for (size_t i = 20; i <= 80; i++) {
+    PTDTestSetPixel(&canvas, i, 20, 0xFF000000);
+    PTDTestSetPixel(&canvas, i, 80, 0xFF000000);
+    PTDTestSetPixel(&canvas, 20, i, 0xFF000000);
+    PTDTestSetPixel(&canvas, 80, i, 0xFF000000);
+  }
+  PTDFloodFillOptions options = {0, 0, 0};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDFloodFill(&canvas, 50, 50, &options, &mask));
+  PTD_CHECK(mask.x == 21 && mask.y == 21 && mask.width == 59 && mask.height == 59);
+  PTDSelectionMaskFree(&mask);
+  
+  options.antialias = 1;
+  PTD_CHECK(PTDFloodFill(&canvas, 50, 50, &options, &mask));
+  PTD_CHECK(mask.x == 20 && mask.y == 20 && mask.width == 61 && mask.height == 61);
+  PTD_CHECK(mask.coverage[30 * 61 + 30] == 255);
+  PTD_CHECK(mask.coverage[30 * 61] == 0);
+  PTDSelectionMaskFree(&mask);
+  
+  /* the outside goes around it */
+  PTD_CHECK(PTDFloodFill(&canvas, 0, 0, &options, &mask));
+  PTD_CHECK(mask.width == 100 && mask.height == 100);
+  PTD_CHECK(mask.coverage[50 * 100 + 50] == 0);
+  PTD_CHECK(mask.coverage[10 * 100 + 90] == 255);
+  PTDSelectionMaskFree(&mask);
+  free(canvas.data);
+}
+
+
+static void testGapClosing(void)
+{
+  /* the same square with a gap of 3 pixels on the left side */
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(100, 100);
+  for (size_t i = 20; i <= 80; i++) {
+    PTDTestSetPixel(&canvas, i, 20, 0xFF000000);
+    PTDTestSetPixel(&canvas, i, 80, 0xFF000000);
+    if (i < 49 || i > 51)
+      PTDTestSetPixel(&canvas, 20, i, 0xFF000000);
+    PTDTestSetPixel(&canvas, 80, i, 0xFF000000);
+  }
+  PTDFloodFillOptions options = {0, 0, 0};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDFloodFill(&canvas, 50, 50, &options, &mask));
+  PTD_CHECK(mask.width == 100 && mask.height == 100);
+  PTDSelectionMaskFree(&mask);
+  
+  /* the fill still reaches the outline everywhere else */
+  options.gapSize = 4;
+  PTD_CHECK(PTDFloodFill(&canvas, 50, 50, &options, &mask));
+  PTD_CHECK(mask.x == 21 && mask.y == 21 && mask.width == 59 && mask.height == 59);
+  PTD_CHECK(mask.coverage[0] == 255 && mask.coverage[59 * 59 - 1] == 255);
+  PTDSelectionMaskFree(&mask);
+  
+  /* clicking in a corridor narrower than the gaps fills it anyway */
+  PTD_CHECK(PTDFloodFill(&canvas, 19, 50, &options, &mask));
+  PTD_CHECK(mask.width == 100 && mask.height == 100);
+  PTDSelectionMaskFree(&mask);
+  free(canvas.data);
+}
+
+
+static void testMatchesReference(void)
+{
+  static const size_t sizes[][2] = {{131, 77}, {64, 64}, {1, 50}, {200, 1}, {65, 130}, {300, 40}};
+  static const PTDFloodFillOptions options[] = {
+    {0, 0, 0}, {0, 0, 1}, {40, 0, 1}, {255, 0, 1}, {0, 1, 1}, {0, 4, 0}, {20, 4, 1}, {0, 10, 1}, {0, 200, 1}
+  };
+  uint64_t rng = 11;
+  int ok = 1;
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    PTDPixelBuffer canvas = PTDTestRandomDrawing(sizes[s][0], sizes[s][1], s + 1);
+    for (size_t o = 0; o < sizeof(options) / sizeof(options[0]); o++) {
+      for (int i = 0; i < 6; i++) {
+        size_t x = PTDTestRandomBelow(&rng, canvas.width), y = PTDTestRandomBelow(&rng, canvas.height);
+        PTDSelectionMask mask, expected;
+        PTD_CHECK(PTDFloodFill(&canvas, x, y, &options[o], &mask));
+        PTDTestReferenceFill(&canvas, x, y, &options[o], &expected);
+        if (!PTDTestMasksEqual(&mask, &expected)) {
+          fprintf(stderr, "mismatch: %zux%zu, seed %zu,%zu, tolerance %d, gap %u\n", canvas.width, canvas.height, x, y, options[o].tolerance, options[o].gapSize);
+          ok = 0;
+        }
+        PTDSelectionMaskFree(&mask);
+        PTDSelectionMaskFree(&expected);
+      }
+    }
+    free(canvas.data);
+  }
+  PTD_CHECK(ok);
+}
+
+
+static void testSpiral(void)
+{
+  /* a maze with a single corridor, which turns at every row or column */
+  const size_t w = 97, h = 61;
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(w, h);
+  const long dx[] = {1, 0, -1, 0}, dy[] = {0, 1, 0, -1};
+  long x = 0, y = 0;
+  for (long i = 0; ; i++) {
+    long length = (i % 2 ? (long)h : (long)w) - 1 - (i > 0 ? 2 * ((i - 1) / 2) : 0);
+    if (length <= 2)
+      break;
+    for (long j = 0; j < length; j++, x += dx[i % 4], y += dy[i % 4])
+      PTDTestSetPixel(&canvas, (size_t)x, (size_t)y, 0xFF000000);
+  }
+  size_t open = 0;
+  for (size_t yy = 0; yy < h; yy++)
+    for (size_t xx = 0; xx < w; xx++)
+      open += PTDTestPixel(&canvas, xx, yy)[3] == 0;
+  
+  PTDFloodFillOptions options = {0, 0, 0};
+  PTDSelectionMask mask, expected;
+  PTD_CHECK(PTDFloodFill(&canvas, 1, 1, &options, &mask));
+  size_t filled = 0;
+  for (size_t i = 0; i < mask.width * mask.height; i++)
+    filled += mask.coverage[i] == 255;
+  PTD_CHECK(filled == open);
+  PTDTestReferenceFill(&canvas, 1, 1, &options, &expected);
+  PTD_CHECK(PTDTestMasksEqual(&mask, &expected));
+  PTDSelectionMaskFree(&mask);
+  PTDSelectionMaskFree(&expected);
+  free(canvas.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testEmptyCanvas);
+  PTD_RUN(testClosedShape);
+  PTD_RUN(testGapClosing);
+  PTD_RUN(testMatchesReference);
+  PTD_RUN(testSpiral);
+  return PTDTestFinish();
+}
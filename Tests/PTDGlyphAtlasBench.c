@@ -0,0 +1,105 @@
+//
+// PTDGlyphAtlasBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDGlyphAtlas.h"
+
+
+/* Drawing a page of text through a 2048x2048 atlas, as the text objects
+ * do, with glyphs from a stub source which fills them with a pattern, so
+ * that the times are those of the atlas and not of a font renderer */
+
+static const size_t _AtlasSize = 2048;
+static const size_t _TextLength = 10000;
+
+
+static const PTDGlyphAtlasEntry *PTDBenchGlyph(PTDGlyphAtlas *atlas, uint64_t key, size_t size)
+{
+  const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasLookup(atlas, key);
+  if (entry)
+    return entry;
+  size_t width = size / 2 + key % (size / 2), height = size + key % 7;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    uint8_t *coverage;
+    size_t bytesPerRow;
+    entry = PTDGlyphAtlasInsert(atlas, key, width, height, -1, (int)(height * 3 / 4), &coverage, &bytesPerRow);
+    if (entry) {
+      for (size_t y = 0; y < height; y++)
+        memset(coverage + y * bytesPerRow, (int)(key * 17 + y), width);
+      return entry;
+    }
+    PTDGlyphAtlasClear(atlas);
+  }
+  return NULL;
+}
+
+
+/* draws the text in lines across the canvas; the keys are picked from a
+ * set of distinct glyphs, as many as the font size and subpixel positions
+ * of the text make */
+static void PTDBenchDrawText(PTDGlyphAtlas *atlas, PTDPixelBuffer *canvas, const uint64_t *text, size_t size)
+{
+  static const uint8_t color[4] = {20, 40, 160, 255};
+  long x = 0, y = (long)size;
+  for (size_t i = 0; i < _TextLength; i++) {
+    const PTDGlyphAtlasEntry *entry = PTDBenchGlyph(atlas, text[i], size);
+    PTDGlyphAtlasComposite(atlas, entry, canvas, x, y, color);
+    x += (long)(size * 2 / 3);
+    if (x > (long)canvas->width) {
+      x = 0;
+      y += (long)size * 3 / 2;
+      if (y > (long)canvas->height)
+        y = (long)size;
+    }
+  }
+}
+
+
+int main(void)
+{
+  PTDPixelBuffer canvas = {calloc(2880 * 1800, 4), 2880, 1800, 2880 * 4};
+  PTDGlyphAtlas *atlas = PTDGlyphAtlasCreate(_AtlasSize, _AtlasSize);
+  uint64_t *text = malloc(_TextLength * sizeof(uint64_t));
+  
+  static const size_t sizes[] = {16, 32, 96};
+  static const size_t glyphSets[] = {100, 1000, 10000};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (size_t g = 0; g < sizeof(glyphSets) / sizeof(glyphSets[0]); g++) {
+      uint64_t rng = 1;
+      for (size_t i = 0; i < _TextLength; i++)
+        text[i] = 1 + PTDTestRandomBelow(&rng, glyphSets[g]);
+      char name[80];
+      snprintf(name, sizeof(name), "10k glyphs, %zupx, %zu distinct", sizes[s], glyphSets[g]);
+      PTDGlyphAtlasClear(atlas);
+      PTD_BENCH(name, 0.5, PTDBenchDrawText(atlas, &canvas, text, sizes[s]));
+    }
+  }
+  
+  free(text);
+  PTDGlyphAtlasDestroy(atlas);
+  free(canvas.data);
+  return 0;
+}
@@ -0,0 +1,276 @@
+//
+// PTDGlyphAtlasTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDGlyphAtlas.h"
+
+
+/* The glyphs come from a stub source which derives the size, the offsets
+ * and the coverage of each glyph from its key alone, so that what the
+ * atlas returns can be checked without any font */
+
+typedef struct {
+  size_t width, height;
+  int left, top;
+} PTDStubGlyph;
+
+
+static PTDStubGlyph PTDStubGlyphForKey(uint64_t key)
+{
+  uint64_t state = key * 2 + 1;
+  PTDTestRandom(&state);
+  PTDStubGlyph glyph;
+  glyph.width = 3 + PTDTestRandomBelow(&state, 30);
+  glyph.height = 5 + PTDTestRandomBelow(&state, 40);
+  glyph.left = (int)PTDTestRandomBelow(&state, 7) - 3;
+  glyph.top = (int)glyph.height - (int)PTDTestRandomBelow(&state, 10);
+  return glyph;
+}
+
+
+static uint8_t PTDStubGlyphCoverage(uint64_t key, size_t x, size_t y)
+{
+  return (uint8_t)(1 + ((key * 31 + x * 7 + y * 13) % 255));
+}
+
+
+static const PTDGlyphAtlasEntry *PTDStubGlyphInsert(PTDGlyphAtlas *atlas, uint64_t key)
+{
+  PTDStubGlyph glyph = PTDStubGlyphForKey(key);
+  uint8_t *coverage;
+  size_t bytesPerRow;
+  const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasInsert(atlas, key, glyph.width, glyph.height, glyph.left, glyph.top, &coverage, &bytesPerRow);
+  if (!entry)
+    return NULL;
+  for (size_t y = 0; y < glyph.height; y++) {
+    for (size_t x = 0; x < glyph.width; x++) {
+      if (coverage[y * bytesPerRow + x] != 0)
+        return NULL;
+      coverage[y * bytesPerRow + x] = PTDStubGlyphCoverage(key, x, y);
+    }
+  }
+  return entry;
+}
+
+
+/* draws the glyph in a canvas and checks it against the stub, which is
+ * the only way to read back the coverage from outside the atlas */
+static int PTDStubGlyphCheckCoverage(PTDGlyphAtlas *atlas, const PTDGlyphAtlasEntry *entry, uint64_t key)
+{
+  PTDStubGlyph glyph = PTDStubGlyphForKey(key);
+  if (entry->width != glyph.width || entry->height != glyph.height || entry->left != glyph.left || entry->top != glyph.top)
+    return 0;
+  PTDPixelBuffer canvas = {calloc(glyph.width * glyph.height, 4), glyph.width, glyph.height, glyph.width * 4};
+  static const uint8_t white[4] = {255, 255, 255, 255};
+  PTDGlyphAtlasComposite(atlas, entry, &canvas, -glyph.left, glyph.top, white);
+  int ok = 1;
+  for (size_t y = 0; y < glyph.height; y++)
+    for (size_t x = 0; x < glyph.width; x++)
+      ok &= canvas.data[(y * glyph.width + x) * 4 + 3] == PTDStubGlyphCoverage(key, x, y);
+  free(canvas.data);
+  return ok;
+}
+
+
+static void testInsertAndLookup(void)
+{
+  PTDGlyphAtlas *atlas = PTDGlyphAtlasCreate(512, 512);
+  PTD_CHECK(PTDGlyphAtlasLookup(atlas, 1) == NULL);
+  uint64_t keys[200];
+  for (int i = 0; i < 200; i++) {
+    keys[i] = (uint64_t)i * 0x10001 + 7;
+    PTD_CHECK(PTDStubGlyphInsert(atlas, keys[i]) != NULL);
+  }
+  for (int i = 0; i < 200; i++) {
+    const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasLookup(atlas, keys[i]);
+    if (!PTD_CHECK(entry != NULL))
+      continue;
+    PTD_CHECK(PTDStubGlyphCheckCoverage(atlas, entry, keys[i]));
+  }
+  PTD_CHECK(PTDGlyphAtlasLookup(atlas, 3) == NULL);
+  PTDGlyphAtlasDestroy(atlas);
+}
+
+
+static int PTDEntriesOverlap(const PTDGlyphAtlasEntry *a, const PTDGlyphAtlasEntry *b)
+{
+  return a->x < b->x + b->width && b->x < a->x + a->width && a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+
+static void testPacking(void)
+{
+  /* glyphs never overlap nor leave the atlas, and the shelves waste less
+   * than half of the area before it is full */
+  const size_t size = 256;
+  PTDGlyphAtlas *atlas = PTDGlyphAtlasCreate(size, size);
+  PTDGlyphAtlasEntry entries[1000];
+  size_t count = 0, area = 0;
+  for (uint64_t key = 1; count < 1000; key++) {
+    const PTDGlyphAtlasEntry *entry = PTDStubGlyphInsert(atlas, key);
+    if (!entry)
+      break;
+    entries[count++] = *entry;
+    area += (size_t)entry->width * entry->height;
+  }
+  PTD_CHECK(count > 0 && count < 1000);
+  PTD_CHECK(area > size * size / 2);
+  int ok = 1;
+  for (size_t i = 0; i < count; i++) {
+    ok &= entries[i].x + entries[i].width <= size && entries[i].y + entries[i].height <= size;
+    for (size_t j = 0; j < i; j++)
+      ok &= !PTDEntriesOverlap(&entries[i], &entries[j]);
+  }
+  PTD_CHECK(ok);
+  PTDGlyphAtlasDestroy(atlas);
+}
+
+
+static void testEmptyAndOversizedGlyphs(void)
+{
+  PTDGlyphAtlas *atlas = PTDGlyphAtlasCreate(64, 64);
+  uint8_t *coverage;
+  size_t bytesPerRow;
+  const PTDGlyphAtlasEntry *space = PTDGlyphAtlasInsert(atlas, 10, 0, 0, 0, 0, &coverage, &bytesPerRow);
+  PTD_CHECK(space && space->width == 0 && space->height == 0);
+  PTD_CHECK(PTDGlyphAtlasLookup(atlas, 10) == space);
+  
+  PTD_CHECK(PTDGlyphAtlasInsert(atlas, 11, 65, 10, 0, 0, &coverage, &bytesPerRow) == NULL);
+  PTD_CHECK(PTDGlyphAtlasInsert(atlas, 12, 10, 65, 0, 0, &coverage, &bytesPerRow) == NULL);
+  PTD_CHECK(PTDGlyphAtlasInsert(atlas, 13, 10, 10, 40000, 0, &coverage, &bytesPerRow) == NULL);
+  PTD_CHECK(PTDGlyphAtlasLookup(atlas, 11) == NULL);
+  PTD_CHECK(PTDGlyphAtlasInsert(atlas, 14, 64, 64, 0, 0, &coverage, &bytesPerRow) != NULL);
+  
+  /* the empty glyph does not draw anything */
+  uint8_t pixel[4] = {1, 2, 3, 4};
+  PTDPixelBuffer canvas = {pixel, 1, 1, 4};
+  PTDGlyphAtlasComposite(atlas, PTDGlyphAtlasLookup(atlas, 10), &canvas, 0, 0, (uint8_t[4]){255, 255, 255, 255});
+  PTD_CHECK(pixel[0] == 1 && pixel[3] == 4);
+  PTDGlyphAtlasDestroy(atlas);
+}
+
+
+static void testClearWhenFull(void)
+{
+  /* the text objects empty the atlas when a glyph does not fit anymore and
+   * add the glyph again: the old glyphs are gone, their area is zeroed and
+   * the atlas fills up again the same way */
+  PTDGlyphAtlas *atlas = PTDGlyphAtlasCreate(128, 128);
+  uint64_t key = 1;
+  size_t firstFill = 0;
+  while (PTDStubGlyphInsert(atlas, key)) {
+    key++;
+    firstFill++;
+  }
+  uint64_t overflow = key;
+  for (int round = 0; round < 3; round++) {
+    PTDGlyphAtlasClear(atlas);
+    PTD_CHECK(PTDGlyphAtlasLookup(atlas, 1) == NULL);
+    PTD_CHECK(PTDGlyphAtlasLookup(atlas, overflow - 1) == NULL);
+    /* the insertion fails if the area is not zero */
+    size_t fill = 0;
+    for (key = 1; PTDStubGlyphInsert(atlas, key); key++)
+      fill++;
+    PTD_CHECK(fill == firstFill);
+    PTD_CHECK(PTDStubGlyphCheckCoverage(atlas, PTDGlyphAtlasLookup(atlas, 1), 1));
+  }
+  
+  /* a working set larger than the atlas keeps all the recent glyphs */
+  PTDGlyphAtlasClear(atlas);
+  for (key = 1; key < 2000; key++) {
+    const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasLookup(atlas, key % 300);
+    if (!entry) {
+      entry = PTDStubGlyphInsert(atlas, key % 300);
+      if (!entry) {
+        PTDGlyphAtlasClear(atlas);
+        entry = PTDStubGlyphInsert(atlas, key % 300);
+      }
+    }
+    if (!PTD_CHECK(entry && PTDStubGlyphCheckCoverage(atlas, entry, key % 300)))
+      break;
+  }
+  PTDGlyphAtlasDestroy(atlas);
+}
+
+
+static void testComposite(void)
+{
+  /* source over against a floating point reference, clipped at every edge
+   * of the canvas; the color and the destination are rounded separately */
+  PTDGlyphAtlas *atlas = PTDGlyphAtlasCreate(64, 64);
+  uint8_t *coverage;
+  size_t bytesPerRow;
+  const PTDGlyphAtlasEntry *entry = PTDGlyphAtlasInsert(atlas, 1, 8, 8, 0, 8, &coverage, &bytesPerRow);
+  for (size_t y = 0; y < 8; y++)
+    for (size_t x = 0; x < 8; x++)
+      coverage[y * bytesPerRow + x] = (uint8_t)(y * 32 + x * 4);
+  
+  static const uint8_t color[4] = {40, 100, 160, 200};
+  static const long positions[][2] = {{4, 12}, {-3, 8}, {12, 5}, {2, 18}, {-7, 1}, {20, 20}};
+  uint64_t rng = 3;
+  int ok = 1;
+  for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); p++) {
+    PTDPixelBuffer canvas = {malloc(16 * 16 * 4), 16, 16, 16 * 4};
+    for (size_t i = 0; i < 16 * 16; i++) {
+      uint8_t a = (uint8_t)PTDTestRandomBelow(&rng, 256);
+      for (int c = 0; c < 3; c++)
+        canvas.data[i * 4 + c] = (uint8_t)PTDTestRandomBelow(&rng, (size_t)a + 1);
+      canvas.data[i * 4 + 3] = a;
+    }
+    uint8_t *before = malloc(16 * 16 * 4);
+    memcpy(before, canvas.data, 16 * 16 * 4);
+    long px = positions[p][0], py = positions[p][1];
+    PTDGlyphAtlasComposite(atlas, entry, &canvas, px, py, color);
+    for (long y = 0; y < 16; y++) {
+      for (long x = 0; x < 16; x++) {
+        long gx = x - px, gy = y - (py - 8);
+        double m = (gx >= 0 && gx < 8 && gy >= 0 && gy < 8) ? (double)(gy * 32 + gx * 4) / 255.0 : 0.0;
+        const uint8_t *b = before + (y * 16 + x) * 4;
+        const uint8_t *a = canvas.data + (y * 16 + x) * 4;
+        for (int c = 0; c < 4; c++) {
+          double expected = color[c] * m + b[c] * (1.0 - color[3] * m / 255.0);
+          ok &= fabs(a[c] - expected) <= 1.5;
+        }
+      }
+    }
+    free(before);
+    free(canvas.data);
+  }
+  PTD_CHECK(ok);
+  PTDGlyphAtlasDestroy(atlas);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testInsertAndLookup);
+  PTD_RUN(testPacking);
+  PTD_RUN(testEmptyAndOversizedGlyphs);
+  PTD_RUN(testClearWhenFull);
+  PTD_RUN(testComposite);
+  return PTDTestFinish();
+}
@@ -0,0 +1,80 @@
+//
+// PTDPageStoreBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDPageStore.h"
+
+
+/* A semester of annotations on a long textbook: random access to a
+ * thousand pages, with a few of them hot. */
+
+#define PAGES 1000
+#define PAGE_LENGTH (96 * 1024)
+#define HOT_PAGES 8
+
+
+int main(void)
+{
+  PTDPageStore *store = PTDPageStoreCreate(PAGES, HOT_PAGES, NULL);
+  uint8_t *data = malloc(PAGE_LENGTH);
+  uint64_t rng = 3;
+  for (size_t i = 0; i < PAGE_LENGTH; i++)
+    data[i] = (uint8_t)PTDTestRandom(&rng);
+  
+  double start = PTDTestNow();
+  for (size_t i = 0; i < PAGES; i++) {
+    data[0] = (uint8_t)i;
+    data[1] = (uint8_t)(i >> 8);
+    PTDPageStoreSetPage(store, i, data, PAGE_LENGTH);
+  }
+  printf("%-48s %10.3f ms\n", "store 1000 pages of 96 KB", (PTDTestNow() - start) * 1000.0);
+  printf("%-48s %10.1f KB\n", "resident after storing", PTDPageStoreResidentSize(store) / 1024.0);
+  
+  size_t length;
+  PTD_BENCH("random page read, cached", 0.5, {
+    size_t page = PTDTestRandomBelow(&rng, PAGES);
+    free(PTDPageStoreCopyPage(store, page, &length, true));
+  });
+  PTD_BENCH("random page read, uncached", 0.5, {
+    size_t page = PTDTestRandomBelow(&rng, PAGES);
+    free(PTDPageStoreCopyPage(store, page, &length, false));
+  });
+  PTD_BENCH("hot page read", 0.5, {
+    size_t page = PTDTestRandomBelow(&rng, HOT_PAGES / 2);
+    free(PTDPageStoreCopyPage(store, page, &length, true));
+  });
+  PTD_BENCH("random page rewrite", 0.5, {
+    size_t page = PTDTestRandomBelow(&rng, PAGES);
+    data[2]++;
+    PTDPageStoreSetPage(store, page, data, PAGE_LENGTH);
+  });
+  printf("%-48s %10.1f KB\n", "resident after the benchmark", PTDPageStoreResidentSize(store) / 1024.0);
+  printf("%-48s %10.1f MB\n", "spill file size", PTDPageStoreFileSize(store) / 1048576.0);
+  
+  PTDPageStoreDestroy(store);
+  free(data);
+  return 0;
+}
@@ -0,0 +1,277 @@
+//
+// PTDPageStoreTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "PTDTest.h"
+#include "PTDPageStore.h"
+
+
+/* Page contents which can be recognized from any of their bytes */
+static uint8_t *PTDTestPageData(size_t index, uint32_t version, size_t length)
+{
+  uint8_t *data = malloc(length);
+  uint32_t seed = (uint32_t)index * 2654435761u + version * 40503u;
+  for (size_t i = 0; i < length; i++)
+    data[i] = (uint8_t)((seed + i * 31u) >> 3);
+  return data;
+}
+
+
+static int PTDTestPageMatches(PTDPageStore *store, size_t index, uint32_t version, size_t length, bool cache)
+{
+  size_t readLength;
+  uint8_t *read = PTDPageStoreCopyPage(store, index, &readLength, cache);
+  uint8_t *expected = PTDTestPageData(index, version, length);
+  int res = read && readLength == length && memcmp(read, expected, length) == 0;
+  free(read);
+  free(expected);
+  return res;
+}
+
+
+static void PTDTestSetPage(PTDPageStore *store, size_t index, uint32_t version, size_t length)
+{
+  uint8_t *data = PTDTestPageData(index, version, length);
+  PTD_CHECK(PTDPageStoreSetPage(store, index, data, length));
+  free(data);
+}
+
+
+static void testRoundTrip(void)
+{
+  PTDPageStore *store = PTDPageStoreCreate(10, 4, NULL);
+  PTD_CHECK(store != NULL);
+  PTD_CHECK(PTDPageStorePageCount(store) == 10);
+  
+  size_t length = 123;
+  PTD_CHECK(PTDPageStoreCopyPage(store, 3, &length, true) == NULL && length == 0);
+  PTD_CHECK(!PTDPageStoreHasPage(store, 3));
+  PTD_CHECK(PTDPageStoreRevision(store, 3) == 0);
+  
+  PTDTestSetPage(store, 3, 1, 5000);
+  PTD_CHECK(PTDPageStoreHasPage(store, 3));
+  PTD_CHECK(PTDTestPageMatches(store, 3, 1, 5000, true));
+  PTD_CHECK(PTDTestPageMatches(store, 3, 1, 5000, false));
+  uint64_t revision = PTDPageStoreRevision(store, 3);
+  PTD_CHECK(revision != 0);
+  
+  /* the same data again is not a change */
+  PTDTestSetPage(store, 3, 1, 5000);
+  PTD_CHECK(PTDPageStoreRevision(store, 3) == revision);
+  PTDTestSetPage(store, 3, 2, 5000);
+  PTD_CHECK(PTDPageStoreRevision(store, 3) > revision);
+  PTD_CHECK(PTDTestPageMatches(store, 3, 2, 5000, true));
+  
+  /* empty data removes the page */
+  revision = PTDPageStoreRevision(store, 3);
+  PTD_CHECK(PTDPageStoreSetPage(store, 3, NULL, 0));
+  PTD_CHECK(!PTDPageStoreHasPage(store, 3));
+  PTD_CHECK(PTDPageStoreRevision(store, 3) > revision);
+  
+  /* out of range */
+  PTD_CHECK(!PTDPageStoreSetPage(store, 10, "x", 1));
+  PTD_CHECK(!PTDPageStoreHasPage(store, 10));
+  PTD_CHECK(PTDPageStoreCopyPage(store, 10, &length, true) == NULL);
+  PTDPageStoreDestroy(store);
+}
+
+
+static void testResidentSizeIsBounded(void)
+{
+  const size_t pages = 200, length = 10000;
+  PTDPageStore *store = PTDPageStoreCreate(pages, 4, NULL);
+  for (size_t i = 0; i < pages; i++)
+    PTDTestSetPage(store, i, 1, length);
+  PTD_CHECK(PTDPageStoreResidentSize(store) <= 4 * length);
+  
+  uint64_t rng = 1;
+  int allMatch = 1;
+  for (int i = 0; i < 2000; i++) {
+    size_t page = PTDTestRandomBelow(&rng, pages);
+    allMatch &= PTDTestPageMatches(store, page, 1, length, i % 3 != 0);
+  }
+  PTD_CHECK(allMatch);
+  PTD_CHECK(PTDPageStoreResidentSize(store) <= 4 * length);
+  PTD_CHECK(PTDPageStoreFileSize(store) == pages * length);
+  PTDPageStoreDestroy(store);
+}
+
+
+static void testCompaction(void)
+{
+  const size_t length = 1024 * 1024;
+  PTDPageStore *store = PTDPageStoreCreate(4, 1, NULL);
+  PTDTestSetPage(store, 0, 1, length);
+  for (uint32_t v = 1; v <= 12; v++)
+    PTDTestSetPage(store, 1, v, length);
+  /* the dead space was dropped at some point */
+  PTD_CHECK(PTDPageStoreFileSize(store) < 8 * length);
+  PTD_CHECK(PTDTestPageMatches(store, 0, 1, length, false));
+  PTD_CHECK(PTDTestPageMatches(store, 1, 12, length, false));
+  PTDPageStoreDestroy(store);
+}
+
+
+static void testFailedCompactionKeepsData(void)
+{
+  char dir[] = "/tmp/PTDPageStoreTests.XXXXXX";
+  PTD_CHECK(mkdtemp(dir) != NULL);
+  const size_t length = 1024 * 1024;
+  PTDPageStore *store = PTDPageStoreCreate(4, 1, dir);
+  PTDTestSetPage(store, 0, 1, length);
+  /* no new spill file can be created from now on */
+  PTD_CHECK(rmdir(dir) == 0);
+  for (uint32_t v = 1; v <= 12; v++)
+    PTDTestSetPage(store, 1, v, length);
+  PTD_CHECK(PTDPageStoreFileSize(store) >= 13 * length);
+  PTD_CHECK(PTDTestPageMatches(store, 0, 1, length, false));
+  PTD_CHECK(PTDTestPageMatches(store, 1, 12, length, false));
+  PTDPageStoreDestroy(store);
+}
+
+
+static void testFailedWritesKeepDataInMemory(void)
+{
+  const size_t length = 64 * 1024;
+  PTDPageStore *store = PTDPageStoreCreate(4, 1, NULL);
+  PTDTestSetPage(store, 0, 1, length);
+  
+  struct rlimit old, limit;
+  getrlimit(RLIMIT_FSIZE, &old);
+  limit = old;
+  limit.rlim_cur = (rlim_t)PTDPageStoreFileSize(store);
+  signal(SIGXFSZ, SIG_IGN);
+  PTD_CHECK(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+  
+  PTDTestSetPage(store, 1, 1, length);
+  PTDTestSetPage(store, 2, 1, length);
+  PTD_CHECK(PTDPageStoreResidentSize(store) >= 2 * length);
+  setrlimit(RLIMIT_FSIZE, &old);
+  signal(SIGXFSZ, SIG_DFL);
+  
+  for (size_t i = 0; i < 3; i++)
+    PTD_CHECK(PTDTestPageMatches(store, i, 1, length, true));
+  /* once writing works again, new data is spilled as usual */
+  PTDTestSetPage(store, 1, 2, length);
+  PTD_CHECK(PTDTestPageMatches(store, 1, 2, length, true));
+  PTD_CHECK(PTDTestPageMatches(store, 2, 1, length, true));
+  PTDPageStoreDestroy(store);
+}
+
+
+static void testRemoveAllPages(void)
+{
+  PTDPageStore *store = PTDPageStoreCreate(8, 2, NULL);
+  for (size_t i = 0; i < 8; i++)
+    PTDTestSetPage(store, i, 1, 1000);
+  uint64_t revision = PTDPageStoreRevision(store, 5);
+  PTDPageStoreRemoveAllPages(store);
+  PTD_CHECK(PTDPageStoreFileSize(store) == 0);
+  PTD_CHECK(PTDPageStoreResidentSize(store) == 0);
+  PTD_CHECK(!PTDPageStoreHasPage(store, 5));
+  PTD_CHECK(PTDPageStoreRevision(store, 5) > revision);
+  PTDTestSetPage(store, 5, 2, 1000);
+  PTD_CHECK(PTDTestPageMatches(store, 5, 2, 1000, true));
+  PTDPageStoreDestroy(store);
+}
+
+
+#define STRESS_PAGES 64
+#define STRESS_LENGTH 4096
+
+typedef struct {
+  PTDPageStore *store;
+  _Atomic int done;
+  _Atomic long errors;
+} PTDStressContext;
+
+
+static void *PTDStressReader(void *arg)
+{
+  PTDStressContext *ctx = arg;
+  uint64_t rng = (uint64_t)(uintptr_t)&rng;
+  while (!atomic_load(&ctx->done)) {
+    size_t page = PTDTestRandomBelow(&rng, STRESS_PAGES);
+    size_t length;
+    uint8_t *data = PTDPageStoreCopyPage(ctx->store, page, &length, rng & 1);
+    if (!data)
+      continue;
+    /* whatever the version, it must be a whole one */
+    int found = 0;
+    for (uint32_t v = 1; v <= 64 && !found; v++) {
+      uint8_t *expected = PTDTestPageData(page, v, STRESS_LENGTH);
+      found = length == STRESS_LENGTH && memcmp(expected, data, length) == 0;
+      free(expected);
+    }
+    if (!found)
+      atomic_fetch_add(&ctx->errors, 1);
+    free(data);
+  }
+  return NULL;
+}
+
+
+static void testConcurrentAccess(void)
+{
+  PTDStressContext ctx = {0};
+  ctx.store = PTDPageStoreCreate(STRESS_PAGES, 8, NULL);
+  pthread_t readers[3];
+  for (int i = 0; i < 3; i++)
+    pthread_create(&readers[i], NULL, PTDStressReader, &ctx);
+  
+  uint64_t rng = 7;
+  for (int i = 0; i < 4000; i++) {
+    size_t page = PTDTestRandomBelow(&rng, STRESS_PAGES);
+    uint8_t *data = PTDTestPageData(page, 1 + (uint32_t)PTDTestRandomBelow(&rng, 64), STRESS_LENGTH);
+    PTDPageStoreSetPage(ctx.store, page, data, STRESS_LENGTH);
+    free(data);
+    if (i % 1000 == 999)
+      PTDPageStoreRemoveAllPages(ctx.store);
+  }
+  atomic_store(&ctx.done, 1);
+  for (int i = 0; i < 3; i++)
+    pthread_join(readers[i], NULL);
+  PTD_CHECK(atomic_load(&ctx.errors) == 0);
+  PTDPageStoreDestroy(ctx.store);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testRoundTrip);
+  PTD_RUN(testResidentSizeIsBounded);
+  PTD_RUN(testCompaction);
+  PTD_RUN(testFailedCompactionKeepsData);
+  PTD_RUN(testFailedWritesKeepDataInMemory);
+  PTD_RUN(testRemoveAllPages);
+  PTD_RUN(testConcurrentAccess);
+  return PTDTestFinish();
+}
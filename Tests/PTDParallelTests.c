@@ -0,0 +1,89 @@
+//
+// PTDParallelTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdatomic.h>
+#include "PTDTest.h"
+#include "PTDParallel.h"
+
+
+typedef struct {
+  _Atomic int *counts;
+  _Atomic size_t calls;
+} PTDCountContext;
+
+
+static void PTDCountIteration(void *context, size_t i)
+{
+  PTDCountContext *ctx = context;
+  atomic_fetch_add(&ctx->counts[i], 1);
+  atomic_fetch_add(&ctx->calls, 1);
+}
+
+
+static void testEveryIterationRunsOnce(void)
+{
+  const size_t counts[] = {0, 1, 2, 7, 1000};
+  for (size_t c = 0; c < 5; c++) {
+    PTDCountContext ctx = {calloc(counts[c] + 1, sizeof(_Atomic int)), 0};
+    PTDParallelApply(counts[c], &ctx, PTDCountIteration);
+    PTD_CHECK(atomic_load(&ctx.calls) == counts[c]);
+    int once = 1;
+    for (size_t i = 0; i < counts[c]; i++)
+      once &= atomic_load(&ctx.counts[i]) == 1;
+    PTD_CHECK(once);
+    free((void *)ctx.counts);
+  }
+}
+
+
+static void PTDNestedIteration(void *context, size_t i)
+{
+  PTDCountContext *ctx = context;
+  PTDCountContext inner = {calloc(10, sizeof(_Atomic int)), 0};
+  PTDParallelApply(10, &inner, PTDCountIteration);
+  if (atomic_load(&inner.calls) == 10)
+    atomic_fetch_add(&ctx->counts[i], 1);
+  free((void *)inner.counts);
+}
+
+
+static void testNesting(void)
+{
+  PTDCountContext ctx = {calloc(8, sizeof(_Atomic int)), 0};
+  PTDParallelApply(8, &ctx, PTDNestedIteration);
+  int all = 1;
+  for (size_t i = 0; i < 8; i++)
+    all &= atomic_load(&ctx.counts[i]) == 1;
+  PTD_CHECK(all);
+  free((void *)ctx.counts);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testEveryIterationRunsOnce);
+  PTD_RUN(testNesting);
+  return PTDTestFinish();
+}
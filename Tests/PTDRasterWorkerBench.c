@@ -0,0 +1,143 @@
+//
+// PTDRasterWorkerBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDRasterWorker.h"
+#include "PTDPresentBuffer.h"
+
+
+#define CANVAS_WIDTH 5120
+#define CANVAS_HEIGHT 2880
+
+
+static void PTDBenchNothing(void *context)
+{
+  (void)context;
+}
+
+
+static void PTDBenchEnqueue(PTDRasterWorker *worker, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+    PTDRasterWorkerEnqueue(worker, PTDBenchNothing, NULL);
+  PTDRasterWorkerWaitUntilIdle(worker);
+}
+
+
+static void PTDBenchRoundTrip(PTDRasterWorker *worker)
+{
+  PTDRasterWorkerEnqueue(worker, PTDBenchNothing, NULL);
+  PTDRasterWorkerWaitUntilIdle(worker);
+}
+
+
+typedef struct {
+  PTDPixelBuffer *canvas;
+  PTDPresentBuffer *present;
+  size_t x0, y0, x1, y1;
+} PTDBenchErase;
+
+
+/* like an eraser event on a 2x screen */
+static void PTDBenchRunErase(void *context)
+{
+  PTDBenchErase *cmd = context;
+  for (size_t y = cmd->y0; y < cmd->y1; y++)
+    memset(cmd->canvas->data + y * cmd->canvas->bytesPerRow + cmd->x0 * 4, 0, (cmd->x1 - cmd->x0) * 4);
+  /* stands in for the Quartz drawing of the real command, about 1 ms */
+  for (int pass = 0; pass < 40; pass++)
+    for (size_t y = cmd->y0; y < cmd->y1; y++)
+      memset(cmd->canvas->data + y * cmd->canvas->bytesPerRow + cmd->x0 * 4, pass, (cmd->x1 - cmd->x0) * 4);
+  if (cmd->present)
+    PTDPresentBufferUpdate(cmd->present, cmd->canvas, cmd->x0, cmd->y0, cmd->x1, cmd->y1);
+}
+
+
+/* Enqueues the events of a drag, a few per frame, and measures how long
+ * the producer spends per frame to show the canvas: either waiting for the
+ * worker, or taking the finished changes. */
+static void PTDBenchDrag(PTDRasterWorker *worker, PTDPixelBuffer *canvas, PTDPresentBuffer *present, uint8_t *screen, const char *name)
+{
+  enum { FRAMES = 200, EVENTS_PER_FRAME = 4, SIZE = 400 };
+  static PTDBenchErase cmds[FRAMES * EVENTS_PER_FRAME];
+  double producerTime = 0.0, start = PTDTestNow();
+  
+  for (size_t f = 0; f < FRAMES; f++) {
+    for (size_t e = 0; e < EVENTS_PER_FRAME; e++) {
+      size_t i = f * EVENTS_PER_FRAME + e;
+      size_t x = (i * 23) % (CANVAS_WIDTH - SIZE), y = (i * 11) % (CANVAS_HEIGHT - SIZE);
+      cmds[i] = (PTDBenchErase){canvas, present, x, y, x + SIZE, y + SIZE};
+      PTDRasterWorkerEnqueue(worker, PTDBenchRunErase, &cmds[i]);
+    }
+    
+    double frameStart = PTDTestNow();
+    if (!present) {
+      PTDRasterWorkerWaitUntilIdle(worker);
+    } else {
+      PTDPixelBuffer pixels;
+      size_t x0, y0, x1, y1;
+      /* the copy stands in for the texture upload */
+      if (PTDPresentBufferBeginRead(present, &pixels, &x0, &y0, &x1, &y1)) {
+        for (size_t y = y0; y < y1; y++)
+          memcpy(screen + (y * CANVAS_WIDTH + x0) * 4, pixels.data + y * pixels.bytesPerRow + x0 * 4, (x1 - x0) * 4);
+        PTDPresentBufferEndRead(present);
+      }
+    }
+    producerTime += PTDTestNow() - frameStart;
+  }
+  PTDRasterWorkerWaitUntilIdle(worker);
+  double total = PTDTestNow() - start;
+  printf("%-48s %10.3f ms per frame on the producer, %.0f ms total\n", name, producerTime * 1000.0 / FRAMES, total * 1000.0);
+}
+
+
+int main(void)
+{
+  PTDRasterWorker *worker = PTDRasterWorkerCreate(64);
+  PTD_BENCH("enqueue and run 100000 empty commands", 0.5, PTDBenchEnqueue(worker, 100000));
+  PTD_BENCH("enqueue one command and wait for it", 0.5, PTDBenchRoundTrip(worker));
+  
+  PTDPixelBuffer canvas = {calloc((size_t)CANVAS_WIDTH * CANVAS_HEIGHT, 4), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH * 4};
+  uint8_t *screen = calloc((size_t)CANVAS_WIDTH * CANVAS_HEIGHT, 4);
+  PTDPresentBuffer *present = PTDPresentBufferCreate(CANVAS_WIDTH, CANVAS_HEIGHT);
+  /* faults all the pages in first */
+  memset(canvas.data, 0, (size_t)CANVAS_WIDTH * CANVAS_HEIGHT * 4);
+  memset(screen, 0, (size_t)CANVAS_WIDTH * CANVAS_HEIGHT * 4);
+  PTDPresentBufferUpdate(present, &canvas, 0, 0, CANVAS_WIDTH, CANVAS_HEIGHT);
+  PTDPixelBuffer unused;
+  size_t x0, y0, x1, y1;
+  if (PTDPresentBufferBeginRead(present, &unused, &x0, &y0, &x1, &y1))
+    PTDPresentBufferEndRead(present);
+  
+  PTDBenchDrag(worker, &canvas, NULL, screen, "5K drag, waiting for the worker");
+  PTDBenchDrag(worker, &canvas, present, screen, "5K drag, presenting finished changes");
+  
+  PTDPresentBufferDestroy(present);
+  free(screen);
+  free(canvas.data);
+  PTDRasterWorkerDestroy(worker);
+  return 0;
+}
@@ -0,0 +1,259 @@
+//
+// PTDRasterWorkerTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "PTDTest.h"
+#include "PTDRasterWorker.h"
+#include "PTDPresentBuffer.h"
+
+
+typedef struct {
+  /* only written by the commands, read by the producer once idle */
+  size_t *log;
+  size_t count;
+  _Atomic size_t ran;
+} PTDTestLog;
+
+typedef struct {
+  PTDTestLog *log;
+  size_t value;
+  int spin;
+} PTDTestCommand;
+
+
+static void PTDTestAppend(void *context)
+{
+  PTDTestCommand *cmd = context;
+  for (volatile int i = 0; i < cmd->spin; i++)
+    ;
+  cmd->log->log[cmd->log->count++] = cmd->value;
+  atomic_fetch_add(&cmd->log->ran, 1);
+}
+
+
+static void testOrder(void)
+{
+  /* a tiny ring, so that the producer keeps waiting for free slots */
+  enum { COUNT = 200000 };
+  static const size_t capacities[] = {1, 3, 64};
+  for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+    PTDRasterWorker *worker = PTDRasterWorkerCreate(capacities[c]);
+    PTDTestLog log = {malloc(COUNT * sizeof(size_t)), 0, 0};
+    PTDTestCommand *cmds = malloc(COUNT * sizeof(PTDTestCommand));
+    for (size_t i = 0; i < COUNT; i++) {
+      cmds[i] = (PTDTestCommand){&log, i, (int)(i % 7 == 0 ? 200 : 0)};
+      PTDRasterWorkerEnqueue(worker, PTDTestAppend, &cmds[i]);
+      /* idle checks in between, as done after each finished command */
+      if (i % 1000 == 0 && PTDRasterWorkerIsIdle(worker))
+        PTD_CHECK(atomic_load(&log.ran) == i + 1);
+    }
+    PTDRasterWorkerWaitUntilIdle(worker);
+    PTD_CHECK(PTDRasterWorkerIsIdle(worker));
+    /* the writes of the commands are visible without further sync */
+    PTD_CHECK(log.count == COUNT);
+    int ordered = 1;
+    for (size_t i = 0; i < log.count; i++)
+      ordered &= log.log[i] == i;
+    PTD_CHECK(ordered);
+    PTDRasterWorkerDestroy(worker);
+    free(cmds);
+    free(log.log);
+  }
+}
+
+
+static void testWaitWhileRunning(void)
+{
+  /* waiting repeatedly while commands run, as the main thread does */
+  enum { ROUNDS = 2000 };
+  PTDRasterWorker *worker = PTDRasterWorkerCreate(8);
+  PTDTestLog log = {malloc(ROUNDS * 4 * sizeof(size_t)), 0, 0};
+  PTDTestCommand *cmds = malloc(ROUNDS * 4 * sizeof(PTDTestCommand));
+  int consistent = 1;
+  for (size_t r = 0; r < ROUNDS; r++) {
+    size_t n = 1 + r % 4;
+    size_t first = log.count;
+    for (size_t i = 0; i < n; i++) {
+      cmds[first + i] = (PTDTestCommand){&log, first + i, (int)(r % 3) * 100};
+      PTDRasterWorkerEnqueue(worker, PTDTestAppend, &cmds[first + i]);
+    }
+    PTDRasterWorkerWaitUntilIdle(worker);
+    consistent &= log.count == first + n && log.log[first + n - 1] == first + n - 1;
+  }
+  PTD_CHECK(consistent);
+  PTDRasterWorkerDestroy(worker);
+  free(cmds);
+  free(log.log);
+}
+
+
+static void testDestroyRunsQueuedCommands(void)
+{
+  enum { COUNT = 10000 };
+  for (int round = 0; round < 20; round++) {
+    PTDRasterWorker *worker = PTDRasterWorkerCreate(16);
+    PTDTestLog log = {malloc(COUNT * sizeof(size_t)), 0, 0};
+    PTDTestCommand *cmds = malloc(COUNT * sizeof(PTDTestCommand));
+    size_t count = (size_t)(round * 500);
+    for (size_t i = 0; i < count; i++) {
+      cmds[i] = (PTDTestCommand){&log, i, 0};
+      PTDRasterWorkerEnqueue(worker, PTDTestAppend, &cmds[i]);
+    }
+    PTDRasterWorkerDestroy(worker);
+    PTD_CHECK(log.count == count);
+    free(cmds);
+    free(log.log);
+  }
+}
+
+
+#define CANVAS_WIDTH 300
+#define CANVAS_HEIGHT 200
+
+typedef struct {
+  PTDPixelBuffer *canvas;
+  PTDPresentBuffer *present;
+  size_t x0, y0, x1, y1;
+  uint32_t value;
+} PTDTestDrawCommand;
+
+
+static void PTDTestDraw(void *context)
+{
+  PTDTestDrawCommand *cmd = context;
+  for (size_t y = cmd->y0; y < cmd->y1; y++) {
+    uint32_t *row = (uint32_t *)(cmd->canvas->data + y * cmd->canvas->bytesPerRow);
+    for (size_t x = cmd->x0; x < cmd->x1; x++)
+      row[x] = cmd->value;
+  }
+  PTDPresentBufferUpdate(cmd->present, cmd->canvas, cmd->x0, cmd->y0, cmd->x1, cmd->y1);
+}
+
+
+/* Applies the changes finished so far to the copy shown on screen, checking
+ * that no pixel goes back to an older value */
+static int PTDTestPresent(PTDPresentBuffer *present, uint32_t *screen)
+{
+  PTDPixelBuffer pixels;
+  size_t x0, y0, x1, y1;
+  if (!PTDPresentBufferBeginRead(present, &pixels, &x0, &y0, &x1, &y1))
+    return 1;
+  int monotonic = x1 <= CANVAS_WIDTH && y1 <= CANVAS_HEIGHT;
+  for (size_t y = y0; y < y1 && monotonic; y++) {
+    const uint32_t *row = (const uint32_t *)(pixels.data + y * pixels.bytesPerRow);
+    for (size_t x = x0; x < x1; x++) {
+      monotonic &= row[x] >= screen[y * CANVAS_WIDTH + x];
+      screen[y * CANVAS_WIDTH + x] = row[x];
+    }
+  }
+  PTDPresentBufferEndRead(present);
+  return monotonic;
+}
+
+
+static void testPresentWhileDrawing(void)
+{
+  /* the worker draws growing values in random rects while the producer
+   * shows what is finished, without waiting */
+  enum { COUNT = 20000 };
+  uint64_t rng = 7;
+  PTDPixelBuffer canvas = {calloc(CANVAS_WIDTH * CANVAS_HEIGHT, 4), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH * 4};
+  uint32_t *screen = calloc(CANVAS_WIDTH * CANVAS_HEIGHT, 4);
+  PTDPresentBuffer *present = PTDPresentBufferCreate(CANVAS_WIDTH, CANVAS_HEIGHT);
+  PTDRasterWorker *worker = PTDRasterWorkerCreate(64);
+  PTDTestDrawCommand *cmds = malloc(COUNT * sizeof(PTDTestDrawCommand));
+  
+  int monotonic = 1;
+  size_t presented = 0;
+  PTDPixelBuffer unused;
+  size_t ux0, uy0, ux1, uy1;
+  PTD_CHECK(!PTDPresentBufferBeginRead(present, &unused, &ux0, &uy0, &ux1, &uy1));
+  for (size_t i = 0; i < COUNT; i++) {
+    size_t x = PTDTestRandomBelow(&rng, CANVAS_WIDTH - 1), y = PTDTestRandomBelow(&rng, CANVAS_HEIGHT - 1);
+    size_t x1 = x + 1 + PTDTestRandomBelow(&rng, 60), y1 = y + 1 + PTDTestRandomBelow(&rng, 60);
+    cmds[i] = (PTDTestDrawCommand){&canvas, present, x, y,
+        x1 < CANVAS_WIDTH ? x1 : CANVAS_WIDTH, y1 < CANVAS_HEIGHT ? y1 : CANVAS_HEIGHT, (uint32_t)(i + 1)};
+    PTDRasterWorkerEnqueue(worker, PTDTestDraw, &cmds[i]);
+    if (i % 16 == 0) {
+      monotonic &= PTDTestPresent(present, screen);
+      presented++;
+    }
+  }
+  PTDRasterWorkerWaitUntilIdle(worker);
+  monotonic &= PTDTestPresent(present, screen);
+  PTD_CHECK(monotonic);
+  PTD_CHECK(presented > 0);
+  
+  /* everything drawn has been shown, and nothing else */
+  PTD_CHECK(memcmp(screen, canvas.data, CANVAS_WIDTH * CANVAS_HEIGHT * 4) == 0);
+  PTD_CHECK(!PTDPresentBufferBeginRead(present, &unused, &ux0, &uy0, &ux1, &uy1));
+  
+  PTDRasterWorkerDestroy(worker);
+  PTDPresentBufferDestroy(present);
+  free(cmds);
+  free(screen);
+  free(canvas.data);
+}
+
+
+static void testPresentBufferClipping(void)
+{
+  PTDPixelBuffer canvas = {calloc(40 * 30, 4), 40, 30, 40 * 4};
+  memset(canvas.data, 0xAB, 40 * 30 * 4);
+  PTDPresentBuffer *present = PTDPresentBufferCreate(40, 30);
+  PTDPixelBuffer pixels;
+  size_t x0, y0, x1, y1;
+  
+  /* empty rects are no change */
+  PTDPresentBufferUpdate(present, &canvas, 10, 10, 10, 20);
+  PTDPresentBufferUpdate(present, &canvas, 50, 10, 60, 20);
+  PTD_CHECK(!PTDPresentBufferBeginRead(present, &pixels, &x0, &y0, &x1, &y1));
+  
+  /* rects are clipped to the canvas and joined */
+  PTDPresentBufferUpdate(present, &canvas, 35, 25, 100, 100);
+  PTDPresentBufferUpdate(present, &canvas, 2, 3, 4, 5);
+  if (PTD_CHECK(PTDPresentBufferBeginRead(present, &pixels, &x0, &y0, &x1, &y1))) {
+    PTD_CHECK(x0 == 2 && y0 == 3 && x1 == 40 && y1 == 30);
+    PTD_CHECK(pixels.width == 40 && pixels.height == 30);
+    PTD_CHECK(pixels.data[(29 * pixels.bytesPerRow) + 39 * 4] == 0xAB);
+    PTDPresentBufferEndRead(present);
+  }
+  PTD_CHECK(!PTDPresentBufferBeginRead(present, &pixels, &x0, &y0, &x1, &y1));
+  PTDPresentBufferDestroy(present);
+  free(canvas.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testOrder);
+  PTD_RUN(testWaitWhileRunning);
+  PTD_RUN(testDestroyRunsQueuedCommands);
+  PTD_RUN(testPresentWhileDrawing);
+  PTD_RUN(testPresentBufferClipping);
+  return PTDTestFinish();
+}
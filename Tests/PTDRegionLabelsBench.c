@@ -0,0 +1,129 @@
+//
+// PTDRegionLabelsBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDRegionLabels.h"
+#include "PTDCanvasStore.h"
+
+
+/* Magic wand clicks on a 5K canvas covered by antialiased handwriting:
+ * labelling the whole canvas, from the canvas and from a published frame,
+ * and answering a click from the labels or by visiting the region alone */
+
+static const size_t _Width = 5120, _Height = 2880;
+
+
+/* round pen strokes of a few colors, with one pixel of antialiasing */
+static void PTDBenchDrawStrokes(PTDPixelBuffer *canvas)
+{
+  static const uint8_t colors[][3] = {{0, 0, 0}, {200, 20, 20}, {20, 20, 200}};
+  memset(canvas->data, 0, canvas->bytesPerRow * canvas->height);
+  uint64_t rng = 5;
+  const double radius = 2.0;
+  for (int i = 0; i < 3000; i++) {
+    const uint8_t *color = colors[PTDTestRandomBelow(&rng, 3)];
+    double x = (double)PTDTestRandomBelow(&rng, canvas->width), y = (double)PTDTestRandomBelow(&rng, canvas->height);
+    double angle = (double)PTDTestRandomBelow(&rng, 628) / 100.0;
+    for (int j = 0; j < 200; j++) {
+      angle += ((double)PTDTestRandomBelow(&rng, 100) - 50.0) / 200.0;
+      x += cos(angle);
+      y += sin(angle);
+      for (long py = (long)(y - radius - 1); py <= (long)(y + radius + 1); py++) {
+        for (long px = (long)(x - radius - 1); px <= (long)(x + radius + 1); px++) {
+          if (px < 0 || py < 0 || px >= (long)canvas->width || py >= (long)canvas->height)
+            continue;
+          double d = hypot((double)px + 0.5 - x, (double)py + 0.5 - y);
+          double a = fmin(1.0, fmax(0.0, radius + 0.5 - d));
+          uint8_t *p = canvas->data + (size_t)py * canvas->bytesPerRow + (size_t)px * 4;
+          if (a * 255.0 <= p[3])
+            continue;
+          for (int c = 0; c < 3; c++)
+            p[c] = (uint8_t)(color[c] * a);
+          p[3] = (uint8_t)(255.0 * a);
+        }
+      }
+    }
+  }
+}
+
+
+int main(void)
+{
+  PTDPixelBuffer canvas = {malloc(_Width * _Height * 4), _Width, _Height, _Width * 4};
+  PTDBenchDrawStrokes(&canvas);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(_Width, _Height);
+  PTDCanvasStorePublish(store, &canvas, 0, 0, _Width, _Height);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  
+  PTDRegionLabels labels;
+  for (int tolerance = 0; tolerance <= 64; tolerance += 32) {
+    char name[80];
+    PTDRegionLabelsInit(&labels, &canvas, (uint8_t)tolerance, SIZE_MAX);
+    printf("tolerance %d: %zu regions\n", tolerance, labels.count);
+    PTDRegionLabelsFree(&labels);
+    snprintf(name, sizeof(name), "label the canvas, tolerance %d", tolerance);
+    PTD_BENCH(name, 1.0,
+        PTDRegionLabelsInit(&labels, &canvas, (uint8_t)tolerance, SIZE_MAX),
+        PTDRegionLabelsFree(&labels));
+    snprintf(name, sizeof(name), "label a published frame, tolerance %d", tolerance);
+    PTD_BENCH(name, 1.0,
+        PTDRegionLabelsInitWithFrame(&labels, frame, (uint8_t)tolerance, SIZE_MAX),
+        PTDRegionLabelsFree(&labels));
+  }
+  
+  /* the background, and the stroke under a point of the last one drawn */
+  PTDRegionLabelsInit(&labels, &canvas, 32, SIZE_MAX);
+  size_t strokeX = 0, strokeY = 0;
+  for (size_t i = 0; i < _Width * _Height && !strokeX; i++) {
+    if (canvas.data[i * 4 + 3] == 255) {
+      strokeX = i % _Width;
+      strokeY = i / _Width;
+    }
+  }
+  size_t backgroundX = 0, backgroundY = 0;
+  while (canvas.data[(backgroundY * _Width + backgroundX) * 4 + 3] != 0)
+    backgroundX++;
+  PTDSelectionMask mask;
+  PTD_BENCH("click on the background, from the labels", 1.0,
+      PTDRegionLabelsMaskAtPixel(&labels, backgroundX, backgroundY, &mask),
+      PTDSelectionMaskFree(&mask));
+  PTD_BENCH("click on the background, visiting the region", 1.0,
+      PTDRegionMaskAtPixel(&canvas, backgroundX, backgroundY, 32, &mask),
+      PTDSelectionMaskFree(&mask));
+  PTD_BENCH("click on a stroke, from the labels", 0.5,
+      PTDRegionLabelsMaskAtPixel(&labels, strokeX, strokeY, &mask),
+      PTDSelectionMaskFree(&mask));
+  PTD_BENCH("click on a stroke, visiting the region", 0.5,
+      PTDRegionMaskAtPixel(&canvas, strokeX, strokeY, 32, &mask),
+      PTDSelectionMaskFree(&mask));
+  PTDRegionLabelsFree(&labels);
+  
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasStoreRelease(store);
+  free(canvas.data);
+  return 0;
+}
@@ -0,0 +1,248 @@
+//
+// PTDRegionLabelsTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDRegionLabels.h"
+#include "PTDCanvasStore.h"
+
+
+static uint32_t PTDTestPixel(const PTDPixelBuffer *canvas, size_t x, size_t y)
+{
+  uint32_t v;
+  memcpy(&v, canvas->data + y * canvas->bytesPerRow + x * 4, 4);
+  return v;
+}
+
+
+static int PTDTestConnected(uint32_t a, uint32_t b, int tolerance)
+{
+  for (int c = 0; c < 32; c += 8) {
+    int d = (int)((a >> c) & 0xFF) - (int)((b >> c) & 0xFF);
+    if (d > tolerance || d < -tolerance)
+      return 0;
+  }
+  return 1;
+}
+
+
+/* Labels the regions by visiting them one at a time, in the order of
+ * their first pixel, which is the order the labeller numbers them in */
+static uint32_t *PTDTestReferenceLabels(const PTDPixelBuffer *canvas, int tolerance, size_t *count)
+{
+  size_t w = canvas->width, h = canvas->height;
+  uint32_t *labels = malloc(w * h * sizeof(uint32_t));
+  size_t *queue = malloc(w * h * sizeof(size_t));
+  for (size_t i = 0; i < w * h; i++)
+    labels[i] = UINT32_MAX;
+  *count = 0;
+  for (size_t start = 0; start < w * h; start++) {
+    if (labels[start] != UINT32_MAX)
+      continue;
+    uint32_t label = (uint32_t)(*count)++;
+    size_t head = 0, tail = 0;
+    labels[start] = label;
+    queue[tail++] = start;
+    while (head < tail) {
+      size_t i = queue[head++], x = i % w, y = i / w;
+      uint32_t p = PTDTestPixel(canvas, x, y);
+      size_t next[4] = {x > 0 ? i - 1 : i, x + 1 < w ? i + 1 : i, y > 0 ? i - w : i, y + 1 < h ? i + w : i};
+      for (int k = 0; k < 4; k++) {
+        size_t j = next[k];
+        if (labels[j] == UINT32_MAX && PTDTestConnected(p, PTDTestPixel(canvas, j % w, j / w), tolerance)) {
+          labels[j] = label;
+          queue[tail++] = j;
+        }
+      }
+    }
+  }
+  free(queue);
+  return labels;
+}
+
+
+static PTDPixelBuffer PTDTestCanvasCreate(size_t width, size_t height)
+{
+  PTDPixelBuffer canvas = {calloc(height, width * 4 + 8), width, height, width * 4 + 8};
+  return canvas;
+}
+
+
+/* rectangles and lines of a few colors, and a gradient, which is a single
+ * region once the tolerance is larger than its steps */
+static PTDPixelBuffer PTDTestRandomDrawing(size_t width, size_t height, uint64_t seed)
+{
+  static const uint32_t colors[] = {0xFF000000, 0xFF080808, 0x80402000, 0xFF0000FF, 0x20202020};
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(width, height);
+  for (size_t y = 0; y < height / 3; y++) {
+    for (size_t x = 0; x < width; x++) {
+      uint32_t v = (uint32_t)(x * 4 % 256) * 0x01010101u;
+      memcpy(canvas.data + y * canvas.bytesPerRow + x * 4, &v, 4);
+    }
+  }
+  for (int i = 0; i < 40; i++) {
+    uint32_t color = colors[PTDTestRandomBelow(&seed, 5)];
+    size_t x = PTDTestRandomBelow(&seed, width), y = PTDTestRandomBelow(&seed, height);
+    size_t rw = 1 + PTDTestRandomBelow(&seed, width / 3 + 1), rh = 1 + PTDTestRandomBelow(&seed, height / 3 + 1);
+    if (PTDTestRandomBelow(&seed, 2))
+      rw = 1 + PTDTestRandomBelow(&seed, 3);
+    else
+      rh = 1 + PTDTestRandomBelow(&seed, 3);
+    for (size_t yy = y; yy < y + rh && yy < height; yy++)
+      for (size_t xx = x; xx < x + rw && xx < width; xx++)
+        memcpy(canvas.data + yy * canvas.bytesPerRow + xx * 4, &color, 4);
+  }
+  return canvas;
+}
+
+
+static int PTDTestLabelsMatch(const PTDRegionLabels *labels, const PTDPixelBuffer *canvas, int tolerance)
+{
+  size_t count;
+  uint32_t *expected = PTDTestReferenceLabels(canvas, tolerance, &count);
+  size_t w = canvas->width, h = canvas->height;
+  int ok = labels->count == count && memcmp(labels->labels, expected, w * h * sizeof(uint32_t)) == 0;
+  
+  for (size_t l = 0; l < count && ok; l++) {
+    PTDRegionBounds b = {UINT32_MAX, UINT32_MAX, 0, 0};
+    for (size_t y = 0; y < h; y++) {
+      for (size_t x = 0; x < w; x++) {
+        if (expected[y * w + x] != l)
+          continue;
+        b.minX = (uint32_t)x < b.minX ? (uint32_t)x : b.minX;
+        b.minY = (uint32_t)y < b.minY ? (uint32_t)y : b.minY;
+        b.maxX = (uint32_t)x > b.maxX ? (uint32_t)x : b.maxX;
+        b.maxY = (uint32_t)y;
+      }
+    }
+    ok = memcmp(&b, &labels->bounds[l], sizeof(b)) == 0;
+  }
+  free(expected);
+  return ok;
+}
+
+
+static void testMatchesReference(void)
+{
+  static const size_t sizes[][2] = {{131, 77}, {64, 64}, {1, 50}, {200, 1}, {65, 130}};
+  static const int tolerances[] = {0, 3, 16, 255};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    PTDPixelBuffer canvas = PTDTestRandomDrawing(sizes[s][0], sizes[s][1], s + 1);
+    for (size_t t = 0; t < sizeof(tolerances) / sizeof(tolerances[0]); t++) {
+      PTDRegionLabels labels;
+      PTD_CHECK(PTDRegionLabelsInit(&labels, &canvas, (uint8_t)tolerances[t], SIZE_MAX));
+      if (!PTD_CHECK(PTDTestLabelsMatch(&labels, &canvas, tolerances[t])))
+        fprintf(stderr, "mismatch: %zux%zu, tolerance %d\n", canvas.width, canvas.height, tolerances[t]);
+      PTDRegionLabelsFree(&labels);
+    }
+    free(canvas.data);
+  }
+}
+
+
+static void testMaskAtPixel(void)
+{
+  /* the mask from the labels is the same as visiting the region alone */
+  PTDPixelBuffer canvas = PTDTestRandomDrawing(150, 90, 7);
+  uint64_t rng = 3;
+  int ok = 1;
+  for (int tolerance = 0; tolerance <= 32; tolerance += 8) {
+    PTDRegionLabels labels;
+    PTD_CHECK(PTDRegionLabelsInit(&labels, &canvas, (uint8_t)tolerance, SIZE_MAX));
+    for (int i = 0; i < 50; i++) {
+      size_t x = PTDTestRandomBelow(&rng, 150), y = PTDTestRandomBelow(&rng, 90);
+      PTDSelectionMask a, b;
+      PTD_CHECK(PTDRegionLabelsMaskAtPixel(&labels, x, y, &a));
+      PTD_CHECK(PTDRegionMaskAtPixel(&canvas, x, y, (uint8_t)tolerance, &b));
+      ok &= a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+      ok &= memcmp(a.coverage, b.coverage, a.width * a.height) == 0;
+      ok &= a.coverage[(y - (size_t)a.y) * a.width + (x - (size_t)a.x)] == 255;
+      PTDSelectionMaskFree(&a);
+      PTDSelectionMaskFree(&b);
+    }
+    PTDSelectionMask outside;
+    PTD_CHECK(PTDRegionLabelsMaskAtPixel(&labels, 150, 0, &outside));
+    PTD_CHECK(outside.width == 0 && outside.coverage == NULL);
+    PTD_CHECK(PTDRegionMaskAtPixel(&canvas, 0, 90, (uint8_t)tolerance, &outside));
+    PTD_CHECK(outside.width == 0 && outside.coverage == NULL);
+    PTDRegionLabelsFree(&labels);
+  }
+  PTD_CHECK(ok);
+  free(canvas.data);
+}
+
+
+static void testFrame(void)
+{
+  /* labelling a published frame, which is made of tiles and has
+   * transparent tiles which take no memory */
+  PTDPixelBuffer canvas = PTDTestRandomDrawing(300, 170, 9);
+  for (size_t y = 100; y < 170; y++)
+    memset(canvas.data + y * canvas.bytesPerRow, 0, 300 * 4);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(300, 170);
+  PTD_CHECK(PTDCanvasStorePublish(store, &canvas, 0, 0, 300, 170));
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  
+  PTDRegionLabels fromCanvas, fromFrame;
+  PTD_CHECK(PTDRegionLabelsInit(&fromCanvas, &canvas, 16, SIZE_MAX));
+  PTD_CHECK(PTDRegionLabelsInitWithFrame(&fromFrame, frame, 16, SIZE_MAX));
+  PTD_CHECK(fromFrame.width == 300 && fromFrame.height == 170);
+  PTD_CHECK(fromCanvas.count == fromFrame.count);
+  PTD_CHECK(memcmp(fromCanvas.labels, fromFrame.labels, 300 * 170 * sizeof(uint32_t)) == 0);
+  PTD_CHECK(memcmp(fromCanvas.bounds, fromFrame.bounds, fromCanvas.count * sizeof(PTDRegionBounds)) == 0);
+  PTDRegionLabelsFree(&fromCanvas);
+  PTDRegionLabelsFree(&fromFrame);
+  
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasStoreRelease(store);
+  free(canvas.data);
+}
+
+
+static void testTooManyRegions(void)
+{
+  PTDPixelBuffer canvas = PTDTestCanvasCreate(100, 100);
+  uint64_t rng = 5;
+  for (size_t y = 0; y < 100; y++)
+    for (size_t x = 0; x < 400; x++)
+      canvas.data[y * canvas.bytesPerRow + x] = (uint8_t)PTDTestRandom(&rng);
+  PTDRegionLabels labels;
+  PTD_CHECK(!PTDRegionLabelsInit(&labels, &canvas, 8, 1000));
+  PTD_CHECK(labels.labels == NULL && labels.bounds == NULL);
+  PTD_CHECK(PTDRegionLabelsInit(&labels, &canvas, 8, SIZE_MAX));
+  PTD_CHECK(labels.count > 1000);
+  PTDRegionLabelsFree(&labels);
+  free(canvas.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testMatchesReference);
+  PTD_RUN(testMaskAtPixel);
+  PTD_RUN(testFrame);
+  PTD_RUN(testTooManyRegions);
+  return PTDTestFinish();
+}
@@ -0,0 +1,103 @@
+//
+// PTDResamplerBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDResampler.h"
+
+
+/* Moving a canvas between a 5K display and one with half or twice its
+ * scale factor */
+
+static const double _Pi = 3.14159265358979323846;
+
+
+static PTDPixelBuffer PTDBenchBufferCreate(size_t width, size_t height)
+{
+  PTDPixelBuffer buffer = {malloc(width * height * 4), width, height, width * 4};
+  return buffer;
+}
+
+
+static void PTDBenchFill(const PTDPixelBuffer *buffer)
+{
+  for (size_t y = 0; y < buffer->height; y++) {
+    for (size_t x = 0; x < buffer->width; x++) {
+      uint8_t *px = buffer->data + y * buffer->bytesPerRow + x * 4;
+      double u = ((double)x + 0.5) / (double)buffer->width, v = ((double)y + 0.5) / (double)buffer->height;
+      for (int c = 0; c < 3; c++)
+        px[c] = (uint8_t)lround(128.0 + 90.0 * sin(2.0 * _Pi * (9.0 * u + c)) * cos(2.0 * _Pi * (5.0 * v)));
+      px[3] = 255;
+    }
+  }
+}
+
+
+static double PTDBenchPSNR(const PTDPixelBuffer *a, const PTDPixelBuffer *b)
+{
+  double se = 0.0;
+  for (size_t i = 0; i < a->width * a->height * 4; i++) {
+    double d = (double)a->data[i] - (double)b->data[i];
+    se += d * d;
+  }
+  return 10.0 * log10(255.0 * 255.0 / (se / (double)(a->width * a->height * 4)));
+}
+
+
+static void PTDBenchScale(const char *name, const PTDPixelBuffer *src, const PTDPixelBuffer *dst, const PTDPixelBuffer *expected)
+{
+  PTDResamplingFilter filter = PTDResamplingFilterForScaling(src, dst);
+  double start = PTDTestNow();
+  int runs = 0;
+  do {
+    PTDResample(src, dst, filter);
+    runs++;
+  } while (PTDTestNow() - start < 2.0);
+  double seconds = (PTDTestNow() - start) / runs;
+  printf("%-48s %10.3f ms %8.1f MP/s %6.2f dB\n", name, seconds * 1000.0,
+      (double)(dst->width * dst->height) / seconds / 1e6, PTDBenchPSNR(dst, expected));
+}
+
+
+int main(void)
+{
+  PTDPixelBuffer src = PTDBenchBufferCreate(5120, 2880);
+  PTDPixelBuffer up = PTDBenchBufferCreate(10240, 5760), upExpected = PTDBenchBufferCreate(10240, 5760);
+  PTDPixelBuffer down = PTDBenchBufferCreate(2560, 1440), downExpected = PTDBenchBufferCreate(2560, 1440);
+  PTDBenchFill(&src);
+  PTDBenchFill(&upExpected);
+  PTDBenchFill(&downExpected);
+  
+  PTDBenchScale("5120x2880 to 2x, bicubic", &src, &up, &upExpected);
+  PTDBenchScale("5120x2880 to 0.5x, lanczos", &src, &down, &downExpected);
+  
+  free(src.data);
+  free(up.data);
+  free(upExpected.data);
+  free(down.data);
+  free(downExpected.data);
+  return 0;
+}
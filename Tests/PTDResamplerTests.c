@@ -0,0 +1,214 @@
+//
+// PTDResamplerTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDResampler.h"
+
+
+static const double _Pi = 3.14159265358979323846;
+
+static const PTDResamplingFilter _Filters[] = {
+  PTDResamplingFilterBilinear, PTDResamplingFilterBicubic, PTDResamplingFilterLanczos3
+};
+
+
+static PTDPixelBuffer PTDTestBufferCreate(size_t width, size_t height)
+{
+  PTDPixelBuffer buffer = {calloc(width * height, 4), width, height, width * 4};
+  return buffer;
+}
+
+
+/* A smooth, opaque image, well below the Nyquist frequency of a canvas
+ * shrunk by half; (x, y) are in units of the width and height */
+static double PTDTestSmoothValue(double x, double y, int c)
+{
+  return 128.0 + 90.0 * sin(2.0 * _Pi * (3.0 * x + c)) * cos(2.0 * _Pi * (2.0 * y + 0.3 * c));
+}
+
+
+static void PTDTestFillSmooth(const PTDPixelBuffer *buffer)
+{
+  for (size_t y = 0; y < buffer->height; y++) {
+    for (size_t x = 0; x < buffer->width; x++) {
+      uint8_t *px = buffer->data + y * buffer->bytesPerRow + x * 4;
+      double u = ((double)x + 0.5) / (double)buffer->width, v = ((double)y + 0.5) / (double)buffer->height;
+      for (int c = 0; c < 3; c++)
+        px[c] = (uint8_t)lround(PTDTestSmoothValue(u, v, c));
+      px[3] = 255;
+    }
+  }
+}
+
+
+static double PTDTestPSNR(const PTDPixelBuffer *a, const PTDPixelBuffer *b)
+{
+  double se = 0.0;
+  for (size_t y = 0; y < a->height; y++) {
+    for (size_t x = 0; x < a->width * 4; x++) {
+      double d = (double)a->data[y * a->bytesPerRow + x] - (double)b->data[y * b->bytesPerRow + x];
+      se += d * d;
+    }
+  }
+  double mse = se / (double)(a->width * a->height * 4);
+  return mse == 0.0 ? INFINITY : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+
+static void testSameSizeIsIdentity(void)
+{
+  PTDPixelBuffer src = PTDTestBufferCreate(53, 31), dst = PTDTestBufferCreate(53, 31);
+  uint64_t rng = 3;
+  for (size_t i = 0; i < 53 * 31; i++) {
+    uint8_t a = (uint8_t)PTDTestRandom(&rng);
+    for (int c = 0; c < 3; c++)
+      src.data[i * 4 + c] = (uint8_t)PTDTestRandomBelow(&rng, (size_t)a + 1);
+    src.data[i * 4 + 3] = a;
+  }
+  for (int f = 0; f < 3; f++) {
+    memset(dst.data, 0x55, 53 * 31 * 4);
+    PTDResample(&src, &dst, _Filters[f]);
+    PTD_CHECK(memcmp(src.data, dst.data, 53 * 31 * 4) == 0);
+  }
+  free(src.data);
+  free(dst.data);
+}
+
+
+static void testConstantColorIsPreserved(void)
+{
+  const size_t sizes[][4] = {{100, 80, 200, 160}, {100, 80, 50, 40}, {97, 13, 31, 57}, {1, 1, 9, 9}, {9, 9, 1, 1}};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    PTDPixelBuffer src = PTDTestBufferCreate(sizes[s][0], sizes[s][1]);
+    PTDPixelBuffer dst = PTDTestBufferCreate(sizes[s][2], sizes[s][3]);
+    for (size_t i = 0; i < src.width * src.height; i++)
+      memcpy(src.data + i * 4, (uint8_t[]){40, 90, 120, 200}, 4);
+    for (int f = 0; f < 3; f++) {
+      PTDResample(&src, &dst, _Filters[f]);
+      int allMatch = 1;
+      for (size_t i = 0; i < dst.width * dst.height; i++)
+        allMatch &= memcmp(dst.data + i * 4, (uint8_t[]){40, 90, 120, 200}, 4) == 0;
+      PTD_CHECK(allMatch);
+    }
+    free(src.data);
+    free(dst.data);
+  }
+}
+
+
+static void testResultStaysPremultiplied(void)
+{
+  /* hard edges between opaque and transparent make the kernels ring */
+  PTDPixelBuffer src = PTDTestBufferCreate(120, 90);
+  for (size_t y = 0; y < 90; y++)
+    for (size_t x = 0; x < 120; x++)
+      if (((x / 7) + (y / 5)) % 2)
+        memcpy(src.data + y * src.bytesPerRow + x * 4, (uint8_t[]){255, 255, 255, 255}, 4);
+  const size_t sizes[][2] = {{240, 180}, {60, 45}, {37, 200}};
+  for (size_t s = 0; s < 3; s++) {
+    PTDPixelBuffer dst = PTDTestBufferCreate(sizes[s][0], sizes[s][1]);
+    for (int f = 0; f < 3; f++) {
+      PTDResample(&src, &dst, _Filters[f]);
+      int premultiplied = 1;
+      for (size_t i = 0; i < dst.width * dst.height; i++)
+        for (int c = 0; c < 3; c++)
+          premultiplied &= dst.data[i * 4 + c] <= dst.data[i * 4 + 3];
+      PTD_CHECK(premultiplied);
+    }
+    free(dst.data);
+  }
+  free(src.data);
+}
+
+
+static void testRowPadding(void)
+{
+  /* rows with padding must not be read or written past their width */
+  PTDPixelBuffer src = {calloc(64 * 48 + 16, 1), 10, 48, 64};
+  PTDPixelBuffer dst = {calloc(128 * 96, 1), 20, 96, 128};
+  for (size_t y = 0; y < 48; y++)
+    memset(src.data + y * 64, 0x80, 40);
+  for (size_t y = 0; y < 48; y++)
+    memset(src.data + y * 64 + 40, 0xFF, 24);
+  PTDResample(&src, &dst, PTDResamplingFilterBicubic);
+  int ok = 1;
+  for (size_t y = 0; y < 96; y++) {
+    for (size_t x = 0; x < 80; x++)
+      ok &= dst.data[y * 128 + x] == 0x80;
+    for (size_t x = 80; x < 128; x++)
+      ok &= dst.data[y * 128 + x] == 0;
+  }
+  PTD_CHECK(ok);
+  free(src.data);
+  free(dst.data);
+}
+
+
+static void testQuality(void)
+{
+  PTDPixelBuffer src = PTDTestBufferCreate(640, 360);
+  PTDTestFillSmooth(&src);
+  
+  PTDPixelBuffer up = PTDTestBufferCreate(1280, 720), upExpected = PTDTestBufferCreate(1280, 720);
+  PTDTestFillSmooth(&upExpected);
+  PTDResample(&src, &up, PTDResamplingFilterForScaling(&src, &up));
+  double upPSNR = PTDTestPSNR(&up, &upExpected);
+  printf("  2x    %6.2f dB\n", upPSNR);
+  PTD_CHECK(upPSNR > 40.0);
+  
+  PTDPixelBuffer down = PTDTestBufferCreate(320, 180), downExpected = PTDTestBufferCreate(320, 180);
+  PTDTestFillSmooth(&downExpected);
+  PTDResample(&src, &down, PTDResamplingFilterForScaling(&src, &down));
+  double downPSNR = PTDTestPSNR(&down, &downExpected);
+  printf("  0.5x  %6.2f dB\n", downPSNR);
+  PTD_CHECK(downPSNR > 40.0);
+  
+  /* there and back again */
+  PTDPixelBuffer back = PTDTestBufferCreate(640, 360);
+  PTDResample(&up, &back, PTDResamplingFilterForScaling(&up, &back));
+  double roundTripPSNR = PTDTestPSNR(&back, &src);
+  printf("  2x, then 0.5x  %6.2f dB\n", roundTripPSNR);
+  PTD_CHECK(roundTripPSNR > 40.0);
+  
+  free(src.data);
+  free(up.data);
+  free(upExpected.data);
+  free(down.data);
+  free(downExpected.data);
+  free(back.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testSameSizeIsIdentity);
+  PTD_RUN(testConstantColorIsPreserved);
+  PTD_RUN(testResultStaysPremultiplied);
+  PTD_RUN(testRowPadding);
+  PTD_RUN(testQuality);
+  return PTDTestFinish();
+}
@@ -0,0 +1,73 @@
+//
+// PTDSelectionMaskBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDSelectionMask.h"
+
+
+/* A lasso drawn around most of a 5K canvas, as a wobbly loop with one
+ * point per pixel of mouse movement, and the copy, cut and fill of the
+ * selection it makes */
+
+static const double _Pi = 3.14159265358979323846;
+
+
+int main(void)
+{
+  const size_t width = 5120, height = 2880, count = 12000;
+  double *points = malloc(count * 2 * sizeof(double));
+  for (size_t i = 0; i < count; i++) {
+    double a = (double)i * 2.0 * _Pi / (double)count;
+    double r = 1.0 + 0.05 * sin(a * 37.0);
+    points[i*2] = (double)width / 2.0 + r * 2400.0 * cos(a);
+    points[i*2+1] = (double)height / 2.0 + r * 1300.0 * sin(a);
+  }
+  PTDPixelBuffer canvas = {malloc(width * height * 4), width, height, width * 4};
+  memset(canvas.data, 0x80, width * height * 4);
+  
+  PTDSelectionMask mask;
+  PTD_BENCH("rasterize lasso, 12000 points, non-zero", 1.0,
+      PTDSelectionMaskInitWithPolygon(&mask, points, count, PTDFillRuleNonZero, width, height),
+      PTDSelectionMaskFree(&mask));
+  PTD_BENCH("rasterize lasso, 12000 points, even-odd", 1.0,
+      PTDSelectionMaskInitWithPolygon(&mask, points, count, PTDFillRuleEvenOdd, width, height),
+      PTDSelectionMaskFree(&mask));
+  
+  PTDSelectionMaskInitWithPolygon(&mask, points, count, PTDFillRuleNonZero, width, height);
+  PTDPixelBuffer copy = {malloc(mask.width * mask.height * 4), mask.width, mask.height, mask.width * 4};
+  printf("selection of %zux%zu pixels\n", mask.width, mask.height);
+  const uint8_t color[4] = {0, 0, 0, 0};
+  PTD_BENCH("masked copy", 1.0, PTDSelectionMaskCopy(&mask, &canvas, &copy));
+  PTD_BENCH("masked clear", 1.0, PTDSelectionMaskClear(&mask, &canvas));
+  PTD_BENCH("masked fill", 1.0, PTDSelectionMaskFill(&mask, &canvas, color));
+  
+  PTDSelectionMaskFree(&mask);
+  free(copy.data);
+  free(canvas.data);
+  free(points);
+  return 0;
+}
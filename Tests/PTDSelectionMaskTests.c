@@ -0,0 +1,332 @@
+//
+// PTDSelectionMaskTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDSelectionMask.h"
+
+
+static const double _Pi = 3.14159265358979323846;
+
+
+static double PTDTestMaskArea(const PTDSelectionMask *mask)
+{
+  double sum = 0.0;
+  for (size_t i = 0; i < mask->width * mask->height; i++)
+    sum += mask->coverage[i];
+  return sum / 255.0;
+}
+
+
+static uint8_t PTDTestMaskAt(const PTDSelectionMask *mask, long x, long y)
+{
+  if (x < mask->x || y < mask->y || x >= mask->x + (long)mask->width || y >= mask->y + (long)mask->height)
+    return 0;
+  return mask->coverage[(size_t)(y - mask->y) * mask->width + (size_t)(x - mask->x)];
+}
+
+
+static PTDPixelBuffer PTDTestRandomImage(size_t width, size_t height, uint64_t seed)
+{
+  PTDPixelBuffer buffer = {malloc(width * height * 4), width, height, width * 4};
+  for (size_t i = 0; i < width * height; i++) {
+    uint8_t a = (uint8_t)PTDTestRandom(&seed);
+    for (int c = 0; c < 3; c++)
+      buffer.data[i * 4 + c] = (uint8_t)PTDTestRandomBelow(&seed, (size_t)a + 1);
+    buffer.data[i * 4 + 3] = a;
+  }
+  return buffer;
+}
+
+
+static uint8_t PTDTestScale(uint8_t v, unsigned m)
+{
+  return (uint8_t)lround((double)v * (double)m / 255.0);
+}
+
+
+static void testPixelAlignedRect(void)
+{
+  const double points[] = {10, 5, 30, 5, 30, 25, 10, 25};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, points, 4, PTDFillRuleNonZero, 100, 100));
+  PTD_CHECK(mask.x == 10 && mask.y == 5 && mask.width == 20 && mask.height == 20);
+  int full = 1;
+  for (size_t i = 0; i < mask.width * mask.height; i++)
+    full &= mask.coverage[i] == 255;
+  PTD_CHECK(full);
+  PTDSelectionMaskFree(&mask);
+}
+
+
+static void testFractionalRect(void)
+{
+  /* the edges cover a quarter of the pixels on the sides; the vertical
+   * coverage is sampled on 4 subscanlines, so it is exact at .25 too */
+  const double points[] = {10.25, 5.25, 20.75, 5.25, 20.75, 15.75, 10.25, 15.75};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, points, 4, PTDFillRuleNonZero, 100, 100));
+  PTD_CHECK(mask.x == 10 && mask.y == 5 && mask.width == 11 && mask.height == 11);
+  PTD_CHECK(fabs(PTDTestMaskArea(&mask) - 10.5 * 10.5) < 0.5);
+  PTD_CHECK(PTDTestMaskAt(&mask, 15, 10) == 255);
+  PTD_CHECK(abs((int)PTDTestMaskAt(&mask, 10, 10) - 191) <= 1);
+  PTD_CHECK(abs((int)PTDTestMaskAt(&mask, 20, 10) - 191) <= 1);
+  PTD_CHECK(abs((int)PTDTestMaskAt(&mask, 10, 5) - 143) <= 1);
+  PTDSelectionMaskFree(&mask);
+}
+
+
+static void testPolygonArea(void)
+{
+  /* a triangle, and a circle approximated by many points; the orientation
+   * of the polygon does not matter */
+  const double triangle[] = {3.3, 7.1, 90.6, 20.4, 41.2, 77.9};
+  double expected = fabs((90.6 - 3.3) * (77.9 - 7.1) - (41.2 - 3.3) * (20.4 - 7.1)) / 2.0;
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, triangle, 3, PTDFillRuleNonZero, 100, 100));
+  PTD_CHECK(fabs(PTDTestMaskArea(&mask) - expected) < expected * 0.005);
+  PTDSelectionMaskFree(&mask);
+  
+  double circle[720];
+  for (int i = 0; i < 360; i++) {
+    double a = -(double)i * _Pi / 180.0;
+    circle[i*2] = 150.0 + 100.0 * cos(a);
+    circle[i*2+1] = 130.0 + 100.0 * sin(a);
+  }
+  expected = 360.0 / 2.0 * 100.0 * 100.0 * sin(2.0 * _Pi / 360.0);
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, circle, 360, PTDFillRuleEvenOdd, 300, 300));
+  PTD_CHECK(fabs(PTDTestMaskArea(&mask) - expected) < expected * 0.002);
+  PTDSelectionMaskFree(&mask);
+}
+
+
+static void testFillRules(void)
+{
+  /* a square drawn twice in the same direction is filled by the non-zero
+   * rule and empty with even-odd; a five pointed star has a hole in the
+   * middle only with even-odd */
+  const double twice[] = {10, 10, 30, 10, 30, 30, 10, 30, 10, 10, 30, 10, 30, 30, 10, 30};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, twice, 8, PTDFillRuleNonZero, 50, 50));
+  PTD_CHECK(PTDTestMaskAt(&mask, 20, 20) == 255);
+  PTDSelectionMaskFree(&mask);
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, twice, 8, PTDFillRuleEvenOdd, 50, 50));
+  PTD_CHECK(PTDTestMaskAt(&mask, 20, 20) == 0);
+  PTDSelectionMaskFree(&mask);
+  
+  double star[10];
+  for (int i = 0; i < 5; i++) {
+    double a = (double)(i * 2 % 5) * 2.0 * _Pi / 5.0 - _Pi / 2.0;
+    star[i*2] = 50.0 + 40.0 * cos(a);
+    star[i*2+1] = 50.0 + 40.0 * sin(a);
+  }
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, star, 5, PTDFillRuleNonZero, 100, 100));
+  PTD_CHECK(PTDTestMaskAt(&mask, 50, 50) == 255);
+  PTD_CHECK(PTDTestMaskAt(&mask, 50, 15) == 255);
+  PTDSelectionMaskFree(&mask);
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, star, 5, PTDFillRuleEvenOdd, 100, 100));
+  PTD_CHECK(PTDTestMaskAt(&mask, 50, 50) == 0);
+  PTD_CHECK(PTDTestMaskAt(&mask, 50, 15) == 255);
+  PTDSelectionMaskFree(&mask);
+}
+
+
+static void testClippedToCanvas(void)
+{
+  const double points[] = {-20, -10, 60, -10, 60, 70, -20, 70};
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, points, 4, PTDFillRuleNonZero, 50, 40));
+  PTD_CHECK(mask.x == 0 && mask.y == 0 && mask.width == 50 && mask.height == 40);
+  PTD_CHECK(fabs(PTDTestMaskArea(&mask) - 50.0 * 40.0) < 0.5);
+  PTDSelectionMaskFree(&mask);
+  
+  /* entirely outside, degenerate and too short polygons give empty masks */
+  const double outside[] = {60, 10, 80, 10, 80, 30};
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, outside, 3, PTDFillRuleNonZero, 50, 40));
+  PTD_CHECK(mask.width == 0 && mask.coverage == NULL);
+  const double flat[] = {10, 10, 20, 10, 30, 10};
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, flat, 3, PTDFillRuleNonZero, 50, 40));
+  PTD_CHECK(PTDTestMaskArea(&mask) == 0.0);
+  PTDSelectionMaskFree(&mask);
+  PTD_CHECK(PTDSelectionMaskInitWithPolygon(&mask, points, 2, PTDFillRuleNonZero, 50, 40));
+  PTD_CHECK(mask.width == 0);
+  PTDSelectionMaskFree(&mask);
+}
+
+
+static void testCopyClearFill(void)
+{
+  PTDPixelBuffer canvas = PTDTestRandomImage(64, 48, 7);
+  PTDPixelBuffer original = PTDTestRandomImage(64, 48, 7);
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInit(&mask, 20, 10, 30, 25));
+  uint64_t rng = 3;
+  for (size_t i = 0; i < 30 * 25; i++) {
+    size_t r = PTDTestRandomBelow(&rng, 4);
+    mask.coverage[i] = r == 0 ? 0 : (r == 1 ? 255 : (uint8_t)PTDTestRandom(&rng));
+  }
+  
+  PTDPixelBuffer copy = {malloc(30 * 25 * 4 + 8 * 25), 30, 25, 30 * 4 + 8};
+  PTDSelectionMaskCopy(&mask, &canvas, &copy);
+  int copyOk = 1;
+  for (size_t y = 0; y < 25; y++) {
+    for (size_t x = 0; x < 30; x++) {
+      uint8_t m = mask.coverage[y * 30 + x];
+      const uint8_t *src = canvas.data + (y + 10) * canvas.bytesPerRow + (x + 20) * 4;
+      const uint8_t *out = copy.data + y * copy.bytesPerRow + x * 4;
+      for (int c = 0; c < 4; c++)
+        copyOk &= out[c] == PTDTestScale(src[c], m);
+    }
+  }
+  PTD_CHECK(copyOk);
+  
+  const uint8_t color[4] = {10, 20, 30, 200};
+  PTDPixelBuffer filled = PTDTestRandomImage(64, 48, 7);
+  PTDSelectionMaskFill(&mask, &filled, color);
+  PTDSelectionMaskClear(&mask, &canvas);
+  int clearOk = 1, fillOk = 1;
+  for (size_t y = 0; y < 48; y++) {
+    for (size_t x = 0; x < 64; x++) {
+      uint8_t m = PTDTestMaskAt(&mask, (long)x, (long)y);
+      const uint8_t *orig = original.data + y * 256 + x * 4;
+      const uint8_t *cleared = canvas.data + y * 256 + x * 4;
+      const uint8_t *fill = filled.data + y * 256 + x * 4;
+      for (int c = 0; c < 4; c++) {
+        clearOk &= cleared[c] == PTDTestScale(orig[c], 255u - m);
+        long expected = lround(((double)orig[c] * (255.0 - m) + (double)color[c] * m) / 255.0);
+        fillOk &= labs((long)fill[c] - expected) <= 1;
+      }
+    }
+  }
+  PTD_CHECK(clearOk);
+  PTD_CHECK(fillOk);
+  
+  PTDSelectionMaskFree(&mask);
+  free(canvas.data);
+  free(original.data);
+  free(filled.data);
+  free(copy.data);
+}
+
+
+static void testPasteRestoresCanvas(void)
+{
+  PTDPixelBuffer canvas = PTDTestRandomImage(64, 48, 9);
+  PTDPixelBuffer original = PTDTestRandomImage(64, 48, 9);
+  PTDSelectionMask mask;
+  /* partly outside the canvas */
+  PTD_CHECK(PTDSelectionMaskInit(&mask, 40, -5, 30, 25));
+  uint64_t rng = 5;
+  for (size_t i = 0; i < 30 * 25; i++) {
+    size_t r = PTDTestRandomBelow(&rng, 3);
+    mask.coverage[i] = r == 0 ? 0 : (r == 1 ? 255 : (uint8_t)PTDTestRandom(&rng));
+  }
+  
+  PTDPixelBuffer copy = {malloc(30 * 25 * 4), 30, 25, 30 * 4};
+  PTDSelectionMaskCopy(&mask, &canvas, &copy);
+  PTDSelectionMaskClear(&mask, &canvas);
+  PTDSelectionMaskPaste(&mask, &copy, &canvas);
+  int exactOk = 1, closeOk = 1;
+  for (size_t y = 0; y < 48; y++) {
+    for (size_t x = 0; x < 64; x++) {
+      uint8_t m = PTDTestMaskAt(&mask, (long)x, (long)y);
+      const uint8_t *orig = original.data + y * 256 + x * 4;
+      const uint8_t *restored = canvas.data + y * 256 + x * 4;
+      for (int c = 0; c < 4; c++) {
+        if (m == 0 || m == 255)
+          exactOk &= restored[c] == orig[c];
+        else
+          closeOk &= abs((int)restored[c] - (int)orig[c]) <= 1;
+      }
+    }
+  }
+  PTD_CHECK(exactOk);
+  PTD_CHECK(closeOk);
+  
+  PTDSelectionMaskFree(&mask);
+  free(canvas.data);
+  free(original.data);
+  free(copy.data);
+}
+
+
+static void testMaskOutsideCanvas(void)
+{
+  /* a mask hanging over the top left corner only touches the overlap,
+   * and the parts of the copy outside of the canvas are transparent */
+  PTDPixelBuffer canvas = PTDTestRandomImage(16, 16, 9);
+  PTDPixelBuffer original = PTDTestRandomImage(16, 16, 9);
+  PTDSelectionMask mask;
+  PTD_CHECK(PTDSelectionMaskInit(&mask, -4, -6, 10, 10));
+  memset(mask.coverage, 255, 100);
+  PTDPixelBuffer copy = {malloc(10 * 10 * 4), 10, 10, 40};
+  memset(copy.data, 0xAA, 400);
+  PTDSelectionMaskCopy(&mask, &canvas, &copy);
+  PTDSelectionMaskClear(&mask, &canvas);
+  
+  int copyOk = 1, clearOk = 1;
+  for (long y = 0; y < 10; y++) {
+    for (long x = 0; x < 10; x++) {
+      long cx = x - 4, cy = y - 6;
+      const uint8_t *out = copy.data + y * 40 + x * 4;
+      for (int c = 0; c < 4; c++) {
+        if (cx < 0 || cy < 0)
+          copyOk &= out[c] == 0;
+        else
+          copyOk &= out[c] == original.data[cy * 64 + cx * 4 + c];
+      }
+    }
+  }
+  for (long y = 0; y < 16; y++)
+    for (long x = 0; x < 16; x++)
+      for (int c = 0; c < 4; c++)
+        clearOk &= canvas.data[y * 64 + x * 4 + c] == (x < 6 && y < 4 ? 0 : original.data[y * 64 + x * 4 + c]);
+  PTD_CHECK(copyOk);
+  PTD_CHECK(clearOk);
+  
+  PTDSelectionMaskFree(&mask);
+  PTD_CHECK(PTDSelectionMaskInit(&mask, 20, 20, 5, 5));
+  memset(mask.coverage, 255, 25);
+  PTDSelectionMaskClear(&mask, &canvas);
+  PTDSelectionMaskFree(&mask);
+  free(canvas.data);
+  free(original.data);
+  free(copy.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testPixelAlignedRect);
+  PTD_RUN(testFractionalRect);
+  PTD_RUN(testPolygonArea);
+  PTD_RUN(testFillRules);
+  PTD_RUN(testClippedToCanvas);
+  PTD_RUN(testCopyClearFill);
+  PTD_RUN(testPasteRestoresCanvas);
+  PTD_RUN(testMaskOutsideCanvas);
+  return PTDTestFinish();
+}
@@ -0,0 +1,60 @@
+//
+// PTDShapeRasterBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDShapeRaster.h"
+
+
+/* Rectangles, rounded rectangles and ovals of several sizes and line
+ * widths, stroked and filled, on a canvas large enough for all of them */
+
+int main(void)
+{
+  PTDPixelBuffer canvas = {calloc(2100 * 2100, 4), 2100, 2100, 2100 * 4};
+  static const uint8_t color[4] = {30, 60, 120, 200};
+  static const char *kinds[] = {"rect", "round rect", "oval"};
+  static const float sizes[] = {16.0f, 128.0f, 1024.0f, 2048.0f};
+  static const float widths[] = {1.0f, 4.0f, 16.0f};
+  
+  for (int kind = 0; kind < 3; kind++) {
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      for (int filled = 0; filled < 2; filled++) {
+        for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+          /* the line width does not change much for filled shapes */
+          if (filled && w > 0)
+            break;
+          PTDShapeRasterShape shape = {(PTDShapeRasterKind)kind, 1050.3f, 1049.6f, sizes[s] / 2.0f, sizes[s] / 3.0f, sizes[s] / 8.0f, widths[w], filled};
+          char name[80];
+          snprintf(name, sizeof(name), "%s %gpx, %s %g", kinds[kind], sizes[s], filled ? "filled," : "line", widths[w]);
+          PTD_BENCH(name, 0.3, PTDShapeRasterDraw(&canvas, &shape, color));
+        }
+      }
+    }
+  }
+  
+  free(canvas.data);
+  return 0;
+}
@@ -0,0 +1,267 @@
+//
+// PTDShapeRasterTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDShapeRaster.h"
+
+
+/* The coverage drawn in white over a transparent canvas is compared to the
+ * area of each pixel inside the shape, estimated with 8x8 samples and
+ * exact distances computed in double precision */
+
+#define SAMPLES 8
+
+
+static double PTDReferenceBoxDistance(double x, double y, double hw, double hh, double r)
+{
+  double qx = x - (hw - r), qy = y - (hh - r);
+  double ox = fmax(qx, 0.0), oy = fmax(qy, 0.0);
+  return sqrt(ox * ox + oy * oy) + fmin(fmax(qx, qy), 0.0) - r;
+}
+
+
+static double PTDReferenceEllipseDistance(double x, double y, double a, double b)
+{
+  /* the closest point by bisection on the parameter of the normal, as in
+   * the classic two-dimensional distance to an ellipse */
+  if (a < b) {
+    double t = a; a = b; b = t;
+    t = x; x = y; y = t;
+  }
+  double inside = (x * x) / (a * a) + (y * y) / (b * b) - 1.0;
+  if (x == 0.0)
+    return y - b;
+  double lo = -b * b, hi = sqrt(a * a * x * x + b * b * y * y);
+  if (y == 0.0 && x < a - b * b / a)
+    lo = -b * b + 1e-12;
+  for (int i = 0; i < 40; i++) {
+    double t = (lo + hi) / 2.0;
+    double fx = a * x / (t + a * a), fy = b * y / (t + b * b);
+    if (fx * fx + fy * fy - 1.0 > 0.0)
+      lo = t;
+    else
+      hi = t;
+  }
+  double t = (lo + hi) / 2.0;
+  double px = a * a * x / (t + a * a), py = b * b * y / (t + b * b);
+  if (y == 0.0 && x < a - b * b / a) {
+    px = a * a * x / (a * a - b * b);
+    py = b * sqrt(fmax(0.0, 1.0 - px * px / (a * a)));
+  }
+  double d = hypot(x - px, y - py);
+  return inside < 0.0 ? -d : d;
+}
+
+
+/* signed distances from the outer and the inner edge of the stroke */
+static void PTDReferenceDistances(const PTDShapeRasterShape *s, double x, double y, double *outer, double *inner)
+{
+  x = fabs(x - s->centerX);
+  y = fabs(y - s->centerY);
+  double hlw = s->lineWidth / 2.0;
+  double d;
+  switch (s->kind) {
+    case PTDShapeRasterKindRectangle:
+      d = PTDReferenceBoxDistance(x, y, s->halfWidth, s->halfHeight, 0.0);
+      *outer = PTDReferenceBoxDistance(x, y, s->halfWidth + hlw, s->halfHeight + hlw, 0.0);
+      break;
+    case PTDShapeRasterKindRoundRect:
+      d = PTDReferenceBoxDistance(x, y, s->halfWidth, s->halfHeight, fmin(s->cornerRadius, fmin(s->halfWidth, s->halfHeight)));
+      *outer = d - hlw;
+      break;
+    default:
+      d = PTDReferenceEllipseDistance(x, y, s->halfWidth, s->halfHeight);
+      *outer = d - hlw;
+      break;
+  }
+  *inner = d + hlw;
+}
+
+
+static int PTDReferenceInside(const PTDShapeRasterShape *s, double x, double y)
+{
+  double outer, inner;
+  PTDReferenceDistances(s, x, y, &outer, &inner);
+  return outer < 0.0 && (s->filled || inner > 0.0);
+}
+
+
+/* The area of the pixel inside the shape. Pixels whose center is far
+ * enough from the edges are either covered or empty, and are marked as
+ * exact. */
+static double PTDReferenceCoverage(const PTDShapeRasterShape *s, long px, long py, int *exact)
+{
+  double outer, inner;
+  PTDReferenceDistances(s, px + 0.5, py + 0.5, &outer, &inner);
+  *exact = fabs(outer) > 1.5 && (s->filled || fabs(inner) > 1.5);
+  if (fabs(outer) > 0.75 && (s->filled || fabs(inner) > 0.75))
+    return PTDReferenceInside(s, px + 0.5, py + 0.5);
+  int count = 0;
+  for (int j = 0; j < SAMPLES; j++)
+    for (int i = 0; i < SAMPLES; i++)
+      count += PTDReferenceInside(s, px + (i + 0.5) / SAMPLES, py + (j + 0.5) / SAMPLES);
+  return (double)count / (SAMPLES * SAMPLES);
+}
+
+
+/* Mean and maximum error of the coverage of the edge pixels. Coverage is
+ * estimated from the distance to the edges, which is less accurate near
+ * corners and where an edge curves within a pixel. */
+static void PTDCheckShape(const PTDShapeRasterShape *shape, double maxMeanError, double maxError)
+{
+  const size_t size = 96;
+  PTDPixelBuffer canvas = {calloc(size * size, 4), size, size, size * 4};
+  static const uint8_t white[4] = {255, 255, 255, 255};
+  PTDShapeRasterDraw(&canvas, shape, white);
+  
+  double sum = 0.0, worst = 0.0;
+  long edgePixels = 0;
+  int ok = 1;
+  for (long y = 0; y < (long)size; y++) {
+    for (long x = 0; x < (long)size; x++) {
+      const uint8_t *p = canvas.data + (y * (long)size + x) * 4;
+      ok &= p[0] == p[3] && p[1] == p[3] && p[2] == p[3];
+      int exact;
+      double expected = PTDReferenceCoverage(shape, x, y, &exact);
+      double error = fabs(p[3] / 255.0 - expected);
+      if (exact) {
+        ok &= error == 0.0;
+        continue;
+      }
+      sum += error;
+      edgePixels++;
+      worst = fmax(worst, error);
+    }
+  }
+  double mean = edgePixels ? sum / (double)edgePixels : 0.0;
+  if (!PTD_CHECK(ok && mean <= maxMeanError && worst <= maxError))
+    fprintf(stderr, "  kind %d, %gx%g, line width %g, filled %d: mean error %.3f, max %.3f\n",
+        shape->kind, shape->halfWidth * 2, shape->halfHeight * 2, shape->lineWidth, shape->filled, mean, worst);
+  free(canvas.data);
+}
+
+
+static void testRectangles(void)
+{
+  static const float widths[] = {0.0f, 1.0f, 2.5f, 8.0f};
+  for (int filled = 0; filled < 2; filled++) {
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+      if (widths[w] == 0.0f && !filled)
+        continue;
+      PTDShapeRasterShape shape = {PTDShapeRasterKindRectangle, 48.3f, 47.6f, 30.2f, 20.7f, 0.0f, widths[w], filled};
+      PTDCheckShape(&shape, 0.02, 0.2);
+    }
+  }
+}
+
+
+static void testRoundRects(void)
+{
+  static const float radii[] = {0.0f, 3.0f, 12.0f, 100.0f};
+  for (int filled = 0; filled < 2; filled++) {
+    for (size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+      PTDShapeRasterShape shape = {PTDShapeRasterKindRoundRect, 48.0f, 48.5f, 35.0f, 25.3f, radii[r], 3.0f, filled};
+      PTDCheckShape(&shape, 0.02, 0.2);
+    }
+  }
+}
+
+
+static void testOvals(void)
+{
+  static const float axes[][2] = {{30.0f, 30.0f}, {40.0f, 12.0f}, {8.0f, 35.0f}, {3.0f, 2.0f}, {40.0f, 0.3f}};
+  static const float widths[] = {1.0f, 4.0f};
+  for (int filled = 0; filled < 2; filled++) {
+    for (size_t a = 0; a < sizeof(axes) / sizeof(axes[0]); a++) {
+      for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        PTDShapeRasterShape shape = {PTDShapeRasterKindOval, 48.2f, 47.7f, axes[a][0], axes[a][1], 0.0f, widths[w], filled};
+        /* ovals flatter than a pixel are drawn as rectangles */
+        if (axes[a][1] < 0.5f)
+          shape.kind = PTDShapeRasterKindRectangle;
+        PTDCheckShape(&shape, 0.03, 0.3);
+      }
+    }
+  }
+}
+
+
+static void testClipping(void)
+{
+  /* shapes across the edges of the canvas and completely outside of it */
+  PTDPixelBuffer canvas = {calloc(32 * 32, 4), 32, 32, 32 * 4};
+  static const uint8_t color[4] = {10, 20, 30, 40};
+  static const float centers[][2] = {{0, 0}, {32, 0}, {0, 32}, {32, 32}, {-50, 10}, {10, 90}, {16, 16}};
+  for (int kind = 0; kind < 3; kind++) {
+    for (size_t c = 0; c < sizeof(centers) / sizeof(centers[0]); c++) {
+      PTDShapeRasterShape shape = {(PTDShapeRasterKind)kind, centers[c][0], centers[c][1], 20.0f, 14.0f, 5.0f, 3.0f, 1};
+      PTDShapeRasterDraw(&canvas, &shape, color);
+    }
+  }
+  PTD_CHECK(canvas.data[(16 * 32 + 16) * 4 + 3] > 0);
+  
+  /* empty shapes draw nothing */
+  uint8_t *blank = calloc(32 * 32, 4);
+  PTDPixelBuffer empty = {blank, 32, 32, 32 * 4};
+  PTDShapeRasterShape unstroked = {PTDShapeRasterKindOval, 16, 16, 10, 10, 0, 0.0f, 0};
+  PTDShapeRasterDraw(&empty, &unstroked, color);
+  PTDShapeRasterShape shape = {PTDShapeRasterKindRectangle, 16, 16, 10, 10, 0, 2.0f, 1};
+  PTDShapeRasterDraw(&empty, &shape, (uint8_t[4]){0, 0, 0, 0});
+  int untouched = 1;
+  for (size_t i = 0; i < 32 * 32 * 4; i++)
+    untouched &= blank[i] == 0;
+  PTD_CHECK(untouched);
+  free(blank);
+  free(canvas.data);
+}
+
+
+static void testComposite(void)
+{
+  /* source over with a translucent color on an opaque background */
+  PTDPixelBuffer canvas = {malloc(32 * 32 * 4), 32, 32, 32 * 4};
+  memset(canvas.data, 200, 32 * 32 * 4);
+  static const uint8_t color[4] = {0, 50, 100, 128};
+  PTDShapeRasterShape shape = {PTDShapeRasterKindRectangle, 16, 16, 12, 12, 0, 0.0f, 1};
+  PTDShapeRasterDraw(&canvas, &shape, color);
+  const uint8_t *p = canvas.data + (16 * 32 + 16) * 4;
+  for (int c = 0; c < 4; c++)
+    PTD_CHECK(fabs(p[c] - (color[c] + 200.0 * (1.0 - 128.0 / 255.0))) <= 1.0);
+  p = canvas.data;
+  PTD_CHECK(p[0] == 200 && p[3] == 200);
+  free(canvas.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testRectangles);
+  PTD_RUN(testRoundRects);
+  PTD_RUN(testOvals);
+  PTD_RUN(testClipping);
+  PTD_RUN(testComposite);
+  return PTDTestFinish();
+}
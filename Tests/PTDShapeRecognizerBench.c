@@ -0,0 +1,113 @@
+//
+// PTDShapeRecognizerBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDShapeRecognizer.h"
+
+
+/* Feeding strokes to the recognizer point by point, as the pencil tool
+ * does while drawing, and recognizing them at the end; long strokes show
+ * that the cost of both stays linear */
+
+static const double _Pi = 3.14159265358979323846;
+
+
+static size_t PTDBenchEllipse(double *points, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    double t = 2.0 * _Pi * (double)i / (double)(count - 1);
+    points[2*i] = 300.0 * cos(t) - 100.0 * sin(t);
+    points[2*i+1] = 200.0 * sin(t) + 50.0 * cos(t);
+  }
+  return count;
+}
+
+
+static size_t PTDBenchPentagon(double *points, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    double s = 5.0 * (double)i / (double)(count - 1);
+    int side = s >= 5.0 ? 4 : (int)s;
+    double t = s - side;
+    double a0 = 2.0 * _Pi * side / 5.0, a1 = 2.0 * _Pi * (side + 1) / 5.0;
+    points[2*i] = 300.0 * ((1.0 - t) * cos(a0) + t * cos(a1));
+    points[2*i+1] = 300.0 * ((1.0 - t) * sin(a0) + t * sin(a1));
+  }
+  return count;
+}
+
+
+static size_t PTDBenchScribble(double *points, size_t count)
+{
+  uint64_t rng = 9;
+  double x = 0, y = 0, angle = 0;
+  for (size_t i = 0; i < count; i++) {
+    angle += ((double)PTDTestRandomBelow(&rng, 1001) / 500.0 - 1.0) * 0.3;
+    x += cos(angle);
+    y += sin(angle);
+    points[2*i] = x;
+    points[2*i+1] = y;
+  }
+  return count;
+}
+
+
+static void PTDBenchAddStroke(PTDShapeRecognizer *r, const double *points, size_t count)
+{
+  PTDShapeRecognizerReset(r);
+  for (size_t i = 0; i < count; i++)
+    PTDShapeRecognizerAddPoint(r, points[2*i], points[2*i+1]);
+}
+
+
+int main(void)
+{
+  static const struct {
+    const char *name;
+    size_t (*generate)(double *, size_t);
+  } strokes[] = {{"ellipse", PTDBenchEllipse}, {"pentagon", PTDBenchPentagon}, {"scribble", PTDBenchScribble}};
+  static const size_t counts[] = {1000, 10000, 100000};
+  PTDShapeRecognizer *r = PTDShapeRecognizerCreate();
+  double *points = malloc(100000 * 2 * sizeof(double));
+  
+  for (size_t s = 0; s < sizeof(strokes) / sizeof(strokes[0]); s++) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+      size_t count = strokes[s].generate(points, counts[c]);
+      PTDRecognizedShape shape;
+      char name[80];
+      snprintf(name, sizeof(name), "%s, %zu points, add", strokes[s].name, count);
+      PTD_BENCH(name, 0.3,
+          PTDBenchAddStroke(r, points, count));
+      snprintf(name, sizeof(name), "%s, %zu points, recognize", strokes[s].name, count);
+      PTD_BENCH(name, 0.3, PTDShapeRecognizerRecognize(r, &shape));
+      printf("  recognized as kind %d\n", shape.kind);
+    }
+  }
+  
+  free(points);
+  PTDShapeRecognizerDestroy(r);
+  return 0;
+}
@@ -0,0 +1,263 @@
+//
+// PTDShapeRecognizerTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDShapeRecognizer.h"
+
+
+static const double _Pi = 3.14159265358979323846;
+
+
+/* Adds the points of a freehand stroke along the polyline, one every
+ * step points, moved randomly by up to the jitter in both directions */
+static void PTDAddPolyline(PTDShapeRecognizer *r, const double *v, size_t count, double step, double jitter, uint64_t *rng)
+{
+  for (size_t i = 0; i + 1 < count; i++) {
+    double dx = v[2*i+2] - v[2*i], dy = v[2*i+3] - v[2*i+1];
+    size_t n = (size_t)ceil(hypot(dx, dy) / step);
+    for (size_t j = (i == 0 ? 0 : 1); j <= n; j++) {
+      double t = (double)j / (double)n;
+      double ox = ((double)PTDTestRandomBelow(rng, 1001) / 500.0 - 1.0) * jitter;
+      double oy = ((double)PTDTestRandomBelow(rng, 1001) / 500.0 - 1.0) * jitter;
+      PTDShapeRecognizerAddPoint(r, v[2*i] + t * dx + ox, v[2*i+1] + t * dy + oy);
+    }
+  }
+}
+
+
+static void PTDAddEllipse(PTDShapeRecognizer *r, double cx, double cy, double rx, double ry, double rotation, double turns, size_t count, double jitter, uint64_t *rng)
+{
+  for (size_t i = 0; i <= count; i++) {
+    double t = 2.0 * _Pi * turns * (double)i / (double)count;
+    double x = rx * cos(t), y = ry * sin(t);
+    double ox = ((double)PTDTestRandomBelow(rng, 1001) / 500.0 - 1.0) * jitter;
+    double oy = ((double)PTDTestRandomBelow(rng, 1001) / 500.0 - 1.0) * jitter;
+    PTDShapeRecognizerAddPoint(r,
+        cx + x * cos(rotation) - y * sin(rotation) + ox,
+        cy + x * sin(rotation) + y * cos(rotation) + oy);
+  }
+}
+
+
+/* the vertices match in the same order, starting from any of them */
+static int PTDVerticesMatch(const PTDRecognizedShape *shape, const double *expected, size_t count, double tolerance)
+{
+  if (shape->vertexCount != count)
+    return 0;
+  for (size_t start = 0; start < count; start++) {
+    int ok = 1;
+    for (size_t i = 0; i < count && ok; i++) {
+      const double *v = shape->vertices + 2 * ((start + i) % count);
+      ok = hypot(v[0] - expected[2*i], v[1] - expected[2*i+1]) <= tolerance;
+    }
+    if (ok)
+      return 1;
+  }
+  return 0;
+}
+
+
+static void testLines(void)
+{
+  PTDShapeRecognizer *r = PTDShapeRecognizerCreate();
+  uint64_t rng = 1;
+  static const double lines[][4] = {{10, 20, 300, 40}, {0, 0, 0, -200}, {50, 50, -100, 180}, {0, 0, 30, 0}};
+  for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+    PTDShapeRecognizerReset(r);
+    PTDAddPolyline(r, lines[i], 2, 2.0, 1.5, &rng);
+    PTDRecognizedShape shape;
+    PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape));
+    PTD_CHECK(shape.kind == PTDRecognizedShapeKindLine);
+    PTD_CHECK(PTDVerticesMatch(&shape, lines[i], 2, 3.0));
+  }
+  
+  /* too short to be anything */
+  PTDShapeRecognizerReset(r);
+  static const double dash[] = {0, 0, 10, 0};
+  PTDAddPolyline(r, dash, 2, 1.0, 0.0, &rng);
+  PTDRecognizedShape shape;
+  PTD_CHECK(!PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindNone);
+  PTDShapeRecognizerDestroy(r);
+}
+
+
+static void testPolylines(void)
+{
+  PTDShapeRecognizer *r = PTDShapeRecognizerCreate();
+  uint64_t rng = 2;
+  static const double ell[] = {0, 0, 0, 200, 150, 200};
+  PTDAddPolyline(r, ell, 3, 2.0, 1.0, &rng);
+  PTDRecognizedShape shape;
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindPolyline);
+  PTD_CHECK(PTDVerticesMatch(&shape, ell, 3, 8.0));
+  
+  PTDShapeRecognizerReset(r);
+  static const double zigzag[] = {0, 0, 100, 100, 200, 0, 300, 100, 400, 0};
+  PTDAddPolyline(r, zigzag, 5, 2.0, 1.0, &rng);
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindPolyline);
+  PTD_CHECK(PTDVerticesMatch(&shape, zigzag, 5, 8.0));
+  PTDShapeRecognizerDestroy(r);
+}
+
+
+static void testPolygons(void)
+{
+  PTDShapeRecognizer *r = PTDShapeRecognizerCreate();
+  uint64_t rng = 3;
+  PTDRecognizedShape shape;
+  
+  static const double triangle[] = {0, 0, 200, 10, 90, 180, 0, 0};
+  PTDAddPolyline(r, triangle, 4, 2.0, 1.0, &rng);
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindPolygon);
+  PTD_CHECK(PTDVerticesMatch(&shape, triangle, 3, 8.0));
+  
+  /* a square rotated by 30 degrees stays a polygon */
+  double square[10];
+  for (int i = 0; i <= 4; i++) {
+    double a = _Pi / 6.0 + (double)(i % 4) * _Pi / 2.0;
+    square[2*i] = 100.0 + 120.0 * cos(a);
+    square[2*i+1] = 100.0 + 120.0 * sin(a);
+  }
+  PTDShapeRecognizerReset(r);
+  PTDAddPolyline(r, square, 5, 2.0, 1.0, &rng);
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindPolygon);
+  PTD_CHECK(PTDVerticesMatch(&shape, square, 4, 8.0));
+  
+  /* a rectangle drawn slightly crooked, starting in the middle of a side
+   * and overshooting its start, becomes an axis-aligned rectangle */
+  static const double crooked[] = {100, 2, 203, 0, 200, 104, 3, 100, 0, -3, 120, 3};
+  static const double rect[] = {1.5, 0, 201.5, 0, 201.5, 102, 1.5, 102};
+  PTDShapeRecognizerReset(r);
+  PTDAddPolyline(r, crooked, 6, 2.0, 1.0, &rng);
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindRectangle);
+  PTD_CHECK(PTDVerticesMatch(&shape, rect, 4, 8.0));
+  PTDShapeRecognizerDestroy(r);
+}
+
+
+static void testEllipses(void)
+{
+  PTDShapeRecognizer *r = PTDShapeRecognizerCreate();
+  uint64_t rng = 4;
+  PTDRecognizedShape shape;
+  
+  /* circles, also when they overshoot */
+  PTDAddEllipse(r, 300, 200, 80, 76, 0.0, 1.1, 300, 1.5, &rng);
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindEllipse);
+  PTD_CHECK(fabs(shape.centerX - 300) < 4 && fabs(shape.centerY - 200) < 4);
+  PTD_CHECK(shape.radiusX == shape.radiusY && fabs(shape.radiusX - 78) < 4);
+  
+  /* rotated ellipses */
+  static const double rotations[] = {0.7, -0.5, 1.2};
+  for (size_t i = 0; i < sizeof(rotations) / sizeof(rotations[0]); i++) {
+    PTDShapeRecognizerReset(r);
+    PTDAddEllipse(r, -50, 60, 150, 60, rotations[i], 1.0, 400, 1.0, &rng);
+    if (!PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindEllipse))
+      continue;
+    PTD_CHECK(fabs(shape.centerX + 50) < 4 && fabs(shape.centerY - 60) < 4);
+    double rotation = shape.rotation, rx = shape.radiusX, ry = shape.radiusY;
+    if (rx < ry) {
+      rotation += _Pi / 2.0;
+      rx = shape.radiusY;
+      ry = shape.radiusX;
+    }
+    double diff = fmod(fabs(rotation - rotations[i]), _Pi);
+    PTD_CHECK(fmin(diff, _Pi - diff) < 0.05);
+    PTD_CHECK(fabs(rx - 150) < 5 && fabs(ry - 60) < 5);
+  }
+  
+  /* nearly vertical ellipses are snapped to the axes */
+  PTDShapeRecognizerReset(r);
+  PTDAddEllipse(r, 0, 0, 40, 120, 0.1, 1.0, 300, 0.5, &rng);
+  PTD_CHECK(PTDShapeRecognizerRecognize(r, &shape) && shape.kind == PTDRecognizedShapeKindEllipse);
+  PTD_CHECK(shape.rotation == 0.0 && shape.radiusX < shape.radiusY);
+  PTDShapeRecognizerDestroy(r);
+}
+
+
+static void testScribbles(void)
+{
+  /* random walks and spirals are not shapes */
+  PTDShapeRecognizer *r = PTDShapeRecognizerCreate();
+  uint64_t rng = 5;
+  PTDRecognizedShape shape;
+  for (int i = 0; i < 10; i++) {
+    PTDShapeRecognizerReset(r);
+    double x = 0, y = 0, angle = 0;
+    for (int j = 0; j < 400; j++) {
+      angle += ((double)PTDTestRandomBelow(&rng, 1001) / 500.0 - 1.0) * 0.6;
+      x += 3.0 * cos(angle);
+      y += 3.0 * sin(angle);
+      PTDShapeRecognizerAddPoint(r, x, y);
+    }
+    PTD_CHECK(!PTDShapeRecognizerRecognize(r, &shape));
+  }
+  PTDShapeRecognizerReset(r);
+  for (int j = 0; j < 600; j++) {
+    double t = (double)j / 50.0;
+    PTDShapeRecognizerAddPoint(r, 10.0 * t * cos(t), 10.0 * t * sin(t));
+  }
+  PTD_CHECK(!PTDShapeRecognizerRecognize(r, &shape));
+  PTDShapeRecognizerDestroy(r);
+}
+
+
+static void testRecognizeWhileDrawing(void)
+{
+  /* recognizing in the middle of a stroke does not change the result at
+   * the end of it */
+  static const double triangle[] = {0, 0, 200, 10, 90, 180, 0, 0};
+  PTDShapeRecognizer *a = PTDShapeRecognizerCreate(), *b = PTDShapeRecognizerCreate();
+  PTDRecognizedShape shapeA, shapeB;
+  for (int i = 0; i <= 300; i++) {
+    int side = i < 300 ? i / 100 : 2;
+    double t = (double)(i - side * 100) / 100.0;
+    const double *v = triangle + 2 * side;
+    double x = v[0] + t * (v[2] - v[0]), y = v[1] + t * (v[3] - v[1]);
+    PTDShapeRecognizerAddPoint(a, x, y);
+    PTDShapeRecognizerAddPoint(b, x, y);
+    if (i % 37 == 0)
+      PTDShapeRecognizerRecognize(b, &shapeB);
+  }
+  PTD_CHECK(PTDShapeRecognizerRecognize(a, &shapeA) && PTDShapeRecognizerRecognize(b, &shapeB));
+  PTD_CHECK(shapeA.kind == PTDRecognizedShapeKindPolygon && shapeA.kind == shapeB.kind && shapeA.vertexCount == shapeB.vertexCount);
+  PTD_CHECK(memcmp(shapeA.vertices, shapeB.vertices, shapeA.vertexCount * 2 * sizeof(double)) == 0);
+  PTDShapeRecognizerDestroy(a);
+  PTDShapeRecognizerDestroy(b);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testLines);
+  PTD_RUN(testPolylines);
+  PTD_RUN(testPolygons);
+  PTD_RUN(testEllipses);
+  PTD_RUN(testScribbles);
+  PTD_RUN(testRecognizeWhileDrawing);
+  return PTDTestFinish();
+}
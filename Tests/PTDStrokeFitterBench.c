@@ -0,0 +1,107 @@
+//
+// PTDStrokeFitterBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDStrokeFitter.h"
+
+
+static const double _Pi = 3.14159265358979323846;
+
+
+static size_t PTDBenchSpiral(double *points, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    double t = (double)i / (double)(count - 1);
+    double a = 2.0 * _Pi * 10.0 * t, r = 40.0 + 400.0 * t;
+    points[2*i] = r * cos(a);
+    points[2*i+1] = r * sin(a);
+  }
+  return count;
+}
+
+
+static size_t PTDBenchZigzag(double *points, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    double x = (double)(i % 200);
+    points[2*i] = (double)(i / 200) * 5.0 + (x < 100 ? x : 200 - x);
+    points[2*i+1] = (double)i * 0.5;
+  }
+  return count;
+}
+
+
+static size_t PTDBenchScribble(double *points, size_t count)
+{
+  uint64_t rng = 9;
+  double x = 0, y = 0, angle = 0;
+  for (size_t i = 0; i < count; i++) {
+    angle += ((double)PTDTestRandomBelow(&rng, 1001) / 500.0 - 1.0) * 0.3;
+    x += 1.5 * cos(angle);
+    y += 1.5 * sin(angle);
+    points[2*i] = x;
+    points[2*i+1] = y;
+  }
+  return count;
+}
+
+
+static void PTDBenchFitStroke(PTDStrokeFitter *f, const double *points, size_t count)
+{
+  PTDStrokeFitterReset(f);
+  for (size_t i = 0; i < count; i++)
+    PTDStrokeFitterAddPoint(f, points[2*i], points[2*i+1]);
+  PTDStrokeFitterFinish(f);
+}
+
+
+int main(void)
+{
+  static const struct {
+    const char *name;
+    size_t (*generate)(double *, size_t);
+  } strokes[] = {{"spiral", PTDBenchSpiral}, {"zigzag", PTDBenchZigzag}, {"scribble", PTDBenchScribble}};
+  static const size_t counts[] = {1000, 10000, 100000};
+  PTDStrokeFitter *f = PTDStrokeFitterCreate(0.5);
+  double *points = malloc(100000 * 2 * sizeof(double));
+  
+  for (size_t s = 0; s < sizeof(strokes) / sizeof(strokes[0]); s++) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+      size_t count = strokes[s].generate(points, counts[c]);
+      char name[80];
+      snprintf(name, sizeof(name), "%s, %zu points", strokes[s].name, count);
+      PTD_BENCH(name, 0.3, PTDBenchFitStroke(f, points, count));
+      size_t curveCount;
+      PTDStrokeFitterCurves(f, &curveCount);
+      printf("  %zu curves\n", curveCount);
+    }
+  }
+  
+  free(points);
+  PTDStrokeFitterDestroy(f);
+  return 0;
+}
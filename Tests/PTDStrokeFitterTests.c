@@ -0,0 +1,376 @@
+//
+// PTDStrokeFitterTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <math.h>
+#include "PTDTest.h"
+#include "PTDStrokeFitter.h"
+
+
+static const double _Pi = 3.14159265358979323846;
+static const double _Tolerance = 0.5;
+/* The polyline is within the tolerance from the points, and the curves
+ * are within the tolerance from the polyline */
+static const double _ErrorBound = 2.0 * _Tolerance;
+#define CURVE_STEPS 48
+
+
+static double PTDJitter(uint64_t *rng, double jitter)
+{
+  return ((double)PTDTestRandomBelow(rng, 1001) / 500.0 - 1.0) * jitter;
+}
+
+
+static size_t PTDPolylineStroke(double *points, const double *v, size_t count, double step, double jitter, uint64_t *rng)
+{
+  size_t n = 0;
+  for (size_t i = 0; i + 1 < count; i++) {
+    double dx = v[2*i+2] - v[2*i], dy = v[2*i+3] - v[2*i+1];
+    size_t steps = (size_t)ceil(hypot(dx, dy) / step);
+    for (size_t j = (i == 0 ? 0 : 1); j <= steps; j++) {
+      double t = (double)j / (double)steps;
+      points[2*n] = v[2*i] + t * dx + PTDJitter(rng, jitter);
+      points[2*n+1] = v[2*i+1] + t * dy + PTDJitter(rng, jitter);
+      n++;
+    }
+  }
+  return n;
+}
+
+
+static size_t PTDSpiralStroke(double *points, size_t count, double turns, double jitter, uint64_t *rng)
+{
+  for (size_t i = 0; i < count; i++) {
+    double t = (double)i / (double)(count - 1);
+    double a = 2.0 * _Pi * turns * t, r = 40.0 + 160.0 * t;
+    points[2*i] = r * cos(a) + PTDJitter(rng, jitter);
+    points[2*i+1] = r * sin(a) + PTDJitter(rng, jitter);
+  }
+  return count;
+}
+
+
+static size_t PTDScribbleStroke(double *points, size_t count, uint64_t *rng)
+{
+  double x = 0, y = 0, angle = 0;
+  for (size_t i = 0; i < count; i++) {
+    angle += PTDJitter(rng, 0.4);
+    x += 1.5 * cos(angle);
+    y += 1.5 * sin(angle);
+    points[2*i] = x;
+    points[2*i+1] = y;
+  }
+  return count;
+}
+
+
+static PTDStrokeFitter *PTDFitStroke(const double *points, size_t count)
+{
+  PTDStrokeFitter *f = PTDStrokeFitterCreate(_Tolerance);
+  for (size_t i = 0; i < count; i++)
+    PTDStrokeFitterAddPoint(f, points[2*i], points[2*i+1]);
+  PTDStrokeFitterFinish(f);
+  return f;
+}
+
+
+static double PTDSegmentDistance(double px, double py, double ax, double ay, double bx, double by)
+{
+  double dx = bx - ax, dy = by - ay;
+  double len2 = dx * dx + dy * dy;
+  double t = len2 > 0.0 ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0.0;
+  t = fmin(fmax(t, 0.0), 1.0);
+  return hypot(px - (ax + t * dx), py - (ay + t * dy));
+}
+
+
+/* Flattens the curves into a polyline much finer than the tolerance */
+static double *PTDFlattenCurves(const double *curves, size_t curveCount, size_t *count)
+{
+  double *flat = malloc((curveCount * CURVE_STEPS + 1) * 2 * sizeof(double));
+  flat[0] = curves[0];
+  flat[1] = curves[1];
+  size_t n = 1;
+  for (size_t i = 0; i < curveCount; i++) {
+    const double *c = curves + 6 * i;
+    for (int j = 1; j <= CURVE_STEPS; j++) {
+      double t = (double)j / CURVE_STEPS, s = 1.0 - t;
+      double b0 = s * s * s, b1 = 3.0 * s * s * t, b2 = 3.0 * s * t * t, b3 = t * t * t;
+      flat[2*n] = b0 * c[0] + b1 * c[2] + b2 * c[4] + b3 * c[6];
+      flat[2*n+1] = b0 * c[1] + b1 * c[3] + b2 * c[5] + b3 * c[7];
+      n++;
+    }
+  }
+  *count = n;
+  return flat;
+}
+
+
+/* Largest distance from the points to the curves */
+static double PTDMaxError(PTDStrokeFitter *f, const double *points, size_t count)
+{
+  size_t curveCount, flatCount;
+  const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+  if (!curves)
+    return INFINITY;
+  double *flat = PTDFlattenCurves(curves, curveCount, &flatCount);
+  double maxError = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    double best = INFINITY;
+    for (size_t j = 0; j + 1 < flatCount; j++)
+      best = fmin(best, PTDSegmentDistance(points[2*i], points[2*i+1], flat[2*j], flat[2*j+1], flat[2*j+2], flat[2*j+3]));
+    maxError = fmax(maxError, best);
+  }
+  free(flat);
+  return maxError;
+}
+
+
+static void PTDCheckErrorBound(const double *points, size_t count)
+{
+  PTDStrokeFitter *f = PTDFitStroke(points, count);
+  size_t curveCount, pendingCount;
+  const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+  PTDStrokeFitterPendingPoints(f, &pendingCount);
+  if (PTD_CHECK(curves != NULL)) {
+    /* the curves span the whole stroke */
+    PTD_CHECK(curves[0] == points[0] && curves[1] == points[1]);
+    PTD_CHECK(curves[6*curveCount] == points[2*count-2] && curves[6*curveCount+1] == points[2*count-1]);
+    PTD_CHECK(pendingCount == 1);
+  }
+  double error = PTDMaxError(f, points, count);
+  if (!PTD_CHECK(error <= _ErrorBound))
+    fprintf(stderr, "  max error %g, %zu points, %zu curves\n", error, count, curveCount);
+  PTDStrokeFitterDestroy(f);
+}
+
+
+static void testStraightLines(void)
+{
+  double *points = malloc(4000 * 2 * sizeof(double));
+  uint64_t rng = 1;
+  static const double lines[][4] = {{0, 0, 500, 0}, {10, 20, 300, 240}, {0, 0, -3, 800}};
+  for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+    size_t count = PTDPolylineStroke(points, lines[i], 2, 1.0, 0.0, &rng);
+    PTDCheckErrorBound(points, count);
+    
+    /* a line without noise needs very few curves */
+    PTDStrokeFitter *f = PTDFitStroke(points, count);
+    size_t curveCount;
+    PTDStrokeFitterCurves(f, &curveCount);
+    PTD_CHECK(curveCount <= 2);
+    PTDStrokeFitterDestroy(f);
+    
+    count = PTDPolylineStroke(points, lines[i], 2, 1.0, 0.4, &rng);
+    PTDCheckErrorBound(points, count);
+  }
+  free(points);
+}
+
+
+static void testCurves(void)
+{
+  double *points = malloc(4000 * 2 * sizeof(double));
+  uint64_t rng = 2;
+  PTDCheckErrorBound(points, PTDSpiralStroke(points, 2000, 3.0, 0.0, &rng));
+  PTDCheckErrorBound(points, PTDSpiralStroke(points, 2000, 3.0, 0.5, &rng));
+  /* points far apart, as when the mouse moves fast */
+  PTDCheckErrorBound(points, PTDSpiralStroke(points, 120, 1.0, 0.0, &rng));
+  PTDCheckErrorBound(points, PTDScribbleStroke(points, 3000, &rng));
+  
+  /* the curves are smooth along a spiral: the tangents at their joints
+   * are aligned */
+  size_t count = PTDSpiralStroke(points, 2000, 3.0, 0.0, &rng);
+  PTDStrokeFitter *f = PTDFitStroke(points, count);
+  size_t curveCount;
+  const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+  PTD_CHECK(curveCount > 1 && curveCount < 200);
+  double worst = 1.0;
+  for (size_t i = 1; i < curveCount; i++) {
+    const double *c = curves + 6 * i;
+    double ix = c[0] - c[-2], iy = c[1] - c[-1], ox = c[2] - c[0], oy = c[3] - c[1];
+    double li = hypot(ix, iy), lo = hypot(ox, oy);
+    if (li > 0.0 && lo > 0.0)
+      worst = fmin(worst, (ix * ox + iy * oy) / (li * lo));
+  }
+  PTD_CHECK(worst > 0.99);
+  PTDStrokeFitterDestroy(f);
+  free(points);
+}
+
+
+static void testCorners(void)
+{
+  double *points = malloc(4000 * 2 * sizeof(double));
+  uint64_t rng = 3;
+  static const double zigzag[] = {0, 0, 100, 100, 200, 0, 300, 100, 400, 0, 400, 200, 0, 200};
+  size_t count = PTDPolylineStroke(points, zigzag, 7, 1.0, 0.0, &rng);
+  PTDCheckErrorBound(points, count);
+  
+  /* the corners are kept sharp: a curve ends at each one */
+  PTDStrokeFitter *f = PTDFitStroke(points, count);
+  size_t curveCount;
+  const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+  for (size_t i = 1; i < 6; i++) {
+    double best = INFINITY;
+    for (size_t j = 0; j <= curveCount; j++)
+      best = fmin(best, hypot(curves[6*j] - zigzag[2*i], curves[6*j+1] - zigzag[2*i+1]));
+    PTD_CHECK(best <= _Tolerance);
+  }
+  PTDStrokeFitterDestroy(f);
+  
+  count = PTDPolylineStroke(points, zigzag, 7, 1.0, 0.5, &rng);
+  PTDCheckErrorBound(points, count);
+  
+  /* strokes turning back on themselves */
+  static const double back[] = {0, 0, 200, 0, 20, 1, 180, 2};
+  count = PTDPolylineStroke(points, back, 4, 1.0, 0.0, &rng);
+  PTDCheckErrorBound(points, count);
+  free(points);
+}
+
+
+static void testDegenerateStrokes(void)
+{
+  PTDStrokeFitter *f = PTDStrokeFitterCreate(_Tolerance);
+  size_t curveCount, pendingCount;
+  
+  /* a click is a single point, which is pending */
+  PTD_CHECK(PTDStrokeFitterAddPoint(f, 10, 10));
+  PTD_CHECK(PTDStrokeFitterFinish(f));
+  PTD_CHECK(PTDStrokeFitterCurves(f, &curveCount) == NULL && curveCount == 0);
+  const double *pending = PTDStrokeFitterPendingPoints(f, &pendingCount);
+  PTD_CHECK(pendingCount == 1 && pending[0] == 10 && pending[1] == 10);
+  PTD_CHECK(!PTDStrokeFitterAddPoint(f, 20, 20));
+  
+  /* the same point repeated */
+  PTDStrokeFitterReset(f);
+  for (int i = 0; i < 100; i++)
+    PTD_CHECK(PTDStrokeFitterAddPoint(f, 5, 5));
+  PTD_CHECK(PTDStrokeFitterFinish(f));
+  PTDStrokeFitterCurves(f, &curveCount);
+  PTD_CHECK(curveCount == 0);
+  
+  /* two points make a single straight curve */
+  PTDStrokeFitterReset(f);
+  PTDStrokeFitterAddPoint(f, 0, 0);
+  PTDStrokeFitterAddPoint(f, 30, 40);
+  PTD_CHECK(PTDStrokeFitterFinish(f));
+  const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+  PTD_CHECK(curveCount == 1 && curves[6] == 30 && curves[7] == 40);
+  PTD_CHECK(fabs(curves[2] * 40 - curves[3] * 30) < 1e-9 && fabs(curves[4] * 40 - curves[5] * 30) < 1e-9);
+  PTDStrokeFitterDestroy(f);
+}
+
+
+static void testCurvesAreAppended(void)
+{
+  /* the curves returned while the stroke is drawn are never changed, so
+   * that they can be drawn only once */
+  double *points = malloc(4000 * 2 * sizeof(double));
+  uint64_t rng = 4;
+  size_t count = PTDScribbleStroke(points, 3000, &rng);
+  PTDStrokeFitter *f = PTDStrokeFitterCreate(_Tolerance);
+  double *seen = malloc(count * 6 * sizeof(double) + 2 * sizeof(double));
+  size_t seenCount = 0;
+  int unchanged = 1, pendingContinues = 1;
+  for (size_t i = 0; i < count; i++) {
+    PTDStrokeFitterAddPoint(f, points[2*i], points[2*i+1]);
+    size_t curveCount, pendingCount;
+    const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+    const double *pending = PTDStrokeFitterPendingPoints(f, &pendingCount);
+    if (curveCount < seenCount || (seenCount > 0 && memcmp(curves, seen, (seenCount * 6 + 2) * sizeof(double)) != 0))
+      unchanged = 0;
+    if (curves) {
+      memcpy(seen, curves, (curveCount * 6 + 2) * sizeof(double));
+      seenCount = curveCount;
+      pendingContinues &= pending[0] == curves[6*curveCount] && pending[1] == curves[6*curveCount+1];
+    }
+    /* the pending points always end at the last point added */
+    pendingContinues &= pending[2*pendingCount-2] == points[2*i] && pending[2*pendingCount-1] == points[2*i+1];
+  }
+  PTD_CHECK(unchanged);
+  PTD_CHECK(pendingContinues);
+  PTD_CHECK(seenCount > 10);
+  
+  /* finishing only appends, too */
+  PTDStrokeFitterFinish(f);
+  size_t curveCount;
+  const double *curves = PTDStrokeFitterCurves(f, &curveCount);
+  PTD_CHECK(curveCount >= seenCount && memcmp(curves, seen, (seenCount * 6 + 2) * sizeof(double)) == 0);
+  
+  /* the work per point stays bounded: few points are ever pending */
+  PTDStrokeFitterReset(f);
+  size_t maxPending = 0;
+  for (size_t i = 0; i < count; i++) {
+    PTDStrokeFitterAddPoint(f, points[2*i], points[2*i+1]);
+    size_t pendingCount;
+    PTDStrokeFitterPendingPoints(f, &pendingCount);
+    maxPending = pendingCount > maxPending ? pendingCount : maxPending;
+  }
+  PTD_CHECK(maxPending <= 34);
+  
+  free(seen);
+  free(points);
+  PTDStrokeFitterDestroy(f);
+}
+
+
+static void testReset(void)
+{
+  double *points = malloc(4000 * 2 * sizeof(double));
+  uint64_t rng = 5;
+  size_t count = PTDSpiralStroke(points, 1500, 2.0, 0.5, &rng);
+  PTDStrokeFitter *a = PTDFitStroke(points, count);
+  
+  /* a fitter used before and reset gives the same curves as a new one */
+  PTDStrokeFitter *b = PTDStrokeFitterCreate(_Tolerance);
+  for (size_t i = 0; i < 200; i++)
+    PTDStrokeFitterAddPoint(b, points[2*i+1], points[2*i]);
+  PTDStrokeFitterReset(b);
+  for (size_t i = 0; i < count; i++)
+    PTDStrokeFitterAddPoint(b, points[2*i], points[2*i+1]);
+  PTDStrokeFitterFinish(b);
+  
+  size_t countA, countB;
+  const double *curvesA = PTDStrokeFitterCurves(a, &countA);
+  const double *curvesB = PTDStrokeFitterCurves(b, &countB);
+  PTD_CHECK(countA == countB && memcmp(curvesA, curvesB, (countA * 6 + 2) * sizeof(double)) == 0);
+  PTDStrokeFitterDestroy(a);
+  PTDStrokeFitterDestroy(b);
+  free(points);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testStraightLines);
+  PTD_RUN(testCurves);
+  PTD_RUN(testCorners);
+  PTD_RUN(testDegenerateStrokes);
+  PTD_RUN(testCurvesAreAppended);
+  PTD_RUN(testReset);
+  return PTDTestFinish();
+}
@@ -0,0 +1,166 @@
+//
+// PTDTaskSchedulerBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdatomic.h>
+#include <sched.h>
+#include "PTDTest.h"
+#include "PTDTaskScheduler.h"
+
+
+static _Atomic size_t _Finished;
+
+
+static void PTDBenchCount(PTDTask *task, void *context)
+{
+  (void)task;
+  (void)context;
+  atomic_fetch_add(&_Finished, 1);
+}
+
+
+static void PTDBenchWaitForCount(size_t count)
+{
+  while (atomic_load(&_Finished) < count)
+    sched_yield();
+}
+
+
+static void PTDBenchSubmit(PTDTaskScheduler *scheduler, PTDTaskSerialQueue *queue, size_t count)
+{
+  atomic_store(&_Finished, 0);
+  for (size_t i = 0; i < count; i++) {
+    PTDTask *task = PTDTaskCreate((PTDTaskPriority)(i % PTDTaskPriorityCount), PTDBenchCount, NULL);
+    if (queue)
+      PTDTaskSetSerialQueue(task, queue);
+    PTDTaskSchedulerSubmit(scheduler, task);
+    PTDTaskRelease(task);
+  }
+  PTDBenchWaitForCount(count);
+}
+
+
+static void PTDBenchRoundTrip(PTDTaskScheduler *scheduler, bool inlineWait)
+{
+  atomic_store(&_Finished, 0);
+  PTDTask *task = PTDTaskCreate(PTDTaskPriorityInteractive, PTDBenchCount, NULL);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  if (inlineWait)
+    PTDTaskWait(task);
+  else
+    PTDBenchWaitForCount(1);
+  PTDTaskRelease(task);
+}
+
+
+typedef struct {
+  PTDTaskScheduler *scheduler;
+  _Atomic bool stop;
+} PTDBenchLoad;
+
+
+/* a background task of about 5 ms, which submits the next one */
+static void PTDBenchBusy(PTDTask *task, void *context)
+{
+  PTDBenchLoad *load = context;
+  double start = PTDTestNow();
+  while (PTDTestNow() - start < 0.005)
+    ;
+  if (!atomic_load(&load->stop) && !PTDTaskIsCancelled(task)) {
+    PTDTask *next = PTDTaskCreate(PTDTaskPriorityEncode, PTDBenchBusy, load);
+    PTDTaskSchedulerSubmit(load->scheduler, next);
+    PTDTaskRelease(next);
+  }
+}
+
+
+typedef struct {
+  double submittedAt;
+  _Atomic double startedAt;
+} PTDBenchLatency;
+
+
+static void PTDBenchStart(PTDTask *task, void *context)
+{
+  (void)task;
+  PTDBenchLatency *latency = context;
+  atomic_store(&latency->startedAt, PTDTestNow());
+}
+
+
+/* How long an interactive task waits to start on a worker while all the
+ * others are busy with background tasks. */
+static void PTDBenchInteractiveLatency(size_t workers)
+{
+  enum { SAMPLES = 200 };
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(workers);
+  PTDBenchLoad load = {scheduler, false};
+  /* more than the workers, so that the background queue is never empty */
+  for (size_t i = 0; i < workers * 2; i++) {
+    PTDTask *task = PTDTaskCreate(PTDTaskPriorityEncode, PTDBenchBusy, &load);
+    PTDTaskSchedulerSubmit(scheduler, task);
+    PTDTaskRelease(task);
+  }
+  
+  double total = 0.0, worst = 0.0;
+  for (int i = 0; i < SAMPLES; i++) {
+    PTDBenchLatency latency = {PTDTestNow(), 0.0};
+    PTDTask *task = PTDTaskCreate(PTDTaskPriorityInteractive, PTDBenchStart, &latency);
+    PTDTaskSchedulerSubmit(scheduler, task);
+    while (atomic_load(&latency.startedAt) == 0.0)
+      sched_yield();
+    PTDTaskRelease(task);
+    double wait = atomic_load(&latency.startedAt) - latency.submittedAt;
+    total += wait;
+    if (wait > worst)
+      worst = wait;
+    /* lets the background tasks take over again */
+    double pause = PTDTestNow();
+    while (PTDTestNow() - pause < 0.001)
+      sched_yield();
+  }
+  atomic_store(&load.stop, true);
+  PTDTaskSchedulerDestroy(scheduler);
+  
+  char name[64];
+  snprintf(name, sizeof(name), "interactive task start, %zu busy workers", workers - 1);
+  printf("%-48s %10.3f ms average, %.3f ms worst\n", name, total * 1000.0 / SAMPLES, worst * 1000.0);
+}
+
+
+int main(void)
+{
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(4);
+  PTD_BENCH("submit and run 100000 empty tasks", 0.5, PTDBenchSubmit(scheduler, NULL, 100000));
+  PTDTaskSerialQueue *queue = PTDTaskSerialQueueCreate();
+  PTD_BENCH("same, all on one serial queue", 0.5, PTDBenchSubmit(scheduler, queue, 100000));
+  PTDTaskSerialQueueRelease(queue);
+  PTD_BENCH("submit one task and wait for a worker", 0.5, PTDBenchRoundTrip(scheduler, false));
+  PTD_BENCH("submit one task and run it inline", 0.5, PTDBenchRoundTrip(scheduler, true));
+  PTDTaskSchedulerDestroy(scheduler);
+  
+  PTDBenchInteractiveLatency(2);
+  PTDBenchInteractiveLatency(4);
+  return 0;
+}
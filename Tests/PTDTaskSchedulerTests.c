@@ -0,0 +1,565 @@
+//
+// PTDTaskSchedulerTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "PTDTest.h"
+#include "PTDTaskScheduler.h"
+
+
+/* how many tasks the scheduler takes before one which was passed over */
+static const size_t _StarvationLimit = 16;
+static const double _Timeout = 10.0;
+
+
+typedef struct {
+  pthread_mutex_t lock;
+  int log[1024];
+  size_t count;
+} PTDTestOrder;
+
+typedef struct {
+  PTDTestOrder *order;
+  int value;
+  _Atomic int calls;
+  _Atomic int sawCancel;
+  pthread_t thread;
+} PTDTestTask;
+
+
+static void PTDTestOrderInit(PTDTestOrder *order)
+{
+  pthread_mutex_init(&order->lock, NULL);
+  order->count = 0;
+}
+
+
+static void PTDTestOrderAppend(PTDTestOrder *order, int value)
+{
+  pthread_mutex_lock(&order->lock);
+  if (order->count < sizeof(order->log) / sizeof(order->log[0]))
+    order->log[order->count++] = value;
+  pthread_mutex_unlock(&order->lock);
+}
+
+
+static size_t PTDTestOrderCount(PTDTestOrder *order)
+{
+  pthread_mutex_lock(&order->lock);
+  size_t count = order->count;
+  pthread_mutex_unlock(&order->lock);
+  return count;
+}
+
+
+static void PTDTestRecord(PTDTask *task, void *context)
+{
+  PTDTestTask *t = context;
+  t->thread = pthread_self();
+  atomic_store(&t->sawCancel, PTDTaskIsCancelled(task));
+  if (t->order)
+    PTDTestOrderAppend(t->order, t->value);
+  atomic_fetch_add(&t->calls, 1);
+}
+
+
+/* Keeps the only background slot busy until released, so that the tasks
+ * submitted in the meantime pile up. */
+typedef struct {
+  _Atomic int started;
+  _Atomic int released;
+  _Atomic int finished;
+  /* if set, also released when this task is cancelled */
+  PTDTask *releasedByCancelOf;
+} PTDTestGate;
+
+
+static void PTDTestGateRun(PTDTask *task, void *context)
+{
+  (void)task;
+  PTDTestGate *gate = context;
+  atomic_store(&gate->started, 1);
+  double start = PTDTestNow();
+  while (!atomic_load(&gate->released) && PTDTestNow() - start < _Timeout) {
+    if (gate->releasedByCancelOf && PTDTaskIsCancelled(gate->releasedByCancelOf))
+      break;
+    sched_yield();
+  }
+  atomic_store(&gate->finished, 1);
+}
+
+
+static PTDTask *PTDTestGateSubmit(PTDTaskScheduler *scheduler, PTDTestGate *gate)
+{
+  PTDTask *task = PTDTaskCreate(PTDTaskPriorityPrefetch, PTDTestGateRun, gate);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  double start = PTDTestNow();
+  while (!atomic_load(&gate->started) && PTDTestNow() - start < _Timeout)
+    sched_yield();
+  return task;
+}
+
+
+static bool PTDTestWaitForCalls(_Atomic int *calls, int expected)
+{
+  double start = PTDTestNow();
+  while (atomic_load(calls) < expected) {
+    if (PTDTestNow() - start > _Timeout)
+      return false;
+    sched_yield();
+  }
+  return true;
+}
+
+
+static void PTDTestSubmit(PTDTaskScheduler *scheduler, PTDTaskPriority priority, PTDTestTask *t)
+{
+  PTDTask *task = PTDTaskCreate(priority, PTDTestRecord, t);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  PTDTaskRelease(task);
+}
+
+
+static void testPriorityOrder(void)
+{
+  /* two workers: one background task at a time, plus interactive ones */
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(2);
+  PTDTestOrder order;
+  PTDTestOrderInit(&order);
+  PTDTestGate gate = {0};
+  PTDTask *gateTask = PTDTestGateSubmit(scheduler, &gate);
+  
+  /* fewer than the starvation limit, submitted from the least urgent */
+  static const PTDTaskPriority priorities[] = {
+    PTDTaskPriorityAutosave, PTDTaskPriorityEncode, PTDTaskPriorityPrefetch,
+    PTDTaskPriorityAutosave, PTDTaskPriorityEncode, PTDTaskPriorityPrefetch,
+    PTDTaskPriorityAutosave, PTDTaskPriorityEncode, PTDTaskPriorityPrefetch};
+  enum { COUNT = sizeof(priorities) / sizeof(priorities[0]) };
+  PTDTestTask tasks[COUNT] = {{0}};
+  for (int i = 0; i < COUNT; i++) {
+    tasks[i].order = &order;
+    tasks[i].value = i;
+    PTDTestSubmit(scheduler, priorities[i], &tasks[i]);
+  }
+  
+  /* interactive tasks do not wait for the background ones */
+  PTDTestTask interactive = {0};
+  PTDTestSubmit(scheduler, PTDTaskPriorityInteractive, &interactive);
+  PTD_CHECK(PTDTestWaitForCalls(&interactive.calls, 1));
+  PTD_CHECK(PTDTestOrderCount(&order) == 0);
+  
+  atomic_store(&gate.released, 1);
+  PTDTaskWait(gateTask);
+  PTDTaskRelease(gateTask);
+  for (int i = 0; i < COUNT; i++)
+    PTD_CHECK(PTDTestWaitForCalls(&tasks[i].calls, 1));
+  
+  /* by class, and in submission order within each class */
+  static const int expected[COUNT] = {2, 5, 8, 1, 4, 7, 0, 3, 6};
+  PTD_CHECK(order.count == COUNT);
+  PTD_CHECK(memcmp(order.log, expected, sizeof(expected)) == 0);
+  PTDTaskSchedulerDestroy(scheduler);
+}
+
+
+typedef struct {
+  PTDTaskScheduler *scheduler;
+  PTDTestOrder *order;
+  _Atomic int remaining;
+  _Atomic int finished;
+} PTDTestFlood;
+
+
+static void PTDTestFloodRun(PTDTask *task, void *context)
+{
+  (void)task;
+  PTDTestFlood *flood = context;
+  PTDTestOrderAppend(flood->order, 0);
+  /* keeps a few urgent tasks pending, all the time */
+  if (atomic_fetch_sub(&flood->remaining, 1) > 0) {
+    PTDTask *next = PTDTaskCreate(PTDTaskPriorityPrefetch, PTDTestFloodRun, flood);
+    PTDTaskSchedulerSubmit(flood->scheduler, next);
+    PTDTaskRelease(next);
+  }
+  atomic_fetch_add(&flood->finished, 1);
+}
+
+
+static void testStarvationLimit(void)
+{
+  enum { FLOOD = 200, INITIAL = 4 };
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(2);
+  PTDTestOrder order;
+  PTDTestOrderInit(&order);
+  PTDTestGate gate = {0};
+  PTDTask *gateTask = PTDTestGateSubmit(scheduler, &gate);
+  
+  PTDTestTask autosave = {0};
+  autosave.order = &order;
+  autosave.value = 1;
+  PTDTestSubmit(scheduler, PTDTaskPriorityAutosave, &autosave);
+  PTDTestFlood flood = {0};
+  flood.scheduler = scheduler;
+  flood.order = &order;
+  atomic_init(&flood.remaining, FLOOD - INITIAL);
+  for (int i = 0; i < INITIAL; i++) {
+    PTDTask *task = PTDTaskCreate(PTDTaskPriorityPrefetch, PTDTestFloodRun, &flood);
+    PTDTaskSchedulerSubmit(scheduler, task);
+    PTDTaskRelease(task);
+  }
+  
+  atomic_store(&gate.released, 1);
+  PTDTaskWait(gateTask);
+  PTDTaskRelease(gateTask);
+  PTD_CHECK(PTDTestWaitForCalls(&flood.finished, FLOOD));
+  PTD_CHECK(PTDTestWaitForCalls(&autosave.calls, 1));
+  
+  /* the autosave task ran while urgent tasks were still pending, but only
+   * after they were preferred to it for a while */
+  size_t before = 0;
+  while (before < order.count && order.log[before] == 0)
+    before++;
+  PTD_CHECK(before >= _StarvationLimit);
+  PTD_CHECK(before <= 2 * _StarvationLimit);
+  PTD_CHECK(order.count == FLOOD + 1);
+  PTDTaskSchedulerDestroy(scheduler);
+}
+
+
+static void PTDTestRunUntilCancelled(PTDTask *task, void *context)
+{
+  PTDTestTask *t = context;
+  atomic_store(&t->sawCancel, 0);
+  atomic_fetch_add(&t->calls, 1);
+  double start = PTDTestNow();
+  while (!PTDTaskIsCancelled(task) && PTDTestNow() - start < _Timeout)
+    sched_yield();
+  atomic_store(&t->sawCancel, PTDTaskIsCancelled(task));
+}
+
+
+static void testCancellation(void)
+{
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(2);
+  
+  /* a pending task is still called, so that it can dispose of its context */
+  PTDTestGate gate = {0};
+  PTDTask *gateTask = PTDTestGateSubmit(scheduler, &gate);
+  PTDTestTask pending = {0};
+  PTDTask *task = PTDTaskCreate(PTDTaskPriorityEncode, PTDTestRecord, &pending);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  PTDTaskCancel(task);
+  PTD_CHECK(PTDTaskIsCancelled(task));
+  atomic_store(&gate.released, 1);
+  PTDTaskWait(task);
+  PTD_CHECK(atomic_load(&pending.calls) == 1);
+  PTD_CHECK(atomic_load(&pending.sawCancel));
+  PTDTaskRelease(task);
+  PTDTaskWait(gateTask);
+  PTDTaskRelease(gateTask);
+  
+  /* a running task sees the cancellation and stops early */
+  PTDTestTask running = {0};
+  task = PTDTaskCreate(PTDTaskPriorityEncode, PTDTestRunUntilCancelled, &running);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  PTD_CHECK(PTDTestWaitForCalls(&running.calls, 1));
+  double start = PTDTestNow();
+  PTDTaskCancel(task);
+  PTDTaskWait(task);
+  PTD_CHECK(PTDTestNow() - start < _Timeout / 2);
+  PTD_CHECK(atomic_load(&running.sawCancel));
+  PTDTaskRelease(task);
+  PTDTaskSchedulerDestroy(scheduler);
+  
+  /* destroying the scheduler cancels all the pending tasks, and runs each
+   * of them exactly once */
+  enum { COUNT = 100 };
+  scheduler = PTDTaskSchedulerCreate(2);
+  PTDTestTask tasks[COUNT] = {{0}};
+  PTDTask *last = PTDTaskCreate(PTDTaskPriorityAutosave, PTDTestRecord, &tasks[COUNT - 1]);
+  PTDTestGate destroyGate = {0};
+  destroyGate.releasedByCancelOf = last;
+  gateTask = PTDTestGateSubmit(scheduler, &destroyGate);
+  for (int i = 0; i < COUNT - 1; i++)
+    PTDTestSubmit(scheduler, PTDTaskPriorityAutosave, &tasks[i]);
+  PTDTaskSchedulerSubmit(scheduler, last);
+  PTDTaskSchedulerDestroy(scheduler);
+  int once = 1, cancelled = 1;
+  for (int i = 0; i < COUNT; i++) {
+    once &= atomic_load(&tasks[i].calls) == 1;
+    cancelled &= atomic_load(&tasks[i].sawCancel);
+  }
+  PTD_CHECK(once);
+  PTD_CHECK(cancelled);
+  PTD_CHECK(!atomic_load(&destroyGate.released));
+  PTDTaskRelease(last);
+  PTDTaskRelease(gateTask);
+}
+
+
+static void *PTDTestReleaseLater(void *arg)
+{
+  PTDTestGate *gate = arg;
+  struct timespec delay = {0, 20 * 1000 * 1000};
+  nanosleep(&delay, NULL);
+  atomic_store(&gate->released, 1);
+  return NULL;
+}
+
+
+typedef struct {
+  PTDTestGate *before;
+  _Atomic int calls;
+  _Atomic int ranAfter;
+} PTDTestFollower;
+
+
+static void PTDTestFollowerRun(PTDTask *task, void *context)
+{
+  (void)task;
+  PTDTestFollower *f = context;
+  atomic_store(&f->ranAfter, atomic_load(&f->before->finished));
+  atomic_fetch_add(&f->calls, 1);
+}
+
+
+static void testInlineWait(void)
+{
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(2);
+  
+  /* nothing to wait for */
+  PTDTestTask unsubmitted = {0};
+  PTDTask *task = PTDTaskCreate(PTDTaskPriorityEncode, PTDTestRecord, &unsubmitted);
+  PTDTaskWait(task);
+  PTD_CHECK(atomic_load(&unsubmitted.calls) == 0);
+  PTDTaskRelease(task);
+  
+  /* a task which did not start yet runs on the waiting thread right away,
+   * even if all the workers which could run it are busy */
+  PTDTestGate gate = {0};
+  PTDTask *gateTask = PTDTestGateSubmit(scheduler, &gate);
+  PTDTestTask inlined = {0};
+  task = PTDTaskCreate(PTDTaskPriorityAutosave, PTDTestRecord, &inlined);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  PTDTaskWait(task);
+  PTD_CHECK(atomic_load(&inlined.calls) == 1);
+  PTD_CHECK(pthread_equal(inlined.thread, pthread_self()));
+  PTD_CHECK(!atomic_load(&gate.finished));
+  /* waiting again does not run it again */
+  PTDTaskWait(task);
+  PTD_CHECK(atomic_load(&inlined.calls) == 1);
+  PTDTaskRelease(task);
+  atomic_store(&gate.released, 1);
+  PTDTaskWait(gateTask);
+  PTD_CHECK(atomic_load(&gate.finished));
+  PTDTaskRelease(gateTask);
+  
+  /* but not before the tasks in front of it on its serial queue */
+  PTDTaskSerialQueue *queue = PTDTaskSerialQueueCreate();
+  PTDTestGate first = {0};
+  PTDTask *firstTask = PTDTaskCreate(PTDTaskPriorityPrefetch, PTDTestGateRun, &first);
+  PTDTaskSetSerialQueue(firstTask, queue);
+  PTDTaskSchedulerSubmit(scheduler, firstTask);
+  PTD_CHECK(PTDTestWaitForCalls(&first.started, 1));
+  PTDTestFollower follower = {0};
+  follower.before = &first;
+  task = PTDTaskCreate(PTDTaskPriorityInteractive, PTDTestFollowerRun, &follower);
+  PTDTaskSetSerialQueue(task, queue);
+  PTDTaskSerialQueueRelease(queue);
+  PTDTaskSchedulerSubmit(scheduler, task);
+  pthread_t releaser;
+  pthread_create(&releaser, NULL, PTDTestReleaseLater, &first);
+  PTDTaskWait(task);
+  pthread_join(releaser, NULL);
+  PTD_CHECK(atomic_load(&follower.calls) == 1);
+  PTD_CHECK(atomic_load(&follower.ranAfter));
+  PTDTaskRelease(task);
+  PTDTaskRelease(firstTask);
+  PTDTaskSchedulerDestroy(scheduler);
+}
+
+
+static void testSerialBurstStartsNoWorkers(void)
+{
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(4);
+  PTDTaskSerialQueue *queue = PTDTaskSerialQueueCreate();
+  
+  /* the tasks behind the first one can not start, so they get no threads */
+  PTDTestGate gate = {0};
+  PTDTask *gateTask = PTDTaskCreate(PTDTaskPriorityEncode, PTDTestGateRun, &gate);
+  PTDTaskSetSerialQueue(gateTask, queue);
+  PTDTaskSchedulerSubmit(scheduler, gateTask);
+  PTDTestTask tasks[20];
+  PTDTask *last = NULL;
+  for (int i = 0; i < 20; i++) {
+    tasks[i] = (PTDTestTask){0};
+    PTDTask *task = PTDTaskCreate(PTDTaskPriorityEncode, PTDTestRecord, &tasks[i]);
+    PTDTaskSetSerialQueue(task, queue);
+    PTDTaskSchedulerSubmit(scheduler, task);
+    PTDTaskRelease(last);
+    last = task;
+  }
+  PTD_CHECK(PTDTaskSchedulerWorkerCount(scheduler) == 1);
+  
+  /* nor do they make other tasks start threads that the idle ones would
+   * have run */
+  PTDTestTask others[5];
+  for (int i = 0; i < 5; i++) {
+    others[i] = (PTDTestTask){0};
+    PTDTestSubmit(scheduler, PTDTaskPriorityEncode, &others[i]);
+    PTD_CHECK(PTDTestWaitForCalls(&others[i].calls, 1));
+    /* lets the thread go back to waiting for work */
+    nanosleep(&(struct timespec){0, 20000000}, NULL);
+  }
+  PTD_CHECK(PTDTaskSchedulerWorkerCount(scheduler) == 2);
+  
+  atomic_store(&gate.released, 1);
+  PTDTaskWait(last);
+  for (int i = 0; i < 20; i++)
+    PTD_CHECK(atomic_load(&tasks[i].calls) == 1);
+  PTD_CHECK(PTDTaskSchedulerWorkerCount(scheduler) == 2);
+  PTDTaskRelease(last);
+  PTDTaskRelease(gateTask);
+  PTDTaskSerialQueueRelease(queue);
+  PTDTaskSchedulerDestroy(scheduler);
+}
+
+
+enum { STRESS_THREADS = 4, STRESS_TASKS = 3000, STRESS_QUEUES = 3 };
+
+typedef struct {
+  PTDTaskSerialQueue *queue;
+  _Atomic int running;
+  _Atomic int overlaps;
+  /* only touched by the tasks on the queue, one at a time */
+  int lastSeq[STRESS_THREADS];
+  int outOfOrder;
+} PTDTestStressQueue;
+
+typedef struct {
+  PTDTestStressQueue *queue;
+  int submitter;
+  int seq;
+  _Atomic int calls;
+} PTDTestStressTask;
+
+typedef struct {
+  PTDTaskScheduler *scheduler;
+  PTDTestStressQueue *queues;
+  PTDTestStressTask *tasks;
+  int index;
+} PTDTestStressSubmitter;
+
+
+static void PTDTestStressRun(PTDTask *task, void *context)
+{
+  (void)task;
+  PTDTestStressTask *t = context;
+  PTDTestStressQueue *q = t->queue;
+  if (q) {
+    if (atomic_fetch_add(&q->running, 1) != 0)
+      atomic_fetch_add(&q->overlaps, 1);
+    if (t->seq <= q->lastSeq[t->submitter])
+      q->outOfOrder++;
+    q->lastSeq[t->submitter] = t->seq;
+  }
+  for (volatile int i = 0; i < (t->seq % 5) * 100; i++)
+    ;
+  if (q)
+    atomic_fetch_sub(&q->running, 1);
+  atomic_fetch_add(&t->calls, 1);
+}
+
+
+static void *PTDTestStressSubmit(void *arg)
+{
+  PTDTestStressSubmitter *s = arg;
+  uint64_t rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(s->index + 1);
+  for (int i = 0; i < STRESS_TASKS; i++) {
+    PTDTestStressTask *t = &s->tasks[i];
+    t->submitter = s->index;
+    t->seq = i + 1;
+    size_t q = PTDTestRandomBelow(&rng, STRESS_QUEUES + 2);
+    t->queue = q < STRESS_QUEUES ? &s->queues[q] : NULL;
+    PTDTaskPriority priority = (PTDTaskPriority)PTDTestRandomBelow(&rng, PTDTaskPriorityCount);
+    PTDTask *task = PTDTaskCreate(priority, PTDTestStressRun, t);
+    if (t->queue)
+      PTDTaskSetSerialQueue(task, t->queue->queue);
+    PTDTaskSchedulerSubmit(s->scheduler, task);
+    size_t action = PTDTestRandomBelow(&rng, 16);
+    if (action == 0)
+      PTDTaskWait(task);
+    else if (action == 1)
+      PTDTaskCancel(task);
+    PTDTaskRelease(task);
+  }
+  return NULL;
+}
+
+
+static void testStress(void)
+{
+  PTDTaskScheduler *scheduler = PTDTaskSchedulerCreate(4);
+  PTDTestStressQueue queues[STRESS_QUEUES];
+  memset(queues, 0, sizeof(queues));
+  for (int q = 0; q < STRESS_QUEUES; q++)
+    queues[q].queue = PTDTaskSerialQueueCreate();
+  PTDTestStressTask *tasks = calloc(STRESS_THREADS * STRESS_TASKS, sizeof(PTDTestStressTask));
+  PTDTestStressSubmitter submitters[STRESS_THREADS];
+  pthread_t threads[STRESS_THREADS];
+  for (int i = 0; i < STRESS_THREADS; i++) {
+    submitters[i] = (PTDTestStressSubmitter){scheduler, queues, tasks + i * STRESS_TASKS, i};
+    pthread_create(&threads[i], NULL, PTDTestStressSubmit, &submitters[i]);
+  }
+  for (int i = 0; i < STRESS_THREADS; i++)
+    pthread_join(threads[i], NULL);
+  PTDTaskSchedulerDestroy(scheduler);
+  
+  int once = 1;
+  for (int i = 0; i < STRESS_THREADS * STRESS_TASKS; i++)
+    once &= atomic_load(&tasks[i].calls) == 1;
+  PTD_CHECK(once);
+  for (int q = 0; q < STRESS_QUEUES; q++) {
+    PTD_CHECK(atomic_load(&queues[q].overlaps) == 0);
+    PTD_CHECK(queues[q].outOfOrder == 0);
+    PTDTaskSerialQueueRelease(queues[q].queue);
+  }
+  free(tasks);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testPriorityOrder);
+  PTD_RUN(testStarvationLimit);
+  PTD_RUN(testCancellation);
+  PTD_RUN(testInlineWait);
+  PTD_RUN(testSerialBurstStartsNoWorkers);
+  PTD_RUN(testStress);
+  return PTDTestFinish();
+}
@@ -0,0 +1,106 @@
+//
+// PTDTest.h
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PTDTest_h
+#define PTDTest_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Minimal helpers shared by the tests and benchmarks of the portable C
+ * components. Each test program is a single translation unit. */
+
+static int PTDTestFailures;
+static int PTDTestChecks;
+
+#define PTD_CHECK(cond) PTDTestCheck(!!(cond), #cond, __FILE__, __LINE__)
+
+static inline int PTDTestCheck(int ok, const char *expr, const char *file, int line)
+{
+  PTDTestChecks++;
+  if (!ok) {
+    PTDTestFailures++;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+  }
+  return ok;
+}
+
+
+#define PTD_RUN(test) do { \
+    int failures = PTDTestFailures; \
+    test(); \
+    printf("%-48s %s\n", #test, failures == PTDTestFailures ? "ok" : "FAILED"); \
+  } while (0)
+
+
+static inline int PTDTestFinish(void)
+{
+  printf("%d checks, %d failed\n", PTDTestChecks, PTDTestFailures);
+  return PTDTestFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+static inline double PTDTestNow(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+/* xorshift64*, so that every run sees the same inputs */
+static inline uint64_t PTDTestRandom(uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+
+static inline size_t PTDTestRandomBelow(uint64_t *state, size_t n)
+{
+  return n ? (size_t)(PTDTestRandom(state) % n) : 0;
+}
+
+
+/* Runs the block of code enough times to take at least the given time,
+ * and prints the average time of one run. The code may contain commas. */
+#define PTD_BENCH(name, minSeconds, ...) do { \
+    double _start = PTDTestNow(), _elapsed; \
+    long _runs = 0; \
+    do { \
+      __VA_ARGS__; \
+      _runs++; \
+      _elapsed = PTDTestNow() - _start; \
+    } while (_elapsed < (minSeconds)); \
+    printf("%-48s %10.3f ms\n", name, _elapsed * 1000.0 / (double)_runs); \
+  } while (0)
+
+#endif /* PTDTest_h */
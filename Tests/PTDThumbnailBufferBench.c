@@ -0,0 +1,108 @@
+//
+// PTDThumbnailBufferBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDThumbnailBuffer.h"
+
+
+/* The status menu shows one thumbnail per canvas. With 4 displays and 10
+ * canvases spread among them, opening it used to copy and shrink every
+ * canvas at full resolution; now it only copies the thumbnails, which are
+ * kept up to date as the canvases change. */
+
+#define CANVASES 10
+#define THUMBNAIL_AREA (200 * 200)
+
+static const size_t _DisplaySizes[4][2] = {
+  {5120, 2880}, {3840, 2160}, {2560, 1440}, {1920, 1080}
+};
+
+
+int main(void)
+{
+  PTDCanvasStore *stores[4];
+  PTDPixelBuffer canvases[4];
+  PTDThumbnailBuffer *thumbs[CANVASES];
+  PTDPixelBuffer menuImages[CANVASES];
+  uint64_t rng = 9;
+  
+  for (int d = 0; d < 4; d++) {
+    size_t width = _DisplaySizes[d][0], height = _DisplaySizes[d][1];
+    canvases[d] = (PTDPixelBuffer){calloc(width * height, 4), width, height, width * 4};
+    /* a few strokes' worth of content */
+    for (int i = 0; i < 200; i++) {
+      size_t x = PTDTestRandomBelow(&rng, width - 64), y = PTDTestRandomBelow(&rng, height - 64);
+      for (size_t r = 0; r < 64; r++)
+        memset((uint8_t *)canvases[d].data + (y + r) * canvases[d].bytesPerRow + x * 4, 0xFF, 64 * 4);
+    }
+    stores[d] = PTDCanvasStoreCreate(width, height);
+    PTDCanvasStorePublish(stores[d], &canvases[d], 0, 0, width, height);
+  }
+  for (int c = 0; c < CANVASES; c++) {
+    const PTDPixelBuffer *canvas = &canvases[c % 4];
+    thumbs[c] = PTDThumbnailBufferCreate(canvas->width, canvas->height, THUMBNAIL_AREA);
+    size_t width = PTDThumbnailBufferWidth(thumbs[c]), height = PTDThumbnailBufferHeight(thumbs[c]);
+    menuImages[c] = (PTDPixelBuffer){malloc(width * height * 4), width, height, width * 4};
+    PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(stores[c % 4]);
+    PTDThumbnailBufferUpdate(thumbs[c], frame, 0, 0, width, height);
+    PTDCanvasFrameRelease(frame);
+  }
+  
+  PTDCanvasFrame *frame5K = PTDCanvasStoreAcquireFrame(stores[0]);
+  PTD_BENCH("full thumbnail rebuild, 5K", 0.5, {
+    PTDThumbnailBufferUpdate(thumbs[0], frame5K, 0, 0, 256, 144);
+  });
+  PTD_BENCH("incremental update, 200x200 px stroke, 5K", 0.5, {
+    size_t x = PTDTestRandomBelow(&rng, 5120 - 200) / 20, y = PTDTestRandomBelow(&rng, 2880 - 200) / 20;
+    PTDThumbnailBufferUpdate(thumbs[0], frame5K, x, y, x + 11, y + 11);
+  });
+  PTDCanvasFrameRelease(frame5K);
+  
+  PTD_BENCH("menu open, 10 canvases, full resolution", 1.0, {
+    for (int c = 0; c < CANVASES; c++) {
+      /* the old path: snapshot the canvas, then shrink the snapshot */
+      const PTDPixelBuffer *canvas = &canvases[c % 4];
+      PTDPixelBuffer snapshot = {malloc(canvas->height * canvas->bytesPerRow), canvas->width, canvas->height, canvas->bytesPerRow};
+      memcpy(snapshot.data, canvas->data, canvas->height * canvas->bytesPerRow);
+      PTDThumbnailBoxFilter(&snapshot, &menuImages[c], PTDThumbnailBufferFactor(thumbs[c]));
+      free(snapshot.data);
+    }
+  });
+  PTD_BENCH("menu open, 10 canvases, thumbnails", 0.5, {
+    for (int c = 0; c < CANVASES; c++)
+      PTDThumbnailBufferCopyPixels(thumbs[c], &menuImages[c]);
+  });
+  
+  for (int c = 0; c < CANVASES; c++) {
+    PTDThumbnailBufferDestroy(thumbs[c]);
+    free(menuImages[c].data);
+  }
+  for (int d = 0; d < 4; d++) {
+    PTDCanvasStoreRelease(stores[d]);
+    free(canvases[d].data);
+  }
+  return 0;
+}
@@ -0,0 +1,298 @@
+//
+// PTDThumbnailBufferTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "PTDTest.h"
+#include "PTDThumbnailBuffer.h"
+
+
+static PTDPixelBuffer PTDTestBufferCreate(size_t width, size_t height)
+{
+  PTDPixelBuffer buffer = {calloc(width * height, 4), width, height, width * 4};
+  return buffer;
+}
+
+
+/* Premultiplied, like the canvas */
+static void PTDTestFillRect(const PTDPixelBuffer *canvas, size_t x0, size_t y0, size_t x1, size_t y1, uint32_t color)
+{
+  uint8_t a = (uint8_t)(color >> 24);
+  uint8_t px[4] = {(uint8_t)(((color & 0xFF) * a) / 255), (uint8_t)((((color >> 8) & 0xFF) * a) / 255), (uint8_t)((((color >> 16) & 0xFF) * a) / 255), a};
+  for (size_t y = y0; y < y1; y++)
+    for (size_t x = x0; x < x1; x++)
+      memcpy((uint8_t *)canvas->data + y * canvas->bytesPerRow + x * 4, px, 4);
+}
+
+
+static void testBoxFilterAverages(void)
+{
+  uint64_t rng = 11;
+  for (size_t factor = 1; factor <= 5; factor++) {
+    PTDPixelBuffer src = PTDTestBufferCreate(37, 23);
+    for (size_t i = 0; i < 37 * 23 * 4; i++)
+      ((uint8_t *)src.data)[i] = (uint8_t)PTDTestRandom(&rng);
+    size_t width = (37 + factor - 1) / factor, height = (23 + factor - 1) / factor;
+    PTDPixelBuffer dst = PTDTestBufferCreate(width, height);
+    PTDThumbnailBoxFilter(&src, &dst, factor);
+    
+    int allMatch = 1;
+    for (size_t ty = 0; ty < height; ty++) {
+      for (size_t tx = 0; tx < width; tx++) {
+        for (int c = 0; c < 4; c++) {
+          unsigned sum = 0, n = 0;
+          for (size_t y = ty * factor; y < ty * factor + factor && y < 23; y++)
+            for (size_t x = tx * factor; x < tx * factor + factor && x < 37; x++, n++)
+              sum += ((uint8_t *)src.data)[y * src.bytesPerRow + x * 4 + c];
+          allMatch &= ((uint8_t *)dst.data)[ty * dst.bytesPerRow + tx * 4 + c] == (sum + n / 2) / n;
+        }
+      }
+    }
+    PTD_CHECK(allMatch);
+    free(src.data);
+    free(dst.data);
+  }
+}
+
+
+static void testDimensions(void)
+{
+  PTDThumbnailBuffer *thumb = PTDThumbnailBufferCreate(5120, 2880, 200 * 200);
+  PTD_CHECK(PTDThumbnailBufferFactor(thumb) == 20);
+  PTD_CHECK(PTDThumbnailBufferWidth(thumb) == 256);
+  PTD_CHECK(PTDThumbnailBufferHeight(thumb) == 144);
+  PTDThumbnailBufferDestroy(thumb);
+  
+  thumb = PTDThumbnailBufferCreate(100, 50, 200 * 200);
+  PTD_CHECK(PTDThumbnailBufferFactor(thumb) == 1);
+  PTD_CHECK(PTDThumbnailBufferWidth(thumb) == 100);
+  PTD_CHECK(PTDThumbnailBufferHeight(thumb) == 50);
+  PTDThumbnailBufferDestroy(thumb);
+}
+
+
+static void testWrongFrameSize(void)
+{
+  PTDCanvasStore *store = PTDCanvasStoreCreate(64, 64);
+  PTDCanvasStorePublish(store, NULL, 0, 0, 0, 0);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTDThumbnailBuffer *thumb = PTDThumbnailBufferCreate(65, 64, 100);
+  PTD_CHECK(!PTDThumbnailBufferUpdate(thumb, frame, 0, 0, 100, 100));
+  PTDThumbnailBufferDestroy(thumb);
+  PTDCanvasFrameRelease(frame);
+  PTDCanvasStoreRelease(store);
+}
+
+
+/* The invalid region of a change, as PTDCanvasThumbnail computes it */
+static void PTDTestThumbnailRegion(size_t factor, size_t x0, size_t y0, size_t x1, size_t y1, size_t *tx0, size_t *ty0, size_t *tx1, size_t *ty1)
+{
+  *tx0 = x0 / factor;
+  *ty0 = y0 / factor;
+  *tx1 = (x1 + factor - 1) / factor;
+  *ty1 = (y1 + factor - 1) / factor;
+}
+
+
+/* Many small changes applied one at a time to the thumbnail must give the
+ * same pixels as resampling the final canvas from scratch. */
+static void testIncrementalMatchesFullRebuild(void)
+{
+  const size_t width = 701, height = 499;
+  PTDPixelBuffer canvas = PTDTestBufferCreate(width, height);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(width, height);
+  PTDThumbnailBuffer *incremental = PTDThumbnailBufferCreate(width, height, 5000);
+  size_t factor = PTDThumbnailBufferFactor(incremental);
+  size_t thumbWidth = PTDThumbnailBufferWidth(incremental);
+  size_t thumbHeight = PTDThumbnailBufferHeight(incremental);
+  PTDPixelBuffer a = PTDTestBufferCreate(thumbWidth, thumbHeight);
+  PTDPixelBuffer b = PTDTestBufferCreate(thumbWidth, thumbHeight);
+  PTDPixelBuffer reference = PTDTestBufferCreate(thumbWidth, thumbHeight);
+  
+  PTDCanvasStorePublish(store, NULL, 0, 0, 0, 0);
+  uint64_t rng = 5;
+  int allMatch = 1;
+  size_t dx0 = SIZE_MAX, dy0 = SIZE_MAX, dx1 = 0, dy1 = 0;
+  for (int i = 0; i < 200; i++) {
+    size_t x0 = PTDTestRandomBelow(&rng, width), y0 = PTDTestRandomBelow(&rng, height);
+    size_t x1 = x0 + 1 + PTDTestRandomBelow(&rng, 80), y1 = y0 + 1 + PTDTestRandomBelow(&rng, 80);
+    x1 = x1 < width ? x1 : width;
+    y1 = y1 < height ? y1 : height;
+    /* erase every so often, so that content also disappears */
+    uint32_t color = i % 7 == 6 ? 0 : (uint32_t)PTDTestRandom(&rng) | 0x40000000;
+    PTDTestFillRect(&canvas, x0, y0, x1, y1, color);
+    PTDCanvasStorePublish(store, &canvas, x0, y0, x1, y1);
+    
+    /* changes are often coalesced before the thumbnail is updated */
+    size_t tx0, ty0, tx1, ty1;
+    PTDTestThumbnailRegion(factor, x0, y0, x1, y1, &tx0, &ty0, &tx1, &ty1);
+    dx0 = tx0 < dx0 ? tx0 : dx0;
+    dy0 = ty0 < dy0 ? ty0 : dy0;
+    dx1 = tx1 > dx1 ? tx1 : dx1;
+    dy1 = ty1 > dy1 ? ty1 : dy1;
+    if (i % 3 != 2 && i != 199)
+      continue;
+    PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+    PTD_CHECK(PTDThumbnailBufferUpdate(incremental, frame, dx0, dy0, dx1, dy1));
+    PTDCanvasFrameRelease(frame);
+    dx0 = dy0 = SIZE_MAX;
+    dx1 = dy1 = 0;
+  }
+  
+  for (int i = 0; i < 100; i++) {
+    size_t x0 = PTDTestRandomBelow(&rng, width), y0 = PTDTestRandomBelow(&rng, height);
+    size_t x1 = x0 + 1 + PTDTestRandomBelow(&rng, 40), y1 = y0 + 1 + PTDTestRandomBelow(&rng, 40);
+    x1 = x1 < width ? x1 : width;
+    y1 = y1 < height ? y1 : height;
+    PTDTestFillRect(&canvas, x0, y0, x1, y1, i % 5 == 4 ? 0 : (uint32_t)PTDTestRandom(&rng) | 0xFF000000);
+    PTDCanvasStorePublish(store, &canvas, x0, y0, x1, y1);
+    
+    size_t tx0, ty0, tx1, ty1;
+    PTDTestThumbnailRegion(factor, x0, y0, x1, y1, &tx0, &ty0, &tx1, &ty1);
+    PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+    PTD_CHECK(PTDThumbnailBufferUpdate(incremental, frame, tx0, ty0, tx1, ty1));
+    
+    PTDThumbnailBuffer *full = PTDThumbnailBufferCreate(width, height, 5000);
+    PTD_CHECK(PTDThumbnailBufferUpdate(full, frame, 0, 0, thumbWidth, thumbHeight));
+    PTDThumbnailBufferCopyPixels(incremental, &a);
+    PTDThumbnailBufferCopyPixels(full, &b);
+    allMatch &= memcmp(a.data, b.data, thumbWidth * thumbHeight * 4) == 0;
+    PTDThumbnailBufferDestroy(full);
+    PTDCanvasFrameRelease(frame);
+  }
+  PTD_CHECK(allMatch);
+  
+  PTDThumbnailBoxFilter(&canvas, &reference, factor);
+  PTD_CHECK(memcmp(a.data, reference.data, thumbWidth * thumbHeight * 4) == 0);
+  
+  PTDThumbnailBufferDestroy(incremental);
+  PTDCanvasStoreRelease(store);
+  free(canvas.data);
+  free(a.data);
+  free(b.data);
+  free(reference.data);
+}
+
+
+static void testClearedCanvasClearsThumbnail(void)
+{
+  const size_t width = 300, height = 200;
+  PTDPixelBuffer canvas = PTDTestBufferCreate(width, height);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(width, height);
+  PTDThumbnailBuffer *thumb = PTDThumbnailBufferCreate(width, height, 1000);
+  size_t thumbWidth = PTDThumbnailBufferWidth(thumb), thumbHeight = PTDThumbnailBufferHeight(thumb);
+  PTDPixelBuffer pixels = PTDTestBufferCreate(thumbWidth, thumbHeight);
+  
+  PTDTestFillRect(&canvas, 0, 0, width, height, 0xFF336699);
+  PTDCanvasStorePublish(store, &canvas, 0, 0, width, height);
+  PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+  PTDThumbnailBufferUpdate(thumb, frame, 0, 0, thumbWidth, thumbHeight);
+  PTDCanvasFrameRelease(frame);
+  PTDThumbnailBufferCopyPixels(thumb, &pixels);
+  PTD_CHECK(((uint8_t *)pixels.data)[3] == 0xFF);
+  
+  memset(canvas.data, 0, width * height * 4);
+  PTDCanvasStorePublish(store, &canvas, 0, 0, width, height);
+  frame = PTDCanvasStoreAcquireFrame(store);
+  PTDThumbnailBufferUpdate(thumb, frame, 0, 0, thumbWidth, thumbHeight);
+  PTDCanvasFrameRelease(frame);
+  PTDThumbnailBufferCopyPixels(thumb, &pixels);
+  int clear = 1;
+  for (size_t i = 0; i < thumbWidth * thumbHeight * 4; i++)
+    clear &= ((uint8_t *)pixels.data)[i] == 0;
+  PTD_CHECK(clear);
+  
+  PTDThumbnailBufferDestroy(thumb);
+  PTDCanvasStoreRelease(store);
+  free(canvas.data);
+  free(pixels.data);
+}
+
+
+typedef struct {
+  PTDThumbnailBuffer *thumb;
+  _Atomic int done;
+  _Atomic long torn;
+} PTDCopyContext;
+
+
+static void *PTDTestCopyLoop(void *arg)
+{
+  PTDCopyContext *ctx = arg;
+  size_t width = PTDThumbnailBufferWidth(ctx->thumb), height = PTDThumbnailBufferHeight(ctx->thumb);
+  PTDPixelBuffer pixels = PTDTestBufferCreate(width, height);
+  while (!atomic_load(&ctx->done)) {
+    PTDThumbnailBufferCopyPixels(ctx->thumb, &pixels);
+    /* every pixel is opaque gray or transparent, never anything else */
+    for (size_t i = 0; i < width * height; i++) {
+      uint8_t *px = (uint8_t *)pixels.data + i * 4;
+      if (px[0] != px[3] && px[3] != 0)
+        atomic_fetch_add(&ctx->torn, 1);
+    }
+  }
+  free(pixels.data);
+  return NULL;
+}
+
+
+static void testConcurrentCopies(void)
+{
+  const size_t width = 512, height = 512;
+  PTDPixelBuffer canvas = PTDTestBufferCreate(width, height);
+  PTDCanvasStore *store = PTDCanvasStoreCreate(width, height);
+  PTDCopyContext ctx = {0};
+  ctx.thumb = PTDThumbnailBufferCreate(width, height, 64 * 64);
+  size_t thumbWidth = PTDThumbnailBufferWidth(ctx.thumb), thumbHeight = PTDThumbnailBufferHeight(ctx.thumb);
+  pthread_t reader;
+  pthread_create(&reader, NULL, PTDTestCopyLoop, &ctx);
+  
+  for (int i = 0; i < 100; i++) {
+    PTDTestFillRect(&canvas, 0, 0, width, height, i % 2 ? 0 : 0xFFFFFFFF);
+    PTDCanvasStorePublish(store, &canvas, 0, 0, width, height);
+    PTDCanvasFrame *frame = PTDCanvasStoreAcquireFrame(store);
+    PTDThumbnailBufferUpdate(ctx.thumb, frame, 0, 0, thumbWidth, thumbHeight);
+    PTDCanvasFrameRelease(frame);
+  }
+  atomic_store(&ctx.done, 1);
+  pthread_join(reader, NULL);
+  PTD_CHECK(atomic_load(&ctx.torn) == 0);
+  
+  PTDThumbnailBufferDestroy(ctx.thumb);
+  PTDCanvasStoreRelease(store);
+  free(canvas.data);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testBoxFilterAverages);
+  PTD_RUN(testDimensions);
+  PTD_RUN(testWrongFrameSize);
+  PTD_RUN(testIncrementalMatchesFullRebuild);
+  PTD_RUN(testClearedCanvasClearsThumbnail);
+  PTD_RUN(testConcurrentCopies);
+  return PTDTestFinish();
+}
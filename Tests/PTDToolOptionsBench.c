@@ -0,0 +1,135 @@
+//
+// PTDToolOptionsBench.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdio.h>
+#include "PTDTest.h"
+#include "PTDToolOptionStore.h"
+
+
+/* A registry the size of the app's one (a dozen tools with a handful of
+ * options each, plus the global ones), looked up by name the way the tools
+ * read their options, and by key once the name is resolved. The fan-out
+ * sends one change to N subscribers, and every subscriber subscribes again
+ * to its options while being notified, as the tools do when they reload. */
+
+static const size_t _ToolCount = 16;
+static const size_t _OptionsPerTool = 12;
+static const size_t _Lookups = 1000000;
+
+
+static double PTDBenchRate(const char *name, size_t operations, double elapsed)
+{
+  double rate = (double)operations / elapsed;
+  printf("%-48s %10.2f M/s\n", name, rate / 1e6);
+  return rate;
+}
+
+
+static void PTDBenchIgnoreKey(void *context, size_t key)
+{
+  (void)context;
+  (void)key;
+}
+
+
+int main(void)
+{
+  PTDToolOptionStore *store = PTDToolOptionStoreCreate(NULL, NULL);
+  size_t optionCount = _ToolCount * _OptionsPerTool;
+  char (*names)[32] = malloc(optionCount * sizeof(*names));
+  uintptr_t *scopes = malloc(optionCount * sizeof(uintptr_t));
+  for (size_t i = 0; i < optionCount; i++) {
+    scopes[i] = i < _OptionsPerTool ? 0 : 0x10000 + (i / _OptionsPerTool) * 0x40;
+    snprintf(names[i], sizeof(names[i]), "PTDToolOption%zu", i % _OptionsPerTool);
+    PTDToolOptionStoreIntern(store, scopes[i], names[i]);
+    PTDToolOptionStoreLoadValue(store, i, &(PTDToolOptionValue){NULL, (int64_t)i, (double)i});
+  }
+  volatile int64_t sink = 0;
+  uint64_t rng = 3;
+  
+  size_t *order = malloc(_Lookups * sizeof(size_t));
+  for (size_t i = 0; i < _Lookups; i++)
+    order[i] = PTDTestRandomBelow(&rng, optionCount);
+  
+  for (int pass = 0; pass < 3; pass++) {
+    double start = PTDTestNow();
+    for (size_t i = 0; i < _Lookups; i++) {
+      size_t key = PTDToolOptionStoreFind(store, scopes[order[i]], names[order[i]]);
+      sink += PTDToolOptionStoreValue(store, key)->integer;
+    }
+    PTDBenchRate("lookups by name", _Lookups, PTDTestNow() - start);
+    
+    start = PTDTestNow();
+    for (size_t i = 0; i < _Lookups; i++)
+      sink += PTDToolOptionStoreValue(store, order[i])->integer;
+    PTDBenchRate("lookups by key", _Lookups, PTDTestNow() - start);
+  }
+  
+  static const size_t counts[] = {10, 100, 1000};
+  PTDToolOptionSubscriberList list = {0};
+  size_t keys[4];
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    size_t count = counts[c];
+    for (size_t s = 0; s < count; s++)
+      PTDToolOptionStoreAddSubscriber(store);
+    /* everyone reads a global option, and a few of the options of its tool */
+    for (uint32_t s = 0; s < count; s++) {
+      size_t tool = s % _ToolCount;
+      keys[0] = 0;
+      for (size_t k = 1; k < 4; k++)
+        keys[k] = tool * _OptionsPerTool + k;
+      PTDToolOptionStoreSubscribe(store, s, keys, 4);
+    }
+    
+    char name[80];
+    size_t notified = 0;
+    snprintf(name, sizeof(name), "change fanned out to %zu subscribers", count);
+    PTD_BENCH(name, 0.5,
+      PTDToolOptionStoreSetValue(store, 0, &(PTDToolOptionValue){NULL, (int64_t)notified, 0.0});
+      PTDToolOptionStoreCopySubscribers(store, 0, &list);
+      for (size_t i = 0; i < list.count; i++) {
+        uint32_t s = list.handles[i];
+        size_t tool = s % _ToolCount;
+        keys[0] = 0;
+        for (size_t k = 1; k < 4; k++)
+          keys[k] = tool * _OptionsPerTool + k;
+        PTDToolOptionStoreSubscribe(store, s, keys, 4);
+        notified++;
+      });
+    sink += (int64_t)notified;
+    
+    for (uint32_t s = 0; s < count; s++)
+      PTDToolOptionStoreRemoveSubscriber(store, s);
+  }
+  PTDToolOptionStoreTakeChanges(store, PTDBenchIgnoreKey, NULL);
+  
+  PTDToolOptionSubscriberListFree(&list);
+  PTDToolOptionStoreDestroy(store);
+  free(order);
+  free(scopes);
+  free(names);
+  (void)sink;
+  return 0;
+}
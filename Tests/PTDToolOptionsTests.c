@@ -0,0 +1,259 @@
+//
+// PTDToolOptionsTests.c
+// PaintTheDesktop -- Created on 19/10/2026.
+//
+// Copyright (c) 2026 Daniele Cattaneo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "PTDTest.h"
+#include "PTDToolOptionStore.h"
+
+
+/* The objects of the values are counters of their references */
+
+static const void *PTDTestRetain(const void *object)
+{
+  (*(int *)object)++;
+  return object;
+}
+
+
+static void PTDTestRelease(const void *object)
+{
+  (*(int *)object)--;
+}
+
+
+static void PTDTestCollectKey(void *context, size_t key)
+{
+  PTDToolOptionSubscriberList *keys = context;
+  keys->handles[keys->count++] = (uint32_t)key;
+}
+
+
+static void testIntern(void)
+{
+  PTDToolOptionStore *store = PTDToolOptionStoreCreate(NULL, NULL);
+  size_t global = PTDToolOptionStoreIntern(store, 0, "size");
+  size_t tool = PTDToolOptionStoreIntern(store, 0x1000, "size");
+  size_t other = PTDToolOptionStoreIntern(store, 0x1000, "color");
+  PTD_CHECK(global == 0 && tool == 1 && other == 2);
+  PTD_CHECK(PTDToolOptionStoreIntern(store, 0x1000, "size") == tool);
+  PTD_CHECK(PTDToolOptionStoreFind(store, 0, "size") == global);
+  PTD_CHECK(PTDToolOptionStoreFind(store, 0x1000, "color") == other);
+  PTD_CHECK(PTDToolOptionStoreFind(store, 0, "color") == PTD_TOOL_OPTION_NOT_FOUND);
+  PTD_CHECK(PTDToolOptionStoreFind(store, 0x2000, "size") == PTD_TOOL_OPTION_NOT_FOUND);
+  PTD_CHECK(PTDToolOptionStoreFind(store, 0, "") == PTD_TOOL_OPTION_NOT_FOUND);
+  
+  /* enough to grow the table a few times; the keys stay the same */
+  int ok = 1;
+  char name[32];
+  for (size_t i = 0; i < 1000; i++) {
+    snprintf(name, sizeof(name), "option%zu", i);
+    ok &= PTDToolOptionStoreIntern(store, i % 7, name) == i + 3;
+  }
+  for (size_t i = 0; i < 1000; i++) {
+    snprintf(name, sizeof(name), "option%zu", i);
+    ok &= PTDToolOptionStoreFind(store, i % 7, name) == i + 3;
+    ok &= PTDToolOptionStoreFind(store, i % 7 + 1, name) == PTD_TOOL_OPTION_NOT_FOUND;
+  }
+  PTD_CHECK(ok);
+  PTD_CHECK(PTDToolOptionStoreCount(store) == 1003);
+  PTD_CHECK(PTDToolOptionStoreFind(store, 0x1000, "size") == tool);
+  PTDToolOptionStoreDestroy(store);
+}
+
+
+static void testValues(void)
+{
+  int a = 0, b = 0;
+  PTDToolOptionStore *store = PTDToolOptionStoreCreate(PTDTestRetain, PTDTestRelease);
+  for (int i = 0; i < 4; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "o%d", i);
+    PTDToolOptionStoreIntern(store, 0, name);
+  }
+  PTD_CHECK(PTDToolOptionStoreValue(store, 0) == NULL);
+  
+  /* loading caches the value without making it a change to persist */
+  PTDToolOptionStoreLoadValue(store, 2, &(PTDToolOptionValue){&a, 3, 3.5});
+  const PTDToolOptionValue *value = PTDToolOptionStoreValue(store, 2);
+  PTD_CHECK(value && value->object == &a && value->integer == 3 && value->real == 3.5);
+  PTD_CHECK(a == 1);
+  PTD_CHECK(!PTDToolOptionStoreHasChanges(store));
+  
+  /* the same object again keeps one reference */
+  PTDToolOptionStoreSetValue(store, 2, &(PTDToolOptionValue){&a, 4, 4.0});
+  PTD_CHECK(a == 1);
+  PTDToolOptionStoreSetValue(store, 3, &(PTDToolOptionValue){&b, 0, 0.0});
+  PTDToolOptionStoreSetValue(store, 0, &(PTDToolOptionValue){&b, 0, 0.0});
+  PTDToolOptionStoreSetValue(store, 2, &(PTDToolOptionValue){&b, 1, 1.0});
+  PTD_CHECK(a == 0 && b == 3);
+  PTD_CHECK(PTDToolOptionStoreHasChanges(store));
+  
+  uint32_t taken[8];
+  PTDToolOptionSubscriberList keys = {taken, 0, 8};
+  PTDToolOptionStoreTakeChanges(store, PTDTestCollectKey, &keys);
+  PTD_CHECK(keys.count == 3 && taken[0] == 0 && taken[1] == 2 && taken[2] == 3);
+  PTD_CHECK(!PTDToolOptionStoreHasChanges(store));
+  keys.count = 0;
+  PTDToolOptionStoreTakeChanges(store, PTDTestCollectKey, &keys);
+  PTD_CHECK(keys.count == 0);
+  
+  /* resetting drops the value and a change not taken yet */
+  PTDToolOptionStoreSetValue(store, 1, &(PTDToolOptionValue){&a, 0, 0.0});
+  PTDToolOptionStoreResetValue(store, 1);
+  PTD_CHECK(a == 0 && PTDToolOptionStoreValue(store, 1) == NULL);
+  PTD_CHECK(!PTDToolOptionStoreHasChanges(store));
+  /* values without an object */
+  PTDToolOptionStoreSetValue(store, 1, &(PTDToolOptionValue){NULL, 7, 7.0});
+  PTD_CHECK(PTDToolOptionStoreValue(store, 1)->integer == 7);
+  
+  PTDToolOptionStoreDestroy(store);
+  PTD_CHECK(a == 0 && b == 0);
+}
+
+
+static void testFanOut(void)
+{
+  PTDToolOptionStore *store = PTDToolOptionStoreCreate(NULL, NULL);
+  for (int i = 0; i < 4; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "o%d", i);
+    PTDToolOptionStoreIntern(store, 0, name);
+  }
+  PTDToolOptionSubscriberList list = {0};
+  uint32_t s0 = PTDToolOptionStoreAddSubscriber(store);
+  uint32_t s1 = PTDToolOptionStoreAddSubscriber(store);
+  uint32_t s2 = PTDToolOptionStoreAddSubscriber(store);
+  PTD_CHECK(s0 == 0 && s1 == 1 && s2 == 2);
+  
+  PTD_CHECK(PTDToolOptionStoreSubscribe(store, s0, (size_t[]){0, 1}, 2));
+  PTD_CHECK(PTDToolOptionStoreSubscribe(store, s1, (size_t[]){1, 2}, 2));
+  /* repeated and unknown keys */
+  PTD_CHECK(PTDToolOptionStoreSubscribe(store, s2, (size_t[]){1, 1, 99}, 3));
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 1, &list));
+  PTD_CHECK(list.count == 3 && list.handles[0] == s0 && list.handles[1] == s1 && list.handles[2] == s2);
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 3, &list));
+  PTD_CHECK(list.count == 0);
+  
+  /* subscribing again to the same keys keeps the place of the subscriber */
+  PTD_CHECK(PTDToolOptionStoreSubscribe(store, s0, (size_t[]){0, 1}, 2));
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 1, &list));
+  PTD_CHECK(list.count == 3 && list.handles[0] == s0);
+  
+  /* other keys replace the old ones, and put the subscriber last */
+  PTD_CHECK(PTDToolOptionStoreSubscribe(store, s0, (size_t[]){1, 3}, 2));
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 0, &list));
+  PTD_CHECK(list.count == 0);
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 1, &list));
+  PTD_CHECK(list.count == 3 && list.handles[0] == s1 && list.handles[1] == s2 && list.handles[2] == s0);
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 3, &list));
+  PTD_CHECK(list.count == 1 && list.handles[0] == s0);
+  
+  /* the handle of a removed subscriber is reused, without its keys */
+  PTDToolOptionStoreRemoveSubscriber(store, s1);
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 2, &list));
+  PTD_CHECK(list.count == 0);
+  PTD_CHECK(PTDToolOptionStoreAddSubscriber(store) == s1);
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 1, &list));
+  PTD_CHECK(list.count == 2 && list.handles[0] == s2 && list.handles[1] == s0);
+  PTD_CHECK(!PTDToolOptionStoreSubscribe(store, 50, (size_t[]){0}, 1));
+  PTD_CHECK(PTDToolOptionStoreSubscribe(store, s2, NULL, 0));
+  PTD_CHECK(PTDToolOptionStoreCopySubscribers(store, 1, &list));
+  PTD_CHECK(list.count == 1 && list.handles[0] == s0);
+  
+  PTDToolOptionSubscriberListFree(&list);
+  PTDToolOptionStoreDestroy(store);
+}
+
+
+static void testFanOutMatchesSubscriptions(void)
+{
+  enum { keyCount = 40, subscriberCount = 60 };
+  PTDToolOptionStore *store = PTDToolOptionStoreCreate(NULL, NULL);
+  for (int i = 0; i < keyCount; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "o%d", i);
+    PTDToolOptionStoreIntern(store, (uintptr_t)(i % 3), name);
+  }
+  static unsigned char subscribed[subscriberCount][keyCount];
+  static int alive[subscriberCount];
+  memset(subscribed, 0, sizeof(subscribed));
+  for (int s = 0; s < subscriberCount; s++) {
+    PTDToolOptionStoreAddSubscriber(store);
+    alive[s] = 1;
+  }
+  
+  uint64_t rng = 5;
+  PTDToolOptionSubscriberList list = {0};
+  int ok = 1;
+  for (int round = 0; round < 500; round++) {
+    uint32_t s = (uint32_t)PTDTestRandomBelow(&rng, subscriberCount);
+    if (alive[s] && PTDTestRandomBelow(&rng, 10) == 0) {
+      PTDToolOptionStoreRemoveSubscriber(store, s);
+      memset(subscribed[s], 0, keyCount);
+      alive[s] = 0;
+    } else {
+      if (!alive[s]) {
+        /* the first free handle comes back, which may not be this one */
+        s = PTDToolOptionStoreAddSubscriber(store);
+        ok &= s < subscriberCount && !alive[s];
+        if (s >= subscriberCount)
+          break;
+        alive[s] = 1;
+      }
+      size_t keys[keyCount];
+      size_t count = PTDTestRandomBelow(&rng, 8);
+      memset(subscribed[s], 0, keyCount);
+      for (size_t i = 0; i < count; i++) {
+        keys[i] = PTDTestRandomBelow(&rng, keyCount);
+        subscribed[s][keys[i]] = 1;
+      }
+      ok &= PTDToolOptionStoreSubscribe(store, s, keys, count);
+    }
+    
+    for (size_t key = 0; key < keyCount; key++) {
+      ok &= PTDToolOptionStoreCopySubscribers(store, key, &list);
+      size_t expected = 0;
+      for (int t = 0; t < subscriberCount; t++)
+        expected += subscribed[t][key];
+      ok &= list.count == expected;
+      for (size_t i = 0; i < list.count; i++)
+        ok &= list.handles[i] < subscriberCount && subscribed[list.handles[i]][key];
+    }
+  }
+  PTD_CHECK(ok);
+  PTDToolOptionSubscriberListFree(&list);
+  PTDToolOptionStoreDestroy(store);
+}
+
+
+int main(void)
+{
+  PTD_RUN(testIntern);
+  PTD_RUN(testValues);
+  PTD_RUN(testFanOut);
+  PTD_RUN(testFanOutMatchesSubscriptions);
+  return PTDTestFinish();
+}